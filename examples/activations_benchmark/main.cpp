@@ -0,0 +1,179 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   A C T I V A T I O N S   B E N C H M A R K   A P P L I C A T I O N
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+// System includes
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <time.h>
+
+// OpenNN includes
+
+#include "../../opennn/opennn.h"
+
+using namespace opennn;
+using namespace std::chrono;
+
+/// Times an exact and an approximate activation over the same combinations, and prints the speedup and maximum error.
+
+template<class Exact, class Approximate>
+void benchmark_activation(const string& name,
+                          ThreadPoolDevice& thread_pool_device,
+                          const Tensor<type, 1>& combinations,
+                          const Index& iterations_number,
+                          const Exact& exact,
+                          const Approximate& approximate)
+{
+    Tensor<type, 1> exact_activations(combinations.size());
+    Tensor<type, 1> approximate_activations(combinations.size());
+
+    auto beginning_time = steady_clock::now();
+
+    for(Index iteration = 0; iteration < iterations_number; iteration++)
+    {
+        exact(thread_pool_device, combinations, exact_activations);
+    }
+
+    const double exact_time = duration<double, milli>(steady_clock::now() - beginning_time).count()/iterations_number;
+
+    beginning_time = steady_clock::now();
+
+    for(Index iteration = 0; iteration < iterations_number; iteration++)
+    {
+        approximate(thread_pool_device, combinations, approximate_activations);
+    }
+
+    const double approximate_time = duration<double, milli>(steady_clock::now() - beginning_time).count()/iterations_number;
+
+    const Tensor<type, 0> maximum_error = (exact_activations - approximate_activations).abs().maximum();
+
+    cout << name << ": "
+         << "exact " << exact_time << " ms, "
+         << "approximate " << approximate_time << " ms, "
+         << "speedup " << exact_time/approximate_time << ", "
+         << "maximum error " << maximum_error(0) << endl;
+}
+
+
+int main()
+{
+    try
+    {
+        cout << "OpenNN. Activations benchmark." << endl;
+
+        srand(static_cast<unsigned>(time(nullptr)));
+
+        const Index samples_number = 1000;
+        const Index neurons_number = 1000;
+        const Index iterations_number = 20;
+
+        const int threads_number = omp_get_max_threads();
+
+        ThreadPool thread_pool(threads_number);
+        ThreadPoolDevice thread_pool_device(&thread_pool, threads_number);
+
+        // Combinations in [-10, 10]
+
+        Tensor<type, 1> combinations(samples_number*neurons_number);
+        combinations.setRandom();
+        combinations = (combinations - type(0.5))*type(20);
+
+        cout << "Elements: " << combinations.size() << endl;
+        cout << "Threads: " << threads_number << endl;
+
+        // The exact expressions are those of the Layer class
+
+        benchmark_activation("Logistic", thread_pool_device, combinations, iterations_number,
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = (type(1) + x.exp().inverse()).inverse();},
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = x.unaryExpr(ApproximateLogistic());});
+
+        benchmark_activation("HyperbolicTangent", thread_pool_device, combinations, iterations_number,
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = x.tanh();},
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = x.unaryExpr(ApproximateHyperbolicTangent());});
+
+        benchmark_activation("SoftPlus", thread_pool_device, combinations, iterations_number,
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = (x.constant(type(1)) + x.exp()).log();},
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = x.unaryExpr(ApproximateSoftPlus());});
+
+        benchmark_activation("ExponentialLinear", thread_pool_device, combinations, iterations_number,
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {
+                const Tensor<bool, 1> if_sentence = x < x.constant(type(0));
+                Tensor<type, 1> f_1(x.dimension(0));
+                f_1 = x.exp() - type(1);
+                y.device(device) = if_sentence.select(f_1, x);
+            },
+            [](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {y.device(device) = x.unaryExpr(ApproximateExponentialLinear());});
+
+        benchmark_activation("Softmax", thread_pool_device, combinations, iterations_number,
+            [&](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {
+                const TensorMap<const Tensor<type, 2>> x_matrix(x.data(), samples_number, neurons_number);
+                TensorMap<Tensor<type, 2>> y_matrix(y.data(), samples_number, neurons_number);
+                const Eigen::array<Index, 1> columns_dimension({1});
+                Tensor<type, 1> rows_sum(samples_number);
+                y_matrix.device(device) = x_matrix.exp();
+                rows_sum.device(device) = y_matrix.sum(columns_dimension);
+                divide_columns(&device, y_matrix, rows_sum);
+            },
+            [&](ThreadPoolDevice& device, const Tensor<type, 1>& x, Tensor<type, 1>& y)
+            {
+                const TensorMap<const Tensor<type, 2>> x_matrix(x.data(), samples_number, neurons_number);
+                TensorMap<Tensor<type, 2>> y_matrix(y.data(), samples_number, neurons_number);
+                const Eigen::array<Index, 1> columns_dimension({1});
+                const Eigen::array<Index, 2> rows_shape({samples_number, 1});
+                const Eigen::array<Index, 2> columns_broadcast({1, neurons_number});
+                Tensor<type, 1> rows_maximum(samples_number);
+                Tensor<type, 1> rows_sum(samples_number);
+                rows_maximum.device(device) = x_matrix.maximum(columns_dimension);
+                y_matrix.device(device)
+                        = (x_matrix - rows_maximum.reshape(rows_shape).broadcast(columns_broadcast)).unaryExpr(ApproximateExponential());
+                rows_sum.device(device) = y_matrix.sum(columns_dimension);
+                divide_columns(&device, y_matrix, rows_sum);
+            });
+
+        cout << "Bye!" << endl;
+
+        return 0;
+    }
+    catch(const exception& e)
+    {
+        cerr << e.what() << endl;
+
+        return 1;
+    }
+}
+
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) Artificial Intelligence Techniques SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
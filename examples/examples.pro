@@ -10,10 +10,12 @@ TEMPLATE = subdirs
 
 CONFIG += ordered
 
+SUBDIRS += activations_benchmark
 SUBDIRS += airfoil_self_noise
 SUBDIRS += airline_passengers
 SUBDIRS += amazon_reviews
 SUBDIRS += breast_cancer
+SUBDIRS += forward_propagation_benchmark
 SUBDIRS += iris_plant
 SUBDIRS += logical_operations
 SUBDIRS += mnist
@@ -0,0 +1,146 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   F O R W A R D   P R O P A G A T I O N   B E N C H M A R K   A P P L I C A T I O N
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+// System includes
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <time.h>
+
+// OpenNN includes
+
+#include "../../opennn/opennn.h"
+
+using namespace opennn;
+using namespace std::chrono;
+
+int main()
+{
+    try
+    {
+        cout << "OpenNN. Forward propagation benchmark." << endl;
+
+        srand(static_cast<unsigned>(time(nullptr)));
+
+        const Index batch_samples_number = 1000;
+        const Index inputs_number = 256;
+        const Index hidden_neurons_number = 256;
+        const Index hidden_layers_number = 32;
+        const Index outputs_number = 1;
+        const Index iterations_number = 20;
+
+        // Neural network
+
+        Tensor<Index, 1> architecture(hidden_layers_number + 2);
+        architecture.setConstant(hidden_neurons_number);
+        architecture(0) = inputs_number;
+        architecture(hidden_layers_number + 1) = outputs_number;
+
+        NeuralNetwork neural_network(NeuralNetwork::ProjectType::Approximation, architecture);
+
+        neural_network.set_parameters_random();
+
+        // Batch
+
+        DataSetBatch batch;
+
+        batch.batch_size = batch_samples_number;
+        batch.inputs.resize(1);
+
+        Tensor<Index, 1> inputs_dimensions(2);
+        inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+        batch.inputs(0).set_dimensions(inputs_dimensions);
+        batch.inputs(0).to_tensor_map<2>().setRandom();
+
+        NeuralNetworkForwardPropagation forward_propagation(batch_samples_number, &neural_network);
+
+        bool is_training = true;
+
+        const Index first_trainable_layer_index = neural_network.get_first_trainable_layer_index();
+        const Index last_trainable_layer_index = neural_network.get_last_trainable_layer_index();
+
+        // Bytes which were deep copied on every batch when layer outputs were passed by value
+
+        Index saved_bytes = batch.inputs(0).get_size()*sizeof(type);
+
+        for(Index i = first_trainable_layer_index; i < last_trainable_layer_index; i++)
+        {
+            saved_bytes += forward_propagation.layers(i)->outputs(0).get_size()*sizeof(type);
+        }
+
+        // Forward propagation
+
+        neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+        auto beginning_time = steady_clock::now();
+
+        for(Index iteration = 0; iteration < iterations_number; iteration++)
+        {
+            neural_network.forward_propagate(batch, forward_propagation, is_training);
+        }
+
+        const double forward_propagation_time
+                = duration<double, milli>(steady_clock::now() - beginning_time).count()/iterations_number;
+
+        // Copies of the layer outputs, as made by the previous forward propagation
+
+        beginning_time = steady_clock::now();
+
+        for(Index iteration = 0; iteration < iterations_number; iteration++)
+        {
+            const Tensor<DynamicTensor<type>, 1> inputs = batch.inputs;
+
+            for(Index i = first_trainable_layer_index; i < last_trainable_layer_index; i++)
+            {
+                const Tensor<DynamicTensor<type>, 1> outputs = forward_propagation.layers(i)->outputs;
+            }
+        }
+
+        const double copies_time
+                = duration<double, milli>(steady_clock::now() - beginning_time).count()/iterations_number;
+
+        cout << "Hidden layers number: " << hidden_layers_number << endl;
+        cout << "Neurons per layer: " << hidden_neurons_number << endl;
+        cout << "Batch samples number: " << batch_samples_number << endl;
+        cout << "Forward propagation time per iteration: " << forward_propagation_time << " ms" << endl;
+        cout << "Saved copies per iteration: " << saved_bytes << " bytes" << endl;
+        cout << "Saved time per iteration: " << copies_time << " ms" << endl;
+
+        cout << "Bye!" << endl;
+
+        return 0;
+    }
+    catch(const exception& e)
+    {
+        cerr << e.what() << endl;
+
+        return 1;
+    }
+}
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) Artificial Intelligence Techniques SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
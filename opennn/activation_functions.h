@@ -0,0 +1,327 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   A C T I V A T I O N   F U N C T I O N S   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef ACTIVATIONFUNCTIONS_H
+#define ACTIVATIONFUNCTIONS_H
+
+// System includes
+
+#include <cmath>
+
+// OpenNN includes
+
+#include "config.h"
+#include "approximate_activations.h"
+
+namespace opennn
+{
+
+// Element-wise activation functions, applied to each combination after it is calculated, while it is still in cache.
+// Each one is a functor whose operator with a single argument returns the activation of a combination,
+// and whose operator with two arguments also writes the derivative of the activation.
+
+struct LinearActivation
+{
+    type operator()(const type& x) const
+    {
+        return x;
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        derivative = type(1);
+
+        return x;
+    }
+};
+
+
+struct LogisticActivation
+{
+    type operator()(const type& x) const
+    {
+        return type(1)/(type(1) + exp(-x));
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type activation = type(1)/(type(1) + exp(-x));
+
+        derivative = activation*(type(1) - activation);
+
+        return activation;
+    }
+};
+
+
+struct HyperbolicTangentActivation
+{
+    type operator()(const type& x) const
+    {
+        return tanh(x);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type activation = tanh(x);
+
+        derivative = type(1) - activation*activation;
+
+        return activation;
+    }
+};
+
+
+struct ThresholdActivation
+{
+    type operator()(const type& x) const
+    {
+        return x >= type(0) ? type(1) : type(0);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        derivative = type(0);
+
+        return x >= type(0) ? type(1) : type(0);
+    }
+};
+
+
+struct SymmetricThresholdActivation
+{
+    type operator()(const type& x) const
+    {
+        return x > type(0) ? type(1) : type(-1);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        derivative = type(0);
+
+        return x > type(0) ? type(1) : type(-1);
+    }
+};
+
+
+struct RectifiedLinearActivation
+{
+    type operator()(const type& x) const
+    {
+        return x < type(0) ? type(0) : x;
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        derivative = x < type(0) ? type(0) : type(1);
+
+        return x < type(0) ? type(0) : x;
+    }
+};
+
+
+/// Scaled exponential linear function, with the constants of Klambauer et al., which are also used by the layers.
+
+struct ScaledExponentialLinearActivation
+{
+    static constexpr type lambda = type(1.0507);
+
+    static constexpr type alpha = type(1.67326);
+
+    type operator()(const type& x) const
+    {
+        return x < type(0) ? lambda*alpha*(exp(x) - type(1)) : lambda*x;
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        if(x < type(0))
+        {
+            const type exponential = exp(x);
+
+            derivative = lambda*alpha*exponential;
+
+            return lambda*alpha*(exponential - type(1));
+        }
+
+        derivative = lambda;
+
+        return lambda*x;
+    }
+};
+
+
+struct SoftPlusActivation
+{
+    type operator()(const type& x) const
+    {
+        return log(type(1) + exp(x));
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type exponential = exp(x);
+
+        derivative = type(1)/(type(1) + type(1)/exponential);
+
+        return log(type(1) + exponential);
+    }
+};
+
+
+struct SoftSignActivation
+{
+    type operator()(const type& x) const
+    {
+        return x < type(0) ? x/(type(1) - x) : x/(type(1) + x);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type denominator = x < type(0) ? type(1) - x : type(1) + x;
+
+        derivative = type(1)/(denominator*denominator);
+
+        return x/denominator;
+    }
+};
+
+
+struct HardSigmoidActivation
+{
+    type operator()(const type& x) const
+    {
+        return x < type(-2.5) ? type(0) : x > type(2.5) ? type(1) : type(0.2)*x + type(0.5);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        derivative = x < type(-2.5) || x > type(2.5) ? type(0) : type(0.2);
+
+        return x < type(-2.5) ? type(0) : x > type(2.5) ? type(1) : type(0.2)*x + type(0.5);
+    }
+};
+
+
+struct ExponentialLinearActivation
+{
+    type operator()(const type& x) const
+    {
+        return x < type(0) ? exp(x) - type(1) : x;
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        if(x < type(0))
+        {
+            const type exponential = exp(x);
+
+            derivative = exponential;
+
+            return exponential - type(1);
+        }
+
+        derivative = type(1);
+
+        return x;
+    }
+};
+
+
+// Element-wise versions of the fast activation functions, built on the approximations.
+
+struct FastLogisticActivation
+{
+    type operator()(const type& x) const
+    {
+        return ApproximateLogistic()(x);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type activation = ApproximateLogistic()(x);
+
+        derivative = activation*(type(1) - activation);
+
+        return activation;
+    }
+};
+
+
+struct FastHyperbolicTangentActivation
+{
+    type operator()(const type& x) const
+    {
+        return ApproximateHyperbolicTangent()(x);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type activation = ApproximateHyperbolicTangent()(x);
+
+        derivative = type(1) - activation*activation;
+
+        return activation;
+    }
+};
+
+
+struct FastSoftPlusActivation
+{
+    type operator()(const type& x) const
+    {
+        return ApproximateSoftPlus()(x);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        derivative = ApproximateLogistic()(x);
+
+        return ApproximateSoftPlus()(x);
+    }
+};
+
+
+struct FastExponentialLinearActivation
+{
+    type operator()(const type& x) const
+    {
+        return ApproximateExponentialLinear()(x);
+    }
+
+    type operator()(const type& x, type& derivative) const
+    {
+        const type exponential = ApproximateExponential()(x);
+
+        derivative = x < type(0) ? exponential : type(1);
+
+        return x < type(0) ? exponential - type(1) : x;
+    }
+};
+
+}
+
+#endif
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -328,6 +328,8 @@ TrainingResults AdaptiveMomentEstimation::perform_training()
 
     AdaptiveMomentEstimationData optimization_data(this);
 
+    set_neural_network_parameters(training_back_propagation, optimization_data);
+
     bool stop_training = false;
     bool is_training = true;
 
@@ -594,6 +596,15 @@ Tensor<string, 2> AdaptiveMomentEstimation::to_string_matrix() const
 void AdaptiveMomentEstimation::update_parameters(LossIndexBackPropagation& back_propagation,
     AdaptiveMomentEstimationData& optimization_data) const
 {
+    if(!emulate_gradient_precision(back_propagation, optimization_data)) return;
+
+    if(!back_propagation.gradient_segments.empty() && emulated_precision == Precision::Single)
+    {
+        update_parameters_lazy(back_propagation, optimization_data);
+
+        return;
+    }
+
     const type learning_rate =
         type(initial_learning_rate *
             sqrt(type(1) - pow(beta_2, static_cast<type>(optimization_data.iteration))) /
@@ -630,7 +641,59 @@ void AdaptiveMomentEstimation::update_parameters(LossIndexBackPropagation& back_
 
     // Update parameters
 
-    back_propagation.loss_index_pointer->get_neural_network_pointer()->set_parameters(back_propagation.parameters);
+    set_neural_network_parameters(back_propagation, optimization_data);
+}
+
+
+/// Updates only the parameters in the gradient segments, when the loss index has assembled a sparse gradient.
+/// The moment estimates of the rest of parameters are not decayed until their gradient is nonzero again (lazy Adam).
+/// @param back_propagation Back propagation of the loss index, with the gradient segments.
+/// @param optimization_data Data of the optimization algorithm.
+
+void AdaptiveMomentEstimation::update_parameters_lazy(LossIndexBackPropagation& back_propagation,
+                                                      AdaptiveMomentEstimationData& optimization_data) const
+{
+    const type learning_rate =
+        type(initial_learning_rate *
+            sqrt(type(1) - pow(beta_2, static_cast<type>(optimization_data.iteration))) /
+            (type(1) - pow(beta_1, static_cast<type>(optimization_data.iteration))));
+
+    const vector<pair<Index, Index>>& gradient_segments = back_propagation.gradient_segments;
+
+    const Index segments_number = static_cast<Index>(gradient_segments.size());
+
+    const type* gradient_data = back_propagation.gradient.data();
+
+    type* parameters_data = back_propagation.parameters.data();
+
+    type* gradient_exponential_decay_data = optimization_data.gradient_exponential_decay.data();
+    type* square_gradient_exponential_decay_data = optimization_data.square_gradient_exponential_decay.data();
+
+#pragma omp parallel for schedule(dynamic)
+    for(Index i = 0; i < segments_number; i++)
+    {
+        const Index first = gradient_segments[i].first;
+        const Index end = first + gradient_segments[i].second;
+
+        for(Index j = first; j < end; j++)
+        {
+            gradient_exponential_decay_data[j]
+                = gradient_data[j]*(type(1) - beta_1) + gradient_exponential_decay_data[j]*beta_1;
+
+            square_gradient_exponential_decay_data[j]
+                = gradient_data[j]*gradient_data[j]*(type(1) - beta_2) + square_gradient_exponential_decay_data[j]*beta_2;
+
+            parameters_data[j]
+                -= learning_rate*gradient_exponential_decay_data[j]/(sqrt(square_gradient_exponential_decay_data[j]) + epsilon);
+        }
+    }
+
+    optimization_data.iteration++;
+
+    // Update parameters
+
+    back_propagation.loss_index_pointer->get_neural_network_pointer()->set_parameters_segments(back_propagation.parameters,
+                                                                                               gradient_segments);
 }
 
 
@@ -865,6 +928,8 @@ void AdaptiveMomentEstimationData::set(AdaptiveMomentEstimation* new_adaptive_mo
     square_gradient_exponential_decay.setZero();
 
     square_gradient_exponential_decay.setZero();
+
+    loss_scale = new_adaptive_moment_estimation_pointer->get_loss_scale();
 }
 
 
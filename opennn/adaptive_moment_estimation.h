@@ -120,6 +120,8 @@ public:
 
    void update_parameters(LossIndexBackPropagation&, AdaptiveMomentEstimationData&) const;
 
+   void update_parameters_lazy(LossIndexBackPropagation&, AdaptiveMomentEstimationData&) const;
+
 private:
 
    // TRAINING OPERATORS
@@ -21,10 +21,12 @@ AdditionLayer::AdditionLayer() : Layer()
 
 /// Input size setter constructor.
 /// After setting new dimensions for the input, it creates an empty AdditionLayer object.
-/// @param new_input_variables_dimensions A vector containing the new number of channels, rows and columns for the input.
+/// @param new_input_variables_dimensions A vector containing the dimensions of each sample of the inputs to be added.
 
 AdditionLayer::AdditionLayer(const Tensor<Index, 1>& new_input_variables_dimensions) : Layer()
 {
+    inputs_dimensions = new_input_variables_dimensions;
+
     set_default();
 }
 
@@ -44,33 +46,31 @@ AdditionLayer::AdditionLayer(const Tensor<Index, 1>& new_input_variables_dimensi
 }
 
 
-/// Returns the number of neurons the layer applies to an image.
+/// Returns the number of outputs of each sample, which is the number of inputs of each sample.
 
 Index AdditionLayer::get_neurons_number() const
 {
-    return get_outputs_rows_number() * get_outputs_columns_number();
+    return get_inputs_number();
 }
 
 
-/// Returns the layer's outputs dimensions.
+/// Returns the layer's outputs dimensions, which are equal to the dimensions of each input.
 
 Tensor<Index, 1> AdditionLayer::get_outputs_dimensions() const
 {
-    Tensor<Index, 1> outputs_dimensions(3);
-
-    outputs_dimensions[0] = get_outputs_rows_number();
-    outputs_dimensions[1] = get_outputs_columns_number();
-    outputs_dimensions[2] = inputs_dimensions[2];
-
-    return outputs_dimensions;
+    return inputs_dimensions;
 }
 
 
-/// Returns the number of inputs of the layer.
+/// Returns the number of inputs of each sample of the layer.
 
 Index AdditionLayer::get_inputs_number() const
 {
-    return inputs_dimensions.size();
+    Index inputs_number = 1;
+
+    for(Index i = 0; i < inputs_dimensions.size(); i++) inputs_number *= inputs_dimensions(i);
+
+    return inputs_number;
 }
 
 
@@ -79,7 +79,7 @@ Index AdditionLayer::get_inputs_number() const
 
 Index AdditionLayer::get_inputs_rows_number() const
 {
-    return inputs_dimensions[0];
+    return inputs_dimensions.size() > 0 ? inputs_dimensions[0] : 1;
 }
 
 
@@ -87,7 +87,7 @@ Index AdditionLayer::get_inputs_rows_number() const
 
 Index AdditionLayer::get_inputs_columns_number() const
 {
-    return inputs_dimensions[1];
+    return inputs_dimensions.size() > 1 ? inputs_dimensions[1] : 1;
 }
 
 
@@ -95,7 +95,7 @@ Index AdditionLayer::get_inputs_columns_number() const
 
 Index AdditionLayer::get_channels_number() const
 {
-    return inputs_dimensions[2];
+    return inputs_dimensions.size() > 2 ? inputs_dimensions[2] : 1;
 }
 
 
@@ -103,7 +103,7 @@ Index AdditionLayer::get_channels_number() const
 
 Index AdditionLayer::get_outputs_rows_number() const
 {
-    return 0;
+    return get_inputs_rows_number();
 }
 
 
@@ -111,7 +111,7 @@ Index AdditionLayer::get_outputs_rows_number() const
 
 Index AdditionLayer::get_outputs_columns_number() const
 {
-    return 0;
+    return get_inputs_columns_number();
 }
 
 
@@ -160,49 +160,263 @@ void AdditionLayer::set_inputs_dimensions(const Tensor<Index, 1>& new_inputs_dim
 }
 
 
-/// Sets the layer type to Layer::Pooling.
+/// Sets the layer type to Layer::Addition.
 
 void AdditionLayer::set_default()
 {
-    layer_type = Layer::Type::Pooling;
+    layer_type = Layer::Type::Addition;
+
+    layer_name = "addition_layer";
 }
 
 
-void AdditionLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>&,
-                                     LayerForwardPropagation* layer_forward_propagation,
-                                     const bool& is_training)
+/// Adds element-wise all the inputs of the layer.
+/// All the inputs must have the size of the layer outputs.
+
+void AdditionLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                      LayerForwardPropagation* layer_forward_propagation,
+                                      const bool& is_training)
 {
-    if(layer_forward_propagation == nullptr) cout << "NULL" << endl;
+    const Index inputs_number = inputs.size();
+
+    const Index outputs_size = layer_forward_propagation->outputs(0).get_size();
+
+    for(Index i = 0; i < inputs_number; i++)
+    {
+        if(inputs(i).get_size() != outputs_size)
+        {
+            ostringstream buffer;
+
+            buffer << "OpenNN Exception: AdditionLayer class.\n"
+                   << "void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, LayerForwardPropagation*, const bool&) method.\n"
+                   << "Size of input " << i << " (" << inputs(i).get_size() << ") must be equal to outputs size (" << outputs_size << ").\n";
+
+            throw invalid_argument(buffer.str());
+        }
+    }
+
+    TensorMap<Tensor<type, 1>> outputs(layer_forward_propagation->outputs(0).get_data(), outputs_size);
 
+    if(inputs_number == 0)
+    {
+        outputs.setZero();
+
+        return;
+    }
+
+    outputs.device(*thread_pool_device) = TensorMap<Tensor<type, 1>>(inputs(0).get_data(), outputs_size);
+
+    for(Index i = 1; i < inputs_number; i++)
+    {
+        outputs.device(*thread_pool_device) += TensorMap<Tensor<type, 1>>(inputs(i).get_data(), outputs_size);
+    }
 }
 
 
 void AdditionLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
-                                          LayerBackPropagation* next_layer_back_propagation,
-                                          LayerBackPropagation* this_layeer_back_propagation) const
+                                           LayerBackPropagation* next_layer_back_propagation,
+                                           LayerBackPropagation* layer_back_propagation) const
 {
-    /// @todo put switch
-    /*
-    if(pooling_method == PoolingMethod::NoPooling) return next_layer_delta;
+    switch(next_layer_back_propagation->layer_pointer->get_type())
+    {
+    case Type::Perceptron:
+    {
+        PerceptronLayerForwardPropagation* next_perceptron_layer_forward_propagation =
+                static_cast<PerceptronLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        PerceptronLayerBackPropagation* next_perceptron_layer_back_propagation =
+                static_cast<PerceptronLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_perceptron_layer_forward_propagation,
+                               next_perceptron_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Probabilistic:
+    {
+        ProbabilisticLayerForwardPropagation* next_probabilistic_layer_forward_propagation =
+                static_cast<ProbabilisticLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        ProbabilisticLayerBackPropagation* next_probabilistic_layer_back_propagation =
+                static_cast<ProbabilisticLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_probabilistic_layer_forward_propagation,
+                               next_probabilistic_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Convolutional:
+    {
+        ConvolutionalLayerForwardPropagation* next_convolutional_layer_forward_propagation =
+                static_cast<ConvolutionalLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        ConvolutionalLayerBackPropagation* next_convolutional_layer_back_propagation =
+                static_cast<ConvolutionalLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_convolutional_layer_forward_propagation,
+                               next_convolutional_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Pooling:
+    {
+        PoolingLayerForwardPropagation* next_pooling_layer_forward_propagation =
+                static_cast<PoolingLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        PoolingLayerBackPropagation* next_pooling_layer_back_propagation =
+                static_cast<PoolingLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_pooling_layer_forward_propagation,
+                               next_pooling_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Flatten:
+    {
+        FlattenLayerForwardPropagation* next_flatten_layer_forward_propagation =
+                static_cast<FlattenLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        FlattenLayerBackPropagation* next_flatten_layer_back_propagation =
+                static_cast<FlattenLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_flatten_layer_forward_propagation,
+                               next_flatten_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
 
+    default:
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: AdditionLayer class.\n"
+               << "void calculate_hidden_delta(LayerForwardPropagation*, LayerBackPropagation*, LayerBackPropagation*) const method.\n"
+               << "Next layer type " << next_layer_back_propagation->layer_pointer->get_type_string() << " is not implemented.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+    }
+}
+
+
+void AdditionLayer::calculate_hidden_delta(PerceptronLayerForwardPropagation* next_forward_propagation,
+                                           PerceptronLayerBackPropagation* next_back_propagation,
+                                           LayerBackPropagation* back_propagation) const
+{
+    const Tensor<type, 2>& next_synaptic_weights = static_cast<PerceptronLayer*>(next_back_propagation->layer_pointer)->get_synaptic_weights();
+
+    const TensorMap<Tensor<type, 2>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->deltas_dimensions(0),
+                                                 next_back_propagation->deltas_dimensions(1));
+
+    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data,
+                                      back_propagation->batch_samples_number,
+                                      get_neurons_number());
+
+    deltas.device(*thread_pool_device) = (next_deltas*next_forward_propagation->activations_derivatives).contract(next_synaptic_weights, A_BT);
+}
+
+
+void AdditionLayer::calculate_hidden_delta(ProbabilisticLayerForwardPropagation* next_forward_propagation,
+                                           ProbabilisticLayerBackPropagation* next_back_propagation,
+                                           LayerBackPropagation* back_propagation) const
+{
+    const ProbabilisticLayer* probabilistic_layer_pointer = static_cast<ProbabilisticLayer*>(next_back_propagation->layer_pointer);
+
+    const Tensor<type, 2>& next_synaptic_weights = probabilistic_layer_pointer->get_synaptic_weights();
+
+    const Index next_neurons_number = probabilistic_layer_pointer->get_neurons_number();
+
+    const Index batch_samples_number = back_propagation->batch_samples_number;
+
+    const TensorMap<Tensor<type, 2>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->deltas_dimensions(0),
+                                                 next_back_propagation->deltas_dimensions(1));
+
+    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data,
+                                      batch_samples_number,
+                                      get_neurons_number());
+
+    if(next_neurons_number == 1
+    || probabilistic_layer_pointer->get_activation_function() != ProbabilisticLayer::ActivationFunction::Softmax)
+    {
+        const TensorMap<Tensor<type, 2>> activations_derivatives(next_forward_propagation->activations_derivatives.data(),
+                                                                 batch_samples_number,
+                                                                 next_neurons_number);
+
+        deltas.device(*thread_pool_device) = (next_deltas*activations_derivatives).contract(next_synaptic_weights, A_BT);
+    }
     else
     {
-        const Type layer_type = next_layer_pointer->get_type();
+        const Index step = next_neurons_number*next_neurons_number;
 
-        if(layer_type == Type::Convolutional)
+        for(Index i = 0; i < batch_samples_number; i++)
         {
-            ConvolutionalLayer* convolutional_layer = dynamic_cast<ConvolutionalLayer*>(next_layer_pointer);
+            next_back_propagation->delta_row = next_deltas.chip(i,0);
 
-            return calculate_hidden_delta_convolutional(convolutional_layer, activations, activations_derivatives, next_layer_delta);
-        }
-        else if(layer_type == Type::Pooling)
-        {
-            AdditionLayer* pooling_layer = dynamic_cast<AdditionLayer*>(next_layer_pointer);
+            TensorMap<Tensor<type, 2>> activations_derivatives_matrix(next_forward_propagation->activations_derivatives.data() + i*step,
+                                                                      next_neurons_number,
+                                                                      next_neurons_number);
 
-            return calculate_hidden_delta_pooling(pooling_layer, activations, activations_derivatives, next_layer_delta);
+            next_back_propagation->error_combinations_derivatives.chip(i,0) =
+                    next_back_propagation->delta_row.contract(activations_derivatives_matrix, AT_B);
         }
+
+        deltas.device(*thread_pool_device) =
+                next_back_propagation->error_combinations_derivatives.contract(next_synaptic_weights, A_BT);
     }
-    */
+}
+
+
+/// The deltas of this layer are the derivatives of the error with respect to the inputs of the next convolutional layer.
+
+void AdditionLayer::calculate_hidden_delta(ConvolutionalLayerForwardPropagation* next_forward_propagation,
+                                           ConvolutionalLayerBackPropagation* next_back_propagation,
+                                           LayerBackPropagation* back_propagation) const
+{
+    const ConvolutionalLayer* next_convolutional_layer = static_cast<ConvolutionalLayer*>(next_back_propagation->layer_pointer);
+
+    const TensorMap<Tensor<type, 4>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->get_deltas_dimensions_array());
+
+    next_back_propagation->deltas_times_activations_derivatives.device(*thread_pool_device)
+            = next_deltas*next_forward_propagation->activations_derivatives;
+
+    next_convolutional_layer->calculate_inputs_derivatives(next_back_propagation, back_propagation->deltas_data);
+}
+
+
+/// The deltas of this layer are the derivatives of the error with respect to the inputs of the next pooling layer.
+
+void AdditionLayer::calculate_hidden_delta(PoolingLayerForwardPropagation* next_forward_propagation,
+                                           PoolingLayerBackPropagation* next_back_propagation,
+                                           LayerBackPropagation* back_propagation) const
+{
+    const PoolingLayer* next_pooling_layer = static_cast<PoolingLayer*>(next_back_propagation->layer_pointer);
+
+    next_pooling_layer->calculate_inputs_derivatives(next_forward_propagation,
+                                                     next_back_propagation,
+                                                     back_propagation->deltas_data);
+}
+
+
+/// A flatten layer only reshapes its inputs, so the deltas of this layer are those of the next layer.
+
+void AdditionLayer::calculate_hidden_delta(FlattenLayerForwardPropagation* next_forward_propagation,
+                                           FlattenLayerBackPropagation* next_back_propagation,
+                                           LayerBackPropagation* back_propagation) const
+{
+    const Index batch_samples_number = back_propagation->batch_samples_number;
+
+    const Index next_neurons_number = next_forward_propagation->layer_pointer->get_neurons_number();
+
+    memcpy(back_propagation->deltas_data,
+           next_back_propagation->deltas_data,
+           static_cast<size_t>(batch_samples_number*next_neurons_number)*sizeof(type));
 }
 
 
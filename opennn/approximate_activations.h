@@ -0,0 +1,251 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   A P P R O X I M A T E   A C T I V A T I O N S   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef APPROXIMATEACTIVATIONS_H
+#define APPROXIMATEACTIVATIONS_H
+
+// System includes
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+// OpenNN includes
+
+#include "config.h"
+
+namespace opennn
+{
+
+// Approximate activation functions, used by the layers when fast activations are enabled.
+// Each one is a functor with a scalar and a packet operator, so that tensor expressions built with unaryExpr
+// are vectorized with the instruction set selected by Eigen (SSE, AVX, NEON...).
+// The maximum errors, measured in single precision over [-100, 100] against double precision functions, are:
+//
+//   ApproximateExponential          relative 3.4e-6
+//   ApproximateLogistic             absolute 1.8e-7
+//   ApproximateHyperbolicTangent    absolute 3.3e-7
+//   ApproximateSoftPlus             absolute 1.4e-6 (relative for outputs greater than 1)
+//   ApproximateExponentialLinear    absolute 2.4e-6
+//
+// The softmax of the layers, built on ApproximateExponential, has a relative error of 3.4e-6.
+// Outputs are not checked for NaN inputs.
+
+/// Exponential function, as 2^n times a degree 5 Taylor polynomial of the remainder in [-ln(2)/2, ln(2)/2].
+/// Inputs are clamped to the range where the result is a normal number.
+/// Near the upper end of that range n reaches 128, whose power of two overflows on its own,
+/// so that 2^n is applied in two halves.
+
+struct ApproximateExponential
+{
+    type operator()(const type& x) const
+    {
+        const type clamped_x = min(max(x, type(-87.3)), type(88.7));
+
+        // Adding and subtracting 1.5 times 2 to the number of mantissa bits rounds to the nearest integer
+
+        const type rounding = type(1.5)*type(Index(1) << (numeric_limits<type>::digits - 1));
+
+        const type n = (clamped_x*type(1.44269504088896341) + rounding) - rounding;
+
+        const type r = clamped_x - n*type(0.693145751953125) - n*type(1.42860682030941723e-6);
+
+        const type polynomial = type(1) + r*(type(1) + r*(type(1.0/2.0) + r*(type(1.0/6.0)
+                              + r*(type(1.0/24.0) + r*type(1.0/120.0)))));
+
+        const type half_n = floor(n*type(0.5));
+
+        return polynomial*power_of_two(half_n)*power_of_two(n - half_n);
+    }
+
+    /// Returns 2 to the power of an integer stored as a floating point number, by writing its exponent bits.
+
+    static float power_of_two(const float& n)
+    {
+        const int32_t bits = (int32_t(n) + 127) << 23;
+
+        float power;
+
+        memcpy(&power, &bits, sizeof(float));
+
+        return power;
+    }
+
+    static double power_of_two(const double& n)
+    {
+        const int64_t bits = (int64_t(n) + 1023) << 52;
+
+        double power;
+
+        memcpy(&power, &bits, sizeof(double));
+
+        return power;
+    }
+
+    template<class Packet>
+    Packet packetOp(const Packet& x) const
+    {
+        using namespace Eigen::internal;
+
+        const Packet clamped_x = pmin(pmax(x, pset1<Packet>(type(-87.3))), pset1<Packet>(type(88.7)));
+
+        const Packet rounding = pset1<Packet>(type(1.5)*type(Index(1) << (numeric_limits<type>::digits - 1)));
+
+        const Packet n = psub(pmadd(clamped_x, pset1<Packet>(type(1.44269504088896341)), rounding), rounding);
+
+        Packet r = pmadd(n, pset1<Packet>(type(-0.693145751953125)), clamped_x);
+        r = pmadd(n, pset1<Packet>(type(-1.42860682030941723e-6)), r);
+
+        Packet polynomial = pset1<Packet>(type(1.0/120.0));
+        polynomial = pmadd(polynomial, r, pset1<Packet>(type(1.0/24.0)));
+        polynomial = pmadd(polynomial, r, pset1<Packet>(type(1.0/6.0)));
+        polynomial = pmadd(polynomial, r, pset1<Packet>(type(1.0/2.0)));
+        polynomial = pmadd(polynomial, r, pset1<Packet>(type(1)));
+        polynomial = pmadd(polynomial, r, pset1<Packet>(type(1)));
+
+        const Packet half_n = pfloor(pmul(n, pset1<Packet>(type(0.5))));
+
+        return pldexp_fast_impl<Packet>::run(pldexp_fast_impl<Packet>::run(polynomial, half_n), psub(n, half_n));
+    }
+};
+
+
+/// Logistic function, as the rational approximation of Eigen, which needs no exponential.
+
+struct ApproximateLogistic
+{
+    type operator()(const type& x) const
+    {
+        return Eigen::internal::scalar_logistic_op<type>()(x);
+    }
+
+    template<class Packet>
+    Packet packetOp(const Packet& x) const
+    {
+        return Eigen::internal::scalar_logistic_op<type>().packetOp(x);
+    }
+};
+
+
+/// Hyperbolic tangent, as the rational approximation of Eigen.
+/// It is the same function used by the exact activation, which Eigen already vectorizes,
+/// so that fast activations only save the checks.
+
+struct ApproximateHyperbolicTangent
+{
+    type operator()(const type& x) const
+    {
+        return Eigen::internal::scalar_tanh_op<type>()(x);
+    }
+
+    template<class Packet>
+    Packet packetOp(const Packet& x) const
+    {
+        return Eigen::internal::scalar_tanh_op<type>().packetOp(x);
+    }
+};
+
+
+/// Soft plus function, as max(x, 0) + log(1 + e^(-|x|)), which does not overflow.
+
+struct ApproximateSoftPlus
+{
+    type operator()(const type& x) const
+    {
+        return max(x, type(0)) + log(type(1) + ApproximateExponential()(-abs(x)));
+    }
+
+    template<class Packet>
+    Packet packetOp(const Packet& x) const
+    {
+        using namespace Eigen::internal;
+
+        const Packet exponential = ApproximateExponential().packetOp(pnegate(pabs(x)));
+
+        return padd(pmax(x, pzero(x)), plog(padd(pset1<Packet>(type(1)), exponential)));
+    }
+};
+
+
+/// Exponential linear function, with alpha equal to 1.
+
+struct ApproximateExponentialLinear
+{
+    type operator()(const type& x) const
+    {
+        return x < type(0) ? ApproximateExponential()(x) - type(1) : x;
+    }
+
+    template<class Packet>
+    Packet packetOp(const Packet& x) const
+    {
+        using namespace Eigen::internal;
+
+        const Packet exponential_linear = psub(ApproximateExponential().packetOp(x), pset1<Packet>(type(1)));
+
+        return pselect(pcmp_lt(x, pzero(x)), exponential_linear, x);
+    }
+};
+
+}
+
+namespace Eigen
+{
+
+namespace internal
+{
+
+template<> struct functor_traits<opennn::ApproximateExponential>
+{
+    enum {Cost = 12*NumTraits<opennn::type>::MulCost, PacketAccess = packet_traits<opennn::type>::HasExp};
+};
+
+template<> struct functor_traits<opennn::ApproximateLogistic>
+{
+    enum {Cost = 14*NumTraits<opennn::type>::MulCost, PacketAccess = packet_traits<opennn::type>::HasExp};
+};
+
+template<> struct functor_traits<opennn::ApproximateHyperbolicTangent>
+{
+    enum {Cost = 20*NumTraits<opennn::type>::MulCost, PacketAccess = packet_traits<opennn::type>::HasTanh};
+};
+
+template<> struct functor_traits<opennn::ApproximateSoftPlus>
+{
+    enum {Cost = 30*NumTraits<opennn::type>::MulCost, PacketAccess = packet_traits<opennn::type>::HasLog};
+};
+
+template<> struct functor_traits<opennn::ApproximateExponentialLinear>
+{
+    enum {Cost = 14*NumTraits<opennn::type>::MulCost, PacketAccess = packet_traits<opennn::type>::HasExp};
+};
+
+}
+
+}
+
+#endif
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
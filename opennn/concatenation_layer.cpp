@@ -1,7 +1,7 @@
 //   OpenNN: Open Neural Networks Library
 //   www.opennn.net
 //
-//   A D D I T I O N   L A Y E R   C L A S S
+//   C O N C A T E N A T I O N   L A Y E R   C L A S S
 //
 //   Artificial Intelligence Techniques SL
 //   artelnics@artelnics.com
@@ -20,57 +20,76 @@ ConcatenationLayer::ConcatenationLayer() : Layer()
 }
 
 /// Input size setter constructor.
-/// After setting new dimensions for the input, it creates an empty ConcatenationLayer object.
-/// @param new_input_variables_dimensions A vector containing the new number of channels, rows and columns for the input.
+/// After setting new dimensions for the input, it creates a ConcatenationLayer object with a single input.
+/// @param new_input_variables_dimensions A vector containing the dimensions of each sample of the input.
 
 ConcatenationLayer::ConcatenationLayer(const Tensor<Index, 1>& new_input_variables_dimensions) : Layer()
 {
+    set_inputs_dimensions(new_input_variables_dimensions);
+
     set_default();
 }
 
 
 /// Input size setter constructor.
-/// After setting new dimensions for the input, it creates an empty ConcatenationLayer object.
-/// @param new_input_variables_dimensions A vector containing the desired number of rows and columns for the input.
-/// @param pool_dimensions A vector containing the desired number of rows and columns for the pool.
+/// After setting new dimensions for the input, it creates a ConcatenationLayer object.
+/// @param new_input_variables_dimensions A vector containing the dimensions of each sample of the first input.
+/// @param new_inputs_last_dimensions A vector containing the size of the last dimension of each input.
 
-ConcatenationLayer::ConcatenationLayer(const Tensor<Index, 1>& new_input_variables_dimensions, const Tensor<Index, 1>& pool_dimensions) : Layer()
+ConcatenationLayer::ConcatenationLayer(const Tensor<Index, 1>& new_input_variables_dimensions, const Tensor<Index, 1>& new_inputs_last_dimensions) : Layer()
 { 
-    set(new_input_variables_dimensions, pool_dimensions);
-
-    inputs_dimensions = new_input_variables_dimensions;
-
-    set_default();
+    set(new_input_variables_dimensions, new_inputs_last_dimensions);
 }
 
 
-/// Returns the number of neurons the layer applies to an image.
+/// Returns the number of outputs of each sample.
 
 Index ConcatenationLayer::get_neurons_number() const
 {
-    return get_outputs_rows_number() * get_outputs_columns_number();
+    const Tensor<Index, 1> outputs_dimensions = get_outputs_dimensions();
+
+    Index neurons_number = 1;
+
+    for(Index i = 0; i < outputs_dimensions.size(); i++) neurons_number *= outputs_dimensions(i);
+
+    return neurons_number;
 }
 
 
 /// Returns the layer's outputs dimensions.
+/// They are the inputs dimensions, with the last dimension equal to the sum of the last dimensions of all the inputs.
 
 Tensor<Index, 1> ConcatenationLayer::get_outputs_dimensions() const
 {
-    Tensor<Index, 1> outputs_dimensions(3);
+    Tensor<Index, 1> outputs_dimensions = inputs_dimensions;
 
-    outputs_dimensions[0] = get_outputs_rows_number();
-    outputs_dimensions[1] = get_outputs_columns_number();
-    outputs_dimensions[2] = inputs_dimensions[2];
+    const Index inputs_rank = inputs_dimensions.size();
+
+    if(inputs_rank == 0) return outputs_dimensions;
+
+    Index last_dimension = 0;
+
+    for(Index i = 0; i < inputs_last_dimensions.size(); i++) last_dimension += inputs_last_dimensions(i);
+
+    outputs_dimensions(inputs_rank - 1) = last_dimension;
 
     return outputs_dimensions;
 }
 
 
-/// Returns the number of inputs of the layer.
+/// Returns the size of the last dimension of each input.
+
+const Tensor<Index, 1>& ConcatenationLayer::get_inputs_last_dimensions() const
+{
+    return inputs_last_dimensions;
+}
+
+
+/// Returns the number of inputs of each sample of the layer, which is the number of outputs.
 
 Index ConcatenationLayer::get_inputs_number() const
 {
-    return inputs_dimensions.size();
+    return get_neurons_number();
 }
 
 
@@ -79,7 +98,7 @@ Index ConcatenationLayer::get_inputs_number() const
 
 Index ConcatenationLayer::get_inputs_rows_number() const
 {
-    return inputs_dimensions[0];
+    return inputs_dimensions.size() > 0 ? inputs_dimensions[0] : 1;
 }
 
 
@@ -87,7 +106,7 @@ Index ConcatenationLayer::get_inputs_rows_number() const
 
 Index ConcatenationLayer::get_inputs_columns_number() const
 {
-    return inputs_dimensions[1];
+    return inputs_dimensions.size() > 1 ? inputs_dimensions[1] : 1;
 }
 
 
@@ -95,7 +114,7 @@ Index ConcatenationLayer::get_inputs_columns_number() const
 
 Index ConcatenationLayer::get_channels_number() const
 {
-    return inputs_dimensions[2];
+    return inputs_dimensions.size() > 2 ? inputs_dimensions[2] : 1;
 }
 
 
@@ -103,7 +122,9 @@ Index ConcatenationLayer::get_channels_number() const
 
 Index ConcatenationLayer::get_outputs_rows_number() const
 {
-    return 0;
+    const Tensor<Index, 1> outputs_dimensions = get_outputs_dimensions();
+
+    return outputs_dimensions.size() > 0 ? outputs_dimensions[0] : 1;
 }
 
 
@@ -111,7 +132,9 @@ Index ConcatenationLayer::get_outputs_rows_number() const
 
 Index ConcatenationLayer::get_outputs_columns_number() const
 {
-    return 0;
+    const Tensor<Index, 1> outputs_dimensions = get_outputs_dimensions();
+
+    return outputs_dimensions.size() > 1 ? outputs_dimensions[1] : 1;
 }
 
 
@@ -139,10 +162,12 @@ Tensor<Index, 1> ConcatenationLayer::get_inputs_dimensions() const
 }
 
 
-void ConcatenationLayer::set(const Tensor<Index, 1>& new_input_variables_dimensions, const Tensor<Index, 1>& new_pool_dimensions)
+void ConcatenationLayer::set(const Tensor<Index, 1>& new_input_variables_dimensions, const Tensor<Index, 1>& new_inputs_last_dimensions)
 {
     inputs_dimensions = new_input_variables_dimensions;
 
+    inputs_last_dimensions = new_inputs_last_dimensions;
+
     set_default();
 }
 
@@ -157,52 +182,278 @@ void ConcatenationLayer::set_name(const string& new_layer_name)
 void ConcatenationLayer::set_inputs_dimensions(const Tensor<Index, 1>& new_inputs_dimensions)
 {
     inputs_dimensions = new_inputs_dimensions;
+
+    const Index inputs_rank = inputs_dimensions.size();
+
+    if(inputs_rank == 0) return;
+
+    inputs_last_dimensions.resize(1);
+    inputs_last_dimensions(0) = inputs_dimensions(inputs_rank - 1);
 }
 
 
-/// Sets the layer type to Layer::Pooling.
+/// Sets the size of the last dimension of each input, in the order of the layer inputs.
+/// @param new_inputs_last_dimensions The desired last dimensions.
+
+void ConcatenationLayer::set_inputs_last_dimensions(const Tensor<Index, 1>& new_inputs_last_dimensions)
+{
+    inputs_last_dimensions = new_inputs_last_dimensions;
+}
+
+
+/// Sets the layer type to Layer::Concatenation.
 
 void ConcatenationLayer::set_default()
 {
-    layer_type = Layer::Type::Pooling;
+    layer_type = Layer::Type::Concatenation;
+
+    layer_name = "concatenation_layer";
 }
 
 
+/// Concatenates the inputs of the layer along their last dimension.
+/// As tensors are stored in column-major order, each input is copied as a contiguous block of the outputs.
+
 void ConcatenationLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
-                                     LayerForwardPropagation* layer_forward_propagation,
-                                     const bool& is_training)
+                                           LayerForwardPropagation* layer_forward_propagation,
+                                           const bool& is_training)
 {
-    if(layer_forward_propagation == nullptr) cout << "NULL" << endl;
+    const Index inputs_number = inputs.size();
+
+    const Index outputs_size = layer_forward_propagation->outputs(0).get_size();
+
+    Index inputs_size = 0;
+
+    for(Index i = 0; i < inputs_number; i++) inputs_size += inputs(i).get_size();
+
+    if(inputs_size != outputs_size)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: ConcatenationLayer class.\n"
+               << "void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, LayerForwardPropagation*, const bool&) method.\n"
+               << "Sum of inputs sizes (" << inputs_size << ") must be equal to outputs size (" << outputs_size << ").\n";
 
+        throw invalid_argument(buffer.str());
+    }
+
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+
+    for(Index i = 0; i < inputs_number; i++)
+    {
+        const Index input_size = inputs(i).get_size();
+
+        memcpy(outputs_data, inputs(i).get_data(), static_cast<size_t>(input_size)*sizeof(type));
+
+        outputs_data += input_size;
+    }
 }
 
 
 void ConcatenationLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
-                                          LayerBackPropagation* next_layer_back_propagation,
-                                          LayerBackPropagation* this_layeer_back_propagation) const
+                                                LayerBackPropagation* next_layer_back_propagation,
+                                                LayerBackPropagation* layer_back_propagation) const
 {
-    /// @todo put switch
-    /*
-    if(pooling_method == PoolingMethod::NoPooling) return next_layer_delta;
+    switch(next_layer_back_propagation->layer_pointer->get_type())
+    {
+    case Type::Perceptron:
+    {
+        PerceptronLayerForwardPropagation* next_perceptron_layer_forward_propagation =
+                static_cast<PerceptronLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        PerceptronLayerBackPropagation* next_perceptron_layer_back_propagation =
+                static_cast<PerceptronLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_perceptron_layer_forward_propagation,
+                               next_perceptron_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Probabilistic:
+    {
+        ProbabilisticLayerForwardPropagation* next_probabilistic_layer_forward_propagation =
+                static_cast<ProbabilisticLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        ProbabilisticLayerBackPropagation* next_probabilistic_layer_back_propagation =
+                static_cast<ProbabilisticLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_probabilistic_layer_forward_propagation,
+                               next_probabilistic_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Convolutional:
+    {
+        ConvolutionalLayerForwardPropagation* next_convolutional_layer_forward_propagation =
+                static_cast<ConvolutionalLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        ConvolutionalLayerBackPropagation* next_convolutional_layer_back_propagation =
+                static_cast<ConvolutionalLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_convolutional_layer_forward_propagation,
+                               next_convolutional_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
 
+    case Type::Pooling:
+    {
+        PoolingLayerForwardPropagation* next_pooling_layer_forward_propagation =
+                static_cast<PoolingLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        PoolingLayerBackPropagation* next_pooling_layer_back_propagation =
+                static_cast<PoolingLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_pooling_layer_forward_propagation,
+                               next_pooling_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    case Type::Flatten:
+    {
+        FlattenLayerForwardPropagation* next_flatten_layer_forward_propagation =
+                static_cast<FlattenLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        FlattenLayerBackPropagation* next_flatten_layer_back_propagation =
+                static_cast<FlattenLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_flatten_layer_forward_propagation,
+                               next_flatten_layer_back_propagation,
+                               layer_back_propagation);
+    }
+        break;
+
+    default:
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: ConcatenationLayer class.\n"
+               << "void calculate_hidden_delta(LayerForwardPropagation*, LayerBackPropagation*, LayerBackPropagation*) const method.\n"
+               << "Next layer type " << next_layer_back_propagation->layer_pointer->get_type_string() << " is not implemented.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+    }
+}
+
+
+void ConcatenationLayer::calculate_hidden_delta(PerceptronLayerForwardPropagation* next_forward_propagation,
+                                                PerceptronLayerBackPropagation* next_back_propagation,
+                                                LayerBackPropagation* back_propagation) const
+{
+    const Tensor<type, 2>& next_synaptic_weights = static_cast<PerceptronLayer*>(next_back_propagation->layer_pointer)->get_synaptic_weights();
+
+    const TensorMap<Tensor<type, 2>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->deltas_dimensions(0),
+                                                 next_back_propagation->deltas_dimensions(1));
+
+    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data,
+                                      back_propagation->batch_samples_number,
+                                      get_neurons_number());
+
+    deltas.device(*thread_pool_device) = (next_deltas*next_forward_propagation->activations_derivatives).contract(next_synaptic_weights, A_BT);
+}
+
+
+void ConcatenationLayer::calculate_hidden_delta(ProbabilisticLayerForwardPropagation* next_forward_propagation,
+                                                ProbabilisticLayerBackPropagation* next_back_propagation,
+                                                LayerBackPropagation* back_propagation) const
+{
+    const ProbabilisticLayer* probabilistic_layer_pointer = static_cast<ProbabilisticLayer*>(next_back_propagation->layer_pointer);
+
+    const Tensor<type, 2>& next_synaptic_weights = probabilistic_layer_pointer->get_synaptic_weights();
+
+    const Index next_neurons_number = probabilistic_layer_pointer->get_neurons_number();
+
+    const Index batch_samples_number = back_propagation->batch_samples_number;
+
+    const TensorMap<Tensor<type, 2>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->deltas_dimensions(0),
+                                                 next_back_propagation->deltas_dimensions(1));
+
+    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data,
+                                      batch_samples_number,
+                                      get_neurons_number());
+
+    if(next_neurons_number == 1
+    || probabilistic_layer_pointer->get_activation_function() != ProbabilisticLayer::ActivationFunction::Softmax)
+    {
+        const TensorMap<Tensor<type, 2>> activations_derivatives(next_forward_propagation->activations_derivatives.data(),
+                                                                 batch_samples_number,
+                                                                 next_neurons_number);
+
+        deltas.device(*thread_pool_device) = (next_deltas*activations_derivatives).contract(next_synaptic_weights, A_BT);
+    }
     else
     {
-        const Type layer_type = next_layer_pointer->get_type();
+        const Index step = next_neurons_number*next_neurons_number;
 
-        if(layer_type == Type::Convolutional)
+        for(Index i = 0; i < batch_samples_number; i++)
         {
-            ConvolutionalLayer* convolutional_layer = dynamic_cast<ConvolutionalLayer*>(next_layer_pointer);
+            next_back_propagation->delta_row = next_deltas.chip(i,0);
 
-            return calculate_hidden_delta_convolutional(convolutional_layer, activations, activations_derivatives, next_layer_delta);
-        }
-        else if(layer_type == Type::Pooling)
-        {
-            ConcatenationLayer* pooling_layer = dynamic_cast<ConcatenationLayer*>(next_layer_pointer);
+            TensorMap<Tensor<type, 2>> activations_derivatives_matrix(next_forward_propagation->activations_derivatives.data() + i*step,
+                                                                      next_neurons_number,
+                                                                      next_neurons_number);
 
-            return calculate_hidden_delta_pooling(pooling_layer, activations, activations_derivatives, next_layer_delta);
+            next_back_propagation->error_combinations_derivatives.chip(i,0) =
+                    next_back_propagation->delta_row.contract(activations_derivatives_matrix, AT_B);
         }
+
+        deltas.device(*thread_pool_device) =
+                next_back_propagation->error_combinations_derivatives.contract(next_synaptic_weights, A_BT);
     }
-    */
+}
+
+
+/// The deltas of this layer are the derivatives of the error with respect to the inputs of the next convolutional layer.
+
+void ConcatenationLayer::calculate_hidden_delta(ConvolutionalLayerForwardPropagation* next_forward_propagation,
+                                                ConvolutionalLayerBackPropagation* next_back_propagation,
+                                                LayerBackPropagation* back_propagation) const
+{
+    const ConvolutionalLayer* next_convolutional_layer = static_cast<ConvolutionalLayer*>(next_back_propagation->layer_pointer);
+
+    const TensorMap<Tensor<type, 4>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->get_deltas_dimensions_array());
+
+    next_back_propagation->deltas_times_activations_derivatives.device(*thread_pool_device)
+            = next_deltas*next_forward_propagation->activations_derivatives;
+
+    next_convolutional_layer->calculate_inputs_derivatives(next_back_propagation, back_propagation->deltas_data);
+}
+
+
+/// The deltas of this layer are the derivatives of the error with respect to the inputs of the next pooling layer.
+
+void ConcatenationLayer::calculate_hidden_delta(PoolingLayerForwardPropagation* next_forward_propagation,
+                                                PoolingLayerBackPropagation* next_back_propagation,
+                                                LayerBackPropagation* back_propagation) const
+{
+    const PoolingLayer* next_pooling_layer = static_cast<PoolingLayer*>(next_back_propagation->layer_pointer);
+
+    next_pooling_layer->calculate_inputs_derivatives(next_forward_propagation,
+                                                     next_back_propagation,
+                                                     back_propagation->deltas_data);
+}
+
+
+/// A flatten layer only reshapes its inputs, so the deltas of this layer are those of the next layer.
+
+void ConcatenationLayer::calculate_hidden_delta(FlattenLayerForwardPropagation* next_forward_propagation,
+                                                FlattenLayerBackPropagation* next_back_propagation,
+                                                LayerBackPropagation* back_propagation) const
+{
+    const Index batch_samples_number = back_propagation->batch_samples_number;
+
+    const Index next_neurons_number = next_forward_propagation->layer_pointer->get_neurons_number();
+
+    memcpy(back_propagation->deltas_data,
+           next_back_propagation->deltas_data,
+           static_cast<size_t>(batch_samples_number*next_neurons_number)*sizeof(type));
 }
 
 
@@ -22,9 +22,11 @@
 // OpenNN includes
 
 #include "config.h"
-//#include "convolutional_layer.h"
+#include "convolutional_layer.h"
 #include "layer.h"
 #include "flatten_layer.h"
+#include "perceptron_layer.h"
+#include "probabilistic_layer.h"
 
 #include "statistics.h"
 
@@ -34,8 +36,8 @@ namespace opennn
 struct ConcatenationLayerForwardPropagation;
 struct ConcatenationLayerBackPropagation;
 
-/// This class represents the Pooling Layer in Convolutional Neural Network(CNN).
-/// Pooling: is the procross_entropy_errors of merging, ie, reducing the size of the data and remove some noise by different processes.
+/// This class represents a layer which concatenates the outputs of several layers along their last dimension.
+/// It is used to merge branches of a neural network graph.
 
 class ConcatenationLayer : public Layer
 {
@@ -55,6 +57,8 @@ public:
     Tensor<Index, 1> get_inputs_dimensions() const;
     Tensor<Index, 1> get_outputs_dimensions() const;
 
+    const Tensor<Index, 1>& get_inputs_last_dimensions() const;
+
     Index get_inputs_number() const;
 
     Index get_channels_number() const;
@@ -79,9 +83,11 @@ public:
 
     void set_inputs_number(const Index&) {}
     void set_neurons_number(const Index&) {}
+    void set_parameters(const Tensor<type, 1>&, const Index&) final {}
     void set_name(const string&);
 
     void set_inputs_dimensions(const Tensor<Index, 1>&);
+    void set_inputs_last_dimensions(const Tensor<Index, 1>&);
 
     void set_default();
 
@@ -97,6 +103,26 @@ public:
 
     void calculate_hidden_delta(LayerForwardPropagation*,
                                 LayerBackPropagation*,
+                                LayerBackPropagation*) const final;
+
+    void calculate_hidden_delta(PerceptronLayerForwardPropagation*,
+                                PerceptronLayerBackPropagation*,
+                                LayerBackPropagation*) const;
+
+    void calculate_hidden_delta(ProbabilisticLayerForwardPropagation*,
+                                ProbabilisticLayerBackPropagation*,
+                                LayerBackPropagation*) const;
+
+    void calculate_hidden_delta(ConvolutionalLayerForwardPropagation*,
+                                ConvolutionalLayerBackPropagation*,
+                                LayerBackPropagation*) const;
+
+    void calculate_hidden_delta(PoolingLayerForwardPropagation*,
+                                PoolingLayerBackPropagation*,
+                                LayerBackPropagation*) const;
+
+    void calculate_hidden_delta(FlattenLayerForwardPropagation*,
+                                FlattenLayerBackPropagation*,
                                 LayerBackPropagation*) const;
 
     // Serialization methods
@@ -106,8 +132,14 @@ public:
 
 protected:
 
+    /// Dimensions of each sample of the first input.
+
     Tensor<Index, 1> inputs_dimensions;
 
+    /// Size of the last dimension of each input, in the order of the layer inputs.
+
+    Tensor<Index, 1> inputs_last_dimensions;
+
 #ifdef OPENNN_CUDA
 #include "../../opennn-cuda/op(3, 3, 3, 64)ennn-cuda/concatenation_layer_cuda.h"
 #endif
@@ -132,34 +164,6 @@ struct ConcatenationLayerForwardPropagation : LayerForwardPropagation
         set(new_batch_samples_number, new_layer_pointer);
     }
 
-    Eigen::array<ptrdiff_t, 4> get_inputs_dimensions_array() const
-    {
-        ConcatenationLayer* concatenation_layer_pointer = static_cast<ConcatenationLayer*>(layer_pointer);
-
-        const Index inputs_rows_number = concatenation_layer_pointer->get_inputs_rows_number();
-        const Index inputs_columns_number = concatenation_layer_pointer->get_inputs_columns_number();
-        const Index inputs_channels_number = concatenation_layer_pointer->get_channels_number();
-
-        return Eigen::array<ptrdiff_t, 4>({batch_samples_number,
-                                           inputs_rows_number,
-                                           inputs_columns_number,
-                                           inputs_channels_number});
-    }
-
-    Eigen::array<ptrdiff_t, 4> get_outputs_dimensions_array() const
-    {
-        ConcatenationLayer* concatenation_layer_pointer = static_cast<ConcatenationLayer*>(layer_pointer);
-
-        const Index oututs_columns_number =  concatenation_layer_pointer->get_outputs_columns_number();
-        const Index oututs_rows_number = concatenation_layer_pointer->get_outputs_rows_number();
-        const Index outputs_channels_number = concatenation_layer_pointer->get_channels_number();
-
-        return Eigen::array<ptrdiff_t, 4>({batch_samples_number,
-                                           oututs_rows_number,
-                                           oututs_columns_number,
-                                           outputs_channels_number});
-    }
-
     void set(const Index& new_batch_samples_number, Layer* new_layer_pointer)
     {
         batch_samples_number = new_batch_samples_number;
@@ -168,32 +172,31 @@ struct ConcatenationLayerForwardPropagation : LayerForwardPropagation
 
         const ConcatenationLayer* concatenation_layer_pointer = static_cast<ConcatenationLayer*>(layer_pointer);
 
-        const Index outputs_rows_number = concatenation_layer_pointer->get_outputs_rows_number();
+        const Tensor<Index, 1> layer_outputs_dimensions = concatenation_layer_pointer->get_outputs_dimensions();
+
+        const Index layer_outputs_rank = layer_outputs_dimensions.size();
 
-        const Index outputs_columns_number = concatenation_layer_pointer->get_outputs_columns_number();
+        Tensor<Index, 1> output_dimensions(layer_outputs_rank + 1);
 
-        const Index channels_number = concatenation_layer_pointer->get_channels_number();
+        output_dimensions(0) = batch_samples_number;
+
+        for(Index i = 0; i < layer_outputs_rank; i++) output_dimensions(i+1) = layer_outputs_dimensions(i);
 
         outputs.resize(1);
-        Tensor<Index, 1> output_dimensions(4);
-        output_dimensions.setValues({batch_samples_number,
-                                     outputs_rows_number,
-                                     outputs_columns_number,
-                                     channels_number});
-        outputs(0).set_dimensions(output_dimensions);
+        set_buffer_dimensions(outputs(0), output_dimensions);
     }
 
 
     void print() const
     {
-        cout << "concatenation layer forward propagation" << endl;
+        cout << "Concatenation layer forward propagation" << endl;
 
         cout << "Outputs dimensions:" << endl;
         cout << outputs[0].get_dimensions() << endl;
 
         cout << "Outputs:" << endl;
 
-        cout << outputs(0).to_tensor_map<4>() << endl;
+        cout << TensorMap<Tensor<type, 1>>(outputs(0).get_data(), outputs(0).get_size()) << endl;
      }
 };
 
@@ -222,27 +225,35 @@ struct ConcatenationLayerBackPropagation : LayerBackPropagation
 
         layer_pointer = new_layer_pointer;
 
-        const ConcatenationLayer* pooling_layer_pointer = static_cast<ConcatenationLayer*>(layer_pointer);
+        const ConcatenationLayer* concatenation_layer_pointer = static_cast<ConcatenationLayer*>(layer_pointer);
+
+        const Tensor<Index, 1> layer_outputs_dimensions = concatenation_layer_pointer->get_outputs_dimensions();
+
+        const Index layer_outputs_rank = layer_outputs_dimensions.size();
+
+        deltas_dimensions.resize(layer_outputs_rank + 1);
+
+        deltas_dimensions(0) = batch_samples_number;
+
+        Index deltas_size = batch_samples_number;
+
+        for(Index i = 0; i < layer_outputs_rank; i++)
+        {
+            deltas_dimensions(i+1) = layer_outputs_dimensions(i);
 
-        const Index outputs_rows_number = pooling_layer_pointer->get_outputs_rows_number();
-        const Index outputs_columns_number = pooling_layer_pointer->get_outputs_columns_number();
+            deltas_size *= layer_outputs_dimensions(i);
+        }
 
-        deltas_dimensions.resize(4);
-/*
-        deltas_dimensions.setValues({batch_samples_number,
-                                     kernels_number,
-                                     outputs_rows_number,
-                                     outputs_columns_number});
+        free(deltas_data);
 
-        deltas_data = (type*)malloc(static_cast<size_t>(batch_samples_number*kernels_number*outputs_rows_number*outputs_columns_number*sizeof(type)));
-*/
+        deltas_data = (type*)malloc(static_cast<size_t>(deltas_size*sizeof(type)));
     }
 
 
     void print() const
     {
-        cout << "Deltas:" << endl;
-        //cout << deltas << endl;
+        cout << "Deltas dimensions:" << endl;
+        cout << deltas_dimensions << endl;
 
     }
 };
@@ -9,6 +9,10 @@
 
 //#define OPENNN_MKL
 
+// Scalar type of the library. Define OPENNN_DOUBLE to build it in double precision.
+
+//#define OPENNN_DOUBLE
+
 #ifdef OPENNN_MKL
     #include "../mkl/mkl.h"
 #endif
@@ -57,8 +61,11 @@ namespace opennn
 {
     using namespace std;
     using namespace Eigen;
+#ifdef OPENNN_DOUBLE
+    using type = double;
+#else
     using type = float;
-//    typedef double type;
+#endif
 }
 
 
@@ -99,82 +99,503 @@ void ConvolutionalLayer::insert_padding(const Tensor<type, 4>& inputs, Tensor<ty
 }
 
 
-/// Calculate convolutions
+/// Calculates the convolutions of the inputs with all the kernels, plus the biases.
+/// Kernels of 3x3 with unit strides use the Winograd F(2x2,3x3) algorithm.
+/// Other kernels lower the inputs to a matrix (im2col) and multiply it by the kernels matrix.
+/// @param inputs_data Pointer to the inputs, with dimensions (batch samples, rows, columns, channels).
+/// @param layer_forward_propagation Forward propagation of the layer, where the outputs are written.
 
 void ConvolutionalLayer::calculate_convolutions(type* inputs_data,
                                                 LayerForwardPropagation* layer_forward_propagation) const
 {
-    ConvolutionalLayerForwardPropagation* convolutional_layer_forward_propagation
-            = static_cast<ConvolutionalLayerForwardPropagation*>(layer_forward_propagation);
+    if(is_winograd_convolution())
+    {
+        calculate_winograd_convolutions(inputs_data, layer_forward_propagation);
+    }
+    else
+    {
+        calculate_im2col_convolutions(inputs_data, layer_forward_propagation);
+    }
+}
 
-    const Eigen::array<ptrdiff_t, 4> inputs_dimensions_array
-            = convolutional_layer_forward_propagation->get_inputs_dimensions_array();
 
-    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+/// Returns true if the convolutions are calculated with the Winograd F(2x2,3x3) algorithm,
+/// that is, if the kernels have 3 rows and 3 columns and both strides are 1.
+
+bool ConvolutionalLayer::is_winograd_convolution() const
+{
+    return get_kernels_rows_number() == 3
+        && get_kernels_columns_number() == 3
+        && row_stride == 1
+        && column_stride == 1;
+}
+
+
+/// Returns the number of output positions whose im2col matrix is built at once,
+/// so that it fits in the cache and the matrix products are still efficient.
+/// @param positions_number Total number of output positions.
+
+Index ConvolutionalLayer::get_im2col_block_size(const Index& positions_number) const
+{
+    const Index single_kernel_size = get_kernels_rows_number()*get_kernels_columns_number()*get_kernels_channels_number();
+
+    return min(positions_number, max(Index(32), Index(131072)/single_kernel_size));
+}
+
+
+/// Lowers the inputs under the kernels at some output positions to an im2col matrix.
+/// The output positions are indexed as in the outputs, with the sample index varying fastest,
+/// and the matrix has one row per position and one column per kernel element, in the kernels order.
+/// Inputs outside the image because of the padding are zero.
+/// @param inputs_data Pointer to the inputs, with dimensions (batch samples, rows, columns, channels).
+/// @param batch_samples_number Number of samples in the batch.
+/// @param first_position Index of the first output position.
+/// @param positions_step Distance between consecutive output positions.
+/// @param positions_number Number of output positions, which is the number of rows of the matrix.
+/// @param columns_data Pointer to the im2col matrix.
+
+void ConvolutionalLayer::calculate_im2col(const type* inputs_data,
+                                          const Index& batch_samples_number,
+                                          const Index& first_position,
+                                          const Index& positions_step,
+                                          const Index& positions_number,
+                                          type* columns_data) const
+{
+    const Index inputs_rows_number = get_inputs_rows_number();
+    const Index inputs_columns_number = get_inputs_columns_number();
+    const Index channel_size = batch_samples_number*inputs_rows_number*inputs_columns_number;
+
+    const Index kernels_rows_number = get_kernels_rows_number();
+    const Index kernels_columns_number = get_kernels_columns_number();
+    const Index kernels_channels_number = get_kernels_channels_number();
+
+    const Index outputs_rows_number = get_outputs_rows_number();
+
+    const pair<Index, Index> padding = get_padding();
+
+    vector<Index> samples(positions_number);
+    vector<Index> first_rows(positions_number);
+    vector<Index> first_columns(positions_number);
+
+    for(Index i = 0; i < positions_number; i++)
+    {
+        const Index position = first_position + i*positions_step;
+
+        samples[i] = position%batch_samples_number;
+        first_rows[i] = ((position/batch_samples_number)%outputs_rows_number)*row_stride - padding.first;
+        first_columns[i] = (position/(batch_samples_number*outputs_rows_number))*column_stride - padding.second;
+    }
+
+    for(Index channel_index = 0; channel_index < kernels_channels_number; channel_index++)
+    {
+        const type* channel_data = inputs_data + channel_index*channel_size;
 
-    type* synaptic_weights_pointer = const_cast<type*>(synaptic_weights.data());
+        for(Index kernel_column = 0; kernel_column < kernels_columns_number; kernel_column++)
+        {
+            for(Index kernel_row = 0; kernel_row < kernels_rows_number; kernel_row++)
+            {
+                for(Index i = 0; i < positions_number; i++)
+                {
+                    const Index input_row = first_rows[i] + kernel_row;
+                    const Index input_column = first_columns[i] + kernel_column;
+
+                    columns_data[i] = input_row >= 0 && input_row < inputs_rows_number
+                                   && input_column >= 0 && input_column < inputs_columns_number
+                            ? channel_data[samples[i] + batch_samples_number*(input_row + inputs_rows_number*input_column)]
+                            : type(0);
+                }
+
+                columns_data += positions_number;
+            }
+        }
+    }
+}
 
-    type* biases_pointer = const_cast<type*>(biases.data());
 
-    TensorMap<Tensor<type, 4>> inputs(inputs_data, inputs_dimensions_array);
+/// Adds an im2col matrix back to the inputs it was lowered from (col2im).
+/// Inputs under several output positions get the sum of their elements, and padding elements are dropped.
+/// Different calls write to the same inputs if their output positions belong to the same sample.
+/// @param columns_data Pointer to the im2col matrix.
+/// @param batch_samples_number Number of samples in the batch.
+/// @param first_position Index of the first output position.
+/// @param positions_step Distance between consecutive output positions.
+/// @param positions_number Number of output positions, which is the number of rows of the matrix.
+/// @param inputs_data Pointer to the inputs, with dimensions (batch samples, rows, columns, channels).
 
-    Tensor<type, 4>& preprocessed_inputs = convolutional_layer_forward_propagation->preprocessed_inputs;
+void ConvolutionalLayer::calculate_col2im(const type* columns_data,
+                                          const Index& batch_samples_number,
+                                          const Index& first_position,
+                                          const Index& positions_step,
+                                          const Index& positions_number,
+                                          type* inputs_data) const
+{
+    const Index inputs_rows_number = get_inputs_rows_number();
+    const Index inputs_columns_number = get_inputs_columns_number();
+    const Index channel_size = batch_samples_number*inputs_rows_number*inputs_columns_number;
 
     const Index kernels_rows_number = get_kernels_rows_number();
     const Index kernels_columns_number = get_kernels_columns_number();
     const Index kernels_channels_number = get_kernels_channels_number();
+
+    const Index outputs_rows_number = get_outputs_rows_number();
+
+    const pair<Index, Index> padding = get_padding();
+
+    vector<Index> samples(positions_number);
+    vector<Index> first_rows(positions_number);
+    vector<Index> first_columns(positions_number);
+
+    for(Index i = 0; i < positions_number; i++)
+    {
+        const Index position = first_position + i*positions_step;
+
+        samples[i] = position%batch_samples_number;
+        first_rows[i] = ((position/batch_samples_number)%outputs_rows_number)*row_stride - padding.first;
+        first_columns[i] = (position/(batch_samples_number*outputs_rows_number))*column_stride - padding.second;
+    }
+
+    for(Index channel_index = 0; channel_index < kernels_channels_number; channel_index++)
+    {
+        type* channel_data = inputs_data + channel_index*channel_size;
+
+        for(Index kernel_column = 0; kernel_column < kernels_columns_number; kernel_column++)
+        {
+            for(Index kernel_row = 0; kernel_row < kernels_rows_number; kernel_row++)
+            {
+                for(Index i = 0; i < positions_number; i++)
+                {
+                    const Index input_row = first_rows[i] + kernel_row;
+                    const Index input_column = first_columns[i] + kernel_column;
+
+                    if(input_row < 0 || input_row >= inputs_rows_number
+                    || input_column < 0 || input_column >= inputs_columns_number) continue;
+
+                    channel_data[samples[i] + batch_samples_number*(input_row + inputs_rows_number*input_column)] += columns_data[i];
+                }
+
+                columns_data += positions_number;
+            }
+        }
+    }
+}
+
+
+/// Calculates the convolutions as a matrix product.
+/// Each row of the im2col matrix contains the inputs under the kernel at one output position,
+/// so that the outputs of all the kernels at that position are the product of that row and the kernels matrix.
+/// The output positions are split into blocks, whose im2col matrices fit in the cache and are built and multiplied in parallel,
+/// so that the whole im2col matrix is never stored.
+/// @param inputs_data Pointer to the inputs, with dimensions (batch samples, rows, columns, channels).
+/// @param layer_forward_propagation Forward propagation of the layer, where the outputs are written.
+
+void ConvolutionalLayer::calculate_im2col_convolutions(const type* inputs_data,
+                                                       LayerForwardPropagation* layer_forward_propagation) const
+{
+    const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
+
     const Index kernels_number = get_kernels_number();
 
-    const Index single_kernel_size = kernels_channels_number*kernels_rows_number*kernels_columns_number;
+    const Index single_kernel_size = get_kernels_rows_number()*get_kernels_columns_number()*get_kernels_channels_number();
+    const Index single_output_size = batch_samples_number*get_outputs_rows_number()*get_outputs_columns_number();
+
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+
+    const TensorMap<Tensor<type, 2>> kernels(const_cast<type*>(synaptic_weights.data()), single_kernel_size, kernels_number);
 
+    const Index block_size = get_im2col_block_size(single_output_size);
+
+    const Index blocks_number = (single_output_size + block_size - 1)/block_size;
+
+    const TensorOpCost cost(type(block_size*single_kernel_size*sizeof(type)),
+                            type(block_size*kernels_number*sizeof(type)),
+                            type(2*block_size*single_kernel_size*kernels_number));
+
+    thread_pool_device->parallelFor(blocks_number, cost, [&](Index first, Index last)
+    {
+        Tensor<type, 1> columns_buffer(block_size*single_kernel_size);
+        Tensor<type, 1> block_outputs_buffer(block_size*kernels_number);
+
+        for(Index block_index = first; block_index < last; block_index++)
+        {
+            const Index first_position = block_index*block_size;
+            const Index positions_number = min(block_size, single_output_size - first_position);
+
+            calculate_im2col(inputs_data, batch_samples_number, first_position, 1, positions_number, columns_buffer.data());
+
+            // GEMM
+
+            const TensorMap<Tensor<type, 2>> columns(columns_buffer.data(), positions_number, single_kernel_size);
+
+            TensorMap<Tensor<type, 2>> block_outputs(block_outputs_buffer.data(), positions_number, kernels_number);
+
+            block_outputs = columns.contract(kernels, A_B);
+
+            // Biases
+
+            for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+            {
+                const type bias = biases(kernel_index);
+
+                const type* block_output = block_outputs_buffer.data() + kernel_index*positions_number;
+
+                type* output = outputs_data + kernel_index*single_output_size + first_position;
+
+                for(Index i = 0; i < positions_number; i++)
+                {
+                    output[i] = block_output[i] + bias;
+                }
+            }
+        }
+    });
+}
+
+
+/// Calculates the convolutions of 3x3 kernels with unit strides with the Winograd F(2x2,3x3) algorithm.
+/// Each 4x4 input tile gives a 2x2 output tile with 16 multiplications per channel and kernel instead of 36.
+/// The kernels are transformed when the parameters are set, and the products of the transformed tiles and kernels
+/// are 16 matrix products per block of tiles, so that they run at GEMM speed.
+/// @param inputs_data Pointer to the inputs, with dimensions (batch samples, rows, columns, channels).
+/// @param layer_forward_propagation Forward propagation of the layer, where the outputs are written.
+
+void ConvolutionalLayer::calculate_winograd_convolutions(const type* inputs_data,
+                                                         LayerForwardPropagation* layer_forward_propagation) const
+{
     const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
+
+    const Index inputs_rows_number = get_inputs_rows_number();
+    const Index inputs_columns_number = get_inputs_columns_number();
+
+    const Index channels_number = get_kernels_channels_number();
+    const Index kernels_number = get_kernels_number();
+
     const Index outputs_rows_number = get_outputs_rows_number();
     const Index outputs_columns_number = get_outputs_columns_number();
+
+    const pair<Index, Index> padding = get_padding();
+
     const Index single_output_size = batch_samples_number*outputs_rows_number*outputs_columns_number;
 
-    if(convolution_type == ConvolutionType::Same)
+    const Index tiles_rows_number = (outputs_rows_number + 1)/2;
+    const Index tiles_columns_number = (outputs_columns_number + 1)/2;
+    const Index tiles_number = batch_samples_number*tiles_rows_number*tiles_columns_number;
+
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+
+    const Index kernels_matrix_size = channels_number*kernels_number;
+
+    const type* winograd_synaptic_weights_data = winograd_synaptic_weights.data();
+
+    // Tiles
+
+    const Index block_size = min(tiles_number, max(Index(32), Index(32768)/(channels_number + kernels_number)));
+
+    const Index blocks_number = (tiles_number + block_size - 1)/block_size;
+
+    const TensorOpCost cost(type(16*block_size*channels_number*sizeof(type)),
+                            type(4*block_size*kernels_number*sizeof(type)),
+                            type(32*block_size*channels_number*kernels_number));
+
+    thread_pool_device->parallelFor(blocks_number, cost, [&](Index first, Index last)
     {
-        const Eigen::array<pair<Index, Index>, 4> paddings = get_paddings();
+        Tensor<type, 1> inputs_tiles_buffer(block_size*channels_number*16);
+        Tensor<type, 1> outputs_tiles_buffer(block_size*kernels_number*16);
 
-        preprocessed_inputs = inputs.pad(paddings);
-    }
-    else
+        for(Index block_index = first; block_index < last; block_index++)
+        {
+            const Index first_tile = block_index*block_size;
+            const Index block_tiles_number = min(block_size, tiles_number - first_tile);
+
+            const Index inputs_tiles_size = block_tiles_number*channels_number;
+            const Index outputs_tiles_size = block_tiles_number*kernels_number;
+
+            type* inputs_tiles_data = inputs_tiles_buffer.data();
+            type* outputs_tiles_data = outputs_tiles_buffer.data();
+
+            // Inputs transformation, V = B^T d B
+
+            for(Index channel_index = 0; channel_index < channels_number; channel_index++)
+            {
+                const type* channel_data = inputs_data + channel_index*batch_samples_number*inputs_rows_number*inputs_columns_number;
+
+                for(Index tile = 0; tile < block_tiles_number; tile++)
+                {
+                    const Index tile_index = first_tile + tile;
+
+                    const Index sample_index = tile_index%batch_samples_number;
+                    const Index tile_row = (tile_index/batch_samples_number)%tiles_rows_number;
+                    const Index tile_column = tile_index/(batch_samples_number*tiles_rows_number);
+
+                    type d[4][4];
+
+                    for(Index column = 0; column < 4; column++)
+                    {
+                        const Index input_column = 2*tile_column - padding.second + column;
+
+                        for(Index row = 0; row < 4; row++)
+                        {
+                            const Index input_row = 2*tile_row - padding.first + row;
+
+                            d[row][column] = input_row >= 0 && input_row < inputs_rows_number
+                                          && input_column >= 0 && input_column < inputs_columns_number
+                                    ? channel_data[sample_index + batch_samples_number*(input_row + inputs_rows_number*input_column)]
+                                    : type(0);
+                        }
+                    }
+
+                    type t[4][4];
+
+                    for(Index column = 0; column < 4; column++)
+                    {
+                        t[0][column] = d[0][column] - d[2][column];
+                        t[1][column] = d[1][column] + d[2][column];
+                        t[2][column] = d[2][column] - d[1][column];
+                        t[3][column] = d[1][column] - d[3][column];
+                    }
+
+                    type* v = inputs_tiles_data + tile + block_tiles_number*channel_index;
+
+                    for(Index row = 0; row < 4; row++)
+                    {
+                        v[inputs_tiles_size*(row + 4*0)] = t[row][0] - t[row][2];
+                        v[inputs_tiles_size*(row + 4*1)] = t[row][1] + t[row][2];
+                        v[inputs_tiles_size*(row + 4*2)] = t[row][2] - t[row][1];
+                        v[inputs_tiles_size*(row + 4*3)] = t[row][1] - t[row][3];
+                    }
+                }
+            }
+
+            // Element-wise products, as one matrix product per tile element, M = V U
+
+            for(Index element = 0; element < 16; element++)
+            {
+                const TensorMap<Tensor<type, 2>> inputs_tiles(inputs_tiles_data + element*inputs_tiles_size,
+                                                              block_tiles_number,
+                                                              channels_number);
+
+                const TensorMap<Tensor<type, 2>> kernels_tiles(const_cast<type*>(winograd_synaptic_weights_data) + element*kernels_matrix_size,
+                                                               channels_number,
+                                                               kernels_number);
+
+                TensorMap<Tensor<type, 2>> outputs_tiles(outputs_tiles_data + element*outputs_tiles_size,
+                                                         block_tiles_number,
+                                                         kernels_number);
+
+                outputs_tiles = inputs_tiles.contract(kernels_tiles, A_B);
+            }
+
+            // Outputs transformation, Y = A^T M A, plus biases
+
+            for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+            {
+                const type bias = biases(kernel_index);
+
+                type* kernel_outputs_data = outputs_data + kernel_index*single_output_size;
+
+                for(Index tile = 0; tile < block_tiles_number; tile++)
+                {
+                    const Index tile_index = first_tile + tile;
+
+                    const Index sample_index = tile_index%batch_samples_number;
+                    const Index tile_row = (tile_index/batch_samples_number)%tiles_rows_number;
+                    const Index tile_column = tile_index/(batch_samples_number*tiles_rows_number);
+
+                    const type* m = outputs_tiles_data + tile + block_tiles_number*kernel_index;
+
+                    type s[2][4];
+
+                    for(Index column = 0; column < 4; column++)
+                    {
+                        const type m0 = m[outputs_tiles_size*(4*column)];
+                        const type m1 = m[outputs_tiles_size*(1 + 4*column)];
+                        const type m2 = m[outputs_tiles_size*(2 + 4*column)];
+                        const type m3 = m[outputs_tiles_size*(3 + 4*column)];
+
+                        s[0][column] = m0 + m1 + m2;
+                        s[1][column] = m1 - m2 - m3;
+                    }
+
+                    for(Index row = 0; row < 2; row++)
+                    {
+                        const Index output_row = 2*tile_row + row;
+
+                        if(output_row >= outputs_rows_number) break;
+
+                        const type y[2] = {s[row][0] + s[row][1] + s[row][2],
+                                           s[row][1] - s[row][2] - s[row][3]};
+
+                        for(Index column = 0; column < 2; column++)
+                        {
+                            const Index output_column = 2*tile_column + column;
+
+                            if(output_column >= outputs_columns_number) break;
+
+                            kernel_outputs_data[sample_index + batch_samples_number*(output_row + outputs_rows_number*output_column)]
+                                    = y[column] + bias;
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+
+/// Transforms the kernels for the Winograd convolutions, U = G g G^T, and stores them in the layer.
+/// It is called whenever the synaptic weights or the strides change, so that forward propagation does not repeat it.
+/// The transformed kernels are released if the layer does not use Winograd convolutions.
+
+void ConvolutionalLayer::update_winograd_synaptic_weights()
+{
+    if(!is_winograd_convolution())
     {
-        preprocessed_inputs = inputs;
+        winograd_synaptic_weights.resize(0, 0, 0);
+        return;
     }
 
-    if(row_stride != 1 || column_stride != 1)
-    {
-        const Eigen::array<ptrdiff_t, 4> strides = get_strides();
+    const Index channels_number = get_kernels_channels_number();
+    const Index kernels_number = get_kernels_number();
 
-        preprocessed_inputs.device(*thread_pool_device) = preprocessed_inputs.stride(strides);
-    }
+    const Index kernels_matrix_size = channels_number*kernels_number;
 
-//    const Eigen::array<pair<Index, Index>, 4> paddings = get_paddings();
-//    const Eigen::array<ptrdiff_t, 4> strides = get_strides();
+    winograd_synaptic_weights.resize(channels_number, kernels_number, 16);
 
-//    preprocessed_inputs = inputs.pad(paddings).stride(strides);
+    const type* synaptic_weights_data = synaptic_weights.data();
+    type* winograd_synaptic_weights_data = winograd_synaptic_weights.data();
 
-    for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+    for(Index i = 0; i < kernels_matrix_size; i++)
     {
-        const TensorMap<Tensor<type, 3>> kernel(synaptic_weights_pointer + kernel_index*single_kernel_size,
-                                                kernels_rows_number,
-                                                kernels_columns_number,
-                                                kernels_channels_number);
+        const type* g = synaptic_weights_data + 9*i;
+
+        type gg[4][3];
+
+        for(Index column = 0; column < 3; column++)
+        {
+            const type g0 = g[3*column];
+            const type g1 = g[1 + 3*column];
+            const type g2 = g[2 + 3*column];
+
+            gg[0][column] = g0;
+            gg[1][column] = type(0.5)*(g0 + g1 + g2);
+            gg[2][column] = type(0.5)*(g0 - g1 + g2);
+            gg[3][column] = g2;
+        }
 
-        TensorMap<Tensor<type, 4>> convolution(outputs_data + kernel_index*single_output_size,
-                                               batch_samples_number,
-                                               outputs_rows_number,
-                                               outputs_columns_number,
-                                               1);
+        for(Index row = 0; row < 4; row++)
+        {
+            const type u[4] = {gg[row][0],
+                               type(0.5)*(gg[row][0] + gg[row][1] + gg[row][2]),
+                               type(0.5)*(gg[row][0] - gg[row][1] + gg[row][2]),
+                               gg[row][2]};
 
-        convolution.device(*thread_pool_device) = preprocessed_inputs.convolve(kernel, convolutions_dimensions)
-                                                                     + biases_pointer[kernel_index];
+            for(Index column = 0; column < 4; column++)
+            {
+                winograd_synaptic_weights_data[i + kernels_matrix_size*(row + 4*column)] = u[column];
+            }
+        }
     }
 }
 
 
-
 // Batch normalization
 
 void ConvolutionalLayer::normalize(LayerForwardPropagation* layer_forward_propagation, const bool& is_training)
@@ -371,6 +792,203 @@ void ConvolutionalLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>&
 }
 
 
+/// Returns true if this layer and a following pooling layer can be calculated as a single block,
+/// which writes only the pooled outputs.
+/// That is the case for max pooling of windows which do not overlap,
+/// after a linear or rectified linear activation without batch normalization.
+/// Winograd convolutions are not fused, because they are faster than fused im2col convolutions.
+/// @param pooling_layer Pooling layer which follows this layer.
+
+bool ConvolutionalLayer::is_fusable(const PoolingLayer* pooling_layer) const
+{
+    return pooling_layer->get_pooling_method() == PoolingLayer::PoolingMethod::MaxPooling
+        && pooling_layer->get_row_stride() == pooling_layer->get_pool_rows_number()
+        && pooling_layer->get_column_stride() == pooling_layer->get_pool_columns_number()
+        && (activation_function == ActivationFunction::Linear || activation_function == ActivationFunction::RectifiedLinear)
+        && !batch_normalization
+        && !is_winograd_convolution();
+}
+
+
+/// Calculates the convolutions, biases and activations of this layer and the max pooling of the following layer
+/// as a single block, for layers which are fusable.
+/// Each task calculates the convolutions of some pooled rows of one pooling window column by column in cache,
+/// and reduces them, so that only the pooled outputs are written, instead of writing and reading the full outputs twice.
+/// When training, the activations derivatives of this layer and the indices of the maxima are written too,
+/// so that the back propagation of both layers does not change.
+/// The outputs of this layer are not calculated.
+/// @param inputs Inputs of this layer.
+/// @param layer_forward_propagation Forward propagation of this layer.
+/// @param pooling_layer Pooling layer which follows this layer.
+/// @param pooling_layer_forward_propagation Forward propagation of the pooling layer, where the pooled outputs are written.
+/// @param is_training True if the layers are being trained.
+
+void ConvolutionalLayer::forward_propagate_max_pooling(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                                       LayerForwardPropagation* layer_forward_propagation,
+                                                       const PoolingLayer* pooling_layer,
+                                                       LayerForwardPropagation* pooling_layer_forward_propagation,
+                                                       const bool& is_training) const
+{
+    ConvolutionalLayerForwardPropagation* convolutional_layer_forward_propagation
+            = static_cast<ConvolutionalLayerForwardPropagation*>(layer_forward_propagation);
+
+    PoolingLayerForwardPropagation* pooling_forward_propagation
+            = static_cast<PoolingLayerForwardPropagation*>(pooling_layer_forward_propagation);
+
+    const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
+
+    const Index kernels_number = get_kernels_number();
+
+    const Index outputs_rows_number = get_outputs_rows_number();
+    const Index outputs_columns_number = get_outputs_columns_number();
+
+    const Index single_kernel_size = get_kernels_rows_number()*get_kernels_columns_number()*get_kernels_channels_number();
+    const Index single_output_size = batch_samples_number*outputs_rows_number*outputs_columns_number;
+
+    const Index pool_rows_number = pooling_layer->get_pool_rows_number();
+    const Index pool_columns_number = pooling_layer->get_pool_columns_number();
+
+    const Index pooled_rows_number = pooling_layer->get_outputs_rows_number();
+    const Index pooled_columns_number = pooling_layer->get_outputs_columns_number();
+
+    const bool is_rectified_linear = activation_function == ActivationFunction::RectifiedLinear;
+
+    const type* inputs_data = inputs(0).get_data();
+
+    type* activations_derivatives_data = convolutional_layer_forward_propagation->activations_derivatives.data();
+
+    type* pooled_outputs_data = pooling_layer_forward_propagation->outputs(0).get_data();
+    Index* maximal_indices_data = pooling_forward_propagation->maximal_indices.data();
+
+    const TensorMap<Tensor<type, 2>> kernels(const_cast<type*>(synaptic_weights.data()), single_kernel_size, kernels_number);
+
+    // Each tile holds some pooled rows of the output columns of one pooling window.
+    // When training, the last rows and columns, which are not pooled, are calculated too for their activations derivatives
+
+    const Index tile_pooled_rows_number
+            = max(Index(1), get_im2col_block_size(single_output_size)/(batch_samples_number*pool_rows_number));
+
+    const Index tile_rows_number = tile_pooled_rows_number*pool_rows_number;
+
+    const Index rows_number = is_training ? outputs_rows_number : pooled_rows_number*pool_rows_number;
+    const Index columns_number = is_training ? outputs_columns_number : pooled_columns_number*pool_columns_number;
+
+    const Index row_tiles_number = (rows_number + tile_rows_number - 1)/tile_rows_number;
+    const Index column_tiles_number = (columns_number + pool_columns_number - 1)/pool_columns_number;
+
+    const Index block_size = batch_samples_number*tile_rows_number;
+
+    const TensorOpCost cost(type(pool_columns_number*block_size*single_kernel_size*sizeof(type)),
+                            type(block_size*kernels_number*sizeof(type)/pool_rows_number),
+                            type(2*pool_columns_number*block_size*single_kernel_size*kernels_number));
+
+    thread_pool_device->parallelFor(row_tiles_number*column_tiles_number, cost, [&](Index first, Index last)
+    {
+        Tensor<type, 1> columns_buffer(block_size*single_kernel_size);
+        Tensor<type, 1> block_outputs_buffer(block_size*kernels_number);
+
+        for(Index tile_index = first; tile_index < last; tile_index++)
+        {
+            const Index column_tile = tile_index/row_tiles_number;
+            const Index first_row = (tile_index%row_tiles_number)*tile_rows_number;
+            const Index last_row = min(first_row + tile_rows_number, rows_number);
+
+            const Index first_pooled_row = first_row/pool_rows_number;
+            const Index last_pooled_row = min(last_row, pooled_rows_number*pool_rows_number)/pool_rows_number;
+
+            const bool is_pooled = column_tile < pooled_columns_number;
+
+            const Index positions_number = batch_samples_number*(last_row - first_row);
+
+            for(Index pool_column = 0; pool_column < pool_columns_number; pool_column++)
+            {
+                const Index output_column = column_tile*pool_columns_number + pool_column;
+
+                if(output_column >= columns_number) break;
+
+                const Index first_position = batch_samples_number*(first_row + outputs_rows_number*output_column);
+
+                calculate_im2col(inputs_data, batch_samples_number, first_position, 1, positions_number, columns_buffer.data());
+
+                const TensorMap<Tensor<type, 2>> columns(columns_buffer.data(), positions_number, single_kernel_size);
+
+                TensorMap<Tensor<type, 2>> block_outputs(block_outputs_buffer.data(), positions_number, kernels_number);
+
+                block_outputs = columns.contract(kernels, A_B);
+
+                for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+                {
+                    const type bias = biases(kernel_index);
+
+                    type* kernel_outputs = block_outputs_buffer.data() + kernel_index*positions_number;
+
+                    // Biases, activations and activations derivatives
+
+                    for(Index i = 0; i < positions_number; i++)
+                    {
+                        kernel_outputs[i] += bias;
+                    }
+
+                    if(is_training)
+                    {
+                        type* kernel_activations_derivatives = activations_derivatives_data + kernel_index*single_output_size + first_position;
+
+                        for(Index i = 0; i < positions_number; i++)
+                        {
+                            kernel_activations_derivatives[i] = !is_rectified_linear || kernel_outputs[i] > type(0) ? type(1) : type(0);
+                        }
+                    }
+
+                    if(!is_pooled) continue;
+
+                    // Max pooling, accumulated over the columns of the pooling window
+
+                    for(Index pooled_row = first_pooled_row; pooled_row < last_pooled_row; pooled_row++)
+                    {
+                        const Index pooled_index
+                                = batch_samples_number*(pooled_row + pooled_rows_number*(column_tile + pooled_columns_number*kernel_index));
+
+                        type* pooled_outputs = pooled_outputs_data + pooled_index;
+                        Index* maximal_indices = maximal_indices_data + pooled_index;
+
+                        for(Index pool_row = 0; pool_row < pool_rows_number; pool_row++)
+                        {
+                            const Index window_index = batch_samples_number*(pooled_row*pool_rows_number + pool_row - first_row);
+
+                            const type* window_outputs = kernel_outputs + window_index;
+
+                            const bool is_first = pool_row == 0 && pool_column == 0;
+
+                            for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
+                            {
+                                if(is_first || window_outputs[sample_index] > pooled_outputs[sample_index])
+                                {
+                                    pooled_outputs[sample_index] = window_outputs[sample_index];
+
+                                    if(is_training)
+                                    {
+                                        maximal_indices[sample_index]
+                                                = kernel_index*single_output_size + first_position + window_index + sample_index;
+                                    }
+                                }
+                            }
+                        }
+
+                        if(is_rectified_linear && pool_column == pool_columns_number - 1)
+                        {
+                            for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
+                            {
+                                pooled_outputs[sample_index] = max(pooled_outputs[sample_index], type(0));
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    });
+}
+
+
 void ConvolutionalLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
                                                 LayerBackPropagation* next_layer_back_propagation,
                                                 LayerBackPropagation* this_layer_back_propagation) const
@@ -392,6 +1010,22 @@ void ConvolutionalLayer::calculate_hidden_delta(LayerForwardPropagation* next_la
                               next_convolutional_layer_back_propagation,
                               this_convolutional_layer_back_propagation);
     }
+        break;
+
+    case Type::Pooling:
+    {
+        PoolingLayerForwardPropagation* next_pooling_layer_forward_propagation =
+                static_cast<PoolingLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        PoolingLayerBackPropagation* next_pooling_layer_back_propagation =
+                static_cast<PoolingLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_pooling_layer_forward_propagation,
+                               next_pooling_layer_back_propagation,
+                               this_convolutional_layer_back_propagation);
+    }
+        break;
+
     case Type::Flatten:
     {
 
@@ -419,23 +1053,104 @@ void ConvolutionalLayer::calculate_hidden_delta(ConvolutionalLayerForwardPropaga
                                                 ConvolutionalLayerBackPropagation* next_convolutional_layer_back_propagation,
                                                 ConvolutionalLayerBackPropagation* this_convolutional_layer_back_propagation) const
 {
+    const ConvolutionalLayer* next_convolutional_layer
+            = static_cast<ConvolutionalLayer*>(next_convolutional_layer_back_propagation->layer_pointer);
+
     const TensorMap<Tensor<type, 4>> next_deltas(next_convolutional_layer_back_propagation->deltas_data,
-                                                 next_convolutional_layer_back_propagation->deltas_dimensions(0),
-                                                 next_convolutional_layer_back_propagation->deltas_dimensions(1),
-                                                 next_convolutional_layer_back_propagation->deltas_dimensions(2),
-                                                 next_convolutional_layer_back_propagation->deltas_dimensions(3));
+                                                 next_convolutional_layer_back_propagation->get_deltas_dimensions_array());
 
+    next_convolutional_layer_back_propagation->deltas_times_activations_derivatives.device(*thread_pool_device)
+            = next_deltas*next_convolutional_layer_forward_propagation->activations_derivatives;
+
+    next_convolutional_layer->calculate_inputs_derivatives(next_convolutional_layer_back_propagation,
+                                                           this_convolutional_layer_back_propagation->deltas_data);
+}
 
-    // (next deltas * activations derivatives) ¿convolve? kernels
+
+void ConvolutionalLayer::calculate_hidden_delta(PoolingLayerForwardPropagation* next_pooling_layer_forward_propagation,
+                                                PoolingLayerBackPropagation* next_pooling_layer_back_propagation,
+                                                ConvolutionalLayerBackPropagation* this_convolutional_layer_back_propagation) const
+{
+    const PoolingLayer* next_pooling_layer = static_cast<PoolingLayer*>(next_pooling_layer_back_propagation->layer_pointer);
+
+    next_pooling_layer->calculate_inputs_derivatives(next_pooling_layer_forward_propagation,
+                                                     next_pooling_layer_back_propagation,
+                                                     this_convolutional_layer_back_propagation->deltas_data);
+}
+
+
+/// Calculates the derivatives of the error with respect to the inputs of this layer,
+/// from the products of its deltas and activations derivatives.
+/// They are the products of those and the transposed kernels matrix, added back to the inputs positions (col2im).
+/// The samples are calculated in parallel, since the inputs of different samples do not overlap.
+/// @param back_propagation Back propagation of this layer, with the deltas times activations derivatives.
+/// @param inputs_derivatives_data Pointer to the inputs derivatives, with dimensions (batch samples, rows, columns, channels).
+
+void ConvolutionalLayer::calculate_inputs_derivatives(ConvolutionalLayerBackPropagation* back_propagation,
+                                                      type* inputs_derivatives_data) const
+{
+    const Index batch_samples_number = back_propagation->batch_samples_number;
 
     const Index kernels_number = get_kernels_number();
 
-    for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+    const Index single_kernel_size = get_kernels_rows_number()*get_kernels_columns_number()*get_kernels_channels_number();
+    const Index single_output_size = batch_samples_number*get_outputs_rows_number()*get_outputs_columns_number();
+    const Index sample_positions_number = get_outputs_rows_number()*get_outputs_columns_number();
+    const Index sample_inputs_number = get_inputs_rows_number()*get_inputs_columns_number()*get_inputs_channels_number();
+
+    const type* deltas_times_activations_derivatives_data = back_propagation->deltas_times_activations_derivatives.data();
+
+    const TensorMap<Tensor<type, 2>> kernels(const_cast<type*>(synaptic_weights.data()), single_kernel_size, kernels_number);
+
+    const Index block_size = get_im2col_block_size(sample_positions_number);
+
+    const TensorOpCost cost(type(sample_positions_number*kernels_number*sizeof(type)),
+                            type(sample_inputs_number*sizeof(type)),
+                            type(2*sample_positions_number*single_kernel_size*kernels_number));
+
+    thread_pool_device->parallelFor(batch_samples_number, cost, [&](Index first, Index last)
     {
+        Tensor<type, 1> block_deltas_buffer(block_size*kernels_number);
+        Tensor<type, 1> columns_buffer(block_size*single_kernel_size);
 
-    }
+        for(Index sample_index = first; sample_index < last; sample_index++)
+        {
+            for(Index i = 0; i < sample_inputs_number; i++)
+            {
+                inputs_derivatives_data[sample_index + batch_samples_number*i] = type(0);
+            }
 
-    next_deltas * next_convolutional_layer_forward_propagation->activations_derivatives;
+            for(Index first_sample_position = 0; first_sample_position < sample_positions_number; first_sample_position += block_size)
+            {
+                const Index positions_number = min(block_size, sample_positions_number - first_sample_position);
+
+                const Index first_position = sample_index + batch_samples_number*first_sample_position;
+
+                for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+                {
+                    const type* kernel_deltas = deltas_times_activations_derivatives_data + kernel_index*single_output_size + first_position;
+
+                    for(Index i = 0; i < positions_number; i++)
+                    {
+                        block_deltas_buffer(i + kernel_index*positions_number) = kernel_deltas[i*batch_samples_number];
+                    }
+                }
+
+                const TensorMap<Tensor<type, 2>> block_deltas(block_deltas_buffer.data(), positions_number, kernels_number);
+
+                TensorMap<Tensor<type, 2>> columns(columns_buffer.data(), positions_number, single_kernel_size);
+
+                columns = block_deltas.contract(kernels, A_BT);
+
+                calculate_col2im(columns_buffer.data(),
+                                 batch_samples_number,
+                                 first_position,
+                                 batch_samples_number,
+                                 positions_number,
+                                 inputs_derivatives_data);
+            }
+        }
+    });
 }
 
 
@@ -464,22 +1179,25 @@ void ConvolutionalLayer::calculate_hidden_delta(FlattenLayerForwardPropagation*
 }
 
 
-void ConvolutionalLayer::calculate_error_gradient(type* input_data,
+/// Calculates the derivatives of the error with respect to the biases and the synaptic weights.
+/// The synaptic weights derivatives are the product of the transposed im2col matrix of the inputs
+/// and the deltas times activations derivatives.
+/// The output positions are split into as many chunks as threads, each of which accumulates its own derivatives,
+/// and the accumulators are added at the end.
+/// @param inputs_data Pointer to the inputs, with dimensions (batch samples, rows, columns, channels).
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, with the deltas.
+
+void ConvolutionalLayer::calculate_error_gradient(type* inputs_data,
                                                   LayerForwardPropagation* forward_propagation,
                                                   LayerBackPropagation* back_propagation) const
 {
-    const Index batch_samples_number = back_propagation->batch_samples_number;   
-    const Index inputs_rows_number = get_inputs_rows_number();
-    const Index inputs_columns_number = get_inputs_columns_number();
-    const Index inputs_channels_number = get_inputs_channels_number();
+    const Index batch_samples_number = back_propagation->batch_samples_number;
 
-    const Index kernels_number = get_kernels_number(); 
-    const Index kernels_rows_number = get_kernels_rows_number();
-    const Index kernels_columns_number = get_kernels_columns_number();
-    const Index kernels_channels_number = get_kernels_channels_number();
+    const Index kernels_number = get_kernels_number();
 
-    const Index outputs_rows_number = get_outputs_rows_number();
-    const Index outputs_columns_number = get_outputs_columns_number();
+    const Index single_kernel_size = get_kernels_rows_number()*get_kernels_columns_number()*get_kernels_channels_number();
+    const Index single_output_size = batch_samples_number*get_outputs_rows_number()*get_outputs_columns_number();
 
     ConvolutionalLayerForwardPropagation* convolutional_layer_forward_propagation =
             static_cast<ConvolutionalLayerForwardPropagation*>(forward_propagation);
@@ -487,80 +1205,90 @@ void ConvolutionalLayer::calculate_error_gradient(type* input_data,
     ConvolutionalLayerBackPropagation* convolutional_layer_back_propagation =
             static_cast<ConvolutionalLayerBackPropagation*>(back_propagation);
 
-    const Eigen::array<ptrdiff_t, 4> inputs_dimensions_array = convolutional_layer_forward_propagation->get_inputs_dimensions_array();
+    const TensorMap<Tensor<type, 4>> deltas(convolutional_layer_back_propagation->deltas_data,
+                                            convolutional_layer_back_propagation->get_deltas_dimensions_array());
 
-    const TensorMap<Tensor<type,4>> inputs(input_data, inputs_dimensions_array);
+    Tensor<type, 4>& deltas_times_activations_derivatives = convolutional_layer_back_propagation->deltas_times_activations_derivatives;
 
-    type* deltas_data = convolutional_layer_back_propagation->deltas_data;
+    deltas_times_activations_derivatives.device(*thread_pool_device)
+            = deltas*convolutional_layer_forward_propagation->activations_derivatives;
 
-    const Eigen::array<ptrdiff_t, 4> deltas_dimensions_array = convolutional_layer_back_propagation->get_deltas_dimensions_array();
+    const type* deltas_times_activations_derivatives_data = deltas_times_activations_derivatives.data();
 
-    const TensorMap<Tensor<type, 4>> deltas(deltas_data, deltas_dimensions_array);
+    // Biases derivatives
 
-    convolutional_layer_back_propagation->deltas_times_activations_derivatives.device(*thread_pool_device)
-            = deltas * convolutional_layer_forward_propagation->activations_derivatives;
+    const TensorMap<Tensor<type, 2>> deltas_times_activations_derivatives_matrix(deltas_times_activations_derivatives.data(),
+                                                                                 single_output_size,
+                                                                                 kernels_number);
 
-    Eigen::array<Eigen::Index, 4> offsets;
-    Eigen::array<Eigen::Index, 4> extents;
+    convolutional_layer_back_propagation->biases_derivatives.device(*thread_pool_device)
+            = deltas_times_activations_derivatives_matrix.sum(rows_sum);
 
     // Synaptic weights derivatives
 
-    const Eigen::array<ptrdiff_t, 3> convolutions_dimensions = {0, 1, 2};
+    const Index block_size = get_im2col_block_size(single_output_size);
 
-    Tensor<type, 4> delta_slice;
-    Tensor<type, 4> image_slice;
+    const Index blocks_number = (single_output_size + block_size - 1)/block_size;
 
-    type* synaptic_weights_derivatives_data = convolutional_layer_back_propagation->synaptic_weights_derivatives.data();
+    const Index chunks_number = min(blocks_number, Index(thread_pool_device->numThreads()));
 
-    const Index kernel_synaptic_weights_number = kernels_channels_number*kernels_rows_number*kernels_columns_number;
+    Tensor<type, 3>& synaptic_weights_derivatives_accumulators
+            = convolutional_layer_back_propagation->synaptic_weights_derivatives_accumulators;
 
-    for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+    if(synaptic_weights_derivatives_accumulators.dimension(2) != chunks_number)
+    {
+        synaptic_weights_derivatives_accumulators.resize(single_kernel_size, kernels_number, chunks_number);
+    }
+
+    const TensorOpCost cost(type(blocks_number*block_size*single_kernel_size*sizeof(type)/chunks_number),
+                            type(single_kernel_size*kernels_number*sizeof(type)),
+                            type(2*single_output_size*single_kernel_size*kernels_number/chunks_number));
+
+    thread_pool_device->parallelFor(chunks_number, cost, [&](Index first, Index last)
     {
-        TensorMap<Tensor<type, 3>> kernel_synaptic_weights_derivatives(synaptic_weights_derivatives_data + kernel_index*kernel_synaptic_weights_number,
-                                                                       kernels_rows_number,
-                                                                       kernels_columns_number,
-                                                                       kernels_channels_number);
+        Tensor<type, 1> columns_buffer(block_size*single_kernel_size);
+        Tensor<type, 1> block_deltas_buffer(block_size*kernels_number);
 
-        for(Index image_index = 0; image_index < batch_samples_number; image_index++)
+        for(Index chunk_index = first; chunk_index < last; chunk_index++)
         {
-            offsets = {image_index, 0, 0, kernel_index};
-            extents = {1, outputs_rows_number, outputs_columns_number, 1};
+            TensorMap<Tensor<type, 2>> synaptic_weights_derivatives_accumulator(synaptic_weights_derivatives_accumulators.data()
+                                                                                 + chunk_index*single_kernel_size*kernels_number,
+                                                                                 single_kernel_size,
+                                                                                 kernels_number);
 
-            delta_slice = convolutional_layer_back_propagation->deltas_times_activations_derivatives.slice(offsets, extents);
+            synaptic_weights_derivatives_accumulator.setZero();
 
-            offsets = {image_index, 0, 0, 0};
-            extents = {1, inputs_rows_number, inputs_columns_number, inputs_channels_number};
+            const Index first_block = chunk_index*blocks_number/chunks_number;
+            const Index last_block = (chunk_index + 1)*blocks_number/chunks_number;
 
-            image_slice = inputs.slice(offsets, extents);
+            for(Index block_index = first_block; block_index < last_block; block_index++)
+            {
+                const Index first_position = block_index*block_size;
+                const Index positions_number = min(block_size, single_output_size - first_position);
 
-            const TensorMap<Tensor<type, 3>> image(image_slice.data(),
-                                                   inputs_rows_number,
-                                                   inputs_columns_number,
-                                                   inputs_channels_number);
+                calculate_im2col(inputs_data, batch_samples_number, first_position, 1, positions_number, columns_buffer.data());
 
-            const TensorMap<Tensor<type, 3>> delta_reshape(delta_slice.data(),
-                                                           outputs_rows_number,
-                                                           outputs_columns_number,
-                                                           1);
+                for(Index kernel_index = 0; kernel_index < kernels_number; kernel_index++)
+                {
+                    copy(deltas_times_activations_derivatives_data + kernel_index*single_output_size + first_position,
+                         deltas_times_activations_derivatives_data + kernel_index*single_output_size + first_position + positions_number,
+                         block_deltas_buffer.data() + kernel_index*positions_number);
+                }
 
-            const Tensor<type, 0> current_sum = delta_slice.sum();
+                const TensorMap<Tensor<type, 2>> columns(columns_buffer.data(), positions_number, single_kernel_size);
 
-            if(image_index == 0)
-            {
-                kernel_synaptic_weights_derivatives = image.convolve(delta_reshape, convolutions_dimensions);
-                convolutional_layer_back_propagation->biases_derivatives(kernel_index) = current_sum();
-            }
-            else
-            {
-                kernel_synaptic_weights_derivatives += image.convolve(delta_reshape, convolutions_dimensions);
-                convolutional_layer_back_propagation->biases_derivatives(kernel_index) += current_sum();
+                const TensorMap<Tensor<type, 2>> block_deltas(block_deltas_buffer.data(), positions_number, kernels_number);
+
+                synaptic_weights_derivatives_accumulator += columns.contract(block_deltas, AT_B);
             }
         }
+    });
 
-        memcpy(synaptic_weights_derivatives_data + kernel_synaptic_weights_number*kernel_index,
-               kernel_synaptic_weights_derivatives.data(),
-               static_cast<size_t>(kernel_synaptic_weights_number)*sizeof(type));
-    }
+    TensorMap<Tensor<type, 2>> synaptic_weights_derivatives(convolutional_layer_back_propagation->synaptic_weights_derivatives.data(),
+                                                            single_kernel_size,
+                                                            kernels_number);
+
+    synaptic_weights_derivatives.device(*thread_pool_device) = synaptic_weights_derivatives_accumulators.sum(chunks_sum);
 }
 
 
@@ -906,6 +1634,8 @@ void ConvolutionalLayer::set(const Tensor<Index, 1>& new_inputs_dimensions,
 
     synaptic_weights.setRandom();
 
+    update_winograd_synaptic_weights();
+
     moving_means.resize(kernels_number);
     moving_standard_deviations.resize(kernels_number);
 
@@ -937,6 +1667,8 @@ void ConvolutionalLayer::set_biases_constant(const type& value)
 void ConvolutionalLayer::set_synaptic_weights_constant(const type& value)
 {
     synaptic_weights.setConstant(value);
+
+    update_winograd_synaptic_weights();
 }
 
 
@@ -958,6 +1690,8 @@ void ConvolutionalLayer::set_parameters_random()
     biases.setRandom();
 
     synaptic_weights.setRandom();
+
+    update_winograd_synaptic_weights();
 }
 
 
@@ -1048,6 +1782,8 @@ void ConvolutionalLayer::set_biases(const Tensor<type, 1>& new_biases)
 void ConvolutionalLayer::set_synaptic_weights(const Tensor<type, 4>& new_synaptic_weights)
 {
     synaptic_weights = new_synaptic_weights;
+
+    update_winograd_synaptic_weights();
 }
 
 
@@ -1101,6 +1837,8 @@ void ConvolutionalLayer::set_row_stride(const Index& new_stride_row)
     }
 
     row_stride = new_stride_row;
+
+    update_winograd_synaptic_weights();
 }
 
 
@@ -1115,6 +1853,8 @@ void ConvolutionalLayer::set_column_stride(const Index& new_stride_column)
     }
 
     column_stride = new_stride_column;
+
+    update_winograd_synaptic_weights();
 }
 
 void ConvolutionalLayer::set_inputs_dimensions(const Tensor<Index,1>& new_inputs_dimensions)
@@ -1147,6 +1887,8 @@ void ConvolutionalLayer::set_parameters(const Tensor<type, 1>& new_parameters, c
     memcpy(biases.data(),
            new_parameters.data() + index + synaptic_weights.size(),
            static_cast<size_t>(biases.size())*sizeof(type));
+
+    update_winograd_synaptic_weights();
 }
 
 
@@ -166,6 +166,18 @@ public:
 
     void calculate_convolutions(type*, LayerForwardPropagation*) const;
 
+    bool is_winograd_convolution() const;
+
+    void calculate_im2col_convolutions(const type*, LayerForwardPropagation*) const;
+
+    Index get_im2col_block_size(const Index&) const;
+
+    void calculate_im2col(const type*, const Index&, const Index&, const Index&, const Index&, type*) const;
+    void calculate_col2im(const type*, const Index&, const Index&, const Index&, const Index&, type*) const;
+    void calculate_winograd_convolutions(const type*, LayerForwardPropagation*) const;
+
+    void update_winograd_synaptic_weights();
+
     void normalize(LayerForwardPropagation*, const bool&);
     void shift(LayerForwardPropagation*);
 
@@ -178,6 +190,14 @@ public:
                            LayerForwardPropagation*,
                            const bool&) final;
 
+    bool is_fusable(const PoolingLayer*) const;
+
+    void forward_propagate_max_pooling(const Tensor<DynamicTensor<type>, 1>&,
+                                       LayerForwardPropagation*,
+                                       const PoolingLayer*,
+                                       LayerForwardPropagation*,
+                                       const bool&) const;
+
    // Outputs
 
    // Delta methods
@@ -198,6 +218,8 @@ public:
                                FlattenLayerBackPropagation*,
                                ConvolutionalLayerBackPropagation*) const;
 
+   void calculate_inputs_derivatives(ConvolutionalLayerBackPropagation*, type*) const;
+
    // Gradient methods
 
    void calculate_error_gradient(type*,
@@ -222,6 +244,11 @@ protected:
 
    Tensor<type, 1> biases;
 
+   /// Kernels transformed for the Winograd F(2x2,3x3) convolutions, with dimensions (channels, kernels, 16).
+   /// They are updated whenever the synaptic weights or the strides change, and empty if the layer does not use them.
+
+   Tensor<type, 3> winograd_synaptic_weights;
+
    Index row_stride = 1;
 
    Index column_stride = 1;
@@ -234,6 +261,8 @@ protected:
 
    const Eigen::array<ptrdiff_t, 3> convolutions_dimensions = {1, 2, 3};
    const Eigen::array<ptrdiff_t, 3> means_dimensions = {0, 1, 2};
+   const Eigen::array<Index, 1> rows_sum = {Index(0)};
+   const Eigen::array<Index, 1> chunks_sum = {Index(2)};
 
    // Batch normalization
 
@@ -331,27 +360,17 @@ struct ConvolutionalLayerForwardPropagation : LayerForwardPropagation
 
        const ConvolutionalLayer* convolutional_layer_pointer = static_cast<ConvolutionalLayer*>(layer_pointer);
 
-       const Index inputs_rows_number = convolutional_layer_pointer->get_inputs_rows_number();
-       const Index inputs_columns_number = convolutional_layer_pointer->get_inputs_columns_number();
-
-       const Index inputs_channels_number = convolutional_layer_pointer->get_inputs_channels_number();
-
        const Index kernels_number = convolutional_layer_pointer->get_kernels_number();
        const Index outputs_rows_number = convolutional_layer_pointer->get_outputs_rows_number();
        const Index outputs_columns_number = convolutional_layer_pointer->get_outputs_columns_number();
 
-       preprocessed_inputs.resize(batch_samples_number,
-                                  inputs_rows_number,
-                                  inputs_columns_number,
-                                  inputs_channels_number);
-
        outputs.resize(1);
        Tensor<Index, 1> output_dimensions(4);
        output_dimensions.setValues({batch_samples_number,
                                     outputs_rows_number,
                                     outputs_columns_number,
                                     kernels_number});
-       outputs(0).set_dimensions(output_dimensions);
+       set_buffer_dimensions(outputs(0), output_dimensions);
 
        means.resize(kernels_number);
        standard_deviations.resize(kernels_number);
@@ -378,8 +397,6 @@ struct ConvolutionalLayerForwardPropagation : LayerForwardPropagation
        cout << activations_derivatives << endl;
    }
 
-   Tensor<type, 4> preprocessed_inputs;
-
    Tensor<type, 1> means;
    Tensor<type, 1> standard_deviations;
 
@@ -483,6 +500,10 @@ struct ConvolutionalLayerBackPropagation : LayerBackPropagation
 
    Tensor<type, 1> biases_derivatives;
    Tensor<type, 4> synaptic_weights_derivatives;
+
+   /// Synaptic weights derivatives of each chunk of output positions, with dimensions (kernel size, kernels, chunks).
+
+   Tensor<type, 3> synaptic_weights_derivatives_accumulators;
 };
 
 
@@ -51,6 +51,20 @@ Tensor<type, 1> autocorrelations(const ThreadPoolDevice* thread_pool_device,
 Correlation correlation(const ThreadPoolDevice* thread_pool_device,
                         const Tensor<type, 2>& x,
                         const Tensor<type, 2>& y)
+{
+    return correlation(thread_pool_device, x, y, missing_values_mask(x, y));
+}
+
+
+/// Calculates the correlation between two variables, whose missing values have already been masked.
+/// @param x Matrix containing data.
+/// @param y Matrix for computing the correlation with this matrix.
+/// @param mask Rows of x and y without missing values.
+
+Correlation correlation(const ThreadPoolDevice* thread_pool_device,
+                        const Tensor<type, 2>& x,
+                        const Tensor<type, 2>& y,
+                        const MissingValuesMask& mask)
 {
     Correlation correlation;
 
@@ -67,17 +81,20 @@ Correlation correlation(const ThreadPoolDevice* thread_pool_device,
     {
         if(!x_binary && !y_binary)
         {
+            const Tensor<type, 1> x_vector = x.reshape(vector);
+            const Tensor<type, 1> y_vector = y.reshape(vector);
+
             const Correlation linear_correlation
-                    = opennn::linear_correlation(thread_pool_device, x.reshape(vector), y.reshape(vector));
+                    = opennn::linear_correlation(thread_pool_device, x_vector, y_vector, mask);
 
             const Correlation exponential_correlation
-                    = opennn::exponential_correlation(thread_pool_device, x.reshape(vector), y.reshape(vector));
+                    = opennn::exponential_correlation(thread_pool_device, x_vector, y_vector, mask);
 
             const Correlation logarithmic_correlation
-                    = opennn::logarithmic_correlation(thread_pool_device, x.reshape(vector), y.reshape(vector));
+                    = opennn::logarithmic_correlation(thread_pool_device, x_vector, y_vector, mask);
 
             const Correlation power_correlation
-                    = opennn::power_correlation(thread_pool_device, x.reshape(vector), y.reshape(vector));
+                    = opennn::power_correlation(thread_pool_device, x_vector, y_vector, mask);
 
             Correlation strongest_correlation = linear_correlation;
 
@@ -102,7 +119,7 @@ Correlation correlation(const ThreadPoolDevice* thread_pool_device,
         }
         else if(x_binary && y_binary)
         {
-            return opennn::linear_correlation(thread_pool_device, x.reshape(vector), y.reshape(vector));
+            return opennn::linear_correlation(thread_pool_device, x.reshape(vector), y.reshape(vector), mask);
         }
     }
     else if(x_columns != 1 && y_columns == 1)
@@ -241,6 +258,20 @@ Tensor<type, 1> cross_correlations(const ThreadPoolDevice* thread_pool_device,
 Correlation exponential_correlation(const ThreadPoolDevice* thread_pool_device,
                                     const Tensor<type, 1>& x,
                                     const Tensor<type, 1>& y)
+{
+    return exponential_correlation(thread_pool_device, x, y, missing_values_mask(x, y));
+}
+
+
+/// Calculate the coefficients of a exponential regression (a, b) over the rows without missing values.
+/// @param x Vector of the independent variable.
+/// @param y Vector of the dependent variable.
+/// @param mask Rows of x and y without missing values.
+
+Correlation exponential_correlation(const ThreadPoolDevice* thread_pool_device,
+                                    const Tensor<type, 1>& x,
+                                    const Tensor<type, 1>& y,
+                                    const MissingValuesMask& mask)
 {
 #ifdef OPENNN_DEBUG
 
@@ -272,7 +303,7 @@ Correlation exponential_correlation(const ThreadPoolDevice* thread_pool_device,
         }
     }
 
-    exponential_correlation = linear_correlation(thread_pool_device, x, y.log());
+    exponential_correlation = linear_correlation(thread_pool_device, x, y.log(), mask);
 
     exponential_correlation.correlation_type = CorrelationType::Exponential;
 
@@ -378,11 +409,11 @@ pair<Tensor<type, 1>, Tensor<type, 2>> filter_missing_values_vector_matrix(const
 }
 
 
-pair<Tensor<type, 1>, Tensor<type, 2>> filter_missing_values_matrix_vector(const Tensor<type, 2>&x,
-                                                                           const Tensor<type, 1>y)
+pair<Tensor<type, 1>, Tensor<type, 2>> filter_missing_values_matrix_vector(const Tensor<type, 2>& x,
+                                                                           const Tensor<type, 1>& y)
 {
     return filter_missing_values_vector_matrix(y,x);
-};
+}
 
 
 
@@ -452,6 +483,103 @@ pair<Tensor<type, 2>, Tensor<type, 2>> filter_missing_values_matrix_matrix(const
 }
 
 
+/// Marks the rows in which none of the columns of two variables has missing values.
+/// The valid rows tensor is only allocated when the first missing value is found.
+/// @param x_data Data of the first variable, in column-major order.
+/// @param x_columns_number Number of columns of the first variable.
+/// @param y_data Data of the second variable, in column-major order.
+/// @param y_columns_number Number of columns of the second variable.
+/// @param rows_number Number of rows of both variables.
+
+static MissingValuesMask missing_values_mask(const type* x_data,
+                                             const Index& x_columns_number,
+                                             const type* y_data,
+                                             const Index& y_columns_number,
+                                             const Index& rows_number)
+{
+    MissingValuesMask mask(rows_number);
+
+    Tensor<bool, 1>& valid_rows = mask.valid_rows;
+
+    const auto mask_column = [&](const type* column_data)
+    {
+        for(Index i = 0; i < rows_number; i++)
+        {
+            if(!isnan(column_data[i])) continue;
+
+            if(valid_rows.size() == 0)
+            {
+                valid_rows.resize(rows_number);
+                valid_rows.setConstant(true);
+            }
+
+            valid_rows(i) = false;
+        }
+    };
+
+    for(Index j = 0; j < x_columns_number; j++) mask_column(x_data + j*rows_number);
+
+    for(Index j = 0; j < y_columns_number; j++) mask_column(y_data + j*rows_number);
+
+    if(mask.has_missing_values())
+    {
+        const Tensor<Index, 0> valid_rows_number = valid_rows.cast<Index>().sum();
+
+        mask.valid_rows_number = valid_rows_number(0);
+    }
+
+    return mask;
+}
+
+
+/// Returns the mask of the rows in which two vectors have no missing values.
+/// @param x First vector.
+/// @param y Second vector.
+
+MissingValuesMask missing_values_mask(const Tensor<type, 1>& x, const Tensor<type, 1>& y)
+{
+    return missing_values_mask(x.data(), 1, y.data(), 1, x.size());
+}
+
+
+/// Returns the mask of the rows in which a vector and a matrix have no missing values.
+/// @param x Vector.
+/// @param y Matrix.
+
+MissingValuesMask missing_values_mask(const Tensor<type, 1>& x, const Tensor<type, 2>& y)
+{
+    return missing_values_mask(x.data(), 1, y.data(), y.dimension(1), x.size());
+}
+
+
+/// Returns the mask of the rows in which two matrices have no missing values.
+/// @param x First matrix.
+/// @param y Second matrix.
+
+MissingValuesMask missing_values_mask(const Tensor<type, 2>& x, const Tensor<type, 2>& y)
+{
+    return missing_values_mask(x.data(), x.dimension(1), y.data(), y.dimension(1), x.dimension(0));
+}
+
+
+/// Returns the mask of the rows in which two matrices have no missing values.
+/// If the known numbers of missing values of both matrices are zero, the data is not scanned at all.
+/// @param x First matrix.
+/// @param y Second matrix.
+/// @param x_missing_values_number Number of missing values in the first matrix.
+/// @param y_missing_values_number Number of missing values in the second matrix.
+
+MissingValuesMask missing_values_mask(const Tensor<type, 2>& x,
+                                      const Tensor<type, 2>& y,
+                                      const Index& x_missing_values_number,
+                                      const Index& y_missing_values_number)
+{
+    if(x_missing_values_number == 0 && y_missing_values_number == 0) return MissingValuesMask(x.dimension(0));
+
+    return missing_values_mask(x, y);
+}
+
+
 /// Get correlation values from a Correlation matrix.
 /// @param correlations Correlation matrix.
 
@@ -481,6 +609,21 @@ Tensor<type, 2> get_correlation_values(const Tensor<Correlation, 2>& correlation
 Correlation linear_correlation(const ThreadPoolDevice* thread_pool_device,
                                const Tensor<type, 1>& x,
                                const Tensor<type, 1>& y)
+{
+    return linear_correlation(thread_pool_device, x, y, missing_values_mask(x, y));
+}
+
+
+/// Calculate the coefficients of a goodness-of-fit (a, b) and the correlation among the variables.
+/// The sums are reduced in place over the rows without missing values.
+/// @param x Vector of the independent variable.
+/// @param y Vector of the dependent variable.
+/// @param mask Rows of x and y without missing values.
+
+Correlation linear_correlation(const ThreadPoolDevice* thread_pool_device,
+                               const Tensor<type, 1>& x,
+                               const Tensor<type, 1>& y,
+                               const MissingValuesMask& mask)
 {
 #ifdef OPENNN_DEBUG
 
@@ -542,14 +685,9 @@ Correlation linear_correlation(const ThreadPoolDevice* thread_pool_device,
         return linear_correlation;
     }
 
-    pair<Tensor<type, 1>, Tensor<type, 1>> filter_vectors = filter_missing_values_vector_vector(x,y);
-
-    const Tensor<double, 1> x_filter = filter_vectors.first.cast<double>();
-    const Tensor<double, 1> y_filter = filter_vectors.second.cast<double>();
+    const Index n = mask.valid_rows_number;
 
-    const Index n = x_filter.size();
-
-    if(x_filter.size() == 0)
+    if(n == 0)
     {
         cout << "Warning: Column X and Y hasn't common rows." << endl;
 
@@ -571,11 +709,25 @@ Correlation linear_correlation(const ThreadPoolDevice* thread_pool_device,
 
     Tensor<double, 0> s_xy;
 
-    s_x.device(*thread_pool_device) = x_filter.sum();
-    s_y.device(*thread_pool_device) = y_filter.sum();
-    s_xx.device(*thread_pool_device) = x_filter.square().sum();
-    s_yy.device(*thread_pool_device) = y_filter.square().sum();
-    s_xy.device(*thread_pool_device) = (y_filter*x_filter).sum();
+    if(mask.has_missing_values())
+    {
+        const auto x_valid = mask.valid_rows.select(x.cast<double>(), x.cast<double>().constant(0.0));
+        const auto y_valid = mask.valid_rows.select(y.cast<double>(), y.cast<double>().constant(0.0));
+
+        s_x.device(*thread_pool_device) = x_valid.sum();
+        s_y.device(*thread_pool_device) = y_valid.sum();
+        s_xx.device(*thread_pool_device) = x_valid.square().sum();
+        s_yy.device(*thread_pool_device) = y_valid.square().sum();
+        s_xy.device(*thread_pool_device) = (y_valid*x_valid).sum();
+    }
+    else
+    {
+        s_x.device(*thread_pool_device) = x.cast<double>().sum();
+        s_y.device(*thread_pool_device) = y.cast<double>().sum();
+        s_xx.device(*thread_pool_device) = x.cast<double>().square().sum();
+        s_yy.device(*thread_pool_device) = y.cast<double>().square().sum();
+        s_xy.device(*thread_pool_device) = (y.cast<double>()*x.cast<double>()).sum();
+    }
 
     if(abs(s_x()) < NUMERIC_LIMITS_MIN
     && abs(s_y()) < NUMERIC_LIMITS_MIN
@@ -696,15 +848,32 @@ Tensor<type,1> calculate_spearman_ranks(const Tensor<type,1> & x)
 
 Correlation linear_correlation_spearman(const ThreadPoolDevice* thread_pool_device, const Tensor<type, 1>& x, const Tensor<type, 1>& y)
 {
-    const pair<Tensor<type, 1>, Tensor<type, 1>> filter_vectors = filter_missing_values_vector_vector(x,y);
+    return linear_correlation_spearman(thread_pool_device, x, y, missing_values_mask(x, y));
+}
 
-    const Tensor<type, 1> x_filter = filter_vectors.first.cast<type>();
-    const Tensor<type, 1> y_filter = filter_vectors.second.cast<type>();
+
+/// Calculates the Spearman correlation over the rows without missing values.
+/// The ranks are only computed on filtered copies of the variables when the mask is not empty.
+/// @param x Vector of the independent variable.
+/// @param y Vector of the dependent variable.
+/// @param mask Rows of x and y without missing values.
+
+Correlation linear_correlation_spearman(const ThreadPoolDevice* thread_pool_device,
+                                        const Tensor<type, 1>& x,
+                                        const Tensor<type, 1>& y,
+                                        const MissingValuesMask& mask)
+{
+    pair<Tensor<type, 1>, Tensor<type, 1>> filter_vectors;
+
+    if(mask.has_missing_values()) filter_vectors = filter_missing_values_vector_vector(x,y);
+
+    const Tensor<type, 1>& x_filter = mask.has_missing_values() ? filter_vectors.first : x;
+    const Tensor<type, 1>& y_filter = mask.has_missing_values() ? filter_vectors.second : y;
 
     const Tensor<type, 1> x_rank = calculate_spearman_ranks(x_filter);
     const Tensor<type, 1> y_rank = calculate_spearman_ranks(y_filter);
 
-    return linear_correlation(thread_pool_device, x_rank, y_rank);
+    return linear_correlation(thread_pool_device, x_rank, y_rank, MissingValuesMask(x_rank.size()));
 }
 
 
@@ -715,6 +884,20 @@ Correlation linear_correlation_spearman(const ThreadPoolDevice* thread_pool_devi
 Correlation logarithmic_correlation(const ThreadPoolDevice* thread_pool_device,
                                     const Tensor<type, 1>& x,
                                     const Tensor<type, 1>& y)
+{
+    return logarithmic_correlation(thread_pool_device, x, y, missing_values_mask(x, y));
+}
+
+
+/// Calculate the coefficients of a logarithmic regression (a, b) over the rows without missing values.
+/// @param x Vector of the independent variable.
+/// @param y Vector of the dependent variable.
+/// @param mask Rows of x and y without missing values.
+
+Correlation logarithmic_correlation(const ThreadPoolDevice* thread_pool_device,
+                                    const Tensor<type, 1>& x,
+                                    const Tensor<type, 1>& y,
+                                    const MissingValuesMask& mask)
 {
 #ifdef OPENNN_DEBUG
 
@@ -751,7 +934,7 @@ Correlation logarithmic_correlation(const ThreadPoolDevice* thread_pool_device,
         }
     }
 
-    logarithmic_correlation = linear_correlation(thread_pool_device, x.log(), y);
+    logarithmic_correlation = linear_correlation(thread_pool_device, x.log(), y, mask);
 
     logarithmic_correlation.correlation_type = CorrelationType::Logarithmic;
 
@@ -769,10 +952,14 @@ Correlation logistic_correlation_vector_vector(const ThreadPoolDevice* thread_po
 {
     Correlation correlation;
 
-    pair<Tensor<type,1>, Tensor<type,1>> filtered_elements = filter_missing_values_vector_vector(x,y);
+    const MissingValuesMask mask = missing_values_mask(x, y);
 
-    Tensor<type,1> x_filtered = filtered_elements.first;
-    Tensor<type,1> y_filtered = filtered_elements.second;
+    pair<Tensor<type,1>, Tensor<type,1>> filtered_elements;
+
+    if(mask.has_missing_values()) filtered_elements = filter_missing_values_vector_vector(x,y);
+
+    const Tensor<type,1>& x_filtered = mask.has_missing_values() ? filtered_elements.first : x;
+    const Tensor<type,1>& y_filtered = mask.has_missing_values() ? filtered_elements.second : y;
 
     if(x_filtered.size() == 0)
     {
@@ -858,10 +1045,14 @@ Correlation logistic_correlation_vector_vector_spearman(const ThreadPoolDevice*
 {
     Correlation correlation;
 
-    pair<Tensor<type,1>, Tensor<type,1>> filtered_elements = filter_missing_values_vector_vector(x,y);
+    const MissingValuesMask mask = missing_values_mask(x, y);
+
+    pair<Tensor<type,1>, Tensor<type,1>> filtered_elements;
 
-    Tensor<type,1> x_filtered = filtered_elements.first;
-    Tensor<type,1> y_filtered = filtered_elements.second;
+    if(mask.has_missing_values()) filtered_elements = filter_missing_values_vector_vector(x,y);
+
+    const Tensor<type,1>& x_filtered = mask.has_missing_values() ? filtered_elements.first : x;
+    const Tensor<type,1>& y_filtered = mask.has_missing_values() ? filtered_elements.second : y;
 
     if(x_filtered.size() == 0)
     {
@@ -948,10 +1139,14 @@ Correlation  logistic_correlation_vector_matrix(const ThreadPoolDevice* thread_p
 {
     Correlation correlation;
 
-    pair<Tensor<type,1>, Tensor<type,2>> filtered_elements = opennn::filter_missing_values_vector_matrix(x, y);
+    const MissingValuesMask mask = missing_values_mask(x, y);
+
+    pair<Tensor<type,1>, Tensor<type,2>> filtered_elements;
 
-    Tensor<type,1> x_filtered = filtered_elements.first;
-    Tensor<type,2> y_filtered = filtered_elements.second;
+    if(mask.has_missing_values()) filtered_elements = opennn::filter_missing_values_vector_matrix(x, y);
+
+    const Tensor<type,1>& x_filtered = mask.has_missing_values() ? filtered_elements.first : x;
+    const Tensor<type,2>& y_filtered = mask.has_missing_values() ? filtered_elements.second : y;
 
     if(y_filtered.dimension(1) > 50)
     {
@@ -1055,10 +1250,14 @@ Correlation logistic_correlation_matrix_matrix(const ThreadPoolDevice* thread_po
 
     // Scrub missing values
 
-    pair<Tensor<type,2>, Tensor<type,2>> filtered_matrixes = filter_missing_values_matrix_matrix(x,y);
+    const MissingValuesMask mask = missing_values_mask(x, y);
+
+    pair<Tensor<type,2>, Tensor<type,2>> filtered_matrixes;
 
-    Tensor<type,2> x_filtered = filtered_matrixes.first;
-    Tensor<type,2> y_filtered = filtered_matrixes.second;
+    if(mask.has_missing_values()) filtered_matrixes = filter_missing_values_matrix_matrix(x,y);
+
+    const Tensor<type,2>& x_filtered = mask.has_missing_values() ? filtered_matrixes.first : x;
+    const Tensor<type,2>& y_filtered = mask.has_missing_values() ? filtered_matrixes.second : y;
 
     if(x.dimension(0)  == y.dimension(0) && x.dimension(1)  == y.dimension(1))
     {
@@ -1183,6 +1382,20 @@ Correlation logistic_correlation_matrix_matrix(const ThreadPoolDevice* thread_po
 Correlation power_correlation(const ThreadPoolDevice* thread_pool_device,
                               const Tensor<type, 1>& x,
                               const Tensor<type, 1>& y)
+{
+    return power_correlation(thread_pool_device, x, y, missing_values_mask(x, y));
+}
+
+
+/// Calculate the coefficients of a power regression (a, b) over the rows without missing values.
+/// @param x Vector of the independent variable.
+/// @param y Vector of the dependent variable.
+/// @param mask Rows of x and y without missing values.
+
+Correlation power_correlation(const ThreadPoolDevice* thread_pool_device,
+                              const Tensor<type, 1>& x,
+                              const Tensor<type, 1>& y,
+                              const MissingValuesMask& mask)
 {
 #ifdef OPENNN_DEBUG
 
@@ -1222,7 +1435,7 @@ Correlation power_correlation(const ThreadPoolDevice* thread_pool_device,
         }
     }
 
-    power_correlation = linear_correlation(thread_pool_device, x.log(), y.log());
+    power_correlation = linear_correlation(thread_pool_device, x.log(), y.log(), mask);
 
     power_correlation.correlation_type = CorrelationType::Power;
 
@@ -92,15 +92,49 @@ struct Correlation
 };
 
 
+/// This structure marks the rows in which two variables have no missing values.
+/// The correlation methods reduce over the valid rows in place, so that the variables need not be filtered into copies.
+/// If there are no missing values the mask is left empty and every row is valid.
+
+struct MissingValuesMask
+{
+    explicit MissingValuesMask() {}
+
+    explicit MissingValuesMask(const Index& new_rows_number) : valid_rows_number(new_rows_number) {}
+
+    bool has_missing_values() const
+    {
+        return valid_rows.size() != 0;
+    }
+
+    bool is_valid(const Index& row_index) const
+    {
+        return valid_rows.size() == 0 || valid_rows(row_index);
+    }
+
+    /// Number of rows without missing values in any of the variables.
+
+    Index valid_rows_number = 0;
+
+    /// Rows without missing values. It is empty when there are no missing values.
+
+    Tensor<bool, 1> valid_rows;
+};
+
+
     // Pearson correlation methods
 
     Correlation linear_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
+    Correlation linear_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&, const MissingValuesMask&);
 
     Correlation logarithmic_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
+    Correlation logarithmic_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&, const MissingValuesMask&);
 
     Correlation exponential_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
+    Correlation exponential_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&, const MissingValuesMask&);
 
     Correlation power_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
+    Correlation power_correlation(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&, const MissingValuesMask&);
 
     Correlation logistic_correlation_vector_vector(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
 
@@ -111,10 +145,12 @@ struct Correlation
     Correlation logistic_correlation_matrix_matrix(const ThreadPoolDevice*, const Tensor<type, 2>&, const Tensor<type, 2>&);
 
     Correlation correlation(const ThreadPoolDevice*, const Tensor<type, 2>&, const Tensor<type, 2>&);
+    Correlation correlation(const ThreadPoolDevice*, const Tensor<type, 2>&, const Tensor<type, 2>&, const MissingValuesMask&);
 
     // Spearman correlation methods
 
     Correlation linear_correlation_spearman(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
+    Correlation linear_correlation_spearman(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&, const MissingValuesMask&);
     Tensor<type, 1> calculate_spearman_ranks(const Tensor<type, 1>&);
 
     Correlation logistic_correlation_vector_vector_spearman(const ThreadPoolDevice*, const Tensor<type, 1>&, const Tensor<type, 1>&);
@@ -155,6 +191,11 @@ struct Correlation
 
     // Missing values methods
 
+    MissingValuesMask missing_values_mask(const Tensor<type, 1>&, const Tensor<type, 1>&);
+    MissingValuesMask missing_values_mask(const Tensor<type, 1>&, const Tensor<type, 2>&);
+    MissingValuesMask missing_values_mask(const Tensor<type, 2>&, const Tensor<type, 2>&);
+    MissingValuesMask missing_values_mask(const Tensor<type, 2>&, const Tensor<type, 2>&, const Index&, const Index&);
+
     pair<Tensor<type, 1>, Tensor<type, 1>> filter_missing_values_vector_vector(const Tensor<type, 1>&, const Tensor<type, 1>&);
     pair<Tensor<type, 1>, Tensor<type, 2>> filter_missing_values_vector_matrix(const Tensor<type, 1>&, const Tensor<type, 2>&);
     pair<Tensor<type, 1>, Tensor<type, 2>> filter_missing_values_matrix_vector(const Tensor<type, 2>&, const Tensor<type, 1>&);
@@ -7764,6 +7764,8 @@ Tensor<Correlation, 2> DataSet::calculate_input_target_columns_correlations() co
 
     const Tensor<Index, 1> used_samples_indices = get_used_samples_indices();
 
+    const Tensor<Index, 1> nan_columns = count_nan_columns();
+
     Tensor<Correlation, 2> correlations(input_columns_number, target_columns_number);
 
 #pragma omp parallel for
@@ -7780,7 +7782,12 @@ Tensor<Correlation, 2> DataSet::calculate_input_target_columns_correlations() co
 
             const Tensor<type, 2> target_column_data = get_column_data(target_index, used_samples_indices);
 
-            correlations(i,j) = opennn::correlation(correlations_thread_pool_device, input_column_data, target_column_data);
+            const MissingValuesMask mask = missing_values_mask(input_column_data,
+                                                               target_column_data,
+                                                               nan_columns(input_index),
+                                                               nan_columns(target_index));
+
+            correlations(i,j) = opennn::correlation(correlations_thread_pool_device, input_column_data, target_column_data, mask);
         }
     }
 
@@ -7801,6 +7808,10 @@ Tensor<Correlation, 2> DataSet::calculate_relevant_input_target_columns_correlat
     const Index input_columns_number = input_columns_indices.dimension(0);
     const Index target_columns_number = target_columns_indices.dimension(0);
 
+    const Tensor<Index, 1> used_samples_indices = get_used_samples_indices();
+
+    const Tensor<Index, 1> nan_columns = count_nan_columns();
+
     Tensor<Correlation, 2> correlations(input_columns_number, target_columns_number);
 /**
 #pragma omp parallel for
@@ -7826,15 +7837,20 @@ Tensor<Correlation, 2> DataSet::calculate_relevant_input_target_columns_correlat
     {
         const Index input_index = input_columns_indices(i);
 
-        const Tensor<type, 2> input_column_data = get_column_data(input_index, get_used_samples_indices());
+        const Tensor<type, 2> input_column_data = get_column_data(input_index, used_samples_indices);
 
         for(Index j = 0; j < target_columns_number; j++)
         {
             const Index target_index = target_columns_indices(j);
 
-            const Tensor<type, 2> target_column_data = get_column_data(target_index, get_used_samples_indices());
+            const Tensor<type, 2> target_column_data = get_column_data(target_index, used_samples_indices);
+
+            const MissingValuesMask mask = missing_values_mask(input_column_data,
+                                                               target_column_data,
+                                                               nan_columns(input_index),
+                                                               nan_columns(target_index));
 
-            correlations(i,j) = opennn::correlation(correlations_thread_pool_device, input_column_data, target_column_data);
+            correlations(i,j) = opennn::correlation(correlations_thread_pool_device, input_column_data, target_column_data, mask);
         }
     }
 
@@ -8009,6 +8025,8 @@ Tensor<Tensor<Correlation, 2>, 1> DataSet::calculate_input_columns_correlations(
     // list to return
     Tensor<Tensor<Correlation, 2>, 1> correlations_list(2);
 
+    const Tensor<Index, 1> nan_columns = count_nan_columns();
+
     for(Index i = 0; i < input_columns_number; i++)
     {
         const Index current_input_index_i = input_columns_indices(i);
@@ -8053,7 +8071,12 @@ Tensor<Tensor<Correlation, 2>, 1> DataSet::calculate_input_columns_correlations(
 
                 if(calculate_pearson_correlations)
                 {
-                    correlations(i,j) = opennn::correlation(thread_pool_device, input_i, input_j);
+                    const MissingValuesMask mask = missing_values_mask(input_i,
+                                                                       input_j,
+                                                                       nan_columns(current_input_index_i),
+                                                                       nan_columns(current_input_index_j));
+
+                    correlations(i,j) = opennn::correlation(thread_pool_device, input_i, input_j, mask);
                     if(correlations(i,j).r > (type(1) - NUMERIC_LIMITS_MIN))
                         correlations(i,j).r = type(1);
                 }
@@ -48,6 +48,19 @@ public:
         set_dimensions(new_dimensions_tensor);
     }
 
+    /// View constructor.
+    /// The dynamic tensor does not own the data, which must outlive it.
+
+    DynamicTensor(T* new_data, const Tensor<Index, 1>& new_dimensions)
+    {
+        set_view(new_data, new_dimensions);
+    }
+
+    DynamicTensor(const DynamicTensor& other)
+    {
+        *this = other;
+    }
+
 
     DynamicTensor& operator = (const DynamicTensor& other)
     {
@@ -79,16 +92,18 @@ public:
                 dimensions = other.dimensions;
             }
 
-            if(data != nullptr)
+            if(owns_data)
             {
                 free(data);
             }
 
-            const Tensor<Index, 0> size = dimensions.prod();
+            const Index size = get_size();
 
-            data = (T*) malloc(static_cast<size_t>(size(0)*sizeof(T)));
+            data = (T*) malloc(static_cast<size_t>(size*sizeof(T)));
 
-            memcpy(data, other.data, static_cast<size_t>(size(0)*sizeof(T)) );
+            owns_data = true;
+
+            memcpy(data, other.data, static_cast<size_t>(size*sizeof(T)) );
         }
 
         return *this;
@@ -157,7 +172,7 @@ public:
 */
     virtual ~DynamicTensor()
     {
-        free(data);
+        if(owns_data) free(data);
     }
 
     T* get_data() const
@@ -165,6 +180,23 @@ public:
         return data;
     }
 
+    bool get_owns_data() const
+    {
+        return owns_data;
+    }
+
+    Index get_size() const
+    {
+        Index size = 1;
+
+        for(Index i = 0; i < dimensions.size(); i++)
+        {
+            size *= dimensions(i);
+        }
+
+        return dimensions.size() == 0 ? 0 : size;
+    }
+
     const Tensor<Index, 1>& get_dimensions() const
     {
         return dimensions;
@@ -178,23 +210,48 @@ public:
 
     void set_data(const T* new_data)
     {
-        free(data);
+        if(owns_data) free(data);
 
         data = (T*) new_data;
+
+        owns_data = true;
     }
 
 
     void set_dimensions(const Tensor<Index, 1> new_dimensions)
     {
-        free(data);
+        if(owns_data) free(data);
 
         dimensions = new_dimensions;
 
-        const Tensor<Index, 0> size = dimensions.prod();
+        data = (T*) malloc(static_cast<size_t>(get_size()*sizeof(T)));
+
+        owns_data = true;
+    }
+
+
+    /// Makes this dynamic tensor a view of external data, which is neither copied nor freed.
+
+    void set_view(T* new_data, const Tensor<Index, 1>& new_dimensions)
+    {
+        if(owns_data) free(data);
+
+        data = new_data;
 
-        data = (T*) malloc(static_cast<size_t>(size(0)*sizeof(T)));
+        dimensions = new_dimensions;
+
+        owns_data = false;
     }
 
+    /// Changes the dimensions without moving or reallocating the data,
+    /// so the new size must not be greater than the allocated one.
+
+    void reshape(const Tensor<Index, 1>& new_dimensions)
+    {
+        dimensions = new_dimensions;
+    }
+
+
     template <int rank>
     TensorMap<Tensor<T, rank>> to_tensor_map() const
     {
@@ -213,6 +270,8 @@ private:
 
     T* data = nullptr;
 
+    bool owns_data = true;
+
     Tensor<Index, 1> dimensions;
 };
 };
@@ -7,6 +7,7 @@
 //   artelnics@artelnics.com
 
 #include "embedding_layer.h"
+#include "multihead_attention_layer.h"
 
 namespace opennn
 {
@@ -32,10 +33,9 @@ EmbeddingLayer::EmbeddingLayer() : Layer()
 EmbeddingLayer::EmbeddingLayer(const Index& new_input_dim,
                                const Index& new_input_length,
                                const Index& new_depth,
-                               const bool& new_positional_encoding,
-                               const PerceptronLayer::ActivationFunction& new_activation_function) : Layer()
+                               const PositionalEncoding& new_positional_encoding) : Layer()
 {
-    set(new_input_dim, new_input_length, new_depth, new_positional_encoding, new_activation_function);
+    set(new_input_dim, new_input_length, new_depth, new_positional_encoding);
 
     layer_type = Type::Embedding;
 
@@ -43,6 +43,14 @@ EmbeddingLayer::EmbeddingLayer(const Index& new_input_dim,
 }
 
 
+/// Returns true if the lookup table of the layer is empty.
+
+bool EmbeddingLayer::is_empty() const
+{
+    return lookup_table.size() == 0;
+}
+
+
 /// Returns the dimension (maximum value + 1) of the input to the layer.
 
 Index EmbeddingLayer::get_input_dim() const
@@ -67,73 +75,118 @@ Index EmbeddingLayer::get_depth() const
 }
 
 
-/// Each returns the layer's Perceptron sub-layer.
+/// Returns the dimensions of each input sample, which is a sequence of input_length values.
 
-PerceptronLayer EmbeddingLayer::get_perceptron_layer() const
+Tensor<Index, 1> EmbeddingLayer::get_inputs_dimensions() const
 {
-    return perceptron_layer;
+    Tensor<Index, 1> inputs_dimensions(1);
+
+    inputs_dimensions.setValues({input_length});
+
+    return inputs_dimensions;
 }
 
 
-/// Returns the number of parameters of the layer.
+/// Returns the dimensions of each output sample, which is a sequence of input_length embeddings.
 
-Index EmbeddingLayer::get_parameters_number() const
+Tensor<Index, 1> EmbeddingLayer::get_outputs_dimensions() const
+{
+    Tensor<Index, 1> outputs_dimensions(2);
+
+    outputs_dimensions.setValues({input_length, depth});
+
+    return outputs_dimensions;
+}
+
+
+/// Returns the lookup table of the layer, with dimensions depth and input dim.
+/// The embedding of the input value i is the column i of the table.
+
+const Tensor<type, 2>& EmbeddingLayer::get_lookup_table() const
 {
-    return perceptron_layer.get_parameters_number();
+    return lookup_table;
 }
 
 
-/// Returns the activation function of the layer.
-/// The activation function of a layer is the activation function of all perceptrons in it.
+/// Returns the positional encoding added to the embeddings.
 
-const PerceptronLayer::ActivationFunction& EmbeddingLayer::get_activation_function() const
+const EmbeddingLayer::PositionalEncoding& EmbeddingLayer::get_positional_encoding() const
 {
-    return activation_function;
+    return positional_encoding;
 }
 
 
-/// Returns a string with the name of the layer activation function.
-/// This can be Logistic, HyperbolicTangent, Threshold, SymmetricThreshold, Linear, RectifiedLinear, ScaledExponentialLinear.
+/// Returns a string with the name of the positional encoding of the layer.
 
-string EmbeddingLayer::write_activation_function() const
+string EmbeddingLayer::write_positional_encoding() const
 {
-    switch(activation_function)
+    switch(positional_encoding)
     {
-    case PerceptronLayer::ActivationFunction::Logistic:
-        return "Logistic";
+    case PositionalEncoding::NoPositionalEncoding:
+        return "NoPositionalEncoding";
 
-    case PerceptronLayer::ActivationFunction::HyperbolicTangent:
-        return "HyperbolicTangent";
+    case PositionalEncoding::Sinusoidal:
+        return "Sinusoidal";
 
-    case PerceptronLayer::ActivationFunction::Threshold:
-        return "Threshold";
+    case PositionalEncoding::Learned:
+        return "Learned";
+    }
 
-    case PerceptronLayer::ActivationFunction::SymmetricThreshold:
-        return "SymmetricThreshold";
+    return string();
+}
 
-    case PerceptronLayer::ActivationFunction::Linear:
-        return "Linear";
 
-    case PerceptronLayer::ActivationFunction::RectifiedLinear:
-        return "RectifiedLinear";
+/// Returns the positional encodings of all the positions, with dimensions input length and depth.
+/// The matrix is empty if the layer does not add positional encoding.
 
-    case PerceptronLayer::ActivationFunction::ScaledExponentialLinear:
-        return "ScaledExponentialLinear";
+const Tensor<type, 2>& EmbeddingLayer::get_positional_encoding_matrix() const
+{
+    return positional_encoding_matrix;
+}
 
-    case PerceptronLayer::ActivationFunction::SoftPlus:
-        return "SoftPlus";
 
-    case PerceptronLayer::ActivationFunction::SoftSign:
-        return "SoftSign";
+/// Returns the number of parameters of the layer,
+/// which are the entries of the lookup table and those of the positional encoding matrix if it is learned.
 
-    case PerceptronLayer::ActivationFunction::HardSigmoid:
-        return "HardSigmoid";
+Index EmbeddingLayer::get_parameters_number() const
+{
+    if(positional_encoding == PositionalEncoding::Learned)
+        return lookup_table.size() + positional_encoding_matrix.size();
 
-    case PerceptronLayer::ActivationFunction::ExponentialLinear:
-        return "ExponentialLinear";
-    }
+    return lookup_table.size();
+}
 
-    return string();
+
+/// Returns the parameters of the layer, which are the embeddings of all the input values, one after the other,
+/// followed by the positional encodings if they are learned.
+
+Tensor<type, 1> EmbeddingLayer::get_parameters() const
+{
+    Tensor<type, 1> parameters(get_parameters_number());
+
+    copy(lookup_table.data(), lookup_table.data() + lookup_table.size(), parameters.data());
+
+    if(positional_encoding == PositionalEncoding::Learned)
+        copy(positional_encoding_matrix.data(),
+             positional_encoding_matrix.data() + positional_encoding_matrix.size(),
+             parameters.data() + lookup_table.size());
+
+    return parameters;
+}
+
+
+Tensor< TensorMap< Tensor<type, 1> >*, 1> EmbeddingLayer::get_layer_parameters()
+{
+    const bool is_learned = positional_encoding == PositionalEncoding::Learned;
+
+    Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_parameters(is_learned ? 2 : 1);
+
+    layer_parameters(0) = new TensorMap<Tensor<type, 1>>(lookup_table.data(), lookup_table.size());
+
+    if(is_learned)
+        layer_parameters(1) = new TensorMap<Tensor<type, 1>>(positional_encoding_matrix.data(), positional_encoding_matrix.size());
+
+    return layer_parameters;
 }
 
 
@@ -157,22 +210,23 @@ void EmbeddingLayer::set()
 
     depth = 0;
 
-    positional_encoding = false;
+    positional_encoding = PositionalEncoding::NoPositionalEncoding;
 
-    perceptron_layer.set();
+    lookup_table.resize(0, 0);
+
+    positional_encoding_matrix.resize(0, 0);
 
     set_default();
 }
 
 
-/// Sets new input dimension, input length, embedding depth and activation function of the layer.
+/// Sets new input dimension, input length and embedding depth of the layer.
 /// It also sets the rest of the members to their default values.
 
 void EmbeddingLayer::set(const Index& new_input_dim,
                          const Index& new_input_length,
                          const Index& new_depth,
-                         const bool& new_positional_encoding,
-                         const PerceptronLayer::ActivationFunction& new_activation_function)
+                         const PositionalEncoding& new_positional_encoding)
 {
     input_dim = new_input_dim;
 
@@ -180,17 +234,17 @@ void EmbeddingLayer::set(const Index& new_input_dim,
 
     depth = new_depth;
 
-    set_perceptron();
-
     positional_encoding = new_positional_encoding;
 
-    activation_function = new_activation_function;
+    set_lookup_table();
+
+    set_positional_encoding_matrix();
 
     set_default();
 }
 
 
-/// Sets those members not related to the perceptrons to their default value.
+/// Sets those members not related to the lookup table to their default value.
 
 void EmbeddingLayer::set_default()
 {
@@ -214,7 +268,7 @@ void EmbeddingLayer::set_input_dim(const Index& new_input_dim)
 {
     input_dim = new_input_dim;
 
-    set_perceptron();
+    set_lookup_table();
 }
 
 
@@ -223,6 +277,8 @@ void EmbeddingLayer::set_input_dim(const Index& new_input_dim)
 void EmbeddingLayer::set_input_length(const Index& new_input_length)
 {
     input_length = new_input_length;
+
+    set_positional_encoding_matrix();
 }
 
 
@@ -232,85 +288,180 @@ void EmbeddingLayer::set_depth(const Index& new_depth)
 {
     depth = new_depth;
 
-    set_perceptron();
+    set_lookup_table();
+
+    set_positional_encoding_matrix();
 }
 
 
-/// Sets the perceptron sub-layer according to the layer's parameters.
+/// Sets the lookup table according to the layer's dimensions, and initializes it at random.
 
-void EmbeddingLayer::set_perceptron()
+void EmbeddingLayer::set_lookup_table()
 {
-    perceptron_layer.set(input_dim, depth, activation_function);
-}
+    lookup_table.resize(depth, input_dim);
 
-/// This class sets a new activation(or transfer) function in the layer.
+    const type minimum = type(-0.2);
+    const type maximum = type(0.2);
 
-void EmbeddingLayer::set_activation_function(const PerceptronLayer::ActivationFunction& new_activation_function)
-{
-    activation_function = new_activation_function;
+    for(Index i = 0; i < lookup_table.size(); i++)
+    {
+        const type random = static_cast<type>(rand()/(RAND_MAX+1.0));
+
+        lookup_table(i) = minimum + (maximum - minimum)*random;
+    }
 }
 
 
-/// Sets a new activation(or transfer) function in a single layer.
-/// The second argument is a string containing the name of the function("Logistic", "HyperbolicTangent", "Threshold", etc).
-/// @param new_activation_function Activation function for that layer.
+/// Sets a new lookup table, whose dimensions must be depth and input dim.
+/// @param new_lookup_table Embeddings of the input values, one per column.
 
-void EmbeddingLayer::set_activation_function(const string& new_activation_function_name)
+void EmbeddingLayer::set_lookup_table(const Tensor<type, 2>& new_lookup_table)
 {
-    if(new_activation_function_name == "Logistic")
-    {
-        activation_function = PerceptronLayer::ActivationFunction::Logistic;
-    }
-    else if(new_activation_function_name == "HyperbolicTangent")
+    if(new_lookup_table.dimension(0) != depth || new_lookup_table.dimension(1) != input_dim)
     {
-        activation_function = PerceptronLayer::ActivationFunction::HyperbolicTangent;
-    }
-    else if(new_activation_function_name == "Threshold")
-    {
-        activation_function = PerceptronLayer::ActivationFunction::Threshold;
-    }
-    else if(new_activation_function_name == "SymmetricThreshold")
-    {
-        activation_function = PerceptronLayer::ActivationFunction::SymmetricThreshold;
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: EmbeddingLayer class.\n"
+               << "void set_lookup_table(const Tensor<type, 2>&) method.\n"
+               << "Lookup table dimensions must be (" << depth << ", " << input_dim << ").\n";
+
+        throw invalid_argument(buffer.str());
     }
-    else if(new_activation_function_name == "Linear")
+
+    lookup_table = new_lookup_table;
+}
+
+
+/// Sets a new positional encoding, and builds or initializes the positional encoding matrix accordingly.
+/// @param new_positional_encoding No positional encoding, sinusoidal or learned.
+
+void EmbeddingLayer::set_positional_encoding(const PositionalEncoding& new_positional_encoding)
+{
+    positional_encoding = new_positional_encoding;
+
+    set_positional_encoding_matrix();
+}
+
+
+/// Sets a new positional encoding from its name ("NoPositionalEncoding", "Sinusoidal" or "Learned").
+/// @param new_positional_encoding_name Name of the positional encoding.
+
+void EmbeddingLayer::set_positional_encoding(const string& new_positional_encoding_name)
+{
+    if(new_positional_encoding_name == "NoPositionalEncoding")
     {
-        activation_function = PerceptronLayer::ActivationFunction::Linear;
+        set_positional_encoding(PositionalEncoding::NoPositionalEncoding);
     }
-    else if(new_activation_function_name == "RectifiedLinear")
+    else if(new_positional_encoding_name == "Sinusoidal")
     {
-        activation_function = PerceptronLayer::ActivationFunction::RectifiedLinear;
+        set_positional_encoding(PositionalEncoding::Sinusoidal);
     }
-    else if(new_activation_function_name == "ScaledExponentialLinear")
+    else if(new_positional_encoding_name == "Learned")
     {
-        activation_function = PerceptronLayer::ActivationFunction::ScaledExponentialLinear;
+        set_positional_encoding(PositionalEncoding::Learned);
     }
-    else if(new_activation_function_name == "SoftPlus")
+    else
     {
-        activation_function = PerceptronLayer::ActivationFunction::SoftPlus;
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: EmbeddingLayer class.\n"
+               << "void set_positional_encoding(const string&) method.\n"
+               << "Unknown positional encoding: " << new_positional_encoding_name << ".\n";
+
+        throw invalid_argument(buffer.str());
     }
-    else if(new_activation_function_name == "SoftSign")
+}
+
+
+/// Sets the positional encoding matrix according to the layer's dimensions and positional encoding.
+/// Sinusoidal encodings are calculated here once, so that the forward propagation only adds them,
+/// and learned encodings are initialized at random.
+
+void EmbeddingLayer::set_positional_encoding_matrix()
+{
+    switch(positional_encoding)
     {
-        activation_function = PerceptronLayer::ActivationFunction::SoftSign;
-    }
-    else if(new_activation_function_name == "HardSigmoid")
+    case PositionalEncoding::NoPositionalEncoding:
+        positional_encoding_matrix.resize(0, 0);
+        break;
+
+    case PositionalEncoding::Sinusoidal:
+        positional_encoding_matrix = build_positional_encoding_matrix();
+        break;
+
+    case PositionalEncoding::Learned:
     {
-        activation_function = PerceptronLayer::ActivationFunction::HardSigmoid;
+        positional_encoding_matrix.resize(input_length, depth);
+
+        const type minimum = type(-0.2);
+        const type maximum = type(0.2);
+
+        for(Index i = 0; i < positional_encoding_matrix.size(); i++)
+        {
+            const type random = static_cast<type>(rand()/(RAND_MAX+1.0));
+
+            positional_encoding_matrix(i) = minimum + (maximum - minimum)*random;
+        }
     }
-    else if(new_activation_function_name == "ExponentialLinear")
-    {
-        activation_function = PerceptronLayer::ActivationFunction::ExponentialLinear;
+        break;
     }
-    else
+}
+
+
+/// Sets new positional encodings, whose dimensions must be input length and depth.
+/// @param new_positional_encoding_matrix Positional encodings of all the positions, one per row.
+
+void EmbeddingLayer::set_positional_encoding_matrix(const Tensor<type, 2>& new_positional_encoding_matrix)
+{
+    if(positional_encoding == PositionalEncoding::NoPositionalEncoding
+    || new_positional_encoding_matrix.dimension(0) != input_length
+    || new_positional_encoding_matrix.dimension(1) != depth)
     {
         ostringstream buffer;
 
-        buffer << "OpenNN Exception: PerceptronLayer class.\n"
-               << "void set_activation_function(const string&) method.\n"
-               << "Unknown activation function: " << new_activation_function_name << ".\n";
+        buffer << "OpenNN Exception: EmbeddingLayer class.\n"
+               << "void set_positional_encoding_matrix(const Tensor<type, 2>&) method.\n"
+               << "Positional encoding matrix dimensions must be (" << input_length << ", " << depth << ") "
+               << "and the layer must have positional encoding.\n";
 
         throw invalid_argument(buffer.str());
     }
+
+    positional_encoding_matrix = new_positional_encoding_matrix;
+}
+
+
+/// Sets the lookup table from a vector of parameters.
+/// @param new_parameters Parameters vector.
+/// @param index Position of the parameters of this layer in the vector.
+
+void EmbeddingLayer::set_parameters(const Tensor<type, 1>& new_parameters, const Index& index)
+{
+    copy(new_parameters.data() + index, new_parameters.data() + index + lookup_table.size(), lookup_table.data());
+
+    if(positional_encoding != PositionalEncoding::Learned) return;
+
+    const Index positional_encoding_index = index + lookup_table.size();
+
+    copy(new_parameters.data() + positional_encoding_index,
+         new_parameters.data() + positional_encoding_index + positional_encoding_matrix.size(),
+         positional_encoding_matrix.data());
+}
+
+
+void EmbeddingLayer::set_parameters_constant(const type& value)
+{
+    lookup_table.setConstant(value);
+
+    if(positional_encoding == PositionalEncoding::Learned) positional_encoding_matrix.setConstant(value);
+}
+
+
+void EmbeddingLayer::set_parameters_random()
+{
+    set_lookup_table();
+
+    if(positional_encoding == PositionalEncoding::Learned) set_positional_encoding_matrix();
 }
 
 
@@ -325,238 +476,379 @@ void EmbeddingLayer::set_display(const bool& new_display)
 }
 
 
-/// Calculates one-hot encoding, of dimension = input_dim, of an input row (assuming all input values are integers)
-/// @return Matrix of one-hot encodings of all values in input_row
+/// Checks that all the input values are integers between 0 and input_dim - 1.
+/// @param inputs_data Input values.
+/// @param inputs_number Number of input values.
 
-Tensor<type, 2> EmbeddingLayer::one_hot_encode_row(const Tensor<type, 1>& input_row)
+void EmbeddingLayer::check_inputs(const type* inputs_data, const Index& inputs_number) const
 {
-    Tensor<type, 2> one_hot_encoded_input_row(input_length, input_dim);
-    one_hot_encoded_input_row.setZero();
-
-    const Tensor<type, 0> max_input = input_row.maximum();
-
-    if(max_input(0) >= type(input_dim))
+    for(Index i = 0; i < inputs_number; i++)
     {
-        ostringstream buffer;
-        buffer << "OpenNN Exception: EmbeddingLayer class.\n"
-               << "void EmbeddingLayer::one_hot_encode_row(const Tensor<Index, 1>&)\n"
-               << "All input values must be less than " << input_dim << " (" << max_input(0) << ").\n";
-        throw invalid_argument(buffer.str());
-    }
+        const type input = inputs_data[i];
 
-#pragma omp parallel for
-    for(Index i = 0; i < input_length; i++)
-        one_hot_encoded_input_row(i, Index(input_row(i))) = 1;
+        if(input < type(0) || input >= type(input_dim) || input != floor(input))
+        {
+            ostringstream buffer;
 
-    return one_hot_encoded_input_row;
+            buffer << "OpenNN Exception: EmbeddingLayer class.\n"
+                   << "void check_inputs(const type*, const Index&) const method.\n"
+                   << "All input values must be integers between 0 and " << input_dim - 1 << " (" << input << ").\n";
+
+            throw invalid_argument(buffer.str());
+        }
+    }
 }
 
 
-/// Looks up embedding of an input row, by passing its one-hot encoding through a perceptron layer (that corresponds to the lookup table)
-/// Saves the embedding matrix of the row in outputs_data of the given perceptron layer forward propagation structure
+/// Gathers the embeddings of a batch of inputs from the lookup table, and adds the positional encodings in the same pass.
+/// Each output row is a copy of a lookup table column, so that the cost does not depend on the input dimension.
+/// @param inputs Input values, with dimensions batch size and number of positions.
+/// @param first_position Position of the first inputs in their sequences, which is not zero for incremental decoding.
+/// @param outputs_data Embeddings, with dimensions batch size, number of positions and depth.
 
-void EmbeddingLayer::lookup_embedding(const Tensor<type, 1>& input_row,
-                                    PerceptronLayerForwardPropagation* perceptron_forward_propagation,
-                                    const bool& is_training)
+void EmbeddingLayer::lookup_embedding(const TensorMap<Tensor<type, 2>>& inputs, const Index& first_position, type* outputs_data) const
 {
-    Tensor<type, 2> one_hot_encoded_input_row = one_hot_encode_row(input_row);
+    const Index batch_size = inputs.dimension(0);
 
-    Tensor<type*, 1> one_hot_encoded_input_row_data(1);
-    one_hot_encoded_input_row_data.setValues({one_hot_encoded_input_row.data()});
+    const Index tokens_number = inputs.size();
 
-    Tensor<Tensor<Index, 1>, 1> one_hot_encoded_input_row_dimensions;
-    one_hot_encoded_input_row_dimensions.setValues({get_dimensions(one_hot_encoded_input_row)});
+    const type* inputs_data = inputs.data();
 
-//    perceptron_layer.forward_propagate(one_hot_encoded_input_row_data,
-//                                       one_hot_encoded_input_row_dimensions, // input_length is batch_size
-//                                       perceptron_forward_propagation,
-//                                       is_training);
-};
+    check_inputs(inputs_data, tokens_number);
 
+    const type* lookup_table_data = lookup_table.data();
 
-/// Builds positional encoding matrix with dimensions (input_length, depth) of the layer.
+    const type* positional_encoding_data = positional_encoding_matrix.data();
 
-const Tensor<type, 2> EmbeddingLayer::build_positional_encoding_matrix()
-{
-    Tensor<type, 2> positional_encoding_matrix(input_length, depth);
-    positional_encoding_matrix.setZero();
-
-    const Index half_depth = type(depth)/2;
+    const bool has_positional_encoding = positional_encoding != PositionalEncoding::NoPositionalEncoding;
 
-#pragma omp parallel for collapse(2)
-    for(Index i = 0; i < input_length; i++)
+#pragma omp parallel for
+    for(Index i = 0; i < tokens_number; i++)
     {
-        for(Index j = 0; j < half_depth - 1; j++)
+        const type* embedding = lookup_table_data + static_cast<Index>(inputs_data[i])*depth;
+
+        if(has_positional_encoding)
+        {
+            const Index position = first_position + i/batch_size;
+
+            for(Index j = 0; j < depth; j++)
+            {
+                outputs_data[i + tokens_number*j] = embedding[j] + positional_encoding_data[position + input_length*j];
+            }
+        }
+        else
         {
-            positional_encoding_matrix(i, 2*j) = sin( (i + 1) / pow(100000, (j + 1) / half_depth) );
-            positional_encoding_matrix(i, 2*j+1) = cos( (i + 1) / pow(100000, (j + 1) / half_depth) );
+            for(Index j = 0; j < depth; j++)
+            {
+                outputs_data[i + tokens_number*j] = embedding[j];
+            }
         }
     }
+}
+
+
+/// Builds the sinusoidal positional encoding matrix, with dimensions (input_length, depth) of the layer.
+/// The even columns 2i of position t are sin(t/10000^(2i/depth)), and the odd columns 2i+1 are cos(t/10000^(2i/depth)).
+
+Tensor<type, 2> EmbeddingLayer::build_positional_encoding_matrix() const
+{
+    Tensor<type, 2> positional_encoding_matrix(input_length, depth);
 
 #pragma omp parallel for
-    for(Index i = 0; i < input_length; i++)
+    for(Index j = 0; j < depth; j++)
     {
-        if(depth % 2 == 0)
-        {
-            positional_encoding_matrix(i, depth - 2) = sin( (i+1) / 10000 );
-            positional_encoding_matrix(i, depth - 1) = cos( (i+1) / 10000 );
-        }
-        else
+        const type frequency = type(1)/pow(type(10000), type(j - j%2)/type(depth));
+
+        for(Index i = 0; i < input_length; i++)
         {
-            positional_encoding_matrix(i, depth - 1) = sin( (i+1) / 10000 );
+            positional_encoding_matrix(i, j) = j%2 == 0
+                    ? sin(type(i)*frequency)
+                    : cos(type(i)*frequency);
         }
     }
 
     return positional_encoding_matrix;
+}
 
-};
 
+/// Calculates the embeddings of a batch of inputs.
+/// In an incremental forward propagation, the inputs are the next positions of the sequences of the previous ones,
+/// so that there can be fewer than the input length, and their positional encodings start after those positions.
+/// @param inputs Input values, with dimensions batch size and input length, or the number of new positions if incremental.
+/// @param forward_propagation Forward propagation of the layer, where the embeddings are written.
 
 void EmbeddingLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
                                         LayerForwardPropagation* forward_propagation,
                                         const bool& is_training)
 {
-    if(inputs(0).get_dimension(1) != input_length)
+    EmbeddingLayerForwardPropagation* embedding_layer_forward_propagation
+        = static_cast<EmbeddingLayerForwardPropagation*>(forward_propagation);
+
+    const bool is_incremental = forward_propagation->is_incremental;
+
+    const Index batch_size = inputs(0).get_dimension(0);
+    const Index positions_number = inputs(0).get_dimension(1);
+
+    const Index first_position = is_incremental ? embedding_layer_forward_propagation->positions_number : 0;
+
+    if(is_incremental ? positions_number > input_length : positions_number != input_length)
     {
         ostringstream buffer;
         buffer << "OpenNN Exception: EmbeddingLayer class.\n"
                << "void EmbeddingLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>&, type*, Tensor<Index, 1>&)\n"
-               << "Inputs columns number must be equal to " << input_length << ", (" << inputs(0).get_dimension(1) << ").\n";
+               << "Inputs columns number must be " << (is_incremental ? "at most " : "equal to ") << input_length << ", (" << positions_number << ").\n";
         throw invalid_argument(buffer.str());
     }
 
-    const Index batch_size = inputs(0).get_dimension(0);
+    if(positional_encoding != PositionalEncoding::NoPositionalEncoding && first_position + positions_number > input_length)
+    {
+        ostringstream buffer;
+        buffer << "OpenNN Exception: EmbeddingLayer class.\n"
+               << "void EmbeddingLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>&, type*, Tensor<Index, 1>&)\n"
+               << "Incremental sequences with positional encoding must have at most " << input_length << " positions ("
+               << first_position + positions_number << "). Reset the states to start new sequences.\n";
+        throw invalid_argument(buffer.str());
+    }
 
     const TensorMap<Tensor<type, 2>> inputs_tensor_map = inputs(0).to_tensor_map<2>();
 
-    EmbeddingLayerForwardPropagation* embedding_layer_forward_propagation
-        = static_cast<EmbeddingLayerForwardPropagation*>(forward_propagation);
+    DynamicTensor<type>& outputs = embedding_layer_forward_propagation->outputs(0);
+
+    Tensor<Index, 1> outputs_dimensions(3);
+    outputs_dimensions.setValues({batch_size, positions_number, depth});
+
+    outputs.reshape(outputs_dimensions);
 
-    PerceptronLayerForwardPropagation perceptron_layer_forward_propagation =
-        embedding_layer_forward_propagation->perceptron_forward_propagation;
+    lookup_embedding(inputs_tensor_map, first_position, outputs.get_data());
+
+    if(is_incremental) embedding_layer_forward_propagation->positions_number += positions_number;
+}
 
-    Tensor<type, 1> input_row(input_length);
 
-//#pragma omp parallel for
-    for(Index i = 0; i < batch_size; i++)
+/// Calculates the deltas of the layer from those of the next layer, which is a multi-head attention layer
+/// that takes the embeddings as query, key and value.
+/// @param next_layer_forward_propagation Forward propagation of the next layer.
+/// @param next_layer_back_propagation Back propagation of the next layer, with its deltas.
+/// @param layer_back_propagation Back propagation of this layer, where the deltas are written.
+
+void EmbeddingLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
+                                            LayerBackPropagation* next_layer_back_propagation,
+                                            LayerBackPropagation* layer_back_propagation) const
+{
+    switch(next_layer_back_propagation->layer_pointer->get_type())
     {
-        input_row = inputs_tensor_map.chip(i, 0);
-        lookup_embedding(input_row, &perceptron_layer_forward_propagation, is_training);
+    case Type::MultiheadAttention:
+    {
+        static_cast<MultiheadAttentionLayer*>(next_layer_back_propagation->layer_pointer)
+                ->calculate_inputs_deltas(next_layer_forward_propagation,
+                                          next_layer_back_propagation,
+                                          layer_back_propagation->deltas_data);
+    }
+        break;
 
-        memcpy(embedding_layer_forward_propagation->outputs(0).get_data() + i*input_length*depth,
-               perceptron_layer_forward_propagation.outputs(0).get_data(),
-               static_cast<size_t>(input_length*depth*sizeof(type)));
+    default: return;
     }
+}
+
+
+/// Calculates the derivatives of the error with respect to the rows of the lookup table touched by the batch.
+/// The deltas of all the positions of the same input value are added into a single row of derivatives,
+/// so that the cost is proportional to the number of input values in the batch and not to the input dimension.
+/// The derivatives of learned positional encodings are the deltas added over the batch.
+/// @param inputs_data Input values of the batch.
+/// @param back_propagation Back propagation of the layer, where the touched rows and their derivatives are written.
+
+void EmbeddingLayer::calculate_error_gradient(type* inputs_data,
+                                              LayerForwardPropagation*,
+                                              LayerBackPropagation* back_propagation) const
+{
+    EmbeddingLayerBackPropagation* embedding_layer_back_propagation =
+            static_cast<EmbeddingLayerBackPropagation*>(back_propagation);
 
-    if(positional_encoding)
+    const Index tokens_number = back_propagation->batch_samples_number*input_length;
+
+    Tensor<Index, 1>& touched_rows = embedding_layer_back_propagation->touched_rows;
+    Tensor<Index, 1>& tokens_rows = embedding_layer_back_propagation->tokens_rows;
+    Tensor<Index, 1>& rows_positions = embedding_layer_back_propagation->rows_positions;
+
+    Tensor<type, 2>& rows_derivatives = embedding_layer_back_propagation->rows_derivatives;
+
+    // Touched rows
+
+    Index touched_rows_number = 0;
+
+    for(Index i = 0; i < tokens_number; i++)
     {
-        TensorMap<Tensor<type, 3>> outputs = embedding_layer_forward_propagation->outputs(0).to_tensor_map<3>();
+        const Index row = static_cast<Index>(inputs_data[i]);
+
+        if(rows_positions(row) == -1)
+        {
+            rows_positions(row) = touched_rows_number;
+
+            touched_rows(touched_rows_number) = row;
+
+            touched_rows_number++;
+        }
+
+        tokens_rows(i) = rows_positions(row);
+    }
+
+    for(Index i = 0; i < touched_rows_number; i++)
+    {
+        rows_positions(touched_rows(i)) = -1;
+    }
+
+    embedding_layer_back_propagation->touched_rows_number = touched_rows_number;
+
+    // Rows derivatives
+
+    const type* deltas_data = back_propagation->deltas_data;
 
-        const Tensor<type, 2> positional_encoding_matrix = build_positional_encoding_matrix();
 #pragma omp parallel for
-        for(Index i = 0; i < batch_size; i++)
-            outputs.chip(i, 0) += positional_encoding_matrix;
+    for(Index j = 0; j < depth; j++)
+    {
+        type* row_derivatives = rows_derivatives.data() + rows_derivatives.dimension(0)*j;
+
+        fill(row_derivatives, row_derivatives + touched_rows_number, type(0));
+
+        for(Index i = 0; i < tokens_number; i++)
+        {
+            row_derivatives[tokens_rows(i)] += deltas_data[i + tokens_number*j];
+        }
     }
+
+    // Positional encoding derivatives
+
+    if(positional_encoding != PositionalEncoding::Learned) return;
+
+    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->batch_samples_number, input_length*depth);
+
+    TensorMap<Tensor<type, 1>> positional_encoding_derivatives(embedding_layer_back_propagation->positional_encoding_derivatives.data(),
+                                                               input_length*depth);
+
+    const Eigen::array<Index, 1> batch_dimension({0});
+
+    positional_encoding_derivatives.device(*thread_pool_device) = deltas.sum(batch_dimension);
 }
 
-/*
-void EmbeddingLayer::forward_propagate(type* inputs_data,
-                                        const Tensor<Index, 1>& inputs_dimensions,
-                                        Tensor<type, 1>& potential_parameters,
-                                        LayerForwardPropagation* forward_propagation)
+
+/// Writes the derivatives of the touched rows in the gradient, and zeroes those of the rows written in the previous batch.
+/// The rest of the lookup table gradient is zeroed only the first time.
+/// The derivatives of learned positional encodings are written after those of the lookup table.
+
+void EmbeddingLayer::insert_gradient(LayerBackPropagation* back_propagation, const Index& index, Tensor<type, 1>& gradient) const
 {
-#ifdef OPENNN_DEBUG
-    if(inputs_dimensions(1) != get_inputs_number())
-    {
-        ostringstream buffer;
-        buffer << "OpenNN Exception:" << LOG << endl
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final method.\n"
-               << "Inputs columns number must be equal to " << get_inputs_number() << ", (inputs number).\n";
+    EmbeddingLayerBackPropagation* embedding_layer_back_propagation =
+            static_cast<EmbeddingLayerBackPropagation*>(back_propagation);
 
-        throw invalid_argument(buffer.str());
-    }
+    const Index touched_rows_number = embedding_layer_back_propagation->touched_rows_number;
 
-    check_size(potential_parameters, get_parameters_number(), LOG);
-#endif
+    const Tensor<Index, 1>& touched_rows = embedding_layer_back_propagation->touched_rows;
 
-    const TensorMap<Tensor<type, 2>> inputs(inputs_data, inputs_dimensions(0), inputs_dimensions(1));
+    const Tensor<type, 2>& rows_derivatives = embedding_layer_back_propagation->rows_derivatives;
 
-    const Index neurons_number = get_neurons_number();
+    Tensor<Index, 1>& inserted_rows = embedding_layer_back_propagation->inserted_rows;
 
-    const Index inputs_number = get_inputs_number();
+    type* gradient_data = gradient.data() + index;
 
-    const TensorMap<Tensor<type, 2>> potential_biases(potential_parameters.data(), 1, neurons_number);
+    if(embedding_layer_back_propagation->inserted_rows_number == -1)
+    {
+        fill(gradient_data, gradient_data + lookup_table.size(), type(0));
+    }
+    else
+    {
+        for(Index i = 0; i < embedding_layer_back_propagation->inserted_rows_number; i++)
+        {
+            fill(gradient_data + inserted_rows(i)*depth, gradient_data + (inserted_rows(i) + 1)*depth, type(0));
+        }
+    }
 
-    const TensorMap<Tensor<type, 2>> potential_synaptic_weights(potential_parameters.data()+neurons_number, inputs_number, neurons_number);
+#pragma omp parallel for
+    for(Index i = 0; i < touched_rows_number; i++)
+    {
+        type* row_gradient = gradient_data + touched_rows(i)*depth;
 
-    PerceptronLayerForwardPropagation* perceptron_layer_forward_propagation
-        = static_cast<PerceptronLayerForwardPropagation*>(forward_propagation);
+        for(Index j = 0; j < depth; j++)
+        {
+            row_gradient[j] = rows_derivatives(i, j);
+        }
+
+        inserted_rows(i) = touched_rows(i);
+    }
 
-    const Tensor<Index, 1> activations_dimensions = perceptron_layer_forward_propagation->outputs_dimensions;
+    embedding_layer_back_propagation->inserted_rows_number = touched_rows_number;
 
-    const Tensor<Index, 1> combinations_dimensions = get_dimensions(perceptron_layer_forward_propagation->combinations);
+    if(positional_encoding != PositionalEncoding::Learned) return;
 
-    const Tensor<Index, 1> derivatives_dimensions = get_dimensions(perceptron_layer_forward_propagation->activations_derivatives);
+    const Tensor<type, 2>& positional_encoding_derivatives = embedding_layer_back_propagation->positional_encoding_derivatives;
 
+    copy(positional_encoding_derivatives.data(),
+         positional_encoding_derivatives.data() + positional_encoding_derivatives.size(),
+         gradient_data + lookup_table.size());
+}
 
-    calculate_combinations(inputs,
-                           potential_biases,
-                           potential_synaptic_weights,
-                           perceptron_layer_forward_propagation->get_combinations_data());
 
+/// The error gradient of an embedding layer is only nonzero at the rows of the input values in the batch.
 
-    calculate_activations_derivatives(perceptron_layer_forward_propagation->combinations.data(),
-                                      combinations_dimensions,
-                                      perceptron_layer_forward_propagation->outputs_data,
-                                      activations_dimensions,
-                                      perceptron_layer_forward_propagation->activations_derivatives.data(),
-                                      derivatives_dimensions);
+bool EmbeddingLayer::has_sparse_gradient() const
+{
+    return true;
 }
-*/
 
 
-string EmbeddingLayer::write_activation_function_expression() const
+/// Appends one gradient segment for each row of the lookup table touched by the last batch,
+/// and another one for the learned positional encodings.
+
+void EmbeddingLayer::insert_gradient_segments(LayerBackPropagation* back_propagation,
+                                              const Index& index,
+                                              vector<pair<Index, Index>>& gradient_segments) const
 {
-    switch(activation_function)
-    {
-    case PerceptronLayer::ActivationFunction::Threshold:
-        return "threshold";
+    const EmbeddingLayerBackPropagation* embedding_layer_back_propagation =
+            static_cast<EmbeddingLayerBackPropagation*>(back_propagation);
 
-    case PerceptronLayer::ActivationFunction::SymmetricThreshold:
-        return "symmetric_threshold";
+    for(Index i = 0; i < embedding_layer_back_propagation->touched_rows_number; i++)
+    {
+        gradient_segments.push_back(make_pair(index + embedding_layer_back_propagation->touched_rows(i)*depth, depth));
+    }
 
-    case PerceptronLayer::ActivationFunction::Logistic:
-        return "logistic";
+    if(positional_encoding == PositionalEncoding::Learned)
+        gradient_segments.push_back(make_pair(index + lookup_table.size(), positional_encoding_matrix.size()));
+}
 
-    case PerceptronLayer::ActivationFunction::HyperbolicTangent:
-        return "tanh";
 
-    case PerceptronLayer::ActivationFunction::Linear:
-        return string();
+/// Sets only the rows of the lookup table, and the learned positional encodings, which lie in the given segments.
+/// @param new_parameters Parameters of the whole neural network.
+/// @param index Position of the parameters of this layer in the vector.
+/// @param gradient_segments Segments of the parameters to be set, as pairs of first index and size.
 
-    case PerceptronLayer::ActivationFunction::RectifiedLinear:
-        return "ReLU";
+void EmbeddingLayer::set_parameters_segments(const Tensor<type, 1>& new_parameters,
+                                             const Index& index,
+                                             const vector<pair<Index, Index>>& gradient_segments)
+{
+    const Index lookup_table_size = lookup_table.size();
 
-    case PerceptronLayer::ActivationFunction::ExponentialLinear:
-        return "ELU";
+    const Index parameters_number = get_parameters_number();
 
-    case PerceptronLayer::ActivationFunction::ScaledExponentialLinear:
-        return "SELU";
+    const Index segments_number = static_cast<Index>(gradient_segments.size());
 
-    case PerceptronLayer::ActivationFunction::SoftPlus:
-        return "soft_plus";
+#pragma omp parallel for
+    for(Index i = 0; i < segments_number; i++)
+    {
+        const Index first = gradient_segments[i].first;
 
-    case PerceptronLayer::ActivationFunction::SoftSign:
-        return "soft_sign";
+        if(first < index || first >= index + parameters_number) continue;
 
-    case PerceptronLayer::ActivationFunction::HardSigmoid:
-        return "hard_sigmoid";
+        type* parameters_data = first - index < lookup_table_size
+                ? lookup_table.data() + first - index
+                : positional_encoding_matrix.data() + first - index - lookup_table_size;
 
-    default:
-        return string();
+        copy(new_parameters.data() + first,
+             new_parameters.data() + first + gradient_segments[i].second,
+             parameters_data);
     }
 }
 
+
 /// @todo
 ///// Returns a string with the expression of the inputs-outputs relationship of the layer.
 ///// @param inputs_names vector of strings with the name of the layer inputs.
@@ -22,7 +22,6 @@
 
 #include "config.h"
 #include "layer.h"
-#include "perceptron_layer.h"
 
 #ifdef OPENNN_MKL
 #include "../mkl/mkl.h"
@@ -44,7 +43,9 @@ struct EmbeddingLayerBackPropagationLM;
 
 /// EmbeddingLayer has inputs of a fixed length (input_length) and within a fixed set of possible integer values (input_dim).
 /// The layer will assign to each possible value a dense vector of fixed length (depth).
-/// The vectors are learnable parameters, which is implemented by passing a one-hot encoding of each value through a PerceptronLayer.
+/// The vectors are learnable parameters, stored in a lookup table whose rows are gathered for each input value.
+/// A positional encoding, either sinusoidal or learned, can be added to the embeddings in the same gather.
+/// The error gradient is only nonzero at the rows of the values in the batch, which are the only ones updated by lazy optimizers.
 
 
 class EmbeddingLayer : public Layer
@@ -53,10 +54,9 @@ class EmbeddingLayer : public Layer
 
 public:
 
-    /// Enumeration of the available activation functions for the perceptron neuron model.
+    /// Enumeration of the available positional encodings.
 
-    enum class ActivationFunction{Threshold, SymmetricThreshold, Logistic, HyperbolicTangent, Linear, RectifiedLinear,
-                                    ExponentialLinear, ScaledExponentialLinear, SoftPlus, SoftSign, HardSigmoid};
+    enum class PositionalEncoding{NoPositionalEncoding, Sinusoidal, Learned};
 
     // Constructors
 
@@ -65,8 +65,8 @@ public:
     explicit EmbeddingLayer(const Index&, /// Input dim
                             const Index&, /// Input length
                             const Index&, /// Embedding depth
-                            const bool& = false, /// Add positional encoding or not
-                            const PerceptronLayer::ActivationFunction& = PerceptronLayer::ActivationFunction::Linear);
+                            const PositionalEncoding& = PositionalEncoding::NoPositionalEncoding
+                            );
 
     // Get methods
 
@@ -75,13 +75,20 @@ public:
     Index get_input_dim() const;
     Index get_input_length() const;
     Index get_depth() const;
-    PerceptronLayer get_perceptron_layer() const;
 
-    Index get_parameters_number() const final;
+    Tensor<Index, 1> get_inputs_dimensions() const final;
+    Tensor<Index, 1> get_outputs_dimensions() const final;
+
+    const Tensor<type, 2>& get_lookup_table() const;
 
-    const PerceptronLayer::ActivationFunction& get_activation_function() const;
+    const PositionalEncoding& get_positional_encoding() const;
+    string write_positional_encoding() const;
 
-    string write_activation_function() const;
+    const Tensor<type, 2>& get_positional_encoding_matrix() const;
+
+    Index get_parameters_number() const final;
+    Tensor<type, 1> get_parameters() const final;
+    Tensor< TensorMap< Tensor<type, 1>>*, 1> get_layer_parameters() final;
 
     // Display messages
 
@@ -90,8 +97,7 @@ public:
     // Set methods
 
     void set();
-    void set(const Index&, const Index&, const Index&, const bool& = false,
-             const PerceptronLayer::ActivationFunction& = PerceptronLayer::ActivationFunction::Linear);
+    void set(const Index&, const Index&, const Index&, const PositionalEncoding& = PositionalEncoding::NoPositionalEncoding);
 
     void set_default();
     void set_name(const string&);
@@ -102,10 +108,18 @@ public:
     void set_input_length(const Index&);
     void set_depth(const Index&);
 
-    void set_perceptron();
+    void set_lookup_table();
+    void set_lookup_table(const Tensor<type, 2>&);
 
-    void set_activation_function(const PerceptronLayer::ActivationFunction&);
-    void set_activation_function(const string&);
+    void set_positional_encoding(const PositionalEncoding&);
+    void set_positional_encoding(const string&);
+
+    void set_positional_encoding_matrix();
+    void set_positional_encoding_matrix(const Tensor<type, 2>&);
+
+    void set_parameters(const Tensor<type, 1>&, const Index& = 0) final;
+    void set_parameters_constant(const type&) final;
+    void set_parameters_random() final;
 
     // Display messages
 
@@ -113,29 +127,39 @@ public:
 
     // Embedding lookup
 
-    Tensor<type, 2> one_hot_encode_row(const Tensor<type, 1>&);
+    void check_inputs(const type*, const Index&) const;
 
-    void lookup_embedding(const Tensor<type, 1>&, PerceptronLayerForwardPropagation*, const bool&);
+    void lookup_embedding(const TensorMap<Tensor<type, 2>>&, const Index&, type*) const;
 
     // Positional encoding
 
-    const Tensor<type, 2> build_positional_encoding_matrix();
+    Tensor<type, 2> build_positional_encoding_matrix() const;
 
     // Embedding layer outputs
 
     void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, LayerForwardPropagation*, const bool&) final;
 
-    /*
-    void forward_propagate(type*,
-                           const Tensor<Index, 1>&,
-                           Tensor<type, 1>&,
-                           LayerForwardPropagation*) final;
-*/
-    // Expression methods
+    // Delta methods
+
+    void calculate_hidden_delta(LayerForwardPropagation*,
+                                LayerBackPropagation*,
+                                LayerBackPropagation*) const final;
+
+    // Gradient methods
 
-    //    string write_expression(const Tensor<string, 1>&, const Tensor<string, 1>&) const final;
+    void calculate_error_gradient(type*,
+                                  LayerForwardPropagation*,
+                                  LayerBackPropagation*) const final;
 
-    string write_activation_function_expression() const;
+    void insert_gradient(LayerBackPropagation*, const Index&, Tensor<type, 1>&) const final;
+
+    // Sparse gradient
+
+    bool has_sparse_gradient() const final;
+
+    void insert_gradient_segments(LayerBackPropagation*, const Index&, vector<pair<Index, Index>>&) const final;
+
+    void set_parameters_segments(const Tensor<type, 1>&, const Index&, const vector<pair<Index, Index>>&) final;
 
     // Serialization methods
     /// @todo
@@ -159,17 +183,18 @@ protected:
 
     Index depth;
 
-    /// Perceptron layer
+    /// Lookup table, with the embedding of each input value stored contiguously in a column of size depth.
 
-    PerceptronLayer perceptron_layer;
+    Tensor<type, 2> lookup_table;
 
-    /// Whether the layer has to add positional encoding or not
+    /// Positional encoding added to the embeddings.
 
-    bool positional_encoding;
+    PositionalEncoding positional_encoding;
 
-    /// Activation function variable.
+    /// Positional encodings of all the positions, with dimensions input length and depth.
+    /// They are built when the layer dimensions change, or learned with the lookup table.
 
-    PerceptronLayer::ActivationFunction activation_function;
+    Tensor<type, 2> positional_encoding_matrix;
 
     /// Display messages to screen.
 
@@ -215,32 +240,31 @@ protected:
             outputs.resize(1);
             Tensor<Index, 1> output_dimensions(3);
             output_dimensions.setValues({batch_samples_number, input_length, depth});
-            outputs(0).set_dimensions(output_dimensions);
+            set_buffer_dimensions(outputs(0), output_dimensions);
 
-            // Rest of quantities
+            positions_number = 0;
+        }
 
-            PerceptronLayer perceptron_layer = layer_pointer-> get_perceptron_layer();
 
-            perceptron_forward_propagation.set(input_length, &perceptron_layer);
+        void reset_states() final
+        {
+            positions_number = 0;
         }
 
+
         void print() const
         {
-            //            cout << "Attention scores:" << endl;
-            //            cout << attention_scores.dimensions() << endl;
+            cout << "Outputs dimensions:" << endl;
+            cout << outputs(0).get_dimensions() << endl;
 
-
-            //            cout << "Outputs dimensions:" << endl;
-            //            cout << outputs_dimensions << endl;
-
-            //            cout << "Outputs:" << endl;
-            //            cout << TensorMap<Tensor<type,3>>(outputs_data, outputs_dimensions(0), outputs_dimensions(1), outputs_dimensions(2)) << endl;
-
-            //            cout << "Attention scores:" << endl;
-            //            cout << attention_scores << endl;
+            cout << "Outputs:" << endl;
+            cout << outputs(0).to_tensor_map<3>() << endl;
         }
 
-        PerceptronLayerForwardPropagation perceptron_forward_propagation;
+        /// Number of positions of the sequences given by the previous incremental forward propagations,
+        /// which is the position of the first inputs of the next one.
+
+        Index positions_number = 0;
     };
 
 
@@ -267,36 +291,11 @@ protected:
         }
 
         /// @todo
-        /*
-        void set(const Index& new_batch_samples_number, Layer* new_layer_pointer)
-        {
-            layer_pointer = new_layer_pointer;
-
-            batch_samples_number = new_batch_samples_number;
-
-            const Index neurons_number = layer_pointer->get_neurons_number();
-            const Index parameters_number = layer_pointer->get_parameters_number();
-
-            deltas.resize(batch_samples_number, neurons_number);
-
-            squared_errors_Jacobian.resize(batch_samples_number, parameters_number);
-        }
-
-        void print() const
-        {
-            cout << "Deltas:" << endl;
-            cout << deltas << endl;
-
-            cout << "Squared errors Jacobian: " << endl;
-            cout << squared_errors_Jacobian << endl;
-
-        }
-
-        Tensor<type, 2> squared_errors_Jacobian;
-*/
     };
 
 
+    /// This structure contains the sparse error gradient of an embedding layer.
+    /// Each input value appearing in the batch (touched row) has a row of derivatives, which is the sum of the deltas of its positions.
 
     struct EmbeddingLayerBackPropagation : LayerBackPropagation
     {
@@ -318,60 +317,96 @@ protected:
             set(new_batch_samples_number, new_layer_pointer);
         }
 
-        /// @todo
-        /*
+
         void set(const Index& new_batch_samples_number, Layer* new_layer_pointer)
         {
             layer_pointer = new_layer_pointer;
 
+            const EmbeddingLayer* embedding_layer_pointer = static_cast<EmbeddingLayer*>(new_layer_pointer);
+
             batch_samples_number = new_batch_samples_number;
 
-            const Index neurons_number = layer_pointer->get_neurons_number();
-            const Index inputs_number = layer_pointer->get_inputs_number();
+            const Index input_dim = embedding_layer_pointer->get_input_dim();
 
-            deltas_dimensions.resize(2);
-            deltas_dimensions.setValues({batch_samples_number, neurons_number});
+            const Index input_length = embedding_layer_pointer->get_input_length();
 
-            deltas_data = (type*)malloc( static_cast<size_t>(batch_samples_number*neurons_number*sizeof(type)));
+            const Index depth = embedding_layer_pointer->get_depth();
 
-            biases_derivatives.resize(neurons_number);
+            const Index tokens_number = batch_samples_number*input_length;
 
-            synaptic_weights_derivatives.resize(inputs_number, neurons_number);
+            const Index maximum_touched_rows_number = min(tokens_number, input_dim);
 
-            deltas_times_activations_derivatives.resize(batch_samples_number, neurons_number);
-        }
+            // Deltas
 
-        Tensor< TensorMap< Tensor<type, 1> >*, 1> get_layer_gradient()
-        {
-            Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_gradient(2);
+            deltas_dimensions.resize(3);
+            deltas_dimensions.setValues({batch_samples_number, input_length, depth});
+
+            free(deltas_data);
+            deltas_data = (type*)malloc(static_cast<size_t>(tokens_number*depth*sizeof(type)));
+
+            // Sparse gradient
+
+            touched_rows_number = 0;
+            touched_rows.resize(maximum_touched_rows_number);
+
+            rows_derivatives.resize(maximum_touched_rows_number, depth);
+
+            tokens_rows.resize(tokens_number);
 
-            const Index inputs_number = layer_pointer->get_inputs_number();
-            const Index neurons_number = layer_pointer->get_neurons_number();
+            rows_positions.resize(input_dim);
+            rows_positions.setConstant(-1);
 
-            layer_gradient(0) = new TensorMap<Tensor<type, 1>>(biases_derivatives.data(), neurons_number);
-            layer_gradient(1) = new TensorMap<Tensor<type, 1>>(synaptic_weights_derivatives.data(), inputs_number*neurons_number);
+            inserted_rows_number = -1;
+            inserted_rows.resize(maximum_touched_rows_number);
 
-            return layer_gradient;
+            // Learned positional encoding
+
+            if(embedding_layer_pointer->get_positional_encoding() == EmbeddingLayer::PositionalEncoding::Learned)
+                positional_encoding_derivatives.resize(input_length, depth);
+            else
+                positional_encoding_derivatives.resize(0, 0);
         }
 
 
         void print() const
         {
-            cout << "Deltas:" << endl;
-            //cout << deltas << endl;
-
-            cout << "Biases derivatives:" << endl;
-            cout << biases_derivatives << endl;
+            cout << "Touched rows:" << endl;
+            cout << touched_rows.slice(Eigen::array<Index, 1>({0}), Eigen::array<Index, 1>({touched_rows_number})) << endl;
 
-            cout << "Synaptic weights derivatives:" << endl;
-            cout << synaptic_weights_derivatives << endl;
+            cout << "Rows derivatives:" << endl;
+            cout << rows_derivatives.slice(Eigen::array<Index, 2>({0, 0}),
+                                           Eigen::array<Index, 2>({touched_rows_number, rows_derivatives.dimension(1)})) << endl;
         }
 
-        Tensor<type, 1> biases_derivatives;
-        Tensor<type, 2> synaptic_weights_derivatives;
+        /// Number of different input values in the batch.
+
+        Index touched_rows_number = 0;
+
+        /// Different input values in the batch, in order of appearance.
+
+        Tensor<Index, 1> touched_rows;
+
+        /// Derivatives of the error with respect to the touched rows of the lookup table, one row per touched row.
+
+        Tensor<type, 2> rows_derivatives;
+
+        /// Position in touched_rows of the input value of each token of the batch.
+
+        Tensor<Index, 1> tokens_rows;
+
+        /// Position in touched_rows of each input value, or -1 if it does not appear in the batch.
+
+        Tensor<Index, 1> rows_positions;
+
+        /// Rows written in the gradient by the last call to insert_gradient, or -1 if the gradient has not been cleared yet.
+
+        Index inserted_rows_number = -1;
+
+        Tensor<Index, 1> inserted_rows;
+
+        /// Derivatives of the error with respect to the learned positional encodings.
 
-        Tensor<type, 2> deltas_times_activations_derivatives;
-*/
+        Tensor<type, 2> positional_encoding_derivatives;
     };
 
 }
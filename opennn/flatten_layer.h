@@ -145,7 +145,7 @@ struct FlattenLayerForwardPropagation : LayerForwardPropagation
         outputs.resize(1);
         Tensor<Index, 1> output_dimensions(2);
         output_dimensions.setValues({batch_samples_number, neurons_number});
-        outputs(0).set_dimensions(output_dimensions);
+        set_buffer_dimensions(outputs(0), output_dimensions);
     }
 
 
@@ -0,0 +1,381 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   B A T C H E R   C L A S S
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#include "inference_batcher.h"
+
+namespace opennn
+{
+
+/// Number of bins of the queue latency histogram.
+/// The last bin counts the requests which waited for more than about half an hour.
+
+const Index queue_latency_bins_number = 32;
+
+
+/// Default constructor.
+/// It creates an inference batcher not associated to any neural network, with the worker thread stopped.
+
+InferenceBatcher::InferenceBatcher()
+{
+}
+
+
+/// Neural network constructor.
+/// It starts the worker thread which calculates the outputs of a neural network in batches.
+/// @param new_neural_network_pointer Pointer to a neural network object.
+/// @param new_maximum_batch_samples_number Maximum number of samples in a batch.
+/// @param new_maximum_latency_microseconds Maximum time that a request waits for its batch to be filled.
+
+InferenceBatcher::InferenceBatcher(NeuralNetwork* new_neural_network_pointer,
+                                   const Index& new_maximum_batch_samples_number,
+                                   const Index& new_maximum_latency_microseconds)
+{
+    set(new_neural_network_pointer, new_maximum_batch_samples_number, new_maximum_latency_microseconds);
+}
+
+
+/// Destructor.
+/// It calculates the requests still in the queue and stops the worker thread.
+
+InferenceBatcher::~InferenceBatcher()
+{
+    stop();
+}
+
+
+/// Returns a pointer to the neural network whose outputs are calculated.
+
+NeuralNetwork* InferenceBatcher::get_neural_network_pointer() const
+{
+    return neural_network_pointer;
+}
+
+
+/// Returns the maximum number of samples in a batch.
+
+Index InferenceBatcher::get_maximum_batch_samples_number() const
+{
+    return maximum_batch_samples_number;
+}
+
+
+/// Returns the maximum time, in microseconds, that a request waits for its batch to be filled.
+
+Index InferenceBatcher::get_maximum_latency_microseconds() const
+{
+    return maximum_latency_microseconds;
+}
+
+
+/// Returns true if the worker thread is accepting requests, and false otherwise.
+
+bool InferenceBatcher::is_running() const
+{
+    lock_guard<mutex> lock(requests_mutex);
+
+    return running;
+}
+
+
+/// Returns the number of batches calculated of each size.
+/// The centers of the bins are the batch sizes, from 1 to the maximum batch samples number.
+
+Histogram InferenceBatcher::get_batch_samples_histogram() const
+{
+    Tensor<type, 1> centers(maximum_batch_samples_number);
+
+    for(Index i = 0; i < maximum_batch_samples_number; i++)
+    {
+        centers(i) = type(i + 1);
+    }
+
+    lock_guard<mutex> lock(requests_mutex);
+
+    return Histogram(batch_samples_frequencies, centers, centers, centers);
+}
+
+
+/// Returns the number of requests by the time, in microseconds, that they waited in the queue.
+/// The first bin is [0, 1) and each of the next bins is twice as wide as the previous one.
+
+Histogram InferenceBatcher::get_queue_latency_histogram() const
+{
+    Tensor<type, 1> minimums(queue_latency_bins_number);
+    Tensor<type, 1> maximums(queue_latency_bins_number);
+    Tensor<type, 1> centers(queue_latency_bins_number);
+
+    for(Index i = 0; i < queue_latency_bins_number; i++)
+    {
+        minimums(i) = i == 0 ? type(0) : type(Index(1) << (i-1));
+        maximums(i) = type(Index(1) << i);
+        centers(i) = type(0.5)*(minimums(i) + maximums(i));
+    }
+
+    lock_guard<mutex> lock(requests_mutex);
+
+    return Histogram(queue_latency_frequencies, centers, minimums, maximums);
+}
+
+
+/// Sets a new neural network and batching parameters, and starts the worker thread.
+/// The requests queued before are calculated with the previous neural network.
+/// @param new_neural_network_pointer Pointer to a neural network object.
+/// @param new_maximum_batch_samples_number Maximum number of samples in a batch.
+/// @param new_maximum_latency_microseconds Maximum time that a request waits for its batch to be filled.
+
+void InferenceBatcher::set(NeuralNetwork* new_neural_network_pointer,
+                           const Index& new_maximum_batch_samples_number,
+                           const Index& new_maximum_latency_microseconds)
+{
+    if(new_maximum_latency_microseconds < 0)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceBatcher class.\n"
+               << "void set(NeuralNetwork*, const Index&, const Index&) method.\n"
+               << "Maximum latency (" << new_maximum_latency_microseconds << ") must be positive.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    stop();
+
+    inference_session.set(new_neural_network_pointer, new_maximum_batch_samples_number);
+
+    neural_network_pointer = new_neural_network_pointer;
+    maximum_batch_samples_number = new_maximum_batch_samples_number;
+    maximum_latency_microseconds = new_maximum_latency_microseconds;
+
+    inputs_number = neural_network_pointer->get_inputs_number();
+    outputs_number = neural_network_pointer->get_outputs_number();
+
+    batch_inputs.resize(maximum_batch_samples_number, inputs_number);
+    batch_outputs.resize(maximum_batch_samples_number, outputs_number);
+
+    batch_samples_frequencies.resize(maximum_batch_samples_number);
+    queue_latency_frequencies.resize(queue_latency_bins_number);
+
+    reset_histograms();
+
+    start();
+}
+
+
+/// Sets to zero the frequencies of the batch samples and queue latency histograms.
+
+void InferenceBatcher::reset_histograms()
+{
+    lock_guard<mutex> lock(requests_mutex);
+
+    batch_samples_frequencies.setZero();
+    queue_latency_frequencies.setZero();
+}
+
+
+/// Starts the worker thread, if it is not running.
+
+void InferenceBatcher::start()
+{
+    if(!neural_network_pointer)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceBatcher class.\n"
+               << "void start() method.\n"
+               << "Neural network pointer is nullptr.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    lock_guard<mutex> lock(requests_mutex);
+
+    if(running) return;
+
+    running = true;
+
+    worker_thread = thread(&InferenceBatcher::run, this);
+}
+
+
+/// Stops accepting requests, waits until the queued ones are calculated and stops the worker thread.
+
+void InferenceBatcher::stop()
+{
+    {
+        lock_guard<mutex> lock(requests_mutex);
+
+        running = false;
+    }
+
+    requests_condition.notify_all();
+
+    if(worker_thread.joinable()) worker_thread.join();
+}
+
+
+/// Queues the inputs of a single sample and returns a future which holds its outputs once its batch is calculated.
+/// It can be called from many threads at the same time.
+/// If the calculation of the batch fails, the future throws the exception.
+/// @param inputs Inputs of the sample.
+
+future<Tensor<type, 1>> InferenceBatcher::calculate_outputs(const Tensor<type, 1>& inputs)
+{
+    if(inputs.size() != inputs_number)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceBatcher class.\n"
+               << "future<Tensor<type, 1>> calculate_outputs(const Tensor<type, 1>&) method.\n"
+               << "Size of inputs (" << inputs.size() << ") must be equal to inputs number (" << inputs_number << ").\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    InferenceRequest request;
+
+    request.inputs = inputs;
+
+    future<Tensor<type, 1>> outputs_future = request.outputs_promise.get_future();
+
+    {
+        lock_guard<mutex> lock(requests_mutex);
+
+        if(!running)
+        {
+            ostringstream buffer;
+
+            buffer << "OpenNN Exception: InferenceBatcher class.\n"
+                   << "future<Tensor<type, 1>> calculate_outputs(const Tensor<type, 1>&) method.\n"
+                   << "Inference batcher is not running.\n";
+
+            throw logic_error(buffer.str());
+        }
+
+        request.arrival_time = chrono::steady_clock::now();
+
+        requests.push_back(move(request));
+    }
+
+    requests_condition.notify_one();
+
+    return outputs_future;
+}
+
+
+/// Loop of the worker thread.
+/// It waits for the first request of a batch, then until the batch is full or the deadline of that request is reached.
+
+void InferenceBatcher::run()
+{
+    deque<InferenceRequest> batch_requests;
+
+    unique_lock<mutex> lock(requests_mutex);
+
+    while(true)
+    {
+        requests_condition.wait(lock, [this]{return !running || !requests.empty();});
+
+        if(requests.empty()) break;
+
+        const chrono::steady_clock::time_point deadline
+                = requests.front().arrival_time + chrono::microseconds(maximum_latency_microseconds);
+
+        requests_condition.wait_until(lock, deadline,
+                                      [this]{return !running || Index(requests.size()) >= maximum_batch_samples_number;});
+
+        const Index batch_samples_number = min(Index(requests.size()), maximum_batch_samples_number);
+
+        const chrono::steady_clock::time_point now = chrono::steady_clock::now();
+
+        for(Index i = 0; i < batch_samples_number; i++)
+        {
+            const Index latency_microseconds
+                    = Index(chrono::duration_cast<chrono::microseconds>(now - requests.front().arrival_time).count());
+
+            Index bin = 0;
+
+            while(bin < queue_latency_bins_number - 1 && (Index(1) << bin) <= latency_microseconds) bin++;
+
+            queue_latency_frequencies(bin)++;
+
+            batch_requests.push_back(move(requests.front()));
+
+            requests.pop_front();
+        }
+
+        batch_samples_frequencies(batch_samples_number - 1)++;
+
+        lock.unlock();
+
+        calculate_batch_outputs(batch_requests);
+
+        batch_requests.clear();
+
+        lock.lock();
+    }
+}
+
+
+/// Gathers the inputs of a batch of requests, calculates their outputs in a single call
+/// and scatters them to the promises of the requests.
+/// Batches closed by the maximum latency have fewer samples than the maximum,
+/// and the session only changes the dimensions of its workspaces for them, so they are not padded.
+
+void InferenceBatcher::calculate_batch_outputs(deque<InferenceRequest>& batch_requests)
+{
+    const Index batch_samples_number = Index(batch_requests.size());
+
+    TensorMap<Tensor<type, 2>> inputs(batch_inputs.data(), batch_samples_number, inputs_number);
+    TensorMap<Tensor<type, 2>> outputs(batch_outputs.data(), batch_samples_number, outputs_number);
+
+    for(Index i = 0; i < batch_samples_number; i++)
+    {
+        inputs.chip(i, 0) = batch_requests[i].inputs;
+    }
+
+    try
+    {
+        inference_session.calculate_outputs(inputs.data(), batch_samples_number, outputs.data());
+    }
+    catch(...)
+    {
+        for(Index i = 0; i < batch_samples_number; i++)
+        {
+            batch_requests[i].outputs_promise.set_exception(current_exception());
+        }
+
+        return;
+    }
+
+    for(Index i = 0; i < batch_samples_number; i++)
+    {
+        const Tensor<type, 1> sample_outputs = outputs.chip(i, 0);
+
+        batch_requests[i].outputs_promise.set_value(sample_outputs);
+    }
+}
+
+}
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -0,0 +1,167 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   B A T C H E R   C L A S S   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef INFERENCEBATCHER_H
+#define INFERENCEBATCHER_H
+
+// System includes
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <thread>
+
+// OpenNN includes
+
+#include "config.h"
+#include "neural_network.h"
+#include "inference_session.h"
+#include "statistics.h"
+
+namespace opennn
+{
+
+/// This class calculates the outputs of a neural network for single samples requested by many threads, in batches.
+
+///
+/// The requests are queued, and a worker thread takes them in batches of up to a maximum number of samples.
+/// A batch is calculated when it is full or when its oldest request has waited for the maximum latency,
+/// and the outputs of each sample are given back through a future.
+/// The batch sizes and the times spent in the queue are counted in histograms.
+
+class InferenceBatcher
+{
+
+public:
+
+   // Constructors
+
+   explicit InferenceBatcher();
+
+   explicit InferenceBatcher(NeuralNetwork*, const Index&, const Index&);
+
+   // Destructor
+
+   virtual ~InferenceBatcher();
+
+   // Get methods
+
+   NeuralNetwork* get_neural_network_pointer() const;
+
+   Index get_maximum_batch_samples_number() const;
+
+   Index get_maximum_latency_microseconds() const;
+
+   bool is_running() const;
+
+   Histogram get_batch_samples_histogram() const;
+
+   Histogram get_queue_latency_histogram() const;
+
+   // Set methods
+
+   void set(NeuralNetwork*, const Index&, const Index&);
+
+   void reset_histograms();
+
+   // Worker methods
+
+   void start();
+
+   void stop();
+
+   // Outputs
+
+   future<Tensor<type, 1>> calculate_outputs(const Tensor<type, 1>&);
+
+protected:
+
+   /// Inputs of a single sample waiting in the queue, and the promise of its outputs.
+
+   struct InferenceRequest
+   {
+       Tensor<type, 1> inputs;
+
+       promise<Tensor<type, 1>> outputs_promise;
+
+       chrono::steady_clock::time_point arrival_time;
+   };
+
+   void run();
+
+   void calculate_batch_outputs(deque<InferenceRequest>&);
+
+   NeuralNetwork* neural_network_pointer = nullptr;
+
+   /// Maximum number of samples in a batch.
+
+   Index maximum_batch_samples_number = 1;
+
+   /// Maximum time that the oldest request waits for a batch to be filled.
+
+   Index maximum_latency_microseconds = 0;
+
+   Index inputs_number = 0;
+
+   Index outputs_number = 0;
+
+   /// Session used by the worker thread to calculate the batches.
+
+   InferenceSession inference_session;
+
+   Tensor<type, 2> batch_inputs;
+
+   Tensor<type, 2> batch_outputs;
+
+   /// Requests waiting to be calculated.
+
+   deque<InferenceRequest> requests;
+
+   mutable mutex requests_mutex;
+
+   condition_variable requests_condition;
+
+   thread worker_thread;
+
+   bool running = false;
+
+   /// Number of batches of each size, from 1 to the maximum batch samples number.
+
+   Tensor<Index, 1> batch_samples_frequencies;
+
+   /// Number of requests by time in the queue, in bins of microseconds which double in width.
+
+   Tensor<Index, 1> queue_latency_frequencies;
+};
+
+}
+
+#endif
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
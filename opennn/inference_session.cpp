@@ -0,0 +1,448 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   S E S S I O N   C L A S S
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#include "inference_session.h"
+
+namespace opennn
+{
+
+/// Default constructor.
+/// It creates an inference session not associated to any neural network.
+
+InferenceSession::InferenceSession()
+{
+}
+
+
+/// Neural network constructor.
+/// It allocates the workspaces to calculate the outputs of a neural network for a maximum batch size.
+/// @param new_neural_network_pointer Pointer to a neural network object.
+/// @param new_maximum_batch_samples_number Maximum number of samples of each call.
+
+InferenceSession::InferenceSession(NeuralNetwork* new_neural_network_pointer, const Index& new_maximum_batch_samples_number)
+{
+    set(new_neural_network_pointer, new_maximum_batch_samples_number);
+}
+
+
+/// Destructor.
+
+InferenceSession::~InferenceSession()
+{
+}
+
+
+/// Returns a pointer to the neural network associated to the inference session.
+
+NeuralNetwork* InferenceSession::get_neural_network_pointer() const
+{
+    return neural_network_pointer;
+}
+
+
+/// Returns the maximum number of samples of each call.
+
+const Index& InferenceSession::get_maximum_batch_samples_number() const
+{
+    return maximum_batch_samples_number;
+}
+
+
+/// Returns the number of samples of the current calls, which is not greater than the maximum one.
+
+const Index& InferenceSession::get_batch_samples_number() const
+{
+    return batch_samples_number;
+}
+
+
+/// Returns the number of outputs of each sample, which is the number of outputs of the neural network.
+
+Index InferenceSession::get_outputs_number() const
+{
+    if(neural_network_pointer == nullptr) return 0;
+
+    return neural_network_pointer->get_outputs_number();
+}
+
+
+/// Associates a neural network to the inference session and allocates the workspaces for a maximum batch size.
+/// The neural network must not be modified while the session is in use.
+/// @param new_neural_network_pointer Pointer to a neural network object.
+/// @param new_maximum_batch_samples_number Maximum number of samples of each call.
+
+void InferenceSession::set(NeuralNetwork* new_neural_network_pointer, const Index& new_maximum_batch_samples_number)
+{
+    if(new_neural_network_pointer == nullptr)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSession class.\n"
+               << "void set(NeuralNetwork*, const Index&) method.\n"
+               << "Neural network pointer is nullptr.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    if(new_maximum_batch_samples_number < 1)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSession class.\n"
+               << "void set(NeuralNetwork*, const Index&) method.\n"
+               << "Maximum batch samples number (" << new_maximum_batch_samples_number << ") must be greater than 0.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    neural_network_pointer = new_neural_network_pointer;
+
+    maximum_batch_samples_number = new_maximum_batch_samples_number;
+
+    batch.inputs.resize(1);
+
+    inputs_dimensions.resize(2);
+
+    batch_samples_number = maximum_batch_samples_number;
+
+    batch.batch_size = batch_samples_number;
+
+    forward_propagation.set(batch_samples_number, neural_network_pointer, true);
+
+    const Index layers_number = forward_propagation.layers.size();
+
+    if(layers_number == 0) return;
+
+    outputs_dimensions = forward_propagation.layers(layers_number-1)->outputs(0).get_dimensions();
+}
+
+
+/// Returns the number of threads of the session, or 0 if the layers use their own threads.
+
+int InferenceSession::get_threads_number() const
+{
+    if(thread_pool_device == nullptr) return 0;
+
+    return thread_pool_device->numThreads();
+}
+
+
+/// Sets the number of threads which calculate the outputs of the session.
+/// While the session calculates outputs, the layers use these threads instead of theirs,
+/// and the OpenMP loops of the calling thread are limited to the same number, without modifying the neural network.
+/// A single thread calculates each call in the thread which makes it.
+/// @param new_threads_number Number of threads, or 0 to use the threads of the layers.
+
+void InferenceSession::set_threads_number(const int& new_threads_number)
+{
+    thread_pool_device.reset();
+    thread_pool.reset();
+
+    if(new_threads_number < 1) return;
+
+    thread_pool.reset(new ThreadPool(new_threads_number));
+    thread_pool_device.reset(new ThreadPoolDevice(thread_pool.get(), new_threads_number));
+}
+
+
+/// Sets the number of samples of the next calls, which must not be greater than the maximum one.
+/// The workspaces allocated for the maximum number of samples are reused, and only their dimensions change.
+/// @param new_batch_samples_number Number of samples of the next calls.
+
+void InferenceSession::set_batch_samples_number(const Index& new_batch_samples_number)
+{
+    batch_samples_number = new_batch_samples_number;
+
+    batch.batch_size = batch_samples_number;
+
+    forward_propagation.set_batch_samples_number(batch_samples_number);
+
+    const Index layers_number = forward_propagation.layers.size();
+
+    if(layers_number == 0) return;
+
+    outputs_dimensions = forward_propagation.layers(layers_number-1)->outputs(0).get_dimensions();
+}
+
+
+/// Calculates the outputs of the neural network for a batch of samples stored as a matrix.
+/// @param inputs_data Pointer to the inputs, a column-major matrix with a row for each sample.
+/// @param new_batch_samples_number Number of samples.
+/// @param outputs_data Pointer to the memory where the outputs are written, with room for the outputs of all the samples.
+
+void InferenceSession::calculate_outputs(type* inputs_data, const Index& new_batch_samples_number, type* outputs_data)
+{
+    if(neural_network_pointer == nullptr)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSession class.\n"
+               << "void calculate_outputs(type*, const Index&, type*) method.\n"
+               << "Neural network pointer is nullptr.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    inputs_dimensions(0) = new_batch_samples_number;
+    inputs_dimensions(1) = neural_network_pointer->get_inputs_number();
+
+    calculate_outputs(inputs_data, inputs_dimensions, outputs_data);
+}
+
+
+/// Calculates the outputs of the neural network for a batch of samples.
+/// The inputs are not copied, and the outputs of the last layer are written directly to the caller memory.
+/// @param inputs_data Pointer to the inputs, stored in column-major order.
+/// @param new_inputs_dimensions Dimensions of the inputs, the first one being the number of samples.
+/// @param outputs_data Pointer to the memory where the outputs are written, with room for the outputs of all the samples.
+
+void InferenceSession::calculate_outputs(type* inputs_data, const Tensor<Index, 1>& new_inputs_dimensions, type* outputs_data)
+{
+    if(neural_network_pointer == nullptr)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSession class.\n"
+               << "void calculate_outputs(type*, const Tensor<Index, 1>&, type*) method.\n"
+               << "Neural network pointer is nullptr.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    const Index new_batch_samples_number = new_inputs_dimensions(0);
+
+    if(new_batch_samples_number < 1 || new_batch_samples_number > maximum_batch_samples_number)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSession class.\n"
+               << "void calculate_outputs(type*, const Tensor<Index, 1>&, type*) method.\n"
+               << "Batch samples number (" << new_batch_samples_number << ") must be between 1 and " << maximum_batch_samples_number << ".\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    if(new_batch_samples_number != batch_samples_number) set_batch_samples_number(new_batch_samples_number);
+
+    const Index layers_number = forward_propagation.layers.size();
+
+    if(layers_number == 0) return;
+
+    batch.inputs(0).set_view(inputs_data, new_inputs_dimensions);
+
+    forward_propagation.layers(layers_number-1)->outputs(0).set_view(outputs_data, outputs_dimensions);
+
+    if(thread_pool_device == nullptr)
+    {
+        neural_network_pointer->forward_propagate_deploy(batch, forward_propagation);
+
+        return;
+    }
+
+    const CallingThreadDevice calling_thread_device(thread_pool_device.get());
+
+    neural_network_pointer->forward_propagate_deploy(batch, forward_propagation);
+}
+
+
+/// Default constructor.
+/// It creates an inference session pool without sessions.
+
+InferenceSessionPool::InferenceSessionPool()
+{
+}
+
+
+/// Neural network constructor.
+/// It creates a number of inference sessions for a neural network.
+/// @param new_neural_network_pointer Pointer to a neural network object.
+/// @param new_maximum_batch_samples_number Maximum number of samples of each call.
+/// @param new_sessions_number Number of calls which can run at the same time.
+
+InferenceSessionPool::InferenceSessionPool(NeuralNetwork* new_neural_network_pointer,
+                                           const Index& new_maximum_batch_samples_number,
+                                           const Index& new_sessions_number)
+{
+    set(new_neural_network_pointer, new_maximum_batch_samples_number, new_sessions_number);
+}
+
+
+/// Destructor.
+
+InferenceSessionPool::~InferenceSessionPool()
+{
+}
+
+
+/// Returns a pointer to the neural network shared by all the sessions.
+
+NeuralNetwork* InferenceSessionPool::get_neural_network_pointer() const
+{
+    return neural_network_pointer;
+}
+
+
+/// Returns the number of calls which can run at the same time.
+
+Index InferenceSessionPool::get_sessions_number() const
+{
+    return static_cast<Index>(sessions.size());
+}
+
+
+/// Creates the inference sessions of the pool.
+/// It must not be called while other threads are calculating outputs.
+/// If there are several sessions, each of them has a single thread.
+/// @param new_neural_network_pointer Pointer to a neural network object.
+/// @param new_maximum_batch_samples_number Maximum number of samples of each call.
+/// @param new_sessions_number Number of calls which can run at the same time.
+
+void InferenceSessionPool::set(NeuralNetwork* new_neural_network_pointer,
+                               const Index& new_maximum_batch_samples_number,
+                               const Index& new_sessions_number)
+{
+    if(new_sessions_number < 1)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSessionPool class.\n"
+               << "void set(NeuralNetwork*, const Index&, const Index&) method.\n"
+               << "Sessions number (" << new_sessions_number << ") must be greater than 0.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    lock_guard<mutex> lock(free_sessions_mutex);
+
+    neural_network_pointer = new_neural_network_pointer;
+
+    sessions.clear();
+    free_sessions.clear();
+
+    for(Index i = 0; i < new_sessions_number; i++)
+    {
+        sessions.push_back(unique_ptr<InferenceSession>(new InferenceSession(neural_network_pointer,
+                                                                             new_maximum_batch_samples_number)));
+
+        // Each call is calculated in the thread which makes it, instead of sharing the thread pools of the layers
+
+        if(new_sessions_number > 1) sessions.back()->set_threads_number(1);
+
+        free_sessions.push_back(sessions.back().get());
+    }
+}
+
+
+/// Calculates the outputs of the neural network for a batch of samples stored as a matrix.
+/// It can be called from many threads at the same time.
+/// @param inputs_data Pointer to the inputs, a column-major matrix with a row for each sample.
+/// @param batch_samples_number Number of samples.
+/// @param outputs_data Pointer to the memory where the outputs are written.
+
+void InferenceSessionPool::calculate_outputs(type* inputs_data, const Index& batch_samples_number, type* outputs_data)
+{
+    InferenceSession* inference_session = acquire_session();
+
+    try
+    {
+        inference_session->calculate_outputs(inputs_data, batch_samples_number, outputs_data);
+    }
+    catch(...)
+    {
+        release_session(inference_session);
+
+        throw;
+    }
+
+    release_session(inference_session);
+}
+
+
+/// Calculates the outputs of the neural network for a batch of samples.
+/// It can be called from many threads at the same time.
+/// @param inputs_data Pointer to the inputs, stored in column-major order.
+/// @param inputs_dimensions Dimensions of the inputs, the first one being the number of samples.
+/// @param outputs_data Pointer to the memory where the outputs are written.
+
+void InferenceSessionPool::calculate_outputs(type* inputs_data, const Tensor<Index, 1>& inputs_dimensions, type* outputs_data)
+{
+    InferenceSession* inference_session = acquire_session();
+
+    try
+    {
+        inference_session->calculate_outputs(inputs_data, inputs_dimensions, outputs_data);
+    }
+    catch(...)
+    {
+        release_session(inference_session);
+
+        throw;
+    }
+
+    release_session(inference_session);
+}
+
+
+/// Takes a session not in use, waiting until one is released if all of them are busy.
+
+InferenceSession* InferenceSessionPool::acquire_session()
+{
+    unique_lock<mutex> lock(free_sessions_mutex);
+
+    if(sessions.empty())
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: InferenceSessionPool class.\n"
+               << "InferenceSession* acquire_session() method.\n"
+               << "Inference session pool has no sessions.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    free_session_condition.wait(lock, [this]{return !free_sessions.empty();});
+
+    InferenceSession* inference_session = free_sessions.back();
+
+    free_sessions.pop_back();
+
+    return inference_session;
+}
+
+
+/// Gives back a session to the pool and wakes up a waiting call.
+
+void InferenceSessionPool::release_session(InferenceSession* inference_session)
+{
+    {
+        lock_guard<mutex> lock(free_sessions_mutex);
+
+        free_sessions.push_back(inference_session);
+    }
+
+    free_session_condition.notify_one();
+}
+
+}
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
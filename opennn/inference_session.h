@@ -0,0 +1,197 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   S E S S I O N   C L A S S   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef INFERENCESESSION_H
+#define INFERENCESESSION_H
+
+// System includes
+
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <vector>
+
+// OpenNN includes
+
+#include "config.h"
+#include "data_set.h"
+#include "neural_network.h"
+
+namespace opennn
+{
+
+/// This class calculates the outputs of a neural network repeatedly, without allocating memory on each call.
+
+///
+/// The forward propagation structures are allocated once, for a maximum batch size,
+/// and the layers outputs share a single buffer planned for inference.
+/// The inputs are read from, and the outputs are written to, memory provided by the caller, without copies.
+/// Calls with fewer samples reuse the same workspaces, whose dimensions are changed without allocating memory.
+/// A session can have its own threads, which the layers then use instead of theirs while it calculates outputs.
+/// A session must not be used by several threads at the same time.
+
+class InferenceSession
+{
+
+public:
+
+   // Constructors
+
+   explicit InferenceSession();
+
+   explicit InferenceSession(NeuralNetwork*, const Index&);
+
+   // Destructor
+
+   virtual ~InferenceSession();
+
+   // Get methods
+
+   NeuralNetwork* get_neural_network_pointer() const;
+
+   const Index& get_maximum_batch_samples_number() const;
+   const Index& get_batch_samples_number() const;
+
+   Index get_outputs_number() const;
+
+   int get_threads_number() const;
+
+   // Set methods
+
+   void set(NeuralNetwork*, const Index&);
+
+   void set_batch_samples_number(const Index&);
+
+   void set_threads_number(const int&);
+
+   // Outputs
+
+   void calculate_outputs(type*, const Index&, type*);
+
+   void calculate_outputs(type*, const Tensor<Index, 1>&, type*);
+
+protected:
+
+   /// Pointer to the neural network whose outputs are calculated.
+
+   NeuralNetwork* neural_network_pointer = nullptr;
+
+   /// Maximum number of samples of each call.
+
+   Index maximum_batch_samples_number = 0;
+
+   /// Number of samples of the current calls.
+
+   Index batch_samples_number = 0;
+
+   /// Batch whose inputs are views of the caller inputs.
+
+   DataSetBatch batch;
+
+   Tensor<Index, 1> inputs_dimensions;
+
+   Tensor<Index, 1> outputs_dimensions;
+
+   /// Preallocated forward propagation workspaces.
+
+   NeuralNetworkForwardPropagation forward_propagation;
+
+   /// Threads of the session, or nullptr if the layers use their own threads.
+
+   unique_ptr<ThreadPool> thread_pool;
+
+   unique_ptr<ThreadPoolDevice> thread_pool_device;
+};
+
+
+/// This class calculates the outputs of a single neural network from many threads at the same time.
+
+///
+/// The neural network is shared and only read, while each call borrows one of a pool of inference sessions,
+/// which hold all the state modified during the calculation, including the states of recurrent layers.
+/// A call waits when all the sessions are in use, so the number of sessions bounds the memory used.
+/// With several sessions, each session has a single thread, and the Eigen and OpenMP calculations of a call
+/// run in the thread which makes it, so that the throughput scales with the number of threads.
+/// The neural network is not modified.
+
+class InferenceSessionPool
+{
+
+public:
+
+   // Constructors
+
+   explicit InferenceSessionPool();
+
+   explicit InferenceSessionPool(NeuralNetwork*, const Index&, const Index&);
+
+   // Destructor
+
+   virtual ~InferenceSessionPool();
+
+   // Get methods
+
+   NeuralNetwork* get_neural_network_pointer() const;
+
+   Index get_sessions_number() const;
+
+   // Set methods
+
+   void set(NeuralNetwork*, const Index&, const Index&);
+
+   // Outputs
+
+   void calculate_outputs(type*, const Index&, type*);
+
+   void calculate_outputs(type*, const Tensor<Index, 1>&, type*);
+
+protected:
+
+   InferenceSession* acquire_session();
+
+   void release_session(InferenceSession*);
+
+   NeuralNetwork* neural_network_pointer = nullptr;
+
+   /// Execution contexts, one for each call which can run at the same time.
+
+   vector<unique_ptr<InferenceSession>> sessions;
+
+   /// Sessions not in use.
+
+   vector<InferenceSession*> free_sessions;
+
+   mutex free_sessions_mutex;
+
+   condition_variable free_session_condition;
+};
+
+}
+
+#endif
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
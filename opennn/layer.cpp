@@ -14,7 +14,7 @@ namespace opennn
 Layer::~Layer()
 {
     delete thread_pool;
-    delete thread_pool_device;
+    delete thread_pool_device.get_layer_device();
 }
 
 
@@ -70,6 +70,12 @@ string Layer::get_type_string() const
     case Type::NonMaxSuppression:
         return "NonMaxSuppression";
 
+    case Type::Addition:
+        return "Addition";
+
+    case Type::Concatenation:
+        return "Concatenation";
+
     default:
         return "Unkown type";
     }
@@ -79,13 +85,33 @@ string Layer::get_type_string() const
 void Layer::set_threads_number(const int& new_threads_number)
 {
     if(thread_pool != nullptr) delete thread_pool;
-    if(thread_pool_device != nullptr) delete thread_pool_device;
+    delete thread_pool_device.get_layer_device();
 
     thread_pool = new ThreadPool(new_threads_number);
     thread_pool_device = new ThreadPoolDevice(thread_pool, new_threads_number);
 }
 
 
+/// Returns true if the activation functions use fast approximations, and false if they are exact.
+
+const bool& Layer::get_fast_activations() const
+{
+    return fast_activations;
+}
+
+
+/// Sets the activation functions to fast approximations, or back to the exact ones.
+/// The approximations, whose maximum errors are listed in approximate_activations.h,
+/// are used by the logistic, hyperbolic tangent, softmax, soft plus and exponential linear functions,
+/// which then do not check the dimensions of their arguments.
+/// @param new_fast_activations True to use the approximations.
+
+void Layer::set_fast_activations(const bool& new_fast_activations)
+{
+    fast_activations = new_fast_activations;
+}
+
+
 void Layer::set_parameters_constant(const type&)
 {
 }
@@ -108,6 +134,38 @@ void Layer::set_parameters(const Tensor<type, 1>&, const Index&)
 }
 
 
+/// Appends the segments of the gradient, as pairs of first index and size, where the layer error gradient can be nonzero.
+/// Dense layers append all their parameters as a single segment.
+/// @param index Index of the first parameter of the layer in the gradient.
+/// @param gradient_segments Gradient segments of the whole neural network.
+
+void Layer::insert_gradient_segments(LayerBackPropagation*,
+                                     const Index& index,
+                                     vector<pair<Index, Index>>& gradient_segments) const
+{
+    const Index parameters_number = get_parameters_number();
+
+    if(parameters_number == 0) return;
+
+    gradient_segments.push_back(make_pair(index, parameters_number));
+}
+
+
+/// Sets the layer parameters which lie in the given segments of the parameters of the neural network.
+/// Dense layers set all their parameters.
+/// @param new_parameters Parameters of the whole neural network.
+/// @param index Index of the first parameter of the layer.
+
+void Layer::set_parameters_segments(const Tensor<type, 1>& new_parameters,
+                                    const Index& index,
+                                    const vector<pair<Index, Index>>&)
+{
+    if(get_parameters_number() == 0) return;
+
+    set_parameters(new_parameters, index);
+}
+
+
 Tensor< TensorMap< Tensor<type, 1>>*, 1> Layer::get_layer_parameters()
 {
     ostringstream buffer;
@@ -297,6 +355,13 @@ void Layer::linear_derivatives(type* combinations_data,
 
 void Layer::logistic(type* x_data, const Tensor<Index, 1>& x_dimensions, type* y_data, const Tensor<Index, 1>& y_dimensions) const
 {
+    if(fast_activations)
+    {
+        calculate_approximate_activations(x_data, x_dimensions, y_data, ApproximateLogistic());
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (x_dimensions== y_dimensions).all();
@@ -357,6 +422,22 @@ void Layer::logistic_derivatives(type* combinations_data, const Tensor<Index, 1>
                                  type* activations_data, const Tensor<Index, 1>& activations_dimensions,
                                  type* activations_derivatives_data, const Tensor<Index, 1>& activations_derivatives_dimensions) const
 {
+    if(fast_activations)
+    {
+        Index size = 1;
+
+        for(Index i = 0; i < combinations_dimensions.size(); i++) size *= combinations_dimensions(i);
+
+        calculate_approximate_activations(combinations_data, combinations_dimensions, activations_data, ApproximateLogistic());
+
+        const TensorMap<Tensor<type, 1>> activations(activations_data, size);
+        TensorMap<Tensor<type, 1>> activations_derivatives(activations_derivatives_data, size);
+
+        activations_derivatives.device(*thread_pool_device) = activations*(type(1) - activations);
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (combinations_dimensions == activations_dimensions).all();
@@ -696,6 +777,13 @@ void Layer::hard_sigmoid_derivatives(type* combinations_data,
 void Layer::hyperbolic_tangent(type* x_data, const Tensor<Index, 1>& x_dimensions,
                                type* y_data, const Tensor<Index, 1>& y_dimensions) const
 {
+    if(fast_activations)
+    {
+        calculate_approximate_activations(x_data, x_dimensions, y_data, ApproximateHyperbolicTangent());
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (x_dimensions== y_dimensions).all();
@@ -759,6 +847,22 @@ void Layer::hyperbolic_tangent_derivatives(type* combinations_data,
                                            type* activations_derivatives_data,
                                            const Tensor<Index, 1>& activations_derivatives_dimensions) const
 {
+    if(fast_activations)
+    {
+        Index size = 1;
+
+        for(Index i = 0; i < combinations_dimensions.size(); i++) size *= combinations_dimensions(i);
+
+        calculate_approximate_activations(combinations_data, combinations_dimensions, activations_data, ApproximateHyperbolicTangent());
+
+        const TensorMap<Tensor<type, 1>> activations(activations_data, size);
+        TensorMap<Tensor<type, 1>> activations_derivatives(activations_derivatives_data, size);
+
+        activations_derivatives.device(*thread_pool_device) = type(1) - activations.square();
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     if(combinations_dimensions.size() != activations_dimensions.size())
@@ -1240,9 +1344,9 @@ void Layer::scaled_exponential_linear(type* x_data, const Tensor<Index, 1>& x_di
 
     const Index rank = x_dimensions.size();
 
-    const type lambda = static_cast<type>(1.0507);
+    const type lambda = ScaledExponentialLinearActivation::lambda;
 
-    const type alpha = static_cast<type>(1.67326);
+    const type alpha = ScaledExponentialLinearActivation::alpha;
 
     if(rank == 1)
     {
@@ -1331,9 +1435,9 @@ void Layer::scaled_exponential_linear_derivatives(type* combinations_data, const
 
     const Index rank = combinations_dimensions.size();
 
-    const type lambda = static_cast<type>(1.0507);
+    const type lambda = ScaledExponentialLinearActivation::lambda;
 
-    const type alpha = static_cast<type>(1.67326);
+    const type alpha = ScaledExponentialLinearActivation::alpha;
 
     if(rank == 1)
     {
@@ -1437,6 +1541,13 @@ void Layer::scaled_exponential_linear_derivatives(type* combinations_data, const
 void Layer::soft_plus(type* x_data, const Tensor<Index, 1>& x_dimensions,
                       type* y_data, const Tensor<Index, 1>& y_dimensions) const
 {
+    if(fast_activations)
+    {
+        calculate_approximate_activations(x_data, x_dimensions, y_data, ApproximateSoftPlus());
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (x_dimensions== y_dimensions).all();
@@ -1497,6 +1608,17 @@ void Layer::soft_plus_derivatives(type* combinations_data,
                                   type* activations_derivatives_data,
                                   const Tensor<Index, 1>& activations_derivatives_dimensions) const
 {
+    if(fast_activations)
+    {
+        // Derivatives first, as the activations can overwrite the combinations
+
+        calculate_approximate_activations(combinations_data, combinations_dimensions, activations_derivatives_data, ApproximateLogistic());
+
+        calculate_approximate_activations(combinations_data, combinations_dimensions, activations_data, ApproximateSoftPlus());
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (combinations_dimensions == activations_dimensions).all();
@@ -1773,6 +1895,13 @@ void Layer::soft_sign_derivatives(type* combinations_data, const Tensor<Index, 1
 void Layer::exponential_linear(type* x_data, const Tensor<Index, 1>& x_dimensions,
                                type* y_data, const Tensor<Index, 1>& y_dimensions) const
 {
+    if(fast_activations)
+    {
+        calculate_approximate_activations(x_data, x_dimensions, y_data, ApproximateExponentialLinear());
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (x_dimensions== y_dimensions).all();
@@ -1862,6 +1991,28 @@ void Layer::exponential_linear_derivatives(type* combinations_data, const Tensor
                                  type* activations_data, const Tensor<Index, 1>& activations_dimensions,
                                  type* activations_derivatives_data, const Tensor<Index, 1>& activations_derivatives_dimensions) const
 {
+    if(fast_activations)
+    {
+        Index size = 1;
+
+        for(Index i = 0; i < combinations_dimensions.size(); i++) size *= combinations_dimensions(i);
+
+        // Derivatives first, as the activations can overwrite the combinations
+
+        const TensorMap<Tensor<type, 1>> combinations(combinations_data, size);
+        TensorMap<Tensor<type, 1>> activations(activations_data, size);
+        TensorMap<Tensor<type, 1>> activations_derivatives(activations_derivatives_data, size);
+
+        activations_derivatives.device(*thread_pool_device)
+                = (combinations < combinations.constant(type(0))).select(combinations.unaryExpr(ApproximateExponential()),
+                                                                         combinations.constant(type(1)));
+
+        activations.device(*thread_pool_device)
+                = (combinations < combinations.constant(type(0))).select(activations_derivatives - type(1), combinations);
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (combinations_dimensions == activations_dimensions).all();
@@ -1983,6 +2134,34 @@ void Layer::exponential_linear_derivatives(type* combinations_data, const Tensor
 void Layer::softmax(type* x_data, const Tensor<Index, 1>& x_dimensions,
                     type* y_data, const Tensor<Index, 1>& y_dimensions) const
 {
+    if(fast_activations && x_dimensions.size() == 2)
+    {
+        const Index rows_number = x_dimensions(0);
+        const Index columns_number = x_dimensions(1);
+
+        const TensorMap<Tensor<type, 2>> x(x_data, rows_number, columns_number);
+        TensorMap<Tensor<type, 2>> y(y_data, rows_number, columns_number);
+
+        const Eigen::array<Index, 1> columns_dimension({1});
+        const Eigen::array<Index, 2> rows_shape({rows_number, 1});
+        const Eigen::array<Index, 2> columns_broadcast({1, columns_number});
+
+        Tensor<type, 1> rows_maximum(rows_number);
+
+        rows_maximum.device(*thread_pool_device) = x.maximum(columns_dimension);
+
+        y.device(*thread_pool_device)
+                = (x - rows_maximum.reshape(rows_shape).broadcast(columns_broadcast)).unaryExpr(ApproximateExponential());
+
+        Tensor<type, 1> rows_sum(rows_number);
+
+        rows_sum.device(*thread_pool_device) = y.sum(columns_dimension);
+
+        divide_columns(thread_pool_device, y, rows_sum);
+
+        return;
+    }
+
     // Check equal sizes and ranks
 
     const Tensor<bool, 0> same_dimensions = (x_dimensions== y_dimensions).all();
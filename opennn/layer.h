@@ -28,6 +28,9 @@
 #include "dynamic_tensor.h"
 #include "statistics.h"
 #include "scaling.h"
+#include "approximate_activations.h"
+#include "activation_functions.h"
+#include "mixed_precision.h"
 //#include "data_set.h"
 
 #include <tuple>
@@ -46,6 +49,93 @@ struct LayerBackPropagationLM;
 #endif
 
 
+/// While an object of this class exists, the layers use its device in the calling thread instead of their own,
+/// and the OpenMP loops of the calling thread use its number of threads.
+/// Inference sessions use it so that concurrent calls on a shared neural network neither modify the layers
+/// nor share their thread pools.
+
+class CallingThreadDevice
+{
+
+public:
+
+    explicit CallingThreadDevice(ThreadPoolDevice* new_thread_pool_device)
+        : previous_thread_pool_device(get()), previous_threads_number(omp_get_max_threads())
+    {
+        get() = new_thread_pool_device;
+
+        omp_set_num_threads(new_thread_pool_device->numThreads());
+    }
+
+    ~CallingThreadDevice()
+    {
+        get() = previous_thread_pool_device;
+
+        omp_set_num_threads(previous_threads_number);
+    }
+
+    /// Returns the device of the calling thread, or nullptr if the layers use their own.
+
+    static ThreadPoolDevice*& get()
+    {
+        static thread_local ThreadPoolDevice* thread_pool_device = nullptr;
+
+        return thread_pool_device;
+    }
+
+private:
+
+    ThreadPoolDevice* previous_thread_pool_device = nullptr;
+
+    int previous_threads_number = 1;
+};
+
+
+/// Thread pool device of a layer, used as a pointer.
+/// It points to the device of the calling thread if there is one, and otherwise to the device owned by the layer.
+
+class LayerThreadPoolDevice
+{
+
+public:
+
+    LayerThreadPoolDevice& operator=(ThreadPoolDevice* new_thread_pool_device)
+    {
+        thread_pool_device = new_thread_pool_device;
+
+        return *this;
+    }
+
+    operator ThreadPoolDevice*() const
+    {
+        ThreadPoolDevice* calling_thread_device = CallingThreadDevice::get();
+
+        return calling_thread_device != nullptr ? calling_thread_device : thread_pool_device;
+    }
+
+    ThreadPoolDevice& operator*() const
+    {
+        return *static_cast<ThreadPoolDevice*>(*this);
+    }
+
+    ThreadPoolDevice* operator->() const
+    {
+        return static_cast<ThreadPoolDevice*>(*this);
+    }
+
+    /// Returns the device owned by the layer.
+
+    ThreadPoolDevice* get_layer_device() const
+    {
+        return thread_pool_device;
+    }
+
+private:
+
+    ThreadPoolDevice* thread_pool_device = nullptr;
+};
+
+
 /// This abstract class represents the concept of layer of neurons in OpenNN.
 
 /// A layer is a group of neurons having connections to the same inputs and sending outputs to the same destinations.
@@ -72,7 +162,9 @@ public:
                     RegionProposal,
                     NonMaxSuppression,
                     MultiheadAttention,
-                    Embedding};
+                    Embedding,
+                    Addition,
+                    Concatenation};
 
     // Constructor
 
@@ -134,8 +226,51 @@ public:
 
     void set_threads_number(const int&);
 
+    const bool& get_fast_activations() const;
+
+    void set_fast_activations(const bool&);
+
     virtual void insert_gradient(LayerBackPropagation*, const Index&, Tensor<type, 1>&) const {}
 
+    // Sparse gradient
+
+    /// Returns true if the error gradient of the layer is only nonzero at a few parameter segments.
+
+    virtual bool has_sparse_gradient() const {return false;}
+
+    virtual void insert_gradient_segments(LayerBackPropagation*, const Index&, vector<pair<Index, Index>>&) const;
+
+    virtual void set_parameters_segments(const Tensor<type, 1>&, const Index&, const vector<pair<Index, Index>>&);
+
+    // Quantization
+
+    /// Returns true if the layer can run inference with 8 bit integer weights.
+
+    virtual bool is_quantizable() const {return false;}
+
+    /// Returns true if the layer runs inference with 8 bit integer weights.
+
+    virtual bool is_quantized() const {return false;}
+
+    /// Quantizes the layer weights to 8 bit integers, given the maximum absolute value of the layer inputs.
+    /// The floating point weights are released.
+
+    virtual void quantize(const type&) {}
+
+    /// Returns the layer to floating point, with the weights dequantized from the quantized ones.
+
+    virtual void dequantize() {}
+
+    // Reduced precision
+
+    /// Returns the precision in which the layer stores its weights for inference.
+
+    virtual Precision get_weights_precision() const {return Precision::Single;}
+
+    /// Stores the layer weights for inference in a given precision, if the layer supports it.
+
+    virtual void set_weights_precision(const Precision&) {}
+
     // Outputs
 
     virtual void forward_propagate(const Tensor<DynamicTensor<type>, 1>&,
@@ -165,6 +300,16 @@ public:
                                           LayerForwardPropagation*,
                                           LayerBackPropagation*) const {}
 
+    /// Calculates the error gradient of a layer from all its inputs, as in neural networks whose layers form a graph.
+    /// Layers with a single input take the first one.
+
+    virtual void calculate_error_gradient(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                          LayerForwardPropagation* forward_propagation,
+                                          LayerBackPropagation* back_propagation) const
+    {
+        calculate_error_gradient(inputs(0).get_data(), forward_propagation, back_propagation);
+    }
+
     // Squared errors
 
     virtual void calculate_squared_errors_Jacobian_lm(const Tensor<type, 2>&,
@@ -202,7 +347,7 @@ public:
 protected:
 
     ThreadPool* thread_pool = nullptr;
-    ThreadPoolDevice* thread_pool_device = nullptr;
+    LayerThreadPoolDevice thread_pool_device;
 
     /// Layer name.
 
@@ -212,6 +357,11 @@ protected:
 
     Type layer_type;
 
+    /// True if the activation functions use the approximations in approximate_activations.h,
+    /// without checking the dimensions of their arguments.
+
+    bool fast_activations = false;
+
     /// Activation functions
 
     void binary(type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&) const;
@@ -244,6 +394,100 @@ protected:
     void symmetric_threshold_derivatives(type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&) const;
     void threshold_derivatives(type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&) const;
 
+    /// Applies an approximate activation function to all the elements of a tensor, without checks.
+    /// @param x_data Pointer to the combinations.
+    /// @param x_dimensions Dimensions of the combinations.
+    /// @param y_data Pointer to the activations, which can be the same as the combinations.
+    /// @param activation Approximate activation functor.
+
+    template<class Activation>
+    void calculate_approximate_activations(const type* x_data,
+                                           const Tensor<Index, 1>& x_dimensions,
+                                           type* y_data,
+                                           const Activation& activation) const
+    {
+        Index size = 1;
+
+        for(Index i = 0; i < x_dimensions.size(); i++) size *= x_dimensions(i);
+
+        const TensorMap<const Tensor<type, 1>> x(x_data, size);
+        TensorMap<Tensor<type, 1>> y(y_data, size);
+
+        y.device(*thread_pool_device) = x.unaryExpr(activation);
+    }
+
+    /// Adds a bias to each column of a column-major matrix and applies an element-wise activation, in a single pass.
+    /// The work is split into contiguous blocks of elements, with one dispatch to the thread pool.
+    /// @param biases_data Pointer to a bias for each column.
+    /// @param data Pointer to the matrix, overwritten with the activations.
+    /// @param rows_number Number of rows of the matrix.
+    /// @param columns_number Number of columns of the matrix.
+    /// @param activation Function which returns the activation of a combination.
+
+    template<class Activation>
+    void add_biases_activations(const type* biases_data,
+                                type* data,
+                                const Index& rows_number,
+                                const Index& columns_number,
+                                const Activation& activation) const
+    {
+        const TensorOpCost cost(sizeof(type), sizeof(type), 8);
+
+        thread_pool_device->parallelFor(rows_number*columns_number, cost, [&](Index first, Index last)
+        {
+            Index column_index = first/rows_number;
+            Index row_index = first - column_index*rows_number;
+
+            for(Index i = first; i < last; i++)
+            {
+                data[i] = activation(data[i] + biases_data[column_index]);
+
+                if(++row_index == rows_number)
+                {
+                    row_index = 0;
+                    column_index++;
+                }
+            }
+        });
+    }
+
+    /// Adds a bias to each column of a column-major matrix and applies an element-wise activation and its derivative,
+    /// in a single pass.
+    /// @param biases_data Pointer to a bias for each column.
+    /// @param data Pointer to the matrix, overwritten with the activations.
+    /// @param derivatives_data Pointer to the matrix where the activations derivatives are written.
+    /// @param rows_number Number of rows of the matrix.
+    /// @param columns_number Number of columns of the matrix.
+    /// @param activation_derivative Function which returns the activation of a combination and writes its derivative.
+
+    template<class ActivationDerivative>
+    void add_biases_activations_derivatives(const type* biases_data,
+                                            type* data,
+                                            type* derivatives_data,
+                                            const Index& rows_number,
+                                            const Index& columns_number,
+                                            const ActivationDerivative& activation_derivative) const
+    {
+        const TensorOpCost cost(sizeof(type), 2*sizeof(type), 10);
+
+        thread_pool_device->parallelFor(rows_number*columns_number, cost, [&](Index first, Index last)
+        {
+            Index column_index = first/rows_number;
+            Index row_index = first - column_index*rows_number;
+
+            for(Index i = first; i < last; i++)
+            {
+                data[i] = activation_derivative(data[i] + biases_data[column_index], derivatives_data[i]);
+
+                if(++row_index == rows_number)
+                {
+                    row_index = 0;
+                    column_index++;
+                }
+            }
+        });
+    }
+
     const Eigen::array<IndexPair<Index>, 1> A_BT = {IndexPair<Index>(1, 1)};
     const Eigen::array<IndexPair<Index>, 1> AT_B = {IndexPair<Index>(0, 0)};
     const Eigen::array<IndexPair<Index>, 1> A_B = {IndexPair<Index>(1, 0)};
@@ -276,11 +520,75 @@ struct LayerForwardPropagation
 
     virtual void print() const {}
 
+    /// Forgets the states kept between incremental forward propagations.
+
+    virtual void reset_states() {}
+
+    /// Returns the buffers which the layer only uses while it is being calculated, with the number of samples as first dimension.
+    /// An inference memory plan places them in the memory of other layers which are not being calculated at the same time.
+
+    virtual Tensor<DynamicTensor<type>*, 1> get_workspaces()
+    {
+        return Tensor<DynamicTensor<type>*, 1>();
+    }
+
+    /// Sets the dimensions of a buffer of the forward propagation.
+    /// An inference forward propagation does not allocate it, as the inference memory plan places it.
+    /// @param buffer Outputs or workspace.
+    /// @param new_dimensions Dimensions of the buffer.
+
+    void set_buffer_dimensions(DynamicTensor<type>& buffer, const Tensor<Index, 1>& new_dimensions) const
+    {
+        if(is_inference)
+        {
+            buffer.set_view(nullptr, new_dimensions);
+        }
+        else
+        {
+            buffer.set_dimensions(new_dimensions);
+        }
+    }
+
+    /// Changes the number of samples of the next inference forward propagations without allocating memory,
+    /// by reshaping the outputs and the workspaces, which must have been set for at least that number of samples.
+    /// The states of the previous sequences are forgotten.
+
+    virtual void set_batch_samples_number(const Index& new_batch_samples_number)
+    {
+        batch_samples_number = new_batch_samples_number;
+
+        const Tensor<DynamicTensor<type>*, 1> workspaces = get_workspaces();
+
+        for(Index i = 0; i < outputs.size() + workspaces.size(); i++)
+        {
+            DynamicTensor<type>& buffer = i < outputs.size() ? outputs(i) : *workspaces(i - outputs.size());
+
+            Tensor<Index, 1> buffer_dimensions = buffer.get_dimensions();
+
+            buffer_dimensions(0) = new_batch_samples_number;
+
+            buffer.reshape(buffer_dimensions);
+        }
+
+        reset_states();
+    }
+
     Index batch_samples_number;
 
     Layer* layer_pointer = nullptr;
 
     Tensor<DynamicTensor<type>, 1> outputs;
+
+    /// True if the forward propagation is only used for inference.
+    /// Then the outputs and the workspaces are placed by the inference memory plan instead of being allocated by the layer,
+    /// and the buffers which only the back propagation needs, as the activations derivatives, are not allocated.
+
+    bool is_inference = false;
+
+    /// True if each forward propagation continues the sequences of the previous one,
+    /// so that layers with states keep them instead of starting again.
+
+    bool is_incremental = false;
 };
 
 
@@ -107,6 +107,14 @@ const type& LevenbergMarquardtAlgorithm::get_maximum_damping_parameter() const
 }
 
 
+/// Returns true if the damped Hessian system is solved in double precision, and false otherwise.
+
+const bool& LevenbergMarquardtAlgorithm::get_double_precision() const
+{
+    return double_precision;
+}
+
+
 /// Sets the following default values for the Levenberg-Marquardt algorithm:
 /// Training parameters:
 /// <ul>
@@ -146,6 +154,8 @@ void LevenbergMarquardtAlgorithm::set_default()
 
     minimum_damping_parameter = static_cast<type>(1.0e-6);
     maximum_damping_parameter = static_cast<type>(1.0e6);
+
+    double_precision = false;
 }
 
 
@@ -241,6 +251,18 @@ void LevenbergMarquardtAlgorithm::set_maximum_damping_parameter(const type& new_
 }
 
 
+/// Sets whether the Levenberg-Marquardt steps are computed in double precision.
+/// The squared errors Jacobian is computed in the scalar type of the library.
+/// In double precision its products, the Hessian approximation and the gradient, are then accumulated, damped and solved in double,
+/// which is more accurate for ill conditioned fits, so that a float build can make double precision Levenberg-Marquardt steps.
+/// @param new_double_precision True to solve in double precision, false to solve in the library type.
+
+void LevenbergMarquardtAlgorithm::set_double_precision(const bool& new_double_precision)
+{
+    double_precision = new_double_precision;
+}
+
+
 /// Sets a new minimum loss improvement during training.
 /// @param new_minimum_loss_decrease Minimum improvement in the loss between two iterations.
 
@@ -450,6 +472,7 @@ TrainingResults LevenbergMarquardtAlgorithm::perform_training()
     Index selection_failures = 0;
 
     LossIndexBackPropagationLM training_back_propagation_lm(training_samples_number, loss_index_pointer);
+    training_back_propagation_lm.set_double_precision(double_precision);
     LossIndexBackPropagationLM selection_back_propagation_lm(selection_samples_number, loss_index_pointer);
 
     // Training strategy stuff
@@ -654,12 +677,32 @@ void LevenbergMarquardtAlgorithm::update_parameters(const DataSetBatch& batch,
 
     bool success = false;
 
+    if(double_precision)
+        optimization_data.gradient = back_propagation_lm.gradient_double*(-1.0);
+
     do
     {
-        sum_diagonal(back_propagation_lm.hessian, damping_parameter);
+        if(double_precision)
+        {
+            // The damping is added to a copy, so that the Hessian does not accumulate rounding errors from failed steps
+
+            optimization_data.damped_hessian = back_propagation_lm.hessian_double;
+
+            const Index parameters_number = optimization_data.damped_hessian.dimension(0);
 
-        optimization_data.parameters_increment
-                = perform_Householder_QR_decomposition(back_propagation_lm.hessian,(type(-1))*back_propagation_lm.gradient);
+            for(Index i = 0; i < parameters_number; i++)
+                optimization_data.damped_hessian(i, i) += double(damping_parameter);
+
+            optimization_data.parameters_increment
+                    = perform_Householder_QR_decomposition(optimization_data.damped_hessian, optimization_data.gradient).cast<type>();
+        }
+        else
+        {
+            sum_diagonal(back_propagation_lm.hessian, damping_parameter);
+
+            optimization_data.parameters_increment
+                    = perform_Householder_QR_decomposition(back_propagation_lm.hessian,(type(-1))*back_propagation_lm.gradient);
+        }
 
         optimization_data.potential_parameters.device(*thread_pool_device)
                 = back_propagation_lm.parameters + optimization_data.parameters_increment;
@@ -696,7 +739,7 @@ void LevenbergMarquardtAlgorithm::update_parameters(const DataSetBatch& batch,
         }
         else
         {
-            sum_diagonal(back_propagation_lm.hessian, -damping_parameter);
+            if(!double_precision) sum_diagonal(back_propagation_lm.hessian, -damping_parameter);
 
             set_damping_parameter(damping_parameter*damping_parameter_factor);
         }
@@ -756,6 +799,11 @@ Tensor<string, 2> LevenbergMarquardtAlgorithm::to_string_matrix() const
     labels_values(0,0) = "Damping parameter factor";
     labels_values(0,1) = to_string(double(damping_parameter_factor));
 
+    // Double precision
+
+    labels_values(1,0) = "Double precision";
+    labels_values(1,1) = double_precision ? "true" : "false";
+
     // Minimum loss decrease
 
     labels_values(2,0) = "Minimum loss decrease";
@@ -806,6 +854,17 @@ void LevenbergMarquardtAlgorithm::write_XML(tinyxml2::XMLPrinter& file_stream) c
 
     file_stream.CloseElement();
 
+    // Double precision
+
+    file_stream.OpenElement("DoublePrecision");
+
+    buffer.str("");
+    buffer << double_precision;
+
+    file_stream.PushText(buffer.str().c_str());
+
+    file_stream.CloseElement();
+
     // Minimum loss decrease
 
     file_stream.OpenElement("MinimumLossDecrease");
@@ -914,6 +973,17 @@ void LevenbergMarquardtAlgorithm::from_XML(const tinyxml2::XMLDocument& document
         }
     }
 
+    // Double precision
+
+    const tinyxml2::XMLElement* double_precision_element = root_element->FirstChildElement("DoublePrecision");
+
+    if(double_precision_element)
+    {
+        const string new_double_precision = double_precision_element->GetText();
+
+        set_double_precision(new_double_precision != "0");
+    }
+
     // Minimum loss decrease
 
     const tinyxml2::XMLElement* minimum_loss_decrease_element = root_element->FirstChildElement("MinimumLossDecrease");
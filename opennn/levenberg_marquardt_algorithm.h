@@ -76,6 +76,8 @@ public:
    const type& get_minimum_damping_parameter() const;
    const type& get_maximum_damping_parameter() const;
 
+   const bool& get_double_precision() const;
+
    // Set methods
 
    void set_default() override;
@@ -87,6 +89,8 @@ public:
    void set_minimum_damping_parameter(const type&);
    void set_maximum_damping_parameter(const type&);
 
+   void set_double_precision(const bool&);
+
    // Stopping criteria
 
    void set_minimum_loss_decrease(const type&);
@@ -139,6 +143,10 @@ private:
 
    type damping_parameter_factor;
 
+   /// True if the Hessian approximation and the gradient are accumulated from the Jacobian and solved in double precision, whatever the scalar type of the library.
+
+   bool double_precision = false;
+
    // Stopping criteria 
 
    /// Minimum loss improvement between two successive iterations. It is a stopping criterion.
@@ -210,6 +218,11 @@ struct LevenbergMarquardtAlgorithmData : public OptimizationAlgorithmData
 
     Tensor<type, 1> parameters_increment;
 
+    // Double precision data
+
+    Tensor<double, 2> damped_hessian;
+    Tensor<double, 1> gradient;
+
     // Loss index data
 
     type old_loss = type(0);
@@ -200,6 +200,15 @@ Index LongShortTermMemoryLayer::get_timesteps() const
 }
 
 
+/// Returns the number of timesteps through which the errors are back propagated,
+/// or zero if they are back propagated through the whole sequences.
+
+Index LongShortTermMemoryLayer::get_truncation_length() const
+{
+    return truncation_length;
+}
+
+
 /// Returns a single vector with all the layer parameters.
 /// The format is a vector of real values.
 /// The size is the number of parameters in the layer.
@@ -901,6 +910,17 @@ void LongShortTermMemoryLayer::set_timesteps(const Index& new_timesteps)
 }
 
 
+/// Sets the number of timesteps through which the errors are back propagated.
+/// The sequences are split into pieces of that length, and the errors are not back propagated from one piece to the previous one,
+/// while the hidden and cell states still are propagated forward through the whole sequences.
+/// @param new_truncation_length New truncation length, or zero to back propagate through the whole sequences.
+
+void LongShortTermMemoryLayer::set_truncation_length(const Index& new_truncation_length)
+{
+    truncation_length = new_truncation_length;
+}
+
+
 /// Sets a new display value.
 /// If it is set to true messages from this class are displayed on the screen;
 /// if it is set to false messages from this class are not displayed on the screen.
@@ -1204,6 +1224,7 @@ void LongShortTermMemoryLayer::calculate_combinations(type* inputs_data, const T
                                                       const Tensor<type, 2>& weights,
                                                       const Tensor<type, 2>& recurrent_weights,
                                                       const Tensor<type, 1>& biases,
+                                                      const Tensor<type, 1>& hidden_states,
                                                       type* combinations_data, const Tensor<Index, 1>& combinations_dimensions)
 {
 
@@ -1213,7 +1234,7 @@ void LongShortTermMemoryLayer::calculate_combinations(type* inputs_data, const T
         ostringstream buffer;
 
         buffer << "OpenNN Exception: LongShortTermMemoryLayer class.\n"
-               << "void calculate_combinations(type*, const Tensor<Index, 1>&, const Tensor<type, 2>&, const Tensor<type, 2>&, const Tensor<type, 1>&, type*, const Tensor<Index, 1>&) method"
+               << "void calculate_combinations(type*, const Tensor<Index, 1>&, const Tensor<type, 2>&, const Tensor<type, 2>&, const Tensor<type, 1>&, const Tensor<type, 1>&, type*, const Tensor<Index, 1>&) method"
                << "Inputs rank must be equal to 1.\n";
 
         throw invalid_argument(buffer.str());
@@ -1225,7 +1246,7 @@ void LongShortTermMemoryLayer::calculate_combinations(type* inputs_data, const T
         ostringstream buffer;
 
         buffer << "OpenNN Exception: LongShortTermMemoryLayer class.\n"
-               << "void calculate_combinations(type*, const Tensor<Index, 1>&, const Tensor<type, 2>&, const Tensor<type, 2>&, const Tensor<type, 1>&, type*, const Tensor<Index, 1>&) method"
+               << "void calculate_combinations(type*, const Tensor<Index, 1>&, const Tensor<type, 2>&, const Tensor<type, 2>&, const Tensor<type, 1>&, const Tensor<type, 1>&, type*, const Tensor<Index, 1>&) method"
                << "Inputs dimensions must be equal to inputs number, " << get_inputs_number() << ".\n";
 
         throw invalid_argument(buffer.str());
@@ -1627,483 +1648,327 @@ void LongShortTermMemoryLayer::forward_propagate(const Tensor<DynamicTensor<type
                                                  LayerForwardPropagation* forward_propagation,
                                                  const bool& is_training)
 {
-    LongShortTermMemoryLayerForwardPropagation* long_short_term_memory_layer_forward_propagation
-            = static_cast<LongShortTermMemoryLayerForwardPropagation*>(forward_propagation);
-
-    Tensor<Index, 1> inputs_dimensions = inputs(0).get_dimensions();
-
-    const Index samples_number = inputs_dimensions(0);
-    const Index neurons_number = get_neurons_number();
-
-    if(inputs_dimensions.size() != 2)
+    if(inputs(0).get_dimensions().size() != 2)
     {
         ostringstream buffer;
 
-        buffer << "OpenNN Exception: ProbabilisticLayer class.\n"
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, LayerForwardPropagation*) final.\n"
+        buffer << "OpenNN Exception: LongShortTermMemoryLayer class.\n"
+               << "void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, LayerForwardPropagation*, const bool&) final.\n"
                << "Inputs rank must be equal to 2.\n";
 
         throw invalid_argument(buffer.str());
     }
 
-    TensorMap<Tensor<type, 2>> inputs_map = inputs(0).to_tensor_map<2>();
-
-    const Tensor<Index, 1> outputs_dimensions = forward_propagation->outputs[0].get_dimensions();
-
-    Tensor<Index, 1> current_inputs_dimensions = get_dimensions(Tensor<Index, 1>(samples_number));
-    Tensor<Index, 1> current_outputs_dimensions = get_dimensions(Tensor<Index, 1>(neurons_number));
-
-    const TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
-
-    type* current_inputs_data = long_short_term_memory_layer_forward_propagation->current_inputs.data();
-    type* current_forget_combinations_data = long_short_term_memory_layer_forward_propagation->current_forget_combinations.data();
-    type* current_forget_activations_data =  long_short_term_memory_layer_forward_propagation->current_forget_activations.data();
-    type* current_forget_activations_derivatives_data =  long_short_term_memory_layer_forward_propagation->current_forget_activations_derivatives.data();
-    type* current_input_combinations_data = long_short_term_memory_layer_forward_propagation->current_input_combinations.data();
-    type* current_input_activations_data = long_short_term_memory_layer_forward_propagation->current_input_activations.data();
-    type* current_input_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->current_input_activations_derivatives.data();
-    type* current_state_combinations_data = long_short_term_memory_layer_forward_propagation->current_state_combinations.data();
-    type* current_state_activations_data = long_short_term_memory_layer_forward_propagation->current_state_activations.data();
-    type* current_state_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->current_state_activations_derivatives.data();
-    type* current_output_combinations_data = long_short_term_memory_layer_forward_propagation->current_output_combinations.data();
-    type* current_output_activations_data = long_short_term_memory_layer_forward_propagation->current_output_activations.data();
-    type* current_output_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->current_output_activations_derivatives.data();
-    type* cell_states_data = cell_states.data();
-    type* hidden_states_data = hidden_states.data();
-    type* current_hidden_states_derivatives_data = long_short_term_memory_layer_forward_propagation->current_hidden_states_derivatives.data();
-    type* forget_activations_data = long_short_term_memory_layer_forward_propagation->forget_activations.data();
-    type* forget_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->forget_activations_derivatives.data();
-    type* input_activations_data = long_short_term_memory_layer_forward_propagation->input_activations.data();
-    type* input_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->input_activations_derivatives.data();
-    type* state_activations_data = long_short_term_memory_layer_forward_propagation->state_activations.data();
-    type* state_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->state_activations_derivatives.data();
-    type* output_activations_data = long_short_term_memory_layer_forward_propagation->output_activations.data();
-    type* output_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->output_activations_derivatives.data();
-    type* cell_states_activations_data = long_short_term_memory_layer_forward_propagation->cell_states_activations.data();
-    type* hidden_states_activations_data = long_short_term_memory_layer_forward_propagation->hidden_states_activations.data();
-    type* hidden_states_activations_derivatives_data = long_short_term_memory_layer_forward_propagation->hidden_states_activations_derivatives.data();
-
-    Index copy_index = 0;
-
-    for(Index i = 0; i < samples_number; i++)
-    {
-        if(i%timesteps == 0)
-        {
-            hidden_states.setZero();
-            cell_states.setZero();
-        }
-
-        long_short_term_memory_layer_forward_propagation->current_inputs = inputs_map.chip(i,0);
-
-        current_inputs_dimensions.setValues(
-                    {long_short_term_memory_layer_forward_propagation->current_inputs.size()});
-
-        // f_t = σ(W_f * x_t + U_f * h_(t-1) + b_f)
-
-        calculate_combinations(current_inputs_data,
-                               current_inputs_dimensions,
-                               forget_weights,
-                               forget_recurrent_weights,
-                               forget_biases,
-                               current_forget_combinations_data,
-                               current_outputs_dimensions);
-
-        if(is_training)
-        {
-            calculate_recurrent_activations_derivatives(current_forget_combinations_data,
-                                                        current_outputs_dimensions,
-                                                        current_forget_activations_data,
-                                                        current_outputs_dimensions,
-                                                        current_forget_activations_derivatives_data,
-                                                        current_outputs_dimensions);
-        }
-        else
-        {
-            calculate_recurrent_activations(current_forget_combinations_data,
-                                  current_outputs_dimensions,
-                                  current_forget_activations_data,
-                                  current_outputs_dimensions);
-        }
-
-        // i_t = σ(W_i * x_t + U_i * h_(t-1) + b_i)
-
-        calculate_combinations(current_inputs_data,
-                               current_inputs_dimensions,
-                               input_weights,
-                               input_recurrent_weights,
-                               input_biases,
-                               current_input_combinations_data,
-                               current_outputs_dimensions);
-
-        if(is_training)
-        {
-            calculate_recurrent_activations_derivatives(current_input_combinations_data,
-                                                        current_outputs_dimensions,
-                                                        current_input_activations_data,
-                                                        current_outputs_dimensions,
-                                                        current_input_activations_derivatives_data,
-                                                        current_outputs_dimensions);
-        }
-        else
-        {
-            calculate_recurrent_activations(current_input_combinations_data,
-                                  current_outputs_dimensions,
-                                  current_input_activations_data,
-                                  current_outputs_dimensions);
-        }
-
-        // C~_t = tanh(W_C * x_t + U_C * h_(t-1) + b_C)
-
-        calculate_combinations(current_inputs_data,
-                               current_inputs_dimensions,
-                               state_weights,
-                               state_recurrent_weights,
-                               state_biases,
-                               current_state_combinations_data,
-                               current_outputs_dimensions);
-
-        if(is_training)
-        {
-            calculate_activations_derivatives(current_state_combinations_data,
-                                                        current_outputs_dimensions,
-                                                        current_state_activations_data,
-                                                        current_outputs_dimensions,
-                                                        current_state_activations_derivatives_data,
-                                                        current_outputs_dimensions);
-        }
-        else
-        {
-            calculate_activations(current_state_combinations_data,
-                                  current_outputs_dimensions,
-                                  current_state_activations_data,
-                                  current_outputs_dimensions);
-        }
-
-        // o_t = σ(W_o * x_t + U_o * h_(t-1) + b_o)
-
-        calculate_combinations(current_inputs_data,
-                               current_inputs_dimensions,
-                               output_weights,
-                               output_recurrent_weights,
-                               output_biases,
-                               current_output_combinations_data,
-                               current_outputs_dimensions);
-
-        if(is_training)
-        {
-            calculate_recurrent_activations_derivatives(current_output_combinations_data,
-                                                        current_outputs_dimensions,
-                                                        current_output_activations_data,
-                                                        current_outputs_dimensions,
-                                                        current_output_activations_derivatives_data,
-                                                        current_outputs_dimensions);
-        }
-        else
-        {
-            calculate_recurrent_activations(current_output_combinations_data,
-                                  current_outputs_dimensions,
-                                  current_output_activations_data,
-                                  current_outputs_dimensions);
-        }
-
-        // C_t = f_t * C_(t-1) + i_t * C~_t
-
-        cell_states = long_short_term_memory_layer_forward_propagation->current_forget_activations * cell_states +
-                long_short_term_memory_layer_forward_propagation->current_input_activations * long_short_term_memory_layer_forward_propagation->current_state_activations;
-
-        if(is_training)
-        {
+    LongShortTermMemoryLayerForwardPropagation* long_short_term_memory_layer_forward_propagation
+            = static_cast<LongShortTermMemoryLayerForwardPropagation*>(forward_propagation);
 
-            calculate_activations_derivatives(cell_states_data,
-                                              current_outputs_dimensions,
-                                              hidden_states_data,
-                                              current_outputs_dimensions,
-                                              current_hidden_states_derivatives_data,
-                                              current_outputs_dimensions);
-        }
-        else
-        {
-            calculate_activations(cell_states_data,
-                                  current_outputs_dimensions,
-                                  hidden_states_data,
-                                  current_outputs_dimensions);
-        }
+    const Index inputs_number = get_inputs_number();
+    const Index neurons_number = get_neurons_number();
 
-        // h_t = o_t * tanh(C_t)
+    Tensor<type, 1>& gates_biases = long_short_term_memory_layer_forward_propagation->gates_biases;
+    Tensor<type, 2>& gates_weights = long_short_term_memory_layer_forward_propagation->gates_weights;
+    Tensor<type, 2>& gates_recurrent_weights = long_short_term_memory_layer_forward_propagation->gates_recurrent_weights;
 
-        hidden_states *= long_short_term_memory_layer_forward_propagation->current_output_activations;
+    // Gates side by side, in the order forget, input, state and output
 
-        // Activations 2d
+    const Tensor<type, 1>* biases[4] = {&forget_biases, &input_biases, &state_biases, &output_biases};
+    const Tensor<type, 2>* weights[4] = {&forget_weights, &input_weights, &state_weights, &output_weights};
+    const Tensor<type, 2>* recurrent_weights[4]
+            = {&forget_recurrent_weights, &input_recurrent_weights, &state_recurrent_weights, &output_recurrent_weights};
 
-        #pragma omp parallel for
+    for(Index gate_index = 0; gate_index < 4; gate_index++)
+    {
+        copy(biases[gate_index]->data(),
+             biases[gate_index]->data() + neurons_number,
+             gates_biases.data() + gate_index*neurons_number);
 
-        for(Index j = 0; j < neurons_number; j++)
-            outputs(i,j) = hidden_states(j);
+        copy(weights[gate_index]->data(),
+             weights[gate_index]->data() + inputs_number*neurons_number,
+             gates_weights.data() + gate_index*inputs_number*neurons_number);
 
-        // Forget (activations and activations derivatives)
+        copy(recurrent_weights[gate_index]->data(),
+             recurrent_weights[gate_index]->data() + neurons_number*neurons_number,
+             gates_recurrent_weights.data() + gate_index*neurons_number*neurons_number);
+    }
 
-        copy(current_forget_activations_data,
-             current_forget_activations_data + neurons_number,
-             forget_activations_data + copy_index);
+    forward_propagate_sequences(inputs(0).to_tensor_map<2>(),
+                                TensorMap<Tensor<type, 1>>(gates_biases.data(), 4*neurons_number),
+                                TensorMap<Tensor<type, 2>>(gates_weights.data(), inputs_number, 4*neurons_number),
+                                TensorMap<Tensor<type, 2>>(gates_recurrent_weights.data(), neurons_number, 4*neurons_number),
+                                long_short_term_memory_layer_forward_propagation,
+                                is_training);
+}
 
-        copy(current_forget_activations_derivatives_data,
-             current_forget_activations_derivatives_data + neurons_number,
-             forget_activations_derivatives_data + copy_index);
 
-        // Input (activations and activations derivatives)
+/// Calculates the outputs of the layer with the given parameters, together with the activations derivatives.
+/// The parameters are ordered as in get_parameters(), where the biases, weights and recurrent weights of the four gates
+/// are already side by side, and they are kept in the forward propagation for the back propagation.
 
-        copy(current_input_activations_data,
-             current_input_activations_data + neurons_number,
-             input_activations_data + copy_index);
+void LongShortTermMemoryLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs, Tensor<type, 1>& parameters, LayerForwardPropagation* forward_propagation)
+{
+    if(inputs(0).get_dimensions().size() != 2)
+    {
+        ostringstream buffer;
 
-        copy(current_input_activations_derivatives_data,
-             current_input_activations_derivatives_data + neurons_number,
-             input_activations_derivatives_data + copy_index);
+        buffer << "OpenNN Exception: LongShortTermMemoryLayer class.\n"
+               << "void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final.\n"
+               << "Inputs rank must be equal to 2.\n";
 
-        // State (activations and activations derivatives)
+        throw invalid_argument(buffer.str());
+    }
 
-        copy(current_state_activations_data,
-             current_state_activations_data + neurons_number,
-             state_activations_data + copy_index);
+    LongShortTermMemoryLayerForwardPropagation* long_short_term_memory_layer_forward_propagation
+            = static_cast<LongShortTermMemoryLayerForwardPropagation*>(forward_propagation);
 
-        copy(current_state_activations_derivatives_data,
-             current_state_activations_derivatives_data + neurons_number,
-             state_activations_derivatives_data + copy_index);
+    const Index inputs_number = get_inputs_number();
+    const Index neurons_number = get_neurons_number();
 
-        // Output (activations and activations derivatives)
+    // The gates are side by side in the parameters
 
-        copy(current_output_activations_data,
-             current_output_activations_data + neurons_number,
-             output_activations_data + copy_index);
+    Tensor<type, 1>& gates_biases = long_short_term_memory_layer_forward_propagation->gates_biases;
+    Tensor<type, 2>& gates_weights = long_short_term_memory_layer_forward_propagation->gates_weights;
+    Tensor<type, 2>& gates_recurrent_weights = long_short_term_memory_layer_forward_propagation->gates_recurrent_weights;
 
-        copy(current_output_activations_derivatives_data,
-             current_output_activations_derivatives_data + neurons_number,
-             output_activations_derivatives_data + copy_index);
+    const type* parameters_data = parameters.data();
 
-        // Cell states (activations)
+    copy(parameters_data, parameters_data + gates_biases.size(), gates_biases.data());
 
-        copy(cell_states_data,
-             cell_states_data + neurons_number,
-             cell_states_activations_data + copy_index);
+    parameters_data += gates_biases.size();
 
-        // Hidden states (activations and activations derivatives)
+    copy(parameters_data, parameters_data + gates_weights.size(), gates_weights.data());
 
-        copy(hidden_states_data,
-             hidden_states_data + neurons_number,
-             hidden_states_activations_data + copy_index);
+    parameters_data += gates_weights.size();
 
-        copy(current_hidden_states_derivatives_data,
-             current_hidden_states_derivatives_data + neurons_number,
-             hidden_states_activations_derivatives_data + copy_index);
+    copy(parameters_data, parameters_data + gates_recurrent_weights.size(), gates_recurrent_weights.data());
 
-        copy_index += neurons_number;
-    }
+    forward_propagate_sequences(inputs(0).to_tensor_map<2>(),
+                                TensorMap<Tensor<type, 1>>(gates_biases.data(), 4*neurons_number),
+                                TensorMap<Tensor<type, 2>>(gates_weights.data(), inputs_number, 4*neurons_number),
+                                TensorMap<Tensor<type, 2>>(gates_recurrent_weights.data(), neurons_number, 4*neurons_number),
+                                long_short_term_memory_layer_forward_propagation,
+                                true);
 }
 
 
-//remove?
-void LongShortTermMemoryLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs, Tensor<type, 1>& parameters, LayerForwardPropagation* forward_propagation)
+/// Calculates the outputs of the layer for a batch of sequences.
+/// The samples of the batch are consecutive sequences of timesteps samples, and the last one might be shorter.
+/// In an incremental forward propagation, each sample is instead the next timestep of its own sequence,
+/// which starts from the hidden and cell states of the previous forward propagation.
+/// The inputs of all the samples are combined with the weights of the four gates in a single matrix product.
+/// Then, for each timestep, the hidden states of all the sequences are combined with the recurrent weights
+/// of the four gates in a single matrix product, instead of four vector products for each sample.
+/// @param inputs Inputs of the batch, with a row for each sample.
+/// @param gates_biases Forget, input, state and output biases, one after the other.
+/// @param gates_weights Forget, input, state and output weights, side by side.
+/// @param gates_recurrent_weights Forget, input, state and output recurrent weights, side by side.
+/// @param forward_propagation Forward propagation of the layer, where the outputs and the activations are written.
+/// @param is_training True to write the activations derivatives too.
+
+void LongShortTermMemoryLayer::forward_propagate_sequences(const TensorMap<Tensor<type, 2>>& inputs,
+                                                           const TensorMap<Tensor<type, 1>>& gates_biases,
+                                                           const TensorMap<Tensor<type, 2>>& gates_weights,
+                                                           const TensorMap<Tensor<type, 2>>& gates_recurrent_weights,
+                                                           LongShortTermMemoryLayerForwardPropagation* forward_propagation,
+                                                           const bool& is_training)
 {
+    const Index samples_number = inputs.dimension(0);
+    const Index neurons_number = get_neurons_number();
 
-    if(inputs(0).get_dimensions().size() != 2)
-    {
-        ostringstream buffer;
+    const Index sequence_timesteps = forward_propagation->is_incremental ? 1 : timesteps;
 
-        buffer << "OpenNN Exception: ProbabilisticLayer class.\n"
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final.\n"
-               << "Inputs rank must be equal to 2.\n";
+    const Index sequences_number = (samples_number + sequence_timesteps - 1)/sequence_timesteps;
 
-        throw invalid_argument(buffer.str());
+    if(forward_propagation->hidden_states.dimension(0) != sequences_number)
+    {
+        forward_propagation->set_sequences_number(sequences_number);
     }
 
+    Tensor<type, 2>& hidden_states = forward_propagation->hidden_states;
+    Tensor<type, 2>& cell_states = forward_propagation->cell_states;
 
-    LongShortTermMemoryLayerForwardPropagation* long_short_term_memory_layer_forward_propagation
-            = static_cast<LongShortTermMemoryLayerForwardPropagation*>(forward_propagation);
-
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
+    TensorMap<Tensor<type, 2>> gates_combinations = forward_propagation->gates_combinations.to_tensor_map<2>();
 
-    const TensorMap<Tensor<type, 1>> forget_biases(parameters.data(), neurons_number);
-    const TensorMap<Tensor<type, 1>> input_biases(parameters.data()+neurons_number, neurons_number);
-    const TensorMap<Tensor<type, 1>> state_biases(parameters.data()+2*neurons_number, neurons_number);
-    const TensorMap<Tensor<type, 1>> output_biases(parameters.data()+3*neurons_number, neurons_number);
+    Tensor<type, 2>& current_gates_combinations = forward_propagation->current_gates_combinations;
+    Tensor<type, 2>& current_gates_activations = forward_propagation->current_gates_activations;
+    Tensor<type, 2>& current_gates_activations_derivatives = forward_propagation->current_gates_activations_derivatives;
 
-    const TensorMap<Tensor<type, 2>> forget_weights(parameters.data()+4*neurons_number, inputs_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> input_weights(parameters.data()+4*neurons_number+inputs_number*neurons_number, inputs_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> state_weights(parameters.data()+4*neurons_number+2*inputs_number*neurons_number, inputs_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> output_weights(parameters.data()+4*neurons_number+3*inputs_number*neurons_number, inputs_number, neurons_number);
+    Tensor<type, 2>& current_activated_cell_states = forward_propagation->current_activated_cell_states;
+    Tensor<type, 2>& current_hidden_states_activations_derivatives = forward_propagation->current_hidden_states_activations_derivatives;
 
-    const TensorMap<Tensor<type, 2>> forget_recurrent_weights(parameters.data()+4*neurons_number+4*inputs_number*neurons_number, neurons_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> input_recurrent_weights(parameters.data()+4*neurons_number+4*inputs_number*neurons_number+neurons_number*neurons_number, neurons_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> state_recurrent_weights(parameters.data()+4*neurons_number+4*inputs_number*neurons_number+2*neurons_number*neurons_number, neurons_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> output_recurrent_weights(parameters.data()+4*neurons_number+4*inputs_number*neurons_number+3*neurons_number*neurons_number, neurons_number, neurons_number);
+    // Inputs combinations of all the samples and gates
 
-    const Index samples_number = inputs(0).get_dimension(0);
+    gates_combinations.device(*thread_pool_device) = inputs.contract(gates_weights, A_B);
 
-    TensorMap<Tensor<type, 2>> inputs_map = inputs(0).to_tensor_map<2>();
+    add_biases_activations(gates_biases.data(), gates_combinations.data(), samples_number, 4*neurons_number, LinearActivation());
 
-    const Tensor<Index, 1> outputs_dimensions = forward_propagation->outputs[0].get_dimensions();
+    // Gates of the current timestep, with one row for each sequence
 
-    TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
+    const Tensor<Index, 1> gate_dimensions = get_dimensions(hidden_states);
 
-    Tensor<type, 1> forget_combinations(neurons_number);
-    Tensor<type, 1> input_combinations(neurons_number);
-    Tensor<type, 1> state_combinations(neurons_number);
-    Tensor<type, 1> output_combinations(neurons_number);
+    const Index gate_size = sequences_number*neurons_number;
 
-    Tensor<type, 1> forget_activations(neurons_number);
-    Tensor<type, 1> input_activations(neurons_number);
-    Tensor<type, 1> state_activations(neurons_number);
-    Tensor<type, 1> output_activations(neurons_number);
+    type* forget_combinations_data = current_gates_combinations.data();
+    type* input_combinations_data = forget_combinations_data + gate_size;
+    type* state_combinations_data = input_combinations_data + gate_size;
+    type* output_combinations_data = state_combinations_data + gate_size;
 
-    Tensor<type, 1> forget_activations_derivatives(neurons_number);
-    Tensor<type, 1> input_activations_derivatives(neurons_number);
-    Tensor<type, 1> state_activations_derivatives(neurons_number);
-    Tensor<type, 1> output_activations_derivatives(neurons_number);
+    const TensorMap<Tensor<type, 2>> forget_activations(current_gates_activations.data(), sequences_number, neurons_number);
+    const TensorMap<Tensor<type, 2>> input_activations(current_gates_activations.data() + gate_size, sequences_number, neurons_number);
+    const TensorMap<Tensor<type, 2>> state_activations(current_gates_activations.data() + 2*gate_size, sequences_number, neurons_number);
+    const TensorMap<Tensor<type, 2>> output_activations(current_gates_activations.data() + 3*gate_size, sequences_number, neurons_number);
 
-    Tensor<type, 1> hidden_states_derivatives(neurons_number);
+    TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
 
-    Tensor<Index, 1> current_inputs_dimensions;
-    Tensor<Index, 1> combinations_dimensions;
-    Tensor<Index, 1> activations_dimensions;
-    Tensor<Index, 1> derivatives_dimensions;
+    Tensor<type, 2, RowMajor>* activations[7] = {&forward_propagation->forget_activations,
+                                                 &forward_propagation->input_activations,
+                                                 &forward_propagation->state_activations,
+                                                 &forward_propagation->output_activations,
+                                                 &forward_propagation->cell_states_activations,
+                                                 &forward_propagation->activated_cell_states,
+                                                 &forward_propagation->hidden_states_activations};
 
-    Index copy_index = 0;
+    Tensor<type, 2, RowMajor>* activations_derivatives[5] = {&forward_propagation->forget_activations_derivatives,
+                                                             &forward_propagation->input_activations_derivatives,
+                                                             &forward_propagation->state_activations_derivatives,
+                                                             &forward_propagation->output_activations_derivatives,
+                                                             &forward_propagation->hidden_states_activations_derivatives};
 
-    for(Index i = 0; i < samples_number; i++)
+    if(!forward_propagation->is_incremental)
     {
-        if(i%timesteps == 0)
-        {
-            hidden_states.setZero();
-            cell_states.setZero();
-        }
-
-        Tensor<type, 1> current_inputs = inputs_map.chip(i,0);
-        current_inputs_dimensions = get_dimensions(current_inputs);
-
-        combinations_dimensions = get_dimensions(forget_combinations);
-        activations_dimensions = get_dimensions(forget_activations);
-        derivatives_dimensions = get_dimensions(forget_activations_derivatives);
-
-        calculate_combinations(current_inputs.data(), current_inputs_dimensions, forget_weights, forget_recurrent_weights, forget_biases, forget_combinations.data(), combinations_dimensions);
-        calculate_recurrent_activations_derivatives(forget_combinations.data(),
-                                                    combinations_dimensions,
-                                                    forget_activations.data(),
-                                                    activations_dimensions,
-                                                    forget_activations_derivatives.data(),
-                                                    derivatives_dimensions);
-
-        combinations_dimensions = get_dimensions(input_combinations);
-        activations_dimensions = get_dimensions(input_activations);
-        derivatives_dimensions = get_dimensions(input_activations_derivatives);
+        hidden_states.setZero();
+        cell_states.setZero();
+    }
 
-        calculate_combinations(current_inputs.data(), current_inputs_dimensions, input_weights, input_recurrent_weights, input_biases, input_combinations.data(), combinations_dimensions);
-        calculate_recurrent_activations_derivatives(input_combinations.data(),
-                                                    combinations_dimensions,
-                                                    input_activations.data(),
-                                                    activations_dimensions,
-                                                    input_activations_derivatives.data(),
-                                                    derivatives_dimensions);
+    for(Index timestep = 0; timestep < sequence_timesteps; timestep++)
+    {
+        // The last sequence might not have this timestep
 
-        combinations_dimensions = get_dimensions(state_combinations);
-        activations_dimensions = get_dimensions(state_activations);
-        derivatives_dimensions = get_dimensions(state_activations_derivatives);
+        const Index current_sequences_number = (samples_number - timestep + sequence_timesteps - 1)/sequence_timesteps;
 
-        calculate_combinations(current_inputs.data(), current_inputs_dimensions, state_weights, state_recurrent_weights, state_biases, state_combinations.data(), combinations_dimensions);
-        calculate_recurrent_activations_derivatives(state_combinations.data(),
-                                                    combinations_dimensions,
-                                                    state_activations.data(),
-                                                    activations_dimensions,
-                                                    state_activations_derivatives.data(),
-                                                    derivatives_dimensions);
+        if(current_sequences_number <= 0) break;
 
-        combinations_dimensions = get_dimensions(output_combinations);
-        activations_dimensions = get_dimensions(output_activations);
-        derivatives_dimensions = get_dimensions(output_activations_derivatives);
+        // Combinations
 
-        calculate_combinations(current_inputs.data(), current_inputs_dimensions, output_weights, output_recurrent_weights, output_biases, output_combinations.data(), combinations_dimensions);
-        calculate_recurrent_activations_derivatives(output_combinations.data(),
-                                                    combinations_dimensions,
-                                                    output_activations.data(),
-                                                    activations_dimensions,
-                                                    output_activations_derivatives.data(),
-                                                    derivatives_dimensions);
+        if(timestep == 0 && !forward_propagation->is_incremental)
+        {
+            current_gates_combinations.setZero();
+        }
+        else
+        {
+            current_gates_combinations.device(*thread_pool_device) = hidden_states.contract(gates_recurrent_weights, A_B);
+        }
 
-        combinations_dimensions = get_dimensions(cell_states);
-        activations_dimensions = get_dimensions(hidden_states);
-        derivatives_dimensions = get_dimensions(hidden_states_derivatives);
+        for(Index column_index = 0; column_index < 4*neurons_number; column_index++)
+        {
+            const type* sample_combinations = gates_combinations.data() + column_index*samples_number + timestep;
 
-        cell_states = forget_activations * cell_states + input_activations * state_activations;
-        calculate_activations_derivatives(cell_states.data(),
-                                          combinations_dimensions,
-                                          hidden_states.data(),
-                                          activations_dimensions,
-                                          hidden_states_derivatives.data(),
-                                          derivatives_dimensions);
+            type* sequence_combinations = current_gates_combinations.data() + column_index*sequences_number;
 
-        hidden_states *= output_activations;
+            for(Index sequence_index = 0; sequence_index < current_sequences_number; sequence_index++)
+            {
+                sequence_combinations[sequence_index] += sample_combinations[sequence_index*sequence_timesteps];
+            }
+        }
 
-        // Activations 2d
+        // Activations
 
-        for(Index j = 0; j < neurons_number; j++) outputs(i,j) = hidden_states(j);
+        // f_t = σ(W_f * x_t + U_f * h_(t-1) + b_f)
+        // i_t = σ(W_i * x_t + U_i * h_(t-1) + b_i)
+        // C~_t = tanh(W_C * x_t + U_C * h_(t-1) + b_C)
+        // o_t = σ(W_o * x_t + U_o * h_(t-1) + b_o)
 
-        // Forget (activations and activations derivatives)
+        type* combinations_data[4] = {forget_combinations_data, input_combinations_data, state_combinations_data, output_combinations_data};
 
-        copy(long_short_term_memory_layer_forward_propagation->current_forget_activations.data(),
-             long_short_term_memory_layer_forward_propagation->current_forget_activations.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->forget_activations.data() + copy_index);
+        for(Index gate_index = 0; gate_index < 4; gate_index++)
+        {
+            type* gate_activations_data = current_gates_activations.data() + gate_index*gate_size;
+            type* gate_activations_derivatives_data = current_gates_activations_derivatives.data() + gate_index*gate_size;
 
-        copy(long_short_term_memory_layer_forward_propagation->current_forget_activations_derivatives.data(),
-             long_short_term_memory_layer_forward_propagation->current_forget_activations_derivatives.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->forget_activations_derivatives.data() + copy_index);
+            if(gate_index == 2)
+            {
+                if(is_training)
+                    calculate_activations_derivatives(combinations_data[gate_index], gate_dimensions,
+                                                      gate_activations_data, gate_dimensions,
+                                                      gate_activations_derivatives_data, gate_dimensions);
+                else
+                    calculate_activations(combinations_data[gate_index], gate_dimensions,
+                                          gate_activations_data, gate_dimensions);
+            }
+            else
+            {
+                if(is_training)
+                    calculate_recurrent_activations_derivatives(combinations_data[gate_index], gate_dimensions,
+                                                                gate_activations_data, gate_dimensions,
+                                                                gate_activations_derivatives_data, gate_dimensions);
+                else
+                    calculate_recurrent_activations(combinations_data[gate_index], gate_dimensions,
+                                                    gate_activations_data, gate_dimensions);
+            }
+        }
 
-        // Input (activations and activations derivatives)
+        // C_t = f_t * C_(t-1) + i_t * C~_t
 
-        copy(long_short_term_memory_layer_forward_propagation->current_input_activations.data(),
-             long_short_term_memory_layer_forward_propagation->current_input_activations.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->input_activations.data() + copy_index);
+        cell_states.device(*thread_pool_device) = forget_activations*cell_states + input_activations*state_activations;
 
-        copy(long_short_term_memory_layer_forward_propagation->current_input_activations_derivatives.data(),
-             long_short_term_memory_layer_forward_propagation->current_input_activations_derivatives.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->input_activations_derivatives.data() + copy_index);
+        // h_t = o_t * tanh(C_t)
 
-        // State (activations and activations derivatives)
+        if(is_training)
+            calculate_activations_derivatives(cell_states.data(), gate_dimensions,
+                                              current_activated_cell_states.data(), gate_dimensions,
+                                              current_hidden_states_activations_derivatives.data(), gate_dimensions);
+        else
+            calculate_activations(cell_states.data(), gate_dimensions,
+                                  current_activated_cell_states.data(), gate_dimensions);
 
-        copy(long_short_term_memory_layer_forward_propagation->current_state_activations.data(),
-             long_short_term_memory_layer_forward_propagation->current_state_activations.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->state_activations.data() + copy_index);
+        hidden_states.device(*thread_pool_device) = current_activated_cell_states*output_activations;
 
-        copy(long_short_term_memory_layer_forward_propagation->current_state_activations_derivatives.data(),
-             long_short_term_memory_layer_forward_propagation->current_state_activations_derivatives.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->state_activations_derivatives.data() + copy_index);
+        // Outputs, activations and activations derivatives of the samples of this timestep
 
-        // Output (activations and activations derivatives)
+        const type* sequences_activations[7] = {current_gates_activations.data(),
+                                                current_gates_activations.data() + gate_size,
+                                                current_gates_activations.data() + 2*gate_size,
+                                                current_gates_activations.data() + 3*gate_size,
+                                                cell_states.data(),
+                                                current_activated_cell_states.data(),
+                                                hidden_states.data()};
 
-        copy(long_short_term_memory_layer_forward_propagation->current_output_activations.data(),
-             long_short_term_memory_layer_forward_propagation->current_output_activations.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->output_activations.data() + copy_index);
+        const type* sequences_activations_derivatives[5] = {current_gates_activations_derivatives.data(),
+                                                            current_gates_activations_derivatives.data() + gate_size,
+                                                            current_gates_activations_derivatives.data() + 2*gate_size,
+                                                            current_gates_activations_derivatives.data() + 3*gate_size,
+                                                            current_hidden_states_activations_derivatives.data()};
 
-        copy(long_short_term_memory_layer_forward_propagation->current_output_activations_derivatives.data(),
-             long_short_term_memory_layer_forward_propagation->current_output_activations_derivatives.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->output_activations_derivatives.data() + copy_index);
+        for(Index sequence_index = 0; sequence_index < current_sequences_number; sequence_index++)
+        {
+            const Index sample_index = sequence_index*sequence_timesteps + timestep;
 
-        // Cell states (activations)
+            for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
+            {
+                outputs(sample_index, neuron_index) = hidden_states(sequence_index, neuron_index);
+            }
 
-        copy(cell_states.data(),
-             cell_states.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->cell_states_activations.data() + copy_index);
+            if(!is_training) continue;
 
-        // Hidden states (activations and activations derivatives)
+            for(Index i = 0; i < 7; i++)
+            {
+                type* sample_activations = activations[i]->data() + sample_index*neurons_number;
 
-        copy(hidden_states.data(),
-             hidden_states.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->hidden_states_activations.data() + copy_index);
+                for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
+                {
+                    sample_activations[neuron_index] = sequences_activations[i][sequence_index + neuron_index*sequences_number];
+                }
+            }
 
-        copy(long_short_term_memory_layer_forward_propagation->current_hidden_states_derivatives.data(),
-             long_short_term_memory_layer_forward_propagation->current_hidden_states_derivatives.data() + neurons_number,
-             long_short_term_memory_layer_forward_propagation->hidden_states_activations_derivatives.data() + copy_index);
+            for(Index i = 0; i < 5; i++)
+            {
+                type* sample_activations_derivatives = activations_derivatives[i]->data() + sample_index*neurons_number;
 
-        copy_index += neurons_number;
+                for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
+                {
+                    sample_activations_derivatives[neuron_index] = sequences_activations_derivatives[i][sequence_index + neuron_index*sequences_number];
+                }
+            }
+        }
     }
 }
 
@@ -2112,74 +1977,54 @@ void LongShortTermMemoryLayer::insert_gradient(LayerBackPropagation* back_propag
                                                const Index& index,
                                                Tensor<type, 1>& gradient) const
 {
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
-
     LongShortTermMemoryLayerBackPropagation* long_short_term_memory_layer_back_propagation =
             static_cast<LongShortTermMemoryLayerBackPropagation*>(back_propagation);
 
-    // Biases
-
-    copy(long_short_term_memory_layer_back_propagation->forget_biases_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->forget_biases_derivatives.data() + neurons_number,
-         gradient.data() + index);
-
-    copy(long_short_term_memory_layer_back_propagation->input_biases_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->input_biases_derivatives.data() + neurons_number,
-         gradient.data() + index + neurons_number);
-
-    copy(long_short_term_memory_layer_back_propagation->state_biases_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->state_biases_derivatives.data() + neurons_number,
-         gradient.data() + index + 2*neurons_number);
+    const Tensor<type, 1>& gates_biases_derivatives = long_short_term_memory_layer_back_propagation->gates_biases_derivatives;
+    const Tensor<type, 2>& gates_weights_derivatives = long_short_term_memory_layer_back_propagation->gates_weights_derivatives;
+    const Tensor<type, 2>& gates_recurrent_weights_derivatives = long_short_term_memory_layer_back_propagation->gates_recurrent_weights_derivatives;
 
-    copy(long_short_term_memory_layer_back_propagation->output_biases_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->output_biases_derivatives.data() + neurons_number,
-         gradient.data() + index + 3*neurons_number);
+    // The gates are side by side, as in the parameters
 
-    // Weights
-
-    copy(long_short_term_memory_layer_back_propagation->forget_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->forget_weights_derivatives.data() + inputs_number*neurons_number,
-         gradient.data() + index + 4*neurons_number);
-
-    copy(long_short_term_memory_layer_back_propagation->input_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->input_weights_derivatives.data() + inputs_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + inputs_number*neurons_number);
-
-    copy(long_short_term_memory_layer_back_propagation->state_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->state_weights_derivatives.data() + inputs_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + 2*inputs_number*neurons_number);
+    type* gradient_data = gradient.data() + index;
 
-    copy(long_short_term_memory_layer_back_propagation->output_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->output_weights_derivatives.data() + inputs_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + 3*inputs_number*neurons_number);
+    copy(gates_biases_derivatives.data(),
+         gates_biases_derivatives.data() + gates_biases_derivatives.size(),
+         gradient_data);
 
-    // Recurrent weights
-
-    copy(long_short_term_memory_layer_back_propagation->forget_recurrent_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->forget_recurrent_weights_derivatives.data() + neurons_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + 4*inputs_number*neurons_number);
+    gradient_data += gates_biases_derivatives.size();
 
-    copy(long_short_term_memory_layer_back_propagation->input_recurrent_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->input_recurrent_weights_derivatives.data() + neurons_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + 4*inputs_number*neurons_number + neurons_number*neurons_number);
+    copy(gates_weights_derivatives.data(),
+         gates_weights_derivatives.data() + gates_weights_derivatives.size(),
+         gradient_data);
 
-    copy(long_short_term_memory_layer_back_propagation->state_recurrent_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->state_recurrent_weights_derivatives.data() + neurons_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + 4*inputs_number*neurons_number + 2*neurons_number*neurons_number);
+    gradient_data += gates_weights_derivatives.size();
 
-    copy(long_short_term_memory_layer_back_propagation->output_recurrent_weights_derivatives.data(),
-         long_short_term_memory_layer_back_propagation->output_recurrent_weights_derivatives.data() + neurons_number*neurons_number,
-         gradient.data() + index + 4*neurons_number + 4*inputs_number*neurons_number + 3*neurons_number*neurons_number);
+    copy(gates_recurrent_weights_derivatives.data(),
+         gates_recurrent_weights_derivatives.data() + gates_recurrent_weights_derivatives.size(),
+         gradient_data);
 }
 
 
+/// Calculates the error gradient of the layer with back propagation through time.
+/// The errors of all the sequences are swept backwards from the last timestep to the first,
+/// using the activations stored by the forward propagation.
+/// At each timestep, the derivatives of the gates combinations of all the sequences are multiplied
+/// by the recurrent weights to get the errors of the previous hidden states, and by the previous hidden states
+/// to get the recurrent weights derivatives.
+/// The weights and biases derivatives are then calculated for all the samples with a single matrix product.
+/// Memory grows with the number of samples and neurons, not with the product of parameters and neurons.
+/// If there is a truncation length, the errors are not back propagated beyond that number of timesteps.
+/// @param inputs_data Pointer to the inputs of the layer.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, where the gradient is written.
+
 void LongShortTermMemoryLayer::calculate_error_gradient(type* inputs_data,
                                                         LayerForwardPropagation* forward_propagation,
-    LayerBackPropagation* back_propagation) const
+                                                        LayerBackPropagation* back_propagation) const
 {
-
-    const Index batch_samples_number = back_propagation->batch_samples_number;
+    const Index samples_number = back_propagation->batch_samples_number;
+    const Index neurons_number = get_neurons_number();
 
     LongShortTermMemoryLayerForwardPropagation* long_short_term_memory_layer_forward_propagation =
             static_cast<LongShortTermMemoryLayerForwardPropagation*>(forward_propagation);
@@ -2187,1784 +2032,141 @@ void LongShortTermMemoryLayer::calculate_error_gradient(type* inputs_data,
     LongShortTermMemoryLayerBackPropagation* long_short_term_memory_layer_back_propagation =
             static_cast<LongShortTermMemoryLayerBackPropagation*>(back_propagation);
 
-    const TensorMap<Tensor<type, 2>> inputs(inputs_data, batch_samples_number, get_inputs_number());
+    const Index sequences_number = (samples_number + timesteps - 1)/timesteps;
 
-    #pragma omp parallel
+    if(long_short_term_memory_layer_back_propagation->hidden_states_derivatives.dimension(0) != sequences_number)
     {
-        // Biases
-
-        #pragma omp single nowait
-        calculate_forget_biases_error_gradient(inputs,
-                                               long_short_term_memory_layer_forward_propagation,
-                                               long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_input_biases_error_gradient(inputs,
-                                              long_short_term_memory_layer_forward_propagation,
-                                              long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_state_biases_error_gradient(inputs,
-                                              long_short_term_memory_layer_forward_propagation,
-                                              long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_output_biases_error_gradient(inputs,
-                                               long_short_term_memory_layer_forward_propagation,
-                                               long_short_term_memory_layer_back_propagation);
-
-        // Weights
-
-        #pragma omp single nowait
-        calculate_forget_weights_error_gradient(inputs,
-                                                long_short_term_memory_layer_forward_propagation,
-                                                long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_input_weights_error_gradient(inputs,
-                                               long_short_term_memory_layer_forward_propagation,
-                                               long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_state_weights_error_gradient(inputs,
-                                               long_short_term_memory_layer_forward_propagation,
-                                               long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_output_weights_error_gradient(inputs,
-                                                long_short_term_memory_layer_forward_propagation,
-                                                long_short_term_memory_layer_back_propagation);
-
-        // Recurrent weights
-
-        #pragma omp single nowait
-        calculate_forget_recurrent_weights_error_gradient(inputs,
-                                                          long_short_term_memory_layer_forward_propagation,
-                                                          long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_input_recurrent_weights_error_gradient(inputs,
-                                                         long_short_term_memory_layer_forward_propagation,
-                                                         long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_state_recurrent_weights_error_gradient(inputs,
-                                                         long_short_term_memory_layer_forward_propagation,
-                                                         long_short_term_memory_layer_back_propagation);
-
-        #pragma omp single nowait
-        calculate_output_recurrent_weights_error_gradient(inputs,
-                                                          long_short_term_memory_layer_forward_propagation,
-                                                          long_short_term_memory_layer_back_propagation);
+        long_short_term_memory_layer_back_propagation->set_sequences_number(sequences_number);
     }
-}
-
-
-
-void LongShortTermMemoryLayer::calculate_forget_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                       LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                       LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-
-    const Index samples_number = inputs.dimension(0);
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = inputs_number*neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Tensor<type, 2> input_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> forget_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> state_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> output_combinations_weights_derivatives(parameters_number, neurons_number);
-
-    Tensor<type, 2> hidden_states_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> cell_state_weights_derivatives(parameters_number, neurons_number);
-
-    input_combinations_weights_derivatives.setZero();
-    forget_combinations_weights_derivatives.setZero();
-    state_combinations_weights_derivatives.setZero();
-    output_combinations_weights_derivatives.setZero();
-    hidden_states_weights_derivatives.setZero();
-    cell_state_weights_derivatives.setZero();
-
-    Index column_index = 0;
-    Index input_index = 0;
-
-    Index copy_index = 0;
 
-    back_propagation->forget_weights_derivatives.setZero();
+    const TensorMap<Tensor<type, 2>> inputs(inputs_data, samples_number, get_inputs_number());
 
-    #pragma omp parallel for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        const Tensor<type, 1> current_inputs = inputs.chip(sample, 0); // memcpy?
-        const Tensor<type, 1> current_layer_deltas = deltas.chip(sample,0); // memcpy?
-
-        // Forget activations and derivatives
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
+    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, samples_number, neurons_number);
 
-        // Input activations and derivatives
+    const Tensor<type, 2>& gates_recurrent_weights = long_short_term_memory_layer_forward_propagation->gates_recurrent_weights;
 
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
+    // Activations
 
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
+    const type* forget_activations = long_short_term_memory_layer_forward_propagation->forget_activations.data();
+    const type* input_activations = long_short_term_memory_layer_forward_propagation->input_activations.data();
+    const type* state_activations = long_short_term_memory_layer_forward_propagation->state_activations.data();
+    const type* output_activations = long_short_term_memory_layer_forward_propagation->output_activations.data();
+    const type* cell_states_activations = long_short_term_memory_layer_forward_propagation->cell_states_activations.data();
+    const type* activated_cell_states = long_short_term_memory_layer_forward_propagation->activated_cell_states.data();
+    const type* hidden_states_activations = long_short_term_memory_layer_forward_propagation->hidden_states_activations.data();
 
-        // State activations and derivatives
+    const type* forget_activations_derivatives = long_short_term_memory_layer_forward_propagation->forget_activations_derivatives.data();
+    const type* input_activations_derivatives = long_short_term_memory_layer_forward_propagation->input_activations_derivatives.data();
+    const type* state_activations_derivatives = long_short_term_memory_layer_forward_propagation->state_activations_derivatives.data();
+    const type* output_activations_derivatives = long_short_term_memory_layer_forward_propagation->output_activations_derivatives.data();
+    const type* hidden_states_activations_derivatives = long_short_term_memory_layer_forward_propagation->hidden_states_activations_derivatives.data();
 
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
+    // Derivatives
 
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
+    Tensor<type, 1>& gates_biases_derivatives = long_short_term_memory_layer_back_propagation->gates_biases_derivatives;
+    Tensor<type, 2>& gates_weights_derivatives = long_short_term_memory_layer_back_propagation->gates_weights_derivatives;
+    Tensor<type, 2>& gates_recurrent_weights_derivatives = long_short_term_memory_layer_back_propagation->gates_recurrent_weights_derivatives;
 
-        // Output activations and derivatives
+    Tensor<type, 2>& gates_combinations_derivatives = long_short_term_memory_layer_back_propagation->gates_combinations_derivatives;
+    Tensor<type, 2>& current_gates_combinations_derivatives = long_short_term_memory_layer_back_propagation->current_gates_combinations_derivatives;
 
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
+    Tensor<type, 2>& hidden_states_derivatives = long_short_term_memory_layer_back_propagation->hidden_states_derivatives;
+    Tensor<type, 2>& cell_states_derivatives = long_short_term_memory_layer_back_propagation->cell_states_derivatives;
 
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
+    Tensor<type, 2>& previous_hidden_states = long_short_term_memory_layer_back_propagation->previous_hidden_states;
 
-        // Cell states and hidden states
+    gates_recurrent_weights_derivatives.setZero();
 
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
+    hidden_states_derivatives.setZero();
+    cell_states_derivatives.setZero();
 
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
+    for(Index timestep = timesteps - 1; timestep >= 0; timestep--)
+    {
+        // The last sequence might not have this timestep
 
-        if(sample%timesteps == 0)
-        {
-            forward_propagation->previous_cell_state_activations.setZero();
+        const Index current_sequences_number = (samples_number - timestep + timesteps - 1)/timesteps;
 
-            forget_combinations_weights_derivatives.setZero();
-            input_combinations_weights_derivatives.setZero();
-            output_combinations_weights_derivatives.setZero();
-            state_combinations_weights_derivatives.setZero();
+        if(current_sequences_number <= 0) continue;
 
-            cell_state_weights_derivatives.setZero();
-        }
-        else
+        if(truncation_length > 0 && (timestep + 1)%truncation_length == 0)
         {
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            forget_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(forget_recurrent_weights, A_B);
-
-            input_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(input_recurrent_weights, A_B);
-            multiply_rows(input_combinations_weights_derivatives, forward_propagation->current_input_activations_derivatives);
-
-            state_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(state_recurrent_weights, A_B);
-            multiply_rows(state_combinations_weights_derivatives, forward_propagation->current_state_activations_derivatives);
-
-            output_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(output_recurrent_weights, A_B);
-            multiply_rows(output_combinations_weights_derivatives, forward_propagation->current_output_activations_derivatives);
+            hidden_states_derivatives.setZero();
+            cell_states_derivatives.setZero();
         }
 
-        column_index = 0;
-        input_index = 0;
+        current_gates_combinations_derivatives.setZero();
+        previous_hidden_states.setZero();
 
-        for(Index i = 0; i < parameters_number; i++)
+        for(Index sequence_index = 0; sequence_index < current_sequences_number; sequence_index++)
         {
-            forget_combinations_weights_derivatives(i, column_index) += current_inputs(input_index);
+            const Index sample_index = sequence_index*timesteps + timestep;
 
-            input_index++;
-
-            if(input_index == inputs_number)
+            for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
             {
-                input_index = 0;
-                column_index++;
-            }
-        }
-
-        multiply_rows(cell_state_weights_derivatives,
-                      forward_propagation->current_forget_activations);
-
-        multiply_rows(input_combinations_weights_derivatives,
-                      forward_propagation->current_state_activations);
-
-        cell_state_weights_derivatives += input_combinations_weights_derivatives;
-
-        multiply_rows(state_combinations_weights_derivatives,
-                      forward_propagation->current_input_activations);
-
-        cell_state_weights_derivatives += state_combinations_weights_derivatives;
-
-        multiply_rows(forget_combinations_weights_derivatives,
-                      forward_propagation->current_forget_activations_derivatives*forward_propagation->previous_cell_state_activations);
-
-        cell_state_weights_derivatives += forget_combinations_weights_derivatives;
-
-        copy(cell_state_weights_derivatives.data(),
-             cell_state_weights_derivatives.data() + cell_state_weights_derivatives.size(),
-             hidden_states_weights_derivatives.data());
-
-        multiply_rows(hidden_states_weights_derivatives,
-                      forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-
-        multiply_rows(output_combinations_weights_derivatives,
-                      calculate_activations(forward_propagation->current_cell_state_activations));
-        hidden_states_weights_derivatives += output_combinations_weights_derivatives;
-
-        back_propagation->forget_weights_derivatives += hidden_states_weights_derivatives.contract(current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_input_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                      LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                      LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = inputs_number*neurons_number;
-
-    Tensor<type, 2> input_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> forget_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> state_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> output_combinations_weights_derivatives(parameters_number, neurons_number);
-
-    Tensor<type, 2> hidden_states_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> cell_state_weights_derivatives(parameters_number, neurons_number);
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    input_combinations_weights_derivatives.setZero();
-    forget_combinations_weights_derivatives.setZero();
-    state_combinations_weights_derivatives.setZero();
-    output_combinations_weights_derivatives.setZero();
-    hidden_states_weights_derivatives.setZero();
-    cell_state_weights_derivatives.setZero();
-
-    Index column_index = 0;
-    Index input_index = 0;
+                const Index i = sample_index*neurons_number + neuron_index;
 
-    Index copy_index = 0;
+                // h_t = o_t * tanh(C_t)
 
-    back_propagation->input_weights_derivatives.setZero();
+                const type hidden_state_derivative
+                        = deltas(sample_index, neuron_index) + hidden_states_derivatives(sequence_index, neuron_index);
 
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        forward_propagation->current_inputs = inputs.chip(sample, 0); // memcpy?
-
-        back_propagation->current_layer_deltas = deltas.chip(sample,0); // memcpy?
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            forward_propagation->previous_cell_state_activations.setZero();
-
-            forget_combinations_weights_derivatives.setZero();
-            input_combinations_weights_derivatives.setZero();
-            output_combinations_weights_derivatives.setZero();
-            state_combinations_weights_derivatives.setZero();
-
-            cell_state_weights_derivatives.setZero();
-            hidden_states_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            forget_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(forget_recurrent_weights, A_B);
+                const type output_combination_derivative
+                        = hidden_state_derivative*activated_cell_states[i]*output_activations_derivatives[i];
 
-            multiply_rows(forget_combinations_weights_derivatives,
-                          forward_propagation->current_forget_activations_derivatives);
+                // C_t = f_t * C_(t-1) + i_t * C~_t
 
-            input_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(input_recurrent_weights, A_B);
+                const type cell_state_derivative
+                        = hidden_state_derivative*output_activations[i]*hidden_states_activations_derivatives[i]
+                        + cell_states_derivatives(sequence_index, neuron_index);
 
-            state_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(state_recurrent_weights, A_B);
+                const type previous_cell_state = timestep == 0 ? type(0) : cell_states_activations[i - neurons_number];
 
-            multiply_rows(state_combinations_weights_derivatives,
-                          forward_propagation->current_state_activations_derivatives);
+                const type forget_combination_derivative = cell_state_derivative*previous_cell_state*forget_activations_derivatives[i];
+                const type input_combination_derivative = cell_state_derivative*state_activations[i]*input_activations_derivatives[i];
+                const type state_combination_derivative = cell_state_derivative*input_activations[i]*state_activations_derivatives[i];
 
-            output_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(output_recurrent_weights, A_B);
+                cell_states_derivatives(sequence_index, neuron_index) = cell_state_derivative*forget_activations[i];
 
-            multiply_rows(output_combinations_weights_derivatives,
-                          forward_propagation->current_output_activations_derivatives);
-        }
-
-        column_index = 0;
-        input_index = 0;
+                const type combinations_derivatives[4] = {forget_combination_derivative,
+                                                          input_combination_derivative,
+                                                          state_combination_derivative,
+                                                          output_combination_derivative};
 
-        for(Index i = 0; i < parameters_number; i++)
-        {
-            input_combinations_weights_derivatives(i, column_index) += forward_propagation->current_inputs[input_index];
+                for(Index gate_index = 0; gate_index < 4; gate_index++)
+                {
+                    gates_combinations_derivatives(sample_index, gate_index*neurons_number + neuron_index)
+                            = combinations_derivatives[gate_index];
 
-            input_index++;
+                    current_gates_combinations_derivatives(sequence_index, gate_index*neurons_number + neuron_index)
+                            = combinations_derivatives[gate_index];
+                }
 
-            if(input_index == inputs_number)
-            {
-                input_index = 0;
-                column_index++;
+                if(timestep != 0)
+                {
+                    previous_hidden_states(sequence_index, neuron_index) = hidden_states_activations[i - neurons_number];
+                }
             }
         }
 
-        multiply_rows(cell_state_weights_derivatives,
-                      forward_propagation->current_forget_activations);
+        if(timestep == 0) break;
 
-        multiply_rows(forget_combinations_weights_derivatives,
-                      forward_propagation->previous_cell_state_activations);
+        // Recurrent weights derivatives and errors of the previous hidden states
 
-        cell_state_weights_derivatives += forget_combinations_weights_derivatives;
+        gates_recurrent_weights_derivatives.device(*thread_pool_device)
+                += previous_hidden_states.contract(current_gates_combinations_derivatives, AT_B);
 
-        multiply_rows(state_combinations_weights_derivatives,
-                      forward_propagation->current_input_activations);
-
-        cell_state_weights_derivatives += state_combinations_weights_derivatives;
-
-        multiply_rows(input_combinations_weights_derivatives,
-                      forward_propagation->current_input_activations_derivatives*forward_propagation->current_state_activations);
-
-        cell_state_weights_derivatives += input_combinations_weights_derivatives;
+        hidden_states_derivatives.device(*thread_pool_device)
+                = current_gates_combinations_derivatives.contract(gates_recurrent_weights, A_BT);
+    }
 
-        hidden_states_weights_derivatives = cell_state_weights_derivatives;
+    // Biases and weights derivatives of all the samples
 
-        multiply_rows(hidden_states_weights_derivatives,
-                      forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
+    gates_biases_derivatives.device(*thread_pool_device) = gates_combinations_derivatives.sum(rows_sum);
 
-        multiply_rows(output_combinations_weights_derivatives,
-                      calculate_activations(forward_propagation->current_cell_state_activations));
-
-        hidden_states_weights_derivatives += output_combinations_weights_derivatives;
-
-        back_propagation->input_weights_derivatives
-                += hidden_states_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_state_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                      LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                      LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = inputs_number*neurons_number;
-
-    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Tensor<type, 2> input_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> forget_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> state_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> output_combinations_weights_derivatives(parameters_number, neurons_number);
-
-    Tensor<type, 2> hidden_states_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> cell_state_weights_derivatives(parameters_number, neurons_number);
-
-    input_combinations_weights_derivatives.setZero();
-    forget_combinations_weights_derivatives.setZero();
-    state_combinations_weights_derivatives.setZero();
-    output_combinations_weights_derivatives.setZero();
-    hidden_states_weights_derivatives.setZero();
-    cell_state_weights_derivatives.setZero();
-
-    Index column_index = 0;
-    Index input_index = 0;
-
-    Index copy_index = 0;
-
-    back_propagation->state_weights_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        forward_propagation->current_inputs = inputs.chip(sample, 0); // memcpy?
-
-        back_propagation->current_layer_deltas = deltas.chip(sample,0); // memcpy?
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            forward_propagation->previous_cell_state_activations.setZero();
-
-            forget_combinations_weights_derivatives.setZero();
-            input_combinations_weights_derivatives.setZero();
-            output_combinations_weights_derivatives.setZero();
-            state_combinations_weights_derivatives.setZero();
-
-            cell_state_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->cell_states_activations.data() + (copy_index - neurons_number),
-            forward_propagation->cell_states_activations.data() + (copy_index - neurons_number) + neurons_number,
-            forward_propagation->previous_cell_state_activations.data());
-
-            forget_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(forget_recurrent_weights, A_B);
-            multiply_rows(forget_combinations_weights_derivatives, forward_propagation->current_forget_activations_derivatives);
-
-            input_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(input_recurrent_weights, A_B);
-            multiply_rows(input_combinations_weights_derivatives, forward_propagation->current_input_activations_derivatives);
-
-            state_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(state_recurrent_weights, A_B);
-
-            output_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(output_recurrent_weights, A_B);
-            multiply_rows(output_combinations_weights_derivatives, forward_propagation->current_output_activations_derivatives);
-        }
-
-        column_index = 0;
-        input_index = 0;
-
-        for(Index i = 0; i < parameters_number; i++)
-        {
-            state_combinations_weights_derivatives(i, column_index) += forward_propagation->current_inputs[input_index];
-
-            input_index++;
-
-            if(input_index == inputs_number)
-            {
-                input_index = 0;
-                column_index++;
-            }
-        }
-
-        multiply_rows(cell_state_weights_derivatives, forward_propagation->current_forget_activations);
-        multiply_rows(forget_combinations_weights_derivatives, forward_propagation->previous_cell_state_activations);
-        cell_state_weights_derivatives += forget_combinations_weights_derivatives;
-        multiply_rows(input_combinations_weights_derivatives, forward_propagation->current_state_activations);
-        cell_state_weights_derivatives += input_combinations_weights_derivatives;
-        multiply_rows(state_combinations_weights_derivatives, (forward_propagation->current_state_activations_derivatives*forward_propagation->current_input_activations));
-        cell_state_weights_derivatives += state_combinations_weights_derivatives;
-
-        hidden_states_weights_derivatives = cell_state_weights_derivatives;
-        multiply_rows(hidden_states_weights_derivatives, forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-        multiply_rows(output_combinations_weights_derivatives, calculate_activations(forward_propagation->current_cell_state_activations));
-        hidden_states_weights_derivatives += output_combinations_weights_derivatives;
-
-        back_propagation->state_weights_derivatives += hidden_states_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_output_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                       LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                       LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = inputs_number*neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Tensor<type, 2> input_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> forget_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> state_combinations_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> output_combinations_weights_derivatives(parameters_number, neurons_number);
-
-    Tensor<type, 2> hidden_states_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> cell_state_weights_derivatives(parameters_number, neurons_number);
-
-    input_combinations_weights_derivatives.setZero();
-    forget_combinations_weights_derivatives.setZero();
-    state_combinations_weights_derivatives.setZero();
-    output_combinations_weights_derivatives.setZero();
-    hidden_states_weights_derivatives.setZero();
-    cell_state_weights_derivatives.setZero();
-
-    Index column_index = 0;
-    Index input_index = 0;
-
-    Index copy_index = 0;
-
-    back_propagation->output_weights_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        forward_propagation->current_inputs = inputs.chip(sample, 0); // memcpy?
-
-        back_propagation->current_layer_deltas = deltas.chip(sample,0); // memcpy?
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            forward_propagation->previous_cell_state_activations.setZero();
-
-            forget_combinations_weights_derivatives.setZero();
-            input_combinations_weights_derivatives.setZero();
-            output_combinations_weights_derivatives.setZero();
-            state_combinations_weights_derivatives.setZero();
-
-            cell_state_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            forget_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(forget_recurrent_weights, A_B);
-            multiply_rows(forget_combinations_weights_derivatives, forward_propagation->current_forget_activations_derivatives);
-            input_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(input_recurrent_weights, A_B);
-            multiply_rows(input_combinations_weights_derivatives, forward_propagation->current_input_activations_derivatives);
-            state_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(state_recurrent_weights, A_B);
-            multiply_rows(state_combinations_weights_derivatives, forward_propagation->current_state_activations_derivatives);
-            output_combinations_weights_derivatives = hidden_states_weights_derivatives.contract(output_recurrent_weights, A_B);
-        }
-
-        column_index = 0;
-        input_index = 0;
-
-        for(Index i = 0; i < parameters_number; i++)
-        {
-            output_combinations_weights_derivatives(i, column_index) += forward_propagation->current_inputs[input_index];
-
-            input_index++;
-
-            if(input_index == inputs_number)
-            {
-                input_index = 0;
-                column_index++;
-            }
-        }
-
-        multiply_rows(cell_state_weights_derivatives, forward_propagation->current_forget_activations);
-        multiply_rows(forget_combinations_weights_derivatives, forward_propagation->previous_cell_state_activations);
-        cell_state_weights_derivatives += forget_combinations_weights_derivatives;
-        multiply_rows(state_combinations_weights_derivatives, forward_propagation->current_input_activations);
-        cell_state_weights_derivatives += state_combinations_weights_derivatives;
-        multiply_rows(input_combinations_weights_derivatives, forward_propagation->current_state_activations);
-        cell_state_weights_derivatives += input_combinations_weights_derivatives;
-
-         hidden_states_weights_derivatives = cell_state_weights_derivatives;
-         multiply_rows(hidden_states_weights_derivatives, forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-         multiply_rows(output_combinations_weights_derivatives, forward_propagation->current_output_activations_derivatives*calculate_activations(forward_propagation->current_cell_state_activations));
-        hidden_states_weights_derivatives += output_combinations_weights_derivatives;
-
-        back_propagation->output_weights_derivatives += hidden_states_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_forget_recurrent_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                                 LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                                 LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number*neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Tensor<type, 1> forget_recurrent_weights_error_gradient(parameters_number);
-    forget_recurrent_weights_error_gradient.setZero();
-
-    Tensor<type, 2> input_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> forget_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> state_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> output_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-
-    Tensor<type, 2> hidden_states_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> cell_state_recurrent_weights_derivatives(parameters_number, neurons_number);
-
-    Index column_index = 0;
-    Index activation_index = 0;
-
-    Index copy_index = 0;
-
-    back_propagation->forget_recurrent_weights_derivatives.setZero();
-
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            cell_state_recurrent_weights_derivatives.setZero();
-            hidden_states_recurrent_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_hidden_state_activations.data());
-
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            forget_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(forget_recurrent_weights, A_B);
-            input_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(input_recurrent_weights, A_B);
-            multiply_rows(input_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations_derivatives);
-            state_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(state_recurrent_weights, A_B);
-            multiply_rows(state_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations_derivatives);
-            output_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(output_recurrent_weights, A_B);
-            multiply_rows(output_combinations_recurrent_weights_derivatives, forward_propagation->current_output_activations_derivatives);
-
-            column_index = 0;
-            activation_index = 0;
-
-            for(Index i = 0; i < parameters_number; i++)
-            {
-                forget_combinations_recurrent_weights_derivatives(i, column_index) += forward_propagation->previous_hidden_state_activations[activation_index];
-
-                activation_index++;
-
-                if(activation_index == neurons_number)
-                {
-                    activation_index = 0;
-                    column_index++;
-                }
-            }
-
-            multiply_rows(cell_state_recurrent_weights_derivatives, forward_propagation->current_forget_activations);
-            multiply_rows(input_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations);
-            cell_state_recurrent_weights_derivatives += input_combinations_recurrent_weights_derivatives;
-            multiply_rows(state_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations);
-            cell_state_recurrent_weights_derivatives += state_combinations_recurrent_weights_derivatives;
-            multiply_rows(forget_combinations_recurrent_weights_derivatives, (forward_propagation->current_forget_activations_derivatives*forward_propagation->previous_cell_state_activations));
-            cell_state_recurrent_weights_derivatives += forget_combinations_recurrent_weights_derivatives;
-
-            hidden_states_recurrent_weights_derivatives = cell_state_recurrent_weights_derivatives;
-            multiply_rows(hidden_states_recurrent_weights_derivatives, forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-            multiply_rows(output_combinations_recurrent_weights_derivatives, calculate_activations(forward_propagation->current_cell_state_activations));
-            hidden_states_recurrent_weights_derivatives += output_combinations_recurrent_weights_derivatives;
-        }
-
-        back_propagation->forget_recurrent_weights_derivatives += hidden_states_recurrent_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
+    gates_weights_derivatives.device(*thread_pool_device) = inputs.contract(gates_combinations_derivatives, AT_B);
 }
 
 
-void LongShortTermMemoryLayer::calculate_input_recurrent_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                                LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                                LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number*neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Tensor<type, 1> forget_recurrent_weights_error_gradient(parameters_number);
-    forget_recurrent_weights_error_gradient.setZero();
-
-    Tensor<type, 2> input_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> forget_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> state_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> output_combinations_recurrent_weights_derivatives(parameters_number, neurons_number);
-
-    Tensor<type, 2> hidden_states_recurrent_weights_derivatives(parameters_number, neurons_number);
-    Tensor<type, 2> cell_state_recurrent_weights_derivatives(parameters_number, neurons_number);
-
-    Index column_index = 0;
-    Index activation_index = 0;
-
-    Index copy_index = 0;
-
-    back_propagation->input_recurrent_weights_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            cell_state_recurrent_weights_derivatives.setZero();
-            hidden_states_recurrent_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_hidden_state_activations.data());
-
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            forget_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(forget_recurrent_weights, A_B);
-            multiply_rows(forget_combinations_recurrent_weights_derivatives, forward_propagation->current_forget_activations_derivatives);
-            input_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(input_recurrent_weights, A_B);
-            state_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(state_recurrent_weights, A_B);
-            multiply_rows(state_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations_derivatives);
-            output_combinations_recurrent_weights_derivatives = hidden_states_recurrent_weights_derivatives.contract(output_recurrent_weights, A_B);
-            multiply_rows(output_combinations_recurrent_weights_derivatives, forward_propagation->current_output_activations_derivatives);
-
-            column_index = 0;
-            activation_index = 0;
-
-            for(Index i = 0; i < parameters_number; i++)
-            {
-                input_combinations_recurrent_weights_derivatives(i, column_index) += forward_propagation->previous_hidden_state_activations[activation_index];
-
-                activation_index++;
-
-                if(activation_index == neurons_number)
-                {
-                    activation_index = 0;
-                    column_index++;
-                }
-            }
-
-            multiply_rows(cell_state_recurrent_weights_derivatives, forward_propagation->current_forget_activations);
-            multiply_rows(input_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations_derivatives*forward_propagation->current_state_activations);
-            cell_state_recurrent_weights_derivatives += input_combinations_recurrent_weights_derivatives;
-            multiply_rows(state_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations);
-            cell_state_recurrent_weights_derivatives += state_combinations_recurrent_weights_derivatives;
-            multiply_rows(forget_combinations_recurrent_weights_derivatives, forward_propagation->previous_cell_state_activations);
-            cell_state_recurrent_weights_derivatives += forget_combinations_recurrent_weights_derivatives;
-
-            hidden_states_recurrent_weights_derivatives = cell_state_recurrent_weights_derivatives;
-            multiply_rows(hidden_states_recurrent_weights_derivatives, forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-            multiply_rows(output_combinations_recurrent_weights_derivatives, calculate_activations(forward_propagation->current_cell_state_activations));
-            hidden_states_recurrent_weights_derivatives += output_combinations_recurrent_weights_derivatives;
-        }
-
-        back_propagation->input_recurrent_weights_derivatives += hidden_states_recurrent_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_state_recurrent_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                                LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                                LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number*neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Tensor<type, 1> forget_recurrent_weights_error_gradient(parameters_number);
-    forget_recurrent_weights_error_gradient.setZero();
-
-    Index column_index = 0;
-    Index activation_index = 0;
-
-    Index copy_index = 0;
-
-    back_propagation->state_recurrent_weights_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->cell_state_recurrent_weights_derivatives.setZero();
-            back_propagation->hidden_states_recurrent_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_hidden_state_activations.data());
-
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            back_propagation->forget_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(forget_recurrent_weights, A_B);
-            multiply_rows(back_propagation->forget_combinations_recurrent_weights_derivatives, forward_propagation->current_forget_activations_derivatives);
-            back_propagation->input_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(input_recurrent_weights, A_B);
-            multiply_rows(back_propagation->input_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations_derivatives);
-            back_propagation->state_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(state_recurrent_weights, A_B);
-            back_propagation->state_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(output_recurrent_weights, A_B);
-            multiply_rows(back_propagation->state_combinations_recurrent_weights_derivatives, forward_propagation->current_output_activations_derivatives);
-
-            column_index = 0;
-            activation_index = 0;
-
-            for(Index i = 0; i < parameters_number; i++)
-            {
-                back_propagation->state_combinations_recurrent_weights_derivatives(i, column_index) += forward_propagation->previous_hidden_state_activations[activation_index];
-
-                activation_index++;
-
-                if(activation_index == neurons_number)
-                {
-                    activation_index = 0;
-                    column_index++;
-                }
-            }
-
-            multiply_rows(back_propagation->cell_state_recurrent_weights_derivatives, forward_propagation->current_forget_activations);
-            multiply_rows(back_propagation->input_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations);
-            back_propagation->cell_state_recurrent_weights_derivatives += back_propagation->input_combinations_recurrent_weights_derivatives;
-            multiply_rows(back_propagation->state_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations_derivatives*forward_propagation->current_input_activations);
-            back_propagation->cell_state_recurrent_weights_derivatives += back_propagation->state_combinations_recurrent_weights_derivatives;
-            multiply_rows(back_propagation->forget_combinations_recurrent_weights_derivatives, forward_propagation->previous_cell_state_activations);
-            back_propagation->cell_state_recurrent_weights_derivatives += back_propagation->forget_combinations_recurrent_weights_derivatives;
-
-            back_propagation->hidden_states_recurrent_weights_derivatives = back_propagation->cell_state_recurrent_weights_derivatives;
-            multiply_rows(back_propagation->hidden_states_recurrent_weights_derivatives, forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-            multiply_rows(back_propagation->state_combinations_recurrent_weights_derivatives, calculate_activations(forward_propagation->current_cell_state_activations));
-            back_propagation->hidden_states_recurrent_weights_derivatives += back_propagation->state_combinations_recurrent_weights_derivatives;
-        }
-
-        back_propagation->state_recurrent_weights_derivatives += back_propagation->hidden_states_recurrent_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_output_recurrent_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                                 LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                                 LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number*neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-
-    Index column_index = 0;
-    Index activation_index = 0;
-
-    Index copy_index = 0;
-
-    back_propagation->output_recurrent_weights_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->cell_state_recurrent_weights_derivatives.setZero();
-            back_propagation->hidden_states_recurrent_weights_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->hidden_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_hidden_state_activations.data());
-
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            back_propagation->forget_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(forget_recurrent_weights, A_B);
-            multiply_rows(back_propagation->forget_combinations_recurrent_weights_derivatives, forward_propagation->current_forget_activations_derivatives);
-            back_propagation->input_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(input_recurrent_weights, A_B);
-            multiply_rows(back_propagation->input_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations_derivatives);
-            back_propagation->state_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(state_recurrent_weights, A_B);
-            multiply_rows(back_propagation->state_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations_derivatives);
-            back_propagation->output_combinations_recurrent_weights_derivatives = back_propagation->hidden_states_recurrent_weights_derivatives.contract(output_recurrent_weights, A_B);
-
-            column_index = 0;
-            activation_index = 0;
-
-            for(Index i = 0; i < parameters_number; i++)
-            {
-                back_propagation->output_combinations_recurrent_weights_derivatives(i, column_index) += forward_propagation->previous_hidden_state_activations[activation_index];
-
-                activation_index++;
-
-                if(activation_index == neurons_number)
-                {
-                    activation_index = 0;
-                    column_index++;
-                }
-            }
-
-            multiply_rows(back_propagation->cell_state_recurrent_weights_derivatives, forward_propagation->current_forget_activations);
-            multiply_rows(back_propagation->input_combinations_recurrent_weights_derivatives, forward_propagation->current_state_activations);
-            back_propagation->cell_state_recurrent_weights_derivatives += back_propagation->input_combinations_recurrent_weights_derivatives;
-            multiply_rows(back_propagation->state_combinations_recurrent_weights_derivatives, forward_propagation->current_input_activations);
-            back_propagation->cell_state_recurrent_weights_derivatives += back_propagation->state_combinations_recurrent_weights_derivatives;
-            multiply_rows(back_propagation->forget_combinations_recurrent_weights_derivatives, forward_propagation->previous_cell_state_activations);
-            back_propagation->cell_state_recurrent_weights_derivatives += back_propagation->forget_combinations_recurrent_weights_derivatives;
-
-            back_propagation->hidden_states_recurrent_weights_derivatives = back_propagation->cell_state_recurrent_weights_derivatives;
-            multiply_rows(back_propagation->cell_state_recurrent_weights_derivatives, forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-            multiply_rows(back_propagation->output_combinations_recurrent_weights_derivatives, forward_propagation->current_output_activations_derivatives*calculate_activations(forward_propagation->current_cell_state_activations));
-            back_propagation->hidden_states_recurrent_weights_derivatives += back_propagation->output_combinations_recurrent_weights_derivatives;
-        }
-
-        back_propagation->output_recurrent_weights_derivatives += back_propagation->hidden_states_recurrent_weights_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_forget_biases_error_gradient(const Tensor<type, 2>& inputs,
-                                                                      LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                      LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    back_propagation->input_combinations_biases_derivatives.setZero();
-    back_propagation->forget_combinations_biases_derivatives.setZero();
-    back_propagation->state_combinations_biases_derivatives.setZero();
-    back_propagation->output_combinations_biases_derivatives.setZero();
-
-    back_propagation->hidden_states_biases_derivatives.setZero();
-    back_propagation->cell_state_biases_derivatives.setZero();
-
-    Index copy_index = 0;
-
-    back_propagation->forget_biases_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        const Tensor<type, 1> current_layer_deltas = deltas.chip(sample, 0);
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->forget_combinations_biases_derivatives.setZero();
-            back_propagation->input_combinations_biases_derivatives.setZero();
-            back_propagation->state_combinations_biases_derivatives.setZero();
-            back_propagation->output_combinations_biases_derivatives.setZero();
-
-            forward_propagation->previous_cell_state_activations.setZero();
-
-            back_propagation->cell_state_biases_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 forward_propagation->previous_cell_state_activations.data());
-
-            back_propagation->forget_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(forget_recurrent_weights, A_B);
-
-            back_propagation->input_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(input_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                          forward_propagation->current_input_activations_derivatives);
-
-            back_propagation->state_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(state_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                          forward_propagation->current_state_activations_derivatives);
-
-            back_propagation->output_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(output_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                          forward_propagation->current_output_activations_derivatives);
-        }
-
-        for(Index row = 0; row < parameters_number; row++) back_propagation->forget_combinations_biases_derivatives(row, row) += static_cast<type>(1.0);
-
-        multiply_rows(back_propagation->cell_state_biases_derivatives,
-                      forward_propagation->current_forget_activations);
-
-        multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                      forward_propagation->current_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->input_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                      forward_propagation->current_input_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->state_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->forget_combinations_biases_derivatives,
-                      forward_propagation->current_forget_activations_derivatives*forward_propagation->previous_cell_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->forget_combinations_biases_derivatives;
-
-        back_propagation->hidden_states_biases_derivatives = back_propagation->cell_state_biases_derivatives;
-
-        multiply_rows(back_propagation->hidden_states_biases_derivatives,
-                      forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-
-        multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                      calculate_activations(forward_propagation->current_cell_state_activations));
-
-        back_propagation->hidden_states_biases_derivatives += back_propagation->output_combinations_biases_derivatives;
-
-        back_propagation->forget_biases_derivatives += back_propagation->hidden_states_biases_derivatives.contract(current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_input_biases_error_gradient(const Tensor<type, 2>& inputs,
-                                                                     LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                     LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    back_propagation->input_combinations_biases_derivatives.setZero();
-    back_propagation->forget_combinations_biases_derivatives.setZero();
-    back_propagation->state_combinations_biases_derivatives.setZero();
-    back_propagation->output_combinations_biases_derivatives.setZero();
-
-    back_propagation->hidden_states_biases_derivatives.setZero();
-    back_propagation->cell_state_biases_derivatives.setZero();
-
-    Tensor<type, 1> previous_cell_state_activations(neurons_number);
-
-    Index copy_index = 0;
-
-    back_propagation->input_biases_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
-
-        copy(forward_propagation->forget_activations.data() + copy_index,
-             forward_propagation->forget_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations.data());
-
-        copy(forward_propagation->forget_activations_derivatives.data() + copy_index,
-             forward_propagation->forget_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_forget_activations_derivatives.data());
-
-        copy(forward_propagation->input_activations.data() + copy_index,
-             forward_propagation->input_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations.data());
-
-        copy(forward_propagation->input_activations_derivatives.data() + copy_index,
-             forward_propagation->input_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_input_activations_derivatives.data());
-
-        copy(forward_propagation->state_activations.data() + copy_index,
-             forward_propagation->state_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations.data());
-
-        copy(forward_propagation->state_activations_derivatives.data() + copy_index,
-             forward_propagation->state_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_state_activations_derivatives.data());
-
-        copy(forward_propagation->output_activations.data() + copy_index,
-             forward_propagation->output_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations.data());
-
-        copy(forward_propagation->output_activations_derivatives.data() + copy_index,
-             forward_propagation->output_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_output_activations_derivatives.data());
-
-        copy(forward_propagation->cell_states_activations.data() + copy_index,
-             forward_propagation->cell_states_activations.data() + copy_index + neurons_number,
-             forward_propagation->current_cell_state_activations.data());
-
-        copy(forward_propagation->hidden_states_activations_derivatives.data() + copy_index,
-             forward_propagation->hidden_states_activations_derivatives.data() + copy_index + neurons_number,
-             forward_propagation->current_hidden_states_derivatives.data());
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->forget_combinations_biases_derivatives.setZero();
-            back_propagation->input_combinations_biases_derivatives.setZero();
-            back_propagation->state_combinations_biases_derivatives.setZero();
-            back_propagation->output_combinations_biases_derivatives.setZero();
-
-            previous_cell_state_activations.setZero();
-            back_propagation->cell_state_biases_derivatives.setZero();
-        }
-        else
-        {
-            copy(forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                 forward_propagation->cell_states_activations.data() + (copy_index-neurons_number) + neurons_number,
-                 previous_cell_state_activations.data());
-
-            back_propagation->forget_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(forget_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->forget_combinations_biases_derivatives,
-                          forward_propagation->current_forget_activations_derivatives);
-
-            back_propagation->input_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(input_recurrent_weights, A_B);
-
-            back_propagation->state_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(state_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                          forward_propagation->current_state_activations_derivatives);
-
-            back_propagation->output_combinations_biases_derivatives
-                    = back_propagation->hidden_states_biases_derivatives.contract(output_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                          forward_propagation->current_output_activations_derivatives);
-        }
-
-        for(Index row = 0; row < parameters_number; row++)
-            back_propagation->input_combinations_biases_derivatives(row, row) += static_cast<type>(1.0);
-
-        multiply_rows(back_propagation->cell_state_biases_derivatives,
-                      forward_propagation->current_forget_activations);
-
-        multiply_rows(back_propagation->forget_combinations_biases_derivatives, previous_cell_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->forget_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                      forward_propagation->current_input_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->state_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                      forward_propagation->current_input_activations_derivatives*forward_propagation->current_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->input_combinations_biases_derivatives;
-
-        back_propagation->hidden_states_biases_derivatives = back_propagation->cell_state_biases_derivatives;
-
-        multiply_rows(back_propagation->hidden_states_biases_derivatives,
-                      forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-
-        multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                      calculate_activations(forward_propagation->current_cell_state_activations));
-
-        back_propagation->hidden_states_biases_derivatives += back_propagation->output_combinations_biases_derivatives;
-
-        back_propagation->input_biases_derivatives
-                += back_propagation->hidden_states_biases_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_state_biases_error_gradient(const Tensor<type, 2>& inputs,
-                                                                     LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                     LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    back_propagation->input_combinations_biases_derivatives.setZero();
-    back_propagation->forget_combinations_biases_derivatives.setZero();
-    back_propagation->state_combinations_biases_derivatives.setZero();
-    back_propagation->output_combinations_biases_derivatives.setZero();
-
-    back_propagation->hidden_states_biases_derivatives.setZero();
-    back_propagation->cell_state_biases_derivatives.setZero();
-
-    Index copy_index = 0;
-
-    back_propagation->state_biases_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        const Tensor<type, 1> current_layer_deltas = deltas.chip(sample, 0);
-
-        memcpy(forward_propagation->current_forget_activations.data(),
-               forward_propagation->forget_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_forget_activations_derivatives.data(),
-               forward_propagation->forget_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_input_activations.data(),
-               forward_propagation->input_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_input_activations_derivatives.data(),
-               forward_propagation->input_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_state_activations.data(),
-               forward_propagation->state_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_state_activations_derivatives.data(),
-               forward_propagation->state_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_output_activations.data(),
-               forward_propagation->output_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_output_activations_derivatives.data(),
-               forward_propagation->output_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_cell_state_activations.data(),
-               forward_propagation->cell_states_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_hidden_states_derivatives.data(),
-               forward_propagation->hidden_states_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->forget_combinations_biases_derivatives.setZero();
-            back_propagation->input_combinations_biases_derivatives.setZero();
-            back_propagation->state_combinations_biases_derivatives.setZero();
-            back_propagation->output_combinations_biases_derivatives.setZero();
-
-            forward_propagation->previous_cell_state_activations.setZero();
-            back_propagation->cell_state_biases_derivatives.setZero();
-        }
-        else
-        {
-            memcpy(forward_propagation->previous_cell_state_activations.data(),
-                   forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                   static_cast<size_t>(neurons_number)*sizeof(type));
-
-            back_propagation->forget_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(forget_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->forget_combinations_biases_derivatives,
-                          forward_propagation->current_forget_activations_derivatives);
-
-            back_propagation->input_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(input_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                          forward_propagation->current_input_activations_derivatives);
-
-            back_propagation->state_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(state_recurrent_weights, A_B);
-
-            back_propagation->output_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(output_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                          forward_propagation->current_output_activations_derivatives);
-        }
-
-        for(Index row = 0; row < parameters_number; row++) back_propagation->state_combinations_biases_derivatives(row, row) += static_cast<type>(1.0);
-
-        multiply_rows(back_propagation->cell_state_biases_derivatives,
-                      forward_propagation->current_forget_activations);
-
-        multiply_rows(back_propagation->forget_combinations_biases_derivatives, forward_propagation->previous_cell_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->forget_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                      forward_propagation->current_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->input_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                      forward_propagation->current_state_activations_derivatives*forward_propagation->current_input_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->state_combinations_biases_derivatives;
-
-        back_propagation->hidden_states_biases_derivatives = back_propagation->cell_state_biases_derivatives;
-
-        multiply_rows(back_propagation->hidden_states_biases_derivatives,
-                      forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-
-        multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                      calculate_activations(forward_propagation->current_cell_state_activations));
-
-        back_propagation->hidden_states_biases_derivatives += back_propagation->output_combinations_biases_derivatives;
-
-        back_propagation->state_biases_derivatives += back_propagation->hidden_states_biases_derivatives.contract(current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-void LongShortTermMemoryLayer::calculate_output_biases_error_gradient(const Tensor<type, 2>& inputs,
-                                                                      LongShortTermMemoryLayerForwardPropagation* forward_propagation,
-                                                                      LongShortTermMemoryLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number;
-
-    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    back_propagation->input_combinations_biases_derivatives.setZero();
-    back_propagation->forget_combinations_biases_derivatives.setZero();
-    back_propagation->state_combinations_biases_derivatives.setZero();
-    back_propagation->output_combinations_biases_derivatives.setZero();
-    back_propagation->hidden_states_biases_derivatives.setZero();
-    back_propagation->cell_state_biases_derivatives.setZero();
-
-    Index copy_index = 0;
-
-    back_propagation->output_biases_derivatives.setZero();
-
-    #pragma omp for
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
-
-        memcpy(forward_propagation->current_forget_activations.data(),
-               forward_propagation->forget_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_forget_activations_derivatives.data(),
-               forward_propagation->forget_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_input_activations.data(),
-               forward_propagation->input_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_input_activations_derivatives.data(),
-               forward_propagation->input_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_state_activations.data(),
-               forward_propagation->state_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_state_activations_derivatives.data(),
-               forward_propagation->state_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_output_activations.data(),
-               forward_propagation->output_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_output_activations_derivatives.data(),
-               forward_propagation->output_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_cell_state_activations.data(),
-               forward_propagation->cell_states_activations.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        memcpy(forward_propagation->current_hidden_states_derivatives.data(),
-               forward_propagation->hidden_states_activations_derivatives.data()+copy_index,
-               static_cast<size_t>(neurons_number)*sizeof(type));
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->forget_combinations_biases_derivatives.setZero();
-            back_propagation->input_combinations_biases_derivatives.setZero();
-            back_propagation->state_combinations_biases_derivatives.setZero();
-            back_propagation->output_combinations_biases_derivatives.setZero();
-
-            forward_propagation->previous_cell_state_activations.setZero();
-            back_propagation->cell_state_biases_derivatives.setZero();
-        }
-        else
-        {
-            memcpy(forward_propagation->previous_cell_state_activations.data(),
-                   forward_propagation->cell_states_activations.data() + (copy_index-neurons_number),
-                   static_cast<size_t>(neurons_number)*sizeof(type));
-
-            back_propagation->forget_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(forget_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->forget_combinations_biases_derivatives,
-                          forward_propagation->current_forget_activations_derivatives);
-
-            back_propagation->input_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(input_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                          forward_propagation->current_input_activations_derivatives);
-
-            back_propagation->state_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(state_recurrent_weights, A_B);
-
-            multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                          forward_propagation->current_state_activations_derivatives);
-
-            back_propagation->output_combinations_biases_derivatives = back_propagation->hidden_states_biases_derivatives.contract(output_recurrent_weights, A_B);
-        }
-
-        for(Index row = 0; row < parameters_number; row++) back_propagation->output_combinations_biases_derivatives(row, row) += static_cast<type>(1.0);
-
-        multiply_rows(back_propagation->cell_state_biases_derivatives,
-                      forward_propagation->current_forget_activations);
-
-        multiply_rows(back_propagation->forget_combinations_biases_derivatives, forward_propagation->previous_cell_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->forget_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->state_combinations_biases_derivatives,
-                      forward_propagation->current_input_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->state_combinations_biases_derivatives;
-
-        multiply_rows(back_propagation->input_combinations_biases_derivatives,
-                      forward_propagation->current_state_activations);
-
-        back_propagation->cell_state_biases_derivatives += back_propagation->input_combinations_biases_derivatives;
-
-        back_propagation->hidden_states_biases_derivatives = back_propagation->cell_state_biases_derivatives;
-
-        multiply_rows(back_propagation->hidden_states_biases_derivatives,
-                      forward_propagation->current_output_activations*forward_propagation->current_hidden_states_derivatives);
-
-        multiply_rows(back_propagation->output_combinations_biases_derivatives,
-                      forward_propagation->current_output_activations_derivatives*calculate_activations(forward_propagation->current_cell_state_activations));
-
-        back_propagation->hidden_states_biases_derivatives += back_propagation->output_combinations_biases_derivatives;
-
-        back_propagation->output_biases_derivatives += back_propagation->hidden_states_biases_derivatives.contract(back_propagation->current_layer_deltas, A_B);
-
-        copy_index += neurons_number;
-    }
-}
-
-
-/// Returns a string with the expression of the inputs-outputs relationship of the layer.
-/// @param inputs_names Vector of strings with the name of the layer inputs.
-/// @param outputs_names Vector of strings with the name of the layer outputs.
-
 string LongShortTermMemoryLayer::write_expression(const Tensor<string, 1>& inputs_names, const Tensor<string, 1>& outputs_names) const
 {
     const Index neurons_number = get_neurons_number();
@@ -78,6 +78,7 @@ public:
    Tensor<type, 2> get_output_recurrent_weights() const;
 
    Index get_timesteps() const;
+   Index get_truncation_length() const;
 
    Index get_parameters_number() const override;
    Tensor<type, 1> get_parameters() const final;
@@ -138,6 +139,7 @@ public:
    void set_recurrent_activation_function(const string&);
 
    void set_timesteps(const Index&);
+   void set_truncation_length(const Index&);
 
    // Display messages
 
@@ -179,6 +181,7 @@ public:
                                const Tensor<type, 2>&,
                                const Tensor<type, 2>&,
                                const Tensor<type, 1>&,
+                               const Tensor<type, 1>&,
                                type*, const Tensor<Index, 1>&);
 
    // Long short-term memory layer activations
@@ -219,60 +222,19 @@ public:
 
    void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final;
 
+   void forward_propagate_sequences(const TensorMap<Tensor<type, 2>>&,
+                                    const TensorMap<Tensor<type, 1>>&,
+                                    const TensorMap<Tensor<type, 2>>&,
+                                    const TensorMap<Tensor<type, 2>>&,
+                                    LongShortTermMemoryLayerForwardPropagation*,
+                                    const bool&);
+
    // Eror gradient
 
    void insert_gradient(LayerBackPropagation*, const Index& , Tensor<type, 1>&) const final;
 
    void calculate_error_gradient(type*, LayerForwardPropagation*, LayerBackPropagation*) const final;
 
-   void calculate_forget_weights_error_gradient(const Tensor<type, 2>&,
-                                                LongShortTermMemoryLayerForwardPropagation*,
-                                                LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_input_weights_error_gradient(const Tensor<type, 2>&,
-                                               LongShortTermMemoryLayerForwardPropagation*,
-                                               LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_state_weights_error_gradient(const Tensor<type, 2>&,
-                                               LongShortTermMemoryLayerForwardPropagation*,
-                                               LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_output_weights_error_gradient(const Tensor<type, 2>&,
-                                                LongShortTermMemoryLayerForwardPropagation*,
-                                                LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_forget_recurrent_weights_error_gradient(const Tensor<type, 2>&,
-                                                          LongShortTermMemoryLayerForwardPropagation*,
-                                                          LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_input_recurrent_weights_error_gradient(const Tensor<type, 2>&,
-                                                         LongShortTermMemoryLayerForwardPropagation*,
-                                                         LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_state_recurrent_weights_error_gradient(const Tensor<type, 2>&,
-                                                         LongShortTermMemoryLayerForwardPropagation*,
-                                                         LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_output_recurrent_weights_error_gradient(const Tensor<type, 2>&,
-                                                          LongShortTermMemoryLayerForwardPropagation*,
-                                                          LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_forget_biases_error_gradient(const Tensor<type, 2>&,
-                                               LongShortTermMemoryLayerForwardPropagation*,
-                                               LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_input_biases_error_gradient(const Tensor<type, 2>&,
-                                              LongShortTermMemoryLayerForwardPropagation*,
-                                              LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_state_biases_error_gradient(const Tensor<type, 2>&,
-                                              LongShortTermMemoryLayerForwardPropagation*,
-                                              LongShortTermMemoryLayerBackPropagation*) const;
-
-   void calculate_output_biases_error_gradient(const Tensor<type, 2>&,
-                                               LongShortTermMemoryLayerForwardPropagation*,
-                                               LongShortTermMemoryLayerBackPropagation*) const;
-
    // Expression methods
 
    string write_expression(const Tensor<string, 1>&, const Tensor<string, 1>&) const final;
@@ -289,6 +251,10 @@ protected:
 
    Index timesteps = 3;
 
+   /// Number of timesteps through which the errors are back propagated, or zero for the whole sequences.
+
+   Index truncation_length = 0;
+
    Tensor<type, 1> input_biases;
    Tensor<type, 1> forget_biases;
    Tensor<type, 1> state_biases;
@@ -315,6 +281,8 @@ protected:
    Tensor<type, 1> hidden_states;
    Tensor<type, 1> cell_states;
 
+   const Eigen::array<Index, 1> rows_sum = {Index(0)};
+
    /// Display messages to screen.
 
    bool display = true;
@@ -353,99 +321,158 @@ struct LongShortTermMemoryLayerForwardPropagation : LayerForwardPropagation
         outputs.resize(1);
         Tensor<Index, 1> output_dimensions(2);
         output_dimensions.setValues({batch_samples_number, neurons_number});
-        outputs(0).set_dimensions(output_dimensions);
+        set_buffer_dimensions(outputs(0), output_dimensions);
+
+        // Sequences
+
+        const Index timesteps = static_cast<LongShortTermMemoryLayer*>(layer_pointer)->get_timesteps();
+
+        set_sequences_number((batch_samples_number + timesteps - 1)/timesteps);
+
+        gates_biases.resize(4*neurons_number);
+        gates_weights.resize(inputs_number, 4*neurons_number);
+        gates_recurrent_weights.resize(neurons_number, 4*neurons_number);
+
+        Tensor<Index, 1> gates_combinations_dimensions(2);
+        gates_combinations_dimensions.setValues({batch_samples_number, 4*neurons_number});
+        set_buffer_dimensions(gates_combinations, gates_combinations_dimensions);
 
         // Rest of quantities
 
-        previous_hidden_state_activations.resize(neurons_number);
-        previous_cell_state_activations.resize(neurons_number);
+        set_samples_activations();
+    }
+
+
+    /// Sets the activations and the activations derivatives of each sample, which only the back propagation needs.
 
-        current_inputs.resize(inputs_number);
+    void set_samples_activations()
+    {
+        const Index neurons_number = layer_pointer->get_neurons_number();
 
-        current_forget_combinations.resize(neurons_number);
-        current_input_combinations.resize(neurons_number);
-        current_state_combinations.resize(neurons_number);
-        current_output_combinations.resize(neurons_number);
+        const Index samples_number = is_inference ? 0 : batch_samples_number;
 
-        current_forget_activations.resize(neurons_number);
-        current_input_activations.resize(neurons_number);
-        current_state_activations.resize(neurons_number);
-        current_output_activations.resize(neurons_number);
+        forget_activations.resize(samples_number, neurons_number);
+        input_activations.resize(samples_number, neurons_number);
+        state_activations.resize(samples_number, neurons_number);
+        output_activations.resize(samples_number, neurons_number);
+        cell_states_activations.resize(samples_number, neurons_number);
+        activated_cell_states.resize(samples_number, neurons_number);
+        hidden_states_activations.resize(samples_number, neurons_number);
 
-        current_cell_state_activations.resize(neurons_number);
+        forget_activations_derivatives.resize(samples_number, neurons_number);
+        input_activations_derivatives.resize(samples_number, neurons_number);
+        state_activations_derivatives.resize(samples_number, neurons_number);
+        output_activations_derivatives.resize(samples_number, neurons_number);
+        cell_states_activations_derivatives.resize(samples_number, neurons_number);
+        hidden_states_activations_derivatives.resize(samples_number, neurons_number);
 
-        current_forget_activations_derivatives.resize(neurons_number);
-        current_input_activations_derivatives.resize(neurons_number);
-        current_state_activations_derivatives.resize(neurons_number);
-        current_output_activations_derivatives.resize(neurons_number);
-        current_hidden_states_derivatives.resize(neurons_number);
+        combinations.resize(samples_number, neurons_number);
+    }
 
-        forget_activations.resize(batch_samples_number, neurons_number);
-        input_activations.resize(batch_samples_number, neurons_number);
-        state_activations.resize(batch_samples_number, neurons_number);
-        output_activations.resize(batch_samples_number, neurons_number);
-        cell_states_activations.resize(batch_samples_number, neurons_number);
-        hidden_states_activations.resize(batch_samples_number, neurons_number);
 
-        forget_activations_derivatives.resize(batch_samples_number, neurons_number);
-        input_activations_derivatives.resize(batch_samples_number, neurons_number);
-        state_activations_derivatives.resize(batch_samples_number, neurons_number);
-        output_activations_derivatives.resize(batch_samples_number, neurons_number);
-        cell_states_activations_derivatives.resize(batch_samples_number, neurons_number);
-        hidden_states_activations_derivatives.resize(batch_samples_number, neurons_number);
+    void set_sequences_number(const Index& sequences_number)
+    {
+        const Index neurons_number = layer_pointer->get_neurons_number();
 
-        combinations.resize(batch_samples_number, neurons_number);
+        hidden_states.resize(sequences_number, neurons_number);
+        cell_states.resize(sequences_number, neurons_number);
+
+        current_gates_combinations.resize(sequences_number, 4*neurons_number);
+        current_gates_activations.resize(sequences_number, 4*neurons_number);
+
+        current_activated_cell_states.resize(sequences_number, neurons_number);
+
+        const Index derivatives_sequences_number = is_inference ? 0 : sequences_number;
+
+        current_gates_activations_derivatives.resize(derivatives_sequences_number, 4*neurons_number);
+        current_hidden_states_activations_derivatives.resize(derivatives_sequences_number, neurons_number);
+
+        reset_states();
     }
 
-    void print() const
+
+    void reset_states() final
     {
-        cout << "Combinations: " << endl;
-        cout << combinations << endl;
+        hidden_states.setZero();
+        cell_states.setZero();
+    }
 
-        cout << "Current inputs: " << endl;
-        cout << current_inputs << endl;
 
-        cout << "Current input combinations: " << endl;
-        cout << current_input_combinations << endl;
+    Tensor<DynamicTensor<type>*, 1> get_workspaces() final
+    {
+        Tensor<DynamicTensor<type>*, 1> workspaces(1);
 
-        cout << "Current input activations: " << endl;
-        cout << current_input_activations << endl;
+        workspaces(0) = &gates_combinations;
 
-        cout << "Current input activations derivatives: " << endl;
-        cout << current_input_activations_derivatives << endl;
+        return workspaces;
+    }
+
+
+    /// The outputs and the gates combinations keep their memory, while the states of the sequences
+    /// and the activations of the samples, which depend on the number of samples, are allocated again.
+
+    void set_batch_samples_number(const Index& new_batch_samples_number) final
+    {
+        LayerForwardPropagation::set_batch_samples_number(new_batch_samples_number);
+
+        const Index timesteps = static_cast<LongShortTermMemoryLayer*>(layer_pointer)->get_timesteps();
+
+        set_sequences_number((batch_samples_number + timesteps - 1)/timesteps);
+
+        set_samples_activations();
+    }
+
+
+    void print() const
+    {
+        cout << "Gates combinations: " << endl;
+        cout << gates_combinations.to_tensor_map<2>() << endl;
+
+        cout << "Forget activations: " << endl;
+        cout << forget_activations << endl;
+
+        cout << "Cell states activations: " << endl;
+        cout << cell_states_activations << endl;
+
+        cout << "Hidden states activations: " << endl;
+        cout << hidden_states_activations << endl;
      }
 
     Tensor<type, 2> combinations;
 
-    Tensor<type, 1> previous_hidden_state_activations;
-    Tensor<type, 1> previous_cell_state_activations;
+    /// Hidden and cell states of the sequences being propagated, with one row for each sequence of the batch.
+
+    Tensor<type, 2> hidden_states;
+    Tensor<type, 2> cell_states;
+
+    /// Biases, weights and recurrent weights of the forget, input, state and output gates, side by side,
+    /// so that the four gates are calculated with a single matrix product.
+
+    Tensor<type, 1> gates_biases;
+    Tensor<type, 2> gates_weights;
+    Tensor<type, 2> gates_recurrent_weights;
 
-    Tensor<type, 1> current_inputs;
+    /// Combinations of the inputs of all the samples with the gates weights, plus the gates biases.
 
-    Tensor<type, 1> current_forget_combinations;
-    Tensor<type, 1> current_input_combinations;
-    Tensor<type, 1> current_state_combinations;
-    Tensor<type, 1> current_output_combinations;
+    DynamicTensor<type> gates_combinations;
 
-    Tensor<type, 1> current_forget_activations;
-    Tensor<type, 1> current_input_activations;
-    Tensor<type, 1> current_state_activations;
-    Tensor<type, 1> current_output_activations;
+    /// Combinations, activations and activations derivatives of the gates at the current timestep of each sequence.
 
-    Tensor<type, 1> current_forget_activations_derivatives;
-    Tensor<type, 1> current_input_activations_derivatives;
-    Tensor<type, 1> current_state_activations_derivatives;
-    Tensor<type, 1> current_output_activations_derivatives;
+    Tensor<type, 2> current_gates_combinations;
+    Tensor<type, 2> current_gates_activations;
+    Tensor<type, 2> current_gates_activations_derivatives;
 
-    Tensor<type, 1> current_hidden_states_derivatives;
+    Tensor<type, 2> current_activated_cell_states;
+    Tensor<type, 2> current_hidden_states_activations_derivatives;
 
-    Tensor<type, 1> current_cell_state_activations;
+    /// Activations of each sample, stored for the back propagation through time.
 
     Tensor<type, 2, RowMajor> forget_activations;
     Tensor<type, 2, RowMajor> input_activations;
     Tensor<type, 2, RowMajor> state_activations;
     Tensor<type, 2, RowMajor> output_activations;
     Tensor<type, 2, RowMajor> cell_states_activations;
+    Tensor<type, 2, RowMajor> activated_cell_states;
     Tensor<type, 2, RowMajor> hidden_states_activations;
 
     Tensor<type, 2, RowMajor> forget_activations_derivatives;
@@ -490,151 +517,82 @@ struct LongShortTermMemoryLayerBackPropagation : LayerBackPropagation
         //delete deltas_data;
         deltas_data = (type*)malloc(static_cast<size_t>(batch_samples_number*neurons_number*sizeof(type)));
 
-        current_layer_deltas.resize(neurons_number);
+        gates_biases_derivatives.resize(4*neurons_number);
+        gates_weights_derivatives.resize(inputs_number, 4*neurons_number);
+        gates_recurrent_weights_derivatives.resize(neurons_number, 4*neurons_number);
 
-        forget_weights_derivatives.resize(inputs_number*neurons_number);
-        input_weights_derivatives.resize(inputs_number*neurons_number);
-        state_weights_derivatives.resize(inputs_number*neurons_number);
-        output_weights_derivatives.resize(inputs_number*neurons_number);
+        gates_combinations_derivatives.resize(batch_samples_number, 4*neurons_number);
 
-        forget_recurrent_weights_derivatives.resize(neurons_number*neurons_number);
-        input_recurrent_weights_derivatives.resize(neurons_number*neurons_number);
-        state_recurrent_weights_derivatives.resize(neurons_number*neurons_number);
-        output_recurrent_weights_derivatives.resize(neurons_number*neurons_number);
+        const Index timesteps = static_cast<LongShortTermMemoryLayer*>(layer_pointer)->get_timesteps();
 
-        forget_biases_derivatives.resize(neurons_number);
-        input_biases_derivatives.resize(neurons_number);
-        state_biases_derivatives.resize(neurons_number);
-        output_biases_derivatives.resize(neurons_number);
-
-        input_combinations_biases_derivatives.resize(neurons_number, neurons_number);
-        forget_combinations_biases_derivatives.resize(neurons_number, neurons_number);
-        state_combinations_biases_derivatives.resize(neurons_number, neurons_number);
-        output_combinations_biases_derivatives.resize(neurons_number, neurons_number);
-
-        hidden_states_biases_derivatives.resize(neurons_number, neurons_number);
-        cell_state_biases_derivatives.resize(neurons_number, neurons_number);
+        set_sequences_number((batch_samples_number + timesteps - 1)/timesteps);
+    }
 
-        input_combinations_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
-        forget_combinations_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
-        state_combinations_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
-        output_combinations_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
 
-        hidden_states_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
-        cell_state_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
+    void set_sequences_number(const Index& sequences_number)
+    {
+        const Index neurons_number = layer_pointer->get_neurons_number();
 
-        input_combinations_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
-        forget_combinations_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
-        state_combinations_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
-        output_combinations_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
+        current_gates_combinations_derivatives.resize(sequences_number, 4*neurons_number);
 
-        hidden_states_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
-        cell_state_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
+        hidden_states_derivatives.resize(sequences_number, neurons_number);
+        cell_states_derivatives.resize(sequences_number, neurons_number);
 
+        previous_hidden_states.resize(sequences_number, neurons_number);
     }
 
+
     void print() const
     {
     }
 
     Tensor< TensorMap< Tensor<type, 1> >*, 1> get_layer_gradient()
     {
-        Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_gradient(30);
-
-        auto create_TensorMap_one_dim = [&](Tensor<type, 1> &v, size_t i)
-        {
-            layer_gradient(i) = new TensorMap<Tensor<type, 1>>(v.data(), v.size());
-        };
-
-        auto create_TensorMap_two_dims = [&](Tensor<type, 2> &v, size_t i)
-        {
-            layer_gradient(i) = new TensorMap<Tensor<type, 1>>(v.data(), v.size());
-        };
-
-        create_TensorMap_one_dim(input_biases_derivatives, 0);
-        create_TensorMap_one_dim(forget_biases_derivatives, 1);
-        create_TensorMap_one_dim(state_biases_derivatives, 2);
-        create_TensorMap_one_dim(output_biases_derivatives, 3);
-
-        create_TensorMap_one_dim(input_weights_derivatives, 4);
-        create_TensorMap_one_dim(forget_weights_derivatives, 5);
-        create_TensorMap_one_dim(state_weights_derivatives, 6);
-        create_TensorMap_one_dim(output_weights_derivatives, 7);
+        const Index inputs_number = layer_pointer->get_inputs_number();
+        const Index neurons_number = layer_pointer->get_neurons_number();
 
-        create_TensorMap_one_dim(input_recurrent_weights_derivatives, 8);
-        create_TensorMap_one_dim(forget_recurrent_weights_derivatives, 9);
-        create_TensorMap_one_dim(state_recurrent_weights_derivatives, 10);
-        create_TensorMap_one_dim(output_recurrent_weights_derivatives, 11);
+        Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_gradient(12);
 
-        create_TensorMap_two_dims(input_combinations_biases_derivatives, 12);
-        create_TensorMap_two_dims(forget_combinations_biases_derivatives, 13);
-        create_TensorMap_two_dims(state_combinations_biases_derivatives, 14);
-        create_TensorMap_two_dims(output_combinations_biases_derivatives, 15);
+        // Input, forget, state and output gates, as in get_layer_parameters()
 
-        create_TensorMap_two_dims(hidden_states_biases_derivatives, 16);
-        create_TensorMap_two_dims(cell_state_biases_derivatives, 17);
+        const Index gates_indices[4] = {1, 0, 2, 3};
 
-        create_TensorMap_two_dims(input_combinations_weights_derivatives, 18);
-        create_TensorMap_two_dims(forget_combinations_weights_derivatives, 19);
-        create_TensorMap_two_dims(state_combinations_weights_derivatives, 20);
-        create_TensorMap_two_dims(output_combinations_weights_derivatives, 21);
+        for(Index i = 0; i < 4; i++)
+        {
+            const Index gate_index = gates_indices[i];
 
-        create_TensorMap_two_dims(hidden_states_weights_derivatives, 22);
-        create_TensorMap_two_dims(cell_state_weights_derivatives, 23);
+            layer_gradient(i) = new TensorMap<Tensor<type, 1>>(gates_biases_derivatives.data() + gate_index*neurons_number,
+                                                               neurons_number);
 
-        create_TensorMap_two_dims(input_combinations_recurrent_weights_derivatives, 24);
-        create_TensorMap_two_dims(forget_combinations_recurrent_weights_derivatives, 25);
-        create_TensorMap_two_dims(state_combinations_recurrent_weights_derivatives, 26);
-        create_TensorMap_two_dims(output_combinations_recurrent_weights_derivatives, 27);
+            layer_gradient(4 + i) = new TensorMap<Tensor<type, 1>>(gates_weights_derivatives.data() + gate_index*inputs_number*neurons_number,
+                                                                   inputs_number*neurons_number);
 
-        create_TensorMap_two_dims(hidden_states_recurrent_weights_derivatives, 28);
-        create_TensorMap_two_dims(cell_state_recurrent_weights_derivatives, 29);
+            layer_gradient(8 + i) = new TensorMap<Tensor<type, 1>>(gates_recurrent_weights_derivatives.data() + gate_index*neurons_number*neurons_number,
+                                                                   neurons_number*neurons_number);
+        }
 
         return layer_gradient;
     }
 
+    /// Derivatives of the forget, input, state and output gates parameters, side by side as in the parameters.
 
+    Tensor<type, 1> gates_biases_derivatives;
+    Tensor<type, 2> gates_weights_derivatives;
+    Tensor<type, 2> gates_recurrent_weights_derivatives;
 
-    Tensor<type, 1> current_layer_deltas;
-
-    Tensor<type, 1> forget_weights_derivatives;
-    Tensor<type, 1> input_weights_derivatives;
-    Tensor<type, 1> state_weights_derivatives;
-    Tensor<type, 1> output_weights_derivatives;
-
-    Tensor<type, 1> forget_recurrent_weights_derivatives;
-    Tensor<type, 1> input_recurrent_weights_derivatives;
-    Tensor<type, 1> state_recurrent_weights_derivatives;
-    Tensor<type, 1> output_recurrent_weights_derivatives;
-
-    Tensor<type, 1> forget_biases_derivatives;
-    Tensor<type, 1> input_biases_derivatives;
-    Tensor<type, 1> state_biases_derivatives;
-    Tensor<type, 1> output_biases_derivatives;
-
-    Tensor<type, 2> input_combinations_biases_derivatives;
-    Tensor<type, 2> forget_combinations_biases_derivatives;
-    Tensor<type, 2> state_combinations_biases_derivatives;
-    Tensor<type, 2> output_combinations_biases_derivatives;
+    /// Derivatives of the error with respect to the gates combinations of each sample.
 
-    Tensor<type, 2> hidden_states_biases_derivatives;
-    Tensor<type, 2> cell_state_biases_derivatives;
+    Tensor<type, 2> gates_combinations_derivatives;
 
-    Tensor<type, 2> input_combinations_weights_derivatives;
-    Tensor<type, 2> forget_combinations_weights_derivatives;
-    Tensor<type, 2> state_combinations_weights_derivatives;
-    Tensor<type, 2> output_combinations_weights_derivatives;
+    /// Derivatives of the gates combinations, the hidden states and the cell states at the current timestep of each sequence,
+    /// back propagated from the following timesteps.
 
-    Tensor<type, 2> hidden_states_weights_derivatives;
-    Tensor<type, 2> cell_state_weights_derivatives;
+    Tensor<type, 2> current_gates_combinations_derivatives;
 
-    Tensor<type, 2> input_combinations_recurrent_weights_derivatives;
-    Tensor<type, 2> forget_combinations_recurrent_weights_derivatives;
-    Tensor<type, 2> state_combinations_recurrent_weights_derivatives;
-    Tensor<type, 2> output_combinations_recurrent_weights_derivatives;
+    Tensor<type, 2> hidden_states_derivatives;
+    Tensor<type, 2> cell_states_derivatives;
 
-    Tensor<type, 2> hidden_states_recurrent_weights_derivatives;
-    Tensor<type, 2> cell_state_recurrent_weights_derivatives;
+    Tensor<type, 2> previous_hidden_states;
 };
 
 
@@ -425,6 +425,7 @@ void LossIndex::back_propagate(const DataSetBatch& batch,
 
     assemble_layers_error_gradient(back_propagation);
 
+    assemble_gradient_segments(back_propagation);
 }
 
 
@@ -446,6 +447,10 @@ void LossIndex::back_propagate_lm(const DataSetBatch& batch,
 
     calculate_squared_errors_jacobian_lm(batch, forward_propagation, loss_index_back_propagation_lm);
 
+    if(loss_index_back_propagation_lm.double_precision)
+        loss_index_back_propagation_lm.squared_errors_jacobian_double.device(*thread_pool_device)
+                = loss_index_back_propagation_lm.squared_errors_jacobian.cast<double>();
+
     calculate_error_gradient_lm(batch, loss_index_back_propagation_lm);
 
     calculate_error_hessian_lm(batch, loss_index_back_propagation_lm);
@@ -468,7 +473,18 @@ void LossIndex::back_propagate_lm(const DataSetBatch& batch,
 
         calculate_regularization_hessian(loss_index_back_propagation_lm.parameters, loss_index_back_propagation_lm.regularization_hessian);
 
-        loss_index_back_propagation_lm.hessian += regularization_weight*loss_index_back_propagation_lm.regularization_hessian;
+        if(loss_index_back_propagation_lm.double_precision)
+        {
+            loss_index_back_propagation_lm.gradient_double.device(*thread_pool_device)
+                    += double(regularization_weight)*loss_index_back_propagation_lm.regularization_gradient.cast<double>();
+
+            loss_index_back_propagation_lm.hessian_double.device(*thread_pool_device)
+                    += double(regularization_weight)*loss_index_back_propagation_lm.regularization_hessian.cast<double>();
+        }
+        else
+        {
+            loss_index_back_propagation_lm.hessian += regularization_weight*loss_index_back_propagation_lm.regularization_hessian;
+        }
     }
 }
 
@@ -587,6 +603,37 @@ void LossIndex::calculate_error_gradient_lm(const DataSetBatch& batch,
 {
     loss_index_back_propagation_lm.gradient.device(*thread_pool_device)
             = loss_index_back_propagation_lm.squared_errors_jacobian.contract(loss_index_back_propagation_lm.squared_errors, AT_B);
+
+    if(loss_index_back_propagation_lm.double_precision)
+        calculate_error_gradient_lm_double(type(1), loss_index_back_propagation_lm);
+}
+
+
+/// Accumulates the gradient of the error terms in double precision, from the double precision squared errors Jacobian.
+/// @param coefficient Factor of the error term.
+/// @param loss_index_back_propagation_lm Levenberg-Marquardt back-propagation, with the double precision members set.
+
+void LossIndex::calculate_error_gradient_lm_double(const type& coefficient,
+                                                   LossIndexBackPropagationLM& loss_index_back_propagation_lm) const
+{
+    const Tensor<double, 1> squared_errors = loss_index_back_propagation_lm.squared_errors.cast<double>();
+
+    loss_index_back_propagation_lm.gradient_double.device(*thread_pool_device)
+            = double(coefficient)*loss_index_back_propagation_lm.squared_errors_jacobian_double.contract(squared_errors, AT_B);
+}
+
+
+/// Accumulates the Hessian approximation of the error terms in double precision, from the double precision squared errors Jacobian.
+/// @param coefficient Factor of the error term.
+/// @param loss_index_back_propagation_lm Levenberg-Marquardt back-propagation, with the double precision members set.
+
+void LossIndex::calculate_error_hessian_lm_double(const type& coefficient,
+                                                  LossIndexBackPropagationLM& loss_index_back_propagation_lm) const
+{
+    const Tensor<double, 2>& squared_errors_jacobian = loss_index_back_propagation_lm.squared_errors_jacobian_double;
+
+    loss_index_back_propagation_lm.hessian_double.device(*thread_pool_device)
+            = double(coefficient)*squared_errors_jacobian.contract(squared_errors_jacobian, AT_B);
 }
 
 
@@ -713,6 +760,12 @@ void LossIndex::calculate_layers_delta(const DataSetBatch& batch,
     calculate_output_delta(batch,forward_propagation,
                            back_propagation);
 
+    if(!neural_network_pointer->is_sequential())
+    {
+        calculate_layers_delta_graph(batch, forward_propagation, back_propagation);
+        return;
+    }
+
     // Hidden layers
 
     for(Index i = static_cast<Index>(trainable_layers_number)-2; i >= 0; i--)
@@ -725,6 +778,154 @@ void LossIndex::calculate_layers_delta(const DataSetBatch& batch,
 }
 
 
+/// Calculates the deltas of the hidden layers of a neural network whose layers form a graph.
+/// The layers are visited level by level, from the outputs to the inputs.
+/// The layers of the same level are calculated one after the other, as each of them uses all the threads of the device,
+/// and several of them can take the deltas of the same next layer.
+/// The delta of a layer is the sum of the contributions of all the trainable layers which take its outputs.
+/// Addition layers pass their deltas to each input, and concatenation layers pass the block of their deltas corresponding to each input.
+/// Multi-head attention layers with several inputs pass the derivatives of the query, key or value to the layer which gives it.
+
+void LossIndex::calculate_layers_delta_graph(const DataSetBatch& batch,
+                                             NeuralNetworkForwardPropagation& forward_propagation,
+                                             LossIndexBackPropagation& back_propagation) const
+{
+    const Index layers_number = neural_network_pointer->get_layers_number();
+
+    const Tensor<Layer*, 1> layers_pointers = neural_network_pointer->get_layers_pointers();
+
+    const Tensor<Index, 1> trainable_layers_indices = neural_network_pointer->get_trainable_layers_indices();
+
+    const Index trainable_layers_number = trainable_layers_indices.size();
+
+    const Index first_trainable_layer_index = trainable_layers_indices(0);
+    const Index last_trainable_layer_index = trainable_layers_indices(trainable_layers_number-1);
+
+    const Tensor<Tensor<Index, 1>, 1>& layers_outputs_indices = neural_network_pointer->get_layers_outputs_indices();
+
+    const Tensor<Tensor<Index, 1>, 1>& layers_execution_levels = neural_network_pointer->get_layers_execution_levels();
+
+    // Position of each layer in the back-propagation structure, -1 if it is not trainable
+
+    Tensor<Index, 1> layers_trainable_indices(layers_number);
+    layers_trainable_indices.setConstant(-1);
+
+    for(Index i = 0; i < trainable_layers_number; i++) layers_trainable_indices(trainable_layers_indices(i)) = i;
+
+    for(Index level = layers_execution_levels.size()-1; level >= 0; level--)
+    {
+        const Tensor<Index, 1>& level_layers_indices = layers_execution_levels(level);
+
+        const Index level_layers_number = level_layers_indices.size();
+
+        for(Index i = 0; i < level_layers_number; i++)
+        {
+            const Index layer_index = level_layers_indices(i);
+
+            if(layer_index < first_trainable_layer_index || layer_index >= last_trainable_layer_index) continue;
+
+            if(layers_trainable_indices(layer_index) == -1) continue;
+
+            LayerBackPropagation* layer_back_propagation = back_propagation.neural_network.layers(layers_trainable_indices(layer_index));
+
+            const Index deltas_size = forward_propagation.layers(layer_index)->outputs(0).get_size();
+
+            TensorMap<Tensor<type, 1>> deltas(layer_back_propagation->deltas_data, deltas_size);
+
+            Tensor<type, 1> previous_deltas;
+
+            bool has_deltas = false;
+
+            const Tensor<Index, 1>& layer_outputs_indices = layers_outputs_indices(layer_index);
+
+            for(Index j = 0; j < layer_outputs_indices.size(); j++)
+            {
+                const Index next_layer_index = layer_outputs_indices(j);
+
+                if(next_layer_index > last_trainable_layer_index || layers_trainable_indices(next_layer_index) == -1) continue;
+
+                // Each layer appears once in the outputs indices for each time it is an input of the next layer
+
+                if(j > 0 && layer_outputs_indices(j-1) == next_layer_index) continue;
+
+                LayerBackPropagation* next_layer_back_propagation = back_propagation.neural_network.layers(layers_trainable_indices(next_layer_index));
+
+                const Layer::Type next_layer_type = layers_pointers(next_layer_index)->get_type();
+
+                const Tensor<Index, 1> next_layer_inputs_indices = neural_network_pointer->get_layer_inputs_indices(next_layer_index);
+
+                if(next_layer_type == Layer::Type::MultiheadAttention && next_layer_inputs_indices.size() > 1)
+                {
+                    const MultiheadAttentionLayer* multihead_attention_layer_pointer
+                            = static_cast<MultiheadAttentionLayer*>(layers_pointers(next_layer_index));
+
+                    for(Index k = 0; k < next_layer_inputs_indices.size(); k++)
+                    {
+                        if(next_layer_inputs_indices(k) != layer_index) continue;
+
+                        if(has_deltas) previous_deltas = deltas;
+
+                        multihead_attention_layer_pointer->calculate_inputs_deltas(forward_propagation.layers(next_layer_index),
+                                                                                   next_layer_back_propagation,
+                                                                                   k,
+                                                                                   layer_back_propagation->deltas_data);
+
+                        if(has_deltas) deltas += previous_deltas;
+
+                        has_deltas = true;
+                    }
+                }
+                else if(next_layer_type == Layer::Type::Addition || next_layer_type == Layer::Type::Concatenation)
+                {
+                    Index offset = 0;
+
+                    for(Index k = 0; k < next_layer_inputs_indices.size(); k++)
+                    {
+                        const Index input_index = next_layer_inputs_indices(k);
+
+                        if(input_index == layer_index)
+                        {
+                            const TensorMap<Tensor<type, 1>> next_deltas(next_layer_back_propagation->deltas_data + offset, deltas_size);
+
+                            if(has_deltas)
+                            {
+                                deltas += next_deltas;
+                            }
+                            else
+                            {
+                                deltas = next_deltas;
+                                has_deltas = true;
+                            }
+                        }
+
+                        if(next_layer_type == Layer::Type::Concatenation)
+                        {
+                            offset += input_index < first_trainable_layer_index
+                                    ? batch.inputs(0).get_size()
+                                    : forward_propagation.layers(input_index)->outputs(0).get_size();
+                        }
+                    }
+                }
+                else
+                {
+                    if(has_deltas) previous_deltas = deltas;
+
+                    layers_pointers(layer_index)->calculate_hidden_delta(forward_propagation.layers(next_layer_index),
+                                                                         next_layer_back_propagation,
+                                                                         layer_back_propagation);
+
+                    if(has_deltas) deltas += previous_deltas;
+
+                    has_deltas = true;
+                }
+            }
+
+            if(!has_deltas) deltas.setZero();
+        }
+    }
+}
+
+
 void LossIndex::calculate_layers_delta_lm(const DataSetBatch& batch,
                                           NeuralNetworkForwardPropagation& forward_propagation,
                                           LossIndexBackPropagationLM& back_propagation) const
@@ -775,6 +976,39 @@ void LossIndex::calculate_layers_error_gradient(const DataSetBatch& batch,
     const Tensor<Index, 1> trainable_layers_parameters_number
             = neural_network_pointer->get_trainable_layers_parameters_numbers();
 
+    if(!neural_network_pointer->is_sequential())
+    {
+        // Each layer takes views of the outputs of all its inputs layers, or of the batch inputs, as in the forward propagation
+
+        const Tensor<Index, 1> trainable_layers_indices = neural_network_pointer->get_trainable_layers_indices();
+
+        for(Index i = 0; i < trainable_layers_number; i++)
+        {
+            const Index layer_index = trainable_layers_indices(i);
+
+            const Tensor<Index, 1> layer_inputs_indices = neural_network_pointer->get_layer_inputs_indices(layer_index);
+
+            const Index layer_inputs_number = max(layer_inputs_indices.size(), Index(1));
+
+            Tensor<DynamicTensor<type>, 1> layer_inputs(layer_inputs_number);
+
+            for(Index j = 0; j < layer_inputs_number; j++)
+            {
+                const DynamicTensor<type>& input = layer_inputs_indices.size() == 0 || layer_inputs_indices(j) < first_trainable_layers_index
+                        ? batch.inputs(0)
+                        : forward_propagation.layers(layer_inputs_indices(j))->outputs(0);
+
+                layer_inputs(j).set_view(input.get_data(), input.get_dimensions());
+            }
+
+            trainable_layers_pointers(i)->calculate_error_gradient(layer_inputs,
+                                                                   forward_propagation.layers(layer_index),
+                                                                   back_propagation.neural_network.layers(i));
+        }
+
+        return;
+    }
+
     trainable_layers_pointers(0)->calculate_error_gradient(batch.inputs(0).get_data(),
                                                            forward_propagation.layers(first_trainable_layers_index),
                                                            back_propagation.neural_network.layers(0));
@@ -847,6 +1081,37 @@ void LossIndex::assemble_layers_error_gradient(LossIndexBackPropagation& back_pr
 }
 
 
+/// Assembles the segments of the gradient where the layers error gradients can be nonzero.
+/// The segments are left empty, meaning a dense gradient, unless some layer has a sparse gradient and there is no regularization.
+
+void LossIndex::assemble_gradient_segments(LossIndexBackPropagation& back_propagation) const
+{
+    back_propagation.gradient_segments.clear();
+
+    if(regularization_method != RegularizationMethod::NoRegularization) return;
+
+    if(!neural_network_pointer->has_sparse_gradient()) return;
+
+    const Tensor<Layer*, 1> trainable_layers_pointers = neural_network_pointer->get_trainable_layers_pointers();
+
+    const Index trainable_layers_number = trainable_layers_pointers.size();
+
+    const Tensor<Index, 1> trainable_layers_parameters_number
+            = neural_network_pointer->get_trainable_layers_parameters_numbers();
+
+    Index index = 0;
+
+    for(Index i = 0; i < trainable_layers_number; i++)
+    {
+        trainable_layers_pointers(i)->insert_gradient_segments(back_propagation.neural_network.layers(i),
+                                                               index,
+                                                               back_propagation.gradient_segments);
+
+        index += trainable_layers_parameters_number(i);
+    }
+}
+
+
 /// Serializes a default error term object into an XML document of the TinyXML library without keeping the DOM tree in memory.
 /// See the OpenNN manual for more information about the format of this document.
 
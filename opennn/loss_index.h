@@ -175,12 +175,18 @@ public:
                                NeuralNetworkForwardPropagation&,
                                LossIndexBackPropagation&) const;
 
+   void calculate_layers_delta_graph(const DataSetBatch&,
+                                     NeuralNetworkForwardPropagation&,
+                                     LossIndexBackPropagation&) const;
+
    void calculate_layers_error_gradient(const DataSetBatch&,
                                  const NeuralNetworkForwardPropagation&,
                                  LossIndexBackPropagation&) const;
 
    void assemble_layers_error_gradient(LossIndexBackPropagation&) const;
 
+   void assemble_gradient_segments(LossIndexBackPropagation&) const;
+
    void back_propagate(const DataSetBatch&,
                        NeuralNetworkForwardPropagation&,
                        LossIndexBackPropagation&) const;
@@ -217,6 +223,10 @@ public:
    virtual void calculate_error_hessian_lm(const DataSetBatch&,
                                            LossIndexBackPropagationLM&) const {}
 
+   void calculate_error_gradient_lm_double(const type&, LossIndexBackPropagationLM&) const;
+
+   void calculate_error_hessian_lm_double(const type&, LossIndexBackPropagationLM&) const;
+
    void back_propagate_lm(const DataSetBatch&,
                           NeuralNetworkForwardPropagation&,
                           LossIndexBackPropagationLM&) const;
@@ -312,6 +322,10 @@ struct LossIndexBackPropagation
 
         NeuralNetwork* neural_network_pointer = loss_index_pointer->get_neural_network_pointer();
 
+        // Training needs the floating point weights of the quantized layers
+
+        neural_network_pointer->dequantize();
+
         const Index parameters_number = neural_network_pointer->get_parameters_number();
 
         const Index outputs_number = neural_network_pointer->get_outputs_number();
@@ -372,6 +386,12 @@ struct LossIndexBackPropagation
 
     Tensor<type, 1> gradient;
     Tensor<type, 1> regularization_gradient;
+
+    /// Segments of the gradient, as pairs of first index and size, out of which the gradient is zero.
+    /// They are only assembled when the neural network has layers with sparse gradients and there is no regularization,
+    /// and are used by the optimization algorithms to update only the touched parameters.
+
+    vector<pair<Index, Index>> gradient_segments;
 };
 
 
@@ -401,6 +421,10 @@ struct LossIndexBackPropagationLM
 
         NeuralNetwork* neural_network_pointer = loss_index_pointer->get_neural_network_pointer();
 
+        // Training needs the floating point weights of the quantized layers
+
+        neural_network_pointer->dequantize();
+
         const Index parameters_number = neural_network_pointer->get_parameters_number();
 
         const Index outputs_number = neural_network_pointer->get_outputs_number();
@@ -420,14 +444,42 @@ struct LossIndexBackPropagationLM
 
         squared_errors_jacobian.resize(batch_samples_number, parameters_number);
 
-        hessian.resize(parameters_number, parameters_number);
-
         regularization_hessian.resize(parameters_number, parameters_number);
         regularization_hessian.setZero();
 
         errors.resize(batch_samples_number, outputs_number);
 
         squared_errors.resize(batch_samples_number);
+
+        set_double_precision(double_precision);
+    }
+
+    /// Sets whether the gradient and the Hessian are accumulated in double precision.
+    /// In double precision the Hessian of the library type is not allocated.
+    /// @param new_double_precision True to accumulate in double precision, false to accumulate in the library type.
+
+    void set_double_precision(const bool& new_double_precision)
+    {
+        double_precision = new_double_precision;
+
+        const Index parameters_number = gradient.size();
+
+        if(double_precision)
+        {
+            hessian.resize(0, 0);
+
+            squared_errors_jacobian_double.resize(batch_samples_number, parameters_number);
+            gradient_double.resize(parameters_number);
+            hessian_double.resize(parameters_number, parameters_number);
+        }
+        else
+        {
+            hessian.resize(parameters_number, parameters_number);
+
+            squared_errors_jacobian_double.resize(0, 0);
+            gradient_double.resize(0);
+            hessian_double.resize(0, 0);
+        }
     }
 
     void print() const
@@ -477,6 +529,17 @@ struct LossIndexBackPropagationLM
 
     Tensor<type, 1> regularization_gradient;
     Tensor<type, 2> regularization_hessian;
+
+    /// True if the gradient and the Hessian are also accumulated in double precision.
+
+    bool double_precision = false;
+
+    // Double precision data
+
+    Tensor<double, 2> squared_errors_jacobian_double;
+
+    Tensor<double, 1> gradient_double;
+    Tensor<double, 2> hessian_double;
 };
 
 
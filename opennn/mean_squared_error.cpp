@@ -184,6 +184,9 @@ void MeanSquaredError::calculate_error_gradient_lm(const DataSetBatch& batch,
 
     loss_index_back_propagation_lm.gradient.device(*thread_pool_device)
             = coefficient * loss_index_back_propagation_lm.gradient;
+
+    if(loss_index_back_propagation_lm.double_precision)
+        calculate_error_gradient_lm_double(coefficient, loss_index_back_propagation_lm);
 }
 
 
@@ -200,6 +203,13 @@ void MeanSquaredError::calculate_error_hessian_lm(const DataSetBatch& batch,
 
      const type coefficient = (static_cast<type>(2.0)/static_cast<type>(batch_samples_number));
 
+     if(loss_index_back_propagation_lm.double_precision)
+     {
+         calculate_error_hessian_lm_double(coefficient, loss_index_back_propagation_lm);
+
+         return;
+     }
+
      loss_index_back_propagation_lm.hessian.device(*thread_pool_device)
              = loss_index_back_propagation_lm.squared_errors_jacobian.contract(loss_index_back_propagation_lm.squared_errors_jacobian, AT_B);
 
@@ -0,0 +1,393 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   M I X E D   P R E C I S I O N   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef MIXEDPRECISION_H
+#define MIXEDPRECISION_H
+
+// System includes
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// OpenNN includes
+
+#include "config.h"
+
+namespace opennn
+{
+
+// Storage of floating point values in 16 bits, which are converted to single precision for the arithmetic.
+// Brain floating point (bfloat16) keeps the 8 exponent bits of single precision and 7 mantissa bits,
+// so it has the same range and about 3 significant digits.
+// Half precision (IEEE 754 binary16) has 5 exponent bits and 10 mantissa bits,
+// so it has about 4 significant digits but overflows above 65504,
+// which is why the gradients need loss scaling when they are rounded to half precision.
+// Only the synaptic weights of the perceptron and probabilistic layers are actually stored in 16 bits, for inference.
+// Training in these precisions is emulated, by rounding single precision values to them.
+
+/// Enumeration of the precisions in which values can be stored.
+
+enum class Precision{Single, BFloat16, Half};
+
+
+/// Returns the name of a precision.
+
+inline string write_precision(const Precision& precision)
+{
+    switch(precision)
+    {
+    case Precision::Single: return "Single";
+
+    case Precision::BFloat16: return "BFloat16";
+
+    case Precision::Half: return "Half";
+
+    default: return string();
+    }
+}
+
+
+/// Returns the bits of the nearest brain floating point number to a single precision value, with ties to even.
+
+inline uint16_t float_to_bfloat16(const float& value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+
+    if((bits & 0x7FFFFFFF) > 0x7F800000) return static_cast<uint16_t>((bits >> 16) | 0x0040);
+
+    bits += 0x7FFF + ((bits >> 16) & 1);
+
+    return static_cast<uint16_t>(bits >> 16);
+}
+
+
+/// Returns the single precision value of the bits of a brain floating point number, which is exact.
+
+inline float bfloat16_to_float(const uint16_t& value)
+{
+    const uint32_t bits = static_cast<uint32_t>(value) << 16;
+
+    float single;
+    memcpy(&single, &bits, sizeof(float));
+
+    return single;
+}
+
+
+/// Returns the bits of the nearest half precision number to a single precision value, with ties to even.
+/// Values above the half precision range overflow to infinity.
+
+inline uint16_t float_to_half(const float& value)
+{
+    return static_cast<uint16_t>(half_float::detail::float2half<std::round_to_nearest>(value));
+}
+
+
+/// Returns the single precision value of the bits of a finite half precision number, which is exact.
+/// The sign, exponent and mantissa are moved to their single precision positions, and the multiplication by 2^112
+/// corrects the exponent bias, including for subnormal numbers, without branches.
+
+inline float finite_half_to_float(const uint16_t& value)
+{
+    const uint32_t bits = (static_cast<uint32_t>(value & 0x8000) << 16) | (static_cast<uint32_t>(value & 0x7FFF) << 13);
+
+    float single;
+    memcpy(&single, &bits, sizeof(float));
+
+    return single*5.192296858534828e33f;
+}
+
+
+/// Returns the single precision value of the bits of a half precision number, which is exact.
+
+inline float half_to_float(const uint16_t& value)
+{
+    if((value & 0x7C00) != 0x7C00) return finite_half_to_float(value);
+
+    // Infinity and not a number keep the maximum exponent
+
+    const uint32_t bits = (static_cast<uint32_t>(value & 0x8000) << 16) | 0x7F800000 | (static_cast<uint32_t>(value & 0x03FF) << 13);
+
+    float single;
+    memcpy(&single, &bits, sizeof(float));
+
+    return single;
+}
+
+
+/// Returns the nearest value to a given one which can be stored in a given precision.
+
+inline type round_to_precision(const type& value, const Precision& precision)
+{
+    switch(precision)
+    {
+    case Precision::BFloat16: return type(bfloat16_to_float(float_to_bfloat16(float(value))));
+
+    case Precision::Half: return type(half_to_float(float_to_half(float(value))));
+
+    default: return value;
+    }
+}
+
+
+/// Rounds the values of a vector to the nearest ones which can be stored in a given precision.
+
+inline void round_to_precision(Tensor<type, 1>& values, const Precision& precision)
+{
+    if(precision == Precision::Single) return;
+
+    const Index size = values.size();
+
+    type* values_data = values.data();
+
+    #pragma omp parallel for
+    for(Index i = 0; i < size; i++)
+        values_data[i] = round_to_precision(values_data[i], precision);
+}
+
+
+/// Synaptic weights of a layer stored in 16 bits, which halves the memory read by the matrix product.
+/// The weights are stored in panels of 16 neurons, where the weights of the neurons of a panel for each input are contiguous,
+/// so that the products for the neurons of a panel are calculated in the lanes of vector instructions.
+
+struct ReducedPrecisionSynapticWeights
+{
+    /// Stores the synaptic weights of a layer in a reduced precision.
+    /// Weights out of the half precision range are saturated, so that the stored weights are finite.
+    /// @param synaptic_weights Synaptic weights, with dimensions inputs number and neurons number.
+    /// @param new_precision Precision of the stored weights. Single precision removes the stored weights.
+
+    void set(const Tensor<type, 2>& synaptic_weights, const Precision& new_precision)
+    {
+        if(new_precision == Precision::Single)
+        {
+            set();
+            return;
+        }
+
+        precision = new_precision;
+
+        inputs_number = synaptic_weights.dimension(0);
+        neurons_number = synaptic_weights.dimension(1);
+
+        const Index panels_number = (neurons_number + panel_size - 1)/panel_size;
+
+        weights.resize(panels_number*panel_size*inputs_number);
+        weights.setZero();
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            uint16_t* panel_data = weights.data() + (j/panel_size)*panel_size*inputs_number;
+
+            for(Index i = 0; i < inputs_number; i++)
+                panel_data[i*panel_size + j%panel_size] = precision == Precision::BFloat16
+                        ? float_to_bfloat16(float(synaptic_weights(i, j)))
+                        : float_to_half(min(max(float(synaptic_weights(i, j)), -maximum_half), maximum_half));
+        }
+    }
+
+
+    /// Stores new synaptic weights in the current precision, if it is a reduced one.
+
+    void update(const Tensor<type, 2>& synaptic_weights)
+    {
+        if(precision == Precision::Single) return;
+
+        set(synaptic_weights, precision);
+    }
+
+
+    /// Removes the stored weights, and sets single precision.
+
+    void set()
+    {
+        precision = Precision::Single;
+
+        inputs_number = 0;
+        neurons_number = 0;
+
+        weights.resize(0);
+    }
+
+
+    /// Returns true if there are no weights stored in a reduced precision.
+
+    bool empty() const
+    {
+        return weights.size() == 0;
+    }
+
+
+    /// Returns true if the matrix product of a batch is faster with the weights in reduced precision.
+    /// Products of a few samples are limited by the memory read for the weights, while those of many samples
+    /// are limited by the arithmetic, where the single precision contraction is faster.
+
+    bool is_faster(const Index& batch_samples_number) const
+    {
+        return !empty() && batch_samples_number <= maximum_batch_samples_number;
+    }
+
+
+    /// Returns the stored weights converted to single precision, with dimensions inputs number and neurons number.
+
+    Tensor<type, 2> get_synaptic_weights() const
+    {
+        Tensor<type, 2> synaptic_weights(inputs_number, neurons_number);
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            const uint16_t* panel_data = weights.data() + (j/panel_size)*panel_size*inputs_number;
+
+            for(Index i = 0; i < inputs_number; i++)
+                synaptic_weights(i, j) = type(convert(panel_data[i*panel_size + j%panel_size]));
+        }
+
+        return synaptic_weights;
+    }
+
+
+    /// Calculates the product of the inputs and the stored synaptic weights, accumulating in single precision.
+    /// @param inputs Inputs, with dimensions batch samples number and inputs number.
+    /// @param combinations_data Products, with dimensions batch samples number and neurons number.
+
+    void multiply(const TensorMap<Tensor<type, 2>>& inputs, type* combinations_data) const
+    {
+        if(precision == Precision::BFloat16)
+        {
+            multiply(inputs, combinations_data, [](const uint16_t& value){return bfloat16_to_float(value);});
+        }
+        else
+        {
+            multiply(inputs, combinations_data, [](const uint16_t& value){return finite_half_to_float(value);});
+        }
+    }
+
+
+    /// Returns the single precision value of a stored weight.
+
+    float convert(const uint16_t& value) const
+    {
+        return precision == Precision::BFloat16 ? bfloat16_to_float(value) : half_to_float(value);
+    }
+
+
+    /// Calculates the product of the inputs and the stored synaptic weights, converting them with a given function.
+    /// Each thread calculates blocks of 4 samples and a panel of neurons.
+
+    template<class Conversion>
+    void multiply(const TensorMap<Tensor<type, 2>>& inputs, type* combinations_data, const Conversion& conversion) const
+    {
+        const Index batch_samples_number = inputs.dimension(0);
+
+        // Inputs are stored by samples, padded to whole blocks, so that the inputs of each sample are contiguous
+
+        const Index padded_samples_number = (batch_samples_number + 3)/4*4;
+
+        Tensor<float, 2> samples_inputs(inputs_number, padded_samples_number);
+        samples_inputs.setZero();
+
+        for(Index i = 0; i < inputs_number; i++)
+            for(Index k = 0; k < batch_samples_number; k++)
+                samples_inputs(i, k) = float(inputs(k, i));
+
+        const float* samples_inputs_data = samples_inputs.data();
+
+        const Index panels_number = (neurons_number + panel_size - 1)/panel_size;
+
+        #pragma omp parallel for
+        for(Index panel = 0; panel < panels_number; panel++)
+        {
+            const uint16_t* panel_data = weights.data() + panel*panel_size*inputs_number;
+
+            const Index first_neuron = panel*panel_size;
+            const Index panel_neurons_number = min(panel_size, neurons_number - first_neuron);
+
+            for(Index k = 0; k < batch_samples_number; k += 4)
+            {
+                const float* inputs_0 = samples_inputs_data + k*inputs_number;
+                const float* inputs_1 = inputs_0 + inputs_number;
+                const float* inputs_2 = inputs_1 + inputs_number;
+                const float* inputs_3 = inputs_2 + inputs_number;
+
+                float sums[4][panel_size] = {};
+
+                for(Index i = 0; i < inputs_number; i++)
+                {
+                    const uint16_t* input_weights = panel_data + i*panel_size;
+
+                    const float input_0 = inputs_0[i];
+                    const float input_1 = inputs_1[i];
+                    const float input_2 = inputs_2[i];
+                    const float input_3 = inputs_3[i];
+
+                    for(Index l = 0; l < panel_size; l++)
+                    {
+                        const float weight = conversion(input_weights[l]);
+
+                        sums[0][l] += input_0*weight;
+                        sums[1][l] += input_1*weight;
+                        sums[2][l] += input_2*weight;
+                        sums[3][l] += input_3*weight;
+                    }
+                }
+
+                const Index block_samples_number = min(Index(4), batch_samples_number - k);
+
+                for(Index l = 0; l < panel_neurons_number; l++)
+                    for(Index m = 0; m < block_samples_number; m++)
+                        combinations_data[k + m + batch_samples_number*(first_neuron + l)] = type(sums[m][l]);
+            }
+        }
+    }
+
+    /// Maximum finite half precision value.
+
+    static constexpr float maximum_half = 65504.0f;
+
+    /// Number of neurons in each panel of weights.
+
+    static constexpr Index panel_size = 16;
+
+    /// Maximum number of samples of a batch for which the product in reduced precision is used.
+
+    static constexpr Index maximum_batch_samples_number = 4;
+
+    Precision precision = Precision::Single;
+
+    Index inputs_number = 0;
+    Index neurons_number = 0;
+
+    /// Bits of the synaptic weights in reduced precision, in panels of neurons.
+
+    Tensor<uint16_t, 1> weights;
+};
+
+}
+
+#endif // MIXEDPRECISION_H
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -74,6 +74,35 @@ Index MultiheadAttentionLayer::get_number_of_heads() const
 }
 
 
+/// Returns true if each input position only attends to the context positions up to its own,
+/// and false if it attends to the whole context.
+
+bool MultiheadAttentionLayer::get_causal_mask() const
+{
+    return causal_mask;
+}
+
+
+/// Returns the dimensions of the query, input size and depth.
+
+Tensor<Index, 1> MultiheadAttentionLayer::get_inputs_dimensions() const
+{
+    Tensor<Index, 1> inputs_dimensions(2);
+
+    inputs_dimensions.setValues({input_size, depth});
+
+    return inputs_dimensions;
+}
+
+
+/// Returns the dimensions of the outputs, which are those of the query.
+
+Tensor<Index, 1> MultiheadAttentionLayer::get_outputs_dimensions() const
+{
+    return get_inputs_dimensions();
+}
+
+
 /// Returns linear transformation kernels
 
 Tensor<type, 3> MultiheadAttentionLayer::get_query_kernel() const
@@ -108,6 +137,49 @@ Index MultiheadAttentionLayer::get_parameters_number() const
 }
 
 
+/// Returns the parameters of the layer, which are the query, key, value and projection kernels, one after the other.
+
+Tensor<type, 1> MultiheadAttentionLayer::get_parameters() const
+{
+    Tensor<type, 1> parameters(get_parameters_number());
+
+    const Tensor<type, 3>* kernels[4] = {&query_kernel, &key_kernel, &value_kernel, &projection_kernel};
+
+    Index index = 0;
+
+    for(Index i = 0; i < 4; i++)
+    {
+        copy(kernels[i]->data(), kernels[i]->data() + kernels[i]->size(), parameters.data() + index);
+
+        index += kernels[i]->size();
+    }
+
+    return parameters;
+}
+
+
+Tensor< TensorMap< Tensor<type, 1> >*, 1> MultiheadAttentionLayer::get_layer_parameters()
+{
+    Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_parameters(4);
+
+    layer_parameters(0) = new TensorMap<Tensor<type, 1>>(query_kernel.data(), query_kernel.size());
+    layer_parameters(1) = new TensorMap<Tensor<type, 1>>(key_kernel.data(), key_kernel.size());
+    layer_parameters(2) = new TensorMap<Tensor<type, 1>>(value_kernel.data(), value_kernel.size());
+    layer_parameters(3) = new TensorMap<Tensor<type, 1>>(projection_kernel.data(), projection_kernel.size());
+
+    return layer_parameters;
+}
+
+
+/// Returns true if the attention scores are calculated again in the back propagation,
+/// and false if they are stored by the forward propagation.
+
+bool MultiheadAttentionLayer::get_recompute_attention_scores() const
+{
+    return recompute_attention_scores;
+}
+
+
 /// Returns true if messages from this class are displayed on the screen,
 /// or false if messages from this class are not displayed on the screen.
 
@@ -214,6 +286,28 @@ void MultiheadAttentionLayer::set_number_of_heads(const Index& new_number_of_hea
 }
 
 
+/// Sets whether each input position only attends to the context positions up to its own.
+/// The last input position is aligned with the last context position,
+/// so that the context can hold positions previous to the inputs.
+/// @param new_causal_mask True to mask the following context positions.
+
+void MultiheadAttentionLayer::set_causal_mask(const bool& new_causal_mask)
+{
+    causal_mask = new_causal_mask;
+}
+
+
+/// Sets whether the attention scores are calculated again in the back propagation.
+/// The scores take batch size, input size, context size and number of heads values,
+/// while recomputing them only needs a block of them at a time, for the cost of another product of query and key.
+/// @param new_recompute_attention_scores True to recompute the scores instead of storing them.
+
+void MultiheadAttentionLayer::set_recompute_attention_scores(const bool& new_recompute_attention_scores)
+{
+    recompute_attention_scores = new_recompute_attention_scores;
+}
+
+
 /// Sets the layer's kernels according to the parameters.
 
 void MultiheadAttentionLayer::set_kernels()
@@ -228,6 +322,25 @@ void MultiheadAttentionLayer::set_kernels()
 }
 
 
+/// Sets the query, key, value and projection kernels from a vector of parameters.
+/// @param new_parameters Parameters vector.
+/// @param index Position of the parameters of this layer in the vector.
+
+void MultiheadAttentionLayer::set_parameters(const Tensor<type, 1>& new_parameters, const Index& index)
+{
+    Tensor<type, 3>* kernels[4] = {&query_kernel, &key_kernel, &value_kernel, &projection_kernel};
+
+    Index position = index;
+
+    for(Index i = 0; i < 4; i++)
+    {
+        copy(new_parameters.data() + position, new_parameters.data() + position + kernels[i]->size(), kernels[i]->data());
+
+        position += kernels[i]->size();
+    }
+}
+
+
 void MultiheadAttentionLayer::set_parameters_random()
 {
     const type minimum = type(-0.2);
@@ -274,174 +387,377 @@ void MultiheadAttentionLayer::set_display(const bool& new_display)
 }
 
 
-/// @todo fix, update and explain
-void MultiheadAttentionLayer::calculate_query_transformation(const Tensor<type, 3>& query, type* query_transformation_data)
+/// Transforms the inputs of all the batch elements with the kernels of all the heads in a single matrix product.
+/// The inputs are seen as a matrix with a row for each batch element and position,
+/// and the kernel as a matrix with a column for each depth and head.
+/// @param inputs Inputs with dimensions batch size, positions and depth.
+/// @param kernel Kernel with dimensions depth, depth and number of heads.
+/// @param transformation_data Pointer to the transformation, with dimensions batch size, positions, depth and number of heads.
+
+void MultiheadAttentionLayer::calculate_transformation(const TensorMap<Tensor<type, 3>>& inputs,
+                                                       const Tensor<type, 3>& kernel,
+                                                       type* transformation_data) const
 {
-    const Index batch_size = get_dimensions(query)(0);
+    const Index rows_number = inputs.dimension(0)*inputs.dimension(1);
 
-    TensorMap<Tensor<type, 4>> transformed_query(query_transformation_data, batch_size, input_size, depth, number_of_heads);
+    const TensorMap<Tensor<type, 2>> inputs_matrix(inputs.data(), rows_number, depth);
 
-    Tensor<type, 2> batch_element(input_size, depth);
+    const TensorMap<Tensor<type, 2>> kernel_matrix((type*)kernel.data(), depth, depth*number_of_heads);
 
-    for(Index batch_index = 0; batch_index < batch_size; batch_index++)
-    {
-        batch_element = query.chip(batch_index, 0);
-        transformed_query.chip(batch_index, 0) = batch_element.contract(query_kernel, A_B);
-    }
+    TensorMap<Tensor<type, 2>> transformation(transformation_data, rows_number, depth*number_of_heads);
+
+    transformation.device(*thread_pool_device) = inputs_matrix.contract(kernel_matrix, A_B);
 }
 
 
-void MultiheadAttentionLayer::calculate_key_transformation(const Tensor<type, 3>& key, type* key_transformation_data)
+void MultiheadAttentionLayer::calculate_query_transformation(const TensorMap<Tensor<type, 3>>& query, type* query_transformation_data) const
 {
-    const Index batch_size = get_dimensions(key)(0);
+    calculate_transformation(query, query_kernel, query_transformation_data);
+}
 
-    TensorMap<Tensor<type, 4>> transformed_key(key_transformation_data, batch_size, context_size, depth, number_of_heads);
 
-    Tensor<type, 2> batch_element(context_size, depth);
+void MultiheadAttentionLayer::calculate_key_transformation(const TensorMap<Tensor<type, 3>>& key, type* key_transformation_data) const
+{
+    calculate_transformation(key, key_kernel, key_transformation_data);
+}
 
-    for(Index batch_index = 0; batch_index < batch_size; batch_index++)
-    {
-        batch_element = key.chip(batch_index, 0);
-        transformed_key.chip(batch_index, 0) = batch_element.contract(key_kernel, A_B);
-    }
+
+void MultiheadAttentionLayer::calculate_value_transformation(const TensorMap<Tensor<type, 3>>& value, type* value_transformation_data) const
+{
+    calculate_transformation(value, value_kernel, value_transformation_data);
 }
 
 
-void MultiheadAttentionLayer::calculate_value_transformation(const Tensor<type, 3>& value, type* value_transformation_data)
+/// Projects the attention outputs of all the heads back to the embedding depth in a single matrix product.
+/// The projection kernel is reordered so that its rows follow the depth and head of the attention outputs.
+
+void MultiheadAttentionLayer::calculate_output_projection(const TensorMap<Tensor<type, 4>>& attention_outputs, type* outputs_data) const
 {
-    const Index batch_size = get_dimensions(value)(0);
+    const Index rows_number = attention_outputs.dimension(0)*attention_outputs.dimension(1);
 
-    TensorMap<Tensor<type, 4>> transformed_value(value_transformation_data, batch_size, context_size, depth, number_of_heads);
+    const Eigen::array<Index, 3> heads_before_outputs = {0, 2, 1};
 
-    Tensor<type, 2> batch_element(context_size, depth);
+    Tensor<type, 3> projection_kernel_matrix = projection_kernel.shuffle(heads_before_outputs);
 
-    for(Index batch_index = 0; batch_index < batch_size; batch_index++)
-    {
-        batch_element = value.chip(batch_index, 0);
-        transformed_value.chip(batch_index, 0) = batch_element.contract(value_kernel, A_B);
-    }
+    const TensorMap<Tensor<type, 2>> attention_outputs_matrix(attention_outputs.data(), rows_number, depth*number_of_heads);
+
+    const TensorMap<Tensor<type, 2>> kernel_matrix(projection_kernel_matrix.data(), depth*number_of_heads, depth);
+
+    TensorMap<Tensor<type, 2>> outputs(outputs_data, rows_number, depth);
+
+    outputs.device(*thread_pool_device) = attention_outputs_matrix.contract(kernel_matrix, A_B);
 }
 
 
-void MultiheadAttentionLayer::calculate_output_projection(const Tensor<type, 4>& attention_outputs, type* outputs_data)
+/// Computes the attention outputs by comparing (via dot product) query and key, and weighting the values with the softmax of the scores.
+/// Each batch element and attention head is computed separately, in blocks of input positions.
+/// The scaling, the causal mask and the softmax are applied to each block of scores as it is calculated.
+/// If the attention scores are not stored, the context is also split into blocks, and the softmax sums are rescaled
+/// whenever a new maximum is found, so that the scores of all the context are never held at once.
+/// @param transformed_query Transformed query, with dimensions batch size, input positions, depth and number of heads.
+/// @param transformed_key Transformed key, with dimensions batch size, context positions, depth and number of heads.
+/// @param transformed_value Transformed value, with the same dimensions as the key.
+/// @param context_positions Number of context positions used, from the first one, which might be less than those of the key.
+/// The last input position is aligned with the last context position used.
+/// @param attention_scores_data Pointer where the softmax probabilities are stored, or nullptr not to store them.
+/// @param attention_outputs_data Attention outputs, with dimensions batch size, input size, depth and number of heads.
+
+void MultiheadAttentionLayer::compute_attention(const TensorMap<Tensor<type, 4>>& transformed_query,
+                                                const TensorMap<Tensor<type, 4>>& transformed_key,
+                                                const TensorMap<Tensor<type, 4>>& transformed_value,
+                                                const Index& context_positions,
+                                                type* attention_scores_data,
+                                                type* attention_outputs_data) const
 {
-    const Index batch_size = get_dimensions(attention_outputs)(0);
+    const bool store_scores = attention_scores_data != nullptr;
+
+    const Index batch_size = transformed_query.dimension(0);
+    const Index input_positions = transformed_query.dimension(1);
+    const Index key_positions = transformed_key.dimension(1);
+
+    const type* transformed_query_data = transformed_query.data();
+    const type* transformed_key_data = transformed_key.data();
+    const type* transformed_value_data = transformed_value.data();
 
-    TensorMap<Tensor<type, 3>> outputs(outputs_data, batch_size, input_size, depth);
+    const Index queries_block_number = min(input_positions, queries_block_size);
+    const Index keys_block_number = store_scores ? context_positions : min(context_positions, keys_block_size);
 
-    Tensor<type, 3> batch_element(input_size, depth, number_of_heads);
+    const type scaling_factor = type(1)/sqrt(type(depth));
 
-    const Eigen::array<IndexPair<Index>, 2> contraction_indeces = {IndexPair<Index>(1, 0), IndexPair<Index>(2, 2)};
+    const type minus_infinity = -numeric_limits<type>::infinity();
 
+    // Context positions beyond the input position, so that the last input is aligned with the last context
+
+    const Index mask_offset = context_positions - input_positions;
+
+#pragma omp parallel for collapse(2)
     for(Index batch_index = 0; batch_index < batch_size; batch_index++)
     {
-        batch_element = attention_outputs.chip(batch_index, 0);
-        outputs.chip(batch_index, 0) = batch_element.contract(projection_kernel, contraction_indeces);
-    }
-}
+        for(Index head_index = 0; head_index < number_of_heads; head_index++)
+        {
+            // Key and value of this batch element and head, with a column for each context position
 
+            Tensor<type, 2> key(depth, context_positions);
+            Tensor<type, 2> value(depth, context_positions);
 
-/// Computes the attention scores by comparing (via dot product) query and key.
-/// Attention scores must be computed separately for each batch element and each attention head (batch matrix multiplication).
+            for(Index depth_index = 0; depth_index < depth; depth_index++)
+            {
+                const Index offset = batch_index + batch_size*key_positions*(depth_index + depth*head_index);
 
-void MultiheadAttentionLayer::compute_attention_scores(type* transformed_query_data,
-                                                       const Tensor<Index, 1>& transformed_query_dimensions,
-                                                       type* transformed_key_data,
-                                                       const Tensor<Index, 1>& transformed_key_dimensions,
-                                                       type* attention_scores_data)
-{
-    if(transformed_query_dimensions(0) != transformed_key_dimensions(0))
-    {
-        ostringstream buffer;
+                for(Index context_index = 0; context_index < context_positions; context_index++)
+                {
+                    key(depth_index, context_index) = transformed_key_data[offset + batch_size*context_index];
+                    value(depth_index, context_index) = transformed_value_data[offset + batch_size*context_index];
+                }
+            }
 
-        buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
-               << "void compute_attention_scores(type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&, type*) method.\n"
-               << "Input batch size (" << transformed_query_dimensions(0) << ") and context batch size (" << transformed_key_dimensions(0) << ") not equal.\n";
+            Tensor<type, 2> query(depth, queries_block_number);
+            Tensor<type, 2> scores(keys_block_number, queries_block_number);
+            Tensor<type, 2> outputs(depth, queries_block_number);
 
-        throw invalid_argument(buffer.str());
-    }
+            Tensor<type, 1> maximums(queries_block_number);
+            Tensor<type, 1> sums(queries_block_number);
 
-    const Index batch_size = transformed_query_dimensions(0);
+            for(Index query_start = 0; query_start < input_positions; query_start += queries_block_number)
+            {
+                const Index queries_number = min(queries_block_number, input_positions - query_start);
 
-    TensorMap<Tensor<type, 4>>  transformed_query(transformed_query_data, batch_size, input_size, depth, number_of_heads);
-    const TensorMap<Tensor<type, 4>>  transformed_key(transformed_key_data, batch_size, context_size, depth, number_of_heads);
+                // Scaled query, with a column for each input position
 
-    const Tensor<type, 4> scaled_query = transformed_query / transformed_query.constant(sqrt(depth));
+                for(Index depth_index = 0; depth_index < depth; depth_index++)
+                {
+                    const Index offset = batch_index + batch_size*(query_start + input_positions*(depth_index + depth*head_index));
 
-    Tensor<type, 4> raw_attention_scores(batch_size, input_size, context_size, number_of_heads);
+                    for(Index query_index = 0; query_index < queries_number; query_index++)
+                    {
+                        query(depth_index, query_index) = transformed_query_data[offset + batch_size*query_index]*scaling_factor;
+                    }
+                }
 
-    TensorMap<Tensor<type, 4>> attention_scores(attention_scores_data, batch_size, input_size, context_size, number_of_heads);
+                outputs.setZero();
+                maximums.setConstant(minus_infinity);
+                sums.setZero();
 
-    Tensor<Index, 1> row_size(1);
-    row_size.setValues({context_size});
+                const TensorMap<Tensor<type, 2>> query_block(query.data(), depth, queries_number);
+                TensorMap<Tensor<type, 2>> outputs_block(outputs.data(), depth, queries_number);
 
-#pragma omp parallel for collapse(2)
-        for(Index batch_index = 0; batch_index < batch_size; batch_index++)
-        {
-            for(Index head_index = 0; head_index < number_of_heads ; head_index++)
-            {
-            raw_attention_scores.chip(batch_index, 0).chip(head_index, 2)/*.device(thread_pool_device)*/ =
-                    scaled_query.chip(batch_index, 0).chip(head_index, 2).contract(
-                    transformed_key.chip(batch_index, 0).chip(head_index, 2), A_BT);
+                // Context positions seen by some input of this block
 
-                Tensor<type, 1> raw_attention_scores_row(context_size);
-                Tensor<type, 1> attention_scores_row(context_size);
+                const Index keys_end = causal_mask
+                        ? min(context_positions, max(Index(0), query_start + queries_number + mask_offset))
+                        : context_positions;
 
-                for(Index row_index = 0; row_index < input_size; row_index++)
+                Index keys_number = 0;
+
+                for(Index key_start = 0; key_start < keys_end; key_start += keys_block_number)
+                {
+                    keys_number = min(keys_block_number, keys_end - key_start);
+
+                    const TensorMap<Tensor<type, 2>> key_block(key.data() + key_start*depth, depth, keys_number);
+                    const TensorMap<Tensor<type, 2>> value_block(value.data() + key_start*depth, depth, keys_number);
+
+                    TensorMap<Tensor<type, 2>> scores_block(scores.data(), keys_number, queries_number);
+
+                    scores_block = key_block.contract(query_block, AT_B);
+
+                    // Masked softmax
+
+                    for(Index query_index = 0; query_index < queries_number; query_index++)
+                    {
+                        type* query_scores = scores_block.data() + query_index*keys_number;
+
+                        const Index visible_keys_number = causal_mask
+                                ? min(keys_number, max(Index(0), query_start + query_index + mask_offset + 1 - key_start))
+                                : keys_number;
+
+                        type maximum = maximums(query_index);
+
+                        for(Index key_index = 0; key_index < visible_keys_number; key_index++)
+                        {
+                            maximum = max(maximum, query_scores[key_index]);
+                        }
+
+                        fill(query_scores + visible_keys_number, query_scores + keys_number, type(0));
+
+                        if(maximum == minus_infinity)
+                        {
+                            fill(query_scores, query_scores + visible_keys_number, type(0));
+
+                            continue;
+                        }
+
+                        type sum = type(0);
+
+                        for(Index key_index = 0; key_index < visible_keys_number; key_index++)
+                        {
+                            query_scores[key_index] = exp(query_scores[key_index] - maximum);
+
+                            sum += query_scores[key_index];
+                        }
+
+                        // The previous blocks were exponentiated with a smaller maximum
+
+                        const type rescaling = exp(maximums(query_index) - maximum);
+
+                        if(rescaling != type(1))
+                        {
+                            outputs_block.chip(query_index, 1) = outputs_block.chip(query_index, 1)*rescaling;
+                        }
+
+                        sums(query_index) = sums(query_index)*rescaling + sum;
+                        maximums(query_index) = maximum;
+                    }
+
+                    outputs_block += value_block.contract(scores_block, A_B);
+                }
+
+                // Normalization
+
+                for(Index query_index = 0; query_index < queries_number; query_index++)
                 {
-                    raw_attention_scores_row = raw_attention_scores.chip(batch_index, 0).chip(head_index, 2).chip(row_index, 0);
-                    softmax(raw_attention_scores_row.data(),
-                            row_size,
-                            attention_scores_row.data(),
-                            row_size);
-                    attention_scores.chip(batch_index, 0).chip(head_index, 2).chip(row_index, 0) = attention_scores_row;
+                    const type inverse_sum = sums(query_index) > type(0) ? type(1)/sums(query_index) : type(0);
+
+                    const Index sample_index = batch_index + batch_size*(query_start + query_index);
+
+                    for(Index depth_index = 0; depth_index < depth; depth_index++)
+                    {
+                        attention_outputs_data[sample_index + batch_size*input_positions*(depth_index + depth*head_index)]
+                                = outputs(depth_index, query_index)*inverse_sum;
+                    }
+
+                    if(!store_scores) continue;
+
+                    // All the context is in a single block
+
+                    const type* query_scores = scores.data() + query_index*keys_number;
+
+                    for(Index context_index = 0; context_index < context_positions; context_index++)
+                    {
+                        attention_scores_data[sample_index + batch_size*input_positions*(context_index + context_positions*head_index)]
+                                = context_index < keys_end ? query_scores[context_index]*inverse_sum : type(0);
+                    }
                 }
             }
-        };
+        }
+    }
+
     /// @todo add dropout
 }
 
 
-void MultiheadAttentionLayer::compute_attention_output(type* transformed_value_data,
-                                                       const Tensor<Index, 1>& transformed_value_dimensions,
-                                                       type* attention_scores_data,
-                                                       const Tensor<Index, 1>& attention_scores_dimensions,
-                                                       type* attention_output_data)
-{    
-    const Index batch_size = transformed_value_dimensions(0);
+/// Appends the transformed key and value of some new context positions to those of the previous incremental forward propagations.
+/// If the context size is exceeded, the oldest positions are discarded.
+/// @param key Key of the new context positions, with dimensions batch size, positions and depth.
+/// @param value Value of the new context positions, with the same dimensions as the key.
+/// @param forward_propagation Forward propagation of the layer, whose transformed key and value hold the cached positions.
 
-    TensorMap<Tensor<type, 4>> transformed_value(transformed_value_data, batch_size, context_size, depth, number_of_heads);
-    TensorMap<Tensor<type, 4>> attention_scores(attention_scores_data, batch_size, input_size, context_size, number_of_heads);
+void MultiheadAttentionLayer::update_key_value_cache(const TensorMap<Tensor<type, 3>>& key,
+                                                     const TensorMap<Tensor<type, 3>>& value,
+                                                     MultiheadAttentionLayerForwardPropagation* forward_propagation) const
+{
+    const Index batch_size = key.dimension(0);
+    const Index new_positions = key.dimension(1);
 
-    TensorMap<Tensor<type, 4>> attention_output(attention_output_data, batch_size, input_size, depth, number_of_heads);
+    Tensor<type, 4> new_transformed_key(batch_size, new_positions, depth, number_of_heads);
+    Tensor<type, 4> new_transformed_value(batch_size, new_positions, depth, number_of_heads);
 
-#pragma omp parallel for collapse(2)
-        for(Index batch_index = 0; batch_index < batch_size; batch_index++)
+    calculate_key_transformation(key, new_transformed_key.data());
+    calculate_value_transformation(value, new_transformed_value.data());
+
+    type* transformed_key_data = forward_propagation->get_transformed_key_data();
+    type* transformed_value_data = forward_propagation->get_transformed_value_data();
+
+    Index& cached_positions = forward_propagation->cached_positions;
+
+    const Index discarded_positions = max(Index(0), cached_positions + new_positions - context_size);
+
+    cached_positions -= discarded_positions;
+
+    // Each depth and head holds the positions of all the batch elements consecutively
+
+    for(Index column_index = 0; column_index < depth*number_of_heads; column_index++)
+    {
+        type* cached_key = transformed_key_data + column_index*batch_size*context_size;
+        type* cached_value = transformed_value_data + column_index*batch_size*context_size;
+
+        if(discarded_positions > 0)
         {
-            for(Index head_index = 0; head_index < number_of_heads ; head_index++)
-            {
-                attention_output.chip(batch_index, 0).chip(head_index, 2) =
-                    attention_scores.chip(batch_index, 0).chip(head_index, 2).contract(
-                    transformed_value.chip(batch_index, 0).chip(head_index, 2), A_B);
-            }
-        };
+            copy(cached_key + discarded_positions*batch_size,
+                 cached_key + (discarded_positions + cached_positions)*batch_size,
+                 cached_key);
+
+            copy(cached_value + discarded_positions*batch_size,
+                 cached_value + (discarded_positions + cached_positions)*batch_size,
+                 cached_value);
+        }
+
+        const type* new_key = new_transformed_key.data() + column_index*batch_size*new_positions;
+        const type* new_value = new_transformed_value.data() + column_index*batch_size*new_positions;
+
+        copy(new_key, new_key + batch_size*new_positions, cached_key + cached_positions*batch_size);
+        copy(new_value, new_value + batch_size*new_positions, cached_value + cached_positions*batch_size);
+    }
+
+    cached_positions += new_positions;
 }
 
 
+/// Calculates the outputs of the layer.
+/// The inputs are the query, key and value, or a single tensor for self-attention.
+/// In an incremental forward propagation, the inputs are only the new positions of the sequences,
+/// whose keys and values are added to those of the previous forward propagations, as in autoregressive decoding.
+/// Then, each new position costs a single query instead of the attention of all the sequence.
+/// @param inputs Query, key and value, or inputs of self-attention.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param is_training True to store the attention scores for the back propagation.
+
 void MultiheadAttentionLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
                                         LayerForwardPropagation* forward_propagation,
                                         const bool& is_training)
 {
-    if(inputs.size() != 3)
+    if(inputs.size() != 1 && inputs.size() != 3)
     {
         ostringstream buffer;
         buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
                << "void MultiheadAttentionLayer::forward_propagate(Tensor<type*, 1>, const Tensor<Tensor<Index,1>, 1>&, LayerForwardPropagation*, const bool&)\n"
-               << "Number of input tensors (" << inputs.size() << ") must be 3 (key, query and value).\n";
+               << "Number of input tensors (" << inputs.size() << ") must be 3 (key, query and value) or 1 (self-attention).\n";
         throw invalid_argument(buffer.str());
     }
 
-    if(inputs(0).get_dimension(0) != inputs(1).get_dimension(0) || inputs(0).get_dimension(0) != inputs(2).get_dimension(0))
+    // Inputs with two dimensions, as the outputs of perceptron layers, are viewed as batch size, positions and depth
+
+    Tensor<DynamicTensor<type>, 1> inputs_views(inputs.size());
+
+    for(Index i = 0; i < inputs.size(); i++)
+    {
+        if(inputs(i).get_dimensions().size() != 2)
+        {
+            inputs_views(i).set_view(inputs(i).get_data(), inputs(i).get_dimensions());
+            continue;
+        }
+
+        if(inputs(i).get_dimension(1) % depth != 0)
+        {
+            ostringstream buffer;
+            buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
+                   << "void MultiheadAttentionLayer::forward_propagate(Tensor<type*, 1>, const Tensor<Tensor<Index,1>, 1>&, LayerForwardPropagation*, const bool&)\n"
+                   << "2nd dimension of two dimensional inputs (" << inputs(i).get_dimension(1) << ") must be a multiple of layer depth.\n";
+            throw invalid_argument(buffer.str());
+        }
+
+        Tensor<Index, 1> view_dimensions(3);
+        view_dimensions.setValues({inputs(i).get_dimension(0), inputs(i).get_dimension(1)/depth, depth});
+
+        inputs_views(i).set_view(inputs(i).get_data(), view_dimensions);
+    }
+
+    const DynamicTensor<type>& query_inputs = inputs_views(0);
+    const DynamicTensor<type>& key_inputs = inputs.size() == 3 ? inputs_views(1) : inputs_views(0);
+    const DynamicTensor<type>& value_inputs = inputs.size() == 3 ? inputs_views(2) : inputs_views(0);
+
+    const bool is_incremental = forward_propagation->is_incremental;
+
+    if(query_inputs.get_dimension(0) != key_inputs.get_dimension(0) || query_inputs.get_dimension(0) != value_inputs.get_dimension(0))
     {
         ostringstream buffer;
         buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
@@ -450,25 +766,27 @@ void MultiheadAttentionLayer::forward_propagate(const Tensor<DynamicTensor<type>
         throw invalid_argument(buffer.str());
     }
 
-    if(inputs(0).get_dimension(1) != input_size)
+    if(is_incremental ? query_inputs.get_dimension(1) > input_size : query_inputs.get_dimension(1) != input_size)
     {
         ostringstream buffer;
         buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
                << "void MultiheadAttentionLayer::forward_propagate(Tensor<type*, 1>, const Tensor<Tensor<Index,1>, 1>&, LayerForwardPropagation*, const bool&)\n"
-               << "2nd dimension of query must be equal to layer input_size.\n";
+               << "2nd dimension of query must be " << (is_incremental ? "at most" : "equal to") << " layer input_size.\n";
         throw invalid_argument(buffer.str());
     }
 
-    if(inputs(1).get_dimension(1) != context_size || inputs(2).get_dimension(1) != context_size)
+    if(is_incremental
+    ? key_inputs.get_dimension(1) > context_size || value_inputs.get_dimension(1) != key_inputs.get_dimension(1)
+    : key_inputs.get_dimension(1) != context_size || value_inputs.get_dimension(1) != context_size)
     {
         ostringstream buffer;
         buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
                << "void MultiheadAttentionLayer::forward_propagate(Tensor<type*, 1>, const Tensor<Tensor<Index,1>, 1>&, LayerForwardPropagation*, const bool&)\n"
-               << "2nd dimension of key and value must be equal to layer context_size.\n";
+               << "2nd dimension of key and value must be " << (is_incremental ? "at most" : "equal to") << " layer context_size.\n";
         throw invalid_argument(buffer.str());
     }
 
-    if(inputs(0).get_dimension(2) != depth || inputs(1).get_dimension(2) != depth || inputs(2).get_dimension(2) != depth)
+    if(query_inputs.get_dimension(2) != depth || key_inputs.get_dimension(2) != depth || value_inputs.get_dimension(2) != depth)
     {
         ostringstream buffer;
         buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
@@ -477,53 +795,670 @@ void MultiheadAttentionLayer::forward_propagate(const Tensor<DynamicTensor<type>
         throw invalid_argument(buffer.str());
     }
 
-    const Index batch_size = inputs(0).get_dimension(0);
-
-    const Tensor<Index, 1> query_dimensions = inputs(0).get_dimensions();
-    const Tensor<Index, 1> key_dimensions = inputs(1).get_dimensions();
+    const Index batch_size = query_inputs.get_dimension(0);
+    const Index input_positions = query_inputs.get_dimension(1);
 
     MultiheadAttentionLayerForwardPropagation* multihead_attention_layer_forward_propagation
         = static_cast<MultiheadAttentionLayerForwardPropagation*>(forward_propagation);
 
-    const TensorMap<Tensor<type, 3>> query = inputs(0).to_tensor_map<3>();
-    const TensorMap<Tensor<type, 3>> key = inputs(1).to_tensor_map<3>();
-    const TensorMap<Tensor<type, 3>> value = inputs(2).to_tensor_map<3>();
+    const TensorMap<Tensor<type, 3>> query = query_inputs.to_tensor_map<3>();
+    const TensorMap<Tensor<type, 3>> key = key_inputs.to_tensor_map<3>();
+    const TensorMap<Tensor<type, 3>> value = value_inputs.to_tensor_map<3>();
 
     type* transformed_query_data = multihead_attention_layer_forward_propagation->get_transformed_query_data();
     type* transformed_key_data = multihead_attention_layer_forward_propagation->get_transformed_key_data();
     type* transformed_value_data = multihead_attention_layer_forward_propagation->get_transformed_value_data();
 
     calculate_query_transformation(query, transformed_query_data);
-    calculate_key_transformation(key, transformed_key_data);
-    calculate_value_transformation(value, transformed_value_data);
 
-    Tensor<Index, 1> transformed_query_dimensions(4);
-    Tensor<Index, 1> transformed_key_dimensions(4);
-    transformed_query_dimensions.setValues({batch_size, input_size, depth, number_of_heads});
-    transformed_key_dimensions.setValues({batch_size, context_size, depth, number_of_heads});
+    Index context_positions = context_size;
+
+    if(is_incremental)
+    {
+        update_key_value_cache(key, value, multihead_attention_layer_forward_propagation);
+
+        context_positions = multihead_attention_layer_forward_propagation->cached_positions;
+    }
+    else
+    {
+        calculate_key_transformation(key, transformed_key_data);
+        calculate_value_transformation(value, transformed_value_data);
+    }
 
-    type* attention_scores_data = multihead_attention_layer_forward_propagation->get_attention_scores_data();
+    // The attention scores are only kept for training
 
-    compute_attention_scores(transformed_query_data,
-                             transformed_query_dimensions,
-                             transformed_key_data,
-                             transformed_key_dimensions,
-                             attention_scores_data);
+    type* attention_scores_data = nullptr;
 
-    const Tensor<Index, 1> attention_scores_dimensions = get_dimensions(multihead_attention_layer_forward_propagation->attention_scores);
+    if(is_training && !recompute_attention_scores && !is_incremental)
+    {
+        Tensor<type, 4>& attention_scores = multihead_attention_layer_forward_propagation->attention_scores;
+
+        if(attention_scores.size() != batch_size*input_size*context_size*number_of_heads)
+        {
+            attention_scores.resize(batch_size, input_size, context_size, number_of_heads);
+        }
+
+        attention_scores_data = attention_scores.data();
+    }
 
     type* attention_outputs_data = multihead_attention_layer_forward_propagation->get_attention_outputs_data();
 
-    compute_attention_output(transformed_value_data,
-                             transformed_key_dimensions,
-                             attention_scores_data,
-                             attention_scores_dimensions,
-                             attention_outputs_data);
+    compute_attention(TensorMap<Tensor<type, 4>>(transformed_query_data, batch_size, input_positions, depth, number_of_heads),
+                      TensorMap<Tensor<type, 4>>(transformed_key_data, batch_size, context_size, depth, number_of_heads),
+                      TensorMap<Tensor<type, 4>>(transformed_value_data, batch_size, context_size, depth, number_of_heads),
+                      context_positions,
+                      attention_scores_data,
+                      attention_outputs_data);
+
+    const TensorMap<Tensor<type, 4>> attention_outputs(attention_outputs_data, batch_size, input_positions, depth, number_of_heads);
+
+    DynamicTensor<type>& outputs = multihead_attention_layer_forward_propagation->outputs(0);
+
+    Tensor<Index, 1> outputs_dimensions(3);
+    outputs_dimensions.setValues({batch_size, input_positions, depth});
+
+    outputs.reshape(outputs_dimensions);
+
+    calculate_output_projection(attention_outputs, outputs.get_data());
+}
+
+
+/// Calculates the error gradient of a self-attention layer, whose query, key and value are the same inputs.
+/// @param inputs_data Pointer to the inputs of the layer, with dimensions batch size, input size and depth.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, where the gradient is written.
+
+void MultiheadAttentionLayer::calculate_error_gradient(type* inputs_data,
+                                                       LayerForwardPropagation* forward_propagation,
+                                                       LayerBackPropagation* back_propagation) const
+{
+    if(input_size != context_size)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
+               << "void calculate_error_gradient(type*, LayerForwardPropagation*, LayerBackPropagation*) const method.\n"
+               << "Input size (" << input_size << ") must be equal to context size (" << context_size << ") for a single inputs tensor.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    inputs_dimensions.setValues({back_propagation->batch_samples_number, input_size, depth});
+
+    Tensor<DynamicTensor<type>, 1> inputs(3);
+
+    inputs.setConstant(DynamicTensor<type>(inputs_data, inputs_dimensions));
+
+    calculate_error_gradient(inputs, forward_propagation, back_propagation);
+}
+
+
+/// Calculates the deltas of the layer from those of the next layer.
+/// The next layer can be a perceptron layer, which takes the outputs of all the positions as a single row of inputs,
+/// or another multi-head attention layer.
+/// @param next_layer_forward_propagation Forward propagation of the next layer.
+/// @param next_layer_back_propagation Back propagation of the next layer, with its deltas.
+/// @param layer_back_propagation Back propagation of this layer, where the deltas are written.
+
+void MultiheadAttentionLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
+                                                     LayerBackPropagation* next_layer_back_propagation,
+                                                     LayerBackPropagation* layer_back_propagation) const
+{
+    MultiheadAttentionLayerBackPropagation* multihead_attention_layer_back_propagation =
+            static_cast<MultiheadAttentionLayerBackPropagation*>(layer_back_propagation);
+
+    switch(next_layer_back_propagation->layer_pointer->get_type())
+    {
+    case Type::Perceptron:
+    {
+        PerceptronLayerForwardPropagation* next_perceptron_layer_forward_propagation =
+                static_cast<PerceptronLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        PerceptronLayerBackPropagation* next_perceptron_layer_back_propagation =
+                static_cast<PerceptronLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_perceptron_layer_forward_propagation,
+                               next_perceptron_layer_back_propagation,
+                               multihead_attention_layer_back_propagation);
+    }
+        break;
+
+    case Type::MultiheadAttention:
+    {
+        MultiheadAttentionLayerForwardPropagation* next_multihead_attention_layer_forward_propagation =
+                static_cast<MultiheadAttentionLayerForwardPropagation*>(next_layer_forward_propagation);
+
+        MultiheadAttentionLayerBackPropagation* next_multihead_attention_layer_back_propagation =
+                static_cast<MultiheadAttentionLayerBackPropagation*>(next_layer_back_propagation);
+
+        calculate_hidden_delta(next_multihead_attention_layer_forward_propagation,
+                               next_multihead_attention_layer_back_propagation,
+                               multihead_attention_layer_back_propagation);
+    }
+        break;
+
+    default: return;
+    }
+}
+
+
+void MultiheadAttentionLayer::calculate_hidden_delta(PerceptronLayerForwardPropagation* next_forward_propagation,
+                                                     PerceptronLayerBackPropagation* next_back_propagation,
+                                                     MultiheadAttentionLayerBackPropagation* back_propagation) const
+{
+    const Tensor<type, 2>& next_synaptic_weights = static_cast<PerceptronLayer*>(next_back_propagation->layer_pointer)->get_synaptic_weights();
+
+    const TensorMap<Tensor<type, 2>> next_deltas(next_back_propagation->deltas_data,
+                                                 next_back_propagation->deltas_dimensions(0),
+                                                 next_back_propagation->deltas_dimensions(1));
+
+    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->batch_samples_number, input_size*depth);
+
+    deltas.device(*thread_pool_device) = (next_deltas*next_forward_propagation->activations_derivatives).contract(next_synaptic_weights, A_BT);
+}
+
+
+void MultiheadAttentionLayer::calculate_hidden_delta(MultiheadAttentionLayerForwardPropagation* next_forward_propagation,
+                                                     MultiheadAttentionLayerBackPropagation* next_back_propagation,
+                                                     MultiheadAttentionLayerBackPropagation* back_propagation) const
+{
+    static_cast<MultiheadAttentionLayer*>(next_back_propagation->layer_pointer)->calculate_inputs_deltas(next_forward_propagation,
+                                                                                                      next_back_propagation,
+                                                                                                      back_propagation->deltas_data);
+}
+
+
+/// Calculates the derivatives of the error with respect to the query, key and value inputs from the deltas of the layer.
+/// They do not depend on the inputs, so that they are calculated with the deltas of the previous layer,
+/// which are needed before the error gradient of this layer.
+/// The derivatives of the attention outputs and of the transformed query, key and value are kept for the error gradient.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, with its deltas.
+
+void MultiheadAttentionLayer::calculate_inputs_derivatives(MultiheadAttentionLayerForwardPropagation* forward_propagation,
+                                                           MultiheadAttentionLayerBackPropagation* back_propagation) const
+{
+    const Index batch_size = back_propagation->batch_samples_number;
+
+    const Index rows_number = batch_size*input_size;
+
+    // Projection
+
+    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, rows_number, depth);
+
+    TensorMap<Tensor<type, 2>> attention_outputs_derivatives(back_propagation->attention_outputs_derivatives.data(),
+                                                             rows_number, depth*number_of_heads);
+
+    const Eigen::array<Index, 3> heads_before_outputs = {0, 2, 1};
+
+    const Tensor<type, 3> projection_kernel_matrix = projection_kernel.shuffle(heads_before_outputs);
+
+    const TensorMap<Tensor<type, 2>> kernel_matrix((type*)projection_kernel_matrix.data(), depth*number_of_heads, depth);
+
+    attention_outputs_derivatives.device(*thread_pool_device) = deltas.contract(kernel_matrix, A_BT);
+
+    // Attention
+
+    compute_attention_derivatives(forward_propagation, back_propagation);
+
+    // Transformations
+
+    calculate_transformation_inputs_derivatives(query_kernel,
+                                                back_propagation->transformed_query_derivatives.data(),
+                                                batch_size*input_size,
+                                                back_propagation->query_derivatives.data());
+
+    calculate_transformation_inputs_derivatives(key_kernel,
+                                                back_propagation->transformed_key_derivatives.data(),
+                                                batch_size*context_size,
+                                                back_propagation->key_derivatives.data());
+
+    calculate_transformation_inputs_derivatives(value_kernel,
+                                                back_propagation->transformed_value_derivatives.data(),
+                                                batch_size*context_size,
+                                                back_propagation->value_derivatives.data());
+
+    back_propagation->inputs_derivatives_calculated = true;
+}
+
+
+/// Calculates the deltas of the layer which gives the inputs of this self-attention layer,
+/// which are the sum of the derivatives of the error with respect to the query, key and value.
+/// The inputs derivatives are calculated if they were not already.
+/// @param forward_propagation Forward propagation of this layer.
+/// @param back_propagation Back propagation of this layer, with its deltas.
+/// @param previous_deltas_data Pointer to the deltas of the previous layer, with batch size, input size and depth elements.
+
+void MultiheadAttentionLayer::calculate_inputs_deltas(LayerForwardPropagation* forward_propagation,
+                                                      LayerBackPropagation* back_propagation,
+                                                      type* previous_deltas_data) const
+{
+    if(input_size != context_size)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: MultiheadAttentionLayer class.\n"
+               << "void calculate_inputs_deltas(LayerForwardPropagation*, LayerBackPropagation*, type*) const method.\n"
+               << "Input size (" << input_size << ") must be equal to context size (" << context_size << ") for the deltas of a single previous layer.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    MultiheadAttentionLayerForwardPropagation* multihead_attention_layer_forward_propagation =
+            static_cast<MultiheadAttentionLayerForwardPropagation*>(forward_propagation);
+
+    MultiheadAttentionLayerBackPropagation* multihead_attention_layer_back_propagation =
+            static_cast<MultiheadAttentionLayerBackPropagation*>(back_propagation);
+
+    if(!multihead_attention_layer_back_propagation->inputs_derivatives_calculated)
+    {
+        calculate_inputs_derivatives(multihead_attention_layer_forward_propagation, multihead_attention_layer_back_propagation);
+    }
+
+    const Tensor<type, 3>& query_derivatives = multihead_attention_layer_back_propagation->query_derivatives;
+    const Tensor<type, 3>& key_derivatives = multihead_attention_layer_back_propagation->key_derivatives;
+    const Tensor<type, 3>& value_derivatives = multihead_attention_layer_back_propagation->value_derivatives;
+
+    TensorMap<Tensor<type, 3>> previous_deltas(previous_deltas_data,
+                                               query_derivatives.dimension(0),
+                                               query_derivatives.dimension(1),
+                                               query_derivatives.dimension(2));
+
+    previous_deltas.device(*thread_pool_device) = query_derivatives + key_derivatives + value_derivatives;
+}
+
+
+/// Calculates the deltas of the layer which gives one of the query, key and value inputs of this layer,
+/// as in neural networks whose layers form a graph.
+/// The inputs derivatives are calculated if they were not already.
+/// @param forward_propagation Forward propagation of this layer.
+/// @param back_propagation Back propagation of this layer, with its deltas.
+/// @param input_index Index of the input, 0 for the query, 1 for the key and 2 for the value.
+/// @param previous_deltas_data Pointer to the deltas of the previous layer, with the size of that input.
+
+void MultiheadAttentionLayer::calculate_inputs_deltas(LayerForwardPropagation* forward_propagation,
+                                                      LayerBackPropagation* back_propagation,
+                                                      const Index& input_index,
+                                                      type* previous_deltas_data) const
+{
+    MultiheadAttentionLayerForwardPropagation* multihead_attention_layer_forward_propagation =
+            static_cast<MultiheadAttentionLayerForwardPropagation*>(forward_propagation);
+
+    MultiheadAttentionLayerBackPropagation* multihead_attention_layer_back_propagation =
+            static_cast<MultiheadAttentionLayerBackPropagation*>(back_propagation);
+
+    if(!multihead_attention_layer_back_propagation->inputs_derivatives_calculated)
+    {
+        calculate_inputs_derivatives(multihead_attention_layer_forward_propagation, multihead_attention_layer_back_propagation);
+    }
+
+    const Tensor<type, 3>& inputs_derivatives = input_index == 0
+            ? multihead_attention_layer_back_propagation->query_derivatives
+            : input_index == 1
+            ? multihead_attention_layer_back_propagation->key_derivatives
+            : multihead_attention_layer_back_propagation->value_derivatives;
+
+    copy(inputs_derivatives.data(), inputs_derivatives.data() + inputs_derivatives.size(), previous_deltas_data);
+}
+
+
+/// Calculates the derivatives of the error with respect to the kernels and the query, key and value inputs.
+/// The derivatives of the attention outputs, the kernels and the inputs are calculated for the whole batch
+/// and all the heads in single matrix products, as in the forward propagation.
+/// The derivatives of the inputs are only calculated if the previous layer did not need them for its deltas.
+/// @param inputs Query, key and value inputs of the layer, or a single inputs tensor for self-attention.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, where the gradient is written.
+
+void MultiheadAttentionLayer::calculate_error_gradient(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                                       LayerForwardPropagation* forward_propagation,
+                                                       LayerBackPropagation* back_propagation) const
+{
+    if(inputs.size() == 1)
+    {
+        calculate_error_gradient(inputs(0).get_data(), forward_propagation, back_propagation);
+
+        return;
+    }
+
+    MultiheadAttentionLayerForwardPropagation* multihead_attention_layer_forward_propagation =
+            static_cast<MultiheadAttentionLayerForwardPropagation*>(forward_propagation);
+
+    MultiheadAttentionLayerBackPropagation* multihead_attention_layer_back_propagation =
+            static_cast<MultiheadAttentionLayerBackPropagation*>(back_propagation);
+
+    if(!multihead_attention_layer_back_propagation->inputs_derivatives_calculated)
+    {
+        calculate_inputs_derivatives(multihead_attention_layer_forward_propagation, multihead_attention_layer_back_propagation);
+    }
+
+    const Index batch_size = back_propagation->batch_samples_number;
+
+    const Index rows_number = batch_size*input_size;
+
+    // Projection
+
+    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, rows_number, depth);
+
+    const TensorMap<Tensor<type, 2>> attention_outputs(multihead_attention_layer_forward_propagation->attention_outputs.get_data(),
+                                                       rows_number, depth*number_of_heads);
+
+    Tensor<type, 3> projection_kernel_matrix_derivatives(depth, number_of_heads, depth);
 
-    const TensorMap<Tensor<type, 4>> attention_outputs(attention_outputs_data, batch_size, input_size, depth, number_of_heads);
+    TensorMap<Tensor<type, 2>> kernel_matrix_derivatives(projection_kernel_matrix_derivatives.data(), depth*number_of_heads, depth);
+
+    kernel_matrix_derivatives.device(*thread_pool_device) = attention_outputs.contract(deltas, AT_B);
+
+    const Eigen::array<Index, 3> outputs_before_heads = {0, 2, 1};
+
+    multihead_attention_layer_back_propagation->projection_kernel_derivatives.device(*thread_pool_device)
+            = projection_kernel_matrix_derivatives.shuffle(outputs_before_heads);
+
+    // Transformations
+
+    calculate_transformation_kernel_derivatives(TensorMap<Tensor<type, 3>>(inputs(0).get_data(), batch_size, input_size, depth),
+                                                multihead_attention_layer_back_propagation->transformed_query_derivatives.data(),
+                                                multihead_attention_layer_back_propagation->query_kernel_derivatives);
+
+    calculate_transformation_kernel_derivatives(TensorMap<Tensor<type, 3>>(inputs(1).get_data(), batch_size, context_size, depth),
+                                                multihead_attention_layer_back_propagation->transformed_key_derivatives.data(),
+                                                multihead_attention_layer_back_propagation->key_kernel_derivatives);
+
+    calculate_transformation_kernel_derivatives(TensorMap<Tensor<type, 3>>(inputs(2).get_data(), batch_size, context_size, depth),
+                                                multihead_attention_layer_back_propagation->transformed_value_derivatives.data(),
+                                                multihead_attention_layer_back_propagation->value_kernel_derivatives);
+
+    multihead_attention_layer_back_propagation->inputs_derivatives_calculated = false;
+}
+
+
+/// Calculates the derivatives of the inputs of a transformation from its derivatives,
+/// with the same matrices as calculate_transformation().
+/// @param kernel Kernel with dimensions depth, depth and number of heads.
+/// @param transformation_derivatives_data Derivatives of the transformation.
+/// @param rows_number Batch size times number of positions.
+/// @param inputs_derivatives_data Pointer to the derivatives of the inputs.
+
+void MultiheadAttentionLayer::calculate_transformation_inputs_derivatives(const Tensor<type, 3>& kernel,
+                                                                          const type* transformation_derivatives_data,
+                                                                          const Index& rows_number,
+                                                                          type* inputs_derivatives_data) const
+{
+    const TensorMap<Tensor<type, 2>> kernel_matrix((type*)kernel.data(), depth, depth*number_of_heads);
 
-    calculate_output_projection(attention_outputs,
-                                multihead_attention_layer_forward_propagation->outputs(0).get_data());
+    const TensorMap<Tensor<type, 2>> transformation_derivatives((type*)transformation_derivatives_data, rows_number, depth*number_of_heads);
+
+    TensorMap<Tensor<type, 2>> inputs_derivatives(inputs_derivatives_data, rows_number, depth);
+
+    inputs_derivatives.device(*thread_pool_device) = transformation_derivatives.contract(kernel_matrix, A_BT);
+}
+
+
+/// Calculates the derivatives of a kernel from the derivatives of its transformation.
+/// @param inputs Inputs with dimensions batch size, positions and depth.
+/// @param transformation_derivatives_data Derivatives of the transformation.
+/// @param kernel_derivatives Derivatives of the kernel.
+
+void MultiheadAttentionLayer::calculate_transformation_kernel_derivatives(const TensorMap<Tensor<type, 3>>& inputs,
+                                                                          const type* transformation_derivatives_data,
+                                                                          Tensor<type, 3>& kernel_derivatives) const
+{
+    const Index rows_number = inputs.dimension(0)*inputs.dimension(1);
+
+    const TensorMap<Tensor<type, 2>> inputs_matrix(inputs.data(), rows_number, depth);
+
+    const TensorMap<Tensor<type, 2>> transformation_derivatives((type*)transformation_derivatives_data, rows_number, depth*number_of_heads);
+
+    TensorMap<Tensor<type, 2>> kernel_matrix_derivatives(kernel_derivatives.data(), depth, depth*number_of_heads);
+
+    kernel_matrix_derivatives.device(*thread_pool_device) = inputs_matrix.contract(transformation_derivatives, AT_B);
+}
+
+
+/// Calculates the derivatives of the transformed query, key and value from those of the attention outputs.
+/// Each batch element and attention head is calculated separately, in blocks of input positions, as in the forward propagation.
+/// The softmax derivatives use the sum of the attention outputs times their derivatives for each input position,
+/// so that only a block of attention scores is needed at a time.
+/// The scores are taken from the forward propagation, or calculated again if they were not stored.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, with the attention outputs derivatives.
+
+void MultiheadAttentionLayer::compute_attention_derivatives(MultiheadAttentionLayerForwardPropagation* forward_propagation,
+                                                            MultiheadAttentionLayerBackPropagation* back_propagation) const
+{
+    const Index batch_size = back_propagation->batch_samples_number;
+
+    const bool stored_scores = forward_propagation->attention_scores.size() == batch_size*input_size*context_size*number_of_heads
+                            && !recompute_attention_scores;
+
+    const type* transformed_query_data = forward_propagation->transformed_query.get_data();
+    const type* transformed_key_data = forward_propagation->transformed_key.data();
+    const type* transformed_value_data = forward_propagation->transformed_value.data();
+    const type* attention_scores_data = forward_propagation->attention_scores.data();
+    const type* attention_outputs_data = forward_propagation->attention_outputs.get_data();
+
+    const type* attention_outputs_derivatives_data = back_propagation->attention_outputs_derivatives.data();
+
+    type* transformed_query_derivatives_data = back_propagation->transformed_query_derivatives.data();
+    type* transformed_key_derivatives_data = back_propagation->transformed_key_derivatives.data();
+    type* transformed_value_derivatives_data = back_propagation->transformed_value_derivatives.data();
+
+    const Index queries_block_number = min(input_size, queries_block_size);
+
+    const type scaling_factor = type(1)/sqrt(type(depth));
+
+    const type minus_infinity = -numeric_limits<type>::infinity();
+
+    const Index mask_offset = context_size - input_size;
+
+#pragma omp parallel for collapse(2)
+    for(Index batch_index = 0; batch_index < batch_size; batch_index++)
+    {
+        for(Index head_index = 0; head_index < number_of_heads; head_index++)
+        {
+            // Key and value of this batch element and head, with a column for each context position
+
+            Tensor<type, 2> key(depth, context_size);
+            Tensor<type, 2> value(depth, context_size);
+
+            for(Index depth_index = 0; depth_index < depth; depth_index++)
+            {
+                const Index offset = batch_index + batch_size*context_size*(depth_index + depth*head_index);
+
+                for(Index context_index = 0; context_index < context_size; context_index++)
+                {
+                    key(depth_index, context_index) = transformed_key_data[offset + batch_size*context_index];
+                    value(depth_index, context_index) = transformed_value_data[offset + batch_size*context_index];
+                }
+            }
+
+            Tensor<type, 2> key_derivatives(depth, context_size);
+            Tensor<type, 2> value_derivatives(depth, context_size);
+
+            key_derivatives.setZero();
+            value_derivatives.setZero();
+
+            Tensor<type, 2> query(depth, queries_block_number);
+            Tensor<type, 2> outputs_derivatives(depth, queries_block_number);
+            Tensor<type, 2> query_derivatives(depth, queries_block_number);
+            Tensor<type, 2> scores(context_size, queries_block_number);
+            Tensor<type, 2> scores_derivatives(context_size, queries_block_number);
+
+            Tensor<type, 1> outputs_times_derivatives(queries_block_number);
+
+            for(Index query_start = 0; query_start < input_size; query_start += queries_block_number)
+            {
+                const Index queries_number = min(queries_block_number, input_size - query_start);
+
+                const Index keys_end = causal_mask
+                        ? min(context_size, max(Index(0), query_start + queries_number + mask_offset))
+                        : context_size;
+
+                // Scaled query and attention outputs derivatives, with a column for each input position
+
+                outputs_times_derivatives.setZero();
+
+                for(Index depth_index = 0; depth_index < depth; depth_index++)
+                {
+                    const Index offset = batch_index + batch_size*(query_start + input_size*(depth_index + depth*head_index));
+
+                    for(Index query_index = 0; query_index < queries_number; query_index++)
+                    {
+                        query(depth_index, query_index) = transformed_query_data[offset + batch_size*query_index]*scaling_factor;
+
+                        outputs_derivatives(depth_index, query_index) = attention_outputs_derivatives_data[offset + batch_size*query_index];
+
+                        outputs_times_derivatives(query_index)
+                                += attention_outputs_data[offset + batch_size*query_index]*outputs_derivatives(depth_index, query_index);
+                    }
+                }
+
+                if(keys_end == 0)
+                {
+                    query_derivatives.setZero();
+                }
+                else
+                {
+                    const TensorMap<Tensor<type, 2>> query_block(query.data(), depth, queries_number);
+                    const TensorMap<Tensor<type, 2>> outputs_derivatives_block(outputs_derivatives.data(), depth, queries_number);
+
+                    const TensorMap<Tensor<type, 2>> key_block(key.data(), depth, keys_end);
+                    const TensorMap<Tensor<type, 2>> value_block(value.data(), depth, keys_end);
+
+                    TensorMap<Tensor<type, 2>> scores_block(scores.data(), keys_end, queries_number);
+                    TensorMap<Tensor<type, 2>> scores_derivatives_block(scores_derivatives.data(), keys_end, queries_number);
+
+                    TensorMap<Tensor<type, 2>> key_derivatives_block(key_derivatives.data(), depth, keys_end);
+                    TensorMap<Tensor<type, 2>> value_derivatives_block(value_derivatives.data(), depth, keys_end);
+
+                    TensorMap<Tensor<type, 2>> query_derivatives_block(query_derivatives.data(), depth, queries_number);
+
+                    // Attention scores
+
+                    if(stored_scores)
+                    {
+                        for(Index query_index = 0; query_index < queries_number; query_index++)
+                        {
+                            const Index sample_index = batch_index + batch_size*(query_start + query_index);
+
+                            for(Index key_index = 0; key_index < keys_end; key_index++)
+                            {
+                                scores_block(key_index, query_index)
+                                        = attention_scores_data[sample_index + batch_size*input_size*(key_index + context_size*head_index)];
+                            }
+                        }
+                    }
+                    else
+                    {
+                        scores_block = key_block.contract(query_block, AT_B);
+
+                        for(Index query_index = 0; query_index < queries_number; query_index++)
+                        {
+                            type* query_scores = scores_block.data() + query_index*keys_end;
+
+                            const Index visible_keys_number = causal_mask
+                                    ? min(keys_end, max(Index(0), query_start + query_index + mask_offset + 1))
+                                    : keys_end;
+
+                            type maximum = minus_infinity;
+
+                            for(Index key_index = 0; key_index < visible_keys_number; key_index++)
+                            {
+                                maximum = max(maximum, query_scores[key_index]);
+                            }
+
+                            type sum = type(0);
+
+                            for(Index key_index = 0; key_index < visible_keys_number; key_index++)
+                            {
+                                query_scores[key_index] = exp(query_scores[key_index] - maximum);
+
+                                sum += query_scores[key_index];
+                            }
+
+                            const type inverse_sum = sum > type(0) ? type(1)/sum : type(0);
+
+                            for(Index key_index = 0; key_index < visible_keys_number; key_index++)
+                            {
+                                query_scores[key_index] *= inverse_sum;
+                            }
+
+                            fill(query_scores + visible_keys_number, query_scores + keys_end, type(0));
+                        }
+                    }
+
+                    // Values derivatives
+
+                    value_derivatives_block += outputs_derivatives_block.contract(scores_block, A_BT);
+
+                    // Softmax derivatives
+
+                    scores_derivatives_block = value_block.contract(outputs_derivatives_block, AT_B);
+
+                    for(Index query_index = 0; query_index < queries_number; query_index++)
+                    {
+                        for(Index key_index = 0; key_index < keys_end; key_index++)
+                        {
+                            scores_derivatives_block(key_index, query_index)
+                                    = scores_block(key_index, query_index)
+                                    *(scores_derivatives_block(key_index, query_index) - outputs_times_derivatives(query_index));
+                        }
+                    }
+
+                    // Query and key derivatives
+
+                    query_derivatives_block = key_block.contract(scores_derivatives_block, A_B)*scaling_factor;
+
+                    key_derivatives_block += query_block.contract(scores_derivatives_block, A_BT);
+                }
+
+                for(Index depth_index = 0; depth_index < depth; depth_index++)
+                {
+                    const Index offset = batch_index + batch_size*(query_start + input_size*(depth_index + depth*head_index));
+
+                    for(Index query_index = 0; query_index < queries_number; query_index++)
+                    {
+                        transformed_query_derivatives_data[offset + batch_size*query_index] = query_derivatives(depth_index, query_index);
+                    }
+                }
+            }
+
+            for(Index depth_index = 0; depth_index < depth; depth_index++)
+            {
+                const Index offset = batch_index + batch_size*context_size*(depth_index + depth*head_index);
+
+                for(Index context_index = 0; context_index < context_size; context_index++)
+                {
+                    transformed_key_derivatives_data[offset + batch_size*context_index] = key_derivatives(depth_index, context_index);
+                    transformed_value_derivatives_data[offset + batch_size*context_index] = value_derivatives(depth_index, context_index);
+                }
+            }
+        }
+    }
+}
+
+
+void MultiheadAttentionLayer::insert_gradient(LayerBackPropagation* back_propagation, const Index& index, Tensor<type, 1>& gradient) const
+{
+    MultiheadAttentionLayerBackPropagation* multihead_attention_layer_back_propagation =
+            static_cast<MultiheadAttentionLayerBackPropagation*>(back_propagation);
+
+    const Tensor<type, 3>* kernels_derivatives[4] = {&multihead_attention_layer_back_propagation->query_kernel_derivatives,
+                                                     &multihead_attention_layer_back_propagation->key_kernel_derivatives,
+                                                     &multihead_attention_layer_back_propagation->value_kernel_derivatives,
+                                                     &multihead_attention_layer_back_propagation->projection_kernel_derivatives};
+
+    Index position = index;
+
+    for(Index i = 0; i < 4; i++)
+    {
+        copy(kernels_derivatives[i]->data(),
+             kernels_derivatives[i]->data() + kernels_derivatives[i]->size(),
+             gradient.data() + position);
+
+        position += kernels_derivatives[i]->size();
+    }
 }
 
 
@@ -22,6 +22,7 @@
 
 #include "config.h"
 #include "layer.h"
+#include "perceptron_layer.h"
 
 #ifdef OPENNN_MKL
 #include "../mkl/mkl.h"
@@ -72,6 +73,8 @@ public:
     Index get_depth() const;
     Index get_number_of_heads() const;
 
+    bool get_causal_mask() const;
+
     Tensor<Index, 1> get_inputs_dimensions() const final;
     Tensor<Index, 1> get_outputs_dimensions() const final;
 
@@ -82,6 +85,10 @@ public:
     Tensor<type, 3> get_projection_kernel() const;
 
     Index get_parameters_number() const final;
+    Tensor<type, 1> get_parameters() const final;
+    Tensor< TensorMap< Tensor<type, 1>>*, 1> get_layer_parameters() final;
+
+    bool get_recompute_attention_scores() const;
 
     // Display messages
 
@@ -103,27 +110,41 @@ public:
     void set_number_of_heads(const Index&);
 
     void set_kernels();
+    void set_parameters(const Tensor<type, 1>&, const Index& = 0) final;
     void set_parameters_random() final;
 
     void set_dropout_rate(const type&);
 
+    void set_causal_mask(const bool&);
+
+    void set_recompute_attention_scores(const bool&);
+
     // Display messages
 
     void set_display(const bool&);
 
     // Linear transformation & projection
 
-    void calculate_query_transformation(const Tensor<type, 3>&, type*);
-    void calculate_key_transformation(const Tensor<type, 3>&, type*);
-    void calculate_value_transformation(const Tensor<type, 3>&, type*);
+    void calculate_transformation(const TensorMap<Tensor<type, 3>>&, const Tensor<type, 3>&, type*) const;
+
+    void calculate_query_transformation(const TensorMap<Tensor<type, 3>>&, type*) const;
+    void calculate_key_transformation(const TensorMap<Tensor<type, 3>>&, type*) const;
+    void calculate_value_transformation(const TensorMap<Tensor<type, 3>>&, type*) const;
 
-    void calculate_output_projection(const Tensor<type, 4>&, type*);
+    void calculate_output_projection(const TensorMap<Tensor<type, 4>>&, type*) const;
 
     // Attention computation
 
-    void compute_attention_scores(type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&, type*); /// Softmax before saving
+    void compute_attention(const TensorMap<Tensor<type, 4>>&,
+                           const TensorMap<Tensor<type, 4>>&,
+                           const TensorMap<Tensor<type, 4>>&,
+                           const Index&,
+                           type*,
+                           type*) const;
 
-    void compute_attention_output(type*, const Tensor<Index, 1>&, type*, const Tensor<Index, 1>&, type*);
+    void update_key_value_cache(const TensorMap<Tensor<type, 3>>&,
+                                const TensorMap<Tensor<type, 3>>&,
+                                MultiheadAttentionLayerForwardPropagation*) const;
 
     // Multihead Attention layer outputs
 
@@ -137,6 +158,56 @@ public:
                            Tensor<type, 1>&,
                            LayerForwardPropagation*) final;
 */
+
+    // Delta methods
+
+    void calculate_hidden_delta(LayerForwardPropagation*,
+                                LayerBackPropagation*,
+                                LayerBackPropagation*) const final;
+
+    void calculate_hidden_delta(PerceptronLayerForwardPropagation*,
+                                PerceptronLayerBackPropagation*,
+                                MultiheadAttentionLayerBackPropagation*) const;
+
+    void calculate_hidden_delta(MultiheadAttentionLayerForwardPropagation*,
+                                MultiheadAttentionLayerBackPropagation*,
+                                MultiheadAttentionLayerBackPropagation*) const;
+
+    void calculate_inputs_derivatives(MultiheadAttentionLayerForwardPropagation*,
+                                      MultiheadAttentionLayerBackPropagation*) const;
+
+    void calculate_inputs_deltas(LayerForwardPropagation*,
+                                 LayerBackPropagation*,
+                                 type*) const;
+
+    void calculate_inputs_deltas(LayerForwardPropagation*,
+                                 LayerBackPropagation*,
+                                 const Index&,
+                                 type*) const;
+
+    // Gradient methods
+
+    void calculate_error_gradient(type*,
+                                  LayerForwardPropagation*,
+                                  LayerBackPropagation*) const final;
+
+    void calculate_error_gradient(const Tensor<DynamicTensor<type>, 1>&,
+                                  LayerForwardPropagation*,
+                                  LayerBackPropagation*) const final;
+
+    void calculate_transformation_inputs_derivatives(const Tensor<type, 3>&,
+                                                     const type*,
+                                                     const Index&,
+                                                     type*) const;
+
+    void calculate_transformation_kernel_derivatives(const TensorMap<Tensor<type, 3>>&,
+                                                     const type*,
+                                                     Tensor<type, 3>&) const;
+
+    void compute_attention_derivatives(MultiheadAttentionLayerForwardPropagation*,
+                                       MultiheadAttentionLayerBackPropagation*) const;
+
+    void insert_gradient(LayerBackPropagation*, const Index&, Tensor<type, 1>&) const final;
     // Expression methods
 
 //    string write_expression(const Tensor<string, 1>&, const Tensor<string, 1>&) const final;
@@ -183,6 +254,19 @@ protected:
 
     type dropout_rate = type(0);
 
+    /// True if each input position only attends to the context positions up to its own.
+
+    bool causal_mask = false;
+
+    /// True to calculate again the attention scores in the back propagation, instead of storing them in the forward propagation.
+
+    bool recompute_attention_scores = false;
+
+    /// Number of input and context positions in the blocks of the attention computation.
+
+    const Index queries_block_size = 64;
+    const Index keys_block_size = 256;
+
     /// Display messages to screen.
 
     bool display = true;
@@ -214,33 +298,61 @@ protected:
 
         void set(const Index& new_batch_samples_number, Layer* new_layer_pointer) final
         {
-            MultiheadAttentionLayer* layer_pointer = static_cast<MultiheadAttentionLayer*>(new_layer_pointer);
+            layer_pointer = new_layer_pointer;
+
+            const MultiheadAttentionLayer* multihead_attention_layer_pointer = static_cast<MultiheadAttentionLayer*>(new_layer_pointer);
 
             batch_samples_number = new_batch_samples_number;
 
-            const Index input_size = layer_pointer->get_input_size();
+            const Index input_size = multihead_attention_layer_pointer->get_input_size();
 
-            const Index context_size = layer_pointer->get_context_size();
+            const Index context_size = multihead_attention_layer_pointer->get_context_size();
 
-            const Index depth = layer_pointer->get_depth();
+            const Index depth = multihead_attention_layer_pointer->get_depth();
 
-            const Index number_of_heads = layer_pointer->get_number_of_heads();
+            const Index number_of_heads = multihead_attention_layer_pointer->get_number_of_heads();
 
             // Outputs
 
             outputs.resize(1);
             Tensor<Index, 1> output_dimensions(3);
             output_dimensions.setValues({batch_samples_number, input_size, depth});
-            outputs(0).set_dimensions(output_dimensions);
+            set_buffer_dimensions(outputs(0), output_dimensions);
 
             // Rest of quantities
 
-            transformed_query.resize(new_batch_samples_number, input_size, depth, number_of_heads);
+            Tensor<Index, 1> heads_dimensions(4);
+            heads_dimensions.setValues({new_batch_samples_number, input_size, depth, number_of_heads});
+
+            set_buffer_dimensions(transformed_query, heads_dimensions);
             transformed_key.resize(new_batch_samples_number, context_size, depth, number_of_heads);
             transformed_value.resize(new_batch_samples_number, context_size, depth, number_of_heads);
 
-            attention_scores.resize(new_batch_samples_number, input_size, context_size, number_of_heads);
-            attention_outputs.resize(new_batch_samples_number, input_size, depth, number_of_heads);
+            // The attention scores are only allocated by a training forward propagation
+
+            attention_scores.resize(0, 0, 0, 0);
+            set_buffer_dimensions(attention_outputs, heads_dimensions);
+
+            cached_positions = 0;
+        }
+
+
+        void reset_states() final
+        {
+            cached_positions = 0;
+        }
+
+
+        /// The transformed key and value are not workspaces, as incremental forward propagations keep them.
+
+        Tensor<DynamicTensor<type>*, 1> get_workspaces() final
+        {
+            Tensor<DynamicTensor<type>*, 1> workspaces(2);
+
+            workspaces(0) = &transformed_query;
+            workspaces(1) = &attention_outputs;
+
+            return workspaces;
         }
 
         void print() const
@@ -261,7 +373,7 @@ protected:
 
         type* get_transformed_query_data()
         {
-            return transformed_query.data();
+            return transformed_query.get_data();
         }
 
         type* get_transformed_key_data()
@@ -281,15 +393,23 @@ protected:
 
         type* get_attention_outputs_data()
         {
-            return attention_outputs.data();
+            return attention_outputs.get_data();
         }
 
-        Tensor<type, 4> transformed_query;
+        DynamicTensor<type> transformed_query;
+
+        /// In an incremental forward propagation, the transformed key and value hold the context positions
+        /// of the previous forward propagations too, up to the number of cached positions.
+
         Tensor<type, 4> transformed_key;
         Tensor<type, 4> transformed_value;
 
+        Index cached_positions = 0;
+
+        /// Softmax probabilities of each input position over the context positions.
+
         Tensor<type, 4> attention_scores;
-        Tensor<type, 4> attention_outputs;
+        DynamicTensor<type> attention_outputs;
     };
 
 
@@ -370,32 +490,56 @@ protected:
         {
             layer_pointer = new_layer_pointer;
 
+            const MultiheadAttentionLayer* multihead_attention_layer_pointer = static_cast<MultiheadAttentionLayer*>(new_layer_pointer);
+
             batch_samples_number = new_batch_samples_number;
 
-            const Index neurons_number = layer_pointer->get_neurons_number();
-            const Index inputs_number = layer_pointer->get_inputs_number();
+            const Index input_size = multihead_attention_layer_pointer->get_input_size();
+
+            const Index context_size = multihead_attention_layer_pointer->get_context_size();
+
+            const Index depth = multihead_attention_layer_pointer->get_depth();
+
+            const Index number_of_heads = multihead_attention_layer_pointer->get_number_of_heads();
 
-            deltas_dimensions.resize(2);
-            deltas_dimensions.setValues({batch_samples_number, neurons_number});
+            // Deltas
 
-            deltas_data = (type*)malloc( static_cast<size_t>(batch_samples_number*neurons_number*sizeof(type)));
+            deltas_dimensions.resize(3);
+            deltas_dimensions.setValues({batch_samples_number, input_size, depth});
 
-            biases_derivatives.resize(neurons_number);
+            free(deltas_data);
+            deltas_data = (type*)malloc(static_cast<size_t>(batch_samples_number*input_size*depth*sizeof(type)));
 
-            synaptic_weights_derivatives.resize(inputs_number, neurons_number);
+            // Kernels derivatives
 
-            deltas_times_activations_derivatives.resize(batch_samples_number, neurons_number);
+            query_kernel_derivatives.resize(depth, depth, number_of_heads);
+            key_kernel_derivatives.resize(depth, depth, number_of_heads);
+            value_kernel_derivatives.resize(depth, depth, number_of_heads);
+
+            projection_kernel_derivatives.resize(depth, depth, number_of_heads);
+
+            // Rest of quantities
+
+            attention_outputs_derivatives.resize(batch_samples_number, input_size, depth, number_of_heads);
+
+            transformed_query_derivatives.resize(batch_samples_number, input_size, depth, number_of_heads);
+            transformed_key_derivatives.resize(batch_samples_number, context_size, depth, number_of_heads);
+            transformed_value_derivatives.resize(batch_samples_number, context_size, depth, number_of_heads);
+
+            query_derivatives.resize(batch_samples_number, input_size, depth);
+            key_derivatives.resize(batch_samples_number, context_size, depth);
+            value_derivatives.resize(batch_samples_number, context_size, depth);
         }
 
+
         Tensor< TensorMap< Tensor<type, 1> >*, 1> get_layer_gradient()
         {
-            Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_gradient(2);
-
-            const Index inputs_number = layer_pointer->get_inputs_number();
-            const Index neurons_number = layer_pointer->get_neurons_number();
+            Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_gradient(4);
 
-            layer_gradient(0) = new TensorMap<Tensor<type, 1>>(biases_derivatives.data(), neurons_number);
-            layer_gradient(1) = new TensorMap<Tensor<type, 1>>(synaptic_weights_derivatives.data(), inputs_number*neurons_number);
+            layer_gradient(0) = new TensorMap<Tensor<type, 1>>(query_kernel_derivatives.data(), query_kernel_derivatives.size());
+            layer_gradient(1) = new TensorMap<Tensor<type, 1>>(key_kernel_derivatives.data(), key_kernel_derivatives.size());
+            layer_gradient(2) = new TensorMap<Tensor<type, 1>>(value_kernel_derivatives.data(), value_kernel_derivatives.size());
+            layer_gradient(3) = new TensorMap<Tensor<type, 1>>(projection_kernel_derivatives.data(), projection_kernel_derivatives.size());
 
             return layer_gradient;
         }
@@ -403,21 +547,41 @@ protected:
 
         void print() const
         {
-            cout << "Deltas:" << endl;
-            //cout << deltas << endl;
+            cout << "Query kernel derivatives:" << endl;
+            cout << query_kernel_derivatives << endl;
 
-            cout << "Biases derivatives:" << endl;
-            cout << biases_derivatives << endl;
+            cout << "Key kernel derivatives:" << endl;
+            cout << key_kernel_derivatives << endl;
 
-            cout << "Synaptic weights derivatives:" << endl;
-            cout << synaptic_weights_derivatives << endl;
+            cout << "Value kernel derivatives:" << endl;
+            cout << value_kernel_derivatives << endl;
+
+            cout << "Projection kernel derivatives:" << endl;
+            cout << projection_kernel_derivatives << endl;
         }
 
-        Tensor<type, 1> biases_derivatives;
-        Tensor<type, 2> synaptic_weights_derivatives;
+        Tensor<type, 3> query_kernel_derivatives;
+        Tensor<type, 3> key_kernel_derivatives;
+        Tensor<type, 3> value_kernel_derivatives;
+
+        Tensor<type, 3> projection_kernel_derivatives;
+
+        Tensor<type, 4> attention_outputs_derivatives;
+
+        Tensor<type, 4> transformed_query_derivatives;
+        Tensor<type, 4> transformed_key_derivatives;
+        Tensor<type, 4> transformed_value_derivatives;
+
+        /// Derivatives of the error with respect to the query, key and value inputs of the layer.
+
+        Tensor<type, 3> query_derivatives;
+        Tensor<type, 3> key_derivatives;
+        Tensor<type, 3> value_derivatives;
 
-        Tensor<type, 2> deltas_times_activations_derivatives;
+        /// True if the derivatives of the inputs were calculated with the deltas of the previous layer,
+        /// so that the error gradient does not calculate them again.
 
+        bool inputs_derivatives_calculated = false;
     };
 
 }
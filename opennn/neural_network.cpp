@@ -86,6 +86,8 @@ NeuralNetwork::NeuralNetwork(const Tensor<Layer*, 1>& new_layers_pointers)
     set();
 
     layers_pointers = new_layers_pointers;
+
+    update_layers_graph();
 }
 
 
@@ -94,6 +96,8 @@ NeuralNetwork::NeuralNetwork(const Tensor<Layer*, 1>& new_layers_pointers)
 NeuralNetwork::~NeuralNetwork()
 {
     delete_layers();
+
+    delete outputs_forward_propagation;
 }
 
 
@@ -109,6 +113,8 @@ void NeuralNetwork::delete_layers()
     }
 
     layers_pointers.resize(0);
+
+    update_layers_graph();
 }
 
 
@@ -164,6 +170,8 @@ void NeuralNetwork::add_layer(Layer* layer_pointer)
 
             layers_inputs_indices(old_layers_number) = new_layer_inputs_indices;
         }
+
+        update_layers_graph();
     }
     else
     {
@@ -341,6 +349,33 @@ bool NeuralNetwork::is_empty() const
 }
 
 
+/// Returns true if each layer takes as inputs only the outputs of the previous layer,
+/// and false if the layers inputs indices define a more general graph.
+
+bool NeuralNetwork::is_sequential() const
+{
+    // Layers without inputs indices take the outputs of the previous layer
+
+    const Index layers_number = min(get_layers_number(), Index(layers_inputs_indices.size()));
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        const Tensor<Index, 1>& layer_inputs_indices = layers_inputs_indices(i);
+
+        if(i == 0)
+        {
+            if(layer_inputs_indices.size() != 0) return false;
+        }
+        else if(layer_inputs_indices.size() != 1 || layer_inputs_indices(0) != i-1)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 /// Returns a string vector with the names of the variables used as inputs.
 
 const Tensor<string, 1>& NeuralNetwork::get_inputs_names() const
@@ -527,6 +562,226 @@ Tensor<Tensor<Index, 1>, 1> NeuralNetwork::get_layers_inputs_indices() const
 }
 
 
+/// Returns the indices of the layers whose outputs are the inputs of a given layer.
+/// An empty vector means that the layer takes the inputs of the neural network.
+/// If the inputs indices of that layer have not been set, the layer takes the outputs of the previous one.
+/// @param layer_index Index of the layer.
+
+Tensor<Index, 1> NeuralNetwork::get_layer_inputs_indices(const Index& layer_index) const
+{
+    if(layer_index < layers_inputs_indices.size()) return layers_inputs_indices(layer_index);
+
+    if(layer_index == 0) return Tensor<Index, 1>();
+
+    Tensor<Index, 1> layer_inputs_indices(1);
+    layer_inputs_indices(0) = layer_index - 1;
+
+    return layer_inputs_indices;
+}
+
+
+/// Returns, for each layer, the indices of the layers which take its outputs as inputs.
+/// They are calculated when the layers connections change.
+
+const Tensor<Tensor<Index, 1>, 1>& NeuralNetwork::get_layers_outputs_indices() const
+{
+    return layers_outputs_indices;
+}
+
+
+/// Returns the layers grouped in execution levels, from the inputs to the outputs of the neural network.
+/// They are calculated when the layers connections change.
+/// If the layers inputs indices are not valid, it throws the exception of calculate_layers_execution_levels().
+
+const Tensor<Tensor<Index, 1>, 1>& NeuralNetwork::get_layers_execution_levels() const
+{
+    if(layers_execution_levels.size() == 0 && get_layers_number() != 0) calculate_layers_execution_levels();
+
+    return layers_execution_levels;
+}
+
+
+/// Calculates the layers outputs indices and execution levels from the layers inputs indices,
+/// so that the forward and back propagation of graphs do not calculate them on every call.
+/// It must be called whenever the layers or their inputs indices change.
+/// Inputs indices may be temporarily not valid while a graph is being connected, and then the execution levels are left empty.
+
+void NeuralNetwork::update_layers_graph()
+{
+    delete outputs_forward_propagation;
+
+    outputs_forward_propagation = nullptr;
+
+    layers_outputs_indices = calculate_layers_outputs_indices();
+
+    try
+    {
+        layers_execution_levels = calculate_layers_execution_levels();
+    }
+    catch(const invalid_argument&)
+    {
+        layers_execution_levels.resize(0);
+    }
+}
+
+
+/// Calculates, for each layer, the indices of the layers which take its outputs as inputs.
+/// Inputs indices which are not valid are ignored.
+
+Tensor<Tensor<Index, 1>, 1> NeuralNetwork::calculate_layers_outputs_indices() const
+{
+    const Index layers_number = get_layers_number();
+
+    Tensor<Index, 1> layers_outputs_number(layers_number);
+    layers_outputs_number.setZero();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        const Tensor<Index, 1> layer_inputs_indices = get_layer_inputs_indices(i);
+
+        for(Index j = 0; j < layer_inputs_indices.size(); j++)
+        {
+            const Index input_index = layer_inputs_indices(j);
+
+            if(input_index >= 0 && input_index < layers_number) layers_outputs_number(input_index)++;
+        }
+    }
+
+    Tensor<Tensor<Index, 1>, 1> layers_outputs_indices(layers_number);
+
+    for(Index i = 0; i < layers_number; i++) layers_outputs_indices(i).resize(layers_outputs_number(i));
+
+    layers_outputs_number.setZero();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        const Tensor<Index, 1> layer_inputs_indices = get_layer_inputs_indices(i);
+
+        for(Index j = 0; j < layer_inputs_indices.size(); j++)
+        {
+            const Index input_index = layer_inputs_indices(j);
+
+            if(input_index < 0 || input_index >= layers_number) continue;
+
+            layers_outputs_indices(input_index)(layers_outputs_number(input_index)) = i;
+
+            layers_outputs_number(input_index)++;
+        }
+    }
+
+    return layers_outputs_indices;
+}
+
+
+/// Calculates the layers grouped in execution levels, from the inputs to the outputs of the neural network.
+/// Each layer is placed one level after the deepest of its inputs layers,
+/// so that the layers of a level depend only on previous levels and can be calculated concurrently.
+
+Tensor<Tensor<Index, 1>, 1> NeuralNetwork::calculate_layers_execution_levels() const
+{
+    const Index layers_number = get_layers_number();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        const Tensor<Index, 1> layer_inputs_indices = get_layer_inputs_indices(i);
+
+        for(Index j = 0; j < layer_inputs_indices.size(); j++)
+        {
+            if(layer_inputs_indices(j) < 0 || layer_inputs_indices(j) >= layers_number || layer_inputs_indices(j) == i)
+            {
+                ostringstream buffer;
+
+                buffer << "OpenNN Exception: NeuralNetwork class.\n"
+                       << "Tensor<Tensor<Index, 1>, 1> calculate_layers_execution_levels() const method.\n"
+                       << "Input index " << layer_inputs_indices(j) << " of layer " << i << " is not valid.\n";
+
+                throw invalid_argument(buffer.str());
+            }
+        }
+    }
+
+    Tensor<Index, 1> layers_levels(layers_number);
+    layers_levels.setConstant(-1);
+
+    Index levels_number = 0;
+    Index sorted_layers_number = 0;
+
+    bool has_changed = true;
+
+    while(sorted_layers_number < layers_number && has_changed)
+    {
+        has_changed = false;
+
+        for(Index i = 0; i < layers_number; i++)
+        {
+            if(layers_levels(i) != -1) continue;
+
+            const Tensor<Index, 1> layer_inputs_indices = get_layer_inputs_indices(i);
+
+            Index layer_level = 0;
+
+            bool is_ready = true;
+
+            for(Index j = 0; j < layer_inputs_indices.size(); j++)
+            {
+                const Index input_level = layers_levels(layer_inputs_indices(j));
+
+                if(input_level == -1)
+                {
+                    is_ready = false;
+                    break;
+                }
+
+                layer_level = max(layer_level, input_level + 1);
+            }
+
+            if(!is_ready) continue;
+
+            layers_levels(i) = layer_level;
+
+            levels_number = max(levels_number, layer_level + 1);
+
+            sorted_layers_number++;
+
+            has_changed = true;
+        }
+    }
+
+    if(sorted_layers_number != layers_number)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: NeuralNetwork class.\n"
+               << "Tensor<Tensor<Index, 1>, 1> calculate_layers_execution_levels() const method.\n"
+               << "Layers inputs indices contain a cycle.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    Tensor<Index, 1> levels_layers_number(levels_number);
+    levels_layers_number.setZero();
+
+    for(Index i = 0; i < layers_number; i++) levels_layers_number(layers_levels(i))++;
+
+    Tensor<Tensor<Index, 1>, 1> layers_execution_levels(levels_number);
+
+    for(Index i = 0; i < levels_number; i++) layers_execution_levels(i).resize(levels_layers_number(i));
+
+    levels_layers_number.setZero();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        const Index layer_level = layers_levels(i);
+
+        layers_execution_levels(layer_level)(levels_layers_number(layer_level)) = i;
+
+        levels_layers_number(layer_level)++;
+    }
+
+    return layers_execution_levels;
+}
+
+
 /// Returns a pointer to the scaling layer object composing this neural network object.
 
 ScalingLayer* NeuralNetwork::get_scaling_layer_pointer() const
@@ -1129,21 +1384,41 @@ void NeuralNetwork::set_threads_number(const int& new_threads_number)
 }
 
 
+/// Sets all the layers to use fast approximate activation functions, or the exact ones.
+/// @param new_fast_activations True to use the approximations.
+
+void NeuralNetwork::set_fast_activations(const bool& new_fast_activations)
+{
+    const Index layers_number = get_layers_number();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        layers_pointers(i)->set_fast_activations(new_fast_activations);
+    }
+}
+
+
 void NeuralNetwork::set_layers_pointers(Tensor<Layer*, 1>& new_layers_pointers)
 {
     layers_pointers = new_layers_pointers;
+
+    update_layers_graph();
 }
 
 
 void NeuralNetwork::set_layers_inputs_indices(const Tensor<Tensor<Index, 1>, 1>& new_layers_inputs_indices)
 {
     layers_inputs_indices = new_layers_inputs_indices;
+
+    update_layers_graph();
 }
 
 
 void NeuralNetwork::set_layer_inputs_indices(const Index& layer_index, const Tensor<Index, 1>& new_layer_inputs_indices)
 {
     layers_inputs_indices(layer_index) = new_layer_inputs_indices;
+
+    update_layers_graph();
 }
 
 
@@ -1161,6 +1436,8 @@ void NeuralNetwork::set_layer_inputs_indices(const string& layer_name, const Ten
     }
 
     layers_inputs_indices(layer_index) = new_layer_inputs_indices;
+
+    update_layers_graph();
 }
 
 
@@ -1173,6 +1450,8 @@ void NeuralNetwork::set_layer_inputs_indices(const string& layer_name, const str
     new_layer_inputs_indices(0) = get_layer_index(new_layer_inputs_name);
 
     layers_inputs_indices(layer_index) = new_layer_inputs_indices;
+
+    update_layers_graph();
 }
 
 
@@ -1576,6 +1855,46 @@ void NeuralNetwork::set_parameters(Tensor<type, 1>& new_parameters) const
 }
 
 
+/// Sets only the parameters which lie in the given segments, as those updated from a sparse gradient.
+/// Layers with dense gradients set all their parameters, and layers with sparse gradients only the rows in the segments.
+/// @param new_parameters Parameters of the whole neural network.
+/// @param segments Segments of the parameters to be set, as pairs of first index and size.
+
+void NeuralNetwork::set_parameters_segments(const Tensor<type, 1>& new_parameters,
+                                            const vector<pair<Index, Index>>& segments) const
+{
+    const Index trainable_layers_number = get_trainable_layers_number();
+
+    const Tensor<Layer*, 1> trainable_layers_pointers = get_trainable_layers_pointers();
+
+    const Tensor<Index, 1> trainable_layers_parameters_numbers = get_trainable_layers_parameters_numbers();
+
+    Index index = 0;
+
+    for(Index i = 0; i < trainable_layers_number; i++)
+    {
+        trainable_layers_pointers(i)->set_parameters_segments(new_parameters, index, segments);
+
+        index += trainable_layers_parameters_numbers(i);
+    }
+}
+
+
+/// Returns true if some trainable layer of the neural network has a sparse error gradient, as embedding layers.
+
+bool NeuralNetwork::has_sparse_gradient() const
+{
+    const Tensor<Layer*, 1> trainable_layers_pointers = get_trainable_layers_pointers();
+
+    for(Index i = 0; i < trainable_layers_pointers.size(); i++)
+    {
+        if(trainable_layers_pointers(i)->has_sparse_gradient()) return true;
+    }
+
+    return false;
+}
+
+
 /// Sets a new display value.
 /// If it is set to true messages from this class are displayed on the screen;
 /// if it is set to false messages from this class are not displayed on the screen.
@@ -1914,17 +2233,34 @@ void NeuralNetwork::forward_propagate(const DataSetBatch& batch,
     const Index first_trainable_layer_index = get_first_trainable_layer_index();
     const Index last_trainable_layer_index = get_last_trainable_layer_index();
 
-    const Tensor<DynamicTensor<type>, 1> inputs = batch.inputs;
+    if(!is_sequential())
+    {
+        forward_propagate_graph(batch.inputs,
+                                forward_propagation,
+                                first_trainable_layer_index,
+                                last_trainable_layer_index,
+                                is_training);
+        return;
+    }
+
+    for(Index i = first_trainable_layer_index; i <= last_trainable_layer_index; i++)
+    {
+        // The outputs of the previous layer are passed by reference, not copied
+
+        const Tensor<DynamicTensor<type>, 1>& inputs = i == first_trainable_layer_index
+                ? batch.inputs
+                : forward_propagation.layers(i-1)->outputs;
 
-    layers_pointers(first_trainable_layer_index)->forward_propagate(inputs,
-                                                                    forward_propagation.layers(first_trainable_layer_index),
-                                                                    is_training);
+        if(i < last_trainable_layer_index && is_convolution_pooling_block(i))
+        {
+            forward_propagate_convolution_pooling_block(inputs, forward_propagation, i, is_training);
+
+            i++;
 
-    for(Index i = first_trainable_layer_index + 1; i <= last_trainable_layer_index; i++)
-    {       
-        const Tensor<DynamicTensor<type>, 1> outputs = forward_propagation.layers(i-1)->outputs;
+            continue;
+        }
 
-        layers_pointers(i)->forward_propagate(outputs,
+        layers_pointers(i)->forward_propagate(inputs,
                                               forward_propagation.layers(i),
                                               is_training);
     }
@@ -1940,23 +2276,89 @@ void NeuralNetwork::forward_propagate_deploy(DataSetBatch& batch,
 
     const bool is_training = false;
 
-    Tensor<DynamicTensor<type>, 1> inputs = batch.inputs;
-
-    layers_pointers(0)->forward_propagate(inputs,
-                                          forward_propagation.layers(0),
-                                          is_training);
+    if(!is_sequential())
+    {
+        forward_propagate_graph(batch.inputs, forward_propagation, 0, layers_number-1, is_training);
+        return;
+    }
 
-    for(Index i = 1; i < layers_number; i++)
+    for(Index i = 0; i < layers_number; i++)
     {
-        const Tensor<DynamicTensor<type>, 1> outputs = forward_propagation.layers(i-1)->outputs;
+        const Tensor<DynamicTensor<type>, 1>& inputs = i == 0
+                ? batch.inputs
+                : forward_propagation.layers(i-1)->outputs;
+
+        if(i < layers_number - 1 && is_convolution_pooling_block(i))
+        {
+            forward_propagate_convolution_pooling_block(inputs, forward_propagation, i, is_training);
+
+            i++;
+
+            continue;
+        }
 
-        layers_pointers(i)->forward_propagate(outputs,
+        layers_pointers(i)->forward_propagate(inputs,
                                               forward_propagation.layers(i),
                                               is_training);
     }
 }
 
 
+/// Returns true if the outputs of a convolutional layer are only taken by a pooling layer,
+/// which takes no other inputs, and both can be calculated as a single block which only writes the pooled outputs.
+/// The pooling layer is found from the layers connections, so the block may also be part of a graph.
+/// @param layer_index Index of the convolutional layer.
+
+bool NeuralNetwork::is_convolution_pooling_block(const Index& layer_index) const
+{
+    if(layer_index >= layers_outputs_indices.size()) return false;
+
+    if(layers_pointers(layer_index)->get_type() != Layer::Type::Convolutional
+    || layers_outputs_indices(layer_index).size() != 1)
+    {
+        return false;
+    }
+
+    const Index pooling_layer_index = layers_outputs_indices(layer_index)(0);
+
+    if(layers_pointers(pooling_layer_index)->get_type() != Layer::Type::Pooling
+    || get_layer_inputs_indices(pooling_layer_index).size() != 1)
+    {
+        return false;
+    }
+
+    const ConvolutionalLayer* convolutional_layer = static_cast<ConvolutionalLayer*>(layers_pointers(layer_index));
+
+    return convolutional_layer->is_fusable(static_cast<PoolingLayer*>(layers_pointers(pooling_layer_index)));
+}
+
+
+/// Calculates a convolutional layer and the pooling layer which takes its outputs as a single block.
+/// The pooled outputs are written to the forward propagation of the pooling layer.
+/// @param inputs Inputs of the convolutional layer.
+/// @param forward_propagation Forward propagation of the neural network.
+/// @param layer_index Index of the convolutional layer.
+/// @param is_training True if the neural network is being trained.
+
+void NeuralNetwork::forward_propagate_convolution_pooling_block(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                                                NeuralNetworkForwardPropagation& forward_propagation,
+                                                                const Index& layer_index,
+                                                                const bool& is_training) const
+{
+    const Index pooling_layer_index = layers_outputs_indices(layer_index)(0);
+
+    const ConvolutionalLayer* convolutional_layer = static_cast<ConvolutionalLayer*>(layers_pointers(layer_index));
+
+    const PoolingLayer* pooling_layer = static_cast<PoolingLayer*>(layers_pointers(pooling_layer_index));
+
+    convolutional_layer->forward_propagate_max_pooling(inputs,
+                                                       forward_propagation.layers(layer_index),
+                                                       pooling_layer,
+                                                       forward_propagation.layers(pooling_layer_index),
+                                                       is_training);
+}
+
+
 /// Calculates the forward propagation in the neural network.
 /// @param batch DataSetBatch of data set that contains the inputs and targets to be trained.
 /// @param parameters Parameters of neural network.
@@ -1978,40 +2380,306 @@ void NeuralNetwork::forward_propagate(const DataSetBatch& batch,
 }
 
 
-Tensor<type, 2> NeuralNetwork::calculate_outputs(type* inputs_data, Tensor<Index, 1>&inputs_dimensions)
+/// Places the outputs and the workspaces of the layers in a single buffer for inference,
+/// reusing the memory of buffers which are no longer needed.
+/// The outputs of a layer are alive from the execution level of that layer until the execution level of its last consumer,
+/// and its workspaces only at the execution level of that layer.
+/// Buffers of layers of the same level are alive at the same time, so they never share memory.
+/// The pooled outputs of a convolution pooling block are alive from the level of the convolutional layer.
+/// Buffers are placed from the largest to the smallest, each one at the lowest offset which does not overlap
+/// with the buffers already placed that are alive at the same time.
+/// Returns the size of the buffer.
+/// @param layers_outputs_sizes Number of elements of the outputs of each layer.
+/// @param layers_workspaces_sizes Number of elements of the workspaces of each layer.
+/// @param layers_outputs_offsets Offset of the outputs of each layer in the buffer.
+/// @param layers_workspaces_offsets Offset of the workspaces of each layer in the buffer.
+
+Index NeuralNetwork::calculate_inference_memory_plan(const Tensor<Index, 1>& layers_outputs_sizes,
+                                                     const Tensor<Index, 1>& layers_workspaces_sizes,
+                                                     Tensor<Index, 1>& layers_outputs_offsets,
+                                                     Tensor<Index, 1>& layers_workspaces_offsets) const
 {
+    const Index layers_number = get_layers_number();
 
-    const Index inputs_rank = inputs_dimensions.size();
+    const Tensor<Tensor<Index, 1>, 1>& layers_execution_levels = get_layers_execution_levels();
 
-    if(inputs_rank == 2)
-    {
-        DataSetBatch data_set_batch;
+    const Index levels_number = layers_execution_levels.size();
 
-        data_set_batch.inputs.resize(1);
-        data_set_batch.inputs(0).set_dimensions(inputs_dimensions);
+    // Buffers: the outputs of each layer, followed by the workspaces of each layer
 
-        const Tensor<Index, 0> size = inputs_dimensions.prod();
+    const Index buffers_number = 2*layers_number;
 
-        memcpy(data_set_batch.inputs(0).get_data(), inputs_data, static_cast<size_t>(size(0)*sizeof(type)) );
+    Tensor<Index, 1> buffers_sizes(buffers_number);
 
-        const Index batch_samples_number = inputs_dimensions(0);
+    for(Index i = 0; i < layers_number; i++)
+    {
+        buffers_sizes(i) = layers_outputs_sizes(i);
+        buffers_sizes(layers_number + i) = layers_workspaces_sizes(i);
+    }
 
-        NeuralNetworkForwardPropagation neural_network_forward_propagation(batch_samples_number, this);
+    // Lifetimes
 
-        forward_propagate_deploy(data_set_batch, neural_network_forward_propagation);
+    Tensor<Index, 1> layers_levels(layers_number);
 
-        const Index layers_number = get_layers_number();
+    for(Index i = 0; i < levels_number; i++)
+    {
+        for(Index j = 0; j < layers_execution_levels(i).size(); j++) layers_levels(layers_execution_levels(i)(j)) = i;
+    }
 
-        if(layers_number == 0) return Tensor<type, 2>();
+    Tensor<Index, 1> first_levels(buffers_number);
+    Tensor<Index, 1> last_levels(buffers_number);
 
-        return neural_network_forward_propagation.layers(layers_number - 1)->outputs(0).to_tensor_map<2>();
-    }
-    else
+    for(Index i = 0; i < layers_number; i++)
     {
-        ostringstream buffer;
+        first_levels(i) = layers_levels(i);
 
-        buffer << "OpenNN Exception: NeuralNetwork class.\n"
-               << "Tensor<type, 2> calculate_outputs(type* , Tensor<Index, 1>&).\n"
+        first_levels(layers_number + i) = layers_levels(i);
+        last_levels(layers_number + i) = layers_levels(i);
+
+        // Outputs of the neural network are kept until the end
+
+        if(layers_outputs_indices(i).size() == 0)
+        {
+            last_levels(i) = levels_number;
+            continue;
+        }
+
+        last_levels(i) = first_levels(i);
+
+        for(Index j = 0; j < layers_outputs_indices(i).size(); j++)
+        {
+            last_levels(i) = max(last_levels(i), layers_levels(layers_outputs_indices(i)(j)));
+        }
+    }
+
+    // The pooled outputs of a convolution pooling block are written while the inputs of the convolution are read
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        if(is_convolution_pooling_block(i)) first_levels(layers_outputs_indices(i)(0)) = layers_levels(i);
+    }
+
+    // Placement
+
+    Tensor<Index, 1> sorted_buffers_indices(buffers_number);
+
+    for(Index i = 0; i < buffers_number; i++) sorted_buffers_indices(i) = i;
+
+    sort(sorted_buffers_indices.data(), sorted_buffers_indices.data() + buffers_number,
+         [&](const Index& a, const Index& b)
+    {
+        return buffers_sizes(a) > buffers_sizes(b);
+    });
+
+    Tensor<Index, 1> buffers_offsets(buffers_number);
+    buffers_offsets.setConstant(-1);
+
+    Index arena_size = 0;
+
+    for(Index i = 0; i < buffers_number; i++)
+    {
+        const Index buffer_index = sorted_buffers_indices(i);
+
+        // Placed buffers alive at the same time, ordered by offset
+
+        Tensor<Index, 1> overlapping_buffers_indices(i);
+
+        Index overlapping_buffers_number = 0;
+
+        for(Index j = 0; j < i; j++)
+        {
+            const Index placed_buffer_index = sorted_buffers_indices(j);
+
+            if(first_levels(placed_buffer_index) <= last_levels(buffer_index)
+            && first_levels(buffer_index) <= last_levels(placed_buffer_index))
+            {
+                overlapping_buffers_indices(overlapping_buffers_number) = placed_buffer_index;
+                overlapping_buffers_number++;
+            }
+        }
+
+        sort(overlapping_buffers_indices.data(), overlapping_buffers_indices.data() + overlapping_buffers_number,
+             [&](const Index& a, const Index& b)
+        {
+            return buffers_offsets(a) < buffers_offsets(b);
+        });
+
+        Index offset = 0;
+
+        for(Index j = 0; j < overlapping_buffers_number; j++)
+        {
+            const Index placed_buffer_index = overlapping_buffers_indices(j);
+
+            if(offset + buffers_sizes(buffer_index) <= buffers_offsets(placed_buffer_index)) break;
+
+            offset = max(offset, buffers_offsets(placed_buffer_index) + buffers_sizes(placed_buffer_index));
+        }
+
+        buffers_offsets(buffer_index) = offset;
+
+        arena_size = max(arena_size, offset + buffers_sizes(buffer_index));
+    }
+
+    layers_outputs_offsets.resize(layers_number);
+    layers_workspaces_offsets.resize(layers_number);
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        layers_outputs_offsets(i) = buffers_offsets(i);
+        layers_workspaces_offsets(i) = buffers_offsets(layers_number + i);
+    }
+
+    return arena_size;
+}
+
+
+/// Calculates the forward propagation of the layers in a range, following the layers inputs indices.
+/// The layers are calculated level by level.
+/// The layers of the same level are calculated one after the other, as each of them uses all the threads of the device.
+/// Layers whose inputs are out of the range take the inputs of the neural network.
+/// Layers with several inputs take views of the outputs of their inputs layers, which are not copied.
+/// A convolutional layer whose outputs are only taken by a pooling layer is calculated together with it,
+/// as in sequential neural networks.
+/// @param inputs Inputs of the neural network.
+/// @param forward_propagation Structure where the outputs of the layers are saved.
+/// @param first_layer_index Index of the first layer to be calculated.
+/// @param last_layer_index Index of the last layer to be calculated.
+/// @param is_training True if the forward propagation is part of the training.
+
+void NeuralNetwork::forward_propagate_graph(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                            NeuralNetworkForwardPropagation& forward_propagation,
+                                            const Index& first_layer_index,
+                                            const Index& last_layer_index,
+                                            const bool& is_training) const
+{
+    const Tensor<Tensor<Index, 1>, 1>& layers_execution_levels = get_layers_execution_levels();
+
+    const Index levels_number = layers_execution_levels.size();
+
+    const auto is_block_in_range = [&](const Index& layer_index)
+    {
+        if(layer_index < first_layer_index || layer_index > last_layer_index) return false;
+
+        if(!is_convolution_pooling_block(layer_index)) return false;
+
+        const Index pooling_layer_index = layers_outputs_indices(layer_index)(0);
+
+        return pooling_layer_index >= first_layer_index && pooling_layer_index <= last_layer_index;
+    };
+
+    for(Index level = 0; level < levels_number; level++)
+    {
+        const Tensor<Index, 1>& level_layers_indices = layers_execution_levels(level);
+
+        const Index level_layers_number = level_layers_indices.size();
+
+        for(Index i = 0; i < level_layers_number; i++)
+        {
+            const Index layer_index = level_layers_indices(i);
+
+            if(layer_index < first_layer_index || layer_index > last_layer_index) continue;
+
+            const Tensor<Index, 1> layer_inputs_indices = get_layer_inputs_indices(layer_index);
+
+            const Index layer_inputs_number = layer_inputs_indices.size();
+
+            // The pooling layer of a block has already been calculated with its convolutional layer
+
+            if(layer_inputs_number == 1 && is_block_in_range(layer_inputs_indices(0))) continue;
+
+            if(layer_inputs_number <= 1)
+            {
+                const Tensor<DynamicTensor<type>, 1>& layer_inputs
+                        = layer_inputs_number == 0 || layer_inputs_indices(0) < first_layer_index
+                        ? inputs
+                        : forward_propagation.layers(layer_inputs_indices(0))->outputs;
+
+                if(is_block_in_range(layer_index))
+                {
+                    forward_propagate_convolution_pooling_block(layer_inputs, forward_propagation, layer_index, is_training);
+                }
+                else
+                {
+                    layers_pointers(layer_index)->forward_propagate(layer_inputs,
+                                                                    forward_propagation.layers(layer_index),
+                                                                    is_training);
+                }
+            }
+            else
+            {
+                Tensor<DynamicTensor<type>, 1> layer_inputs(layer_inputs_number);
+
+                for(Index j = 0; j < layer_inputs_number; j++)
+                {
+                    const Index input_index = layer_inputs_indices(j);
+
+                    const DynamicTensor<type>& input = input_index < first_layer_index
+                            ? inputs(0)
+                            : forward_propagation.layers(input_index)->outputs(0);
+
+                    layer_inputs(j).set_view(input.get_data(), input.get_dimensions());
+                }
+
+                layers_pointers(layer_index)->forward_propagate(layer_inputs,
+                                                                forward_propagation.layers(layer_index),
+                                                                is_training);
+            }
+        }
+    }
+}
+
+
+/// Calculates the outputs of the neural network for a batch of inputs.
+/// The inference forward propagation is kept for the next calls,
+/// so outputs must be calculated from several threads with inference sessions instead.
+/// @param inputs_data Pointer to the inputs, with a row for each sample.
+/// @param inputs_dimensions Dimensions of the inputs.
+
+Tensor<type, 2> NeuralNetwork::calculate_outputs(type* inputs_data, Tensor<Index, 1>&inputs_dimensions)
+{
+
+    const Index inputs_rank = inputs_dimensions.size();
+
+    if(inputs_rank == 2)
+    {
+        DataSetBatch data_set_batch;
+
+        data_set_batch.inputs.resize(1);
+        data_set_batch.inputs(0).set_view(inputs_data, inputs_dimensions);
+
+        const Index batch_samples_number = inputs_dimensions(0);
+
+        const Index parameters_number = get_parameters_number();
+
+        if(outputs_forward_propagation == nullptr
+        || batch_samples_number > outputs_forward_propagation->maximum_batch_samples_number
+        || parameters_number != outputs_forward_propagation_parameters_number)
+        {
+            delete outputs_forward_propagation;
+
+            outputs_forward_propagation = new NeuralNetworkForwardPropagation(batch_samples_number, this, true);
+
+            outputs_forward_propagation_parameters_number = parameters_number;
+        }
+        else if(batch_samples_number != outputs_forward_propagation->batch_samples_number)
+        {
+            outputs_forward_propagation->set_batch_samples_number(batch_samples_number);
+        }
+
+        forward_propagate_deploy(data_set_batch, *outputs_forward_propagation);
+
+        const Index layers_number = get_layers_number();
+
+        if(layers_number == 0) return Tensor<type, 2>();
+
+        return outputs_forward_propagation->layers(layers_number - 1)->outputs(0).to_tensor_map<2>();
+    }
+    else
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: NeuralNetwork class.\n"
+               << "Tensor<type, 2> calculate_outputs(type* , Tensor<Index, 1>&).\n"
                << "Inputs rank must be 2.\n";
 
         throw invalid_argument(buffer.str());
@@ -2372,119 +3040,380 @@ Tensor<type, 2> NeuralNetwork::calculate_directional_inputs(const Index& directi
 }
 
 
-/// Generates a text output based on the neural network and some input letters given by the user.
-/// @param text_generation_alphabet TextGenerationAlphabet object used for the text generation model
-/// @param input_string Input string given by the user
-/// @param max_length Maximum length of the returned string
-/// @param one_word Boolean, if true returns just one word, if false returns a phrase
+/// Quantizes the weights of the layers which support it to 8 bit integers, which are then used for inference.
+/// The ranges of the inputs of those layers are calibrated with a floating point forward propagation of a sample of inputs.
+/// Layers are then quantized one at a time, and a layer returns to floating point if the outputs of the neural network
+/// on the sample change by more than the maximum error, relative to the maximum absolute output.
+/// The floating point weights of the quantized layers are released.
+/// The rest of the layers always run in floating point.
+/// @param inputs Sample of inputs used for calibration, with dimensions samples number and inputs number.
+/// @param maximum_error Maximum relative error of the outputs allowed by the quantization.
+/// Returns the number of quantized layers.
 
-string NeuralNetwork::calculate_text_outputs(TextGenerationAlphabet& text_generation_alphabet, const string& input_string, const Index& max_length, const bool& one_word)
+Index NeuralNetwork::quantize(Tensor<type, 2>& inputs, const type& maximum_error)
 {
-    string result = one_word ? generate_word(text_generation_alphabet, input_string, max_length) : generate_phrase(text_generation_alphabet, input_string, max_length);
+    dequantize();
 
-    return result;
+    const Index layers_number = get_layers_number();
+
+    if(layers_number == 0 || inputs.size() == 0) return 0;
+
+    Tensor<Index, 1> inputs_dimensions = get_dimensions(inputs);
+
+    // Calibration of the inputs ranges
+
+    DataSetBatch batch;
+
+    batch.inputs.resize(1);
+    batch.inputs(0).set_view(inputs.data(), inputs_dimensions);
+
+    NeuralNetworkForwardPropagation forward_propagation(inputs.dimension(0), this);
+
+    forward_propagate_deploy(batch, forward_propagation);
+
+    Tensor<type, 1> layers_inputs_ranges(layers_number);
+    layers_inputs_ranges.setZero();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        if(!layers_pointers(i)->is_quantizable()) continue;
+
+        const Tensor<Index, 1> layer_inputs_indices = get_layer_inputs_indices(i);
+
+        const DynamicTensor<type>& layer_inputs = layer_inputs_indices.size() == 0
+                ? batch.inputs(0)
+                : forward_propagation.layers(layer_inputs_indices(0))->outputs(0);
+
+        const TensorMap<Tensor<type, 1>> layer_inputs_map(layer_inputs.get_data(), layer_inputs.get_size());
+
+        const Tensor<type, 0> layer_inputs_range = layer_inputs_map.abs().maximum();
+
+        layers_inputs_ranges(i) = layer_inputs_range(0);
+    }
+
+    const Tensor<type, 2> outputs = calculate_outputs(inputs.data(), inputs_dimensions);
+
+    const Tensor<type, 0> outputs_range = outputs.abs().maximum();
+
+    const type tolerance = maximum_error*outputs_range(0);
+
+    // Quantization of each layer, with fallback to floating point
+
+    Index quantized_layers_number = 0;
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        if(!layers_pointers(i)->is_quantizable()) continue;
+
+        // The floating point parameters are kept to return the layer to them, without the quantization error
+
+        const Tensor<type, 1> layer_parameters = layers_pointers(i)->get_parameters();
+
+        layers_pointers(i)->quantize(layers_inputs_ranges(i));
+
+        const Tensor<type, 2> quantized_outputs = calculate_outputs(inputs.data(), inputs_dimensions);
+
+        const Tensor<type, 0> error = (quantized_outputs - outputs).abs().maximum();
+
+        if(error(0) > tolerance)
+        {
+            layers_pointers(i)->set_parameters(layer_parameters, 0);
+        }
+        else
+        {
+            quantized_layers_number++;
+        }
+    }
+
+    return quantized_layers_number;
 }
 
 
-/// @todo TEXT GENERATION
+/// Quantizes the weights of the layers which support it to 8 bit integers,
+/// calibrating them on the first training samples of a data set.
+/// @param data_set Data set whose training samples are used for calibration.
+/// @param maximum_error Maximum relative error of the outputs allowed by the quantization.
+/// @param calibration_samples_number Maximum number of training samples used for calibration.
+/// Returns the number of quantized layers.
 
-string NeuralNetwork::generate_word(TextGenerationAlphabet& text_generation_alphabet, const string& first_letters, const Index& length)
+Index NeuralNetwork::quantize(const DataSet& data_set, const type& maximum_error, const Index& calibration_samples_number)
 {
-    ostringstream buffer;
+    const Tensor<Index, 1> training_samples_indices = data_set.get_training_samples_indices();
 
-    buffer << "OpenNN Exception: NeuralNetwork class.\n"
-           << "string generate_word(TextGenerationAlphabet&, const string&, const Index&) method.\n"
-           << "This method is not implemented yet.\n";
+    const Index samples_number = min(training_samples_indices.size(), calibration_samples_number);
+
+    const Tensor<Index, 1> calibration_samples_indices = training_samples_indices.slice(Eigen::array<Index, 1>({0}),
+                                                                                        Eigen::array<Index, 1>({samples_number}));
+
+    Tensor<type, 2> inputs = data_set.get_input_data(calibration_samples_indices);
+
+    return quantize(inputs, maximum_error);
+}
+
+
+/// Returns all the layers to floating point, with the weights dequantized from the quantized ones.
+
+void NeuralNetwork::dequantize()
+{
+    const Index layers_number = get_layers_number();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        layers_pointers(i)->dequantize();
+    }
+}
+
+
+/// Returns the number of layers which run inference with 8 bit integer weights.
+
+Index NeuralNetwork::get_quantized_layers_number() const
+{
+    const Index layers_number = get_layers_number();
+
+    Index quantized_layers_number = 0;
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        if(layers_pointers(i)->is_quantized()) quantized_layers_number++;
+    }
+
+    return quantized_layers_number;
+}
+
+
+/// Stores the weights of the layers which support it in a given precision for inference.
+/// Bfloat16 and half precision halve the memory read by the products of a few samples,
+/// while the parameters are still trained in single precision.
+/// @param new_weights_precision Precision of the stored weights.
+
+void NeuralNetwork::set_weights_precision(const Precision& new_weights_precision)
+{
+    const Index layers_number = get_layers_number();
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        layers_pointers(i)->set_weights_precision(new_weights_precision);
+    }
+}
 
-    throw invalid_argument(buffer.str());
 
-    return string();
+/// Calculates the outputs of the next positions of some sequences, continuing those of the previous calls.
+/// The forward propagation must be incremental, and it keeps the states of the recurrent layers and the keys and values
+/// of the attention layers between calls, so each new position costs one step instead of the whole sequence.
+/// @param inputs Inputs of the next position of each sequence, with a row for each sequence.
+/// @param forward_propagation Incremental forward propagation of the neural network, created for that number of sequences.
 
-    // Under development
+Tensor<type, 2> NeuralNetwork::calculate_next_outputs(Tensor<type, 2>& inputs,
+                                                      NeuralNetworkForwardPropagation& forward_propagation) const
+{
+    const Index layers_number = get_layers_number();
+
+    if(layers_number == 0) return inputs;
+
+    DataSetBatch data_set_batch;
+
+    data_set_batch.inputs.resize(1);
+    data_set_batch.inputs(0).set_view(inputs.data(), get_dimensions(inputs));
+
+    forward_propagate_deploy(data_set_batch, forward_propagation);
+
+    return forward_propagation.layers(layers_number - 1)->outputs(0).to_tensor_map<2>();
+}
 
-    //    const Index alphabet_length = text_generation_alphabet.get_alphabet_length();
 
-    //    if(first_letters.length()*alphabet_length != get_inputs_number())
-    //    {
-    //        ostringstream buffer;
+/// Returns the index of an output sampled among the top_k greatest ones, with probabilities proportional to their values.
+/// With top_k equal to one, it is the index of the greatest output, as in greedy decoding.
+/// @param outputs Outputs of the neural network for one sample, such as the probabilities of the next letter.
+/// @param top_k Number of greatest outputs from which the index is sampled.
 
-    //        buffer << "OpenNN Exception: NeuralNetwork class.\n"
-    //               << "string generate_word(TextGenerationAlphabet&, const string&, const Index&) method.\n"
-    //               << "Input string length must be equal to " << int(get_inputs_number()/alphabet_length) << "\n";
+Index NeuralNetwork::sample_output(const Tensor<type, 1>& outputs, const Index& top_k) const
+{
+    const Index outputs_number = outputs.size();
+
+    const Index candidates_number = min(max(top_k, Index(1)), outputs_number);
+
+    Tensor<Index, 1> indices(outputs_number);
 
-    //        throw invalid_argument(buffer.str());
-    //    }
+    for(Index i = 0; i < outputs_number; i++) indices(i) = i;
 
+    partial_sort(indices.data(), indices.data() + candidates_number, indices.data() + outputs_number,
+                 [&outputs](const Index& a, const Index& b){return outputs(a) > outputs(b);});
 
-    //    string result = first_letters;
+    if(candidates_number == 1) return indices(0);
 
-    //    // 1. Input letters to one hot encode
+    type sum = type(0);
 
-    //    Tensor<type, 2> input_data = text_generation_alphabet.multiple_one_hot_encode(first_letters);
+    for(Index i = 0; i < candidates_number; i++) sum += max(outputs(indices(i)), type(0));
 
-    //    Tensor<Index, 1> input_dimensions = get_dimensions(input_data);
+    if(sum <= type(0)) return indices(0);
 
-    //    Tensor<string, 1> punctuation_signs(6); // @todo change for multiple letters predicted
+    const type random = static_cast<type>(rand()/(RAND_MAX+1.0))*sum;
 
-    //    punctuation_signs.setValues({" ",",",".","\n",":",";"});
+    type cumulative_sum = type(0);
+
+    for(Index i = 0; i < candidates_number; i++)
+    {
+        cumulative_sum += max(outputs(indices(i)), type(0));
+
+        if(random < cumulative_sum) return indices(i);
+    }
+
+    return indices(candidates_number - 1);
+}
 
-    //    // 2. Loop for forecasting the following letter in function of the last letters
 
-    //    do{
-    //        Tensor<type, 2> output = calculate_outputs(input_data.data(), input_dimensions);
+/// Generates a text output based on the neural network and some input letters given by the user.
+/// @param text_generation_alphabet TextGenerationAlphabet object used for the text generation model
+/// @param input_string Input string given by the user
+/// @param max_length Maximum length of the returned string
+/// @param one_word Boolean, if true returns just one word, if false returns a phrase
+/// @param top_k Number of most probable letters from which each letter is sampled, or one to take the most probable.
 
-    //        string letter = text_generation_alphabet.multiple_one_hot_decode(output);
+string NeuralNetwork::calculate_text_outputs(TextGenerationAlphabet& text_generation_alphabet,
+                                             const string& input_string,
+                                             const Index& max_length,
+                                             const bool& one_word,
+                                             const Index& top_k)
+{
+    return generate_text(text_generation_alphabet, input_string, max_length, one_word, top_k);
+}
 
-    //        if(!contains(punctuation_signs, letter))
-    //        {
-    //            result += letter;
 
-    //            input_data = text_generation_alphabet.multiple_one_hot_encode(result.substr(result.length() - first_letters.length()));
-    //        }
+string NeuralNetwork::generate_word(TextGenerationAlphabet& text_generation_alphabet,
+                                    const string& first_letters,
+                                    const Index& length,
+                                    const Index& top_k)
+{
+    return generate_text(text_generation_alphabet, first_letters, length, true, top_k);
+}
 
-    //    }while(result.length() < length);
 
-    //    return result;
+string NeuralNetwork::generate_phrase(TextGenerationAlphabet& text_generation_alphabet,
+                                      const string& first_letters,
+                                      const Index& length,
+                                      const Index& top_k)
+{
+    return generate_text(text_generation_alphabet, first_letters, length, false, top_k);
 }
 
 
-/// @todo TEXT GENERATION
+/// Generates a text by predicting one letter after another from some first letters.
+/// If the inputs of the neural network are a single letter, the letters are propagated incrementally,
+/// so that each new letter costs one step of the recurrent and attention layers.
+/// If the inputs are as many letters as the first letters, each new letter is predicted from the last ones.
+/// @param text_generation_alphabet Alphabet of the text generation model.
+/// @param first_letters First letters of the text.
+/// @param length Maximum length of the text.
+/// @param one_word True to finish the text at the first space or punctuation sign.
+/// @param top_k Number of most probable letters from which each letter is sampled, or one to take the most probable.
 
-string NeuralNetwork::generate_phrase(TextGenerationAlphabet& text_generation_alphabet, const string& first_letters, const Index& length)
+string NeuralNetwork::generate_text(TextGenerationAlphabet& text_generation_alphabet,
+                                    const string& first_letters,
+                                    const Index& length,
+                                    const bool& one_word,
+                                    const Index& top_k)
 {
     const Index alphabet_length = text_generation_alphabet.get_alphabet_length();
 
-    if(first_letters.length()*alphabet_length != get_inputs_number())
+    const Index inputs_number = get_inputs_number();
+
+    const Index first_letters_number = first_letters.length();
+
+    const bool is_incremental = inputs_number == alphabet_length;
+
+    if(!is_incremental && inputs_number != first_letters_number*alphabet_length)
     {
         ostringstream buffer;
 
         buffer << "OpenNN Exception: NeuralNetwork class.\n"
-               << "string generate_word(TextGenerationAlphabet&, const string&, const Index&) method.\n"
-               << "Input string length must be equal to " << int(get_inputs_number()/alphabet_length) << "\n";
+               << "string generate_text(TextGenerationAlphabet&, const string&, const Index&, const bool&, const Index&) method.\n"
+               << "Input string length must be equal to " << inputs_number/alphabet_length << " or the neural network inputs must be a single letter.\n";
 
         throw invalid_argument(buffer.str());
     }
 
+    for(Index i = 0; i < first_letters_number; i++)
+    {
+        if(text_generation_alphabet.get_alphabet_index(first_letters[i]) == -1)
+        {
+            ostringstream buffer;
+
+            buffer << "OpenNN Exception: NeuralNetwork class.\n"
+                   << "string generate_text(TextGenerationAlphabet&, const string&, const Index&, const bool&, const Index&) method.\n"
+                   << "Letter " << first_letters[i] << " is not in the alphabet.\n";
+
+            throw invalid_argument(buffer.str());
+        }
+    }
+
+    const Tensor<string, 1> alphabet = text_generation_alphabet.get_alphabet();
+
+    Tensor<string, 1> punctuation_signs(6);
+    punctuation_signs.setValues({" ", ",", ".", "\n", ":", ";"});
+
     string result = first_letters;
 
-    Tensor<type, 2> input_data = text_generation_alphabet.multiple_one_hot_encode(first_letters);
+    Tensor<type, 2> inputs;
+    Tensor<type, 2> outputs;
+
+    NeuralNetworkForwardPropagation forward_propagation(1, this, true);
+
+    if(is_incremental)
+    {
+        forward_propagation.set_incremental(true);
 
-    Tensor<Index, 1> input_dimensions = get_dimensions(input_data);
+        inputs.resize(1, alphabet_length);
 
-    do{
-        Tensor<type, 2> input_data(get_inputs_number(), 1);
-        input_data.setZero();
-        Tensor<Index, 1> input_dimensions = get_dimensions(input_data);
+        for(Index i = 0; i < first_letters_number; i++)
+        {
+            inputs.setZero();
+            inputs(0, text_generation_alphabet.get_alphabet_index(first_letters[i])) = type(1);
 
-        Tensor<type, 2> output = calculate_outputs(input_data.data(), input_dimensions);
+            outputs = calculate_next_outputs(inputs, forward_propagation);
+        }
+    }
+    else
+    {
+        inputs = text_generation_alphabet.str_to_input(first_letters);
 
-        string letter = text_generation_alphabet.multiple_one_hot_decode(output);
+        outputs = calculate_next_outputs(inputs, forward_propagation);
+    }
+
+    if(outputs.size() != alphabet_length)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: NeuralNetwork class.\n"
+               << "string generate_text(TextGenerationAlphabet&, const string&, const Index&, const bool&, const Index&) method.\n"
+               << "Outputs number (" << outputs.size() << ") must be equal to alphabet length (" << alphabet_length << ").\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    while(Index(result.length()) < length)
+    {
+        const Tensor<type, 1> letter_outputs = outputs.chip(0, 0);
+
+        const Index letter_index = sample_output(letter_outputs, top_k);
+
+        const string letter = alphabet(letter_index);
+
+        if(one_word && contains(punctuation_signs, letter)) break;
 
         result += letter;
 
-        input_data = text_generation_alphabet.multiple_one_hot_encode(result.substr(result.length() - first_letters.length()));
+        if(is_incremental)
+        {
+            inputs.setZero();
+            inputs(0, letter_index) = type(1);
+        }
+        else
+        {
+            inputs = text_generation_alphabet.str_to_input(result.substr(result.length() - first_letters_number));
+        }
 
-    }while(result.length() < length);
+        outputs = calculate_next_outputs(inputs, forward_propagation);
+    }
 
     return result;
 }
@@ -25,6 +25,7 @@
 #include "data_set.h"
 #include "layer.h"
 #include "addition_layer.h"
+#include "concatenation_layer.h"
 #include "perceptron_layer.h"
 #include "scaling_layer.h"
 #include "unscaling_layer.h"
@@ -38,6 +39,8 @@
 #include "pooling_layer.h"
 #include "long_short_term_memory_layer.h"
 #include "recurrent_layer.h"
+#include "multihead_attention_layer.h"
+#include "embedding_layer.h"
 #include "text_analytics.h"
 
 namespace opennn
@@ -102,6 +105,7 @@ public:
    bool has_convolutional_layer() const;
    bool has_flatten_layer() const;
    bool is_empty() const;
+   bool is_sequential() const;
 
    const Tensor<string, 1>& get_inputs_names() const;
    string get_input_name(const Index&) const;
@@ -122,6 +126,15 @@ public:
    Index get_layer_index(const string&) const;
 
    Tensor<Tensor<Index, 1>, 1> get_layers_inputs_indices() const;
+   Tensor<Index, 1> get_layer_inputs_indices(const Index&) const;
+   const Tensor<Tensor<Index, 1>, 1>& get_layers_outputs_indices() const;
+
+   const Tensor<Tensor<Index, 1>, 1>& get_layers_execution_levels() const;
+
+   Index calculate_inference_memory_plan(const Tensor<Index, 1>&,
+                                         const Tensor<Index, 1>&,
+                                         Tensor<Index, 1>&,
+                                         Tensor<Index, 1>&) const;
 
    ScalingLayer* get_scaling_layer_pointer() const;
    UnscalingLayer* get_unscaling_layer_pointer() const;
@@ -180,6 +193,8 @@ public:
 
    void set_threads_number(const int&);
 
+   void set_fast_activations(const bool&);
+
    void set_scaling_layer(ScalingLayer&);
 
    void set_display(const bool&);
@@ -243,6 +258,10 @@ public:
 
    void set_parameters(Tensor<type, 1>&) const;
 
+   void set_parameters_segments(const Tensor<type, 1>&, const vector<pair<Index, Index>>&) const;
+
+   bool has_sparse_gradient() const;
+
    // Parameters initialization methods
 
    void set_parameters_constant(const type&) const;
@@ -269,13 +288,34 @@ public:
 
    Tensor<type, 2> calculate_directional_inputs(const Index&, const Tensor<type, 1>&, const type&, const type&, const Index& = 101) const;
 
+   // Quantization
+
+   Index quantize(Tensor<type, 2>&, const type& = type(0.01));
+   Index quantize(const DataSet&, const type& = type(0.01), const Index& = 1000);
+
+   void dequantize();
+
+   Index get_quantized_layers_number() const;
+
+   // Reduced precision
+
+   void set_weights_precision(const Precision&);
+
+   // Incremental decoding
+
+   Tensor<type, 2> calculate_next_outputs(Tensor<type, 2>&, NeuralNetworkForwardPropagation&) const;
+
+   Index sample_output(const Tensor<type, 1>&, const Index& = 1) const;
+
    // Text generation
 
-   string calculate_text_outputs(TextGenerationAlphabet&, const string&, const Index&, const bool&);
+   string calculate_text_outputs(TextGenerationAlphabet&, const string&, const Index&, const bool&, const Index& = 1);
+
+   string generate_word(TextGenerationAlphabet&, const string&, const Index&, const Index& = 1);
 
-   string generate_word(TextGenerationAlphabet&, const string&, const Index&);
+   string generate_phrase(TextGenerationAlphabet&, const string&, const Index&, const Index& = 1);
 
-   string generate_phrase(TextGenerationAlphabet&, const string&, const Index&);
+   string generate_text(TextGenerationAlphabet&, const string&, const Index&, const bool&, const Index&);
 
    // Serialization methods
 
@@ -332,6 +372,19 @@ public:
 
    void forward_propagate(const DataSetBatch&, Tensor<type, 1>&, NeuralNetworkForwardPropagation&) const;
 
+   void forward_propagate_graph(const Tensor<DynamicTensor<type>, 1>&,
+                                NeuralNetworkForwardPropagation&,
+                                const Index&,
+                                const Index&,
+                                const bool&) const;
+
+   bool is_convolution_pooling_block(const Index&) const;
+
+   void forward_propagate_convolution_pooling_block(const Tensor<DynamicTensor<type>, 1>&,
+                                                    NeuralNetworkForwardPropagation&,
+                                                    const Index&,
+                                                    const bool&) const;
+
 
 
 protected:
@@ -354,6 +407,28 @@ protected:
 
    Tensor<Tensor<Index, 1>, 1> layers_inputs_indices;
 
+   /// Indices of the layers which take the outputs of each layer, calculated when the layers connections change.
+
+   Tensor<Tensor<Index, 1>, 1> layers_outputs_indices;
+
+   /// Layers grouped in execution levels, calculated when the layers connections change.
+   /// It is empty if the layers inputs indices are not valid.
+
+   Tensor<Tensor<Index, 1>, 1> layers_execution_levels;
+
+   /// Inference forward propagation kept between calculations of the outputs, so that its memory plan is only set once.
+   /// It is set again when the layers or the number of parameters change, or when more samples are calculated.
+
+   NeuralNetworkForwardPropagation* outputs_forward_propagation = nullptr;
+
+   Index outputs_forward_propagation_parameters_number = 0;
+
+   void update_layers_graph();
+
+   Tensor<Tensor<Index, 1>, 1> calculate_layers_outputs_indices() const;
+
+   Tensor<Tensor<Index, 1>, 1> calculate_layers_execution_levels() const;
+
    /// AANN distances box plot
 
    BoxPlot auto_associative_distances_box_plot = BoxPlot();
@@ -383,6 +458,16 @@ struct NeuralNetworkForwardPropagation
         set(new_batch_samples_number, new_neural_network_pointer);
     }
 
+    /// Inference constructor.
+    /// If the forward propagation is only used for inference, the memory plan is set before the layers outputs are allocated.
+
+    NeuralNetworkForwardPropagation(const Index& new_batch_samples_number,
+                                    NeuralNetwork* new_neural_network_pointer,
+                                    const bool& new_is_inference)
+    {
+        set(new_batch_samples_number, new_neural_network_pointer, new_is_inference);
+    }
+
     /// Destructor.
 
     virtual ~NeuralNetworkForwardPropagation()
@@ -393,20 +478,44 @@ struct NeuralNetworkForwardPropagation
         {
             delete layers(i);
         }
+
+        free(outputs_arena_data);
     }
 
 
-    void set(const Index& new_batch_samples_number, NeuralNetwork* new_neural_network_pointer)
+    /// Sets the forward propagations of the layers.
+    /// @param new_batch_samples_number Number of samples.
+    /// @param new_neural_network_pointer Neural network.
+    /// @param new_is_inference True if the forward propagation is only used for inference.
+    /// Then the layers do not allocate their outputs and workspaces, which the inference memory plan places,
+    /// nor the buffers which only the back propagation needs.
+
+    void set(const Index& new_batch_samples_number, NeuralNetwork* new_neural_network_pointer, const bool& new_is_inference = false)
     {
         batch_samples_number = new_batch_samples_number;
 
+        is_inference = new_is_inference;
+
+        maximum_batch_samples_number = new_batch_samples_number;
+
         neural_network_pointer = new_neural_network_pointer;
 
         const Tensor<Layer*, 1> layers_pointers = neural_network_pointer->get_layers_pointers();
 
         const Index layers_number = layers_pointers.size();
 
+        for(Index i = 0; i < layers.size(); i++)
+        {
+            delete layers(i);
+        }
+
+        free(outputs_arena_data);
+
+        outputs_arena_data = nullptr;
+        outputs_arena_size = 0;
+
         layers.resize(layers_number);
+        layers.setConstant(nullptr);
 
         for(Index i = 0; i < layers_number; i++)
         {
@@ -414,83 +523,294 @@ struct NeuralNetworkForwardPropagation
             {
             case Layer::Type::Perceptron:
             {
-                layers(i) = new PerceptronLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new PerceptronLayerForwardPropagation();
 
             }
             break;
             case Layer::Type::Probabilistic:
             {
-                layers(i) = new ProbabilisticLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new ProbabilisticLayerForwardPropagation();
 
             }
             break;
 
             case Layer::Type::Recurrent:
             {
-                layers(i) = new RecurrentLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new RecurrentLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::LongShortTermMemory:
             {
-                layers(i) = new LongShortTermMemoryLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new LongShortTermMemoryLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::Convolutional:
             {
-            //    layers(i) = new ConvolutionalLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new ConvolutionalLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::Pooling:
             {
-                layers(i) = new PoolingLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new PoolingLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::Flatten:
             {
-                layers(i) = new FlattenLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new FlattenLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::Scaling:
             {
-                layers(i) = new ScalingLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new ScalingLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::Unscaling:
             {
-                layers(i) = new UnscalingLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new UnscalingLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::Bounding:
             {
-                layers(i) = new BoundingLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new BoundingLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::RegionProposal:
             {
-//                layers(i) = new RegionProposalLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+//                layers(i) = new RegionProposalLayerForwardPropagation();
             }
             break;
 
             case Layer::Type::NonMaxSuppression:
             {
-                layers(i) = new NonMaxSuppressionLayerForwardPropagation(batch_samples_number, layers_pointers(i));
+                layers(i) = new NonMaxSuppressionLayerForwardPropagation();
+            }
+            break;
+
+            case Layer::Type::Addition:
+            {
+                layers(i) = new AdditionLayerForwardPropagation();
+            }
+            break;
+
+            case Layer::Type::Concatenation:
+            {
+                layers(i) = new ConcatenationLayerForwardPropagation();
+            }
+            break;
+
+            case Layer::Type::MultiheadAttention:
+            {
+                layers(i) = new MultiheadAttentionLayerForwardPropagation();
+            }
+            break;
+
+            case Layer::Type::Embedding:
+            {
+                layers(i) = new EmbeddingLayerForwardPropagation();
             }
             break;
 
             default: break;
             }
+
+            if(layers(i) == nullptr) continue;
+
+            layers(i)->is_inference = is_inference;
+
+            layers(i)->set(batch_samples_number, layers_pointers(i));
+        }
+
+        if(is_inference) set_inference_memory_plan();
+    }
+
+
+    /// Places the outputs and the workspaces of all the layers in a single buffer,
+    /// where buffers which are not alive at the same time share memory.
+    /// The outputs of a layer are only kept until the last layer which takes them as inputs has been calculated,
+    /// and its workspaces only while it is calculated,
+    /// so this must be used only for inference, as the back-propagation needs the outputs of all the layers.
+
+    void set_inference_memory_plan()
+    {
+        const Index layers_number = layers.size();
+
+        // Buffers of a layer are placed consecutively, each one aligned for vectorization
+
+        const Index alignment = EIGEN_MAX_ALIGN_BYTES/sizeof(type) > 0 ? EIGEN_MAX_ALIGN_BYTES/sizeof(type) : 1;
+
+        Tensor<Tensor<DynamicTensor<type>*, 1>, 1> layers_workspaces(layers_number);
+
+        Tensor<Index, 1> layers_outputs_sizes(layers_number);
+        layers_outputs_sizes.setZero();
+
+        Tensor<Index, 1> layers_workspaces_sizes(layers_number);
+        layers_workspaces_sizes.setZero();
+
+        for(Index i = 0; i < layers_number; i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            layers_workspaces(i) = layers(i)->get_workspaces();
+
+            for(Index j = 0; j < layers(i)->outputs.size(); j++)
+            {
+                layers_outputs_sizes(i) += (layers(i)->outputs(j).get_size() + alignment - 1)/alignment*alignment;
+            }
+
+            for(Index j = 0; j < layers_workspaces(i).size(); j++)
+            {
+                layers_workspaces_sizes(i) += (layers_workspaces(i)(j)->get_size() + alignment - 1)/alignment*alignment;
+            }
+        }
+
+        Tensor<Index, 1> layers_outputs_offsets;
+        Tensor<Index, 1> layers_workspaces_offsets;
+
+        const Index new_arena_size = neural_network_pointer->calculate_inference_memory_plan(layers_outputs_sizes,
+                                                                                             layers_workspaces_sizes,
+                                                                                             layers_outputs_offsets,
+                                                                                             layers_workspaces_offsets);
+
+        // The previous buffers are released before the new one is allocated
+
+        for(Index i = 0; i < layers_number; i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            for(Index j = 0; j < layers(i)->outputs.size() + layers_workspaces(i).size(); j++)
+            {
+                DynamicTensor<type>& buffer = j < layers(i)->outputs.size()
+                        ? layers(i)->outputs(j)
+                        : *layers_workspaces(i)(j - layers(i)->outputs.size());
+
+                const Tensor<Index, 1> buffer_dimensions = buffer.get_dimensions();
+
+                buffer.set_view(nullptr, buffer_dimensions);
+            }
+        }
+
+        free(outputs_arena_data);
+
+        outputs_arena_data = (type*) malloc(static_cast<size_t>(new_arena_size*sizeof(type)));
+        outputs_arena_size = new_arena_size;
+
+        for(Index i = 0; i < layers_number; i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            type* outputs_data = outputs_arena_data + layers_outputs_offsets(i);
+            type* workspaces_data = outputs_arena_data + layers_workspaces_offsets(i);
+
+            for(Index j = 0; j < layers(i)->outputs.size() + layers_workspaces(i).size(); j++)
+            {
+                const bool is_outputs = j < layers(i)->outputs.size();
+
+                DynamicTensor<type>& buffer = is_outputs
+                        ? layers(i)->outputs(j)
+                        : *layers_workspaces(i)(j - layers(i)->outputs.size());
+
+                type*& buffer_data = is_outputs ? outputs_data : workspaces_data;
+
+                const Tensor<Index, 1> buffer_dimensions = buffer.get_dimensions();
+
+                buffer.set_view(buffer_data, buffer_dimensions);
+
+                buffer_data += (buffer.get_size() + alignment - 1)/alignment*alignment;
+            }
+        }
+    }
+
+
+    /// Changes the number of samples of the next inference forward propagations, which must not be greater than the one of set.
+    /// The layers outputs are reshaped in the memory where they are, so that the inference memory plan is kept.
+    /// @param new_batch_samples_number Number of samples.
+
+    void set_batch_samples_number(const Index& new_batch_samples_number)
+    {
+        if(new_batch_samples_number < 1 || new_batch_samples_number > maximum_batch_samples_number)
+        {
+            ostringstream buffer;
+
+            buffer << "OpenNN Exception: NeuralNetworkForwardPropagation structure.\n"
+                   << "void set_batch_samples_number(const Index&) method.\n"
+                   << "Batch samples number (" << new_batch_samples_number << ") must be between 1 and " << maximum_batch_samples_number << ".\n";
+
+            throw invalid_argument(buffer.str());
+        }
+
+        batch_samples_number = new_batch_samples_number;
+
+        for(Index i = 0; i < layers.size(); i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            layers(i)->set_batch_samples_number(new_batch_samples_number);
+        }
+    }
+
+
+    /// Makes each forward propagation continue the sequences of the previous one, as in autoregressive decoding,
+    /// so that recurrent layers keep their states and attention layers keep the keys and values of the previous positions.
+    /// The states of the previous sequences are forgotten.
+    /// @param new_is_incremental True for incremental forward propagations, false for independent ones.
+
+    void set_incremental(const bool& new_is_incremental)
+    {
+        for(Index i = 0; i < layers.size(); i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            layers(i)->is_incremental = new_is_incremental;
+        }
+
+        reset_states();
+    }
+
+
+    /// Forgets the states of the layers, so that the next incremental forward propagation starts new sequences.
+
+    void reset_states()
+    {
+        for(Index i = 0; i < layers.size(); i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            layers(i)->reset_states();
         }
     }
 
 
+    /// Returns the number of elements of the layers outputs and workspaces which are held at the same time.
+
+    Index get_outputs_size() const
+    {
+        if(outputs_arena_data != nullptr) return outputs_arena_size;
+
+        Index outputs_size = 0;
+
+        for(Index i = 0; i < layers.size(); i++)
+        {
+            if(layers(i) == nullptr) continue;
+
+            for(Index j = 0; j < layers(i)->outputs.size(); j++) outputs_size += layers(i)->outputs(j).get_size();
+
+            const Tensor<DynamicTensor<type>*, 1> workspaces = layers(i)->get_workspaces();
+
+            for(Index j = 0; j < workspaces.size(); j++) outputs_size += workspaces(j)->get_size();
+        }
+
+        return outputs_size;
+    }
+
+
     void print() const
     {
         cout << "Neural network forward propagation" << endl;
@@ -509,9 +829,23 @@ struct NeuralNetworkForwardPropagation
 
     Index batch_samples_number = 0;
 
+    /// Number of samples for which the layers are allocated.
+
+    Index maximum_batch_samples_number = 0;
+
     NeuralNetwork* neural_network_pointer = nullptr;
 
     Tensor<LayerForwardPropagation*, 1> layers;
+
+    /// True if the forward propagation is only used for inference.
+
+    bool is_inference = false;
+
+    /// Buffer shared by the layers outputs and workspaces when an inference memory plan is set.
+
+    type* outputs_arena_data = nullptr;
+
+    Index outputs_arena_size = 0;
 };
 
 
@@ -592,6 +926,30 @@ struct NeuralNetworkBackPropagation
             }
             break;
 
+            case Layer::Type::Addition:
+            {
+                layers(i) = new AdditionLayerBackPropagation(batch_samples_number, trainable_layers_pointers(i));
+            }
+            break;
+
+            case Layer::Type::Concatenation:
+            {
+                layers(i) = new ConcatenationLayerBackPropagation(batch_samples_number, trainable_layers_pointers(i));
+            }
+            break;
+
+            case Layer::Type::MultiheadAttention:
+            {
+                layers(i) = new MultiheadAttentionLayerBackPropagation(batch_samples_number, trainable_layers_pointers(i));
+            }
+            break;
+
+            case Layer::Type::Embedding:
+            {
+                layers(i) = new EmbeddingLayerBackPropagation(batch_samples_number, trainable_layers_pointers(i));
+            }
+            break;
+
             default: break;
             }
         }
@@ -428,6 +428,9 @@ void NormalizedSquaredError::calculate_error_gradient_lm(const DataSetBatch& bat
             = loss_index_back_propagation_lm.squared_errors_jacobian.contract(loss_index_back_propagation_lm.squared_errors, AT_B);
 
     loss_index_back_propagation_lm.gradient.device(*thread_pool_device) = coefficient * loss_index_back_propagation_lm.gradient;
+
+    if(loss_index_back_propagation_lm.double_precision)
+        calculate_error_gradient_lm_double(coefficient, loss_index_back_propagation_lm);
 }
 
 
@@ -445,6 +448,13 @@ void NormalizedSquaredError::calculate_error_hessian_lm(const DataSetBatch& batc
 
     const type coefficient = type(2)/((static_cast<type>(batch_samples_number)/static_cast<type>(total_samples_number))*normalization_coefficient);
 
+    if(loss_index_back_propagation_lm.double_precision)
+    {
+        calculate_error_hessian_lm_double(coefficient, loss_index_back_propagation_lm);
+
+        return;
+    }
+
     loss_index_back_propagation_lm.hessian.device(*thread_pool_device) =
             loss_index_back_propagation_lm.squared_errors_jacobian.contract(loss_index_back_propagation_lm.squared_errors_jacobian, AT_B);
 
@@ -19,8 +19,12 @@
 // Neural network
 
 #include "config.h"
+#include "approximate_activations.h"
+#include "activation_functions.h"
+#include "philox.h"
 #include "layer.h"
 #include "addition_layer.h"
+#include "concatenation_layer.h"
 #include "pooling_layer.h"
 #include "convolutional_layer.h"
 #include "bounding_layer.h"
@@ -30,13 +34,15 @@
 #include "probabilistic_layer.h"
 #include "scaling_layer.h"
 // #include "region_proposal_layer.h"
-//#include "embedding_layer.h"
-//#include "multihead_attention_layer.h"
+#include "embedding_layer.h"
+#include "multihead_attention_layer.h"
 #include "kmeans.h"
 #include "non_max_suppression_layer.h"
 #include "unscaling_layer.h"
 #include "flatten_layer.h"
 #include "neural_network.h"
+#include "inference_session.h"
+#include "inference_batcher.h"
 #include "vgg16.h"
 
 // Training strategy
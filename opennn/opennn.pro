@@ -53,6 +53,11 @@ INCLUDEPATH += ../eigen
 
 HEADERS += \
     addition_layer.h \
+    approximate_activations.h \
+    activation_functions.h \
+    philox.h \
+    quantization.h \
+    mixed_precision.h \
     concatenation_layer.h \
     codification.h \
     dynamic_tensor.h \
@@ -81,6 +86,8 @@ HEADERS += \
     long_short_term_memory_layer.h \
     recurrent_layer.h \
     neural_network.h \
+    inference_session.h \
+    inference_batcher.h \
     loss_index.h \
     mean_squared_error.h \
     optimization_algorithm.h \
@@ -150,6 +157,8 @@ SOURCES += \
     long_short_term_memory_layer.cpp \
     recurrent_layer.cpp \
     neural_network.cpp \
+    inference_session.cpp \
+    inference_batcher.cpp \
     loss_index.cpp \
     mean_squared_error.cpp \
     stochastic_gradient_descent.cpp \
@@ -136,6 +136,22 @@ const string& OptimizationAlgorithm::get_neural_network_file_name() const
 }
 
 
+/// Returns the precision which is emulated for the parameters and the gradient in training.
+
+const Precision& OptimizationAlgorithm::get_emulated_precision() const
+{
+    return emulated_precision;
+}
+
+
+/// Returns the initial loss scale of the gradient in half precision.
+
+const type& OptimizationAlgorithm::get_loss_scale() const
+{
+    return loss_scale;
+}
+
+
 /// Sets the loss index pointer to nullptr.
 /// It also sets the rest of the members to their default values.
 
@@ -236,6 +252,116 @@ void OptimizationAlgorithm::set_neural_network_file_name(const string& new_neura
     neural_network_file_name = new_neural_network_file_name;
 }
 
+
+/// Sets the precision which is emulated for the parameters and the gradient in training.
+/// In bfloat16 or half precision, the neural network parameters are rounded to the values of that precision at each step,
+/// and the gradient is rounded too, while the updates are accumulated in single precision master parameters.
+/// The values are still stored and computed in single precision, so this emulates the accuracy of a reduced precision training,
+/// but it neither saves memory nor time.
+/// @param new_emulated_precision Emulated precision.
+
+void OptimizationAlgorithm::set_emulated_precision(const Precision& new_emulated_precision)
+{
+    emulated_precision = new_emulated_precision;
+}
+
+
+/// Sets the initial loss scale of the gradient in half precision.
+/// @param new_loss_scale Initial loss scale. It must be greater than 0.
+
+void OptimizationAlgorithm::set_loss_scale(const type& new_loss_scale)
+{
+    if(new_loss_scale <= type(0))
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: OptimizationAlgorithm class.\n"
+               << "void set_loss_scale(const type&) method.\n"
+               << "Loss scale must be greater than 0.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    loss_scale = new_loss_scale;
+}
+
+
+/// Rounds the gradient to the emulated precision, as if it had been stored in it.
+/// In half precision, the gradient is multiplied by the loss scale before rounding, so that small values do not underflow,
+/// and divided by it afterwards.
+/// The back propagation is made in single precision, so scaling the gradient is equivalent to scaling the loss.
+/// If the rounded gradient is not finite, the step must be skipped, and the loss scale is halved.
+/// The loss scale is doubled after a number of steps without overflow.
+/// @param back_propagation Back propagation of the loss index, with the gradient.
+/// @param optimization_data Data of the optimization algorithm, with the current loss scale.
+/// Returns false if the step must be skipped.
+
+bool OptimizationAlgorithm::emulate_gradient_precision(LossIndexBackPropagation& back_propagation,
+                                                        OptimizationAlgorithmData& optimization_data) const
+{
+    if(emulated_precision == Precision::Single) return true;
+
+    Tensor<type, 1>& gradient = back_propagation.gradient;
+
+    const bool is_loss_scaled = emulated_precision == Precision::Half;
+
+    if(is_loss_scaled) gradient.device(*thread_pool_device) = gradient*optimization_data.loss_scale;
+
+    round_to_precision(gradient, emulated_precision);
+
+    const Tensor<bool, 0> is_finite = gradient.isfinite().all();
+
+    if(!is_finite(0))
+    {
+        if(is_loss_scaled)
+        {
+            optimization_data.loss_scale /= type(2);
+            optimization_data.loss_scale_steps_number = 0;
+        }
+
+        return false;
+    }
+
+    if(!is_loss_scaled) return true;
+
+    gradient.device(*thread_pool_device) = gradient/optimization_data.loss_scale;
+
+    optimization_data.loss_scale_steps_number++;
+
+    if(optimization_data.loss_scale_steps_number == loss_scale_growth_interval)
+    {
+        optimization_data.loss_scale *= type(2);
+        optimization_data.loss_scale_steps_number = 0;
+    }
+
+    return true;
+}
+
+
+/// Sets the master parameters of the back propagation in the neural network, rounded to the emulated precision.
+/// The rounded parameters are a single precision copy of the master parameters.
+/// @param back_propagation Back propagation of the loss index, with the master parameters.
+/// @param optimization_data Data of the optimization algorithm, where the rounded parameters are kept.
+
+void OptimizationAlgorithm::set_neural_network_parameters(LossIndexBackPropagation& back_propagation,
+                                                          OptimizationAlgorithmData& optimization_data) const
+{
+    NeuralNetwork* neural_network_pointer = back_propagation.loss_index_pointer->get_neural_network_pointer();
+
+    if(emulated_precision == Precision::Single)
+    {
+        neural_network_pointer->set_parameters(back_propagation.parameters);
+
+        return;
+    }
+
+    optimization_data.emulated_precision_parameters = back_propagation.parameters;
+
+    round_to_precision(optimization_data.emulated_precision_parameters, emulated_precision);
+
+    neural_network_pointer->set_parameters(optimization_data.emulated_precision_parameters);
+}
+
 BoxPlot OptimizationAlgorithm::calculate_distances_box_plot(type* & new_inputs_data, Tensor<Index,1>& inputs_dimensions,
                                                             type* & new_outputs_data, Tensor<Index,1>& outputs_dimensions)
 {
@@ -30,6 +30,7 @@ namespace opennn
 {
 
 struct TrainingResults;
+struct OptimizationAlgorithmData;
 
 /// This abstract class represents the concept of optimization algorithm for a neural network in the OpenNN library.
 /// Any derived class must implement the perform_training() method.
@@ -70,6 +71,12 @@ public:
 
    const string& get_neural_network_file_name() const;
 
+   // Precision emulation
+
+   const Precision& get_emulated_precision() const;
+
+   const type& get_loss_scale() const;
+
    /// Writes the time from seconds in format HH:mm:ss.
 
    string write_time(const type&) const;
@@ -91,6 +98,9 @@ public:
    void set_save_period(const Index&);
    void set_neural_network_file_name(const string&);
 
+   void set_emulated_precision(const Precision&);
+   void set_loss_scale(const type&);
+
    // Calculate distances for AANN histogram
 
    BoxPlot calculate_distances_box_plot(type* &, Tensor<Index,1>&, type* &, Tensor<Index,1>&);
@@ -118,6 +128,12 @@ public:
    void save(const string&) const;
    void load(const string&);
 
+   // Precision emulation
+
+   bool emulate_gradient_precision(LossIndexBackPropagation&, OptimizationAlgorithmData&) const;
+
+   void set_neural_network_parameters(LossIndexBackPropagation&, OptimizationAlgorithmData&) const;
+
 protected:
 
    ThreadPool* thread_pool = nullptr;
@@ -157,6 +173,19 @@ protected:
 
    bool display = true;
 
+   /// Precision which is emulated for the parameters and the gradient, by rounding single precision values to it.
+   /// The optimization algorithm keeps master parameters in single precision, where the updates are accumulated.
+
+   Precision emulated_precision = Precision::Single;
+
+   /// Initial factor which multiplies the gradient before it is rounded to half precision, so that small values do not underflow.
+
+   type loss_scale = type(65536);
+
+   /// Number of steps without overflow of the scaled gradient after which the loss scale is doubled.
+
+   Index loss_scale_growth_interval = 2000;
+
    const Eigen::array<IndexPair<Index>, 1> AT_B = {IndexPair<Index>(0, 0)};
    const Eigen::array<IndexPair<Index>, 1> product_vector_matrix = {IndexPair<Index>(0, 1)}; // Normal product vector times matrix
    const Eigen::array<IndexPair<Index>, 1> A_B = {IndexPair<Index>(1, 0)};
@@ -194,6 +223,19 @@ struct OptimizationAlgorithmData
     Tensor<type, 1> training_direction;
     type initial_learning_rate = type(0);
 
+    /// Current loss scale of the gradient in half precision.
+
+    type loss_scale = type(1);
+
+    /// Number of steps since the loss scale last changed.
+
+    Index loss_scale_steps_number = 0;
+
+    /// Master parameters rounded to the emulated precision, which are set in the neural network.
+    /// They are stored in single precision, so they take as much memory as the master parameters.
+
+    Tensor<type, 1> emulated_precision_parameters;
+
 };
 
 
@@ -7,6 +7,7 @@
 //   artelnics@artelnics.com
 
 #include "perceptron_layer.h"
+#include "multihead_attention_layer.h"
 
 namespace opennn
 {
@@ -46,7 +47,7 @@ PerceptronLayer::PerceptronLayer(const Index& new_inputs_number, const Index& ne
 
 Index PerceptronLayer::get_inputs_number() const
 {
-    return synaptic_weights.dimension(0);
+    return is_quantized() ? quantized_synaptic_weights.inputs_number : synaptic_weights.dimension(0);
 }
 
 void PerceptronLayer::set_dropout_rate(const type& new_dropout_rate)
@@ -55,6 +56,18 @@ void PerceptronLayer::set_dropout_rate(const type& new_dropout_rate)
 }
 
 
+/// Sets the seed of the random dropout masks, and starts their sequence again.
+/// Two layers with the same seed and dropout rate drop out the same outputs.
+/// @param new_dropout_seed Seed of the dropout masks.
+
+void PerceptronLayer::set_dropout_seed(const Index& new_dropout_seed)
+{
+    dropout_seed = new_dropout_seed;
+
+    dropout_steps_number = 0;
+}
+
+
 Tensor<Index, 1> PerceptronLayer::get_inputs_dimensions() const
 {
     Tensor<Index, 1> inputs_dimensions(1);
@@ -93,7 +106,7 @@ Index PerceptronLayer::get_biases_number() const
 
 Index PerceptronLayer::get_synaptic_weights_number() const
 {
-    return synaptic_weights.size();
+    return get_inputs_number()*get_neurons_number();
 }
 
 
@@ -101,7 +114,7 @@ Index PerceptronLayer::get_synaptic_weights_number() const
 
 Index PerceptronLayer::get_parameters_number() const
 {
-    return biases.size() + synaptic_weights.size();
+    return biases.size() + get_synaptic_weights_number();
 }
 
 type PerceptronLayer::get_dropout_rate() const
@@ -109,6 +122,15 @@ type PerceptronLayer::get_dropout_rate() const
     return dropout_rate;
 }
 
+
+/// Returns the seed of the random dropout masks.
+
+Index PerceptronLayer::get_dropout_seed() const
+{
+    return dropout_seed;
+}
+
+
 /// Returns the biases from all the perceptrons in the layer.
 /// The format is a vector of real values.
 /// The size of this vector is the number of neurons in the layer.
@@ -170,6 +192,10 @@ Tensor<type, 2> PerceptronLayer::get_biases(const Tensor<type, 1>& parameters) c
 
 Tensor<type, 1> PerceptronLayer::get_parameters() const
 {
+    // The floating point synaptic weights of a quantized layer are recovered from the quantized ones
+
+    const Tensor<type, 2> synaptic_weights = is_quantized() ? quantized_synaptic_weights.dequantize() : this->synaptic_weights;
+
     Tensor<type, 1> parameters(synaptic_weights.size() + biases.size());
 
     memcpy(parameters.data(),
@@ -184,6 +210,8 @@ Tensor<type, 1> PerceptronLayer::get_parameters() const
 
 Tensor< TensorMap< Tensor<type, 1> >*, 1> PerceptronLayer::get_layer_parameters()
 {
+    dequantize();
+
     Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_parameters(2);
 
     const Index inputs_number = get_inputs_number();
@@ -268,6 +296,9 @@ void PerceptronLayer::set()
 
     synaptic_weights.resize(0, 0);
 
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.set();
+
     set_default();
 }
 
@@ -284,6 +315,9 @@ void PerceptronLayer::set(const Index& new_inputs_number, const Index& new_neuro
 
     synaptic_weights.resize(new_inputs_number, new_neurons_number);
 
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.set();
+
     set_parameters_random();
 
     activation_function = new_activation_function;
@@ -325,6 +359,9 @@ void PerceptronLayer::set_inputs_number(const Index& new_inputs_number)
     biases.resize(1, neurons_number);
 
     synaptic_weights.resize(new_inputs_number, neurons_number);
+
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -339,6 +376,9 @@ void PerceptronLayer::set_neurons_number(const Index& new_neurons_number)
     biases.resize(1, new_neurons_number);
 
     synaptic_weights.resize(inputs_number, new_neurons_number);
+
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -360,6 +400,9 @@ void PerceptronLayer::set_biases(const Tensor<type, 2>& new_biases)
 void PerceptronLayer::set_synaptic_weights(const Tensor<type, 2>& new_synaptic_weights)
 {
     synaptic_weights = new_synaptic_weights;
+
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -370,6 +413,8 @@ void PerceptronLayer::set_parameters(const Tensor<type, 1>& new_parameters, cons
 //    const Index biases_number = get_biases_number();
 //    const Index synaptic_weights_number = get_synaptic_weights_number();
 
+    dequantize();
+
     memcpy(synaptic_weights.data(),
            new_parameters.data() + index,
            static_cast<size_t>(synaptic_weights.size())*sizeof(type));
@@ -377,7 +422,11 @@ void PerceptronLayer::set_parameters(const Tensor<type, 1>& new_parameters, cons
     memcpy(biases.data(),
            new_parameters.data() + index + synaptic_weights.size(),
            static_cast<size_t>(biases.size())*sizeof(type));
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
+
+
 /// This class sets a new activation(or transfer) function in a single layer.
 /// @param new_activation_function Activation function for the layer.
 
@@ -474,7 +523,11 @@ void PerceptronLayer::set_biases_constant(const type& value)
 
 void PerceptronLayer::set_synaptic_weights_constant(const type& value)
 {
+    dequantize();
+
     synaptic_weights.setConstant(value);
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -483,9 +536,13 @@ void PerceptronLayer::set_synaptic_weights_constant(const type& value)
 
 void PerceptronLayer::set_parameters_constant(const type& value)
 {
+    dequantize();
+
     biases.setConstant(value);
 
     synaptic_weights.setConstant(value);
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -497,6 +554,8 @@ void PerceptronLayer::set_parameters_random()
     const type minimum = type(-0.2);
     const type maximum = type(0.2);
 
+    dequantize();
+
     for(Index i = 0; i < biases.size(); i++)
     {
         const type random = static_cast<type>(rand()/(RAND_MAX+1.0));
@@ -510,6 +569,100 @@ void PerceptronLayer::set_parameters_random()
 
         synaptic_weights(i) = minimum + (maximum - minimum)*random;
     }
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
+}
+
+
+/// Returns true, as perceptron layers can run inference with 8 bit integer weights.
+
+bool PerceptronLayer::is_quantizable() const
+{
+    return true;
+}
+
+
+/// Returns true if the layer runs inference with 8 bit integer weights.
+
+bool PerceptronLayer::is_quantized() const
+{
+    return !quantized_synaptic_weights.empty();
+}
+
+
+/// Quantizes the synaptic weights to 8 bit integers with a scale per neuron, which are used for inference.
+/// The floating point weights are released, so that the layer takes a quarter of their memory.
+/// Any change of the parameters, or training, dequantizes the layer.
+/// The layer is saved and loaded with the quantized weights.
+/// @param inputs_range Maximum absolute value of the layer inputs, calibrated on a data sample.
+
+void PerceptronLayer::quantize(const type& inputs_range)
+{
+    dequantize();
+
+    quantized_synaptic_weights.set(synaptic_weights, inputs_range);
+
+    synaptic_weights.resize(0, 0);
+}
+
+
+/// Returns the layer to floating point, with the synaptic weights dequantized from the quantized ones.
+/// The quantization error of the weights is not recovered.
+
+void PerceptronLayer::dequantize()
+{
+    if(!is_quantized()) return;
+
+    synaptic_weights = quantized_synaptic_weights.dequantize();
+
+    quantized_synaptic_weights.set();
+}
+
+
+/// Returns the precision in which the synaptic weights are stored for inference.
+
+Precision PerceptronLayer::get_weights_precision() const
+{
+    return reduced_precision_synaptic_weights.precision;
+}
+
+
+/// Stores the synaptic weights for inference in 16 bits, which halves the memory read by the products of a few samples.
+/// The weights are still trained in single precision, and any change of the parameters stores them again.
+/// Single precision removes the stored weights.
+/// @param new_weights_precision Precision of the stored weights.
+
+void PerceptronLayer::set_weights_precision(const Precision& new_weights_precision)
+{
+    reduced_precision_synaptic_weights.set(is_quantized() ? quantized_synaptic_weights.dequantize() : synaptic_weights,
+                                           new_weights_precision);
+}
+
+
+/// Returns the inputs of the layer as a matrix with a row for each sample.
+/// Inputs with more dimensions, as the outputs of attention layers, are flattened into the row of each sample,
+/// so the size of each sample must be the number of inputs of the layer.
+/// @param inputs Inputs of the layer, with the samples as first dimension.
+
+TensorMap<Tensor<type, 2>> PerceptronLayer::get_inputs_matrix(const DynamicTensor<type>& inputs) const
+{
+    const Index inputs_rank = inputs.get_dimensions().size();
+
+    const Index inputs_number = get_inputs_number();
+
+    if(inputs_rank < 2 || inputs.get_size() != inputs.get_dimension(0)*inputs_number)
+    {
+        ostringstream buffer;
+
+        buffer << "OpenNN Exception: PerceptronLayer class.\n"
+               << "TensorMap<Tensor<type, 2>> get_inputs_matrix(const DynamicTensor<type>&) const method.\n"
+               << "Inputs of rank " << inputs_rank << " and size " << inputs.get_size()
+               << " must have " << inputs_number << " (inputs number) values for each sample.\n";
+
+        throw invalid_argument(buffer.str());
+    }
+
+    return TensorMap<Tensor<type, 2>>(inputs.get_data(), inputs.get_dimension(0), inputs_number);
 }
 
 
@@ -529,7 +682,7 @@ void PerceptronLayer::calculate_combinations(const DynamicTensor<type>& inputs,
     PerceptronLayerForwardPropagation* perceptron_layer_forward_propagation
             = static_cast<PerceptronLayerForwardPropagation*>(layer_forward_propagation);
 
-    const TensorMap<Tensor<type, 2>> inputs_map = inputs.to_tensor_map<2>();
+    const TensorMap<Tensor<type, 2>> inputs_map = get_inputs_matrix(inputs);
 
     const Index batch_samples_number = inputs.get_dimension(0);
     const Index biases_number = get_neurons_number();
@@ -542,16 +695,107 @@ void PerceptronLayer::calculate_combinations(const DynamicTensor<type>& inputs,
 
     combinations.device(*thread_pool_device) = inputs_map.contract(synaptic_weights, A_B);
 
-    for(Index i = 0; i < biases_number; i++)
+    add_biases_activations(biases.data(), outputs_data, batch_samples_number, biases_number, LinearActivation());
+}
+
+
+/// Calculates the activations of the layer, and their derivatives if requested.
+/// The biases, the activation function and its derivative are applied in a single pass after the matrix product,
+/// while each block of outputs is still in cache, instead of a pass for each of them.
+/// The matrix product uses the 8 bit integer weights if the layer is quantized, as its floating point weights are released,
+/// or the 16 bit weights if they are stored and the batch is small.
+/// @param inputs Inputs of the layer. Inputs with more dimensions, as the outputs of attention layers, are a row for each sample.
+/// @param biases Biases of the neurons.
+/// @param synaptic_weights Synaptic weights of the neurons.
+/// @param layer_forward_propagation Forward propagation of the layer, where the outputs are written.
+/// @param calculate_derivatives True to write the activations derivatives too.
+
+void PerceptronLayer::calculate_combinations_activations(const DynamicTensor<type>& inputs,
+                                                         const Tensor<type, 2>& biases,
+                                                         const Tensor<type, 2>& synaptic_weights,
+                                                         LayerForwardPropagation* layer_forward_propagation,
+                                                         const bool& calculate_derivatives) const
+{
+    PerceptronLayerForwardPropagation* perceptron_layer_forward_propagation
+            = static_cast<PerceptronLayerForwardPropagation*>(layer_forward_propagation);
+
+    const TensorMap<Tensor<type, 2>> inputs_map = get_inputs_matrix(inputs);
+
+    const Index batch_samples_number = inputs.get_dimension(0);
+    const Index neurons_number = get_neurons_number();
+
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+
+    TensorMap<Tensor<type, 2>> combinations(outputs_data, batch_samples_number, neurons_number);
+
+    if(is_quantized() && synaptic_weights.size() == 0)
+    {
+        quantized_synaptic_weights.multiply(inputs_map, perceptron_layer_forward_propagation->quantized_inputs, outputs_data);
+    }
+    else if(!calculate_derivatives && reduced_precision_synaptic_weights.is_faster(batch_samples_number))
+    {
+        reduced_precision_synaptic_weights.multiply(inputs_map, outputs_data);
+    }
+    else
+    {
+        combinations.device(*thread_pool_device) = inputs_map.contract(synaptic_weights, A_B);
+    }
+
+    const type* biases_data = biases.data();
+
+    type* activations_derivatives_data = perceptron_layer_forward_propagation->activations_derivatives.data();
+
+    const auto add_biases = [&](const auto& activation)
     {
-         TensorMap<Tensor<type,1>>column(outputs_data + i * batch_samples_number, batch_samples_number);
+        if(calculate_derivatives)
+            add_biases_activations_derivatives(biases_data, outputs_data, activations_derivatives_data,
+                                               batch_samples_number, neurons_number, activation);
+        else
+            add_biases_activations(biases_data, outputs_data, batch_samples_number, neurons_number, activation);
+    };
+
+    if(fast_activations)
+    {
+        switch(activation_function)
+        {
+        case ActivationFunction::Logistic: add_biases(FastLogisticActivation()); return;
+
+        case ActivationFunction::HyperbolicTangent: add_biases(FastHyperbolicTangentActivation()); return;
+
+        case ActivationFunction::SoftPlus: add_biases(FastSoftPlusActivation()); return;
+
+        case ActivationFunction::ExponentialLinear: add_biases(FastExponentialLinearActivation()); return;
 
-         column.device(*thread_pool_device) = column + biases(i);
+        default: break;
+        }
     }
 
-//    combinations.device(*thread_pool_device) += inputs_map.contract(synaptic_weights, A_B);
-//    combinations += inputs.contract(synaptic_weights, A_B);
+    switch(activation_function)
+    {
+    case ActivationFunction::Linear: add_biases(LinearActivation()); return;
+
+    case ActivationFunction::Logistic: add_biases(LogisticActivation()); return;
+
+    case ActivationFunction::HyperbolicTangent: add_biases(HyperbolicTangentActivation()); return;
+
+    case ActivationFunction::Threshold: add_biases(ThresholdActivation()); return;
+
+    case ActivationFunction::SymmetricThreshold: add_biases(SymmetricThresholdActivation()); return;
 
+    case ActivationFunction::RectifiedLinear: add_biases(RectifiedLinearActivation()); return;
+
+    case ActivationFunction::ScaledExponentialLinear: add_biases(ScaledExponentialLinearActivation()); return;
+
+    case ActivationFunction::SoftPlus: add_biases(SoftPlusActivation()); return;
+
+    case ActivationFunction::SoftSign: add_biases(SoftSignActivation()); return;
+
+    case ActivationFunction::HardSigmoid: add_biases(HardSigmoidActivation()); return;
+
+    case ActivationFunction::ExponentialLinear: add_biases(ExponentialLinearActivation()); return;
+
+    default: return;
+    }
 }
 
 /* @todo MKL implementation
@@ -735,49 +979,19 @@ void PerceptronLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& in
 
 #endif
 
-    calculate_combinations(inputs(0),
-                           biases,
-                           synaptic_weights,
-                           layer_forward_propagation);
+    calculate_combinations_activations(inputs(0),
+                                       biases,
+                                       synaptic_weights,
+                                       layer_forward_propagation,
+                                       is_training);
 
     if(is_training && dropout_rate > type(0))
     {
-        type* outputs_data = layer_forward_propagation->outputs(0).get_data();
-
-        const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
-        const Index outputs_number = get_neurons_number();
-
-        const type scaling_factor = type(1) / (type(1) - dropout_rate);
-
-        for(Index neuron_index = 0; neuron_index < outputs_number; ++neuron_index)
-        {
-            const type random_number = static_cast<type>(rand()) / static_cast<type>(RAND_MAX);
-
-            TensorMap<Tensor<type, 1>> column(outputs_data + neuron_index*batch_samples_number, batch_samples_number);
-
-            if(random_number < dropout_rate)
-            {
-                column.setZero();
-            }
-            else
-            {
-                column = column*scaling_factor;
-            }
-        }
-    }
-
-    if(is_training) // Perform training
-    {
-        calculate_activations_derivatives(layer_forward_propagation);
-    }
-    else
-    {
-        calculate_activations(layer_forward_propagation);
+        dropout(layer_forward_propagation);
     }
 }
 
 
-
 void PerceptronLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
                                         Tensor<type, 1>& potential_parameters,
                                         LayerForwardPropagation* layer_forward_propagation)
@@ -806,38 +1020,80 @@ void PerceptronLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& in
                                                                 inputs_number,
                                                                 neurons_number);
 
-    calculate_combinations(inputs(0),
-                           potential_biases,
-                           potential_synaptic_weights,
-                           layer_forward_propagation);
+    calculate_combinations_activations(inputs(0),
+                                       potential_biases,
+                                       potential_synaptic_weights,
+                                       layer_forward_propagation,
+                                       true);
 
     if(dropout_rate > type(0))
     {
-        type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+        dropout(layer_forward_propagation);
+    }
+}
+
+
+/// Drops out each output of the layer with probability equal to the dropout rate,
+/// and scales the others by 1/(1 - dropout rate), so that the expected outputs do not change.
+/// The mask is drawn from a Philox counter-based generator, keyed by the dropout seed,
+/// with a counter made of the element index and the number of previous calls,
+/// so that it is generated in parallel and is the same for the same seed.
+/// The mask is stored in the forward propagation and multiplies the activations derivatives too,
+/// so that the back propagation only goes through the outputs which were kept.
+/// @param layer_forward_propagation Forward propagation of the layer, with the activations and their derivatives.
+
+void PerceptronLayer::dropout(LayerForwardPropagation* layer_forward_propagation)
+{
+    PerceptronLayerForwardPropagation* perceptron_layer_forward_propagation
+            = static_cast<PerceptronLayerForwardPropagation*>(layer_forward_propagation);
+
+    const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
+    const Index neurons_number = get_neurons_number();
+    const Index outputs_size = batch_samples_number*neurons_number;
+
+    Tensor<type, 2>& dropout_mask = perceptron_layer_forward_propagation->dropout_mask;
+
+    if(dropout_mask.size() != outputs_size) dropout_mask.resize(batch_samples_number, neurons_number);
+
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+    type* activations_derivatives_data = perceptron_layer_forward_propagation->activations_derivatives.data();
+    type* dropout_mask_data = dropout_mask.data();
+
+    const type scaling_factor = type(1)/(type(1) - dropout_rate);
+
+    const uint64_t seed = uint64_t(dropout_seed);
+    const uint64_t step = uint64_t(dropout_steps_number++);
 
-        const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
-        const Index outputs_number = get_neurons_number();
+    const uint32_t key[2] = {uint32_t(seed), uint32_t(seed >> 32)};
 
-        const type scaling_factor = type(1) / (type(1) - dropout_rate);
+    // Each Philox call gives the random numbers of 4 consecutive outputs
 
-        for(Index neuron_index = 0; neuron_index < outputs_number; ++neuron_index)
+    const Index blocks_number = (outputs_size + 3)/4;
+
+    const TensorOpCost cost(0, 12*sizeof(type), 80);
+
+    thread_pool_device->parallelFor(blocks_number, cost, [&](Index first, Index last)
+    {
+        for(Index block = first; block < last; block++)
         {
-            const type random_number = static_cast<type>(rand()) / static_cast<type>(RAND_MAX);
+            uint32_t random_words[4] = {uint32_t(block), uint32_t(uint64_t(block) >> 32), uint32_t(step), uint32_t(step >> 32)};
 
-            TensorMap<Tensor<type, 1>> column(outputs_data + neuron_index*batch_samples_number, batch_samples_number);
+            philox_4x32_10(random_words, key);
 
-            if(random_number < dropout_rate)
-            {
-                column.setZero();
-            }
-            else
+            const Index block_size = min(Index(4), outputs_size - 4*block);
+
+            for(Index j = 0; j < block_size; j++)
             {
-                column = column * scaling_factor;
+                const Index i = 4*block + j;
+
+                const type mask = philox_uniform(random_words[j]) < dropout_rate ? type(0) : scaling_factor;
+
+                dropout_mask_data[i] = mask;
+                outputs_data[i] *= mask;
+                activations_derivatives_data[i] *= mask;
             }
         }
-    }
-
-    calculate_activations_derivatives(layer_forward_propagation);
+    });
 }
 
 
@@ -877,6 +1133,15 @@ void PerceptronLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer
     }
         break;
 
+    case Type::MultiheadAttention:
+    {
+        static_cast<MultiheadAttentionLayer*>(next_layer_back_propagation->layer_pointer)
+                ->calculate_inputs_deltas(next_layer_forward_propagation,
+                                          next_layer_back_propagation,
+                                          perceptron_layer_back_propagation->deltas_data);
+    }
+        break;
+
     default: return;
     }
 }
@@ -1375,6 +1640,8 @@ string PerceptronLayer::write_expression(const Tensor<string, 1>& inputs_names,
 
     ostringstream buffer;
 
+    const Tensor<type, 2> synaptic_weights = is_quantized() ? quantized_synaptic_weights.dequantize() : this->synaptic_weights;
+
     for(Index j = 0; j < outputs_names.size(); j++)
     {
         const Tensor<type, 1> synaptic_weights_column =  synaptic_weights.chip(j,1);
@@ -1482,11 +1749,15 @@ void PerceptronLayer::from_XML(const tinyxml2::XMLDocument& document)
         set_activation_function(activation_function_element->GetText());
     }
 
-    // Parameters
+    // Parameters, or biases and quantized synaptic weights
 
     const tinyxml2::XMLElement* parameters_element = perceptron_layer_element->FirstChildElement("Parameters");
 
-    if(!parameters_element)
+    const tinyxml2::XMLElement* biases_element = perceptron_layer_element->FirstChildElement("Biases");
+
+    const tinyxml2::XMLElement* quantized_synaptic_weights_element = perceptron_layer_element->FirstChildElement("QuantizedSynapticWeights");
+
+    if(!parameters_element && (!biases_element || !quantized_synaptic_weights_element))
     {
         buffer << "OpenNN Exception: PerceptronLayer class.\n"
                << "void from_XML(const tinyxml2::XMLDocument&) method.\n"
@@ -1495,12 +1766,37 @@ void PerceptronLayer::from_XML(const tinyxml2::XMLDocument& document)
         throw invalid_argument(buffer.str());
     }
 
-    if(parameters_element->GetText())
+    if(parameters_element && parameters_element->GetText())
     {
         const string parameters_string = parameters_element->GetText();
 
         set_parameters(to_type_vector(parameters_string, ' '));
     }
+    else if(!parameters_element)
+    {
+        const Tensor<type, 1> new_biases = biases_element->GetText()
+                ? to_type_vector(biases_element->GetText(), ' ')
+                : Tensor<type, 1>();
+
+        if(new_biases.size() != biases.size())
+        {
+            buffer << "OpenNN Exception: PerceptronLayer class.\n"
+                   << "void from_XML(const tinyxml2::XMLDocument&) method.\n"
+                   << "Number of biases (" << new_biases.size() << ") must be " << biases.size() << ".\n";
+
+            throw invalid_argument(buffer.str());
+        }
+
+        copy(new_biases.data(), new_biases.data() + new_biases.size(), biases.data());
+
+        // The layer stays quantized, without floating point synaptic weights
+
+        quantized_synaptic_weights.from_XML(quantized_synaptic_weights_element, get_inputs_number(), get_neurons_number());
+
+        synaptic_weights.resize(0, 0);
+
+        reduced_precision_synaptic_weights.set();
+    }
 }
 
 
@@ -1548,25 +1844,49 @@ void PerceptronLayer::write_XML(tinyxml2::XMLPrinter& file_stream) const
 
     file_stream.CloseElement();
 
-    // Parameters
+    // Parameters, or biases and quantized synaptic weights, which take less space than the floating point ones
 
-    file_stream.OpenElement("Parameters");
+    if(is_quantized())
+    {
+        file_stream.OpenElement("Biases");
 
-    buffer.str("");
+        buffer.str("");
 
-    const Tensor<type, 1> parameters = get_parameters();
-    const Index parameters_size = parameters.size();
+        const Index biases_number = biases.size();
 
-    for(Index i = 0; i < parameters_size; i++)
-    {
-        buffer << parameters(i);
+        for(Index i = 0; i < biases_number; i++)
+        {
+            buffer << biases(i);
+
+            if(i != (biases_number-1)) buffer << " ";
+        }
 
-        if(i != (parameters_size-1)) buffer << " ";
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+
+        quantized_synaptic_weights.write_XML(file_stream);
     }
+    else
+    {
+        file_stream.OpenElement("Parameters");
 
-    file_stream.PushText(buffer.str().c_str());
+        buffer.str("");
 
-    file_stream.CloseElement();
+        const Tensor<type, 1> parameters = get_parameters();
+        const Index parameters_size = parameters.size();
+
+        for(Index i = 0; i < parameters_size; i++)
+        {
+            buffer << parameters(i);
+
+            if(i != (parameters_size-1)) buffer << " ";
+        }
+
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+    }
 
     // Peceptron layer (end tag)
 
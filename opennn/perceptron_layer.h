@@ -22,7 +22,9 @@
 
 #include "config.h"
 #include "layer.h"
+#include "philox.h"
 #include "probabilistic_layer.h"
+#include "quantization.h"
 
 #ifdef OPENNN_MKL
     #include "../mkl/mkl.h"
@@ -102,6 +104,7 @@ public:
    Index get_synaptic_weights_number() const;
    Index get_parameters_number() const final;
    type get_dropout_rate() const;
+   Index get_dropout_seed() const;
    Tensor<type, 1> get_parameters() const final;
 
    Tensor< TensorMap< Tensor<type, 1>>*, 1> get_layer_parameters() final;
@@ -141,6 +144,7 @@ public:
    void set_activation_function(const ActivationFunction&);
    void set_activation_function(const string&);
    void set_dropout_rate(const type&);
+   void set_dropout_seed(const Index&);
 
    // Display messages
 
@@ -154,19 +158,43 @@ public:
 
    void set_parameters_random() final;
 
+   // Quantization
+
+   bool is_quantizable() const final;
+   bool is_quantized() const final;
+
+   void quantize(const type&) final;
+   void dequantize() final;
+
+   // Reduced precision
+
+   Precision get_weights_precision() const final;
+
+   void set_weights_precision(const Precision&) final;
+
    // Perceptron layer combinations
 
+   TensorMap<Tensor<type, 2>> get_inputs_matrix(const DynamicTensor<type>&) const;
+
    void calculate_combinations(const DynamicTensor<type>&,
                                const Tensor<type, 2>&,
                                const Tensor<type, 2>&,
                                LayerForwardPropagation*) const;
 
+   void calculate_combinations_activations(const DynamicTensor<type>&,
+                                           const Tensor<type, 2>&,
+                                           const Tensor<type, 2>&,
+                                           LayerForwardPropagation*,
+                                           const bool&) const;
+
    // Perceptron layer activations
 
    void calculate_activations(LayerForwardPropagation*) const;
 
    void calculate_activations_derivatives(LayerForwardPropagation*) const;
 
+   void dropout(LayerForwardPropagation*);
+
    // Perceptron layer outputs
 
    void forward_propagate(const Tensor<DynamicTensor<type>, 1>&,
@@ -248,15 +276,32 @@ protected:
    Tensor<type, 2> biases;
 
    /// This matrix contains conection strengths from a layer's inputs to its neurons.
+   /// It is empty while the layer is quantized.
 
    Tensor<type, 2> synaptic_weights;
 
+   /// Synaptic weights quantized to 8 bit integers for inference, empty if the layer is not quantized.
+
+   QuantizedSynapticWeights quantized_synaptic_weights;
+
+   /// Synaptic weights stored in 16 bits for inference, empty if the weights precision is single.
+
+   ReducedPrecisionSynapticWeights reduced_precision_synaptic_weights;
+
    /// Activation function variable.
 
    ActivationFunction activation_function;
 
    type dropout_rate = type(0);
 
+   /// Seed of the counter-based random generator of the dropout masks.
+
+   Index dropout_seed = 0;
+
+   /// Number of dropout masks generated since the seed was set, which is part of the random counter.
+
+   Index dropout_steps_number = 0;
+
    /// Display messages to screen. 
 
    bool display = true;
@@ -317,11 +362,16 @@ struct PerceptronLayerForwardPropagation : LayerForwardPropagation
          output_dimensions.setValues({batch_samples_number, neurons_number});
 
          outputs.resize(1);
-         outputs(0).set_dimensions(output_dimensions);
+         set_buffer_dimensions(outputs(0), output_dimensions);
 
          // Rest of quantities
 
-         activations_derivatives.resize(batch_samples_number, neurons_number);
+         if(is_inference)
+             activations_derivatives.resize(0, 0);
+         else
+             activations_derivatives.resize(batch_samples_number, neurons_number);
+
+         dropout_mask.resize(0, 0);
      }
 
      void print() const
@@ -340,6 +390,14 @@ struct PerceptronLayerForwardPropagation : LayerForwardPropagation
      }
 
      Tensor<type, 2> activations_derivatives;
+
+     /// Dropout mask of the last training forward propagation: 0 for dropped outputs and 1/(1 - dropout rate) for the others.
+
+     Tensor<type, 2> dropout_mask;
+
+     /// Inputs quantized to 8 bit integers, for the product with the quantized synaptic weights.
+
+     Tensor<int16_t, 2> quantized_inputs;
 };
 
 
@@ -0,0 +1,84 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   P H I L O X   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef PHILOX_H
+#define PHILOX_H
+
+// System includes
+
+#include <cstdint>
+
+// OpenNN includes
+
+#include "config.h"
+
+namespace opennn
+{
+
+/// Philox 4x32-10 counter-based random number generator (Salmon et al., 2011).
+/// The four 32-bit outputs are a bijection of the 128-bit counter, keyed by a 64-bit seed,
+/// so that any element of a random stream can be generated independently from the others,
+/// in parallel and in any order, and the same seed and counter always give the same numbers.
+/// @param counter Counter, overwritten with the four random words.
+/// @param key Key, usually a seed.
+
+inline void philox_4x32_10(uint32_t counter[4], const uint32_t key[2])
+{
+    const uint64_t multiplier_0 = 0xD2511F53;
+    const uint64_t multiplier_1 = 0xCD9E8D57;
+
+    uint32_t key_0 = key[0];
+    uint32_t key_1 = key[1];
+
+    for(int round = 0; round < 10; round++)
+    {
+        const uint64_t product_0 = multiplier_0*counter[0];
+        const uint64_t product_1 = multiplier_1*counter[2];
+
+        const uint32_t new_counter_0 = uint32_t(product_1 >> 32) ^ counter[1] ^ key_0;
+        const uint32_t new_counter_2 = uint32_t(product_0 >> 32) ^ counter[3] ^ key_1;
+
+        counter[1] = uint32_t(product_1);
+        counter[3] = uint32_t(product_0);
+        counter[0] = new_counter_0;
+        counter[2] = new_counter_2;
+
+        key_0 += 0x9E3779B9;
+        key_1 += 0xBB67AE85;
+    }
+}
+
+
+/// Returns a uniform random number in [0, 1) from the 24 highest bits of a random word.
+
+inline type philox_uniform(const uint32_t& random_word)
+{
+    return type(random_word >> 8)*type(1.0/16777216.0);
+}
+
+}
+
+#endif
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
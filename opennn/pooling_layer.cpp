@@ -7,6 +7,7 @@
 //   artelnics@artelnics.com
 
 #include "pooling_layer.h"
+#include "convolutional_layer.h"
 
 namespace opennn
 {
@@ -354,29 +355,74 @@ void PoolingLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& input
 }
 
 
-/// Returns the result of applying average pooling to a batch of images.
-/// @param inputs The batch of images.
+/// Calculates the average of each pool of the inputs, and writes it directly to the outputs.
+/// The output columns of each channel are calculated in parallel, and the inner loops go over the batch samples,
+/// which are contiguous both in the inputs and in the outputs.
+/// @param inputs The batch of images, with dimensions (batch samples, rows, columns, channels).
+/// @param layer_forward_propagation Forward propagation of the layer.
+/// @param is_training True if the layer is being trained.
 
 void PoolingLayer::forward_propagate_average_pooling(const DynamicTensor<type>& inputs,
                        LayerForwardPropagation* layer_forward_propagation,
                        const bool& is_training)
 {
+    const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
 
-    const type kernel_size = static_cast<type>(pool_rows_number * pool_columns_number);
+    const Index inputs_rows_number = get_inputs_rows_number();
+    const Index inputs_columns_number = get_inputs_columns_number();
+    const Index channels_number = get_channels_number();
 
-    PoolingLayerForwardPropagation* pooling_layer_forward_propagation
-            = static_cast<PoolingLayerForwardPropagation*>(layer_forward_propagation);
+    const Index outputs_rows_number = get_outputs_rows_number();
+    const Index outputs_columns_number = get_outputs_columns_number();
+
+    const type* inputs_data = inputs.get_data();
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
 
-    const TensorMap<Tensor<type, 4>> inputs_map = inputs.to_tensor_map<4>();
+    const type pool_size_inverse = type(1)/type(pool_rows_number*pool_columns_number);
 
-    TensorMap<Tensor<type, 4>> outputs = pooling_layer_forward_propagation->outputs(0).to_tensor_map<4>();
+    const TensorOpCost cost(type(outputs_rows_number*batch_samples_number*pool_rows_number*pool_columns_number*sizeof(type)),
+                            type(outputs_rows_number*batch_samples_number*sizeof(type)),
+                            type(outputs_rows_number*batch_samples_number*pool_rows_number*pool_columns_number));
+
+    thread_pool_device->parallelFor(channels_number*outputs_columns_number, cost, [&](Index first, Index last)
+    {
+        for(Index slice_index = first; slice_index < last; slice_index++)
+        {
+            const Index channel_index = slice_index/outputs_columns_number;
+            const Index output_column = slice_index%outputs_columns_number;
+
+            for(Index output_row = 0; output_row < outputs_rows_number; output_row++)
+            {
+                type* outputs = outputs_data
+                        + batch_samples_number*(output_row + outputs_rows_number*(output_column + outputs_columns_number*channel_index));
+
+                fill(outputs, outputs + batch_samples_number, type(0));
+
+                for(Index pool_column = 0; pool_column < pool_columns_number; pool_column++)
+                {
+                    const Index input_column = output_column*column_stride + pool_column;
 
-    Tensor<type, 4> kernel(1, pool_rows_number, pool_columns_number, 1);
+                    for(Index pool_row = 0; pool_row < pool_rows_number; pool_row++)
+                    {
+                        const Index input_row = output_row*row_stride + pool_row;
 
-    kernel.setConstant(static_cast<type>(1.0/kernel_size));
+                        const type* pool_inputs = inputs_data
+                                + batch_samples_number*(input_row + inputs_rows_number*(input_column + inputs_columns_number*channel_index));
 
-    outputs = inputs_map.convolve(kernel, convolution_dimensions);
+                        for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
+                        {
+                            outputs[sample_index] += pool_inputs[sample_index];
+                        }
+                    }
+                }
 
+                for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
+                {
+                    outputs[sample_index] *= pool_size_inverse;
+                }
+            }
+        }
+    });
 }
 
 
@@ -400,7 +446,11 @@ void PoolingLayer::forward_propagate_no_pooling(const DynamicTensor<type>& input
 }
 
 
-/// Returns the result of applying max pooling to a batch of images.
+/// Calculates the maximum of each pool of the inputs, and writes it directly to the outputs.
+/// When training, the index of each maximum in the inputs is stored, so that the deltas can be back propagated to it.
+/// @param inputs The batch of images, with dimensions (batch samples, rows, columns, channels).
+/// @param layer_forward_propagation Forward propagation of the layer.
+/// @param is_training True if the layer is being trained.
 
 void PoolingLayer::forward_propagate_max_pooling(const DynamicTensor<type>& inputs,
                                                  LayerForwardPropagation* layer_forward_propagation,
@@ -409,283 +459,257 @@ void PoolingLayer::forward_propagate_max_pooling(const DynamicTensor<type>& inpu
     PoolingLayerForwardPropagation* pooling_layer_forward_propagation
             = static_cast<PoolingLayerForwardPropagation*>(layer_forward_propagation);
 
-    const TensorMap<Tensor<type, 4>> inputs_map = inputs.to_tensor_map<4>();
+    const Index batch_samples_number = layer_forward_propagation->batch_samples_number;
 
-    const Eigen::array<ptrdiff_t, 4> outputs_dimensions_array = pooling_layer_forward_propagation->get_outputs_dimensions_array();
+    const Index inputs_rows_number = get_inputs_rows_number();
+    const Index inputs_columns_number = get_inputs_columns_number();
+    const Index channels_number = get_channels_number();
 
-    TensorMap<Tensor<type, 4>> outputs = layer_forward_propagation->outputs(0).to_tensor_map<4>();
+    const Index outputs_rows_number = get_outputs_rows_number();
+    const Index outputs_columns_number = get_outputs_columns_number();
 
-    const Index in_rows_stride = 1;
-    const Index in_columns_stride = 1;
+    const type* inputs_data = inputs.get_data();
+    type* outputs_data = layer_forward_propagation->outputs(0).get_data();
+    Index* maximal_indices_data = pooling_layer_forward_propagation->maximal_indices.data();
 
-    pooling_layer_forward_propagation->image_patches.device(*thread_pool_device) = inputs_map.extract_image_patches(pool_rows_number,
-                                                           pool_columns_number,
-                                                           row_stride,
-                                                           column_stride,
-                                                           in_rows_stride,
-                                                           in_columns_stride,
-                                                           PADDING_VALID,
-                                                           padding_width);
+    const TensorOpCost cost(type(outputs_rows_number*batch_samples_number*pool_rows_number*pool_columns_number*sizeof(type)),
+                            type(outputs_rows_number*batch_samples_number*(sizeof(type) + sizeof(Index))),
+                            type(2*outputs_rows_number*batch_samples_number*pool_rows_number*pool_columns_number));
 
-    outputs.device(*thread_pool_device) = pooling_layer_forward_propagation->image_patches.maximum(max_pooling_dimensions).reshape(outputs_dimensions_array);
-}
+    thread_pool_device->parallelFor(channels_number*outputs_columns_number, cost, [&](Index first, Index last)
+    {
+        for(Index slice_index = first; slice_index < last; slice_index++)
+        {
+            const Index channel_index = slice_index/outputs_columns_number;
+            const Index output_column = slice_index%outputs_columns_number;
 
+            for(Index output_row = 0; output_row < outputs_rows_number; output_row++)
+            {
+                const Index outputs_index
+                        = batch_samples_number*(output_row + outputs_rows_number*(output_column + outputs_columns_number*channel_index));
 
-void PoolingLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
-                                          LayerBackPropagation* next_layer_back_propagation,
-                                          LayerBackPropagation* this_layeer_back_propagation) const
-{
-    /// @todo put switch
-    /*
-    if(pooling_method == PoolingMethod::NoPooling) return next_layer_delta;
+                type* outputs = outputs_data + outputs_index;
+                Index* maximal_indices = maximal_indices_data + outputs_index;
 
-    else
-    {
-        const Type layer_type = next_layer_pointer->get_type();
+                for(Index pool_column = 0; pool_column < pool_columns_number; pool_column++)
+                {
+                    const Index input_column = output_column*column_stride + pool_column;
 
-        if(layer_type == Type::Convolutional)
-        {
-            ConvolutionalLayer* convolutional_layer = dynamic_cast<ConvolutionalLayer*>(next_layer_pointer);
+                    for(Index pool_row = 0; pool_row < pool_rows_number; pool_row++)
+                    {
+                        const Index input_row = output_row*row_stride + pool_row;
 
-            return calculate_hidden_delta_convolutional(convolutional_layer, activations, activations_derivatives, next_layer_delta);
-        }
-        else if(layer_type == Type::Pooling)
-        {
-            PoolingLayer* pooling_layer = dynamic_cast<PoolingLayer*>(next_layer_pointer);
+                        const Index inputs_index
+                                = batch_samples_number*(input_row + inputs_rows_number*(input_column + inputs_columns_number*channel_index));
+
+                        const type* pool_inputs = inputs_data + inputs_index;
+
+                        const bool is_first = pool_row == 0 && pool_column == 0;
 
-            return calculate_hidden_delta_pooling(pooling_layer, activations, activations_derivatives, next_layer_delta);
+                        if(is_training)
+                        {
+                            for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
+                            {
+                                if(is_first || pool_inputs[sample_index] > outputs[sample_index])
+                                {
+                                    outputs[sample_index] = pool_inputs[sample_index];
+                                    maximal_indices[sample_index] = inputs_index + sample_index;
+                                }
+                            }
+                        }
+                        else if(is_first)
+                        {
+                            copy(pool_inputs, pool_inputs + batch_samples_number, outputs);
+                        }
+                        else
+                        {
+                            for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
+                            {
+                                outputs[sample_index] = max(outputs[sample_index], pool_inputs[sample_index]);
+                            }
+                        }
+                    }
+                }
+            }
         }
-    }
-    */
+    });
 }
 
-/**
-void PoolingLayer::calculate_hidden_delta_convolutional(LayerForwardPropagation* next_layer_forward_propagation,
-                                                        LayerBackPropagation* next_layer_back_propagation,
-                                                        LayerBackPropagation* this_layer_back_propagation) const
-{
-    // Current layer's values
 
-    const Index batch_samples_number = next_layer_forward_propagation->outputs_dimensions[0](0);
-    const Index channels_number = get_channels_number();
-    const Index output_rows_number = get_outputs_rows_number();
-    const Index output_columns_number = get_outputs_columns_number();
+void PoolingLayer::calculate_hidden_delta(LayerForwardPropagation* next_layer_forward_propagation,
+                                          LayerBackPropagation* next_layer_back_propagation,
+                                          LayerBackPropagation* this_layer_back_propagation) const
+{
+    switch(next_layer_back_propagation->layer_pointer->get_type())
+    {
+    case Type::Convolutional:
 
-    // Next layer's values
-/*
-    ConvolutionalLayer* convolutional_layer_pointer
-            = static_cast<ConvolutionalLayer*>(next_layer_forward_propagation->layer_pointer);
+        calculate_hidden_delta_convolutional(next_layer_forward_propagation,
+                                             next_layer_back_propagation,
+                                             this_layer_back_propagation);
+        return;
 
-    const Index next_layers_filters_number = convolutional_layer_pointer->get_kernels_number();
-    const Index next_layers_filter_rows = convolutional_layer_pointer->get_kernels_rows_number();
-    const Index next_layers_filter_columns = convolutional_layer_pointer->get_kernels_columns_number();
-    const Index next_layers_output_rows = convolutional_layer_pointer->get_outputs_rows_number();
-    const Index next_layers_output_columns = convolutional_layer_pointer->get_outputs_columns_number();
-    const Index next_layers_row_stride = convolutional_layer_pointer->get_row_stride();
-    const Index next_layers_column_stride = convolutional_layer_pointer->get_column_stride();
+    case Type::Pooling:
 
-    const Tensor<type, 4> next_layers_weights = next_layer_pointer->get_synaptic_weights();
+        calculate_hidden_delta_pooling(next_layer_forward_propagation,
+                                       next_layer_back_propagation,
+                                       this_layer_back_propagation);
+        return;
 
-    // Hidden delta calculation
+    case Type::Flatten:
 
-        Tensor<type, 4> hidden_delta(images_number, channels_number, output_rows_number, output_columns_number);
+        calculate_hidden_delta_flatten(next_layer_forward_propagation,
+                                       next_layer_back_propagation,
+                                       this_layer_back_propagation);
+        return;
 
-        const Index size = hidden_delta.size();
+    default:
 
-        #pragma omp parallel for
+        cout << "Neural network structure not implemented: " << next_layer_back_propagation->layer_pointer->get_type_string() << endl;
+        return;
+    }
+}
 
-        for(Index tensor_index = 0; tensor_index < size; tensor_index++)
-        {
-            const Index image_index = tensor_index/(channels_number*output_rows_number*output_columns_number);
-            const Index channel_index = (tensor_index/(output_rows_number*output_columns_number))%channels_number;
-            const Index row_index = (tensor_index/output_columns_number)%output_rows_number;
-            const Index column_index = tensor_index%output_columns_number;
 
-            long double sum = 0.0;
+void PoolingLayer::calculate_hidden_delta_convolutional(LayerForwardPropagation* next_layer_forward_propagation,
+                                                        LayerBackPropagation* next_layer_back_propagation,
+                                                        LayerBackPropagation* this_layer_back_propagation) const
+{
+    ConvolutionalLayerForwardPropagation* next_convolutional_layer_forward_propagation
+            = static_cast<ConvolutionalLayerForwardPropagation*>(next_layer_forward_propagation);
 
-            const Index lower_row_index = (row_index - next_layers_filter_rows)/next_layers_row_stride + 1;
-            const Index upper_row_index = min(row_index/next_layers_row_stride + 1, next_layers_output_rows);
-            const Index lower_column_index = (column_index - next_layers_filter_columns)/next_layers_column_stride + 1;
-            const Index upper_column_index = min(column_index/next_layers_column_stride + 1, next_layers_output_columns);
+    ConvolutionalLayerBackPropagation* next_convolutional_layer_back_propagation
+            = static_cast<ConvolutionalLayerBackPropagation*>(next_layer_back_propagation);
 
-            for(Index i = 0; i < next_layers_filters_number; i++)
-            {
-                for(Index j = lower_row_index; j < upper_row_index; j++)
-                {
-                    for(Index k = lower_column_index; k < upper_column_index; k++)
-                    {
-                        const type delta_element = next_layer_delta(image_index, i, j, k);
+    const ConvolutionalLayer* next_convolutional_layer
+            = static_cast<ConvolutionalLayer*>(next_layer_back_propagation->layer_pointer);
 
-                        const type weight = next_layers_weights(i, channel_index, row_index - j*next_layers_row_stride, column_index - k*next_layers_column_stride);
+    const TensorMap<Tensor<type, 4>> next_deltas(next_convolutional_layer_back_propagation->deltas_data,
+                                                 next_convolutional_layer_back_propagation->get_deltas_dimensions_array());
 
-                        sum += delta_element*weight;
-                    }
-                }
-            }
+    next_convolutional_layer_back_propagation->deltas_times_activations_derivatives.device(*thread_pool_device)
+            = next_deltas*next_convolutional_layer_forward_propagation->activations_derivatives;
 
-            hidden_delta(image_index, channel_index, row_index, column_index) = sum;
-        }
+    next_convolutional_layer->calculate_inputs_derivatives(next_convolutional_layer_back_propagation,
+                                                           this_layer_back_propagation->deltas_data);
 }
-*/
 
 
 void PoolingLayer::calculate_hidden_delta_pooling(LayerForwardPropagation* next_layer_forward_propagation,
                                                   LayerBackPropagation* next_layer_back_propagation,
                                                   LayerBackPropagation* this_layer_back_propagation) const
 {
-/*
-        switch(next_layer_pointer->get_pooling_method())
-        {
-            case opennn::PoolingLayer::PoolingMethod::NoPooling:
-            {
-                return next_layer_delta;
-            }
-
-            case opennn::PoolingLayer::PoolingMethod::AveragePooling:
-            {
-                // Current layer's values
-
-                const Index batch_samples_number = next_layer_delta.dimension(0);
-                const Index channels_number = get_channels_number();
-                const Index output_rows_number = get_outputs_rows_number();
-                const Index output_columns_number = get_outputs_columns_number();
-
-                // Next layer's values
-
-                const Index next_layers_pool_rows = next_layer_pointer->get_pool_rows_number();
-                const Index next_layers_pool_columns = next_layer_pointer->get_pool_columns_number();
-                const Index next_layers_output_rows = next_layer_pointer->get_outputs_rows_number();
-                const Index next_layers_output_columns = next_layer_pointer->get_outputs_columns_number();
-                const Index next_layers_row_stride = next_layer_pointer->get_row_stride();
-                const Index next_layers_column_stride = next_layer_pointer->get_column_stride();
+    const PoolingLayer* next_pooling_layer = static_cast<PoolingLayer*>(next_layer_back_propagation->layer_pointer);
 
-                // Hidden delta calculation
+    next_pooling_layer->calculate_inputs_derivatives(static_cast<PoolingLayerForwardPropagation*>(next_layer_forward_propagation),
+                                                     static_cast<PoolingLayerBackPropagation*>(next_layer_back_propagation),
+                                                     this_layer_back_propagation->deltas_data);
+}
 
-                Tensor<type, 4> hidden_delta(batch_samples_number, channels_number, output_rows_number, output_columns_number);
 
-                const Index size = hidden_delta.size();
+void PoolingLayer::calculate_hidden_delta_flatten(LayerForwardPropagation* next_layer_forward_propagation,
+                                                  LayerBackPropagation* next_layer_back_propagation,
+                                                  LayerBackPropagation* this_layer_back_propagation) const
+{
+    const Index batch_samples_number = this_layer_back_propagation->batch_samples_number;
 
-                #pragma omp parallel for
+    const Index next_flatten_layer_neurons_number = next_layer_forward_propagation->layer_pointer->get_neurons_number();
 
-                for(Index tensor_index = 0; tensor_index < size; tensor_index++)
-                {
-                    const Index image_index = tensor_index/(channels_number*output_rows_number*output_columns_number);
-                    const Index channel_index = (tensor_index/(output_rows_number*output_columns_number))%channels_number;
-                    const Index row_index = (tensor_index/output_columns_number)%output_rows_number;
-                    const Index column_index = tensor_index%output_columns_number;
+    memcpy(this_layer_back_propagation->deltas_data,
+           next_layer_back_propagation->deltas_data,
+           static_cast<size_t>(batch_samples_number*next_flatten_layer_neurons_number*sizeof(type)));
+}
 
-                    long double sum = 0.0;
 
-                    const Index lower_row_index = (row_index - next_layers_pool_rows)/next_layers_row_stride + 1;
-                    const Index upper_row_index = min(row_index/next_layers_row_stride + 1, next_layers_output_rows);
-                    const Index lower_column_index = (column_index - next_layers_pool_columns)/next_layers_column_stride + 1;
-                    const Index upper_column_index = min(column_index/next_layers_column_stride + 1, next_layers_output_columns);
+/// Calculates the derivatives of the error with respect to the inputs of this layer, from its deltas.
+/// For max pooling, each delta goes to the input which was the maximum of its pool.
+/// For average pooling, each delta is shared out among the inputs of its pool.
+/// The channels are calculated in parallel, since their inputs do not overlap.
+/// @param forward_propagation Forward propagation of this layer, with the indices of the maxima.
+/// @param back_propagation Back propagation of this layer, with the deltas.
+/// @param inputs_derivatives_data Pointer to the inputs derivatives, with dimensions (batch samples, rows, columns, channels).
 
-                    for(Index i = lower_row_index; i < upper_row_index; i++)
-                    {
-                        for(Index j = lower_column_index; j < upper_column_index; j++)
-                        {
-                            const type delta_element = next_layer_delta(image_index, channel_index, i, j);
+void PoolingLayer::calculate_inputs_derivatives(PoolingLayerForwardPropagation* forward_propagation,
+                                                PoolingLayerBackPropagation* back_propagation,
+                                                type* inputs_derivatives_data) const
+{
+    const Index batch_samples_number = back_propagation->batch_samples_number;
 
-                            sum += delta_element;
-                        }
-                    }
+    const Index inputs_rows_number = get_inputs_rows_number();
+    const Index inputs_columns_number = get_inputs_columns_number();
+    const Index channels_number = get_channels_number();
 
-                    hidden_delta(image_index, channel_index, row_index, column_index) = sum;
-                }
+    const Index outputs_rows_number = get_outputs_rows_number();
+    const Index outputs_columns_number = get_outputs_columns_number();
 
-//                return hidden_delta/(next_layers_pool_rows*next_layers_pool_columns);
-            }
+    const Index channel_inputs_number = batch_samples_number*inputs_rows_number*inputs_columns_number;
+    const Index channel_outputs_number = batch_samples_number*outputs_rows_number*outputs_columns_number;
 
-            case opennn::PoolingLayer::PoolingMethod::MaxPooling:
-            {
-                // Current layer's values
+    const type* deltas_data = back_propagation->deltas_data;
+    const Index* maximal_indices_data = forward_propagation->maximal_indices.data();
 
-                const Index images_number = next_layer_delta.dimension(0);
-                const Index channels_number = get_channels_number();
-                const Index output_rows_number = get_outputs_rows_number();
-                const Index output_columns_number = get_outputs_columns_number();
+    if(pooling_method == PoolingMethod::NoPooling)
+    {
+        memcpy(inputs_derivatives_data, deltas_data, static_cast<size_t>(channels_number*channel_outputs_number*sizeof(type)));
 
-                // Next layer's values
+        return;
+    }
 
-                const Index next_layers_pool_rows = next_layer_pointer->get_pool_rows_number();
-                const Index next_layers_pool_columns = next_layer_pointer->get_pool_columns_number();
-                const Index next_layers_output_rows = next_layer_pointer->get_outputs_rows_number();
-                const Index next_layers_output_columns = next_layer_pointer->get_outputs_columns_number();
-                const Index next_layers_row_stride = next_layer_pointer->get_row_stride();
-                const Index next_layers_column_stride = next_layer_pointer->get_column_stride();
+    const type pool_size_inverse = type(1)/type(pool_rows_number*pool_columns_number);
 
-                // Hidden delta calculation
+    const TensorOpCost cost(type(channel_outputs_number*(sizeof(type) + sizeof(Index))),
+                            type(channel_inputs_number*sizeof(type)),
+                            type(channel_outputs_number*pool_rows_number*pool_columns_number));
 
-                Tensor<type, 4> hidden_delta(images_number, channels_number, output_rows_number, output_columns_number);
+    thread_pool_device->parallelFor(channels_number, cost, [&](Index first, Index last)
+    {
+        for(Index channel_index = first; channel_index < last; channel_index++)
+        {
+            fill(inputs_derivatives_data + channel_index*channel_inputs_number,
+                 inputs_derivatives_data + (channel_index + 1)*channel_inputs_number,
+                 type(0));
 
-                const Index size = hidden_delta.size();
+            const type* deltas = deltas_data + channel_index*channel_outputs_number;
 
-                #pragma omp parallel for
+            if(pooling_method == PoolingMethod::MaxPooling)
+            {
+                const Index* maximal_indices = maximal_indices_data + channel_index*channel_outputs_number;
 
-                for(Index tensor_index = 0; tensor_index < size; tensor_index++)
+                for(Index i = 0; i < channel_outputs_number; i++)
                 {
-                    const Index image_index = tensor_index/(channels_number*output_rows_number*output_columns_number);
-                    const Index channel_index = (tensor_index/(output_rows_number*output_columns_number))%channels_number;
-                    const Index row_index = (tensor_index/output_columns_number)%output_rows_number;
-                    const Index column_index = tensor_index%output_columns_number;
+                    inputs_derivatives_data[maximal_indices[i]] += deltas[i];
+                }
 
-                    long double sum = 0.0;
+                continue;
+            }
 
-                    const Index lower_row_index = (row_index - next_layers_pool_rows)/next_layers_row_stride + 1;
-                    const Index upper_row_index = min(row_index/next_layers_row_stride + 1, next_layers_output_rows);
-                    const Index lower_column_index = (column_index - next_layers_pool_columns)/next_layers_column_stride + 1;
-                    const Index upper_column_index = min(column_index/next_layers_column_stride + 1, next_layers_output_columns);
+            for(Index output_column = 0; output_column < outputs_columns_number; output_column++)
+            {
+                for(Index output_row = 0; output_row < outputs_rows_number; output_row++)
+                {
+                    const type* pool_deltas = deltas + batch_samples_number*(output_row + outputs_rows_number*output_column);
 
-                    for(Index i = lower_row_index; i < upper_row_index; i++)
+                    for(Index pool_column = 0; pool_column < pool_columns_number; pool_column++)
                     {
-                        for(Index j = lower_column_index; j < upper_column_index; j++)
-                        {
-                            Tensor<type, 2> activations_current_submatrix(next_layers_pool_rows, next_layers_pool_columns);
-
-                            for(Index submatrix_row_index = 0; submatrix_row_index < next_layers_pool_rows; submatrix_row_index++)
-                            {
-                                for(Index submatrix_column_index = 0; submatrix_column_index < next_layers_pool_columns; submatrix_column_index++)
-                                {
-                                    activations_current_submatrix(submatrix_row_index, submatrix_column_index) =
-                                            activations(image_index, channel_index, i*next_layers_row_stride + submatrix_row_index, j*next_layers_column_stride + submatrix_column_index);
-                                }
-                            }
+                        const Index input_column = output_column*column_stride + pool_column;
 
-                            Tensor<type, 2> multiply_not_multiply(next_layers_pool_rows, next_layers_pool_columns);
+                        for(Index pool_row = 0; pool_row < pool_rows_number; pool_row++)
+                        {
+                            const Index input_row = output_row*row_stride + pool_row;
 
-                            type max_value = activations_current_submatrix(0,0);
+                            type* pool_inputs_derivatives = inputs_derivatives_data
+                                    + batch_samples_number*(input_row + inputs_rows_number*(input_column + inputs_columns_number*channel_index));
 
-                            for(Index submatrix_row_index = 0; submatrix_row_index < next_layers_pool_rows; submatrix_row_index++)
+                            for(Index sample_index = 0; sample_index < batch_samples_number; sample_index++)
                             {
-                                for(Index submatrix_column_index = 0; submatrix_column_index < next_layers_pool_columns; submatrix_column_index++)
-                                {
-                                    if(activations_current_submatrix(submatrix_row_index, submatrix_column_index) > max_value)
-                                    {
-                                        max_value = activations_current_submatrix(submatrix_row_index, submatrix_column_index);
-
-                                        //multiply_not_multiply.resize(next_layers_pool_rows, next_layers_pool_columns, 0.0);
-                                        //multiply_not_multiply(submatrix_row_index, submatrix_column_index) = type(1);
-                                    }
-                                }
+                                pool_inputs_derivatives[sample_index] += pool_deltas[sample_index]*pool_size_inverse;
                             }
-
-                            const type delta_element = next_layer_delta(image_index, channel_index, i, j);
-
-                            const type max_derivative = multiply_not_multiply(row_index - i*next_layers_row_stride, column_index - j*next_layers_column_stride);
-
-                            sum += delta_element*max_derivative;
                         }
                     }
-
-                    hidden_delta(image_index, channel_index, row_index, column_index) = sum;
                 }
-
-                return hidden_delta;
-                break;
             }
         }
-*/
+    });
 }
 
 
@@ -140,7 +140,7 @@ public:
 
     void calculate_hidden_delta(LayerForwardPropagation*,
                                 LayerBackPropagation*,
-                                LayerBackPropagation*) const;
+                                LayerBackPropagation*) const final;
 
     void calculate_hidden_delta_convolutional(LayerForwardPropagation*,
                                 LayerBackPropagation*,
@@ -154,6 +154,10 @@ public:
                                 LayerBackPropagation*,
                                 LayerBackPropagation*) const;
 
+    void calculate_inputs_derivatives(PoolingLayerForwardPropagation*,
+                                      PoolingLayerBackPropagation*,
+                                      type*) const;
+
     // Serialization methods
 
     void from_XML(const tinyxml2::XMLDocument&) final;
@@ -175,9 +179,6 @@ protected:
 
     PoolingMethod pooling_method = PoolingMethod::AveragePooling;
 
-    const Eigen::array<ptrdiff_t, 4> convolution_dimensions = {0, 1, 2, 3}; // For average pooling
-    const Eigen::array<ptrdiff_t, 2> max_pooling_dimensions = {1, 2};
-
 //#ifdef OPENNN_CUDA
 //#include "../../opennn-cuda/opennn-cuda/pooling_layer_cuda.h"
 //#endif
@@ -238,10 +239,6 @@ struct PoolingLayerForwardPropagation : LayerForwardPropagation
 
         const PoolingLayer* pooling_layer_pointer = static_cast<PoolingLayer*>(layer_pointer);
 
-        Index pool_rows_number = pooling_layer_pointer->get_pool_rows_number();
-
-        Index pool_columns_number = pooling_layer_pointer->get_pool_columns_number();
-
         const Index outputs_rows_number = pooling_layer_pointer->get_outputs_rows_number();
 
         const Index outputs_columns_number = pooling_layer_pointer->get_outputs_columns_number();
@@ -254,13 +251,17 @@ struct PoolingLayerForwardPropagation : LayerForwardPropagation
                                      outputs_rows_number,
                                      outputs_columns_number,
                                      channels_number});
-        outputs(0).set_dimensions(output_dimensions);
+        set_buffer_dimensions(outputs(0), output_dimensions);
+
+        // The maximal indices are only needed by the back propagation
 
-        image_patches.resize(batch_samples_number,
-                             pool_rows_number,
-                             pool_columns_number,
-                             outputs_rows_number*outputs_columns_number,
-                             channels_number);
+        if(is_inference)
+            maximal_indices.resize(0, 0, 0, 0);
+        else
+            maximal_indices.resize(batch_samples_number,
+                                   outputs_rows_number,
+                                   outputs_columns_number,
+                                   channels_number);
     }
 
 
@@ -275,11 +276,13 @@ struct PoolingLayerForwardPropagation : LayerForwardPropagation
 
         cout << outputs(0).to_tensor_map<4>() << endl;
 
-        cout << "Image patches" << endl;
-        cout << image_patches << endl;
+        cout << "Maximal indices:" << endl;
+        cout << maximal_indices << endl;
      }
 
-    Tensor<type, 5> image_patches;
+    /// Index in the inputs of the maximum of each pool, for max pooling.
+
+    Tensor<Index, 4> maximal_indices;
 };
 
 
@@ -311,21 +314,16 @@ struct PoolingLayerBackPropagation : LayerBackPropagation
 
         const Index outputs_rows_number = pooling_layer_pointer->get_outputs_rows_number();
         const Index outputs_columns_number = pooling_layer_pointer->get_outputs_columns_number();
+        const Index channels_number = pooling_layer_pointer->get_channels_number();
 
         deltas_dimensions.resize(4);
-/*
+
         deltas_dimensions.setValues({batch_samples_number,
-                                     kernels_number,
                                      outputs_rows_number,
-                                     outputs_columns_number});
-
-        deltas_data = (type*)malloc(static_cast<size_t>(batch_samples_number*kernels_number*outputs_rows_number*outputs_columns_number*sizeof(type)));
+                                     outputs_columns_number,
+                                     channels_number});
 
-        deltas_times_activations_derivatives.resize(batch_samples_number,
-                                                    kernels_number,
-                                                    outputs_rows_number,
-                                                    outputs_columns_number);
-*/
+        deltas_data = (type*)malloc(static_cast<size_t>(batch_samples_number*outputs_rows_number*outputs_columns_number*channels_number*sizeof(type)));
     }
 
 
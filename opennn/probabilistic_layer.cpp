@@ -38,7 +38,7 @@ ProbabilisticLayer::ProbabilisticLayer(const Index& new_inputs_number, const Ind
 
 Index ProbabilisticLayer::get_inputs_number() const
 {
-    return synaptic_weights.dimension(0);
+    return is_quantized() ? quantized_synaptic_weights.inputs_number : synaptic_weights.dimension(0);
 }
 
 
@@ -58,7 +58,7 @@ Index ProbabilisticLayer::get_biases_number() const
 
 Index ProbabilisticLayer::get_synaptic_weights_number() const
 {
-    return synaptic_weights.size();
+    return get_inputs_number()*get_neurons_number();
 }
 
 
@@ -204,7 +204,7 @@ Tensor<type, 2> ProbabilisticLayer::get_synaptic_weights(Tensor<type, 1>& parame
 
 Index ProbabilisticLayer::get_parameters_number() const
 {
-    return biases.size() + synaptic_weights.size();
+    return biases.size() + get_synaptic_weights_number();
 }
 
 
@@ -214,6 +214,10 @@ Index ProbabilisticLayer::get_parameters_number() const
 
 Tensor<type, 1> ProbabilisticLayer::get_parameters() const
 {
+    // The floating point synaptic weights of a quantized layer are recovered from the quantized ones
+
+    const Tensor<type, 2> synaptic_weights = is_quantized() ? quantized_synaptic_weights.dequantize() : this->synaptic_weights;
+
     Tensor<type, 1> parameters(synaptic_weights.size() + biases.size());
 
     memcpy(parameters.data(),
@@ -228,6 +232,8 @@ Tensor<type, 1> ProbabilisticLayer::get_parameters() const
 
 Tensor< TensorMap< Tensor<type, 1>>*, 1> ProbabilisticLayer::get_layer_parameters()
 {
+    dequantize();
+
     Tensor< TensorMap< Tensor<type, 1> >*, 1> layer_parameters(2);
 
     const Index inputs_number = get_inputs_number();
@@ -249,6 +255,9 @@ void ProbabilisticLayer::set()
 
     synaptic_weights.resize(0,0);
 
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.set();
+
     set_default();
 }
 
@@ -263,6 +272,9 @@ void ProbabilisticLayer::set(const Index& new_inputs_number, const Index& new_ne
 
     synaptic_weights.resize(new_inputs_number, new_neurons_number);
 
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.set();
+
     set_parameters_random();
 
     set_default();
@@ -291,6 +303,9 @@ void ProbabilisticLayer::set_inputs_number(const Index& new_inputs_number)
     biases.resize(1, neurons_number);
 
     synaptic_weights.resize(new_inputs_number, neurons_number);
+
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -301,6 +316,9 @@ void ProbabilisticLayer::set_neurons_number(const Index& new_neurons_number)
     biases.resize(1, new_neurons_number);
 
     synaptic_weights.resize(inputs_number, new_neurons_number);
+
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -313,11 +331,16 @@ void ProbabilisticLayer::set_biases(const Tensor<type, 2>& new_biases)
 void ProbabilisticLayer::set_synaptic_weights(const Tensor<type, 2>& new_synaptic_weights)
 {
     synaptic_weights = new_synaptic_weights;
+
+    quantized_synaptic_weights.set();
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
 void ProbabilisticLayer::set_parameters(const Tensor<type, 1>& new_parameters, const Index& index)
 {
+    dequantize();
+
     const Index biases_number = biases.size();
     const Index synaptic_weights_number = synaptic_weights.size();
 
@@ -328,6 +351,8 @@ void ProbabilisticLayer::set_parameters(const Tensor<type, 1>& new_parameters, c
     memcpy(biases.data(),
            new_parameters.data() + index + synaptic_weights_number,
            static_cast<size_t>(biases_number)*sizeof(type));
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -514,13 +539,21 @@ void ProbabilisticLayer::set_biases_constant(const type& value)
 
 void ProbabilisticLayer::set_synaptic_weights_constant(const type& value)
 {
+    dequantize();
+
     synaptic_weights.setConstant(value);
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
 void ProbabilisticLayer::set_synaptic_weights_constant_Glorot()
 {
+    dequantize();
+
     synaptic_weights.setRandom();
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -529,9 +562,13 @@ void ProbabilisticLayer::set_synaptic_weights_constant_Glorot()
 
 void ProbabilisticLayer::set_parameters_constant(const type& value)
 {
+    dequantize();
+
     biases.setConstant(value);
 
     synaptic_weights.setConstant(value);
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
@@ -543,6 +580,8 @@ void ProbabilisticLayer::set_parameters_random()
     const type minimum = type(-0.2);
     const type maximum = type(0.2);
 
+    dequantize();
+
     for(Index i = 0; i < biases.size(); i++)
     {
         const type random = static_cast<type>(rand()/(RAND_MAX+1.0));
@@ -556,11 +595,15 @@ void ProbabilisticLayer::set_parameters_random()
 
         synaptic_weights(i) = minimum + (maximum - minimum)*random;
     }
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
 }
 
 
 void ProbabilisticLayer::insert_parameters(const Tensor<type, 1>& parameters, const Index& )
 {
+    dequantize();
+
     const Index biases_number = get_biases_number();
     const Index synaptic_weights_number = get_synaptic_weights_number();
 
@@ -571,6 +614,73 @@ void ProbabilisticLayer::insert_parameters(const Tensor<type, 1>& parameters, co
     copy(parameters.data() + biases_number,
          parameters.data() + biases_number + synaptic_weights_number,
          synaptic_weights.data());
+
+    reduced_precision_synaptic_weights.update(synaptic_weights);
+}
+
+
+/// Returns true, as probabilistic layers can run inference with 8 bit integer weights.
+
+bool ProbabilisticLayer::is_quantizable() const
+{
+    return true;
+}
+
+
+/// Returns true if the layer runs inference with 8 bit integer weights.
+
+bool ProbabilisticLayer::is_quantized() const
+{
+    return !quantized_synaptic_weights.empty();
+}
+
+
+/// Quantizes the synaptic weights to 8 bit integers with a scale per neuron, which are used for inference.
+/// The floating point weights are released, so that the layer takes a quarter of their memory.
+/// Any change of the parameters, or training, dequantizes the layer.
+/// The layer is saved and loaded with the quantized weights.
+/// @param inputs_range Maximum absolute value of the layer inputs, calibrated on a data sample.
+
+void ProbabilisticLayer::quantize(const type& inputs_range)
+{
+    dequantize();
+
+    quantized_synaptic_weights.set(synaptic_weights, inputs_range);
+
+    synaptic_weights.resize(0, 0);
+}
+
+
+/// Returns the layer to floating point, with the synaptic weights dequantized from the quantized ones.
+/// The quantization error of the weights is not recovered.
+
+void ProbabilisticLayer::dequantize()
+{
+    if(!is_quantized()) return;
+
+    synaptic_weights = quantized_synaptic_weights.dequantize();
+
+    quantized_synaptic_weights.set();
+}
+
+
+/// Returns the precision in which the synaptic weights are stored for inference.
+
+Precision ProbabilisticLayer::get_weights_precision() const
+{
+    return reduced_precision_synaptic_weights.precision;
+}
+
+
+/// Stores the synaptic weights for inference in 16 bits, which halves the memory read by the products of a few samples.
+/// The weights are still trained in single precision, and any change of the parameters stores them again.
+/// Single precision removes the stored weights.
+/// @param new_weights_precision Precision of the stored weights.
+
+void ProbabilisticLayer::set_weights_precision(const Precision& new_weights_precision)
+{
+    reduced_precision_synaptic_weights.set(is_quantized() ? quantized_synaptic_weights.dequantize() : synaptic_weights,
+                                           new_weights_precision);
 }
 
 
@@ -597,15 +707,9 @@ void ProbabilisticLayer::calculate_combinations(const DynamicTensor<type>& input
     const TensorMap<Tensor<type, 2>> inputs_tensor_map = inputs.to_tensor_map<2>();
     TensorMap<Tensor<type, 2>> combinations(outputs_data, batch_samples_number, biases_number);
 
-    Tensor<type, 2> biases_matrix(batch_samples_number, biases_number);
-
-    for(Index i = 0; i < biases_number; i++)
-    {
-        fill_n(biases_matrix.data() + i*batch_samples_number, batch_samples_number, biases(i));
-    }
-
-    combinations.device(*thread_pool_device) = biases_matrix + inputs_tensor_map.contract(synaptic_weights, A_B);
+    combinations.device(*thread_pool_device) = inputs_tensor_map.contract(synaptic_weights, A_B);
 
+    add_biases_activations(biases.data(), outputs_data, batch_samples_number, biases_number, LinearActivation());
 }
 
 
@@ -726,30 +830,17 @@ void ProbabilisticLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>&
 
     const Tensor<Index, 1> outputs_dimensions = probabilistic_layer_forward_propagation->outputs[0].get_dimensions();
 
-    calculate_combinations(inputs(0),
-                           biases,
-                           synaptic_weights,
-                           outputs_data,
-                           outputs_dimensions);
-
-    if(is_training) // Perform training
-    {
-        calculate_activations_derivatives(outputs_data,
-                                          outputs_dimensions,
-                                          outputs_data,
-                                          outputs_dimensions,
-                                          probabilistic_layer_forward_propagation->activations_derivatives.data(),
-                                          outputs_dimensions);
-    }
-    else // perform deploy
-    {
-        calculate_activations(outputs_data,
-                              outputs_dimensions,
-                              outputs_data,
-                              outputs_dimensions);
-    }
-
-
+    type* activations_derivatives_data = is_training
+            ? probabilistic_layer_forward_propagation->activations_derivatives.data()
+            : nullptr;
+
+    calculate_combinations_activations(inputs(0),
+                                       biases,
+                                       synaptic_weights,
+                                       outputs_data,
+                                       outputs_dimensions,
+                                       activations_derivatives_data,
+                                       probabilistic_layer_forward_propagation->quantized_inputs);
 }
 
 
@@ -788,20 +879,94 @@ void ProbabilisticLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>&
 
     const Tensor<Index, 1> outputs_dimensions = probabilistic_layer_forward_propagation->outputs[0].get_dimensions();
 
-    calculate_combinations(inputs(0),
-                           potential_biases,
-                           potential_synaptic_weights,
-                           outputs_data,
-                           outputs_dimensions);
+    calculate_combinations_activations(inputs(0),
+                                       potential_biases,
+                                       potential_synaptic_weights,
+                                       outputs_data,
+                                       outputs_dimensions,
+                                       probabilistic_layer_forward_propagation->activations_derivatives.data(),
+                                       probabilistic_layer_forward_propagation->quantized_inputs);
+}
+
+/// Calculates the activations of the layer, and their derivatives if a pointer for them is given.
+/// For the logistic activation, the biases, the activation and its derivative are applied in a single pass
+/// after the matrix product. The other activations, which combine the neurons of each sample, are applied afterwards.
+/// The matrix product uses the 8 bit integer weights if the layer is quantized, as its floating point weights are released,
+/// or the 16 bit weights if they are stored and the batch is small.
+/// @param inputs Inputs of the layer.
+/// @param biases Biases of the neurons.
+/// @param synaptic_weights Synaptic weights of the neurons.
+/// @param outputs_data Pointer to the memory where the outputs are written.
+/// @param outputs_dimensions Dimensions of the outputs.
+/// @param activations_derivatives_data Pointer to the memory where the derivatives are written, or nullptr.
+/// @param quantized_inputs Memory for the inputs quantized to 8 bit integers.
+
+void ProbabilisticLayer::calculate_combinations_activations(const DynamicTensor<type>& inputs,
+                                                            const Tensor<type, 2>& biases,
+                                                            const Tensor<type, 2>& synaptic_weights,
+                                                            type* outputs_data, const Tensor<Index, 1>& outputs_dimensions,
+                                                            type* activations_derivatives_data,
+                                                            Tensor<int16_t, 2>& quantized_inputs) const
+{
+    const Index batch_samples_number = inputs.get_dimension(0);
+    const Index neurons_number = get_neurons_number();
+
+    const TensorMap<Tensor<type, 2>> inputs_tensor_map = inputs.to_tensor_map<2>();
+    TensorMap<Tensor<type, 2>> combinations(outputs_data, batch_samples_number, neurons_number);
+
+    if(is_quantized() && synaptic_weights.size() == 0)
+    {
+        quantized_synaptic_weights.multiply(inputs_tensor_map, quantized_inputs, outputs_data);
+    }
+    else if(!activations_derivatives_data && reduced_precision_synaptic_weights.is_faster(batch_samples_number))
+    {
+        reduced_precision_synaptic_weights.multiply(inputs_tensor_map, outputs_data);
+    }
+    else
+    {
+        combinations.device(*thread_pool_device) = inputs_tensor_map.contract(synaptic_weights, A_B);
+    }
+
+    if(activation_function != ActivationFunction::Logistic)
+    {
+        add_biases_activations(biases.data(), outputs_data, batch_samples_number, neurons_number, LinearActivation());
+
+        if(activations_derivatives_data)
+        {
+            calculate_activations_derivatives(outputs_data, outputs_dimensions,
+                                              outputs_data, outputs_dimensions,
+                                              activations_derivatives_data, outputs_dimensions);
+        }
+        else
+        {
+            calculate_activations(outputs_data, outputs_dimensions,
+                                  outputs_data, outputs_dimensions);
+        }
 
-    calculate_activations_derivatives(outputs_data,
-                                      outputs_dimensions,
-                                      outputs_data,
-                                      outputs_dimensions,
-                                      probabilistic_layer_forward_propagation->activations_derivatives.data(),
-                                      outputs_dimensions);
+        return;
+    }
+
+    if(fast_activations && activations_derivatives_data)
+    {
+        add_biases_activations_derivatives(biases.data(), outputs_data, activations_derivatives_data,
+                                           batch_samples_number, neurons_number, FastLogisticActivation());
+    }
+    else if(fast_activations)
+    {
+        add_biases_activations(biases.data(), outputs_data, batch_samples_number, neurons_number, FastLogisticActivation());
+    }
+    else if(activations_derivatives_data)
+    {
+        add_biases_activations_derivatives(biases.data(), outputs_data, activations_derivatives_data,
+                                           batch_samples_number, neurons_number, LogisticActivation());
+    }
+    else
+    {
+        add_biases_activations(biases.data(), outputs_data, batch_samples_number, neurons_number, LogisticActivation());
+    }
 }
 
+
 // Gradient methods
 
 void ProbabilisticLayer::calculate_error_gradient(type* inputs_data,
@@ -1082,25 +1247,49 @@ void ProbabilisticLayer::write_XML(tinyxml2::XMLPrinter& file_stream) const
 
     file_stream.CloseElement();
 
-    // Parameters
+    // Parameters, or biases and quantized synaptic weights, which take less space than the floating point ones
 
-    file_stream.OpenElement("Parameters");
+    if(is_quantized())
+    {
+        file_stream.OpenElement("Biases");
 
-    buffer.str("");
+        buffer.str("");
 
-    const Tensor<type, 1> parameters = get_parameters();
-    const Index parameters_size = parameters.size();
+        const Index biases_number = biases.size();
 
-    for(Index i = 0; i < parameters_size; i++)
-    {
-        buffer << parameters(i);
+        for(Index i = 0; i < biases_number; i++)
+        {
+            buffer << biases(i);
 
-        if(i != (parameters_size-1)) buffer << " ";
+            if(i != (biases_number-1)) buffer << " ";
+        }
+
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+
+        quantized_synaptic_weights.write_XML(file_stream);
     }
+    else
+    {
+        file_stream.OpenElement("Parameters");
 
-    file_stream.PushText(buffer.str().c_str());
+        buffer.str("");
 
-    file_stream.CloseElement();
+        const Tensor<type, 1> parameters = get_parameters();
+        const Index parameters_size = parameters.size();
+
+        for(Index i = 0; i < parameters_size; i++)
+        {
+            buffer << parameters(i);
+
+            if(i != (parameters_size-1)) buffer << " ";
+        }
+
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+    }
 
     // Decision threshold
 
@@ -1199,11 +1388,15 @@ void ProbabilisticLayer::from_XML(const tinyxml2::XMLDocument& document)
         set_activation_function(activation_function_element->GetText());
     }
 
-    // Parameters
+    // Parameters, or biases and quantized synaptic weights
 
     const tinyxml2::XMLElement* parameters_element = probabilistic_layer_element->FirstChildElement("Parameters");
 
-    if(!parameters_element)
+    const tinyxml2::XMLElement* biases_element = probabilistic_layer_element->FirstChildElement("Biases");
+
+    const tinyxml2::XMLElement* quantized_synaptic_weights_element = probabilistic_layer_element->FirstChildElement("QuantizedSynapticWeights");
+
+    if(!parameters_element && (!biases_element || !quantized_synaptic_weights_element))
     {
         buffer << "OpenNN Exception: ProbabilisticLayer class.\n"
                << "void from_XML(const tinyxml2::XMLDocument&) method.\n"
@@ -1212,12 +1405,37 @@ void ProbabilisticLayer::from_XML(const tinyxml2::XMLDocument& document)
         throw invalid_argument(buffer.str());
     }
 
-    if(parameters_element->GetText())
+    if(parameters_element && parameters_element->GetText())
     {
         const string parameters_string = parameters_element->GetText();
 
         set_parameters(to_type_vector(parameters_string, ' '));
     }
+    else if(!parameters_element)
+    {
+        const Tensor<type, 1> new_biases = biases_element->GetText()
+                ? to_type_vector(biases_element->GetText(), ' ')
+                : Tensor<type, 1>();
+
+        if(new_biases.size() != biases.size())
+        {
+            buffer << "OpenNN Exception: ProbabilisticLayer class.\n"
+                   << "void from_XML(const tinyxml2::XMLDocument&) method.\n"
+                   << "Number of biases (" << new_biases.size() << ") must be " << biases.size() << ".\n";
+
+            throw invalid_argument(buffer.str());
+        }
+
+        copy(new_biases.data(), new_biases.data() + new_biases.size(), biases.data());
+
+        // The layer stays quantized, without floating point synaptic weights
+
+        quantized_synaptic_weights.from_XML(quantized_synaptic_weights_element, get_inputs_number(), get_neurons_number());
+
+        synaptic_weights.resize(0, 0);
+
+        reduced_precision_synaptic_weights.set();
+    }
 
     // Decision threshold
 
@@ -1349,6 +1567,8 @@ string ProbabilisticLayer::write_combinations(const Tensor<string, 1>& inputs_na
     const Index inputs_number = get_inputs_number();
     const Index neurons_number = get_neurons_number();
 
+    const Tensor<type, 2> synaptic_weights = is_quantized() ? quantized_synaptic_weights.dequantize() : this->synaptic_weights;
+
     for(Index i = 0; i < neurons_number; i++)
     {
         buffer << "probabilistic_layer_combinations_" << to_string(i) << " = " << biases(i);
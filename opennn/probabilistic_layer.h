@@ -26,6 +26,8 @@
 
 #include "opennn_strings.h"
 
+#include "quantization.h"
+
 
 namespace opennn
 {
@@ -128,6 +130,20 @@ public:
 
    void insert_parameters(const Tensor<type, 1>&, const Index&);
 
+   // Quantization
+
+   bool is_quantizable() const final;
+   bool is_quantized() const final;
+
+   void quantize(const type&) final;
+   void dequantize() final;
+
+   // Reduced precision
+
+   Precision get_weights_precision() const final;
+
+   void set_weights_precision(const Precision&) final;
+
    // Combinations
 
    void calculate_combinations(const DynamicTensor<type>&,
@@ -144,6 +160,13 @@ public:
                                           type*, const Tensor<Index, 1>&,
                                           type*, const Tensor<Index, 1>&) const;
 
+   void calculate_combinations_activations(const DynamicTensor<type>&,
+                                           const Tensor<type, 2>&,
+                                           const Tensor<type, 2>&,
+                                           type*, const Tensor<Index, 1>&,
+                                           type*,
+                                           Tensor<int16_t, 2>&) const;
+
    // Outputs
 
    void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, LayerForwardPropagation*, const bool&) final;
@@ -197,9 +220,18 @@ protected:
    Tensor<type, 2> biases;
 
    /// This matrix contains conection strengths from a layer's inputs to its neurons.
+   /// It is empty while the layer is quantized.
 
    Tensor<type, 2> synaptic_weights;
 
+   /// Synaptic weights quantized to 8 bit integers for inference, empty if the layer is not quantized.
+
+   QuantizedSynapticWeights quantized_synaptic_weights;
+
+   /// Synaptic weights stored in 16 bits for inference, empty if the weights precision is single.
+
+   ReducedPrecisionSynapticWeights reduced_precision_synaptic_weights;
+
    /// Activation function variable.
 
    ActivationFunction activation_function = ActivationFunction::Logistic;
@@ -249,11 +281,14 @@ struct ProbabilisticLayerForwardPropagation : LayerForwardPropagation
         outputs.resize(1);
         Tensor<Index, 1> output_dimensions(2);
         output_dimensions.setValues({batch_samples_number, neurons_number});
-        outputs(0).set_dimensions(output_dimensions);
+        set_buffer_dimensions(outputs(0), output_dimensions);
 
         // Rest of quantities
 
-        activations_derivatives.resize(batch_samples_number, neurons_number, neurons_number);
+        if(is_inference)
+            activations_derivatives.resize(0, 0, 0);
+        else
+            activations_derivatives.resize(batch_samples_number, neurons_number, neurons_number);
     }
 
 
@@ -270,6 +305,10 @@ struct ProbabilisticLayerForwardPropagation : LayerForwardPropagation
     }
 
     Tensor<type, 3> activations_derivatives;
+
+    /// Inputs quantized to 8 bit integers, for the product with the quantized synaptic weights.
+
+    Tensor<int16_t, 2> quantized_inputs;
 };
 
 
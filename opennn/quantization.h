@@ -0,0 +1,383 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   Q U A N T I Z A T I O N   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef QUANTIZATION_H
+#define QUANTIZATION_H
+
+// System includes
+
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <sstream>
+
+// OpenNN includes
+
+#include "config.h"
+#include "tinyxml2.h"
+
+namespace opennn
+{
+
+// Post-training quantization of the synaptic weights of a layer to 8 bit integers.
+// Weights are quantized symmetrically with a scale per neuron (output channel), and inputs with a single scale
+// calibrated from the range of the layer inputs on a data sample.
+// The products of the quantized inputs and weights are accumulated in 32 bit integers,
+// which are exact for up to 2^31/127^2 = 133143 inputs, and then multiplied by both scales.
+// Only perceptron and probabilistic layers are quantized.
+// Convolutional, long short-term memory, recurrent and attention layers are not supported, and always run in floating point.
+
+/// Synaptic weights quantized to 8 bit integers, with a scale per neuron, and the scale of the inputs of the layer.
+
+struct QuantizedSynapticWeights
+{
+    /// Quantizes the synaptic weights of a layer.
+    /// @param synaptic_weights Synaptic weights, with dimensions inputs number and neurons number.
+    /// @param inputs_range Maximum absolute value of the inputs of the layer, calibrated on a data sample.
+
+    void set(const Tensor<type, 2>& synaptic_weights, const type& inputs_range)
+    {
+        resize(synaptic_weights.dimension(0), synaptic_weights.dimension(1));
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            type maximum = type(0);
+
+            for(Index i = 0; i < inputs_number; i++)
+                maximum = max(maximum, abs(synaptic_weights(i, j)));
+
+            weights_scales(j) = maximum > type(0) ? maximum/type(127) : type(1);
+
+            for(Index i = 0; i < inputs_number; i++)
+                weights(i, j) = quantize(synaptic_weights(i, j), weights_scales(j));
+        }
+
+        inputs_scale = inputs_range > type(0) ? inputs_range/type(127) : type(1);
+    }
+
+
+    /// Removes the quantized weights.
+
+    void set()
+    {
+        inputs_number = 0;
+        neurons_number = 0;
+
+        weights.resize(0, 0);
+        weights_scales.resize(0);
+
+        inputs_scale = type(1);
+    }
+
+
+    /// Returns true if there are no quantized weights.
+
+    bool empty() const
+    {
+        return weights.size() == 0;
+    }
+
+
+    /// Returns the nearest 8 bit integer to a value divided by a scale, saturated to [-127, 127].
+
+    static int8_t quantize(const type& value, const type& scale)
+    {
+        const type quantized_value = nearbyint(value/scale);
+
+        return static_cast<int8_t>(min(max(quantized_value, type(-127)), type(127)));
+    }
+
+
+    /// Returns the weights dequantized back to floating point, with dimensions inputs number and neurons number.
+
+    Tensor<type, 2> dequantize() const
+    {
+        Tensor<type, 2> synaptic_weights(inputs_number, neurons_number);
+
+        for(Index j = 0; j < neurons_number; j++)
+            for(Index i = 0; i < inputs_number; i++)
+                synaptic_weights(i, j) = type(weights(i, j))*weights_scales(j);
+
+        return synaptic_weights;
+    }
+
+
+    /// Calculates the product of the inputs and the synaptic weights with 8 bit integers and 32 bit accumulation.
+    /// Inputs out of the calibrated range are saturated.
+    /// The weights of each block of neurons are widened to 16 bits into a buffer of the thread,
+    /// for which compilers emit multiply-add instructions, and are then used for all the samples.
+    /// @param inputs Inputs, with dimensions batch samples number and inputs number.
+    /// @param quantized_inputs Memory for the quantized inputs, from the forward propagation of the layer.
+    /// It is only resized when the batch samples number changes.
+    /// @param combinations_data Products, with dimensions batch samples number and neurons number.
+
+    void multiply(const TensorMap<Tensor<type, 2>>& inputs, Tensor<int16_t, 2>& quantized_inputs, type* combinations_data) const
+    {
+        const Index batch_samples_number = inputs.dimension(0);
+
+        // Quantized inputs are stored by samples, padded to whole blocks, so that the inputs of each sample are contiguous
+
+        const Index padded_samples_number = (batch_samples_number + block_size - 1)/block_size*block_size;
+
+        if(quantized_inputs.dimension(0) != inputs_number || quantized_inputs.dimension(1) != padded_samples_number)
+        {
+            quantized_inputs.resize(inputs_number, padded_samples_number);
+            quantized_inputs.setZero();
+        }
+
+        for(Index i = 0; i < inputs_number; i++)
+            for(Index k = 0; k < batch_samples_number; k++)
+                quantized_inputs(i, k) = quantize(inputs(k, i), inputs_scale);
+
+        const int16_t* quantized_inputs_data = quantized_inputs.data();
+
+        // Each thread calculates blocks of 4 samples and 4 neurons, so that every input and weight loaded is used 4 times
+
+        #pragma omp parallel
+        {
+            Tensor<int16_t, 2> block_weights(inputs_number, block_size);
+
+            #pragma omp for
+            for(Index j = 0; j < neurons_number; j += block_size)
+            {
+                const Index block_neurons_number = min(block_size, neurons_number - j);
+
+                const int8_t* neurons_weights = weights.data() + j*inputs_number;
+
+                int16_t* block_weights_data = block_weights.data();
+
+                for(Index i = 0; i < block_size*inputs_number; i++)
+                    block_weights_data[i] = neurons_weights[i];
+
+                const int16_t* weights_0 = block_weights_data;
+                const int16_t* weights_1 = weights_0 + inputs_number;
+                const int16_t* weights_2 = weights_1 + inputs_number;
+                const int16_t* weights_3 = weights_2 + inputs_number;
+
+                for(Index k = 0; k < batch_samples_number; k += block_size)
+                {
+                    const int16_t* inputs_0 = quantized_inputs_data + k*inputs_number;
+                    const int16_t* inputs_1 = inputs_0 + inputs_number;
+                    const int16_t* inputs_2 = inputs_1 + inputs_number;
+                    const int16_t* inputs_3 = inputs_2 + inputs_number;
+
+                    int32_t sums[block_size][block_size] = {};
+
+                    for(Index i = 0; i < inputs_number; i++)
+                    {
+                        const int32_t input_0 = inputs_0[i];
+                        const int32_t input_1 = inputs_1[i];
+                        const int32_t input_2 = inputs_2[i];
+                        const int32_t input_3 = inputs_3[i];
+
+                        const int32_t weight_0 = weights_0[i];
+                        const int32_t weight_1 = weights_1[i];
+                        const int32_t weight_2 = weights_2[i];
+                        const int32_t weight_3 = weights_3[i];
+
+                        sums[0][0] += input_0*weight_0; sums[0][1] += input_0*weight_1; sums[0][2] += input_0*weight_2; sums[0][3] += input_0*weight_3;
+                        sums[1][0] += input_1*weight_0; sums[1][1] += input_1*weight_1; sums[1][2] += input_1*weight_2; sums[1][3] += input_1*weight_3;
+                        sums[2][0] += input_2*weight_0; sums[2][1] += input_2*weight_1; sums[2][2] += input_2*weight_2; sums[2][3] += input_2*weight_3;
+                        sums[3][0] += input_3*weight_0; sums[3][1] += input_3*weight_1; sums[3][2] += input_3*weight_2; sums[3][3] += input_3*weight_3;
+                    }
+
+                    const Index block_samples_number = min(block_size, batch_samples_number - k);
+
+                    for(Index l = 0; l < block_neurons_number; l++)
+                    {
+                        const type scale = inputs_scale*weights_scales(j + l);
+
+                        for(Index m = 0; m < block_samples_number; m++)
+                            combinations_data[k + m + batch_samples_number*(j + l)] = type(sums[m][l])*scale;
+                    }
+                }
+            }
+        }
+    }
+
+
+    /// Writes the scale of the inputs, the scales of the weights and the quantized weights, as integers.
+
+    void write_XML(tinyxml2::XMLPrinter& file_stream) const
+    {
+        ostringstream buffer;
+
+        file_stream.OpenElement("QuantizedSynapticWeights");
+
+        // Inputs scale
+
+        file_stream.OpenElement("InputsScale");
+
+        buffer << setprecision(9) << inputs_scale;
+
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+
+        // Weights scales
+
+        file_stream.OpenElement("WeightsScales");
+
+        buffer.str("");
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            buffer << weights_scales(j);
+
+            if(j != neurons_number - 1) buffer << " ";
+        }
+
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+
+        // Weights
+
+        file_stream.OpenElement("Weights");
+
+        buffer.str("");
+
+        for(Index j = 0; j < neurons_number; j++)
+            for(Index i = 0; i < inputs_number; i++)
+            {
+                buffer << int(weights(i, j));
+
+                if(i != inputs_number - 1 || j != neurons_number - 1) buffer << " ";
+            }
+
+        file_stream.PushText(buffer.str().c_str());
+
+        file_stream.CloseElement();
+
+        file_stream.CloseElement();
+    }
+
+
+    /// Loads quantized weights written by write_XML().
+    /// @param quantized_synaptic_weights_element QuantizedSynapticWeights element.
+    /// @param new_inputs_number Number of inputs of the layer.
+    /// @param new_neurons_number Number of neurons of the layer.
+
+    void from_XML(const tinyxml2::XMLElement* quantized_synaptic_weights_element,
+                  const Index& new_inputs_number,
+                  const Index& new_neurons_number)
+    {
+        const tinyxml2::XMLElement* inputs_scale_element = quantized_synaptic_weights_element->FirstChildElement("InputsScale");
+        const tinyxml2::XMLElement* weights_scales_element = quantized_synaptic_weights_element->FirstChildElement("WeightsScales");
+        const tinyxml2::XMLElement* weights_element = quantized_synaptic_weights_element->FirstChildElement("Weights");
+
+        if(!inputs_scale_element || !weights_scales_element || !weights_element
+        || !inputs_scale_element->GetText() || !weights_scales_element->GetText() || !weights_element->GetText())
+        {
+            ostringstream buffer;
+
+            buffer << "OpenNN Exception: QuantizedSynapticWeights struct.\n"
+                   << "void from_XML(const tinyxml2::XMLElement*, const Index&, const Index&) method.\n"
+                   << "InputsScale, WeightsScales and Weights elements are required.\n";
+
+            throw invalid_argument(buffer.str());
+        }
+
+        resize(new_inputs_number, new_neurons_number);
+
+        inputs_scale = type(stod(inputs_scale_element->GetText()));
+
+        istringstream weights_scales_stream(weights_scales_element->GetText());
+        istringstream weights_stream(weights_element->GetText());
+
+        bool read = true;
+
+        int weight = 0;
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            read = read && (weights_scales_stream >> weights_scales(j));
+
+            for(Index i = 0; i < inputs_number; i++)
+            {
+                read = read && (weights_stream >> weight) && abs(weight) <= 127;
+
+                weights(i, j) = static_cast<int8_t>(weight);
+            }
+        }
+
+        if(!read)
+        {
+            set();
+
+            ostringstream buffer;
+
+            buffer << "OpenNN Exception: QuantizedSynapticWeights struct.\n"
+                   << "void from_XML(const tinyxml2::XMLElement*, const Index&, const Index&) method.\n"
+                   << "Number of weights must be " << new_inputs_number*new_neurons_number
+                   << ", number of weights scales must be " << new_neurons_number
+                   << " and weights must be between -127 and 127.\n";
+
+            throw invalid_argument(buffer.str());
+        }
+    }
+
+
+    /// Number of samples and of neurons in each block of the product.
+
+    static constexpr Index block_size = 4;
+
+    Index inputs_number = 0;
+    Index neurons_number = 0;
+
+    /// Quantized synaptic weights, with dimensions inputs number and neurons number padded to whole blocks.
+    /// Padding neurons are zero.
+
+    Tensor<int8_t, 2> weights;
+
+    /// Scale of the weights of each neuron.
+
+    Tensor<type, 1> weights_scales;
+
+    /// Scale of the inputs.
+
+    type inputs_scale = type(1);
+
+
+    /// Allocates zero weights for a number of inputs and neurons.
+
+    void resize(const Index& new_inputs_number, const Index& new_neurons_number)
+    {
+        inputs_number = new_inputs_number;
+        neurons_number = new_neurons_number;
+
+        const Index padded_neurons_number = (neurons_number + block_size - 1)/block_size*block_size;
+
+        weights.resize(inputs_number, padded_neurons_number);
+        weights.setZero();
+
+        weights_scales.resize(neurons_number);
+    }
+};
+
+}
+
+#endif // QUANTIZATION_H
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright(C) 2005-2023 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -79,6 +79,15 @@ Index RecurrentLayer::get_timesteps() const
 }
 
 
+/// Returns the number of timesteps through which the errors are back propagated,
+/// or zero if they are back propagated through the whole sequences.
+
+Index RecurrentLayer::get_truncation_length() const
+{
+    return truncation_length;
+}
+
+
 /// Returns the biases from all the recurrent neurons in the layer.
 /// The format is a vector of real values.
 /// The size of this vector is the number of neurons in the layer.
@@ -373,6 +382,17 @@ void RecurrentLayer::set_timesteps(const Index& new_timesteps)
 }
 
 
+/// Sets the number of timesteps through which the errors are back propagated.
+/// The errors are not back propagated from one piece of that length to the previous one,
+/// while the hidden states still are propagated forward through the whole sequences.
+/// @param new_truncation_length New truncation length, or zero to back propagate through the whole sequences.
+
+void RecurrentLayer::set_truncation_length(const Index& new_truncation_length)
+{
+    truncation_length = new_truncation_length;
+}
+
+
 void RecurrentLayer::set_biases(const Tensor<type, 1>& new_biases)
 {
     biases = new_biases;
@@ -609,6 +629,7 @@ void RecurrentLayer::calculate_combinations(const Tensor<type, 1>& inputs,
                                             const Tensor<type, 2>& input_weights,
                                             const Tensor<type, 2>& recurrent_weights,
                                             const Tensor<type, 1>& biases,
+                                            const Tensor<type, 1>& hidden_states,
                                             Tensor<type, 1>& combinations) const
 {   
     combinations.device(*thread_pool_device) = inputs.contract(input_weights, AT_B);
@@ -619,40 +640,32 @@ void RecurrentLayer::calculate_combinations(const Tensor<type, 1>& inputs,
 }
 
 
-void RecurrentLayer::calculate_activations(Tensor<type, 1>& combinations_1d,
-                                           Tensor<type, 1>& activations_1d) const
+void RecurrentLayer::calculate_activations(type* combinations_data, const Tensor<Index, 1>& combinations_dimensions,
+                                           type* activations_data, const Tensor<Index, 1>& activations_dimensions) const
 {
-#ifdef OPENNN_DEBUG
-    check_size(combinations_1d, get_neurons_number(), LOG);
-    check_size(activations_1d, get_neurons_number(), LOG);
-#endif
-
-    Tensor<Index, 1> combinations_dimensions = get_dimensions(combinations_1d);
-    Tensor<Index, 1> activations_dimensions = get_dimensions(activations_1d);
-
     switch(activation_function)
     {
-        case ActivationFunction::Linear:  linear(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::Linear:  linear(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::Logistic: logistic(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::Logistic: logistic(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::HyperbolicTangent: hyperbolic_tangent(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::HyperbolicTangent: hyperbolic_tangent(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::Threshold: threshold(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::Threshold: threshold(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::SymmetricThreshold: symmetric_threshold(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::SymmetricThreshold: symmetric_threshold(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::RectifiedLinear: rectified_linear(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::RectifiedLinear: rectified_linear(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::ScaledExponentialLinear: scaled_exponential_linear(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::ScaledExponentialLinear: scaled_exponential_linear(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::SoftPlus: soft_plus(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::SoftPlus: soft_plus(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::SoftSign: soft_sign(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::SoftSign: soft_sign(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::HardSigmoid: hard_sigmoid(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::HardSigmoid: hard_sigmoid(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
-        case ActivationFunction::ExponentialLinear: exponential_linear(combinations_1d.data(), combinations_dimensions, activations_1d.data(), activations_dimensions); return;
+        case ActivationFunction::ExponentialLinear: exponential_linear(combinations_data, combinations_dimensions, activations_data, activations_dimensions); return;
 
         default: return;
     }
@@ -664,7 +677,9 @@ Tensor<type, 1> RecurrentLayer::get_activations(const Tensor<type,1>& combinatio
     Tensor<type, 1> combinations_copy(combinations);
     Tensor<type, 1> activations(combinations);
 
-    calculate_activations(combinations_copy, activations);
+    const Tensor<Index, 1> dimensions = get_dimensions(activations);
+
+    calculate_activations(combinations_copy.data(), dimensions, activations.data(), dimensions);
 
     return activations;
 }
@@ -734,159 +749,174 @@ void RecurrentLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inp
                                        LayerForwardPropagation* forward_propagation,
                                        const bool& is_training)
 {
-#ifdef OPENNN_DEBUG
-    if(inputs_dimensions(1) != get_inputs_number())
+    if(inputs(0).get_dimensions().size() != 2)
     {
         ostringstream buffer;
 
-        buffer << "OpenNN Exception: PerceptronLayer class.\n"
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, LayerForwardPropagation*) final method.\n"
-               << "Inputs columns number must be equal to " << get_inputs_number() << ", (inputs number).\n";
+        buffer << "OpenNN Exception: RecurrentLayer class.\n"
+               << "void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, LayerForwardPropagation*, const bool&) final.\n"
+               << "Inputs rank must be equal to 2.\n";
 
         throw invalid_argument(buffer.str());
     }
 
-    if(inputs_dimensions(0).size() != 2)
-    {
-        ostringstream buffer;
+    const Index inputs_number = get_inputs_number();
+    const Index neurons_number = get_neurons_number();
 
-        buffer << "OpenNN Exception: RecurrentLayer class.\n"
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, LayerForwardPropagation*) final.\n"
-               << "Inputs rank must be equal to 2.\n";
+    forward_propagate_sequences(inputs(0).to_tensor_map<2>(),
+                                TensorMap<Tensor<type, 1>>(biases.data(), neurons_number),
+                                TensorMap<Tensor<type, 2>>(input_weights.data(), inputs_number, neurons_number),
+                                TensorMap<Tensor<type, 2>>(recurrent_weights.data(), neurons_number, neurons_number),
+                                static_cast<RecurrentLayerForwardPropagation*>(forward_propagation),
+                                is_training);
+}
 
-        throw invalid_argument(buffer.str());
-    }
 
-    if(inputs_dimensions(1) != get_inputs_number())
+void RecurrentLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
+                                       Tensor<type, 1>&parameters,
+                                       LayerForwardPropagation* forward_propagation)
+{
+    if(inputs(0).get_dimensions().size() != 2)
     {
         ostringstream buffer;
 
         buffer << "OpenNN Exception: RecurrentLayer class.\n"
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, LayerForwardPropagation*) final.\n"
-               << "Inputs columns number must be equal to " << get_inputs_number() << ".\n";
+               << "void forward_propagate(type*, const Tensor<Index, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final.\n"
+               << "Inputs rank must be equal to 2.\n";
 
         throw invalid_argument(buffer.str());
     }
 
-#endif
+    const Index neurons_number = get_neurons_number();
+    const Index inputs_number = get_inputs_number();
 
-    RecurrentLayerForwardPropagation* recurrent_layer_forward_propagation = static_cast<RecurrentLayerForwardPropagation*>(forward_propagation);
+    forward_propagate_sequences(inputs(0).to_tensor_map<2>(),
+                                TensorMap<Tensor<type, 1>>(parameters.data(), neurons_number),
+                                TensorMap<Tensor<type, 2>>(parameters.data() + neurons_number, inputs_number, neurons_number),
+                                TensorMap<Tensor<type, 2>>(parameters.data() + neurons_number + inputs_number*neurons_number, neurons_number, neurons_number),
+                                static_cast<RecurrentLayerForwardPropagation*>(forward_propagation),
+                                true);
+}
 
-    const TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
 
-    const Index samples_number = inputs(0).get_dimension(0);
+/// Calculates the outputs of the layer for a batch of sequences.
+/// The samples of the batch are consecutive sequences of timesteps samples, and the last one might be shorter.
+/// In an incremental forward propagation, each sample is instead the next timestep of its own sequence,
+/// which starts from the hidden states of the previous forward propagation.
+/// The inputs of all the samples are combined with the input weights in a single matrix product.
+/// Then, for each timestep, the hidden states of all the sequences are combined with the recurrent weights
+/// in a single matrix product, instead of a vector product for each sample.
+/// @param inputs Inputs of the batch, with a row for each sample.
+/// @param biases Biases of the neurons.
+/// @param input_weights Weights from the inputs to the neurons.
+/// @param recurrent_weights Weights from the hidden states to the neurons.
+/// @param forward_propagation Forward propagation of the layer, where the outputs and the combinations are written.
+/// @param is_training True to write the activations derivatives too.
+
+void RecurrentLayer::forward_propagate_sequences(const TensorMap<Tensor<type, 2>>& inputs,
+                                                 const TensorMap<Tensor<type, 1>>& biases,
+                                                 const TensorMap<Tensor<type, 2>>& input_weights,
+                                                 const TensorMap<Tensor<type, 2>>& recurrent_weights,
+                                                 RecurrentLayerForwardPropagation* forward_propagation,
+                                                 const bool& is_training)
+{
+    const Index samples_number = inputs.dimension(0);
     const Index neurons_number = get_neurons_number();
 
-    TensorMap<Tensor<type, 2>> inputs_map = inputs(0).to_tensor_map<2>();
+    const Index sequence_timesteps = forward_propagation->is_incremental ? 1 : timesteps;
 
-    Tensor<Index, 1> combinations_dimensions;
-    Tensor<Index, 1> activations_dimensions;
-    Tensor<Index, 1> activations_derivatives_dimensions;
+    const Index sequences_number = (samples_number + sequence_timesteps - 1)/sequence_timesteps;
 
-    for(Index i = 0; i < samples_number; i++)
+    if(forward_propagation->hidden_states.dimension(0) != sequences_number)
     {
-        if(i%timesteps == 0) hidden_states.setZero();
-
-        recurrent_layer_forward_propagation->current_inputs = inputs_map.chip(i, 0);
+        forward_propagation->set_sequences_number(sequences_number);
+    }
 
-        calculate_combinations(recurrent_layer_forward_propagation->current_inputs,
-                               input_weights,
-                               recurrent_weights,
-                               biases,
-                               recurrent_layer_forward_propagation->current_combinations);
+    Tensor<type, 2>& hidden_states = forward_propagation->hidden_states;
 
-        combinations_dimensions = get_dimensions(recurrent_layer_forward_propagation->current_combinations);
-        activations_dimensions = get_dimensions(hidden_states);
-        activations_derivatives_dimensions = get_dimensions(recurrent_layer_forward_propagation->current_activations_derivatives);
+    Tensor<type, 2>& current_combinations = forward_propagation->current_combinations;
+    Tensor<type, 2>& current_activations_derivatives = forward_propagation->current_activations_derivatives;
 
-        if(is_training)
-        {
-            calculate_activations_derivatives(recurrent_layer_forward_propagation->current_combinations.data(),
-                                              combinations_dimensions,
-                                              hidden_states.data(),
-                                              activations_dimensions,
-                                              recurrent_layer_forward_propagation->current_activations_derivatives.data(),
-                                              activations_derivatives_dimensions);
-       }
-       else // Perform deploy
-       {
-            calculate_activations(recurrent_layer_forward_propagation->current_combinations, hidden_states);
-       }
-
-        for(Index j = 0; j < neurons_number; j++)
-        {
-            recurrent_layer_forward_propagation->combinations(i,j) = recurrent_layer_forward_propagation->current_combinations(j);
+    TensorMap<Tensor<type, 2>> combinations = forward_propagation->combinations.to_tensor_map<2>();
+    Tensor<type, 2>& activations_derivatives = forward_propagation->activations_derivatives;
 
-            outputs(i,j) = hidden_states(j);
+    TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
 
-            recurrent_layer_forward_propagation->activations_derivatives(i,j) = recurrent_layer_forward_propagation->current_activations_derivatives(j);
-        }
+    if(is_training)
+    {
+        copy(recurrent_weights.data(),
+             recurrent_weights.data() + recurrent_weights.size(),
+             forward_propagation->recurrent_weights.data());
     }
-}
 
+    // Inputs combinations of all the samples
 
-void RecurrentLayer::forward_propagate(const Tensor<DynamicTensor<type>, 1>& inputs,
-                                       Tensor<type, 1>&parameters,
-                                       LayerForwardPropagation* forward_propagation)
-{
-    RecurrentLayerForwardPropagation* recurrent_layer_forward_propagation
-            = static_cast<RecurrentLayerForwardPropagation*>(forward_propagation);
+    combinations.device(*thread_pool_device) = inputs.contract(input_weights, A_B);
 
-    if(inputs(0).get_dimensions().size() != 2)
-    {
-        ostringstream buffer;
+    add_biases_activations(biases.data(), combinations.data(), samples_number, neurons_number, LinearActivation());
 
-        buffer << "OpenNN Exception: RecurrentLayer class.\n"
-               << "void forward_propagate(type*, const Tensor<Index, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final.\n"
-               << "Inputs rank must be equal to 2.\n";
+    const Tensor<Index, 1> states_dimensions = get_dimensions(hidden_states);
 
-        throw invalid_argument(buffer.str());
-    }
+    for(Index timestep = 0; timestep < sequence_timesteps; timestep++)
+    {
+        // The last sequence might not have this timestep
 
-    const TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
+        const Index current_sequences_number = (samples_number - timestep + sequence_timesteps - 1)/sequence_timesteps;
 
-    const Index neurons_number = get_neurons_number();
-    const Index inputs_number = get_inputs_number();
+        if(current_sequences_number <= 0) break;
 
-    const TensorMap<Tensor<type, 1>> biases(parameters.data(), neurons_number);
-    const TensorMap<Tensor<type, 2>> input_weights(parameters.data()+neurons_number, inputs_number, neurons_number);
-    const TensorMap<Tensor<type, 2>> recurrent_weights(parameters.data()+neurons_number+inputs_number*neurons_number, neurons_number, neurons_number);
-    TensorMap<Tensor<type, 2>> inputs_map = inputs(0).to_tensor_map<2>();
+        // h_t = f(W * x_t + U * h_(t-1) + b)
 
-    Tensor<Index, 1> combinations_dimensions;
-    Tensor<Index, 1> activations_dimensions;
-    Tensor<Index, 1> activations_derivatives_dimensions;
+        if(timestep == 0 && !forward_propagation->is_incremental)
+        {
+            current_combinations.setZero();
+        }
+        else
+        {
+            current_combinations.device(*thread_pool_device) = hidden_states.contract(recurrent_weights, A_B);
+        }
 
-    const Index samples_number = inputs(0).get_dimension(0);
+        for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
+        {
+            const type* sample_combinations = combinations.data() + neuron_index*samples_number + timestep;
 
-    for(Index i = 0; i < samples_number; i++)
-    {
-        if(i%timesteps == 0) hidden_states.setZero();
+            type* sequence_combinations = current_combinations.data() + neuron_index*sequences_number;
 
-        recurrent_layer_forward_propagation->current_inputs = inputs_map.chip(i, 0);
+            for(Index sequence_index = 0; sequence_index < current_sequences_number; sequence_index++)
+            {
+                sequence_combinations[sequence_index] += sample_combinations[sequence_index*sequence_timesteps];
+            }
+        }
 
-        calculate_combinations(recurrent_layer_forward_propagation->current_inputs,
-                               input_weights,
-                               recurrent_weights,
-                               biases,
-                               recurrent_layer_forward_propagation->current_combinations);
+        if(is_training)
+        {
+            calculate_activations_derivatives(current_combinations.data(), states_dimensions,
+                                              hidden_states.data(), states_dimensions,
+                                              current_activations_derivatives.data(), states_dimensions);
+        }
+        else
+        {
+            calculate_activations(current_combinations.data(), states_dimensions,
+                                  hidden_states.data(), states_dimensions);
+        }
 
-        calculate_activations_derivatives(recurrent_layer_forward_propagation->current_combinations.data(),
-                                          combinations_dimensions,
-                                          hidden_states.data(),
-                                          activations_dimensions,
-                                          recurrent_layer_forward_propagation->current_activations_derivatives.data(),
-                                          activations_derivatives_dimensions);
+        // Samples of this timestep
 
-        for(Index j = 0; j < neurons_number; j++)
+        for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
         {
-            recurrent_layer_forward_propagation->combinations(i,j)
-                    = recurrent_layer_forward_propagation->current_combinations(j);
+            for(Index sequence_index = 0; sequence_index < current_sequences_number; sequence_index++)
+            {
+                const Index sample_index = sequence_index*sequence_timesteps + timestep;
+
+                combinations(sample_index, neuron_index) = current_combinations(sequence_index, neuron_index);
 
-            outputs(i,j) = hidden_states(j);
+                outputs(sample_index, neuron_index) = hidden_states(sequence_index, neuron_index);
 
-            recurrent_layer_forward_propagation->activations_derivatives(i,j)
-                    = recurrent_layer_forward_propagation->current_activations_derivatives(j);
+                if(is_training)
+                {
+                    activations_derivatives(sample_index, neuron_index) = current_activations_derivatives(sequence_index, neuron_index);
+                }
+            }
         }
     }
 }
@@ -1058,197 +1088,123 @@ void RecurrentLayer::insert_gradient(LayerBackPropagation* back_propagation, con
 }
 
 
+/// Calculates the error gradient of the layer by back propagation through time.
+/// The sequences are swept from the last timestep to the first one, using the activations derivatives
+/// stored by the forward propagation.
+/// At each timestep, the combinations derivatives of all the sequences are multiplied by the recurrent weights
+/// to get the errors of the previous hidden states, and by the previous hidden states
+/// to get the recurrent weights derivatives.
+/// The biases and input weights derivatives are then calculated for all the samples with a single matrix product.
+/// If there is a truncation length, the errors are not back propagated beyond that number of timesteps.
+/// @param inputs_data Pointer to the inputs of the layer.
+/// @param forward_propagation Forward propagation of the layer.
+/// @param back_propagation Back propagation of the layer, where the gradient is written.
+
 void RecurrentLayer::calculate_error_gradient(type* inputs_data,
                                               LayerForwardPropagation* forward_propagation,
                                               LayerBackPropagation* back_propagation) const
 {
+    const Index samples_number = back_propagation->batch_samples_number;
+    const Index inputs_number = get_inputs_number();
+    const Index neurons_number = get_neurons_number();
+
     RecurrentLayerForwardPropagation* recurrent_layer_forward_propagation =
             static_cast<RecurrentLayerForwardPropagation*>(forward_propagation);
 
     RecurrentLayerBackPropagation* recurrent_layer_back_propagation =
             static_cast<RecurrentLayerBackPropagation*>(back_propagation);
 
+    const Index sequences_number = (samples_number + timesteps - 1)/timesteps;
 
-    const Index batch_samples_number = forward_propagation->batch_samples_number;
-
-    const TensorMap<Tensor<type, 2>> inputs(inputs_data, batch_samples_number, get_inputs_number());
-
-    calculate_biases_error_gradient(inputs, recurrent_layer_forward_propagation, recurrent_layer_back_propagation);
-
-    calculate_input_weights_error_gradient(inputs, recurrent_layer_forward_propagation, recurrent_layer_back_propagation);
-
-    calculate_recurrent_weights_error_gradient(inputs, recurrent_layer_forward_propagation, recurrent_layer_back_propagation);
-}
-
-
-void RecurrentLayer::calculate_biases_error_gradient(const Tensor<type, 2>& inputs,
-                                                     RecurrentLayerForwardPropagation* forward_propagation,
-                                                     RecurrentLayerBackPropagation* back_propagation) const
-{
-    // Derivatives of combinations with respect to biases
-
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = neurons_number;
-
-    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    back_propagation->combinations_biases_derivatives.setZero();
-
-    back_propagation->biases_derivatives.setZero();
-
-    for(Index sample = 0; sample < samples_number; sample++)
+    if(recurrent_layer_back_propagation->hidden_states_derivatives.dimension(0) != sequences_number)
     {
-        back_propagation->current_layer_deltas = deltas.chip(sample,0);
-
-        if(sample%timesteps == 0)
-        {
-            back_propagation->combinations_biases_derivatives.setZero();
-        }
-        else
-        {
-            multiply_rows(back_propagation->combinations_biases_derivatives, forward_propagation->current_activations_derivatives);
-
-            back_propagation->combinations_biases_derivatives
-                    = back_propagation->combinations_biases_derivatives.contract(recurrent_weights, A_B).eval();
-        }
-
-        forward_propagation->current_activations_derivatives
-                = forward_propagation->activations_derivatives.chip(sample, 0);
-
-        for(Index i = 0; i < parameters_number; i++) back_propagation->combinations_biases_derivatives(i,i) += static_cast<type>(1);
-
-        back_propagation->biases_derivatives += back_propagation->combinations_biases_derivatives
-                .contract(back_propagation->current_layer_deltas*forward_propagation->current_activations_derivatives, A_B);
+        recurrent_layer_back_propagation->set_sequences_number(sequences_number);
     }
-}
-
-
-void RecurrentLayer::calculate_input_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                            RecurrentLayerForwardPropagation* forward_propagation,
-                                                            RecurrentLayerBackPropagation* back_propagation) const
-{
-    // Derivatives of combinations with respect to input weights
 
-    const Index samples_number = inputs.dimension(0);
-    const Index inputs_number = get_inputs_number();
-    const Index neurons_number = get_neurons_number();
-    const Index parameters_number = inputs_number*neurons_number;
-
-    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
-
-    Index column_index = 0;
-    Index input_index = 0;
-
-    back_propagation->combinations_weights_derivatives.setZero();
-    back_propagation->input_weights_derivatives.setZero();
-
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        forward_propagation->current_inputs = inputs.chip(sample, 0);
-
-        back_propagation->current_layer_deltas = deltas.chip(sample, 0);
+    const TensorMap<Tensor<type, 2>> inputs(inputs_data, samples_number, inputs_number);
 
-        if(sample%timesteps == 0)
-        {
-            back_propagation->combinations_weights_derivatives.setZero();
-        }
-        else
-        {
-            multiply_rows(back_propagation->combinations_weights_derivatives, forward_propagation->current_activations_derivatives);
-
-            back_propagation->combinations_weights_derivatives
-                    = back_propagation->combinations_weights_derivatives.contract(recurrent_weights, A_B).eval();
-        }
+    const TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, samples_number, neurons_number);
 
-        forward_propagation->current_activations_derivatives
-                = forward_propagation->activations_derivatives.chip(sample, 0);
+    const TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
 
-        column_index = 0;
-        input_index = 0;
+    const Tensor<type, 2>& activations_derivatives = recurrent_layer_forward_propagation->activations_derivatives;
 
-        for(Index i = 0; i < parameters_number; i++)
-        {
-            back_propagation->combinations_weights_derivatives(i, column_index) += forward_propagation->current_inputs(input_index);
+    const Tensor<type, 2>& recurrent_weights = recurrent_layer_forward_propagation->recurrent_weights;
 
-            input_index++;
-
-            if(input_index == inputs_number)
-            {
-                input_index = 0;
-                column_index++;
-            }
-        }
+    // Derivatives
 
-        back_propagation->input_weights_derivatives += back_propagation->combinations_weights_derivatives
-                .contract(back_propagation->current_layer_deltas*forward_propagation->current_activations_derivatives, A_B);
-    }
-}
+    TensorMap<Tensor<type, 1>> biases_derivatives(recurrent_layer_back_propagation->biases_derivatives.data(), neurons_number);
 
+    TensorMap<Tensor<type, 2>> input_weights_derivatives(recurrent_layer_back_propagation->input_weights_derivatives.data(),
+                                                         inputs_number, neurons_number);
 
-void RecurrentLayer::calculate_recurrent_weights_error_gradient(const Tensor<type, 2>& inputs,
-                                                                RecurrentLayerForwardPropagation* forward_propagation,
-                                                                RecurrentLayerBackPropagation* back_propagation) const
-{
-    const Index samples_number = inputs.dimension(0);
-    const Index neurons_number = get_neurons_number();
+    TensorMap<Tensor<type, 2>> recurrent_weights_derivatives(recurrent_layer_back_propagation->recurrent_weights_derivatives.data(),
+                                                             neurons_number, neurons_number);
 
-    const Index parameters_number = neurons_number*neurons_number;
+    Tensor<type, 2>& combinations_derivatives = recurrent_layer_back_propagation->combinations_derivatives;
+    Tensor<type, 2>& current_combinations_derivatives = recurrent_layer_back_propagation->current_combinations_derivatives;
 
-    // Derivatives of combinations with respect to recurrent weights
+    Tensor<type, 2>& hidden_states_derivatives = recurrent_layer_back_propagation->hidden_states_derivatives;
 
-    const TensorMap<Tensor<type, 2>> outputs = forward_propagation->outputs(0).to_tensor_map<2>();
+    Tensor<type, 2>& previous_hidden_states = recurrent_layer_back_propagation->previous_hidden_states;
 
-    TensorMap<Tensor<type, 2>> deltas(back_propagation->deltas_data, back_propagation->deltas_dimensions(0), back_propagation->deltas_dimensions(1));
+    recurrent_weights_derivatives.setZero();
 
-    back_propagation->combinations_recurrent_weights_derivatives.setZero();
+    hidden_states_derivatives.setZero();
 
-    back_propagation->recurrent_weights_derivatives.setZero();
+    for(Index timestep = timesteps - 1; timestep >= 0; timestep--)
+    {
+        // The last sequence might not have this timestep
 
-    Index column_index = 0;
-    Index activation_index = 0;
+        const Index current_sequences_number = (samples_number - timestep + timesteps - 1)/timesteps;
 
-    for(Index sample = 0; sample < samples_number; sample++)
-    {
-        back_propagation->current_layer_deltas = deltas.chip(sample,0);
+        if(current_sequences_number <= 0) continue;
 
-        if(sample%timesteps == 0)
+        if(truncation_length > 0 && (timestep + 1)%truncation_length == 0)
         {
-            back_propagation->combinations_recurrent_weights_derivatives.setZero();
+            hidden_states_derivatives.setZero();
         }
-        else
-        {
-            forward_propagation->previous_activations = outputs.chip(sample-1, 0);
 
-            multiply_rows(back_propagation->combinations_recurrent_weights_derivatives, forward_propagation->current_activations_derivatives);
+        current_combinations_derivatives.setZero();
+        previous_hidden_states.setZero();
 
-            back_propagation->combinations_recurrent_weights_derivatives
-                    = back_propagation->combinations_recurrent_weights_derivatives.contract(recurrent_weights,A_B).eval();
+        for(Index neuron_index = 0; neuron_index < neurons_number; neuron_index++)
+        {
+            for(Index sequence_index = 0; sequence_index < current_sequences_number; sequence_index++)
+            {
+                const Index sample_index = sequence_index*timesteps + timestep;
 
-            column_index = 0;
-            activation_index = 0;
+                const type combination_derivative
+                        = (deltas(sample_index, neuron_index) + hidden_states_derivatives(sequence_index, neuron_index))
+                        *activations_derivatives(sample_index, neuron_index);
 
-            for(Index i = 0; i < parameters_number; i++)
-            {
-                back_propagation->combinations_recurrent_weights_derivatives(i, column_index)
-                        += forward_propagation->previous_activations(activation_index);
+                combinations_derivatives(sample_index, neuron_index) = combination_derivative;
 
-                activation_index++;
+                current_combinations_derivatives(sequence_index, neuron_index) = combination_derivative;
 
-                if(activation_index == neurons_number)
+                if(timestep != 0)
                 {
-                    activation_index = 0;
-                    column_index++;
+                    previous_hidden_states(sequence_index, neuron_index) = outputs(sample_index - 1, neuron_index);
                 }
             }
         }
 
-        forward_propagation->current_activations_derivatives = forward_propagation->activations_derivatives.chip(sample, 0);
+        if(timestep == 0) break;
+
+        // Recurrent weights derivatives and errors of the previous hidden states
+
+        recurrent_weights_derivatives.device(*thread_pool_device)
+                += previous_hidden_states.contract(current_combinations_derivatives, AT_B);
 
-        back_propagation->recurrent_weights_derivatives += back_propagation->combinations_recurrent_weights_derivatives
-                .contract(back_propagation->current_layer_deltas*forward_propagation->current_activations_derivatives, A_B);
+        hidden_states_derivatives.device(*thread_pool_device)
+                = current_combinations_derivatives.contract(recurrent_weights, A_BT);
     }
 
+    // Biases and input weights derivatives of all the samples
+
+    biases_derivatives.device(*thread_pool_device) = combinations_derivatives.sum(rows_sum);
+
+    input_weights_derivatives.device(*thread_pool_device) = inputs.contract(combinations_derivatives, AT_B);
 }
 
 
@@ -70,6 +70,7 @@ public:
    // Parameters
 
    Index get_timesteps() const;
+   Index get_truncation_length() const;
 
    Tensor<type, 1> get_biases() const;
    const Tensor<type, 2>& get_input_weights() const;
@@ -113,6 +114,7 @@ public:
    // Parameters
 
    void set_timesteps(const Index&);
+   void set_truncation_length(const Index&);
 
    void set_biases(const Tensor<type, 1>&);
 
@@ -153,10 +155,11 @@ public:
                                const Tensor<type, 2>&,
                                const Tensor<type, 2>&,
                                const Tensor<type, 1>&,
+                               const Tensor<type, 1>&,
                                Tensor<type, 1>&) const;
 
-   void calculate_activations(Tensor<type, 1>&,
-                              Tensor<type, 1>&) const;
+   void calculate_activations(type*, const Tensor<Index, 1>&,
+                              type*, const Tensor<Index, 1>&) const;
 
    Tensor<type, 1> get_activations(const Tensor<type,1>&) const;
 
@@ -170,6 +173,13 @@ public:
 
    void forward_propagate(const Tensor<DynamicTensor<type>, 1>&, Tensor<type, 1>&, LayerForwardPropagation*) final;
 
+   void forward_propagate_sequences(const TensorMap<Tensor<type, 2>>&,
+                                    const TensorMap<Tensor<type, 1>>&,
+                                    const TensorMap<Tensor<type, 2>>&,
+                                    const TensorMap<Tensor<type, 2>>&,
+                                    RecurrentLayerForwardPropagation*,
+                                    const bool&);
+
    void calculate_hidden_delta(LayerForwardPropagation*,
                                LayerBackPropagation*,
                                LayerBackPropagation*) const final;
@@ -190,18 +200,6 @@ public:
                                  LayerForwardPropagation*,
                                  LayerBackPropagation*) const final;
 
-   void calculate_biases_error_gradient(const Tensor<type, 2>&,
-                                        RecurrentLayerForwardPropagation*,
-                                        RecurrentLayerBackPropagation*) const;
-
-   void calculate_input_weights_error_gradient(const Tensor<type, 2>&,
-                                               RecurrentLayerForwardPropagation*,
-                                               RecurrentLayerBackPropagation*) const;
-
-   void calculate_recurrent_weights_error_gradient(const Tensor<type, 2>&,
-                                                   RecurrentLayerForwardPropagation*,
-                                                   RecurrentLayerBackPropagation*) const;
-
    // Expression methods
 
    string write_expression(const Tensor<string, 1>&, const Tensor<string, 1>&) const final;
@@ -218,6 +216,10 @@ protected:
 
    Index timesteps = 1;
 
+   /// Number of timesteps through which the errors are back propagated, or zero for the whole sequences.
+
+   Index truncation_length = 0;
+
    /// Bias is a neuron parameter that is summed with the neuron's weighted inputs
    /// and passed through the neuron's trabsfer function to generate the neuron's output.
 
@@ -235,6 +237,8 @@ protected:
 
    Tensor<type, 1> hidden_states;
 
+   const Eigen::array<Index, 1> rows_sum = {Index(0)};
+
    /// Display messages to screen.
 
    bool display = true;
@@ -256,12 +260,12 @@ struct RecurrentLayerForwardPropagation : LayerForwardPropagation
         set(new_batch_samples_number, new_layer_pointer);
     }
 
+
     void set(const Index& new_batch_samples_number, Layer* new_layer_pointer)
     {
         layer_pointer = new_layer_pointer;
 
         const Index neurons_number = layer_pointer->get_neurons_number();
-        const Index inputs_number = layer_pointer->get_inputs_number();
 
         batch_samples_number = new_batch_samples_number;
 
@@ -270,33 +274,105 @@ struct RecurrentLayerForwardPropagation : LayerForwardPropagation
         outputs.resize(1);
         Tensor<Index, 1> output_dimensions(2);
         output_dimensions.setValues({batch_samples_number, neurons_number});
-        outputs(0).set_dimensions(output_dimensions);
+        set_buffer_dimensions(outputs(0), output_dimensions);
+
+        // Sequences
+
+        const Index timesteps = static_cast<RecurrentLayer*>(layer_pointer)->get_timesteps();
+
+        set_sequences_number((batch_samples_number + timesteps - 1)/timesteps);
 
         // Rest of quantities
 
-        previous_activations.resize(neurons_number);
+        Tensor<Index, 1> combinations_dimensions(2);
+        combinations_dimensions.setValues({batch_samples_number, neurons_number});
+        set_buffer_dimensions(combinations, combinations_dimensions);
+
+        if(is_inference)
+        {
+            activations_derivatives.resize(0, 0);
+            recurrent_weights.resize(0, 0);
+        }
+        else
+        {
+            activations_derivatives.resize(batch_samples_number, neurons_number);
+            recurrent_weights.resize(neurons_number, neurons_number);
+        }
+    }
+
+
+    void set_sequences_number(const Index& sequences_number)
+    {
+        const Index neurons_number = layer_pointer->get_neurons_number();
+
+        hidden_states.resize(sequences_number, neurons_number);
+        hidden_states.setZero();
+
+        current_combinations.resize(sequences_number, neurons_number);
+
+        if(is_inference)
+            current_activations_derivatives.resize(0, 0);
+        else
+            current_activations_derivatives.resize(sequences_number, neurons_number);
+    }
+
+
+    void reset_states() final
+    {
+        hidden_states.setZero();
+    }
+
+
+    Tensor<DynamicTensor<type>*, 1> get_workspaces() final
+    {
+        Tensor<DynamicTensor<type>*, 1> workspaces(1);
+
+        workspaces(0) = &combinations;
+
+        return workspaces;
+    }
+
+
+    /// The outputs and the combinations keep their memory, while the states of the sequences,
+    /// which depend on the number of samples, are allocated again.
+
+    void set_batch_samples_number(const Index& new_batch_samples_number) final
+    {
+        LayerForwardPropagation::set_batch_samples_number(new_batch_samples_number);
+
+        const Index neurons_number = layer_pointer->get_neurons_number();
 
-        current_inputs.resize(inputs_number);
-        current_combinations.resize(neurons_number);
-        current_activations_derivatives.resize(neurons_number);
+        const Index timesteps = static_cast<RecurrentLayer*>(layer_pointer)->get_timesteps();
 
-        combinations.resize(batch_samples_number, neurons_number);
+        set_sequences_number((batch_samples_number + timesteps - 1)/timesteps);
 
-        activations_derivatives.resize(batch_samples_number, neurons_number);
+        if(!is_inference) activations_derivatives.resize(batch_samples_number, neurons_number);
     }
 
+
     void print() const
     {
     }
 
-    Tensor<type, 1> previous_activations;
+    /// Hidden states of the sequences being propagated, with one row for each sequence of the batch.
 
-    Tensor<type, 1> current_inputs;
-    Tensor<type, 1> current_combinations;
-    Tensor<type, 1> current_activations_derivatives;
+    Tensor<type, 2> hidden_states;
+
+    /// Combinations and activations derivatives at the current timestep of each sequence.
+
+    Tensor<type, 2> current_combinations;
+    Tensor<type, 2> current_activations_derivatives;
+
+    /// Combinations of the inputs of all the samples with the input weights, plus the biases.
+
+    DynamicTensor<type> combinations;
 
-    Tensor<type, 2> combinations;
     Tensor<type, 2> activations_derivatives;
+
+    /// Recurrent weights with which the hidden states were calculated in training,
+    /// so that the back propagation through time uses the same ones as the forward propagation.
+
+    Tensor<type, 2> recurrent_weights;
 };
 
 
@@ -306,10 +382,12 @@ struct RecurrentLayerBackPropagation : LayerBackPropagation
     {
     }
 
+
     virtual ~RecurrentLayerBackPropagation()
     {
     }
 
+
     explicit RecurrentLayerBackPropagation(const Index& new_batch_samples_number, Layer* new_layer_pointer)
         : LayerBackPropagation()
     {
@@ -332,26 +410,35 @@ struct RecurrentLayerBackPropagation : LayerBackPropagation
         //delete deltas_data;
         deltas_data = (type*)malloc(static_cast<size_t>(batch_samples_number*neurons_number*sizeof(type)));
 
-        current_layer_deltas.resize(neurons_number);
-
         biases_derivatives.resize(neurons_number);
 
-        input_weights_derivatives.resize(inputs_number * neurons_number);
+        input_weights_derivatives.resize(inputs_number*neurons_number);
+
+        recurrent_weights_derivatives.resize(neurons_number*neurons_number);
 
-        recurrent_weights_derivatives.resize(neurons_number * neurons_number);
+        combinations_derivatives.resize(batch_samples_number, neurons_number);
 
-        combinations_biases_derivatives.resize(neurons_number, neurons_number);
-        combinations_weights_derivatives.resize(inputs_number*neurons_number, neurons_number);
-        combinations_recurrent_weights_derivatives.resize(neurons_number*neurons_number, neurons_number);
+        const Index timesteps = static_cast<RecurrentLayer*>(layer_pointer)->get_timesteps();
+
+        set_sequences_number((batch_samples_number + timesteps - 1)/timesteps);
     }
 
 
-    void print() const
+    void set_sequences_number(const Index& sequences_number)
     {
+        const Index neurons_number = layer_pointer->get_neurons_number();
+
+        current_combinations_derivatives.resize(sequences_number, neurons_number);
 
+        hidden_states_derivatives.resize(sequences_number, neurons_number);
+
+        previous_hidden_states.resize(sequences_number, neurons_number);
     }
 
-    Tensor<type, 1> current_layer_deltas;
+
+    void print() const
+    {
+    }
 
     Tensor<type, 1> biases_derivatives;
 
@@ -359,13 +446,19 @@ struct RecurrentLayerBackPropagation : LayerBackPropagation
 
     Tensor<type, 1> recurrent_weights_derivatives;
 
-    Tensor<type, 2> combinations_biases_derivatives;
-    Tensor<type, 2> combinations_weights_derivatives;
-    Tensor<type, 2> combinations_recurrent_weights_derivatives;
-};
+    /// Derivatives of the error with respect to the combinations of each sample.
 
+    Tensor<type, 2> combinations_derivatives;
 
+    /// Derivatives of the combinations and the hidden states at the current timestep of each sequence,
+    /// back propagated from the following timesteps.
 
+    Tensor<type, 2> current_combinations_derivatives;
+
+    Tensor<type, 2> hidden_states_derivatives;
+
+    Tensor<type, 2> previous_hidden_states;
+};
 
 }
 
@@ -274,6 +274,15 @@ void StochasticGradientDescent::set_maximum_time(const type& new_maximum_time)
 void StochasticGradientDescent::update_parameters(LossIndexBackPropagation& back_propagation,
                       StochasticGradientDescentData& optimization_data) const
 {
+    if(!emulate_gradient_precision(back_propagation, optimization_data)) return;
+
+    if(!back_propagation.gradient_segments.empty() && emulated_precision == Precision::Single)
+    {
+        update_parameters_lazy(back_propagation, optimization_data);
+
+        return;
+    }
+
     const type learning_rate = initial_learning_rate/(type(1) + type(optimization_data.iteration)*initial_decay);
 
     optimization_data.parameters_increment.device(*thread_pool_device) = back_propagation.gradient*(-learning_rate);
@@ -302,7 +311,64 @@ void StochasticGradientDescent::update_parameters(LossIndexBackPropagation& back
 
     // Update parameters
 
-    back_propagation.loss_index_pointer->get_neural_network_pointer()->set_parameters(back_propagation.parameters);
+    set_neural_network_parameters(back_propagation, optimization_data);
+}
+
+
+/// Updates only the parameters in the gradient segments, when the loss index has assembled a sparse gradient.
+/// The rest of parameters, and their momentum, are kept until their gradient is nonzero again.
+/// @param back_propagation Back propagation of the loss index, with the gradient segments.
+/// @param optimization_data Data of the optimization algorithm.
+
+void StochasticGradientDescent::update_parameters_lazy(LossIndexBackPropagation& back_propagation,
+                                                       StochasticGradientDescentData& optimization_data) const
+{
+    const type learning_rate = initial_learning_rate/(type(1) + type(optimization_data.iteration)*initial_decay);
+
+    const vector<pair<Index, Index>>& gradient_segments = back_propagation.gradient_segments;
+
+    const Index segments_number = static_cast<Index>(gradient_segments.size());
+
+    const type* gradient_data = back_propagation.gradient.data();
+
+    type* parameters_data = back_propagation.parameters.data();
+
+    type* parameters_increment_data = optimization_data.parameters_increment.data();
+    type* last_parameters_increment_data = optimization_data.last_parameters_increment.data();
+
+#pragma omp parallel for schedule(dynamic)
+    for(Index i = 0; i < segments_number; i++)
+    {
+        const Index first = gradient_segments[i].first;
+        const Index end = first + gradient_segments[i].second;
+
+        for(Index j = first; j < end; j++)
+        {
+            parameters_increment_data[j] = -learning_rate*gradient_data[j];
+
+            if(momentum > type(0))
+            {
+                parameters_increment_data[j] += momentum*last_parameters_increment_data[j];
+
+                parameters_data[j] += nesterov
+                        ? parameters_increment_data[j]*momentum - gradient_data[j]*learning_rate
+                        : parameters_increment_data[j];
+            }
+            else
+            {
+                parameters_data[j] += parameters_increment_data[j];
+            }
+
+            last_parameters_increment_data[j] = parameters_increment_data[j];
+        }
+    }
+
+    optimization_data.iteration++;
+
+    // Update parameters
+
+    back_propagation.loss_index_pointer->get_neural_network_pointer()->set_parameters_segments(back_propagation.parameters,
+                                                                                               gradient_segments);
 }
 
 
@@ -407,6 +473,8 @@ TrainingResults StochasticGradientDescent::perform_training()
 
     StochasticGradientDescentData optimization_data(this);
 
+    set_neural_network_parameters(training_back_propagation, optimization_data);
+
     bool stop_training = false;
     bool is_training = true;
 
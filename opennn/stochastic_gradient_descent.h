@@ -96,6 +96,8 @@ public:
 
    void update_parameters(LossIndexBackPropagation& , StochasticGradientDescentData&) const;
 
+   void update_parameters_lazy(LossIndexBackPropagation&, StochasticGradientDescentData&) const;
+
    TrainingResults perform_training() final;
 
    string write_optimization_algorithm_type() const final;
@@ -187,6 +189,8 @@ struct StochasticGradientDescentData : public OptimizationAlgorithmData
 
         parameters_increment.setZero();
         last_parameters_increment.setZero();
+
+        loss_scale = stochastic_gradient_descent_pointer->get_loss_scale();
     }
 
     StochasticGradientDescent* stochastic_gradient_descent_pointer = nullptr;
@@ -152,6 +152,9 @@ void SumSquaredError::calculate_error_gradient_lm(const DataSetBatch& ,
 
     loss_index_back_propagation_lm.gradient.device(*thread_pool_device)
             = coefficient*loss_index_back_propagation_lm.gradient;
+
+    if(loss_index_back_propagation_lm.double_precision)
+        calculate_error_gradient_lm_double(coefficient, loss_index_back_propagation_lm);
 }
 
 
@@ -166,6 +169,13 @@ void SumSquaredError::calculate_error_hessian_lm(const DataSetBatch&,
 
      const type coefficient = static_cast<type>(2.0);
 
+     if(loss_index_back_propagation_lm.double_precision)
+     {
+         calculate_error_hessian_lm_double(coefficient, loss_index_back_propagation_lm);
+
+         return;
+     }
+
      loss_index_back_propagation_lm.hessian.device(*thread_pool_device)
              = loss_index_back_propagation_lm.squared_errors_jacobian.contract(loss_index_back_propagation_lm.squared_errors_jacobian, AT_B);
 
@@ -953,20 +953,33 @@ void sum_diagonal(Tensor<type, 2>& matrix, const type& value)
 /// Uses Eigen to solve the system of equations by means of the Householder QR decomposition.
 
 Tensor<type, 1> perform_Householder_QR_decomposition(const Tensor<type, 2>& A, const Tensor<type, 1>& b)
+{
+    return perform_Householder_QR_decomposition<type>(A, b);
+}
+
+
+/// Uses Eigen to solve the system of equations by means of the Householder QR decomposition, in a given scalar type.
+/// It is instantiated for float and double, so that systems can be solved in double precision whatever the library type.
+
+template<typename Scalar>
+Tensor<Scalar, 1> perform_Householder_QR_decomposition(const Tensor<Scalar, 2>& A, const Tensor<Scalar, 1>& b)
 {
     const Index n = A.dimension(0);
 
-    Tensor<type, 1> x(n);
+    Tensor<Scalar, 1> x(n);
 
-    const Map<Matrix<type, Dynamic, Dynamic>> A_eigen((type*)A.data(), n, n);
-    const Map<Matrix<type, Dynamic, 1>> b_eigen((type*)b.data(), n, 1);
-    Map<Matrix<type, Dynamic, 1>> x_eigen((type*)x.data(), n);
+    const Map<Matrix<Scalar, Dynamic, Dynamic>> A_eigen((Scalar*)A.data(), n, n);
+    const Map<Matrix<Scalar, Dynamic, 1>> b_eigen((Scalar*)b.data(), n, 1);
+    Map<Matrix<Scalar, Dynamic, 1>> x_eigen((Scalar*)x.data(), n);
 
     x_eigen = A_eigen.colPivHouseholderQr().solve(b_eigen);
 
     return x;
 }
 
+template Tensor<float, 1> perform_Householder_QR_decomposition<float>(const Tensor<float, 2>&, const Tensor<float, 1>&);
+template Tensor<double, 1> perform_Householder_QR_decomposition<double>(const Tensor<double, 2>&, const Tensor<double, 1>&);
+
 
 void fill_submatrix(const Tensor<type, 2>& matrix,
                     const Tensor<Index, 1>& rows_indices,
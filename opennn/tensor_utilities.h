@@ -117,6 +117,9 @@ void sum_diagonal(Tensor<type, 2>&, const type&);
 
 Tensor<type, 1> perform_Householder_QR_decomposition(const Tensor<type, 2>&, const Tensor<type, 1>&);
 
+template<typename Scalar>
+Tensor<Scalar, 1> perform_Householder_QR_decomposition(const Tensor<Scalar, 2>&, const Tensor<Scalar, 1>&);
+
 void fill_submatrix(const Tensor<type, 2>&, const Tensor<Index, 1>& rows_indices, const Tensor<Index, 1>&, type*);
 void fill_submatrix(const Tensor<type, 2>&, const Tensor<Index, 1>&, const Tensor<Index, 1>&, Tensor<type, 2>&);
 
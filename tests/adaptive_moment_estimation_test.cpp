@@ -115,6 +115,155 @@ void AdaptiveMomentEstimationTest::test_perform_training()
 }
 
 
+void AdaptiveMomentEstimationTest::test_update_parameters_lazy()
+{
+    cout << "test_update_parameters_lazy\n";
+
+    const Index input_dim = 4;
+    const Index depth = 2;
+
+    neural_network.set();
+
+    EmbeddingLayer* embedding_layer_pointer = new EmbeddingLayer(input_dim, 1, depth);
+
+    neural_network.add_layer(embedding_layer_pointer);
+
+    const Index parameters_number = neural_network.get_parameters_number();
+
+    AdaptiveMomentEstimationData lazy_optimization_data(&adaptive_moment_estimation);
+    AdaptiveMomentEstimationData dense_optimization_data(&adaptive_moment_estimation);
+
+    lazy_optimization_data.iteration = 1;
+    dense_optimization_data.iteration = 1;
+
+    LossIndexBackPropagation lazy_back_propagation;
+    lazy_back_propagation.loss_index_pointer = &sum_squared_error;
+    lazy_back_propagation.parameters = neural_network.get_parameters();
+    lazy_back_propagation.gradient.resize(parameters_number);
+
+    LossIndexBackPropagation dense_back_propagation;
+    dense_back_propagation.loss_index_pointer = &sum_squared_error;
+    dense_back_propagation.parameters = neural_network.get_parameters();
+    dense_back_propagation.gradient.resize(parameters_number);
+
+    const Tensor<type, 1> initial_parameters = neural_network.get_parameters();
+
+    // First batch touches row 1 and second batch row 3
+
+    Tensor<type, 1> first_batch_parameters;
+
+    for(Index batch = 0; batch < 2; batch++)
+    {
+        const Index row = batch == 0 ? 1 : 3;
+
+        lazy_back_propagation.gradient.setZero();
+        lazy_back_propagation.gradient(row*depth) = type(0.5);
+        lazy_back_propagation.gradient(row*depth + 1) = type(-1);
+
+        lazy_back_propagation.gradient_segments.clear();
+        lazy_back_propagation.gradient_segments.push_back(make_pair(row*depth, depth));
+
+        dense_back_propagation.gradient = lazy_back_propagation.gradient;
+
+        adaptive_moment_estimation.update_parameters(dense_back_propagation, dense_optimization_data);
+        adaptive_moment_estimation.update_parameters(lazy_back_propagation, lazy_optimization_data);
+
+        // Touched rows are updated as in the dense update
+
+        assert_true(abs(lazy_back_propagation.parameters(row*depth) - dense_back_propagation.parameters(row*depth)) < type(1.0e-6), LOG);
+        assert_true(abs(lazy_back_propagation.parameters(row*depth + 1) - dense_back_propagation.parameters(row*depth + 1)) < type(1.0e-6), LOG);
+        assert_true(abs(lazy_back_propagation.parameters(row*depth) - initial_parameters(row*depth)) > type(0), LOG);
+
+        if(batch == 0) first_batch_parameters = lazy_back_propagation.parameters;
+    }
+
+    // Rows not touched in the last batch keep their values and moments
+
+    assert_true(lazy_back_propagation.parameters(depth) == first_batch_parameters(depth), LOG);
+    assert_true(abs(dense_back_propagation.parameters(depth) - first_batch_parameters(depth)) > type(0), LOG);
+
+    assert_true(lazy_back_propagation.parameters(0) == initial_parameters(0), LOG);
+    assert_true(lazy_back_propagation.parameters(2*depth) == initial_parameters(2*depth), LOG);
+
+    // The lazy update only sets the touched rows of the lookup table, after the dense update set all of them
+
+    const Tensor<type, 2> lookup_table = embedding_layer_pointer->get_lookup_table();
+
+    assert_true(lookup_table(0, 3) == lazy_back_propagation.parameters(3*depth), LOG);
+    assert_true(lookup_table(1, 3) == lazy_back_propagation.parameters(3*depth + 1), LOG);
+    assert_true(lookup_table(0, 1) == dense_back_propagation.parameters(depth), LOG);
+}
+
+
+void AdaptiveMomentEstimationTest::test_update_parameters_emulated_precision()
+{
+    cout << "test_update_parameters_emulated_precision\n";
+
+    neural_network.set();
+
+    neural_network.add_layer(new PerceptronLayer(4, 3));
+
+    const Index parameters_number = neural_network.get_parameters_number();
+
+    Tensor<type, 1> parameters;
+
+    for(const Precision& precision : {Precision::BFloat16, Precision::Half})
+    {
+        adaptive_moment_estimation.set_emulated_precision(precision);
+
+        AdaptiveMomentEstimationData optimization_data(&adaptive_moment_estimation);
+
+        optimization_data.iteration = 1;
+
+        LossIndexBackPropagation back_propagation;
+        back_propagation.loss_index_pointer = &sum_squared_error;
+        back_propagation.parameters = neural_network.get_parameters();
+        back_propagation.gradient.resize(parameters_number);
+
+        // Test
+
+        back_propagation.gradient.setRandom();
+
+        adaptive_moment_estimation.update_parameters(back_propagation, optimization_data);
+
+        parameters = neural_network.get_parameters();
+
+        for(Index i = 0; i < parameters_number; i++)
+        {
+            assert_true(parameters(i) == round_to_precision(parameters(i), precision), LOG);
+            assert_true(abs(parameters(i) - back_propagation.parameters(i)) <= type(1e-2)*abs(back_propagation.parameters(i)) + type(1e-6), LOG);
+        }
+
+        assert_true(optimization_data.iteration == 2, LOG);
+        assert_true(optimization_data.loss_scale == adaptive_moment_estimation.get_loss_scale(), LOG);
+
+        // Test
+
+        const Tensor<type, 1> master_parameters = back_propagation.parameters;
+
+        back_propagation.gradient.setConstant(type(1e4));
+
+        adaptive_moment_estimation.update_parameters(back_propagation, optimization_data);
+
+        if(precision == Precision::Half)
+        {
+            assert_true(optimization_data.iteration == 2, LOG);
+            assert_true(optimization_data.loss_scale == adaptive_moment_estimation.get_loss_scale()/type(2), LOG);
+            assert_true(optimization_data.loss_scale_steps_number == 0, LOG);
+
+            for(Index i = 0; i < parameters_number; i++)
+                assert_true(back_propagation.parameters(i) == master_parameters(i), LOG);
+        }
+        else
+        {
+            assert_true(optimization_data.iteration == 3, LOG);
+        }
+    }
+
+    adaptive_moment_estimation.set_emulated_precision(Precision::Single);
+}
+
+
 void AdaptiveMomentEstimationTest::run_test_case()
 {
     cout << "Running gradient descent test case...\n";
@@ -128,6 +277,10 @@ void AdaptiveMomentEstimationTest::run_test_case()
 
     test_perform_training();
 
+    test_update_parameters_lazy();
+
+    test_update_parameters_emulated_precision();
+
     cout << "End of gradient descent test case.\n\n";
 }
 
@@ -37,6 +37,10 @@ public:
 
     void test_perform_training();
 
+    void test_update_parameters_lazy();
+
+    void test_update_parameters_emulated_precision();
+
     // Unit testing methods
 
     void run_test_case();
@@ -345,6 +345,124 @@ void ConvolutionalLayerTest::test_calculate_combinations()
 
 ///@todo include this in pooling
 
+void ConvolutionalLayerTest::test_calculate_convolutions()
+{
+    cout << "test_calculate_convolutions\n";
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    Tensor<Index, 1> kernels_dimensions(4);
+
+    Tensor<type, 4> inputs;
+
+    const Index batch_samples_number = 2;
+    const Index channels_number = 3;
+    const Index kernels_number = 4;
+
+    // Winograd, Winograd with padding, im2col with strides and im2col with 5x5 kernels
+
+    const Index kernels_sizes[4] = {3, 3, 3, 5};
+    const Index strides[4] = {1, 1, 2, 1};
+    const ConvolutionalLayer::ConvolutionType convolution_types[4] = {ConvolutionalLayer::ConvolutionType::Valid,
+                                                                      ConvolutionalLayer::ConvolutionType::Same,
+                                                                      ConvolutionalLayer::ConvolutionType::Same,
+                                                                      ConvolutionalLayer::ConvolutionType::Same};
+
+    for(Index test_index = 0; test_index < 4; test_index++)
+    {
+        const Index kernels_size = kernels_sizes[test_index];
+        const Index stride = strides[test_index];
+
+        inputs_dimensions.setValues({7, 6, channels_number});
+        kernels_dimensions.setValues({kernels_size, kernels_size, channels_number, kernels_number});
+
+        convolutional_layer.set(inputs_dimensions, kernels_dimensions);
+        convolutional_layer.set_convolution_type(convolution_types[test_index]);
+        convolutional_layer.set_row_stride(stride);
+        convolutional_layer.set_column_stride(stride);
+        convolutional_layer.set_parameters_random();
+
+        assert_true(convolutional_layer.is_winograd_convolution() == (kernels_size == 3 && stride == 1), LOG);
+
+        inputs.resize(batch_samples_number, 7, 6, channels_number);
+        inputs.setRandom();
+
+        forward_propagation.set(batch_samples_number, &convolutional_layer);
+
+        convolutional_layer.calculate_convolutions(inputs.data(), &forward_propagation);
+
+        const TensorMap<Tensor<type, 4>> outputs = forward_propagation.get_outputs();
+
+        const Tensor<type, 4>& synaptic_weights = convolutional_layer.get_synaptic_weights();
+        const Tensor<type, 1>& biases = convolutional_layer.get_biases();
+        const pair<Index, Index> padding = convolutional_layer.get_padding();
+
+        for(Index sample = 0; sample < batch_samples_number; sample++)
+        {
+            for(Index row = 0; row < convolutional_layer.get_outputs_rows_number(); row++)
+            {
+                for(Index column = 0; column < convolutional_layer.get_outputs_columns_number(); column++)
+                {
+                    for(Index kernel = 0; kernel < kernels_number; kernel++)
+                    {
+                        type convolution = biases(kernel);
+
+                        for(Index channel = 0; channel < channels_number; channel++)
+                        {
+                            for(Index kernel_row = 0; kernel_row < kernels_size; kernel_row++)
+                            {
+                                for(Index kernel_column = 0; kernel_column < kernels_size; kernel_column++)
+                                {
+                                    const Index input_row = row*stride - padding.first + kernel_row;
+                                    const Index input_column = column*stride - padding.second + kernel_column;
+
+                                    if(input_row < 0 || input_row >= 7 || input_column < 0 || input_column >= 6) continue;
+
+                                    convolution += inputs(sample, input_row, input_column, channel)
+                                                 *synaptic_weights(kernel_row, kernel_column, channel, kernel);
+                                }
+                            }
+                        }
+
+                        assert_true(abs(outputs(sample, row, column, kernel) - convolution) < type(1e-4), LOG);
+                    }
+                }
+            }
+        }
+    }
+
+    // Winograd kernels after setting the parameters
+
+    inputs_dimensions.setValues({7, 6, channels_number});
+    kernels_dimensions.setValues({3, 3, channels_number, kernels_number});
+
+    convolutional_layer.set(inputs_dimensions, kernels_dimensions);
+    convolutional_layer.set_convolution_type(ConvolutionalLayer::ConvolutionType::Valid);
+    convolutional_layer.set_row_stride(1);
+    convolutional_layer.set_column_stride(1);
+
+    inputs.resize(batch_samples_number, 7, 6, channels_number);
+    inputs.setRandom();
+
+    forward_propagation.set(batch_samples_number, &convolutional_layer);
+
+    convolutional_layer.calculate_convolutions(inputs.data(), &forward_propagation);
+
+    const Tensor<type, 4> outputs = forward_propagation.get_outputs();
+
+    const Tensor<type, 1> parameters = convolutional_layer.get_parameters();
+
+    convolutional_layer.set_parameters(parameters*type(2));
+
+    convolutional_layer.calculate_convolutions(inputs.data(), &forward_propagation);
+
+    const Tensor<type, 4> doubled_outputs = forward_propagation.get_outputs();
+
+    const Tensor<type, 0> maximum_difference = (doubled_outputs - outputs*type(2)).abs().maximum();
+
+    assert_true(maximum_difference(0) < type(1e-4), LOG);
+}
+
+
 void ConvolutionalLayerTest::test_calculate_average_pooling_outputs()
 {
     cout << "test_calculate_max_pooling_outputs\n";
@@ -979,6 +1097,92 @@ void ConvolutionalLayerTest::test_forward_propagation()
 }
 
 
+void ConvolutionalLayerTest::test_forward_propagate_max_pooling()
+{
+    cout << "test_forward_propagate_max_pooling\n";
+
+    const Index batch_samples_number = 2;
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    inputs_dimensions.setValues({7, 9, 3});
+
+    Tensor<Index, 1> kernels_dimensions(4);
+    kernels_dimensions.setValues({5, 5, 3, 4});
+
+    convolutional_layer.set(inputs_dimensions, kernels_dimensions);
+    convolutional_layer.set_convolution_type(ConvolutionalLayer::ConvolutionType::Same);
+    convolutional_layer.set_activation_function(ConvolutionalLayer::ActivationFunction::RectifiedLinear);
+    convolutional_layer.set_parameters_random();
+
+    Tensor<Index, 1> pool_dimensions(2);
+    pool_dimensions.setValues({2, 2});
+
+    PoolingLayer pooling_layer(convolutional_layer.get_outputs_dimensions(), pool_dimensions);
+    pooling_layer.set_pooling_method(PoolingLayer::PoolingMethod::MaxPooling);
+    pooling_layer.set_row_stride(2);
+    pooling_layer.set_column_stride(2);
+
+    assert_true(convolutional_layer.is_fusable(&pooling_layer), LOG);
+
+    // Winograd convolutions are not fused
+
+    kernels_dimensions.setValues({3, 3, 3, 4});
+
+    ConvolutionalLayer winograd_convolutional_layer(inputs_dimensions, kernels_dimensions);
+    winograd_convolutional_layer.set_convolution_type(ConvolutionalLayer::ConvolutionType::Same);
+
+    assert_true(!winograd_convolutional_layer.is_fusable(&pooling_layer), LOG);
+
+    Tensor<type, 4> inputs(batch_samples_number, 7, 9, 3);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    // Separate layers
+
+    forward_propagation.set(batch_samples_number, &convolutional_layer);
+
+    PoolingLayerForwardPropagation pooling_layer_forward_propagation(batch_samples_number, &pooling_layer);
+
+    convolutional_layer.forward_propagate(inputs_pair, &forward_propagation, true);
+
+    pooling_layer.forward_propagate(forward_propagation.outputs, &pooling_layer_forward_propagation, true);
+
+    // Fused block
+
+    ConvolutionalLayerForwardPropagation fused_forward_propagation(batch_samples_number, &convolutional_layer);
+
+    PoolingLayerForwardPropagation fused_pooling_layer_forward_propagation(batch_samples_number, &pooling_layer);
+
+    convolutional_layer.forward_propagate_max_pooling(inputs_pair,
+                                                      &fused_forward_propagation,
+                                                      &pooling_layer,
+                                                      &fused_pooling_layer_forward_propagation,
+                                                      true);
+
+    const TensorMap<Tensor<type, 4>> outputs = pooling_layer_forward_propagation.outputs(0).to_tensor_map<4>();
+    const TensorMap<Tensor<type, 4>> fused_outputs = fused_pooling_layer_forward_propagation.outputs(0).to_tensor_map<4>();
+
+    for(Index i = 0; i < outputs.size(); i++)
+    {
+        assert_true(abs(outputs(i) - fused_outputs(i)) < type(1e-4), LOG);
+
+        // Rectified outputs may be tied at zero
+
+        if(outputs(i) > type(0))
+        {
+            assert_true(pooling_layer_forward_propagation.maximal_indices(i) == fused_pooling_layer_forward_propagation.maximal_indices(i), LOG);
+        }
+    }
+
+    for(Index i = 0; i < forward_propagation.activations_derivatives.size(); i++)
+    {
+        assert_true(forward_propagation.activations_derivatives(i) == fused_forward_propagation.activations_derivatives(i), LOG);
+    }
+}
+
+
 void ConvolutionalLayerTest::test_insert_padding()
 {
     cout << "test_insert_padding\n";
@@ -1075,6 +1279,193 @@ void ConvolutionalLayerTest::test_calculate_hidden_delta_perceptron_test()
 
 
 
+void ConvolutionalLayerTest::test_calculate_error_gradient()
+{
+    cout << "test_calculate_error_gradient\n";
+
+    const Index batch_samples_number = 3;
+    const Index inputs_rows_number = 6;
+    const Index inputs_columns_number = 5;
+    const Index channels_number = 2;
+    const Index kernels_number = 3;
+    const Index stride = 2;
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    inputs_dimensions.setValues({inputs_rows_number, inputs_columns_number, channels_number});
+
+    Tensor<Index, 1> kernels_dimensions(4);
+    kernels_dimensions.setValues({3, 3, channels_number, kernels_number});
+
+    convolutional_layer.set(inputs_dimensions, kernels_dimensions);
+    convolutional_layer.set_convolution_type(ConvolutionalLayer::ConvolutionType::Same);
+    convolutional_layer.set_row_stride(stride);
+    convolutional_layer.set_column_stride(stride);
+    convolutional_layer.set_activation_function(ConvolutionalLayer::ActivationFunction::Linear);
+    convolutional_layer.set_parameters_random();
+
+    const Index outputs_rows_number = convolutional_layer.get_outputs_rows_number();
+    const Index outputs_columns_number = convolutional_layer.get_outputs_columns_number();
+    const pair<Index, Index> padding = convolutional_layer.get_padding();
+
+    Tensor<type, 4> inputs(batch_samples_number, inputs_rows_number, inputs_columns_number, channels_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    forward_propagation.set(batch_samples_number, &convolutional_layer);
+
+    ConvolutionalLayerBackPropagation back_propagation(batch_samples_number, &convolutional_layer);
+
+    convolutional_layer.forward_propagate(inputs_pair, &forward_propagation, true);
+
+    TensorMap<Tensor<type, 4>> deltas(back_propagation.deltas_data, back_propagation.get_deltas_dimensions_array());
+    deltas.setRandom();
+
+    convolutional_layer.calculate_error_gradient(inputs.data(), &forward_propagation, &back_propagation);
+
+    Tensor<type, 4> inputs_derivatives(batch_samples_number, inputs_rows_number, inputs_columns_number, channels_number);
+
+    convolutional_layer.calculate_inputs_derivatives(&back_propagation, inputs_derivatives.data());
+
+    // Direct convolution derivatives
+
+    const Tensor<type, 4>& synaptic_weights = convolutional_layer.get_synaptic_weights();
+
+    Tensor<type, 4> synaptic_weights_derivatives(synaptic_weights.dimensions());
+    synaptic_weights_derivatives.setZero();
+
+    Tensor<type, 1> biases_derivatives(kernels_number);
+    biases_derivatives.setZero();
+
+    Tensor<type, 4> direct_inputs_derivatives(inputs.dimensions());
+    direct_inputs_derivatives.setZero();
+
+    for(Index sample = 0; sample < batch_samples_number; sample++)
+        for(Index row = 0; row < outputs_rows_number; row++)
+            for(Index column = 0; column < outputs_columns_number; column++)
+                for(Index kernel = 0; kernel < kernels_number; kernel++)
+                {
+                    const type delta = deltas(sample, row, column, kernel);
+
+                    biases_derivatives(kernel) += delta;
+
+                    for(Index channel = 0; channel < channels_number; channel++)
+                        for(Index kernel_row = 0; kernel_row < 3; kernel_row++)
+                            for(Index kernel_column = 0; kernel_column < 3; kernel_column++)
+                            {
+                                const Index input_row = row*stride - padding.first + kernel_row;
+                                const Index input_column = column*stride - padding.second + kernel_column;
+
+                                if(input_row < 0 || input_row >= inputs_rows_number
+                                || input_column < 0 || input_column >= inputs_columns_number) continue;
+
+                                synaptic_weights_derivatives(kernel_row, kernel_column, channel, kernel)
+                                        += delta*inputs(sample, input_row, input_column, channel);
+
+                                direct_inputs_derivatives(sample, input_row, input_column, channel)
+                                        += delta*synaptic_weights(kernel_row, kernel_column, channel, kernel);
+                            }
+                }
+
+    for(Index i = 0; i < synaptic_weights_derivatives.size(); i++)
+        assert_true(abs(back_propagation.synaptic_weights_derivatives(i) - synaptic_weights_derivatives(i)) < type(1e-4), LOG);
+
+    for(Index i = 0; i < kernels_number; i++)
+        assert_true(abs(back_propagation.biases_derivatives(i) - biases_derivatives(i)) < type(1e-4), LOG);
+
+    for(Index i = 0; i < inputs_derivatives.size(); i++)
+        assert_true(abs(inputs_derivatives(i) - direct_inputs_derivatives(i)) < type(1e-4), LOG);
+}
+
+
+void ConvolutionalLayerTest::test_calculate_hidden_delta_addition()
+{
+    cout << "test_calculate_hidden_delta_addition\n";
+
+    const Index batch_samples_number = 2;
+    const Index inputs_rows_number = 5;
+    const Index inputs_columns_number = 4;
+    const Index channels_number = 2;
+    const Index kernels_number = 3;
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    inputs_dimensions.setValues({inputs_rows_number, inputs_columns_number, channels_number});
+
+    Tensor<Index, 1> kernels_dimensions(4);
+    kernels_dimensions.setValues({3, 3, channels_number, kernels_number});
+
+    convolutional_layer.set(inputs_dimensions, kernels_dimensions);
+    convolutional_layer.set_convolution_type(ConvolutionalLayer::ConvolutionType::Same);
+    convolutional_layer.set_row_stride(1);
+    convolutional_layer.set_column_stride(1);
+    convolutional_layer.set_activation_function(ConvolutionalLayer::ActivationFunction::HyperbolicTangent);
+    convolutional_layer.set_parameters_random();
+
+    AdditionLayer addition_layer(inputs_dimensions);
+
+    const Index outputs_rows_number = convolutional_layer.get_outputs_rows_number();
+    const Index outputs_columns_number = convolutional_layer.get_outputs_columns_number();
+    const pair<Index, Index> padding = convolutional_layer.get_padding();
+
+    Tensor<type, 4> inputs(batch_samples_number, inputs_rows_number, inputs_columns_number, channels_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    forward_propagation.set(batch_samples_number, &convolutional_layer);
+
+    ConvolutionalLayerBackPropagation back_propagation(batch_samples_number, &convolutional_layer);
+
+    AdditionLayerBackPropagation addition_back_propagation(batch_samples_number, &addition_layer);
+
+    convolutional_layer.forward_propagate(inputs_pair, &forward_propagation, true);
+
+    TensorMap<Tensor<type, 4>> deltas(back_propagation.deltas_data, back_propagation.get_deltas_dimensions_array());
+    deltas.setRandom();
+
+    addition_layer.calculate_hidden_delta(&forward_propagation, &back_propagation, &addition_back_propagation);
+
+    const TensorMap<Tensor<type, 4>> addition_deltas(addition_back_propagation.deltas_data,
+                                                     batch_samples_number, inputs_rows_number, inputs_columns_number, channels_number);
+
+    // Direct derivatives with respect to the inputs of the convolutional layer
+
+    const Tensor<type, 4>& synaptic_weights = convolutional_layer.get_synaptic_weights();
+
+    const Tensor<type, 4>& activations_derivatives = forward_propagation.activations_derivatives;
+
+    Tensor<type, 4> direct_deltas(inputs.dimensions());
+    direct_deltas.setZero();
+
+    for(Index sample = 0; sample < batch_samples_number; sample++)
+        for(Index row = 0; row < outputs_rows_number; row++)
+            for(Index column = 0; column < outputs_columns_number; column++)
+                for(Index kernel = 0; kernel < kernels_number; kernel++)
+                {
+                    const type delta = deltas(sample, row, column, kernel)*activations_derivatives(sample, row, column, kernel);
+
+                    for(Index channel = 0; channel < channels_number; channel++)
+                        for(Index kernel_row = 0; kernel_row < 3; kernel_row++)
+                            for(Index kernel_column = 0; kernel_column < 3; kernel_column++)
+                            {
+                                const Index input_row = row - padding.first + kernel_row;
+                                const Index input_column = column - padding.second + kernel_column;
+
+                                if(input_row < 0 || input_row >= inputs_rows_number
+                                || input_column < 0 || input_column >= inputs_columns_number) continue;
+
+                                direct_deltas(sample, input_row, input_column, channel)
+                                        += delta*synaptic_weights(kernel_row, kernel_column, channel, kernel);
+                            }
+                }
+
+    for(Index i = 0; i < direct_deltas.size(); i++)
+        assert_true(abs(addition_deltas(i) - direct_deltas(i)) < type(1e-4), LOG);
+}
+
+
 void ConvolutionalLayerTest::test_memcpy_approach()
 {
 
@@ -1164,6 +1555,7 @@ void ConvolutionalLayerTest::run_test_case()
    // Combinations
 
    test_calculate_combinations();
+   test_calculate_convolutions();
    test_calculate_average_pooling_outputs();
    test_calculate_max_pooling_outputs();
 
@@ -1179,10 +1571,13 @@ void ConvolutionalLayerTest::run_test_case()
    // Forward propagate
 
     test_forward_propagation();
+    test_forward_propagate_max_pooling();
 
    // Back_propagate
 
    test_calculate_hidden_delta_perceptron_test();
+   test_calculate_error_gradient();
+   test_calculate_hidden_delta_addition();
 
    //Utils
    test_memcpy_approach();
@@ -40,6 +40,7 @@ public:
    // Combinations
 
    void test_calculate_combinations();
+   void test_calculate_convolutions();
 
    ///@move to polling
    void test_calculate_average_pooling_outputs();
@@ -61,10 +62,16 @@ public:
 
   void test_forward_propagate();
 
+  void test_forward_propagate_max_pooling();
+
   //Back propagate
 
   void test_calculate_hidden_delta_perceptron_test();
 
+  void test_calculate_error_gradient();
+
+  void test_calculate_hidden_delta_addition();
+
   // Utils
 
   void test_memcpy_approach();
@@ -342,6 +342,64 @@ void CorrelationsTest::test_cross_correlations()
 }
 
 
+void CorrelationsTest::test_missing_values_mask()
+{
+    cout << "test_missing_values_mask\n";
+
+    Tensor<type, 1> x(6);
+    x.setValues({type(1), type(2), type(NAN), type(4), type(5), type(6)});
+
+    Tensor<type, 1> y(6);
+    y.setValues({type(2), type(4), type(6), type(NAN), type(10), type(13)});
+
+    Tensor<type, 1> x_filtered(4);
+    x_filtered.setValues({type(1), type(2), type(5), type(6)});
+
+    Tensor<type, 1> y_filtered(4);
+    y_filtered.setValues({type(2), type(4), type(10), type(13)});
+
+    MissingValuesMask mask;
+
+    // Test
+
+    mask = missing_values_mask(x, y);
+
+    assert_true(mask.has_missing_values(), LOG);
+    assert_true(mask.valid_rows_number == 4, LOG);
+    assert_true(!mask.is_valid(2) && !mask.is_valid(3), LOG);
+    assert_true(mask.is_valid(0) && mask.is_valid(5), LOG);
+
+    assert_true(abs(linear_correlation(thread_pool_device, x, y).r
+                  - linear_correlation(thread_pool_device, x_filtered, y_filtered).r) < type(NUMERIC_LIMITS_MIN), LOG);
+
+    // Test
+
+    mask = missing_values_mask(x_filtered, y_filtered);
+
+    assert_true(!mask.has_missing_values(), LOG);
+    assert_true(mask.valid_rows_number == 4, LOG);
+    assert_true(mask.valid_rows.size() == 0, LOG);
+
+    // Test
+
+    Tensor<type, 2> x_matrix(6, 1);
+    x_matrix.setValues({{type(1)}, {type(2)}, {type(3)}, {type(4)}, {type(5)}, {type(6)}});
+
+    Tensor<type, 2> y_matrix(6, 2);
+    y_matrix.setValues({{type(0), type(1)}, {type(1), type(0)}, {type(0), type(NAN)}, {type(1), type(0)}, {type(0), type(1)}, {type(1), type(0)}});
+
+    mask = missing_values_mask(x_matrix, y_matrix);
+
+    assert_true(mask.valid_rows_number == 5, LOG);
+    assert_true(!mask.is_valid(2), LOG);
+
+    mask = missing_values_mask(x_matrix, y_matrix, 0, 0);
+
+    assert_true(!mask.has_missing_values(), LOG);
+    assert_true(mask.valid_rows_number == 6, LOG);
+}
+
+
 void CorrelationsTest::run_test_case()
 {
     cout << "Running correlation analysis test case...\n";
@@ -366,6 +424,10 @@ void CorrelationsTest::run_test_case()
 
     test_cross_correlations();
 
+    // Missing values methods
+
+    test_missing_values_mask();
+
     cout << "End of correlation analysis test case.\n\n";
 }
 
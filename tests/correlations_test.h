@@ -45,6 +45,10 @@ public:
 
     void test_cross_correlations();
 
+    // Missing values methods
+
+    void test_missing_values_mask();
+
     // Unit testing methods
 
     void run_test_case();
@@ -0,0 +1,528 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   E M B E D D I N G   L A Y E R   T E S T   C L A S S
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#include "embedding_layer_test.h"
+
+
+EmbeddingLayerTest::EmbeddingLayerTest() : UnitTesting()
+{
+}
+
+
+EmbeddingLayerTest::~EmbeddingLayerTest()
+{
+}
+
+
+void EmbeddingLayerTest::test_constructor()
+{
+    cout << "test_constructor\n";
+
+    EmbeddingLayer embedding_layer_1(10, 4, 3);
+
+    assert_true(embedding_layer_1.get_input_dim() == 10, LOG);
+    assert_true(embedding_layer_1.get_input_length() == 4, LOG);
+    assert_true(embedding_layer_1.get_depth() == 3, LOG);
+    assert_true(embedding_layer_1.get_parameters_number() == 30, LOG);
+    assert_true(embedding_layer_1.get_lookup_table().dimension(0) == 3, LOG);
+    assert_true(embedding_layer_1.get_lookup_table().dimension(1) == 10, LOG);
+    assert_true(embedding_layer_1.has_sparse_gradient(), LOG);
+}
+
+
+void EmbeddingLayerTest::test_forward_propagate()
+{
+    cout << "test_forward_propagate\n";
+
+    batch_samples_number = 2;
+    input_dim = 5;
+    input_length = 3;
+    depth = 4;
+
+    embedding_layer.set(input_dim, input_length, depth);
+
+    Tensor<type, 2> lookup_table(depth, input_dim);
+
+    for(Index i = 0; i < lookup_table.size(); i++) lookup_table(i) = type(i);
+
+    embedding_layer.set_lookup_table(lookup_table);
+
+    Tensor<type, 2> inputs(batch_samples_number, input_length);
+    inputs.setValues({{4, 0, 4}, {2, 1, 0}});
+
+    Tensor<Index, 1> inputs_dimensions = get_dimensions(inputs);
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), inputs_dimensions);
+
+    EmbeddingLayerForwardPropagation embedding_layer_forward_propagation(batch_samples_number, &embedding_layer);
+
+    embedding_layer.forward_propagate(inputs_pair, &embedding_layer_forward_propagation, false);
+
+    const TensorMap<Tensor<type, 3>> outputs = embedding_layer_forward_propagation.outputs(0).to_tensor_map<3>();
+
+    assert_true(outputs.dimension(0) == batch_samples_number, LOG);
+    assert_true(outputs.dimension(1) == input_length, LOG);
+    assert_true(outputs.dimension(2) == depth, LOG);
+
+    bool is_lookup = true;
+
+    for(Index b = 0; b < batch_samples_number; b++)
+        for(Index t = 0; t < input_length; t++)
+            for(Index j = 0; j < depth; j++)
+                if(outputs(b, t, j) != lookup_table(j, Index(inputs(b, t)))) is_lookup = false;
+
+    assert_true(is_lookup, LOG);
+
+    // Input values out of range
+
+    inputs(1, 2) = type(input_dim);
+
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), inputs_dimensions);
+
+    try
+    {
+        embedding_layer.forward_propagate(inputs_pair, &embedding_layer_forward_propagation, false);
+
+        assert_true(false, LOG);
+    }
+    catch(const invalid_argument&)
+    {
+        assert_true(true, LOG);
+    }
+}
+
+
+void EmbeddingLayerTest::test_forward_propagate_positional_encoding()
+{
+    cout << "test_forward_propagate_positional_encoding\n";
+
+    batch_samples_number = 2;
+    input_dim = 6;
+    input_length = 4;
+    depth = 5;
+
+    Tensor<type, 2> inputs(batch_samples_number, input_length);
+    inputs.setValues({{5, 0, 3, 3}, {1, 2, 0, 4}});
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    // Sinusoidal
+
+    embedding_layer.set(input_dim, input_length, depth, EmbeddingLayer::PositionalEncoding::Sinusoidal);
+
+    assert_true(embedding_layer.get_parameters_number() == input_dim*depth, LOG);
+
+    const Tensor<type, 2>& positional_encoding_matrix = embedding_layer.get_positional_encoding_matrix();
+
+    assert_true(positional_encoding_matrix.dimension(0) == input_length, LOG);
+    assert_true(positional_encoding_matrix.dimension(1) == depth, LOG);
+
+    bool is_sinusoidal = true;
+
+    for(Index t = 0; t < input_length; t++)
+    {
+        for(Index j = 0; j < depth; j++)
+        {
+            const type angle = type(t)/pow(type(10000), type(2*(j/2))/type(depth));
+
+            const type expected = j%2 == 0 ? sin(angle) : cos(angle);
+
+            if(abs(positional_encoding_matrix(t, j) - expected) > type(1.0e-5)) is_sinusoidal = false;
+        }
+    }
+
+    assert_true(is_sinusoidal, LOG);
+
+    // Learned, set afterwards
+
+    embedding_layer.set_positional_encoding(EmbeddingLayer::PositionalEncoding::Learned);
+
+    assert_true(embedding_layer.get_parameters_number() == input_dim*depth + input_length*depth, LOG);
+
+    Tensor<type, 2> learned_positional_encoding_matrix(input_length, depth);
+    learned_positional_encoding_matrix.setRandom();
+
+    embedding_layer.set_positional_encoding_matrix(learned_positional_encoding_matrix);
+
+    const Tensor<type, 1> parameters = embedding_layer.get_parameters();
+
+    assert_true(parameters(input_dim*depth + 1) == learned_positional_encoding_matrix(1), LOG);
+
+    Tensor<type, 2> added_positional_encoding_matrix;
+
+    for(Index encoding = 0; encoding < 2; encoding++)
+    {
+        if(encoding == 0)
+        {
+            embedding_layer.set_positional_encoding("Sinusoidal");
+
+            added_positional_encoding_matrix = embedding_layer.build_positional_encoding_matrix();
+        }
+        else
+        {
+            embedding_layer.set_positional_encoding(EmbeddingLayer::PositionalEncoding::Learned);
+            embedding_layer.set_positional_encoding_matrix(learned_positional_encoding_matrix);
+
+            added_positional_encoding_matrix = learned_positional_encoding_matrix;
+        }
+
+        const Tensor<type, 2>& lookup_table = embedding_layer.get_lookup_table();
+
+        EmbeddingLayerForwardPropagation embedding_layer_forward_propagation(batch_samples_number, &embedding_layer);
+
+        embedding_layer.forward_propagate(inputs_pair, &embedding_layer_forward_propagation, false);
+
+        const TensorMap<Tensor<type, 3>> outputs = embedding_layer_forward_propagation.outputs(0).to_tensor_map<3>();
+
+        bool is_added = true;
+
+        for(Index b = 0; b < batch_samples_number; b++)
+            for(Index t = 0; t < input_length; t++)
+                for(Index j = 0; j < depth; j++)
+                    if(abs(outputs(b, t, j) - lookup_table(j, Index(inputs(b, t))) - added_positional_encoding_matrix(t, j)) > type(1.0e-5))
+                        is_added = false;
+
+        assert_true(is_added, LOG);
+    }
+}
+
+
+void EmbeddingLayerTest::test_calculate_error_gradient()
+{
+    cout << "test_calculate_error_gradient\n";
+
+    batch_samples_number = 3;
+    input_dim = 7;
+    input_length = 2;
+    depth = 3;
+
+    embedding_layer.set(input_dim, input_length, depth);
+
+    const Index parameters_number = embedding_layer.get_parameters_number();
+
+    const Index tokens_number = batch_samples_number*input_length;
+
+    EmbeddingLayerForwardPropagation embedding_layer_forward_propagation(batch_samples_number, &embedding_layer);
+
+    EmbeddingLayerBackPropagation embedding_layer_back_propagation(batch_samples_number, &embedding_layer);
+
+    TensorMap<Tensor<type, 3>> deltas(embedding_layer_back_propagation.deltas_data, batch_samples_number, input_length, depth);
+
+    Tensor<type, 2> inputs(batch_samples_number, input_length);
+
+    Tensor<type, 1> gradient(parameters_number + 2);
+    gradient.setConstant(type(-1));
+
+    Tensor<type, 1> dense_gradient(parameters_number);
+
+    vector<pair<Index, Index>> gradient_segments;
+
+    // Two batches, with rows touched in the first and not in the second
+
+    for(Index batch = 0; batch < 2; batch++)
+    {
+        if(batch == 0)
+            inputs.setValues({{3, 1}, {3, 6}, {0, 3}});
+        else
+            inputs.setValues({{2, 2}, {5, 1}, {2, 2}});
+
+        deltas.setRandom();
+
+        embedding_layer.calculate_error_gradient(inputs.data(),
+                                                 &embedding_layer_forward_propagation,
+                                                 &embedding_layer_back_propagation);
+
+        // Dense gradient, as the product of the one-hot encoded inputs and the deltas
+
+        dense_gradient.setZero();
+
+        for(Index b = 0; b < batch_samples_number; b++)
+            for(Index t = 0; t < input_length; t++)
+                for(Index j = 0; j < depth; j++)
+                    dense_gradient(Index(inputs(b, t))*depth + j) += deltas(b, t, j);
+
+        embedding_layer.insert_gradient(&embedding_layer_back_propagation, 1, gradient);
+
+        assert_true(embedding_layer_back_propagation.touched_rows_number == (batch == 0 ? 4 : 3), LOG);
+
+        assert_true(abs(gradient(0) + type(1)) < type(NUMERIC_LIMITS_MIN), LOG);
+        assert_true(abs(gradient(parameters_number + 1) + type(1)) < type(NUMERIC_LIMITS_MIN), LOG);
+
+        bool is_equal = true;
+
+        for(Index i = 0; i < parameters_number; i++)
+            if(abs(gradient(i + 1) - dense_gradient(i)) > type(1.0e-5)) is_equal = false;
+
+        assert_true(is_equal, LOG);
+
+        // Gradient segments
+
+        gradient_segments.clear();
+
+        embedding_layer.insert_gradient_segments(&embedding_layer_back_propagation, 1, gradient_segments);
+
+        assert_true(Index(gradient_segments.size()) == embedding_layer_back_propagation.touched_rows_number, LOG);
+
+        Index segments_size = 0;
+
+        for(size_t i = 0; i < gradient_segments.size(); i++)
+        {
+            assert_true(gradient_segments[i].second == depth, LOG);
+            assert_true((gradient_segments[i].first - 1) % depth == 0, LOG);
+
+            segments_size += gradient_segments[i].second;
+        }
+
+        Tensor<type, 1> segments_gradient(parameters_number);
+        segments_gradient.setZero();
+
+        for(size_t i = 0; i < gradient_segments.size(); i++)
+            for(Index j = 0; j < gradient_segments[i].second; j++)
+                segments_gradient(gradient_segments[i].first - 1 + j) = gradient(gradient_segments[i].first + j);
+
+        is_equal = true;
+
+        for(Index i = 0; i < parameters_number; i++)
+            if(abs(segments_gradient(i) - dense_gradient(i)) > type(1.0e-5)) is_equal = false;
+
+        assert_true(is_equal, LOG);
+        assert_true(segments_size <= tokens_number*depth, LOG);
+    }
+
+    // Set parameters segments
+
+    const Tensor<type, 2> lookup_table = embedding_layer.get_lookup_table();
+
+    Tensor<type, 1> parameters(parameters_number + 1);
+    parameters.setConstant(type(7));
+
+    embedding_layer.set_parameters_segments(parameters, 1, gradient_segments);
+
+    const Tensor<type, 2>& new_lookup_table = embedding_layer.get_lookup_table();
+
+    bool is_segment_set = true;
+
+    for(Index row = 0; row < input_dim; row++)
+    {
+        const bool is_touched = row == 2 || row == 5 || row == 1;
+
+        for(Index j = 0; j < depth; j++)
+        {
+            const type expected = is_touched ? type(7) : lookup_table(j, row);
+
+            if(abs(new_lookup_table(j, row) - expected) > type(NUMERIC_LIMITS_MIN)) is_segment_set = false;
+        }
+    }
+
+    assert_true(is_segment_set, LOG);
+}
+
+
+void EmbeddingLayerTest::test_calculate_positional_encoding_gradient()
+{
+    cout << "test_calculate_positional_encoding_gradient\n";
+
+    batch_samples_number = 3;
+    input_dim = 5;
+    input_length = 2;
+    depth = 2;
+
+    embedding_layer.set(input_dim, input_length, depth, EmbeddingLayer::PositionalEncoding::Learned);
+
+    const Index lookup_table_size = input_dim*depth;
+
+    const Index parameters_number = embedding_layer.get_parameters_number();
+
+    EmbeddingLayerForwardPropagation embedding_layer_forward_propagation(batch_samples_number, &embedding_layer);
+
+    EmbeddingLayerBackPropagation embedding_layer_back_propagation(batch_samples_number, &embedding_layer);
+
+    TensorMap<Tensor<type, 3>> deltas(embedding_layer_back_propagation.deltas_data, batch_samples_number, input_length, depth);
+    deltas.setRandom();
+
+    Tensor<type, 2> inputs(batch_samples_number, input_length);
+    inputs.setValues({{1, 4}, {1, 0}, {4, 4}});
+
+    embedding_layer.calculate_error_gradient(inputs.data(),
+                                             &embedding_layer_forward_propagation,
+                                             &embedding_layer_back_propagation);
+
+    Tensor<type, 1> gradient(parameters_number);
+
+    embedding_layer.insert_gradient(&embedding_layer_back_propagation, 0, gradient);
+
+    bool is_equal = true;
+
+    for(Index t = 0; t < input_length; t++)
+    {
+        for(Index j = 0; j < depth; j++)
+        {
+            type derivative = type(0);
+
+            for(Index b = 0; b < batch_samples_number; b++) derivative += deltas(b, t, j);
+
+            if(abs(gradient(lookup_table_size + t + input_length*j) - derivative) > type(1.0e-5)) is_equal = false;
+        }
+    }
+
+    assert_true(is_equal, LOG);
+
+    // Gradient segments
+
+    vector<pair<Index, Index>> gradient_segments;
+
+    embedding_layer.insert_gradient_segments(&embedding_layer_back_propagation, 0, gradient_segments);
+
+    assert_true(gradient_segments.size() == 4, LOG);
+    assert_true(gradient_segments.back().first == lookup_table_size, LOG);
+    assert_true(gradient_segments.back().second == input_length*depth, LOG);
+
+    Tensor<type, 1> parameters(parameters_number);
+    parameters.setConstant(type(3));
+
+    embedding_layer.set_parameters_segments(parameters, 0, gradient_segments);
+
+    assert_true(embedding_layer.get_positional_encoding_matrix()(1, 1) == type(3), LOG);
+    assert_true(embedding_layer.get_lookup_table()(0, 4) == type(3), LOG);
+    assert_true(embedding_layer.get_lookup_table()(0, 2) != type(3), LOG);
+}
+
+
+void EmbeddingLayerTest::test_forward_propagate_incremental()
+{
+    cout << "test_forward_propagate_incremental\n";
+
+    batch_samples_number = 2;
+    input_dim = 6;
+    input_length = 5;
+    depth = 4;
+
+    Tensor<type, 2> sequence(batch_samples_number, input_length);
+    sequence.setValues({{5, 0, 3, 3, 1}, {1, 2, 0, 4, 4}});
+
+    Tensor<DynamicTensor<type>, 1> inputs(1);
+
+    embedding_layer.set(input_dim, input_length, depth, EmbeddingLayer::PositionalEncoding::Sinusoidal);
+
+    // All the sequence
+
+    inputs(0) = DynamicTensor<type>(sequence.data(), get_dimensions(sequence));
+
+    EmbeddingLayerForwardPropagation embedding_layer_forward_propagation(batch_samples_number, &embedding_layer);
+
+    embedding_layer.forward_propagate(inputs, &embedding_layer_forward_propagation, false);
+
+    const Tensor<type, 3> expected_outputs = embedding_layer_forward_propagation.outputs(0).to_tensor_map<3>();
+
+    // First positions at once, then one position at a time
+
+    EmbeddingLayerForwardPropagation incremental_forward_propagation(batch_samples_number, &embedding_layer);
+
+    incremental_forward_propagation.is_incremental = true;
+
+    const Index first_positions = 2;
+
+    Index position = 0;
+
+    while(position < input_length)
+    {
+        const Index positions_number = position == 0 ? first_positions : 1;
+
+        Tensor<type, 2> step_inputs = sequence.slice(Eigen::array<Index, 2>({0, position}),
+                                                     Eigen::array<Index, 2>({batch_samples_number, positions_number}));
+
+        inputs(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+        embedding_layer.forward_propagate(inputs, &incremental_forward_propagation, false);
+
+        assert_true(incremental_forward_propagation.positions_number == position + positions_number, LOG);
+        assert_true(incremental_forward_propagation.outputs(0).get_dimension(1) == positions_number, LOG);
+
+        const Eigen::array<Index, 3> offsets = {0, position, 0};
+        const Eigen::array<Index, 3> extents = {batch_samples_number, positions_number, depth};
+
+        const Tensor<type, 3> step_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<3>();
+
+        const Tensor<type, 0> difference = (step_outputs - expected_outputs.slice(offsets, extents)).abs().maximum();
+
+        assert_true(difference(0) < type(1e-6), LOG);
+
+        position += positions_number;
+    }
+
+    // The positional encodings end at the input length
+
+    Tensor<type, 2> next_inputs(batch_samples_number, 1);
+    next_inputs.setZero();
+
+    inputs(0) = DynamicTensor<type>(next_inputs.data(), get_dimensions(next_inputs));
+
+    bool is_thrown = false;
+
+    try
+    {
+        embedding_layer.forward_propagate(inputs, &incremental_forward_propagation, false);
+    }
+    catch(const invalid_argument&)
+    {
+        is_thrown = true;
+    }
+
+    assert_true(is_thrown, LOG);
+
+    // New sequences start at the first position
+
+    incremental_forward_propagation.reset_states();
+
+    embedding_layer.forward_propagate(inputs, &incremental_forward_propagation, false);
+
+    assert_true(incremental_forward_propagation.positions_number == 1, LOG);
+}
+
+
+void EmbeddingLayerTest::run_test_case()
+{
+    cout << "Running embedding layer test case...\n";
+
+    // Constructor and destructor
+
+    test_constructor();
+
+    // Forward propagate
+
+    test_forward_propagate();
+    test_forward_propagate_positional_encoding();
+    test_forward_propagate_incremental();
+
+    // Back propagate
+
+    test_calculate_error_gradient();
+    test_calculate_positional_encoding_gradient();
+
+    cout << "End of embedding layer test case.\n\n";
+}
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) 2005-2021 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -0,0 +1,252 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   B A T C H E R   T E S T   C L A S S
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#include "inference_batcher_test.h"
+
+
+InferenceBatcherTest::InferenceBatcherTest() : UnitTesting()
+{
+}
+
+
+InferenceBatcherTest::~InferenceBatcherTest()
+{
+}
+
+
+void InferenceBatcherTest::test_constructor()
+{
+    cout << "test_constructor\n";
+
+    // Default constructor
+
+    InferenceBatcher inference_batcher_1;
+
+    assert_true(inference_batcher_1.get_neural_network_pointer() == nullptr, LOG);
+    assert_true(!inference_batcher_1.is_running(), LOG);
+
+    // Neural network constructor
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {2, 3, 1});
+
+    InferenceBatcher inference_batcher_2(&neural_network, 8, 100);
+
+    assert_true(inference_batcher_2.get_neural_network_pointer() == &neural_network, LOG);
+    assert_true(inference_batcher_2.get_maximum_batch_samples_number() == 8, LOG);
+    assert_true(inference_batcher_2.get_maximum_latency_microseconds() == 100, LOG);
+    assert_true(inference_batcher_2.is_running(), LOG);
+
+    inference_batcher_2.stop();
+
+    assert_true(!inference_batcher_2.is_running(), LOG);
+}
+
+
+void InferenceBatcherTest::test_calculate_outputs()
+{
+    cout << "test_calculate_outputs\n";
+
+    const Index threads_number = 4;
+    const Index requests_number = 25;
+
+    Tensor<type, 2> inputs;
+    Tensor<type, 2> outputs;
+
+    Tensor<Index, 1> inputs_dimensions(2);
+
+    vector<future<Tensor<type, 1>>> outputs_futures(threads_number*requests_number);
+
+    vector<thread> threads;
+
+    // Test
+
+    inputs_number = 3;
+    outputs_number = 2;
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {inputs_number, 5, outputs_number});
+    neural_network.set_parameters_random();
+
+    inputs.resize(threads_number*requests_number, inputs_number);
+    inputs.setRandom();
+
+    inputs_dimensions.setValues({threads_number*requests_number, inputs_number});
+
+    outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    InferenceBatcher inference_batcher(&neural_network, 8, 1000);
+
+    for(Index i = 0; i < threads_number; i++)
+    {
+        threads.push_back(thread([&, i]()
+        {
+            for(Index j = 0; j < requests_number; j++)
+            {
+                const Index sample_index = i*requests_number + j;
+
+                const Tensor<type, 1> sample_inputs = inputs.chip(sample_index, 0);
+
+                outputs_futures[sample_index] = inference_batcher.calculate_outputs(sample_inputs);
+            }
+        }));
+    }
+
+    for(Index i = 0; i < threads_number; i++)
+    {
+        threads[i].join();
+    }
+
+    for(Index i = 0; i < threads_number*requests_number; i++)
+    {
+        const Tensor<type, 1> sample_outputs = outputs_futures[i].get();
+
+        assert_true(sample_outputs.size() == outputs_number, LOG);
+
+        for(Index j = 0; j < outputs_number; j++)
+        {
+            assert_true(abs(sample_outputs(j) - outputs(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+        }
+    }
+
+    // Histograms
+
+    const Histogram batch_samples_histogram = inference_batcher.get_batch_samples_histogram();
+    const Histogram queue_latency_histogram = inference_batcher.get_queue_latency_histogram();
+
+    Index batch_samples_sum = 0;
+
+    for(Index i = 0; i < batch_samples_histogram.get_bins_number(); i++)
+    {
+        batch_samples_sum += Index(batch_samples_histogram.centers(i))*batch_samples_histogram.frequencies(i);
+    }
+
+    Tensor<Index, 0> queue_latency_sum = queue_latency_histogram.frequencies.sum();
+
+    assert_true(batch_samples_histogram.get_bins_number() == 8, LOG);
+    assert_true(batch_samples_sum == threads_number*requests_number, LOG);
+    assert_true(queue_latency_sum(0) == threads_number*requests_number, LOG);
+
+    // Test
+
+    inference_batcher.stop();
+
+    try
+    {
+        inference_batcher.calculate_outputs(inputs.chip(0, 0));
+
+        assert_true(false, LOG);
+    }
+    catch(const logic_error&)
+    {
+        assert_true(true, LOG);
+    }
+}
+
+
+void InferenceBatcherTest::test_calculate_partial_batches_outputs()
+{
+    cout << "test_calculate_partial_batches_outputs\n";
+
+    Tensor<type, 2> inputs;
+    Tensor<type, 2> outputs;
+
+    Tensor<Index, 1> inputs_dimensions(2);
+
+    vector<future<Tensor<type, 1>>> outputs_futures;
+
+    // Test
+
+    inputs_number = 3;
+    outputs_number = 2;
+
+    const Index samples_number = 8;
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {inputs_number, 5, outputs_number});
+    neural_network.set_parameters_random();
+
+    inputs.resize(samples_number, inputs_number);
+    inputs.setRandom();
+
+    inputs_dimensions.setValues({samples_number, inputs_number});
+
+    outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    InferenceBatcher inference_batcher(&neural_network, 4, 100);
+
+    // Batches of 1, 3 and 4 samples, the first two closed by the maximum latency
+
+    Tensor<Index, 1> batches_samples_numbers(3);
+    batches_samples_numbers.setValues({1, 3, 4});
+
+    Index sample_index = 0;
+
+    for(Index i = 0; i < batches_samples_numbers.size(); i++)
+    {
+        outputs_futures.clear();
+
+        for(Index j = 0; j < batches_samples_numbers(i); j++)
+        {
+            const Tensor<type, 1> sample_inputs = inputs.chip(sample_index + j, 0);
+
+            outputs_futures.push_back(inference_batcher.calculate_outputs(sample_inputs));
+        }
+
+        for(Index j = 0; j < batches_samples_numbers(i); j++)
+        {
+            const Tensor<type, 1> sample_outputs = outputs_futures[j].get();
+
+            for(Index k = 0; k < outputs_number; k++)
+            {
+                assert_true(abs(sample_outputs(k) - outputs(sample_index + j, k)) < type(NUMERIC_LIMITS_MIN), LOG);
+            }
+        }
+
+        sample_index += batches_samples_numbers(i);
+    }
+
+    const Histogram batch_samples_histogram = inference_batcher.get_batch_samples_histogram();
+
+    const Tensor<Index, 0> batches_number = batch_samples_histogram.frequencies.sum();
+
+    assert_true(batches_number(0) >= batches_samples_numbers.size(), LOG);
+}
+
+
+void InferenceBatcherTest::run_test_case()
+{
+    cout << "Running inference batcher test case...\n";
+
+    // Constructor and destructor methods
+
+    test_constructor();
+
+    // Output methods
+
+    test_calculate_outputs();
+
+    test_calculate_partial_batches_outputs();
+
+    cout << "End of inference batcher test case.\n\n";
+}
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) 2005-2021 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -0,0 +1,65 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   B A T C H E R   T E S T   C L A S S   H E A D E R
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#ifndef INFERENCEBATCHERTEST_H
+#define INFERENCEBATCHERTEST_H
+
+// Unit testing includes
+
+#include "../opennn/unit_testing.h"
+
+class InferenceBatcherTest : public UnitTesting
+{
+
+public:
+
+   explicit InferenceBatcherTest();
+
+   virtual ~InferenceBatcherTest();
+
+   // Constructor and destructor methods
+
+   void test_constructor();
+
+   // Output methods
+
+   void test_calculate_outputs();
+
+   void test_calculate_partial_batches_outputs();
+
+   // Unit testing methods
+
+   void run_test_case();
+
+private:
+
+   Index inputs_number;
+   Index outputs_number;
+
+   NeuralNetwork neural_network;
+};
+
+#endif
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) 2005-2021 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
@@ -0,0 +1,280 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   I N F E R E N C E   S E S S I O N   T E S T   C L A S S
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#include "inference_session_test.h"
+
+
+InferenceSessionTest::InferenceSessionTest() : UnitTesting()
+{
+}
+
+
+InferenceSessionTest::~InferenceSessionTest()
+{
+}
+
+
+void InferenceSessionTest::test_constructor()
+{
+    cout << "test_constructor\n";
+
+    // Default constructor
+
+    InferenceSession inference_session_1;
+
+    assert_true(inference_session_1.get_neural_network_pointer() == nullptr, LOG);
+    assert_true(inference_session_1.get_maximum_batch_samples_number() == 0, LOG);
+
+    // Neural network constructor
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {2, 3, 1});
+
+    InferenceSession inference_session_2(&neural_network, 10);
+
+    assert_true(inference_session_2.get_neural_network_pointer() == &neural_network, LOG);
+    assert_true(inference_session_2.get_maximum_batch_samples_number() == 10, LOG);
+    assert_true(inference_session_2.get_batch_samples_number() == 10, LOG);
+    assert_true(inference_session_2.get_outputs_number() == 1, LOG);
+}
+
+
+void InferenceSessionTest::test_calculate_outputs()
+{
+    cout << "test_calculate_outputs\n";
+
+    Tensor<type, 2> inputs;
+    Tensor<type, 2> outputs;
+    Tensor<type, 2> session_outputs;
+
+    Tensor<Index, 1> inputs_dimensions(2);
+
+    // Test
+
+    inputs_number = 3;
+    outputs_number = 2;
+    batch_samples_number = 4;
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {inputs_number, 5, 5, outputs_number});
+    neural_network.set_parameters_random();
+
+    inputs.resize(batch_samples_number, inputs_number);
+    inputs.setRandom();
+
+    inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+    outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    inference_session.set(&neural_network, batch_samples_number);
+
+    session_outputs.resize(batch_samples_number, outputs_number);
+
+    for(Index i = 0; i < 2; i++)
+    {
+        session_outputs.setZero();
+
+        inference_session.calculate_outputs(inputs.data(), batch_samples_number, session_outputs.data());
+
+        for(Index j = 0; j < batch_samples_number; j++)
+        {
+            for(Index k = 0; k < outputs_number; k++)
+            {
+                assert_true(abs(session_outputs(j,k) - outputs(j,k)) < type(NUMERIC_LIMITS_MIN), LOG);
+            }
+        }
+    }
+
+    // Test
+
+    batch_samples_number = 1;
+
+    inputs.resize(batch_samples_number, inputs_number);
+    inputs.setRandom();
+
+    inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+    outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    session_outputs.resize(batch_samples_number, outputs_number);
+
+    inference_session.calculate_outputs(inputs.data(), batch_samples_number, session_outputs.data());
+
+    assert_true(inference_session.get_batch_samples_number() == batch_samples_number, LOG);
+    assert_true(abs(session_outputs(0,0) - outputs(0,0)) < type(NUMERIC_LIMITS_MIN), LOG);
+    assert_true(abs(session_outputs(0,1) - outputs(0,1)) < type(NUMERIC_LIMITS_MIN), LOG);
+
+    // Test
+
+    Tensor<Index, 1> batches_samples_numbers(3);
+    batches_samples_numbers.setValues({3, 4, 2});
+
+    for(Index i = 0; i < batches_samples_numbers.size(); i++)
+    {
+        batch_samples_number = batches_samples_numbers(i);
+
+        inputs.resize(batch_samples_number, inputs_number);
+        inputs.setRandom();
+
+        inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+        outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+        session_outputs.resize(batch_samples_number, outputs_number);
+
+        inference_session.calculate_outputs(inputs.data(), batch_samples_number, session_outputs.data());
+
+        assert_true(inference_session.get_batch_samples_number() == batch_samples_number, LOG);
+        assert_true(inference_session.get_maximum_batch_samples_number() == 4, LOG);
+
+        for(Index j = 0; j < batch_samples_number; j++)
+        {
+            for(Index k = 0; k < outputs_number; k++)
+            {
+                assert_true(abs(session_outputs(j,k) - outputs(j,k)) < type(NUMERIC_LIMITS_MIN), LOG);
+            }
+        }
+    }
+
+    // Test
+
+    try
+    {
+        inference_session.calculate_outputs(inputs.data(), 5, session_outputs.data());
+
+        assert_true(false, LOG);
+    }
+    catch(const invalid_argument&)
+    {
+        assert_true(true, LOG);
+    }
+}
+
+
+void InferenceSessionTest::test_inference_session_pool()
+{
+    cout << "test_inference_session_pool\n";
+
+    const Index threads_number = 4;
+    const Index calls_number = 50;
+
+    Tensor<type, 2> inputs;
+    Tensor<type, 2> outputs;
+
+    Tensor<Index, 1> inputs_dimensions(2);
+
+    vector<Tensor<type, 2>> threads_outputs(threads_number);
+
+    vector<thread> threads;
+
+    // Test
+
+    inputs_number = 3;
+    outputs_number = 2;
+    batch_samples_number = 4;
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {inputs_number, 5, outputs_number});
+    neural_network.set_parameters_random();
+
+    inputs.resize(batch_samples_number, inputs_number);
+    inputs.setRandom();
+
+    inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+    outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    InferenceSessionPool inference_session_pool(&neural_network, batch_samples_number, 2);
+
+    assert_true(inference_session_pool.get_sessions_number() == 2, LOG);
+
+    for(Index i = 0; i < threads_number; i++)
+    {
+        threads_outputs[i].resize(batch_samples_number, outputs_number);
+        threads_outputs[i].setZero();
+
+        threads.push_back(thread([&, i]()
+        {
+            for(Index j = 0; j < calls_number; j++)
+            {
+                inference_session_pool.calculate_outputs(inputs.data(), batch_samples_number, threads_outputs[i].data());
+            }
+        }));
+    }
+
+    for(Index i = 0; i < threads_number; i++)
+    {
+        threads[i].join();
+    }
+
+    for(Index i = 0; i < threads_number; i++)
+    {
+        for(Index j = 0; j < batch_samples_number; j++)
+        {
+            for(Index k = 0; k < outputs_number; k++)
+            {
+                assert_true(abs(threads_outputs[i](j,k) - outputs(j,k)) < type(NUMERIC_LIMITS_MIN), LOG);
+            }
+        }
+    }
+
+    // Test
+
+    const int maximum_threads_number = omp_get_max_threads();
+
+    InferenceSession inference_session(&neural_network, batch_samples_number);
+    inference_session.set_threads_number(1);
+
+    assert_true(inference_session.get_threads_number() == 1, LOG);
+
+    Tensor<type, 2> session_outputs(batch_samples_number, outputs_number);
+
+    inference_session.calculate_outputs(inputs.data(), batch_samples_number, session_outputs.data());
+
+    assert_true(omp_get_max_threads() == maximum_threads_number, LOG);
+
+    for(Index j = 0; j < batch_samples_number; j++)
+    {
+        for(Index k = 0; k < outputs_number; k++)
+        {
+            assert_true(abs(session_outputs(j,k) - outputs(j,k)) < type(NUMERIC_LIMITS_MIN), LOG);
+        }
+    }
+}
+
+
+void InferenceSessionTest::run_test_case()
+{
+    cout << "Running inference session test case...\n";
+
+    // Constructor and destructor methods
+
+    test_constructor();
+
+    // Output methods
+
+    test_calculate_outputs();
+
+    test_inference_session_pool();
+
+    cout << "End of inference session test case.\n\n";
+}
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) 2005-2021 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
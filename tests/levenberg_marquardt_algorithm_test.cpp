@@ -151,6 +151,82 @@ void LevenbergMarquardtAlgorithmTest::test_perform_training()
 }
 
 
+void LevenbergMarquardtAlgorithmTest::test_perform_training_double_precision()
+{
+    cout << "test_perform_training_double_precision\n";
+
+    TrainingResults training_results;
+
+    // Test
+
+    data_set.set(20, 2, 1);
+    data_set.set_data_random();
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, {2, 3, 1});
+    neural_network.set_parameters_random();
+
+    Tensor<type, 1> initial_parameters = neural_network.get_parameters();
+
+    levenberg_marquardt_algorithm.set_double_precision(true);
+
+    assert_true(levenberg_marquardt_algorithm.get_double_precision(), LOG);
+
+    levenberg_marquardt_algorithm.set_loss_goal(type(0));
+    levenberg_marquardt_algorithm.set_minimum_loss_decrease(type(0));
+    levenberg_marquardt_algorithm.set_maximum_epochs_number(1);
+    levenberg_marquardt_algorithm.set_display(false);
+
+    training_results = levenberg_marquardt_algorithm.perform_training();
+
+    const type first_loss = training_results.get_loss();
+
+    levenberg_marquardt_algorithm.set_maximum_epochs_number(20);
+
+    training_results = levenberg_marquardt_algorithm.perform_training();
+
+    // Steps which fail at the maximum damping move the parameters by the machine epsilon, and can increase the loss slightly
+
+    assert_true(training_results.get_loss() <= first_loss*(type(1) + type(1.0e-3)), LOG);
+
+    // Test
+
+    neural_network.set_parameters(initial_parameters);
+
+    levenberg_marquardt_algorithm.set_damping_parameter(type(1.0e-3));
+    levenberg_marquardt_algorithm.set_maximum_epochs_number(1);
+
+    training_results = levenberg_marquardt_algorithm.perform_training();
+
+    const type double_precision_error = training_results.get_training_error();
+
+    neural_network.set_parameters(initial_parameters);
+
+    levenberg_marquardt_algorithm.set_damping_parameter(type(1.0e-3));
+    levenberg_marquardt_algorithm.set_double_precision(false);
+
+    training_results = levenberg_marquardt_algorithm.perform_training();
+
+    assert_true(abs(training_results.get_training_error() - double_precision_error) < type(1.0e-3)*(type(1) + double_precision_error), LOG);
+
+    // Test
+
+    levenberg_marquardt_algorithm.set_double_precision(true);
+
+    tinyxml2::XMLPrinter file_stream;
+    levenberg_marquardt_algorithm.write_XML(file_stream);
+
+    tinyxml2::XMLDocument document;
+    document.Parse(file_stream.CStr());
+
+    levenberg_marquardt_algorithm.set_double_precision(false);
+    levenberg_marquardt_algorithm.from_XML(document);
+
+    assert_true(levenberg_marquardt_algorithm.get_double_precision(), LOG);
+
+    levenberg_marquardt_algorithm.set_double_precision(false);
+}
+
+
 void LevenbergMarquardtAlgorithmTest::run_test_case()
 {
     cout << "Running Levenberg-Marquardt algorithm test case...\n";
@@ -164,6 +240,8 @@ void LevenbergMarquardtAlgorithmTest::run_test_case()
 
     test_perform_training();
 
+    test_perform_training_double_precision();
+
     cout << "End of Levenberg-Marquardt algorithm test case.\n\n";
 }
 
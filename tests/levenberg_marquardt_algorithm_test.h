@@ -32,6 +32,8 @@ public:
 
     void test_perform_training();
 
+    void test_perform_training_double_precision();
+
     // Unit testing methods
 
     void run_test_case();
@@ -384,6 +384,292 @@ void LongShortTermMemoryLayerTest::test_forward_propagate()
 }
 
 
+void LongShortTermMemoryLayerTest::test_forward_propagate_sequences()
+{
+    cout << "test_forward_propagate_sequences\n";
+
+    const Index inputs_number = 3;
+    const Index neurons_number = 4;
+    const Index timesteps = 3;
+
+    // Two sequences and a shorter one
+
+    const Index samples_number = 7;
+
+    LongShortTermMemoryLayer long_short_term_layer(inputs_number, neurons_number);
+
+    long_short_term_layer.set_timesteps(timesteps);
+    long_short_term_layer.set_activation_function(LongShortTermMemoryLayer::ActivationFunction::HyperbolicTangent);
+    long_short_term_layer.set_recurrent_activation_function(LongShortTermMemoryLayer::ActivationFunction::Logistic);
+    long_short_term_layer.set_parameters_random();
+
+    Tensor<type, 2> inputs(samples_number, inputs_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    LongShortTermMemoryLayerForwardPropagation long_short_term_layer_forward_propagation(samples_number, &long_short_term_layer);
+
+    long_short_term_layer.forward_propagate(inputs_pair, &long_short_term_layer_forward_propagation, true);
+
+    const TensorMap<Tensor<type, 2>> outputs = long_short_term_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    // Sample by sample
+
+    const Tensor<type, 2> forget_weights = long_short_term_layer.get_forget_weights();
+    const Tensor<type, 2> input_weights = long_short_term_layer.get_input_weights();
+    const Tensor<type, 2> state_weights = long_short_term_layer.get_state_weights();
+    const Tensor<type, 2> output_weights = long_short_term_layer.get_output_weights();
+
+    const Tensor<type, 2> forget_recurrent_weights = long_short_term_layer.get_forget_recurrent_weights();
+    const Tensor<type, 2> input_recurrent_weights = long_short_term_layer.get_input_recurrent_weights();
+    const Tensor<type, 2> state_recurrent_weights = long_short_term_layer.get_state_recurrent_weights();
+    const Tensor<type, 2> output_recurrent_weights = long_short_term_layer.get_output_recurrent_weights();
+
+    const Tensor<type, 1> forget_biases = long_short_term_layer.get_forget_biases();
+    const Tensor<type, 1> input_biases = long_short_term_layer.get_input_biases();
+    const Tensor<type, 1> state_biases = long_short_term_layer.get_state_biases();
+    const Tensor<type, 1> output_biases = long_short_term_layer.get_output_biases();
+
+    const Eigen::array<IndexPair<Index>, 1> AT_B = {IndexPair<Index>(0, 0)};
+
+    Tensor<type, 1> hidden_states(neurons_number);
+    Tensor<type, 1> cell_states(neurons_number);
+
+    for(Index i = 0; i < samples_number; i++)
+    {
+        if(i%timesteps == 0)
+        {
+            hidden_states.setZero();
+            cell_states.setZero();
+        }
+
+        const Tensor<type, 1> current_inputs = inputs.chip(i, 0);
+
+        const Tensor<type, 1> forget_activations
+                = (type(1) + (-(current_inputs.contract(forget_weights, AT_B) + hidden_states.contract(forget_recurrent_weights, AT_B) + forget_biases)).exp()).inverse();
+
+        const Tensor<type, 1> input_activations
+                = (type(1) + (-(current_inputs.contract(input_weights, AT_B) + hidden_states.contract(input_recurrent_weights, AT_B) + input_biases)).exp()).inverse();
+
+        const Tensor<type, 1> state_activations
+                = (current_inputs.contract(state_weights, AT_B) + hidden_states.contract(state_recurrent_weights, AT_B) + state_biases).tanh();
+
+        const Tensor<type, 1> output_activations
+                = (type(1) + (-(current_inputs.contract(output_weights, AT_B) + hidden_states.contract(output_recurrent_weights, AT_B) + output_biases)).exp()).inverse();
+
+        cell_states = forget_activations*cell_states + input_activations*state_activations;
+
+        hidden_states = output_activations*cell_states.tanh();
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            assert_true(abs(outputs(i, j) - hidden_states(j)) < type(1e-5), LOG);
+            assert_true(abs(long_short_term_layer_forward_propagation.cell_states_activations(i, j) - cell_states(j)) < type(1e-5), LOG);
+            assert_true(abs(long_short_term_layer_forward_propagation.forget_activations_derivatives(i, j)
+                            - forget_activations(j)*(type(1) - forget_activations(j))) < type(1e-5), LOG);
+        }
+    }
+
+    // Parameters vector
+
+    Tensor<type, 1> parameters = long_short_term_layer.get_parameters();
+
+    LongShortTermMemoryLayerForwardPropagation parameters_forward_propagation(samples_number, &long_short_term_layer);
+
+    long_short_term_layer.forward_propagate(inputs_pair, parameters, &parameters_forward_propagation);
+
+    const TensorMap<Tensor<type, 2>> parameters_outputs = parameters_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    for(Index i = 0; i < outputs.size(); i++)
+    {
+        assert_true(abs(outputs(i) - parameters_outputs(i)) < type(1e-6), LOG);
+    }
+}
+
+
+void LongShortTermMemoryLayerTest::test_forward_propagate_incremental()
+{
+    cout << "test_forward_propagate_incremental\n";
+
+    const Index inputs_number = 3;
+    const Index neurons_number = 4;
+    const Index timesteps = 5;
+
+    LongShortTermMemoryLayer long_short_term_memory_layer(inputs_number, neurons_number);
+
+    long_short_term_memory_layer.set_timesteps(timesteps);
+    long_short_term_memory_layer.set_parameters_random();
+
+    Tensor<type, 2> inputs(timesteps, inputs_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    LongShortTermMemoryLayerForwardPropagation forward_propagation(timesteps, &long_short_term_memory_layer);
+
+    long_short_term_memory_layer.forward_propagate(inputs_pair, &forward_propagation, false);
+
+    const TensorMap<Tensor<type, 2>> outputs = forward_propagation.outputs(0).to_tensor_map<2>();
+
+    // One timestep at a time
+
+    LongShortTermMemoryLayerForwardPropagation incremental_forward_propagation(1, &long_short_term_memory_layer);
+
+    incremental_forward_propagation.is_incremental = true;
+
+    Tensor<type, 2> step_inputs(1, inputs_number);
+
+    for(Index i = 0; i < timesteps; i++)
+    {
+        step_inputs.chip(0, 0) = inputs.chip(i, 0);
+
+        inputs_pair(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+        long_short_term_memory_layer.forward_propagate(inputs_pair, &incremental_forward_propagation, false);
+
+        const TensorMap<Tensor<type, 2>> step_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<2>();
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            assert_true(abs(step_outputs(0, j) - outputs(i, j)) < type(1e-5), LOG);
+        }
+    }
+
+    // Reset states
+
+    incremental_forward_propagation.reset_states();
+
+    step_inputs.chip(0, 0) = inputs.chip(0, 0);
+
+    inputs_pair(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+    long_short_term_memory_layer.forward_propagate(inputs_pair, &incremental_forward_propagation, false);
+
+    const TensorMap<Tensor<type, 2>> step_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    for(Index j = 0; j < neurons_number; j++)
+    {
+        assert_true(abs(step_outputs(0, j) - outputs(0, j)) < type(1e-5), LOG);
+    }
+}
+
+
+void LongShortTermMemoryLayerTest::test_calculate_error_gradient()
+{
+    cout << "test_calculate_error_gradient\n";
+
+    const Index inputs_number = 3;
+    const Index neurons_number = 4;
+    const Index timesteps = 4;
+    const Index samples_number = 7;
+
+    LongShortTermMemoryLayer long_short_term_layer(inputs_number, neurons_number);
+
+    long_short_term_layer.set_timesteps(timesteps);
+    long_short_term_layer.set_recurrent_activation_function(LongShortTermMemoryLayer::ActivationFunction::Logistic);
+    long_short_term_layer.set_parameters_random();
+
+    const Index parameters_number = long_short_term_layer.get_parameters_number();
+
+    Tensor<type, 2> inputs(samples_number, inputs_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    // The error is the sum of the outputs times some random weights, which are then the deltas
+
+    Tensor<type, 2> error_weights(samples_number, neurons_number);
+    error_weights.setRandom();
+
+    LongShortTermMemoryLayerForwardPropagation long_short_term_layer_forward_propagation(samples_number, &long_short_term_layer);
+    LongShortTermMemoryLayerBackPropagation long_short_term_layer_back_propagation(samples_number, &long_short_term_layer);
+
+    long_short_term_layer.forward_propagate(inputs_pair, &long_short_term_layer_forward_propagation, true);
+
+    copy(error_weights.data(), error_weights.data() + error_weights.size(), long_short_term_layer_back_propagation.deltas_data);
+
+    long_short_term_layer.calculate_error_gradient(inputs.data(),
+                                                   &long_short_term_layer_forward_propagation,
+                                                   &long_short_term_layer_back_propagation);
+
+    Tensor<type, 1> gradient(parameters_number);
+
+    long_short_term_layer.insert_gradient(&long_short_term_layer_back_propagation, 0, gradient);
+
+    // Numerical gradient
+
+    const Tensor<type, 1> parameters = long_short_term_layer.get_parameters();
+
+    const type epsilon = type(1e-2);
+
+    auto calculate_error = [&](const Tensor<type, 1>& new_parameters)
+    {
+        long_short_term_layer.set_parameters(new_parameters);
+
+        long_short_term_layer.forward_propagate(inputs_pair, &long_short_term_layer_forward_propagation, false);
+
+        const Tensor<type, 0> error
+                = (long_short_term_layer_forward_propagation.outputs(0).to_tensor_map<2>()*error_weights).sum();
+
+        return error(0);
+    };
+
+    for(Index i = 0; i < parameters_number; i++)
+    {
+        Tensor<type, 1> perturbed_parameters = parameters;
+
+        perturbed_parameters(i) = parameters(i) + epsilon;
+        const type forward_error = calculate_error(perturbed_parameters);
+
+        perturbed_parameters(i) = parameters(i) - epsilon;
+        const type backward_error = calculate_error(perturbed_parameters);
+
+        const type numerical_derivative = (forward_error - backward_error)/(type(2)*epsilon);
+
+        assert_true(abs(gradient(i) - numerical_derivative) < type(1e-2), LOG);
+    }
+
+    long_short_term_layer.set_parameters(parameters);
+
+    // Truncation as long as the sequences does not change the gradient
+
+    long_short_term_layer.set_truncation_length(timesteps);
+
+    long_short_term_layer.forward_propagate(inputs_pair, &long_short_term_layer_forward_propagation, true);
+
+    long_short_term_layer.calculate_error_gradient(inputs.data(),
+                                                   &long_short_term_layer_forward_propagation,
+                                                   &long_short_term_layer_back_propagation);
+
+    Tensor<type, 1> truncated_gradient(parameters_number);
+
+    long_short_term_layer.insert_gradient(&long_short_term_layer_back_propagation, 0, truncated_gradient);
+
+    for(Index i = 0; i < parameters_number; i++)
+    {
+        assert_true(abs(gradient(i) - truncated_gradient(i)) < type(1e-6), LOG);
+    }
+
+    // Truncation to a single timestep keeps only the errors of the outputs of each timestep
+
+    long_short_term_layer.set_truncation_length(1);
+
+    long_short_term_layer.calculate_error_gradient(inputs.data(),
+                                                   &long_short_term_layer_forward_propagation,
+                                                   &long_short_term_layer_back_propagation);
+
+    long_short_term_layer.insert_gradient(&long_short_term_layer_back_propagation, 0, truncated_gradient);
+
+    const Tensor<type, 0> difference = (gradient - truncated_gradient).abs().maximum();
+
+    assert_true(difference(0) > type(1e-3), LOG);
+}
+
+
 void LongShortTermMemoryLayerTest::run_test_case()
 {
     cout << "Running long short-term memory layer test case...\n";
@@ -423,6 +709,13 @@ void LongShortTermMemoryLayerTest::run_test_case()
 
     test_forward_propagate();
 
+    test_forward_propagate_sequences();
+    test_forward_propagate_incremental();
+
+    // Back propagate
+
+    test_calculate_error_gradient();
+
     cout << "End of long short-term memory layer test case.\n\n";
 }
 
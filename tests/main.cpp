@@ -35,11 +35,14 @@ int main()
    "convulational_layer | cl\n"
    "descriptives | dsc\n"
    "data_set | ds\n"
+   "embedding_layer | el\n"
    "flatten_layer | fl\n"
    "genetic_algorithm | ga\n"
    "gradient_descent | gd\n"
    "growing_inputs | gi\n"
    "growing_neurons | gn\n"
+   "inference_session | ins\n"
+   "inference_batcher | inb\n"
    "inputs_selection | is\n"
    "learning_rate_algorithm | lra\n"
    "levenberg_marquardt_algorithm | lma\n"
@@ -47,6 +50,7 @@ int main()
    "mean_squared_error | mse\n"
    "minkowski_error | me\n"
    "model_selection | ms\n"
+   "multihead_attention_layer | mal\n"
    "neural_network | nn\n"
    "neurons_selection | ns\n"
    "normalized_squared_error | nse\n"
@@ -175,6 +179,24 @@ int main()
          tests_failed_count += recurrent_layer_test.get_tests_failed_count();
       }
 
+      else if(test == "multihead_attention_layer" || test == "mal")
+      {
+         MultiheadAttentionLayerTest multihead_attention_layer_test;
+         multihead_attention_layer_test.run_test_case();
+         tests_count += multihead_attention_layer_test.get_tests_count();
+         tests_passed_count += multihead_attention_layer_test.get_tests_passed_count();
+         tests_failed_count += multihead_attention_layer_test.get_tests_failed_count();
+      }
+
+      else if(test == "embedding_layer" || test == "el")
+      {
+         EmbeddingLayerTest embedding_layer_test;
+         embedding_layer_test.run_test_case();
+         tests_count += embedding_layer_test.get_tests_count();
+         tests_passed_count += embedding_layer_test.get_tests_passed_count();
+         tests_failed_count += embedding_layer_test.get_tests_failed_count();
+      }
+
       else if(test == "scaling_layer" || test == "sl")
       {
          ScalingLayerTest scaling_layer_test;
@@ -246,6 +268,22 @@ int main()
         tests_passed_count += neural_network_test.get_tests_passed_count();
         tests_failed_count += neural_network_test.get_tests_failed_count();
       }
+      else if(test == "inference_session" || test == "ins")
+      {
+        InferenceSessionTest inference_session_test;
+        inference_session_test.run_test_case();
+        tests_count += inference_session_test.get_tests_count();
+        tests_passed_count += inference_session_test.get_tests_passed_count();
+        tests_failed_count += inference_session_test.get_tests_failed_count();
+      }
+      else if(test == "inference_batcher" || test == "inb")
+      {
+        InferenceBatcherTest inference_batcher_test;
+        inference_batcher_test.run_test_case();
+        tests_count += inference_batcher_test.get_tests_count();
+        tests_passed_count += inference_batcher_test.get_tests_passed_count();
+        tests_failed_count += inference_batcher_test.get_tests_failed_count();
+      }
       else if(test == "sum_squared_error" || test == "sse")
       {
         SumSquaredErrorTest sum_squared_error_test;
@@ -555,6 +593,22 @@ int main()
           tests_passed_count += recurrent_layer_test.get_tests_passed_count();
           tests_failed_count += recurrent_layer_test.get_tests_failed_count();
 
+          // multihead attention layer
+
+          MultiheadAttentionLayerTest multihead_attention_layer_test;
+          multihead_attention_layer_test.run_test_case();
+          tests_count += multihead_attention_layer_test.get_tests_count();
+          tests_passed_count += multihead_attention_layer_test.get_tests_passed_count();
+          tests_failed_count += multihead_attention_layer_test.get_tests_failed_count();
+
+          // embedding layer
+
+          EmbeddingLayerTest embedding_layer_test;
+          embedding_layer_test.run_test_case();
+          tests_count += embedding_layer_test.get_tests_count();
+          tests_passed_count += embedding_layer_test.get_tests_passed_count();
+          tests_failed_count += embedding_layer_test.get_tests_failed_count();
+
           // convolutional layer
 
 //          ConvolutionalLayerTest convolutional_layer_test;
@@ -587,6 +641,22 @@ int main()
           tests_passed_count += neural_network_test.get_tests_passed_count();
           tests_failed_count += neural_network_test.get_tests_failed_count();
 
+          // inference session
+
+          InferenceSessionTest inference_session_test;
+          inference_session_test.run_test_case();
+          tests_count += inference_session_test.get_tests_count();
+          tests_passed_count += inference_session_test.get_tests_passed_count();
+          tests_failed_count += inference_session_test.get_tests_failed_count();
+
+          // inference batcher
+
+          InferenceBatcherTest inference_batcher_test;
+          inference_batcher_test.run_test_case();
+          tests_count += inference_batcher_test.get_tests_count();
+          tests_passed_count += inference_batcher_test.get_tests_passed_count();
+          tests_failed_count += inference_batcher_test.get_tests_failed_count();
+
           // L O S S   I N D E X   T E S T S
 
           // sum squared error
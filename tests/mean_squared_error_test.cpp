@@ -1791,6 +1791,67 @@ void MeanSquaredErrorTest::test_calculate_gradient_convolutional_network()
 
 
 
+void MeanSquaredErrorTest::test_back_propagate_lm_double_precision()
+{
+    cout << "test_back_propagate_lm_double_precision\n";
+
+    // Test approximation random samples, inputs, neurons
+    {
+        samples_number = 1 + rand()%10;
+        inputs_number = 1 + rand()%10;
+        outputs_number = 1;
+        neurons_number = 1 + rand()%10;
+
+        // Data set
+
+        data_set.set(samples_number, inputs_number, outputs_number);
+        data_set.set_data_random();
+        data_set.set_training();
+
+        training_samples_indices = data_set.get_training_samples_indices();
+        input_variables_indices = data_set.get_input_variables_indices();
+        target_variables_indices = data_set.get_target_variables_indices();
+
+        batch.set(samples_number, &data_set);
+        batch.fill(training_samples_indices, input_variables_indices, target_variables_indices);
+
+        // Neural network
+
+        neural_network.set(NeuralNetwork::ProjectType::Approximation, {inputs_number, neurons_number, outputs_number});
+        neural_network.set_parameters_random();
+
+        forward_propagation.set(samples_number, &neural_network);
+        neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+        // Loss index
+
+        mean_squared_error.set_regularization_method(LossIndex::RegularizationMethod::L2);
+
+        back_propagation_lm.set(samples_number, &mean_squared_error);
+        mean_squared_error.back_propagate_lm(batch, forward_propagation, back_propagation_lm);
+
+        LossIndexBackPropagationLM back_propagation_lm_double(samples_number, &mean_squared_error);
+        back_propagation_lm_double.set_double_precision(true);
+        mean_squared_error.back_propagate_lm(batch, forward_propagation, back_propagation_lm_double);
+
+        mean_squared_error.set_regularization_method(LossIndex::RegularizationMethod::NoRegularization);
+
+        const Index parameters_number = neural_network.get_parameters_number();
+
+        assert_true(back_propagation_lm_double.hessian.size() == 0, LOG);
+        assert_true(back_propagation_lm_double.hessian_double.dimension(0) == parameters_number, LOG);
+        assert_true(back_propagation_lm_double.hessian_double.dimension(1) == parameters_number, LOG);
+
+        const Tensor<type, 1> gradient = back_propagation_lm_double.gradient_double.cast<type>();
+        const Tensor<type, 2> hessian = back_propagation_lm_double.hessian_double.cast<type>();
+
+        assert_true(are_equal(back_propagation_lm_double.gradient, back_propagation_lm.gradient, type(1.0e-3)), LOG);
+        assert_true(are_equal(gradient, back_propagation_lm.gradient, type(1.0e-3)), LOG);
+        assert_true(are_equal(hessian, back_propagation_lm.hessian, type(1.0e-3)), LOG);
+    }
+}
+
+
 void MeanSquaredErrorTest::run_test_case()
 {
     cout << "Running mean squared error test case...\n";
@@ -1806,6 +1867,7 @@ void MeanSquaredErrorTest::run_test_case()
 
     test_back_propagate();
     test_back_propagate_lm();
+    test_back_propagate_lm_double_precision();
 
     cout << "End of mean squared error test case.\n\n";
 }
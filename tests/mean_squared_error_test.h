@@ -36,6 +36,8 @@ public:
 
     void test_back_propagate_lm();
 
+    void test_back_propagate_lm_double_precision();
+
     // Unit testing methods
 
     void run_test_case();
@@ -0,0 +1,754 @@
+//   OpenNN: Open Neural Networks Library
+//   www.opennn.net
+//
+//   M U L T I H E A D   A T T E N T I O N   L A Y E R   T E S T   C L A S S
+//
+//   Artificial Intelligence Techniques SL
+//   artelnics@artelnics.com
+
+#include "multihead_attention_layer_test.h"
+
+
+MultiheadAttentionLayerTest::MultiheadAttentionLayerTest() : UnitTesting()
+{
+}
+
+
+MultiheadAttentionLayerTest::~MultiheadAttentionLayerTest()
+{
+}
+
+
+void MultiheadAttentionLayerTest::test_constructor()
+{
+    cout << "test_constructor\n";
+
+    MultiheadAttentionLayer multihead_attention_layer_1(3, 5, 4, 2);
+
+    assert_true(multihead_attention_layer_1.get_input_size() == 3, LOG);
+    assert_true(multihead_attention_layer_1.get_context_size() == 5, LOG);
+    assert_true(multihead_attention_layer_1.get_depth() == 4, LOG);
+    assert_true(multihead_attention_layer_1.get_number_of_heads() == 2, LOG);
+    assert_true(multihead_attention_layer_1.get_parameters_number() == 4*4*4*2, LOG);
+    assert_true(!multihead_attention_layer_1.get_causal_mask(), LOG);
+}
+
+
+/// Calculates the outputs of the layer element by element.
+
+Tensor<type, 3> MultiheadAttentionLayerTest::calculate_outputs(const Tensor<type, 3>& query,
+                                                               const Tensor<type, 3>& key,
+                                                               const Tensor<type, 3>& value)
+{
+    const Tensor<type, 3> query_kernel = multihead_attention_layer.get_query_kernel();
+    const Tensor<type, 3> key_kernel = multihead_attention_layer.get_key_kernel();
+    const Tensor<type, 3> value_kernel = multihead_attention_layer.get_value_kernel();
+    const Tensor<type, 3> projection_kernel = multihead_attention_layer.get_projection_kernel();
+
+    const bool causal_mask = multihead_attention_layer.get_causal_mask();
+
+    Tensor<type, 3> outputs(batch_samples_number, input_size, depth);
+    outputs.setZero();
+
+    Tensor<type, 2> transformed_query(input_size, depth);
+    Tensor<type, 2> transformed_key(context_size, depth);
+    Tensor<type, 2> transformed_value(context_size, depth);
+    Tensor<type, 1> scores(context_size);
+
+    for(Index b = 0; b < batch_samples_number; b++)
+    {
+        for(Index h = 0; h < number_of_heads; h++)
+        {
+            transformed_query.setZero();
+            transformed_key.setZero();
+            transformed_value.setZero();
+
+            for(Index d = 0; d < depth; d++)
+            {
+                for(Index e = 0; e < depth; e++)
+                {
+                    for(Index i = 0; i < input_size; i++)
+                        transformed_query(i, d) += query(b, i, e)*query_kernel(e, d, h);
+
+                    for(Index j = 0; j < context_size; j++)
+                    {
+                        transformed_key(j, d) += key(b, j, e)*key_kernel(e, d, h);
+                        transformed_value(j, d) += value(b, j, e)*value_kernel(e, d, h);
+                    }
+                }
+            }
+
+            for(Index i = 0; i < input_size; i++)
+            {
+                const Index visible_context_size = causal_mask ? i + context_size - input_size + 1 : context_size;
+
+                type maximum = -numeric_limits<type>::infinity();
+
+                for(Index j = 0; j < visible_context_size; j++)
+                {
+                    scores(j) = type(0);
+
+                    for(Index d = 0; d < depth; d++)
+                        scores(j) += transformed_query(i, d)*transformed_key(j, d)/sqrt(type(depth));
+
+                    maximum = max(maximum, scores(j));
+                }
+
+                type sum = type(0);
+
+                for(Index j = 0; j < visible_context_size; j++)
+                {
+                    scores(j) = exp(scores(j) - maximum);
+                    sum += scores(j);
+                }
+
+                for(Index d = 0; d < depth; d++)
+                {
+                    type attention_output = type(0);
+
+                    for(Index j = 0; j < visible_context_size; j++)
+                        attention_output += scores(j)/sum*transformed_value(j, d);
+
+                    for(Index e = 0; e < depth; e++)
+                        outputs(b, i, e) += attention_output*projection_kernel(d, e, h);
+                }
+            }
+        }
+    }
+
+    return outputs;
+}
+
+
+/// Calculates the sum of the outputs of the layer times some weights, whose derivatives with respect to the outputs are those weights.
+
+type MultiheadAttentionLayerTest::calculate_error(const Tensor<type, 3>& query,
+                                                  const Tensor<type, 3>& key,
+                                                  const Tensor<type, 3>& value,
+                                                  const Tensor<type, 3>& weights)
+{
+    const Tensor<type, 0> error = (calculate_outputs(query, key, value)*weights).sum();
+
+    return error(0);
+}
+
+
+void MultiheadAttentionLayerTest::test_forward_propagate()
+{
+    cout << "test_forward_propagate\n";
+
+    Tensor<DynamicTensor<type>, 1> inputs(3);
+
+    // Test
+
+    batch_samples_number = 2;
+    input_size = 3;
+    context_size = 5;
+    depth = 4;
+    number_of_heads = 2;
+
+    multihead_attention_layer.set(input_size, context_size, depth, number_of_heads);
+
+    Tensor<type, 3> query(batch_samples_number, input_size, depth);
+    Tensor<type, 3> key(batch_samples_number, context_size, depth);
+    Tensor<type, 3> value(batch_samples_number, context_size, depth);
+
+    query.setRandom();
+    key.setRandom();
+    value.setRandom();
+
+    inputs(0) = DynamicTensor<type>(query.data(), get_dimensions(query));
+    inputs(1) = DynamicTensor<type>(key.data(), get_dimensions(key));
+    inputs(2) = DynamicTensor<type>(value.data(), get_dimensions(value));
+
+    MultiheadAttentionLayerForwardPropagation forward_propagation(batch_samples_number, &multihead_attention_layer);
+
+    multihead_attention_layer.forward_propagate(inputs, &forward_propagation, true);
+
+    Tensor<type, 3> outputs = forward_propagation.outputs(0).to_tensor_map<3>();
+
+    Tensor<type, 3> expected_outputs = calculate_outputs(query, key, value);
+
+    Tensor<type, 0> difference = (outputs - expected_outputs).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+
+    // Attention scores of each input sum one
+
+    const Eigen::array<Index, 1> context_dimension = {2};
+
+    Tensor<type, 3> scores_sums = forward_propagation.attention_scores.sum(context_dimension);
+
+    difference = (scores_sums - scores_sums.constant(type(1))).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+
+    // Test without storing the scores
+
+    multihead_attention_layer.forward_propagate(inputs, &forward_propagation, false);
+
+    outputs = forward_propagation.outputs(0).to_tensor_map<3>();
+
+    difference = (outputs - expected_outputs).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+
+    // Test causal mask
+
+    multihead_attention_layer.set_causal_mask(true);
+
+    expected_outputs = calculate_outputs(query, key, value);
+
+    multihead_attention_layer.forward_propagate(inputs, &forward_propagation, true);
+
+    outputs = forward_propagation.outputs(0).to_tensor_map<3>();
+
+    difference = (outputs - expected_outputs).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+
+    // The first input only sees the context positions up to its own
+
+    for(Index j = context_size - input_size + 1; j < context_size; j++)
+    {
+        assert_true(forward_propagation.attention_scores(0, 0, j, 0) == type(0), LOG);
+    }
+
+    multihead_attention_layer.forward_propagate(inputs, &forward_propagation, false);
+
+    outputs = forward_propagation.outputs(0).to_tensor_map<3>();
+
+    difference = (outputs - expected_outputs).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+
+    // Test context longer than a block
+
+    input_size = 70;
+    context_size = 600;
+
+    multihead_attention_layer.set(input_size, context_size, depth, number_of_heads);
+
+    query.resize(batch_samples_number, input_size, depth);
+    key.resize(batch_samples_number, context_size, depth);
+    value.resize(batch_samples_number, context_size, depth);
+
+    query.setRandom();
+    key.setRandom();
+    value.setRandom();
+
+    inputs(0) = DynamicTensor<type>(query.data(), get_dimensions(query));
+    inputs(1) = DynamicTensor<type>(key.data(), get_dimensions(key));
+    inputs(2) = DynamicTensor<type>(value.data(), get_dimensions(value));
+
+    forward_propagation.set(batch_samples_number, &multihead_attention_layer);
+
+    for(Index i = 0; i < 2; i++)
+    {
+        multihead_attention_layer.set_causal_mask(i == 1);
+
+        expected_outputs = calculate_outputs(query, key, value);
+
+        multihead_attention_layer.forward_propagate(inputs, &forward_propagation, false);
+
+        outputs = forward_propagation.outputs(0).to_tensor_map<3>();
+
+        difference = (outputs - expected_outputs).abs().maximum();
+
+        assert_true(difference(0) < type(1e-5), LOG);
+    }
+}
+
+
+void MultiheadAttentionLayerTest::test_forward_propagate_incremental()
+{
+    cout << "test_forward_propagate_incremental\n";
+
+    Tensor<DynamicTensor<type>, 1> inputs(1);
+
+    batch_samples_number = 2;
+    input_size = 5;
+    context_size = 5;
+    depth = 4;
+    number_of_heads = 2;
+
+    multihead_attention_layer.set(input_size, context_size, depth, number_of_heads);
+    multihead_attention_layer.set_causal_mask(true);
+
+    Tensor<type, 3> sequence(batch_samples_number, input_size, depth);
+    sequence.setRandom();
+
+    const Tensor<type, 3> expected_outputs = calculate_outputs(sequence, sequence, sequence);
+
+    // Self-attention of all the sequence
+
+    inputs(0) = DynamicTensor<type>(sequence.data(), get_dimensions(sequence));
+
+    MultiheadAttentionLayerForwardPropagation forward_propagation(batch_samples_number, &multihead_attention_layer);
+
+    multihead_attention_layer.forward_propagate(inputs, &forward_propagation, false);
+
+    Tensor<type, 3> outputs = forward_propagation.outputs(0).to_tensor_map<3>();
+
+    Tensor<type, 0> difference = (outputs - expected_outputs).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+
+    // First positions at once, then one position at a time
+
+    MultiheadAttentionLayerForwardPropagation incremental_forward_propagation(batch_samples_number, &multihead_attention_layer);
+
+    incremental_forward_propagation.is_incremental = true;
+
+    const Index first_positions = 2;
+
+    Index position = 0;
+
+    while(position < input_size)
+    {
+        const Index positions_number = position == 0 ? first_positions : 1;
+
+        const Eigen::array<Index, 3> offsets = {0, position, 0};
+        const Eigen::array<Index, 3> extents = {batch_samples_number, positions_number, depth};
+
+        Tensor<type, 3> step_inputs = sequence.slice(offsets, extents);
+
+        inputs(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+        multihead_attention_layer.forward_propagate(inputs, &incremental_forward_propagation, false);
+
+        assert_true(incremental_forward_propagation.cached_positions == position + positions_number, LOG);
+        assert_true(incremental_forward_propagation.outputs(0).get_dimension(1) == positions_number, LOG);
+
+        const Tensor<type, 3> step_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<3>();
+
+        difference = (step_outputs - expected_outputs.slice(offsets, extents)).abs().maximum();
+
+        assert_true(difference(0) < type(1e-5), LOG);
+
+        position += positions_number;
+    }
+
+    // The oldest positions are discarded when the context is full
+
+    incremental_forward_propagation.reset_states();
+
+    Tensor<type, 3> longer_sequence(batch_samples_number, context_size + 1, depth);
+    longer_sequence.setRandom();
+
+    for(Index i = 0; i <= context_size; i++)
+    {
+        Tensor<type, 3> step_inputs = longer_sequence.chip(i, 1).reshape(Eigen::array<Index, 3>({batch_samples_number, 1, depth}));
+
+        inputs(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+        multihead_attention_layer.forward_propagate(inputs, &incremental_forward_propagation, false);
+    }
+
+    assert_true(incremental_forward_propagation.cached_positions == context_size, LOG);
+
+    const Eigen::array<Index, 3> offsets = {0, 1, 0};
+    const Eigen::array<Index, 3> extents = {batch_samples_number, context_size, depth};
+
+    const Tensor<type, 3> window = longer_sequence.slice(offsets, extents);
+
+    const Tensor<type, 3> window_outputs = calculate_outputs(window, window, window);
+
+    const Eigen::array<Index, 3> last_offsets = {0, context_size - 1, 0};
+    const Eigen::array<Index, 3> last_extents = {batch_samples_number, 1, depth};
+
+    const Tensor<type, 3> last_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<3>();
+
+    difference = (last_outputs - window_outputs.slice(last_offsets, last_extents)).abs().maximum();
+
+    assert_true(difference(0) < type(1e-5), LOG);
+}
+
+
+void MultiheadAttentionLayerTest::test_calculate_error_gradient()
+{
+    cout << "test_calculate_error_gradient\n";
+
+    const type epsilon = type(1e-2);
+
+    Tensor<DynamicTensor<type>, 1> inputs(3);
+
+    Tensor<type, 1> parameters;
+    Tensor<type, 1> gradient;
+    Tensor<type, 1> numerical_gradient;
+    Tensor<type, 1> recomputed_gradient;
+
+    Tensor<type, 0> difference;
+
+    batch_samples_number = 2;
+    input_size = 3;
+    context_size = 4;
+    depth = 3;
+    number_of_heads = 2;
+
+    Tensor<type, 3> query(batch_samples_number, input_size, depth);
+    Tensor<type, 3> key(batch_samples_number, context_size, depth);
+    Tensor<type, 3> value(batch_samples_number, context_size, depth);
+    Tensor<type, 3> weights(batch_samples_number, input_size, depth);
+
+    query.setRandom();
+    key.setRandom();
+    value.setRandom();
+    weights.setRandom();
+
+    inputs(0) = DynamicTensor<type>(query.data(), get_dimensions(query));
+    inputs(1) = DynamicTensor<type>(key.data(), get_dimensions(key));
+    inputs(2) = DynamicTensor<type>(value.data(), get_dimensions(value));
+
+    for(Index mask = 0; mask < 2; mask++)
+    {
+        // Test kernels derivatives
+
+        multihead_attention_layer.set(input_size, context_size, depth, number_of_heads);
+        multihead_attention_layer.set_causal_mask(mask == 1);
+
+        MultiheadAttentionLayerForwardPropagation forward_propagation(batch_samples_number, &multihead_attention_layer);
+        MultiheadAttentionLayerBackPropagation back_propagation(batch_samples_number, &multihead_attention_layer);
+
+        copy(weights.data(), weights.data() + weights.size(), back_propagation.deltas_data);
+
+        multihead_attention_layer.forward_propagate(inputs, &forward_propagation, true);
+
+        multihead_attention_layer.calculate_error_gradient(inputs, &forward_propagation, &back_propagation);
+
+        gradient.resize(multihead_attention_layer.get_parameters_number());
+
+        multihead_attention_layer.insert_gradient(&back_propagation, 0, gradient);
+
+        parameters = multihead_attention_layer.get_parameters();
+
+        numerical_gradient.resize(parameters.size());
+
+        for(Index i = 0; i < parameters.size(); i++)
+        {
+            Tensor<type, 1> parameters_forward = parameters;
+            Tensor<type, 1> parameters_backward = parameters;
+
+            parameters_forward(i) += epsilon;
+            parameters_backward(i) -= epsilon;
+
+            multihead_attention_layer.set_parameters(parameters_forward);
+            const type error_forward = calculate_error(query, key, value, weights);
+
+            multihead_attention_layer.set_parameters(parameters_backward);
+            const type error_backward = calculate_error(query, key, value, weights);
+
+            numerical_gradient(i) = (error_forward - error_backward)/(type(2)*epsilon);
+        }
+
+        multihead_attention_layer.set_parameters(parameters);
+
+        difference = (gradient - numerical_gradient).abs().maximum();
+
+        assert_true(difference(0) < type(1e-2), LOG);
+
+        // Test inputs derivatives
+
+        Tensor<type, 3>* inputs_tensors[3] = {&query, &key, &value};
+
+        const Tensor<type, 3>* inputs_derivatives[3] = {&back_propagation.query_derivatives,
+                                                        &back_propagation.key_derivatives,
+                                                        &back_propagation.value_derivatives};
+
+        for(Index input_index = 0; input_index < 3; input_index++)
+        {
+            Tensor<type, 3>& input = *inputs_tensors[input_index];
+
+            Tensor<type, 3> numerical_inputs_derivatives(input.dimensions());
+
+            for(Index i = 0; i < input.size(); i++)
+            {
+                const type input_value = input(i);
+
+                input(i) = input_value + epsilon;
+                const type error_forward = calculate_error(query, key, value, weights);
+
+                input(i) = input_value - epsilon;
+                const type error_backward = calculate_error(query, key, value, weights);
+
+                input(i) = input_value;
+
+                numerical_inputs_derivatives(i) = (error_forward - error_backward)/(type(2)*epsilon);
+            }
+
+            difference = (*inputs_derivatives[input_index] - numerical_inputs_derivatives).abs().maximum();
+
+            assert_true(difference(0) < type(1e-2), LOG);
+        }
+
+        // Test recomputing the attention scores
+
+        multihead_attention_layer.set_recompute_attention_scores(true);
+
+        multihead_attention_layer.forward_propagate(inputs, &forward_propagation, true);
+
+        multihead_attention_layer.calculate_error_gradient(inputs, &forward_propagation, &back_propagation);
+
+        recomputed_gradient.resize(gradient.size());
+
+        multihead_attention_layer.insert_gradient(&back_propagation, 0, recomputed_gradient);
+
+        difference = (recomputed_gradient - gradient).abs().maximum();
+
+        assert_true(difference(0) < type(1e-5), LOG);
+
+        multihead_attention_layer.set_recompute_attention_scores(false);
+    }
+
+    // Test self-attention
+
+    context_size = input_size;
+
+    multihead_attention_layer.set(input_size, context_size, depth, number_of_heads);
+
+    MultiheadAttentionLayerForwardPropagation forward_propagation(batch_samples_number, &multihead_attention_layer);
+    MultiheadAttentionLayerBackPropagation back_propagation(batch_samples_number, &multihead_attention_layer);
+
+    copy(weights.data(), weights.data() + weights.size(), back_propagation.deltas_data);
+
+    inputs(1) = inputs(0);
+    inputs(2) = inputs(0);
+
+    multihead_attention_layer.forward_propagate(inputs, &forward_propagation, true);
+
+    multihead_attention_layer.calculate_error_gradient(query.data(), &forward_propagation, &back_propagation);
+
+    Tensor<type, 3> numerical_inputs_derivatives(query.dimensions());
+
+    for(Index i = 0; i < query.size(); i++)
+    {
+        const type input_value = query(i);
+
+        query(i) = input_value + epsilon;
+        const type error_forward = calculate_error(query, query, query, weights);
+
+        query(i) = input_value - epsilon;
+        const type error_backward = calculate_error(query, query, query, weights);
+
+        query(i) = input_value;
+
+        numerical_inputs_derivatives(i) = (error_forward - error_backward)/(type(2)*epsilon);
+    }
+
+    const Tensor<type, 3> inputs_derivatives
+            = back_propagation.query_derivatives + back_propagation.key_derivatives + back_propagation.value_derivatives;
+
+    difference = (inputs_derivatives - numerical_inputs_derivatives).abs().maximum();
+
+    assert_true(difference(0) < type(1e-2), LOG);
+}
+
+
+void MultiheadAttentionLayerTest::test_back_propagate()
+{
+    cout << "test_back_propagate\n";
+
+    DataSet data_set;
+
+    NeuralNetwork neural_network;
+
+    SumSquaredError sum_squared_error(&neural_network, &data_set);
+
+    DataSetBatch batch;
+
+    NeuralNetworkForwardPropagation forward_propagation;
+
+    LossIndexBackPropagation back_propagation;
+
+    Tensor<Index, 1> training_samples_indices;
+    Tensor<Index, 1> input_variables_indices;
+    Tensor<Index, 1> target_variables_indices;
+
+    Tensor<type, 1> numerical_differentiation_gradient;
+
+    bool is_training = true;
+
+    const Index samples_number = 3;
+    const Index inputs_number = 4;
+    const Index outputs_number = 2;
+
+    input_size = 3;
+    context_size = 3;
+    depth = 4;
+    number_of_heads = 2;
+
+    // Test perceptron, two multi-head attention layers and perceptron
+    {
+        data_set.set(samples_number, inputs_number, outputs_number);
+        data_set.set_data_random();
+
+        data_set.set_training();
+
+        training_samples_indices = data_set.get_training_samples_indices();
+        input_variables_indices = data_set.get_input_variables_indices();
+        target_variables_indices = data_set.get_target_variables_indices();
+
+        batch.set(samples_number, &data_set);
+        batch.fill(training_samples_indices, input_variables_indices, target_variables_indices);
+
+        neural_network.set();
+
+        neural_network.add_layer(new PerceptronLayer(inputs_number, input_size*depth, PerceptronLayer::ActivationFunction::HyperbolicTangent));
+        neural_network.add_layer(new MultiheadAttentionLayer(input_size, context_size, depth, number_of_heads));
+        neural_network.add_layer(new MultiheadAttentionLayer(input_size, context_size, depth, number_of_heads));
+        neural_network.add_layer(new PerceptronLayer(input_size*depth, outputs_number, PerceptronLayer::ActivationFunction::Linear));
+
+        neural_network.set_parameters_random();
+
+        forward_propagation.set(samples_number, &neural_network);
+        neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+        back_propagation.set(samples_number, &sum_squared_error);
+        sum_squared_error.back_propagate(batch, forward_propagation, back_propagation);
+
+        numerical_differentiation_gradient = sum_squared_error.calculate_numerical_differentiation_gradient();
+
+        assert_true(back_propagation.gradient.size() == neural_network.get_parameters_number(), LOG);
+
+        assert_true(are_equal(back_propagation.gradient, numerical_differentiation_gradient, type(1.0e-2)), LOG);
+    }
+
+    // Test embedding, multi-head attention layer and perceptron
+    {
+        const Index input_dim = 5;
+
+        Tensor<type, 2> data(samples_number, input_size + outputs_number);
+        data.setRandom();
+
+        for(Index i = 0; i < samples_number; i++)
+            for(Index j = 0; j < input_size; j++)
+                data(i, j) = type(rand()%input_dim);
+
+        data_set.set(samples_number, input_size, outputs_number);
+        data_set.set_data(data, true);
+        data_set.set_columns_scalers(Scaler::NoScaling);
+
+        data_set.set_training();
+
+        training_samples_indices = data_set.get_training_samples_indices();
+        input_variables_indices = data_set.get_input_variables_indices();
+        target_variables_indices = data_set.get_target_variables_indices();
+
+        batch.set(samples_number, &data_set);
+        batch.fill(training_samples_indices, input_variables_indices, target_variables_indices);
+
+        neural_network.set();
+
+        neural_network.add_layer(new EmbeddingLayer(input_dim, input_size, depth));
+        neural_network.add_layer(new MultiheadAttentionLayer(input_size, context_size, depth, number_of_heads));
+        neural_network.add_layer(new PerceptronLayer(input_size*depth, outputs_number, PerceptronLayer::ActivationFunction::Linear));
+
+        neural_network.set_parameters_random();
+
+        forward_propagation.set(samples_number, &neural_network);
+        neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+        back_propagation.set(samples_number, &sum_squared_error);
+        sum_squared_error.back_propagate(batch, forward_propagation, back_propagation);
+
+        numerical_differentiation_gradient = sum_squared_error.calculate_numerical_differentiation_gradient();
+
+        assert_true(are_equal(back_propagation.gradient, numerical_differentiation_gradient, type(1.0e-2)), LOG);
+
+        // Training
+
+        AdaptiveMomentEstimation adaptive_moment_estimation(&sum_squared_error);
+
+        adaptive_moment_estimation.set_display(false);
+        adaptive_moment_estimation.set_maximum_epochs_number(50);
+
+        TrainingResults training_results = adaptive_moment_estimation.perform_training();
+
+        assert_true(training_results.get_training_error() < back_propagation.error, LOG);
+    }
+
+    // Test graph with a multi-head attention layer whose query and context come from different layers
+    {
+        const Index graph_context_size = 2;
+
+        data_set.set(samples_number, inputs_number, outputs_number);
+        data_set.set_data_random();
+
+        data_set.set_training();
+
+        training_samples_indices = data_set.get_training_samples_indices();
+        input_variables_indices = data_set.get_input_variables_indices();
+        target_variables_indices = data_set.get_target_variables_indices();
+
+        batch.set(samples_number, &data_set);
+        batch.fill(training_samples_indices, input_variables_indices, target_variables_indices);
+
+        neural_network.set();
+
+        neural_network.add_layer(new PerceptronLayer(inputs_number, input_size*depth, PerceptronLayer::ActivationFunction::HyperbolicTangent));
+        neural_network.add_layer(new PerceptronLayer(input_size*depth, graph_context_size*depth, PerceptronLayer::ActivationFunction::HyperbolicTangent));
+        neural_network.add_layer(new MultiheadAttentionLayer(input_size, graph_context_size, depth, number_of_heads));
+        neural_network.add_layer(new PerceptronLayer(input_size*depth, outputs_number, PerceptronLayer::ActivationFunction::Linear));
+
+        Tensor<Index, 1> layer_inputs_indices(3);
+        layer_inputs_indices.setValues({0, 1, 1});
+
+        neural_network.set_layer_inputs_indices(2, layer_inputs_indices);
+
+        neural_network.set_parameters_random();
+
+        assert_true(!neural_network.is_sequential(), LOG);
+
+        forward_propagation.set(samples_number, &neural_network);
+        neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+        back_propagation.set(samples_number, &sum_squared_error);
+        sum_squared_error.back_propagate(batch, forward_propagation, back_propagation);
+
+        numerical_differentiation_gradient = sum_squared_error.calculate_numerical_differentiation_gradient();
+
+        assert_true(back_propagation.gradient.size() == neural_network.get_parameters_number(), LOG);
+
+        assert_true(are_equal(back_propagation.gradient, numerical_differentiation_gradient, type(1.0e-2)), LOG);
+    }
+}
+
+
+void MultiheadAttentionLayerTest::run_test_case()
+{
+    cout << "Running multihead attention layer test case...\n";
+
+    // Constructor and destructor
+
+    test_constructor();
+
+    // Forward propagate
+
+    test_forward_propagate();
+    test_forward_propagate_incremental();
+
+    // Back propagate
+
+    test_calculate_error_gradient();
+    test_back_propagate();
+
+    cout << "End of multihead attention layer test case.\n\n";
+}
+
+
+// OpenNN: Open Neural Networks Library.
+// Copyright (C) 2005-2021 Artificial Intelligence Techniques, SL.
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or any later version.
+//
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
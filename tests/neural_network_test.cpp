@@ -1209,6 +1209,509 @@ void NeuralNetworkTest::test_forward_propagate()
 }
 
 
+void NeuralNetworkTest::test_get_layers_execution_levels()
+{
+    cout << "test_get_layers_execution_levels\n";
+
+    NeuralNetwork graph_neural_network;
+
+    Tensor<Tensor<Index, 1>, 1> layers_execution_levels;
+
+    // Test
+
+    graph_neural_network.add_layer(new PerceptronLayer(2, 3));
+    graph_neural_network.add_layer(new PerceptronLayer(3, 3));
+    graph_neural_network.add_layer(new PerceptronLayer(3, 3));
+
+    assert_true(graph_neural_network.is_sequential(), LOG);
+
+    layers_execution_levels = graph_neural_network.get_layers_execution_levels();
+
+    assert_true(layers_execution_levels.size() == 3, LOG);
+
+    // Test
+
+    Tensor<Index, 1> layer_inputs_indices(1);
+    layer_inputs_indices.setValues({0});
+
+    graph_neural_network.set_layer_inputs_indices(2, layer_inputs_indices);
+
+    assert_true(!graph_neural_network.is_sequential(), LOG);
+
+    layers_execution_levels = graph_neural_network.get_layers_execution_levels();
+
+    assert_true(layers_execution_levels.size() == 2, LOG);
+    assert_true(layers_execution_levels(0).size() == 1 && layers_execution_levels(0)(0) == 0, LOG);
+    assert_true(layers_execution_levels(1).size() == 2, LOG);
+    assert_true(layers_execution_levels(1)(0) == 1 && layers_execution_levels(1)(1) == 2, LOG);
+
+    assert_true(graph_neural_network.get_layers_outputs_indices()(0).size() == 2, LOG);
+
+    // Test
+
+    layer_inputs_indices.setValues({2});
+
+    graph_neural_network.set_layer_inputs_indices(1, layer_inputs_indices);
+
+    layer_inputs_indices.setValues({1});
+
+    graph_neural_network.set_layer_inputs_indices(2, layer_inputs_indices);
+
+    try
+    {
+        graph_neural_network.get_layers_execution_levels();
+
+        assert_true(false, LOG);
+    }
+    catch(const invalid_argument&)
+    {
+        assert_true(true, LOG);
+    }
+}
+
+
+void NeuralNetworkTest::test_forward_propagate_graph()
+{
+    cout << "test_forward_propagate_graph\n";
+
+    NeuralNetwork graph_neural_network;
+
+    inputs_number = 2;
+    batch_samples_number = 4;
+    const Index neurons_number = 3;
+    bool is_training = true;
+
+    // Test
+
+    graph_neural_network.add_layer(new PerceptronLayer(inputs_number, neurons_number));
+    graph_neural_network.add_layer(new PerceptronLayer(neurons_number, neurons_number));
+    graph_neural_network.add_layer(new PerceptronLayer(neurons_number, neurons_number));
+
+    Tensor<Index, 1> addition_dimensions(1);
+    addition_dimensions.setValues({neurons_number});
+
+    graph_neural_network.add_layer(new AdditionLayer(addition_dimensions));
+
+    Tensor<Index, 1> concatenation_last_dimensions(2);
+    concatenation_last_dimensions.setValues({neurons_number, neurons_number});
+
+    graph_neural_network.add_layer(new ConcatenationLayer(addition_dimensions, concatenation_last_dimensions));
+
+    Tensor<Index, 1> layer_inputs_indices(1);
+    layer_inputs_indices.setValues({0});
+    graph_neural_network.set_layer_inputs_indices(2, layer_inputs_indices);
+
+    layer_inputs_indices.resize(2);
+    layer_inputs_indices.setValues({1, 2});
+    graph_neural_network.set_layer_inputs_indices(3, layer_inputs_indices);
+
+    layer_inputs_indices.setValues({3, 0});
+    graph_neural_network.set_layer_inputs_indices(4, layer_inputs_indices);
+
+    graph_neural_network.set_parameters_random();
+
+    batch.batch_size = batch_samples_number;
+    batch.inputs.resize(1);
+
+    Tensor<Index, 1> inputs_dimensions(2);
+    inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+    batch.inputs(0).set_dimensions(inputs_dimensions);
+    batch.inputs(0).to_tensor_map<2>().setRandom();
+
+    NeuralNetworkForwardPropagation forward_propagation(batch_samples_number, &graph_neural_network);
+
+    graph_neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+    const Tensor<type, 2> outputs_0 = forward_propagation.layers(0)->outputs(0).to_tensor_map<2>();
+    const Tensor<type, 2> outputs_1 = forward_propagation.layers(1)->outputs(0).to_tensor_map<2>();
+    const Tensor<type, 2> outputs_2 = forward_propagation.layers(2)->outputs(0).to_tensor_map<2>();
+    const Tensor<type, 2> addition_outputs = forward_propagation.layers(3)->outputs(0).to_tensor_map<2>();
+    const Tensor<type, 2> concatenation_outputs = forward_propagation.layers(4)->outputs(0).to_tensor_map<2>();
+
+    assert_true(addition_outputs.dimension(0) == batch_samples_number, LOG);
+    assert_true(addition_outputs.dimension(1) == neurons_number, LOG);
+
+    assert_true(concatenation_outputs.dimension(0) == batch_samples_number, LOG);
+    assert_true(concatenation_outputs.dimension(1) == 2*neurons_number, LOG);
+
+    for(Index i = 0; i < batch_samples_number; i++)
+    {
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            assert_true(abs(addition_outputs(i,j) - outputs_1(i,j) - outputs_2(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+            assert_true(abs(concatenation_outputs(i,j) - addition_outputs(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+            assert_true(abs(concatenation_outputs(i,neurons_number+j) - outputs_0(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+        }
+    }
+
+    // Convolution pooling blocks whose layers are not adjacent
+
+    NeuralNetwork convolutional_neural_network;
+
+    Tensor<Index, 1> images_dimensions(3);
+    images_dimensions.setValues({8, 8, 3});
+
+    Tensor<Index, 1> kernels_dimensions(4);
+    kernels_dimensions.setValues({5, 5, 3, 4});
+
+    Tensor<Index, 1> pool_dimensions(2);
+    pool_dimensions.setValues({2, 2});
+
+    ConvolutionalLayer* convolutional_layer_pointer = new ConvolutionalLayer(images_dimensions, kernels_dimensions);
+    convolutional_layer_pointer->set_convolution_type(ConvolutionalLayer::ConvolutionType::Same);
+    convolutional_layer_pointer->set_activation_function(ConvolutionalLayer::ActivationFunction::RectifiedLinear);
+
+    PoolingLayer* pooling_layer_pointer = new PoolingLayer(convolutional_layer_pointer->get_outputs_dimensions(), pool_dimensions);
+    pooling_layer_pointer->set_pooling_method(PoolingLayer::PoolingMethod::MaxPooling);
+    pooling_layer_pointer->set_row_stride(2);
+    pooling_layer_pointer->set_column_stride(2);
+
+    kernels_dimensions.setValues({5, 5, 4, 2});
+
+    ConvolutionalLayer* second_convolutional_layer_pointer = new ConvolutionalLayer(pooling_layer_pointer->get_outputs_dimensions(), kernels_dimensions);
+    second_convolutional_layer_pointer->set_convolution_type(ConvolutionalLayer::ConvolutionType::Same);
+    second_convolutional_layer_pointer->set_activation_function(ConvolutionalLayer::ActivationFunction::RectifiedLinear);
+
+    PoolingLayer* second_pooling_layer_pointer = new PoolingLayer(second_convolutional_layer_pointer->get_outputs_dimensions(), pool_dimensions);
+    second_pooling_layer_pointer->set_pooling_method(PoolingLayer::PoolingMethod::MaxPooling);
+    second_pooling_layer_pointer->set_row_stride(2);
+    second_pooling_layer_pointer->set_column_stride(2);
+
+    convolutional_neural_network.add_layer(convolutional_layer_pointer);
+    convolutional_neural_network.add_layer(second_convolutional_layer_pointer);
+    convolutional_neural_network.add_layer(pooling_layer_pointer);
+    convolutional_neural_network.add_layer(second_pooling_layer_pointer);
+
+    convolutional_neural_network.set_layer_inputs_indices(0, Tensor<Index, 1>());
+
+    layer_inputs_indices.resize(1);
+
+    layer_inputs_indices.setValues({2});
+    convolutional_neural_network.set_layer_inputs_indices(1, layer_inputs_indices);
+
+    layer_inputs_indices.setValues({0});
+    convolutional_neural_network.set_layer_inputs_indices(2, layer_inputs_indices);
+
+    layer_inputs_indices.setValues({1});
+    convolutional_neural_network.set_layer_inputs_indices(3, layer_inputs_indices);
+
+    convolutional_neural_network.set_parameters_random();
+
+    assert_true(!convolutional_neural_network.is_sequential(), LOG);
+    assert_true(convolutional_neural_network.is_convolution_pooling_block(0), LOG);
+    assert_true(convolutional_neural_network.is_convolution_pooling_block(1), LOG);
+
+    Tensor<type, 4> images(batch_samples_number, 8, 8, 3);
+    images.setRandom();
+
+    batch.inputs(0).set_view(images.data(), get_dimensions(images));
+
+    // Layers calculated one by one
+
+    Tensor<DynamicTensor<type>, 1> images_pair(1);
+    images_pair(0) = DynamicTensor<type>(images.data(), get_dimensions(images));
+
+    ConvolutionalLayerForwardPropagation convolutional_layer_forward_propagation(batch_samples_number, convolutional_layer_pointer);
+    PoolingLayerForwardPropagation pooling_layer_forward_propagation(batch_samples_number, pooling_layer_pointer);
+    ConvolutionalLayerForwardPropagation second_convolutional_layer_forward_propagation(batch_samples_number, second_convolutional_layer_pointer);
+    PoolingLayerForwardPropagation second_pooling_layer_forward_propagation(batch_samples_number, second_pooling_layer_pointer);
+
+    convolutional_layer_pointer->forward_propagate(images_pair, &convolutional_layer_forward_propagation, true);
+    pooling_layer_pointer->forward_propagate(convolutional_layer_forward_propagation.outputs, &pooling_layer_forward_propagation, true);
+    second_convolutional_layer_pointer->forward_propagate(pooling_layer_forward_propagation.outputs, &second_convolutional_layer_forward_propagation, true);
+    second_pooling_layer_pointer->forward_propagate(second_convolutional_layer_forward_propagation.outputs, &second_pooling_layer_forward_propagation, true);
+
+    const Tensor<type, 4> pooled_outputs = second_pooling_layer_forward_propagation.outputs(0).to_tensor_map<4>();
+
+    // Blocks of the graph, with the buffers of the inference memory plan
+
+    NeuralNetworkForwardPropagation convolutional_forward_propagation(batch_samples_number, &convolutional_neural_network, true);
+
+    convolutional_neural_network.forward_propagate_deploy(batch, convolutional_forward_propagation);
+
+    const Tensor<type, 4> graph_pooled_outputs = convolutional_forward_propagation.layers(3)->outputs(0).to_tensor_map<4>();
+
+    assert_true(graph_pooled_outputs.size() == pooled_outputs.size(), LOG);
+
+    const Tensor<type, 0> difference = (graph_pooled_outputs - pooled_outputs).abs().maximum();
+
+    assert_true(difference(0) < type(1e-4), LOG);
+}
+
+
+void NeuralNetworkTest::test_set_inference_memory_plan()
+{
+    cout << "test_set_inference_memory_plan\n";
+
+    inputs_number = 3;
+    outputs_number = 2;
+    batch_samples_number = 5;
+
+    Tensor<Index, 1> architecture(6);
+    architecture.setValues({inputs_number, 8, 8, 8, 8, outputs_number});
+
+    neural_network.set(NeuralNetwork::ProjectType::Approximation, architecture);
+
+    neural_network.set_parameters_random();
+
+    batch.batch_size = batch_samples_number;
+    batch.inputs.resize(1);
+
+    Tensor<Index, 1> inputs_dimensions(2);
+    inputs_dimensions.setValues({batch_samples_number, inputs_number});
+
+    batch.inputs(0).set_dimensions(inputs_dimensions);
+    batch.inputs(0).to_tensor_map<2>().setRandom();
+
+    const Index layers_number = neural_network.get_layers_number();
+
+    // Test
+
+    NeuralNetworkForwardPropagation forward_propagation(batch_samples_number, &neural_network);
+
+    neural_network.forward_propagate_deploy(batch, forward_propagation);
+
+    const Tensor<type, 2> outputs = forward_propagation.layers(layers_number-1)->outputs(0).to_tensor_map<2>();
+
+    NeuralNetworkForwardPropagation planned_forward_propagation(batch_samples_number, &neural_network, true);
+
+    neural_network.forward_propagate_deploy(batch, planned_forward_propagation);
+
+    const Tensor<type, 2> planned_outputs = planned_forward_propagation.layers(layers_number-1)->outputs(0).to_tensor_map<2>();
+
+    assert_true(planned_forward_propagation.get_outputs_size() < forward_propagation.get_outputs_size(), LOG);
+
+    assert_true(planned_outputs.dimension(0) == batch_samples_number, LOG);
+    assert_true(planned_outputs.dimension(1) == outputs_number, LOG);
+
+    for(Index i = 0; i < batch_samples_number; i++)
+    {
+        for(Index j = 0; j < outputs_number; j++)
+        {
+            assert_true(abs(planned_outputs(i,j) - outputs(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+        }
+    }
+
+    // Buffers which only the back propagation needs
+
+    for(Index i = 0; i < layers_number; i++)
+    {
+        if(neural_network.get_layer_pointer(i)->get_type() != Layer::Type::Perceptron) continue;
+
+        const PerceptronLayerForwardPropagation* perceptron_layer_forward_propagation
+                = static_cast<PerceptronLayerForwardPropagation*>(planned_forward_propagation.layers(i));
+
+        assert_true(perceptron_layer_forward_propagation->activations_derivatives.size() == 0, LOG);
+        assert_true(!perceptron_layer_forward_propagation->outputs(0).get_owns_data(), LOG);
+    }
+
+    // Outputs calculated with the same forward propagation, for fewer samples
+
+    Tensor<type, 2> inputs = batch.inputs(0).to_tensor_map<2>();
+
+    for(Index samples_number = batch_samples_number; samples_number > 0; samples_number -= 2)
+    {
+        Tensor<type, 2> samples_inputs = inputs.slice(Eigen::array<Index, 2>({0, 0}),
+                                                      Eigen::array<Index, 2>({samples_number, inputs_number}));
+
+        Tensor<Index, 1> samples_inputs_dimensions = get_dimensions(samples_inputs);
+
+        const Tensor<type, 2> samples_outputs = neural_network.calculate_outputs(samples_inputs.data(), samples_inputs_dimensions);
+
+        assert_true(samples_outputs.dimension(0) == samples_number, LOG);
+
+        for(Index i = 0; i < samples_number; i++)
+        {
+            for(Index j = 0; j < outputs_number; j++)
+            {
+                assert_true(abs(samples_outputs(i,j) - outputs(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+            }
+        }
+    }
+
+    // Workspaces of recurrent layers
+
+    const Index neurons_number = 4;
+    const Index timesteps = 3;
+
+    NeuralNetwork recurrent_neural_network;
+
+    RecurrentLayer* recurrent_layer_pointer = new RecurrentLayer(inputs_number, neurons_number);
+    recurrent_layer_pointer->set_timesteps(timesteps);
+
+    recurrent_neural_network.add_layer(recurrent_layer_pointer);
+    recurrent_neural_network.add_layer(new PerceptronLayer(neurons_number, outputs_number));
+
+    recurrent_neural_network.set_parameters_random();
+
+    NeuralNetworkForwardPropagation recurrent_forward_propagation(batch_samples_number, &recurrent_neural_network);
+
+    recurrent_neural_network.forward_propagate_deploy(batch, recurrent_forward_propagation);
+
+    const Tensor<type, 2> recurrent_outputs = recurrent_forward_propagation.layers(1)->outputs(0).to_tensor_map<2>();
+
+    NeuralNetworkForwardPropagation planned_recurrent_forward_propagation(batch_samples_number, &recurrent_neural_network, true);
+
+    recurrent_neural_network.forward_propagate_deploy(batch, planned_recurrent_forward_propagation);
+
+    const Tensor<type, 2> planned_recurrent_outputs = planned_recurrent_forward_propagation.layers(1)->outputs(0).to_tensor_map<2>();
+
+    const RecurrentLayerForwardPropagation* recurrent_layer_forward_propagation
+            = static_cast<RecurrentLayerForwardPropagation*>(planned_recurrent_forward_propagation.layers(0));
+
+    assert_true(!recurrent_layer_forward_propagation->combinations.get_owns_data(), LOG);
+    assert_true(recurrent_layer_forward_propagation->activations_derivatives.size() == 0, LOG);
+
+    assert_true(planned_recurrent_forward_propagation.get_outputs_size() < recurrent_forward_propagation.get_outputs_size(), LOG);
+
+    for(Index i = 0; i < batch_samples_number; i++)
+    {
+        for(Index j = 0; j < outputs_number; j++)
+        {
+            assert_true(abs(planned_recurrent_outputs(i,j) - recurrent_outputs(i,j)) < type(NUMERIC_LIMITS_MIN), LOG);
+        }
+    }
+}
+
+
+void NeuralNetworkTest::test_quantize()
+{
+    cout << "test_quantize\n";
+
+    inputs_number = 3;
+    outputs_number = 2;
+    batch_samples_number = 100;
+
+    Tensor<Index, 1> architecture(4);
+    architecture.setValues({inputs_number, 16, 16, outputs_number});
+
+    neural_network.set(NeuralNetwork::ProjectType::Classification, architecture);
+
+    neural_network.set_parameters_random();
+
+    Tensor<type, 2> inputs(batch_samples_number, inputs_number);
+    inputs.setRandom();
+
+    Tensor<Index, 1> inputs_dimensions = get_dimensions(inputs);
+
+    const Tensor<type, 2> outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    const Tensor<type, 0> outputs_range = outputs.abs().maximum();
+
+    // Test
+
+    const type maximum_error = type(0.01);
+
+    Index quantized_layers_number = neural_network.quantize(inputs, maximum_error);
+
+    assert_true(quantized_layers_number > 0, LOG);
+    assert_true(neural_network.get_quantized_layers_number() == quantized_layers_number, LOG);
+
+    const Tensor<type, 2> quantized_outputs = neural_network.calculate_outputs(inputs.data(), inputs_dimensions);
+
+    for(Index i = 0; i < outputs.size(); i++)
+    {
+        assert_true(abs(quantized_outputs(i) - outputs(i)) <= maximum_error*outputs_range(0), LOG);
+    }
+
+    // Test
+
+    quantized_layers_number = neural_network.quantize(inputs, type(0));
+
+    assert_true(quantized_layers_number == 0, LOG);
+    assert_true(neural_network.get_quantized_layers_number() == 0, LOG);
+
+    // Test
+
+    neural_network.quantize(inputs, maximum_error);
+
+    neural_network.set_parameters_random();
+
+    assert_true(neural_network.get_quantized_layers_number() == 0, LOG);
+}
+
+
+void NeuralNetworkTest::test_sample_output()
+{
+    cout << "test_sample_output\n";
+
+    Tensor<type, 1> outputs(4);
+    outputs.setValues({type(0.1), type(0.5), type(0.3), type(0.1)});
+
+    // Greedy
+
+    assert_true(neural_network.sample_output(outputs) == 1, LOG);
+
+    // Top-k
+
+    for(Index i = 0; i < 20; i++)
+    {
+        const Index index = neural_network.sample_output(outputs, 2);
+
+        assert_true(index == 1 || index == 2, LOG);
+    }
+}
+
+
+void NeuralNetworkTest::test_calculate_text_outputs()
+{
+    cout << "test_calculate_text_outputs\n";
+
+    TextGenerationAlphabet text_generation_alphabet("hello world. hola mundo.");
+
+    const Index alphabet_length = text_generation_alphabet.get_alphabet_length();
+
+    const Index length = 10;
+
+    neural_network.set(NeuralNetwork::ProjectType::TextGeneration, {alphabet_length, 6, alphabet_length});
+
+    neural_network.set_parameters_random();
+
+    // Incremental decoding of one letter at a time
+
+    const string phrase = neural_network.calculate_text_outputs(text_generation_alphabet, "he", length, false);
+
+    assert_true(Index(phrase.length()) == length, LOG);
+    assert_true(phrase.substr(0, 2) == "he", LOG);
+
+    for(Index i = 0; i < length; i++)
+    {
+        assert_true(text_generation_alphabet.get_alphabet_index(phrase[i]) != -1, LOG);
+    }
+
+    // Greedy letters are the most probable ones for the whole sequence
+
+    neural_network.get_long_short_term_memory_layer_pointer()->set_timesteps(length);
+
+    Tensor<type, 2> sequence = text_generation_alphabet.multiple_one_hot_encode(phrase.substr(0, length - 1));
+
+    Tensor<Index, 1> sequence_dimensions = get_dimensions(sequence);
+
+    const Tensor<type, 2> outputs = neural_network.calculate_outputs(sequence.data(), sequence_dimensions);
+
+    for(Index i = 1; i < length - 1; i++)
+    {
+        const Tensor<type, 1> letter_outputs = outputs.chip(i, 0);
+
+        assert_true(neural_network.sample_output(letter_outputs) == text_generation_alphabet.get_alphabet_index(phrase[i + 1]), LOG);
+    }
+
+    // Word
+
+    const string word = neural_network.calculate_text_outputs(text_generation_alphabet, "ho", length, true);
+
+    assert_true(Index(word.length()) <= length, LOG);
+    assert_true(word.find_first_of(" ,.\n:;") == string::npos, LOG);
+
+    // Top-k sampling
+
+    const string sampled_phrase = neural_network.calculate_text_outputs(text_generation_alphabet, "he", length, false, 3);
+
+    assert_true(Index(sampled_phrase.length()) == length, LOG);
+}
+
+
 void NeuralNetworkTest::run_test_case()
 {
     cout << "Running neural network test case...\n";
@@ -1228,6 +1731,8 @@ void NeuralNetworkTest::run_test_case()
 
     test_has_methods();
 
+    test_get_layers_execution_levels();
+
     // Set methods
 
     test_set();
@@ -1258,6 +1763,17 @@ void NeuralNetworkTest::run_test_case()
     //Forward propagate
 
     test_forward_propagate();
+    test_forward_propagate_graph();
+    test_set_inference_memory_plan();
+
+    // Quantization
+
+    test_quantize();
+
+    // Text generation
+
+    test_sample_output();
+    test_calculate_text_outputs();
 
     // Serialization methods
 
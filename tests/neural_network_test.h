@@ -37,6 +37,8 @@ public:
 
     void test_has_methods();
 
+    void test_get_layers_execution_levels();
+
     // Set methods
 
     void test_set();
@@ -78,6 +80,17 @@ public:
     // Forward propagation
 
     void test_forward_propagate();
+    void test_forward_propagate_graph();
+    void test_set_inference_memory_plan();
+
+    // Quantization
+
+    void test_quantize();
+
+    // Text generation
+
+    void test_sample_output();
+    void test_calculate_text_outputs();
 
     // Expression methods
 
@@ -33,7 +33,11 @@
 #include "probabilistic_layer_test.h"
 #include "long_short_term_memory_layer_test.h"
 #include "recurrent_layer_test.h"
+#include "multihead_attention_layer_test.h"
+#include "embedding_layer_test.h"
 #include "neural_network_test.h"
+#include "inference_session_test.h"
+#include "inference_batcher_test.h"
 
 #include "sum_squared_error_test.h"
 #include "mean_squared_error_test.h"
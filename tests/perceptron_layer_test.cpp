@@ -693,6 +693,62 @@ void PerceptronLayerTest::test_calculate_combinations()
 
     assert_true(abs(combinations(0,0)) < type(NUMERIC_LIMITS_MIN), LOG);
 */
+
+    // Inputs with more dimensions are a row for each sample
+
+    inputs_number = 6;
+    neurons_number = 2;
+    samples_number = 3;
+
+    perceptron_layer.set(inputs_number, neurons_number, PerceptronLayer::ActivationFunction::Linear);
+    perceptron_layer.set_parameters_random();
+
+    Tensor<type, 3> inputs_3(samples_number, 2, 3);
+    inputs_3.setRandom();
+
+    inputs = TensorMap<Tensor<type, 2>>(inputs_3.data(), samples_number, inputs_number);
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+
+    PerceptronLayerForwardPropagation forward_propagation(samples_number, &perceptron_layer);
+
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    perceptron_layer.forward_propagate(inputs_pair, &forward_propagation, false);
+
+    combinations = forward_propagation.outputs(0).to_tensor_map<2>();
+
+    inputs_pair(0) = DynamicTensor<type>(inputs_3.data(), get_dimensions(inputs_3));
+
+    perceptron_layer.forward_propagate(inputs_pair, &forward_propagation, false);
+
+    const TensorMap<Tensor<type, 2>> outputs = forward_propagation.outputs(0).to_tensor_map<2>();
+
+    for(Index i = 0; i < samples_number; i++)
+    {
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            assert_true(abs(outputs(i, j) - combinations(i, j)) < type(NUMERIC_LIMITS_MIN), LOG);
+        }
+    }
+
+    // Inputs whose samples do not have the inputs number
+
+    Tensor<Index, 1> wrong_inputs_dimensions(3);
+    wrong_inputs_dimensions.setValues({samples_number, 2, 2});
+
+    inputs_pair(0) = DynamicTensor<type>(inputs_3.data(), wrong_inputs_dimensions);
+
+    try
+    {
+        perceptron_layer.forward_propagate(inputs_pair, &forward_propagation, false);
+
+        assert_true(false, LOG);
+    }
+    catch(const invalid_argument&)
+    {
+        assert_true(true, LOG);
+    }
 }
 
 
@@ -1432,6 +1488,262 @@ void PerceptronLayerTest::test_forward_propagate()
 }
 
 
+void PerceptronLayerTest::test_dropout()
+{
+    cout << "test_dropout\n";
+
+    Tensor<type, 2> inputs_tensor;
+
+    bool is_training = true;
+
+    // Test
+
+    samples_number = 100;
+    inputs_number = 2;
+    neurons_number = 100;
+
+    const type dropout_rate = type(0.25);
+
+    perceptron_layer.set(inputs_number, neurons_number, PerceptronLayer::ActivationFunction::Linear);
+    perceptron_layer.set_parameters_constant(type(1));
+    perceptron_layer.set_dropout_rate(dropout_rate);
+    perceptron_layer.set_dropout_seed(1);
+
+    inputs_tensor.resize(samples_number, inputs_number);
+    inputs_tensor.setConstant(type(1));
+
+    Tensor<DynamicTensor<type>, 1> inputs(1);
+    inputs(0) = DynamicTensor<type>(inputs_tensor.data(), get_dimensions(inputs_tensor));
+
+    perceptron_layer_forward_propagation.set(samples_number, &perceptron_layer);
+
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, is_training);
+
+    const Tensor<type, 2> dropout_mask = perceptron_layer_forward_propagation.dropout_mask;
+
+    TensorMap<Tensor<type, 2>> outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    assert_true(dropout_mask.dimension(0) == samples_number, LOG);
+    assert_true(dropout_mask.dimension(1) == neurons_number, LOG);
+
+    Index dropped_outputs_number = 0;
+
+    for(Index i = 0; i < dropout_mask.size(); i++)
+    {
+        if(dropout_mask(i) == type(0)) dropped_outputs_number++;
+
+        assert_true(abs(outputs(i) - type(3)*dropout_mask(i)) < type(1e-3), LOG);
+        assert_true(abs(perceptron_layer_forward_propagation.activations_derivatives(i) - dropout_mask(i)) < type(1e-3), LOG);
+    }
+
+    assert_true(abs(type(dropped_outputs_number)/type(dropout_mask.size()) - dropout_rate) < type(0.02), LOG);
+
+    // Test
+
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, is_training);
+
+    Tensor<bool, 0> is_equal = (perceptron_layer_forward_propagation.dropout_mask == dropout_mask).all();
+
+    assert_true(!is_equal(0), LOG);
+
+    perceptron_layer.set_dropout_seed(1);
+
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, is_training);
+
+    is_equal = (perceptron_layer_forward_propagation.dropout_mask == dropout_mask).all();
+
+    assert_true(is_equal(0), LOG);
+
+    // Test
+
+    is_training = false;
+
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, is_training);
+
+    outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    assert_true(abs(outputs(0,0) - type(3)) < type(1e-3), LOG);
+}
+
+
+void PerceptronLayerTest::test_quantize()
+{
+    cout << "test_quantize\n";
+
+    Tensor<type, 2> inputs_tensor;
+
+    // Test
+
+    samples_number = 10;
+    inputs_number = 50;
+    neurons_number = 20;
+
+    perceptron_layer.set(inputs_number, neurons_number, PerceptronLayer::ActivationFunction::Linear);
+    perceptron_layer.set_parameters_random();
+    perceptron_layer.set_dropout_rate(type(0));
+
+    inputs_tensor.resize(samples_number, inputs_number);
+    inputs_tensor.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs(1);
+    inputs(0) = DynamicTensor<type>(inputs_tensor.data(), get_dimensions(inputs_tensor));
+
+    perceptron_layer_forward_propagation.set(samples_number, &perceptron_layer);
+
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, false);
+
+    const Tensor<type, 2> outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    const Tensor<type, 0> inputs_range = inputs_tensor.abs().maximum();
+
+    assert_true(!perceptron_layer.is_quantized(), LOG);
+
+    perceptron_layer.quantize(inputs_range(0));
+
+    assert_true(perceptron_layer.is_quantizable(), LOG);
+    assert_true(perceptron_layer.is_quantized(), LOG);
+
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, false);
+
+    Tensor<type, 2> quantized_outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    const Tensor<type, 0> outputs_range = outputs.abs().maximum();
+
+    for(Index i = 0; i < outputs.size(); i++)
+    {
+        assert_true(abs(quantized_outputs(i) - outputs(i)) < type(0.02)*outputs_range(0), LOG);
+    }
+
+    // Test
+
+    assert_true(perceptron_layer.get_synaptic_weights().size() == 0, LOG);
+    assert_true(perceptron_layer.get_inputs_number() == inputs_number, LOG);
+    assert_true(perceptron_layer.get_parameters_number() == (inputs_number + 1)*neurons_number, LOG);
+    assert_true(perceptron_layer.get_parameters().size() == (inputs_number + 1)*neurons_number, LOG);
+
+    // Test
+
+    tinyxml2::XMLPrinter file_stream;
+    perceptron_layer.write_XML(file_stream);
+
+    tinyxml2::XMLDocument document;
+    document.Parse(file_stream.CStr());
+
+    PerceptronLayer loaded_perceptron_layer;
+    loaded_perceptron_layer.from_XML(document);
+
+    assert_true(loaded_perceptron_layer.is_quantized(), LOG);
+
+    PerceptronLayerForwardPropagation loaded_perceptron_layer_forward_propagation(samples_number, &loaded_perceptron_layer);
+
+    loaded_perceptron_layer.forward_propagate(inputs, &loaded_perceptron_layer_forward_propagation, false);
+    perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, false);
+
+    quantized_outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    const Tensor<type, 2> loaded_outputs = loaded_perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    for(Index i = 0; i < outputs.size(); i++)
+    {
+        assert_true(abs(loaded_outputs(i) - quantized_outputs(i)) < type(1e-4)*outputs_range(0), LOG);
+    }
+
+    assert_true(loaded_perceptron_layer.get_synaptic_weights().size() == 0, LOG);
+
+    const Tensor<type, 1> loaded_parameters = loaded_perceptron_layer.get_parameters();
+    const Tensor<type, 1> parameters = perceptron_layer.get_parameters();
+
+    const Tensor<type, 0> parameters_range = parameters.abs().maximum();
+
+    for(Index i = 0; i < parameters.size(); i++)
+    {
+        assert_true(abs(loaded_parameters(i) - parameters(i)) <= parameters_range(0)/type(127), LOG);
+    }
+
+    // Test
+
+    perceptron_layer.set_parameters(parameters);
+
+    assert_true(!perceptron_layer.is_quantized(), LOG);
+    assert_true(perceptron_layer.get_synaptic_weights().dimension(0) == inputs_number, LOG);
+    assert_true(perceptron_layer.get_synaptic_weights().dimension(1) == neurons_number, LOG);
+}
+
+
+void PerceptronLayerTest::test_set_weights_precision()
+{
+    cout << "test_set_weights_precision\n";
+
+    Tensor<type, 2> inputs_tensor;
+    Tensor<type, 1> parameters;
+
+    samples_number = 3;
+    inputs_number = 50;
+    neurons_number = 20;
+
+    inputs_tensor.resize(samples_number, inputs_number);
+    inputs_tensor.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs(1);
+    inputs(0) = DynamicTensor<type>(inputs_tensor.data(), get_dimensions(inputs_tensor));
+
+    for(const Precision& precision : {Precision::BFloat16, Precision::Half})
+    {
+        // Test
+
+        perceptron_layer.set(inputs_number, neurons_number, PerceptronLayer::ActivationFunction::Linear);
+        perceptron_layer.set_parameters_random();
+        perceptron_layer.set_dropout_rate(type(0));
+
+        parameters = perceptron_layer.get_parameters();
+        round_to_precision(parameters, precision);
+        perceptron_layer.set_parameters(parameters);
+
+        perceptron_layer_forward_propagation.set(samples_number, &perceptron_layer);
+
+        perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, false);
+
+        const Tensor<type, 2> outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+        perceptron_layer.set_weights_precision(precision);
+
+        assert_true(perceptron_layer.get_weights_precision() == precision, LOG);
+
+        perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, false);
+
+        const Tensor<type, 2> reduced_precision_outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+        for(Index i = 0; i < outputs.size(); i++)
+        {
+            assert_true(abs(reduced_precision_outputs(i) - outputs(i)) < type(1e-4)*(type(1) + abs(outputs(i))), LOG);
+        }
+
+        // Test
+
+        perceptron_layer.set_parameters_constant(type(1));
+
+        assert_true(perceptron_layer.get_weights_precision() == precision, LOG);
+
+        perceptron_layer.forward_propagate(inputs, &perceptron_layer_forward_propagation, false);
+
+        const Tensor<type, 2> constant_outputs = perceptron_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+        const Tensor<type, 1> inputs_sums = inputs_tensor.sum(Eigen::array<Index, 1>({1}));
+
+        for(Index i = 0; i < samples_number; i++)
+        {
+            assert_true(abs(constant_outputs(i, 0) - inputs_sums(i) - type(1)) < type(1e-4)*(type(1) + abs(inputs_sums(i))), LOG);
+        }
+    }
+
+    // Test
+
+    perceptron_layer.set(inputs_number, neurons_number);
+
+    assert_true(perceptron_layer.get_weights_precision() == Precision::Single, LOG);
+}
+
+
 void PerceptronLayerTest::run_test_case()
 {
     cout << "Running perceptron layer test case...\n";
@@ -1482,6 +1794,14 @@ void PerceptronLayerTest::run_test_case()
 
     test_forward_propagate();
 
+    test_dropout();
+
+    // Quantization
+
+    test_quantize();
+
+    test_set_weights_precision();
+
     cout << "End of perceptron layer test case.\n\n";
 }
 
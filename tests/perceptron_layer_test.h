@@ -73,6 +73,14 @@ public:
 
     void test_forward_propagate();
 
+    void test_dropout();
+
+    // Quantization
+
+    void test_quantize();
+
+    void test_set_weights_precision();
+
     // Unit testing methods
 
     void run_test_case();
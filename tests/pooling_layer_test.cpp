@@ -365,6 +365,139 @@ void PoolingLayerTest::test_calculate_max_pooling_outputs()
 }
 
 
+void PoolingLayerTest::test_forward_propagate_max_pooling()
+{
+    cout << "test_forward_propagate_max_pooling\n";
+
+    const Index batch_samples_number = 2;
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    inputs_dimensions.setValues({4, 4, 1});
+
+    Tensor<Index, 1> pool_dimensions(2);
+    pool_dimensions.setValues({2, 2});
+
+    pooling_layer.set(inputs_dimensions, pool_dimensions);
+    pooling_layer.set_pooling_method(PoolingLayer::PoolingMethod::MaxPooling);
+    pooling_layer.set_row_stride(2);
+    pooling_layer.set_column_stride(2);
+
+    Tensor<type, 4> inputs(batch_samples_number, 4, 4, 1);
+
+    for(Index i = 0; i < inputs.size(); i++) inputs(i) = type(i%7);
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    PoolingLayerForwardPropagation pooling_layer_forward_propagation(batch_samples_number, &pooling_layer);
+
+    pooling_layer.forward_propagate(inputs_pair, &pooling_layer_forward_propagation, true);
+
+    const TensorMap<Tensor<type, 4>> outputs = pooling_layer_forward_propagation.outputs(0).to_tensor_map<4>();
+
+    assert_true(outputs.dimension(1) == 2 && outputs.dimension(2) == 2, LOG);
+
+    for(Index sample = 0; sample < batch_samples_number; sample++)
+    {
+        for(Index row = 0; row < 2; row++)
+        {
+            for(Index column = 0; column < 2; column++)
+            {
+                type maximum = inputs(sample, 2*row, 2*column, 0);
+
+                for(Index pool_row = 0; pool_row < 2; pool_row++)
+                    for(Index pool_column = 0; pool_column < 2; pool_column++)
+                        maximum = max(maximum, inputs(sample, 2*row + pool_row, 2*column + pool_column, 0));
+
+                assert_true(outputs(sample, row, column, 0) == maximum, LOG);
+
+                const Index maximal_index = pooling_layer_forward_propagation.maximal_indices(sample, row, column, 0);
+
+                assert_true(inputs(maximal_index) == maximum, LOG);
+            }
+        }
+    }
+}
+
+
+void PoolingLayerTest::test_calculate_inputs_derivatives()
+{
+    cout << "test_calculate_inputs_derivatives\n";
+
+    const Index batch_samples_number = 3;
+    const Index inputs_rows_number = 5;
+    const Index inputs_columns_number = 6;
+    const Index channels_number = 2;
+
+    Tensor<Index, 1> inputs_dimensions(3);
+    inputs_dimensions.setValues({inputs_rows_number, inputs_columns_number, channels_number});
+
+    Tensor<Index, 1> pool_dimensions(2);
+    pool_dimensions.setValues({2, 3});
+
+    Tensor<Index, 1> batch_inputs_dimensions(4);
+    batch_inputs_dimensions.setValues({batch_samples_number, inputs_rows_number, inputs_columns_number, channels_number});
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0).set_dimensions(batch_inputs_dimensions);
+
+    // Inputs are different integers, so that the maxima do not change with the perturbations
+
+    TensorMap<Tensor<type, 4>> inputs = inputs_pair(0).to_tensor_map<4>();
+
+    for(Index i = 0; i < inputs.size(); i++) inputs(i) = type((7*i)%inputs.size());
+
+    const PoolingLayer::PoolingMethod pooling_methods[2] = {PoolingLayer::PoolingMethod::MaxPooling,
+                                                            PoolingLayer::PoolingMethod::AveragePooling};
+
+    const type epsilon = type(0.25);
+
+    for(Index method_index = 0; method_index < 2; method_index++)
+    {
+        pooling_layer.set(inputs_dimensions, pool_dimensions);
+        pooling_layer.set_pooling_method(pooling_methods[method_index]);
+        pooling_layer.set_row_stride(1);
+        pooling_layer.set_column_stride(2);
+
+        PoolingLayerForwardPropagation pooling_layer_forward_propagation(batch_samples_number, &pooling_layer);
+        PoolingLayerBackPropagation pooling_layer_back_propagation(batch_samples_number, &pooling_layer);
+
+        pooling_layer.forward_propagate(inputs_pair, &pooling_layer_forward_propagation, true);
+
+        TensorMap<Tensor<type, 4>> deltas(pooling_layer_back_propagation.deltas_data,
+                                          pooling_layer_forward_propagation.get_outputs_dimensions_array());
+        deltas.setRandom();
+
+        Tensor<type, 4> inputs_derivatives(inputs.dimensions());
+
+        pooling_layer.calculate_inputs_derivatives(&pooling_layer_forward_propagation,
+                                                   &pooling_layer_back_propagation,
+                                                   inputs_derivatives.data());
+
+        // Numerical derivatives of the sum of the outputs times the deltas
+
+        for(Index i = 0; i < inputs.size(); i++)
+        {
+            const type input = inputs(i);
+
+            inputs(i) = input + epsilon;
+            pooling_layer.forward_propagate(inputs_pair, &pooling_layer_forward_propagation, false);
+            const Tensor<type, 0> forward_error = (pooling_layer_forward_propagation.outputs(0).to_tensor_map<4>()*deltas).sum();
+
+            inputs(i) = input - epsilon;
+            pooling_layer.forward_propagate(inputs_pair, &pooling_layer_forward_propagation, false);
+            const Tensor<type, 0> backward_error = (pooling_layer_forward_propagation.outputs(0).to_tensor_map<4>()*deltas).sum();
+
+            inputs(i) = input;
+
+            const type numerical_derivative = (forward_error(0) - backward_error(0))/(type(2)*epsilon);
+
+            assert_true(abs(inputs_derivatives(i) - numerical_derivative) < type(1e-2), LOG);
+        }
+    }
+}
+
+
 void PoolingLayerTest::run_test_case()
 {
    cout << "Running pooling layer test case...\n";
@@ -378,6 +511,11 @@ void PoolingLayerTest::run_test_case()
 
     test_calculate_average_pooling_outputs();
     test_calculate_max_pooling_outputs();
+    test_forward_propagate_max_pooling();
+
+    // Back propagation
+
+    test_calculate_inputs_derivatives();
 
    cout << "End of pooling layer test case.\n\n";
 }
@@ -29,6 +29,11 @@ public:
    void test_calculate_average_pooling_outputs();
    void test_forward_propagate_average_pooling();
    void test_calculate_max_pooling_outputs();
+   void test_forward_propagate_max_pooling();
+
+   // Back propagation
+
+   void test_calculate_inputs_derivatives();
 
    // Unit testing methods
 
@@ -362,6 +362,287 @@ void RecurrentLayerTest::test_forward_propagate()
 
 
 
+void RecurrentLayerTest::test_forward_propagate_sequences()
+{
+    cout << "test_forward_propagate_sequences\n";
+
+    const Index inputs_number = 3;
+    const Index neurons_number = 4;
+    const Index timesteps = 3;
+
+    // Two sequences and a shorter one
+
+    const Index samples_number = 7;
+
+    RecurrentLayer recurrent_layer(inputs_number, neurons_number);
+
+    recurrent_layer.set_timesteps(timesteps);
+    recurrent_layer.set_activation_function(RecurrentLayer::ActivationFunction::HyperbolicTangent);
+    recurrent_layer.set_parameters_random();
+
+    Tensor<type, 2> inputs(samples_number, inputs_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    RecurrentLayerForwardPropagation recurrent_layer_forward_propagation(samples_number, &recurrent_layer);
+
+    recurrent_layer.forward_propagate(inputs_pair, &recurrent_layer_forward_propagation, true);
+
+    const TensorMap<Tensor<type, 2>> outputs = recurrent_layer_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    // Sample by sample
+
+    const Tensor<type, 1> biases = recurrent_layer.get_biases();
+    const Tensor<type, 2> input_weights = recurrent_layer.get_input_weights();
+    const Tensor<type, 2> recurrent_weights = recurrent_layer.get_recurrent_weights();
+
+    const Eigen::array<IndexPair<Index>, 1> AT_B = {IndexPair<Index>(0, 0)};
+
+    Tensor<type, 1> hidden_states(neurons_number);
+
+    for(Index i = 0; i < samples_number; i++)
+    {
+        if(i%timesteps == 0) hidden_states.setZero();
+
+        const Tensor<type, 1> current_inputs = inputs.chip(i, 0);
+
+        const Tensor<type, 1> combinations
+                = current_inputs.contract(input_weights, AT_B) + hidden_states.contract(recurrent_weights, AT_B) + biases;
+
+        hidden_states = combinations.tanh();
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            assert_true(abs(outputs(i, j) - hidden_states(j)) < type(1e-5), LOG);
+            assert_true(abs(recurrent_layer_forward_propagation.combinations.to_tensor_map<2>()(i, j) - combinations(j)) < type(1e-5), LOG);
+            assert_true(abs(recurrent_layer_forward_propagation.activations_derivatives(i, j)
+                            - (type(1) - hidden_states(j)*hidden_states(j))) < type(1e-5), LOG);
+        }
+    }
+
+    // Parameters vector
+
+    Tensor<type, 1> parameters = recurrent_layer.get_parameters();
+
+    RecurrentLayerForwardPropagation parameters_forward_propagation(samples_number, &recurrent_layer);
+
+    recurrent_layer.forward_propagate(inputs_pair, parameters, &parameters_forward_propagation);
+
+    const TensorMap<Tensor<type, 2>> parameters_outputs = parameters_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    for(Index i = 0; i < outputs.size(); i++)
+    {
+        assert_true(abs(outputs(i) - parameters_outputs(i)) < type(1e-6), LOG);
+    }
+}
+
+
+void RecurrentLayerTest::test_forward_propagate_incremental()
+{
+    cout << "test_forward_propagate_incremental\n";
+
+    const Index inputs_number = 3;
+    const Index neurons_number = 4;
+    const Index timesteps = 5;
+
+    RecurrentLayer recurrent_layer(inputs_number, neurons_number);
+
+    recurrent_layer.set_timesteps(timesteps);
+    recurrent_layer.set_activation_function(RecurrentLayer::ActivationFunction::HyperbolicTangent);
+    recurrent_layer.set_parameters_random();
+
+    Tensor<type, 2> inputs(timesteps, inputs_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    RecurrentLayerForwardPropagation forward_propagation(timesteps, &recurrent_layer);
+
+    recurrent_layer.forward_propagate(inputs_pair, &forward_propagation, false);
+
+    const TensorMap<Tensor<type, 2>> outputs = forward_propagation.outputs(0).to_tensor_map<2>();
+
+    // One timestep at a time
+
+    RecurrentLayerForwardPropagation incremental_forward_propagation(1, &recurrent_layer);
+
+    incremental_forward_propagation.is_incremental = true;
+
+    Tensor<type, 2> step_inputs(1, inputs_number);
+
+    for(Index i = 0; i < timesteps; i++)
+    {
+        step_inputs.chip(0, 0) = inputs.chip(i, 0);
+
+        inputs_pair(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+        recurrent_layer.forward_propagate(inputs_pair, &incremental_forward_propagation, false);
+
+        const TensorMap<Tensor<type, 2>> step_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<2>();
+
+        for(Index j = 0; j < neurons_number; j++)
+        {
+            assert_true(abs(step_outputs(0, j) - outputs(i, j)) < type(1e-5), LOG);
+        }
+    }
+
+    // Reset states
+
+    incremental_forward_propagation.reset_states();
+
+    step_inputs.chip(0, 0) = inputs.chip(0, 0);
+
+    inputs_pair(0) = DynamicTensor<type>(step_inputs.data(), get_dimensions(step_inputs));
+
+    recurrent_layer.forward_propagate(inputs_pair, &incremental_forward_propagation, false);
+
+    const TensorMap<Tensor<type, 2>> step_outputs = incremental_forward_propagation.outputs(0).to_tensor_map<2>();
+
+    for(Index j = 0; j < neurons_number; j++)
+    {
+        assert_true(abs(step_outputs(0, j) - outputs(0, j)) < type(1e-5), LOG);
+    }
+}
+
+
+void RecurrentLayerTest::test_calculate_error_gradient()
+{
+    cout << "test_calculate_error_gradient\n";
+
+    const Index inputs_number = 3;
+    const Index neurons_number = 4;
+    const Index timesteps = 4;
+    const Index samples_number = 7;
+
+    RecurrentLayer recurrent_layer(inputs_number, neurons_number);
+
+    recurrent_layer.set_timesteps(timesteps);
+    recurrent_layer.set_activation_function(RecurrentLayer::ActivationFunction::HyperbolicTangent);
+    recurrent_layer.set_parameters_random();
+
+    const Index parameters_number = recurrent_layer.get_parameters_number();
+
+    Tensor<type, 2> inputs(samples_number, inputs_number);
+    inputs.setRandom();
+
+    Tensor<DynamicTensor<type>, 1> inputs_pair(1);
+    inputs_pair(0) = DynamicTensor<type>(inputs.data(), get_dimensions(inputs));
+
+    // The error is the sum of the outputs times some random weights, which are then the deltas
+
+    Tensor<type, 2> error_weights(samples_number, neurons_number);
+    error_weights.setRandom();
+
+    RecurrentLayerForwardPropagation recurrent_layer_forward_propagation(samples_number, &recurrent_layer);
+    RecurrentLayerBackPropagation recurrent_layer_back_propagation(samples_number, &recurrent_layer);
+
+    recurrent_layer.forward_propagate(inputs_pair, &recurrent_layer_forward_propagation, true);
+
+    copy(error_weights.data(), error_weights.data() + error_weights.size(), recurrent_layer_back_propagation.deltas_data);
+
+    recurrent_layer.calculate_error_gradient(inputs.data(),
+                                             &recurrent_layer_forward_propagation,
+                                             &recurrent_layer_back_propagation);
+
+    Tensor<type, 1> gradient(parameters_number);
+
+    recurrent_layer.insert_gradient(&recurrent_layer_back_propagation, 0, gradient);
+
+    // Numerical gradient
+
+    const Tensor<type, 1> parameters = recurrent_layer.get_parameters();
+
+    const type epsilon = type(1e-2);
+
+    auto calculate_error = [&](const Tensor<type, 1>& new_parameters)
+    {
+        recurrent_layer.set_parameters(new_parameters);
+
+        recurrent_layer.forward_propagate(inputs_pair, &recurrent_layer_forward_propagation, false);
+
+        const Tensor<type, 0> error
+                = (recurrent_layer_forward_propagation.outputs(0).to_tensor_map<2>()*error_weights).sum();
+
+        return error(0);
+    };
+
+    for(Index i = 0; i < parameters_number; i++)
+    {
+        Tensor<type, 1> perturbed_parameters = parameters;
+
+        perturbed_parameters(i) = parameters(i) + epsilon;
+        const type forward_error = calculate_error(perturbed_parameters);
+
+        perturbed_parameters(i) = parameters(i) - epsilon;
+        const type backward_error = calculate_error(perturbed_parameters);
+
+        const type numerical_derivative = (forward_error - backward_error)/(type(2)*epsilon);
+
+        assert_true(abs(gradient(i) - numerical_derivative) < type(1e-2), LOG);
+    }
+
+    recurrent_layer.set_parameters(parameters);
+
+    // Truncation as long as the sequences does not change the gradient
+
+    recurrent_layer.set_truncation_length(timesteps);
+
+    recurrent_layer.forward_propagate(inputs_pair, &recurrent_layer_forward_propagation, true);
+
+    recurrent_layer.calculate_error_gradient(inputs.data(),
+                                             &recurrent_layer_forward_propagation,
+                                             &recurrent_layer_back_propagation);
+
+    Tensor<type, 1> truncated_gradient(parameters_number);
+
+    recurrent_layer.insert_gradient(&recurrent_layer_back_propagation, 0, truncated_gradient);
+
+    for(Index i = 0; i < parameters_number; i++)
+    {
+        assert_true(abs(gradient(i) - truncated_gradient(i)) < type(1e-6), LOG);
+    }
+
+    // Truncation to a single timestep keeps only the errors of the outputs of each timestep
+
+    recurrent_layer.set_truncation_length(1);
+
+    recurrent_layer.calculate_error_gradient(inputs.data(),
+                                             &recurrent_layer_forward_propagation,
+                                             &recurrent_layer_back_propagation);
+
+    recurrent_layer.insert_gradient(&recurrent_layer_back_propagation, 0, truncated_gradient);
+
+    const Tensor<type, 0> difference = (gradient - truncated_gradient).abs().maximum();
+
+    assert_true(difference(0) > type(1e-3), LOG);
+
+    // The back propagation uses the recurrent weights of the forward propagation,
+    // even if the weights of the layer change in between
+
+    recurrent_layer.set_truncation_length(0);
+
+    recurrent_layer.forward_propagate(inputs_pair, &recurrent_layer_forward_propagation, true);
+
+    recurrent_layer.set_recurrent_weights_random();
+
+    recurrent_layer.calculate_error_gradient(inputs.data(),
+                                             &recurrent_layer_forward_propagation,
+                                             &recurrent_layer_back_propagation);
+
+    Tensor<type, 1> stored_weights_gradient(parameters_number);
+
+    recurrent_layer.insert_gradient(&recurrent_layer_back_propagation, 0, stored_weights_gradient);
+
+    for(Index i = 0; i < parameters_number; i++)
+    {
+        assert_true(abs(gradient(i) - stored_weights_gradient(i)) < type(1e-6), LOG);
+    }
+}
+
+
 void RecurrentLayerTest::run_test_case()
 {
     cout << "Running recurrent layer test case...\n";
@@ -380,6 +661,13 @@ void RecurrentLayerTest::run_test_case()
 
     test_forward_propagate();
 
+    test_forward_propagate_sequences();
+    test_forward_propagate_incremental();
+
+    // Back propagate
+
+    test_calculate_error_gradient();
+
     cout << "End of recurrent layer test case.\n\n";
 }
 
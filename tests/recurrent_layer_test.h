@@ -40,6 +40,13 @@ public:
 
     void test_forward_propagate();
 
+    void test_forward_propagate_sequences();
+    void test_forward_propagate_incremental();
+
+    // Back propagate
+
+    void test_calculate_error_gradient();
+
     // Unit testing methods
 
     void run_test_case();
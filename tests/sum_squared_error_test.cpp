@@ -490,6 +490,77 @@ void SumSquaredErrorTest::test_back_propagate_lm()
 }
 
 
+void SumSquaredErrorTest::test_back_propagate_graph()
+{
+    cout << "test_back_propagate_graph\n";
+
+    // Test approximation residual and concatenation branches
+    {
+        samples_number = 1 + rand()%5;
+        inputs_number = 1 + rand()%5;
+        outputs_number = 1 + rand()%5;
+        neurons_number = 1 + rand()%5;
+        bool is_training = true;
+
+        // Data set
+
+        data_set.set(samples_number, inputs_number, outputs_number);
+        data_set.set_data_random();
+
+        data_set.set_training();
+
+        training_samples_indices = data_set.get_training_samples_indices();
+        input_variables_indices = data_set.get_input_variables_indices();
+        target_variables_indices = data_set.get_target_variables_indices();
+
+        batch.set(samples_number, &data_set);
+        batch.fill(training_samples_indices, input_variables_indices, target_variables_indices);
+
+        // Neural network
+
+        Tensor<Index, 1> addition_dimensions(1);
+        addition_dimensions.setValues({neurons_number});
+
+        Tensor<Index, 1> concatenation_last_dimensions(2);
+        concatenation_last_dimensions.setValues({neurons_number, neurons_number});
+
+        neural_network.set();
+
+        neural_network.add_layer(new PerceptronLayer(inputs_number, neurons_number));
+        neural_network.add_layer(new PerceptronLayer(neurons_number, neurons_number));
+        neural_network.add_layer(new AdditionLayer(addition_dimensions));
+        neural_network.add_layer(new ConcatenationLayer(addition_dimensions, concatenation_last_dimensions));
+        neural_network.add_layer(new PerceptronLayer(2*neurons_number, outputs_number, PerceptronLayer::ActivationFunction::Linear));
+
+        Tensor<Index, 1> layer_inputs_indices(2);
+
+        layer_inputs_indices.setValues({0, 1});
+        neural_network.set_layer_inputs_indices(2, layer_inputs_indices);
+
+        layer_inputs_indices.setValues({2, 0});
+        neural_network.set_layer_inputs_indices(3, layer_inputs_indices);
+
+        neural_network.set_parameters_random();
+
+        assert_true(!neural_network.is_sequential(), LOG);
+
+        forward_propagation.set(samples_number, &neural_network);
+        neural_network.forward_propagate(batch, forward_propagation, is_training);
+
+        // Loss index
+
+        back_propagation.set(samples_number, &sum_squared_error);
+        sum_squared_error.back_propagate(batch, forward_propagation, back_propagation);
+
+        numerical_differentiation_gradient = sum_squared_error.calculate_numerical_differentiation_gradient();
+
+        assert_true(back_propagation.gradient.size() == neural_network.get_parameters_number(), LOG);
+
+        assert_true(are_equal(back_propagation.gradient, numerical_differentiation_gradient, type(1.0e-2)), LOG);
+    }
+}
+
+
 void SumSquaredErrorTest::run_test_case()
 {
     cout << "Running sum squared error test case...\n";
@@ -506,6 +577,8 @@ void SumSquaredErrorTest::run_test_case()
 
     test_back_propagate_lm();
 
+    test_back_propagate_graph();
+
     cout << "End of sum squared error test case.\n\n";
 }
 
@@ -34,6 +34,8 @@ public:
 
     void test_back_propagate_lm();
 
+    void test_back_propagate_graph();
+
     // Unit testing methods
 
     void run_test_case();
@@ -63,6 +63,51 @@ void TensorUtilitiesTest::test_calculate_rank()
 }
 
 
+void TensorUtilitiesTest::test_perform_Householder_QR_decomposition()
+{
+    cout << "test_perform_Householder_QR_decomposition\n";
+
+    Tensor<type, 1> solution;
+
+    // Test
+
+    matrix.resize(2, 2);
+    matrix.setValues({{type(2), type(1)}, {type(1), type(3)}});
+
+    vector.resize(2);
+    vector.setValues({type(3), type(4)});
+
+    solution = perform_Householder_QR_decomposition(matrix, vector);
+
+    assert_true(abs(solution(0) - type(1)) < type(1.0e-5), LOG);
+    assert_true(abs(solution(1) - type(1)) < type(1.0e-5), LOG);
+
+    // Test
+
+    const Index n = 8;
+
+    Tensor<double, 2> hilbert_matrix(n, n);
+    Tensor<double, 1> hilbert_vector(n);
+    hilbert_vector.setZero();
+
+    for(Index i = 0; i < n; i++)
+    {
+        for(Index j = 0; j < n; j++)
+        {
+            hilbert_matrix(i, j) = 1.0/double(i + j + 1);
+            hilbert_vector(i) += hilbert_matrix(i, j);
+        }
+    }
+
+    const Tensor<double, 1> double_solution = perform_Householder_QR_decomposition(hilbert_matrix, hilbert_vector);
+
+    for(Index i = 0; i < n; i++)
+    {
+        assert_true(abs(double_solution(i) - 1.0) < 1.0e-4, LOG);
+    }
+}
+
+
 void TensorUtilitiesTest::run_test_case()
 {
     cout << "Running tensor utilities test case...\n";
@@ -71,6 +116,8 @@ void TensorUtilitiesTest::run_test_case()
 
     test_calculate_rank();
 
+    test_perform_Householder_QR_decomposition();
+
     cout << "End of tensor utilities test case.\n\n";
 }
 
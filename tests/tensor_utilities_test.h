@@ -26,6 +26,8 @@ public:
 
     void test_calculate_rank();
 
+    void test_perform_Householder_QR_decomposition();
+
     // Unit testing methods
 
     void run_test_case();
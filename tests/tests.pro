@@ -27,7 +27,11 @@ SOURCES += \
     perceptron_layer_test.cpp \
     long_short_term_memory_layer_test.cpp \
     recurrent_layer_test.cpp \
+    multihead_attention_layer_test.cpp \
+    embedding_layer_test.cpp \
     neural_network_test.cpp \
+    inference_session_test.cpp \
+    inference_batcher_test.cpp \
     bounding_layer_test.cpp \
     sum_squared_error_test.cpp \
     weighted_squared_error_test.cpp \
@@ -71,7 +75,11 @@ HEADERS += \
     perceptron_layer_test.h \
     long_short_term_memory_layer_test.h \
     recurrent_layer_test.h \
+    multihead_attention_layer_test.h \
+    embedding_layer_test.h \
     neural_network_test.h \
+    inference_session_test.h \
+    inference_batcher_test.h \
     bounding_layer_test.h \
     sum_squared_error_test.h \
     weighted_squared_error_test.h \